@@ -6,27 +6,171 @@
 using namespace RLGSC;
 using namespace RLGPC;
 
-// Global variable so that we can pass params to the bot factory
+// Global variables so that we can pass params and the shared server to the bot factory
 // TODO: This is a lame solution
 RLBotParams g_RLBotParams = {};
+RLBotInferServer* g_InferServer = NULL;
 
 rlbot::Bot* BotFactory(int index, int team, std::string name) {
-	return new RLBotBot(index, team, name, g_RLBotParams);
+	return new RLBotBot(index, team, name, g_RLBotParams, g_InferServer);
 }
 
-RLBotBot::RLBotBot(int _index, int _team, std::string _name, const RLBotParams& params) 
-	: rlbot::Bot(_index, _team, _name), params(params) {
+void RLBotLatencyStats::Log() {
+	std::stringstream stream;
+	stream << "RLBot latency (p50 / p99 / max in ms):";
+
+	auto fnLogStage = [&](const char* name, LatencyTracker& tracker) {
+		auto summary = tracker.GetSummary();
+		stream << "\n > " << name << ": " << summary.p50 << " / " << summary.p99 << " / " << summary.max << " (last " << summary.count << ")";
+	};
+	fnLogStage("GetOutput", getOutput);
+	fnLogStage("Packet conversion", packetConversion);
+	fnLogStage("Decision", decision);
+	fnLogStage("Build OBS", buildOBS);
+	fnLogStage("Inference", inference);
+	fnLogStage("Parse actions", parseActions);
+
+	stream << "\n > Ticks slower than 1/120s: " << slowTicks << " of " << totalTicks;
+	RG_LOG(stream.str());
+}
+
+RLBotInferServer::RLBotInferServer(PolicyInferUnit* policyInferUnit, float maxWait, float latencyLogInterval) 
+	: policyInferUnit(policyInferUnit), maxWait(maxWait), latencyLogInterval(latencyLogInterval) {
+	thread = std::thread(&RLBotInferServer::_Run, this);
+}
+
+RLBotInferServer::~RLBotInferServer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shouldRun = false;
+	}
+	requestCV.notify_all();
+	thread.join();
+	delete policyInferUnit;
+}
+
+void RLBotInferServer::Warmup(int obsSize, int maxBatchSize) {
+	RG_LOG("Warming up the policy...");
+	auto startTime = std::chrono::steady_clock::now();
+
+	FList obsData = FList(obsSize * maxBatchSize, 0);
+	std::vector<int64_t> actions = std::vector<int64_t>(maxBatchSize);
+	for (int i = 0; i < 3; i++)
+		for (int batchSize = 1; batchSize <= maxBatchSize; batchSize++)
+			policyInferUnit->InferActions(obsData.data(), batchSize, actions.data(), true);
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	RG_LOG(" > Done in " << (int)(elapsed * 1000) << "ms");
+}
+
+void RLBotInferServer::AddBot() {
+	std::lock_guard<std::mutex> lock(mutex);
+	numBots++;
+}
+
+void RLBotInferServer::RemoveBot(Request* request) {
+	std::unique_lock<std::mutex> lock(mutex);
+	numBots--;
+
+	auto itr = std::find(pending.begin(), pending.end(), request);
+	if (itr != pending.end()) {
+		pending.erase(itr);
+		request->inFlight = false;
+	}
+
+	// If it isn't pending, it's in the batch being inferred
+	resultCV.wait(lock, [&] { return !request->inFlight; });
+
+	lock.unlock();
+	requestCV.notify_all(); // The batch could be complete without this bot
+}
+
+void RLBotInferServer::Submit(Request* request) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (pending.empty())
+		firstPendingTime = std::chrono::steady_clock::now();
+
+	request->inFlight = true;
+	request->submitTime = std::chrono::steady_clock::now();
+	pending.push_back(request);
+	requestCV.notify_all();
+}
+
+void RLBotInferServer::_Run() {
+	auto obsBuilder = policyInferUnit->obsBuilder;
+	auto actionParser = policyInferUnit->actionParser;
+
+	std::vector<Request*> batch = {};
+	FList obsData = {};
+	std::vector<int64_t> actions = {};
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			auto fnBatchReady = [&] { return !shouldRun || (!pending.empty() && pending.size() >= numBots); };
+
+			requestCV.wait(lock, [&] { return fnBatchReady() || !pending.empty(); });
+			if (!fnBatchReady()) {
+				// Not every bot has asked yet, give the rest until the deadline of the first
+				auto deadline = firstPendingTime + std::chrono::microseconds((int64_t)(maxWait * 1000 * 1000));
+				requestCV.wait_until(lock, deadline, fnBatchReady);
+			}
+
+			if (!shouldRun)
+				break;
+
+			batch.swap(pending);
+			pending.clear();
+		}
+
+		// Bots leave in-flight requests alone, so we can use them without the lock
+		auto stageStartTime = std::chrono::steady_clock::now();
+		obsData.clear();
+		for (Request* request : batch) {
+			obsBuilder->PreStep(request->state);
+			FList obs = obsBuilder->BuildOBS(request->state.players[request->playerIndex], request->state, request->prevAction);
+			obsData.insert(obsData.end(), obs.begin(), obs.end());
+		}
+		latency.buildOBS.AddSince(stageStartTime);
+
+		stageStartTime = std::chrono::steady_clock::now();
+		actions.resize(batch.size());
+		policyInferUnit->InferActions(obsData.data(), batch.size(), actions.data(), true);
+		latency.inference.AddSince(stageStartTime);
+
+		stageStartTime = std::chrono::steady_clock::now();
+		for (int i = 0; i < batch.size(); i++)
+			batch[i]->result = actionParser->ParseActions({ (int)actions[i] }, batch[i]->state)[0];
+		latency.parseActions.AddSince(stageStartTime);
+
+		for (Request* request : batch)
+			latency.decision.AddSince(request->submitTime);
 
-	RG_LOG("Creating RLBot bot: index " << _index << ", name: " << name << "...");
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (Request* request : batch)
+				request->inFlight = false;
+		}
+		resultCV.notify_all();
+		batch.clear();
+
+		if (latencyLogInterval > 0 && latencyLogTimer.Elapsed() > latencyLogInterval) {
+			latencyLogTimer.Reset();
+			latency.Log();
+		}
+	}
+}
 
-	RG_LOG(" > Loading policy from " << params.policyPath << "...");
-	policyInferUnit = new PolicyInferUnit(params.obsBuilder, params.actionParser, params.policyPath, params.obsSize, params.policyLayerSizes, false);
+RLBotBot::RLBotBot(int _index, int _team, std::string _name, const RLBotParams& params, RLBotInferServer* inferServer)
+	: rlbot::Bot(_index, _team, _name), params(params), inferServer(inferServer) {
 
-	RG_LOG(" > Done!");
+	RG_LOG("Created RLBot bot: index " << _index << ", name: " << name);
+	inferServer->AddBot();
 }
 
 RLBotBot::~RLBotBot() {
-	delete policyInferUnit;
+	inferServer->RemoveBot(&inferRequest);
+	delete compArena;
 }
 
 Vec ToVec(const rlbot::flat::Vector3* rlbotVec) {
@@ -46,14 +190,13 @@ PhysObj ToPhysObj(const rlbot::flat::Physics* phys) {
 	return obj;
 }
 
-PlayerData ToPlayer(const rlbot::flat::PlayerInfo* playerInfo) {
-	PlayerData pd = {};
+void UpdatePlayer(PlayerData& pd, const rlbot::flat::PlayerInfo* playerInfo) {
 	pd.carId = playerInfo->spawnId();
 
 	pd.team = (Team)playerInfo->team();
 
 	pd.phys = ToPhysObj(playerInfo->physics());
-	pd.physInv = pd.phys.Invert();
+	pd._physInvValid = false;
 
 	pd.boostFraction = playerInfo->boost() / 100.f;
 	pd.carState.isOnGround = playerInfo->hasWheelContact();
@@ -61,41 +204,95 @@ PlayerData ToPlayer(const rlbot::flat::PlayerInfo* playerInfo) {
 	pd.carState.hasDoubleJumped = playerInfo->doubleJumped();
 	pd.carState.isDemoed = playerInfo->isDemolished();
 	pd.hasFlip = !playerInfo->doubleJumped();
-
-	return pd;
 }
 
-GameState ToGameState(rlbot::GameTickPacket& gameTickPacket) {
-	GameState gs = {};
-
+// Updates a state we keep between ticks, so nothing is allocated unless the amount of players changes
+void UpdateGameState(GameState& gs, rlbot::GameTickPacket& gameTickPacket) {
 	auto players = gameTickPacket->players();
+	gs.players.resize(players->size());
 	for (int i = 0; i < players->size(); i++)
-		gs.players.push_back(ToPlayer(players->Get(i)));
+		UpdatePlayer(gs.players[i], players->Get(i));
 
 	gs.ball = ToPhysObj(gameTickPacket->ball()->physics());
-	gs.ballInv = gs.ball.Invert();
 
 	auto boostPadStates = gameTickPacket->boostPadStates();
 	if (boostPadStates->size() != CommonValues::BOOST_LOCATIONS_AMOUNT) {
 		if (rand() % 20 == 0) { // Don't spam-log as that will lag the bot
 			RG_LOG(
-				"RLBotClient ToGameState(): Bad boost pad amount, expected " << CommonValues::BOOST_LOCATIONS_AMOUNT << " but got " << boostPadStates->size()
+				"RLBotClient UpdateGameState(): Bad boost pad amount, expected " << CommonValues::BOOST_LOCATIONS_AMOUNT << " but got " << boostPadStates->size()
 			);
 		}
 
 		// Just set all boost pads to on
-		std::fill(gs.boostPads.begin(), gs.boostPads.end(), 1);
+		gs.boostPads.SetAll(true);
 	} else {
-		for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++) {
-			gs.boostPads[i] = boostPadStates->Get(i)->isActive();
-			gs.boostPadsInv[CommonValues::BOOST_LOCATIONS_AMOUNT - i - 1] = gs.boostPads[i];
-		}
+		for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++)
+			gs.boostPads.Set(i, boostPadStates->Get(i)->isActive());
 	}
 
-	return gs;
+	gs.InvalidateCaches();
+}
+
+// Simulates a state ahead in an arena, with one player using our controls and the rest coasting
+// The arena is remade if its cars don't match the players
+void SimulateAhead(Arena*& arena, GameState& gs, int playerIndex, const Action& controls, int ticks) {
+	bool carsMatch = arena && arena->_cars.size() == gs.players.size();
+	for (int i = 0; carsMatch && i < gs.players.size(); i++)
+		carsMatch = arena->_cars[i]->team == gs.players[i].team;
+
+	if (!carsMatch) {
+		delete arena;
+		arena = Arena::Create(GameMode::SOCCAR);
+		for (auto& player : gs.players)
+			arena->AddCar(player.team);
+	}
+
+	for (int i = 0; i < gs.players.size(); i++) {
+		auto& player = gs.players[i];
+		Car* car = arena->_cars[i];
+
+		CarState carState = {};
+		carState.pos = player.phys.pos;
+		carState.rotMat = player.phys.rotMat;
+		carState.vel = player.phys.vel;
+		carState.angVel = player.phys.angVel;
+		carState.boost = player.boostFraction * 100;
+		carState.isOnGround = player.carState.isOnGround;
+		carState.hasJumped = player.carState.hasJumped;
+		carState.hasDoubleJumped = player.carState.hasDoubleJumped;
+		carState.isDemoed = player.carState.isDemoed;
+		car->SetState(carState);
+		car->controls = (i == playerIndex) ? (CarControls)controls : CarControls();
+	}
+
+	BallState ballState = {};
+	ballState.pos = gs.ball.pos;
+	ballState.vel = gs.ball.vel;
+	ballState.angVel = gs.ball.angVel;
+	arena->ball->SetState(ballState);
+
+	arena->Step(ticks);
+
+	for (int i = 0; i < gs.players.size(); i++) {
+		auto& player = gs.players[i];
+		CarState carState = arena->_cars[i]->GetState();
+		if (carState.isDemoed)
+			continue; // Keep where it was
+
+		player.phys = PhysObj(carState);
+		player._physInvValid = false;
+		player.boostFraction = carState.boost / 100;
+		player.carState.isOnGround = carState.isOnGround;
+		player.carState.hasJumped = carState.hasJumped;
+		player.carState.hasDoubleJumped = carState.hasDoubleJumped;
+		player.hasFlip = !carState.hasDoubleJumped;
+	}
+	gs.ball = PhysObj(arena->ball->GetState());
+	gs.InvalidateCaches();
 }
 
 rlbot::Controller RLBotBot::GetOutput(rlbot::GameTickPacket gameTickPacket) {
+	auto startTime = std::chrono::steady_clock::now();
 
 	float curTime = gameTickPacket->gameInfo()->secondsElapsed();
 	float deltaTime = curTime - prevTime;
@@ -104,21 +301,85 @@ rlbot::Controller RLBotBot::GetOutput(rlbot::GameTickPacket gameTickPacket) {
 	int ticksElapsed = roundf(deltaTime * 120);
 	ticks += ticksElapsed;
 
-	GameState gs = ToGameState(gameTickPacket);
-	auto& localPlayer = gs.players[index];
+	if (compCheckTime >= 0 && curTime >= compCheckTime - 0.5f / 120) {
+		// This is the tick our last simulated state was for
+		compCheckTime = -1;
+		Vec realPos = ToVec(gameTickPacket->players()->Get(index)->physics()->location());
+		float predError = compPredPos.Dist(realPos), rawError = compRawPos.Dist(realPos);
+		compChecks++;
+		if (predError < rawError)
+			compHits++;
+		compPredErrorTotal += predError;
+		compRawErrorTotal += rawError;
+	}
 
-	if (updateAction) {
+	// Submit our next decision from the state of this tick, once the server is done with our last one
+	if (updateAction && !inferRequest.inFlight) {
 		updateAction = false;
-		action = policyInferUnit->InferPolicySingle(localPlayer, gs, controls, true);
+
+		// Only converted on ticks we decide on, into the request's state from our last decision
+		auto conversionStartTime = std::chrono::steady_clock::now();
+		UpdateGameState(inferRequest.state, gameTickPacket);
+		inferServer->latency.packetConversion.AddSince(conversionStartTime);
+
+		if (params.latencyCompTicks > 0) {
+			compRawPos = inferRequest.state.players[index].phys.pos;
+			SimulateAhead(compArena, inferRequest.state, index, controls, params.latencyCompTicks);
+			compPredPos = inferRequest.state.players[index].phys.pos;
+			compCheckTime = curTime + params.latencyCompTicks / 120.f;
+		}
+		inferRequest.playerIndex = index;
+		inferRequest.prevAction = controls;
+		inferServer->Submit(&inferRequest);
+
+		awaitingAction = true;
+		submitTime = curTime;
+		totalDecisions++;
 	}
 
 	if (ticks >= params.tickSkip || ticks == -1) {
-		// Apply new action
-		controls = action;
+		if (awaitingAction && !inferRequest.inFlight) {
+			// Apply new action
+			controls = inferRequest.result;
+			awaitingAction = false;
+			hasApplied = true;
+			isLate = false;
+
+			// Trigger action update next tick
+			ticks = 0;
+			updateAction = true;
+		} else if (awaitingAction) {
+			// Not inferred yet, keep the current action until it is
+			if (hasApplied && !isLate) {
+				isLate = true;
+				lateDecisions++;
+			}
+
+			if (curTime - submitTime > params.tickSkip * 2 / 120.f) {
+				// Too stale to be worth applying, decide again from a newer state
+				missedDecisions++;
+				awaitingAction = false;
+				isLate = false;
+				updateAction = true;
+			}
+		}
+	}
 
-		// Trigger action update next tick
-		ticks = 0;
-		updateAction = true;
+	if (curTime - lastReportTime > 60) {
+		lastReportTime = curTime;
+		if (lateDecisions != lastReportedLate || missedDecisions != lastReportedMissed) {
+			RG_LOG("RLBot bot " << index << ": " << lateDecisions << " late and " << missedDecisions << " missed out of " << totalDecisions << " decisions");
+			lastReportedLate = lateDecisions;
+			lastReportedMissed = missedDecisions;
+		}
+
+		if (compChecks != lastReportedCompChecks) {
+			RG_LOG(
+				"RLBot bot " << index << ": Latency compensation was closer than the packet in " << compHits << " of " << compChecks << " checks" <<
+				" (mean error " << (int)(compPredErrorTotal / compChecks) << "uu vs " << (int)(compRawErrorTotal / compChecks) << "uu)"
+			);
+			lastReportedCompChecks = compChecks;
+		}
 	}
 
 	auto rc = rlbot::Controller();
@@ -135,12 +396,43 @@ rlbot::Controller RLBotBot::GetOutput(rlbot::GameTickPacket gameTickPacket) {
 		rc.handbrake = controls.handbrake;
 	}
 
+	auto& latency = inferServer->latency;
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	latency.getOutput.Add(elapsed);
+	latency.totalTicks++;
+	if (elapsed > 1 / 120.0)
+		latency.slowTicks++;
+
 	return rc;
 }
 
 void RLBotClient::Run(const RLBotParams& params) {
 	g_RLBotParams = params;
 
+	if (params.latencyCompTicks > 0)
+		RocketSim::Init(params.collisionMeshesPath);
+
+	PolicyInferUnit* policyInferUnit;
+	if (!params.quantPolicyPath.empty()) {
+		RG_LOG("Loading quantized policy from " << params.quantPolicyPath << "...");
+		policyInferUnit = new PolicyInferUnit(params.obsBuilder, params.actionParser, params.quantPolicyPath);
+	} else {
+		RG_LOG("Loading policy from " << params.policyPath << "...");
+		policyInferUnit = new PolicyInferUnit(
+			params.obsBuilder, params.actionParser, params.policyPath, params.obsSize, params.policyLayerSizes, false, params.nativeInference
+		);
+	}
+	g_InferServer = new RLBotInferServer(policyInferUnit, params.inferBatchMaxWait, params.latencyLogInterval);
+	g_InferServer->Warmup(params.obsSize, RLBotClient::MAX_BOTS);
+
+	if (!params.hotReloadPath.empty()) {
+		if (!params.quantPolicyPath.empty()) {
+			RG_LOG("WARNING: Quantized policies can't be hot-reloaded, ignoring hotReloadPath");
+		} else {
+			policyInferUnit->StartHotReload(params.hotReloadPath, params.hotReloadInterval);
+		}
+	}
+
 	rlbot::platform::SetWorkingDirectory(
 		rlbot::platform::GetExecutableDirectory()
 	);
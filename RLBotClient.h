@@ -5,6 +5,10 @@
 #include <RLGymSim_CPP/Utils/ActionParsers/ActionParser.h>
 
 #include <RLGymPPO_CPP/Util/PolicyInferUnit.h>
+#include <RLGymPPO_CPP/Util/LatencyTracker.h>
+#include <RLGymPPO_CPP/Util/Timer.h>
+#include <condition_variable>
+#include <atomic>
 
 struct RLBotParams {
 	// Set this to the same port used in rlbot/port.cfg
@@ -13,10 +17,96 @@ struct RLBotParams {
 	RLGSC::OBSBuilder* obsBuilder = NULL; // Use your OBS builder
 	RLGSC::ActionParser* actionParser = NULL; // Use your action parser
 
-	std::filesystem::path policyPath; // The path to your trained PPO_POLICY.lt
+	std::filesystem::path policyPath; // The path to your trained PPO_POLICY.lt, or to a CHECKPOINT.rgck (see LearnerConfig::singleFileCheckpoints)
 	int obsSize; // You can find this from the console when running training
 	std::vector<int> policyLayerSizes = {}; // Your layer sizes
 	int tickSkip; // Your tick skip
+
+	// Infer with native CPU kernels instead of torch (see LearnerConfig::nativeInference)
+	bool nativeInference = false;
+
+	// If set, infer this quantized policy instead of policyPath (see PolicyInferUnit::ExportQuantized()), without using torch
+	// Quantized policies can't be hot-reloaded, so hotReloadPath is ignored
+	std::filesystem::path quantPolicyPath = {};
+
+	// All bots in this process share one policy, which infers every bot that needs an action this tick in one batch
+	// A batch is inferred once every bot has asked, or once the first has waited this long (i.e. if bots act on different ticks)
+	float inferBatchMaxWait = 0.002f; // In seconds
+
+	// If set, new checkpoints here are loaded while running (see PolicyInferUnit::StartHotReload())
+	// Can be the training's checkpoint folder, to always play with the newest checkpoint
+	std::filesystem::path hotReloadPath = {};
+	float hotReloadInterval = 5; // In seconds
+
+	// How often the latency of each stage of deciding is logged (see RLBotLatencyStats), 0 to never log it
+	float latencyLogInterval = 60; // In seconds
+
+	// If above 0, the state of each decision is simulated this many ticks ahead with RocketSim before it is inferred
+	// A decision is only applied tickSkip ticks after the tick it was made on, so tickSkip is a good start
+	// Our car keeps its current controls while simulating, other cars coast
+	int latencyCompTicks = 0;
+	std::filesystem::path collisionMeshesPath = "./collision_meshes"; // Only loaded with latencyCompTicks
+};
+
+// Latency of each stage of the decision path, over a rolling window of samples
+struct RLBotLatencyStats {
+	RLGPC::LatencyTracker
+		getOutput, packetConversion, // Per tick of each bot, on its thread
+		decision, // From a bot submitting a decision to it being inferred
+		buildOBS, inference, parseActions; // Per batch, on the server's thread
+
+	// Ticks where GetOutput took longer than a tick (1/120s)
+	std::atomic<uint64_t> slowTicks = 0, totalTicks = 0;
+
+	void Log();
+};
+
+// Infers the actions of every bot in the process together, on its own thread
+// Bots never wait on it, they submit a request with the state of a tick and pick up the result on a later tick
+class RLBotInferServer {
+public:
+	RLGPC::PolicyInferUnit* policyInferUnit;
+	float maxWait;
+
+	// Owned by the bot, which must not touch anything but inFlight while it is set
+	struct Request {
+		RLGSC::GameState state;
+		int playerIndex;
+		RLGSC::Action prevAction;
+
+		RLGSC::Action result = {};
+		std::atomic<bool> inFlight = false;
+		std::chrono::steady_clock::time_point submitTime = {};
+	};
+
+	RLBotLatencyStats latency = {};
+	float latencyLogInterval;
+	RLGPC::Timer latencyLogTimer = {};
+
+	std::mutex mutex = {};
+	std::condition_variable requestCV = {}, resultCV = {};
+	std::vector<Request*> pending = {};
+	std::chrono::steady_clock::time_point firstPendingTime = {};
+	int numBots = 0;
+	bool shouldRun = true;
+	std::thread thread;
+
+	RLBotInferServer(RLGPC::PolicyInferUnit* policyInferUnit, float maxWait, float latencyLogInterval);
+	~RLBotInferServer();
+
+	// Runs the policy on dummy observations of every batch size up to maxBatchSize
+	// Otherwise the first real decisions would pay for libtorch's lazy initialization
+	void Warmup(int obsSize, int maxBatchSize);
+
+	// Bots register themselves, so we know how many to wait for
+	void AddBot();
+	// Also waits for the bot's request to be done with, if it has one in flight
+	void RemoveBot(Request* request);
+
+	// Returns immediately, request->inFlight is cleared once request->result is set
+	void Submit(Request* request);
+
+	void _Run();
 };
 
 class RLBotBot : public rlbot::Bot {
@@ -25,25 +115,51 @@ public:
 	// Parameters to define the bot
 	RLBotParams params;
 
-	// Inference unit to infer the policy with, also uses our obs and action parser
-	RLGPC::PolicyInferUnit* policyInferUnit;
+	// Shared by all bots in this process
+	RLBotInferServer* inferServer;
+
+	// Our decision being inferred, if awaitingAction
+	RLBotInferServer::Request inferRequest = {};
+	bool awaitingAction = false;
 
-	// Queued action and current action
-	RLGSC::Action 
-		action = {}, 
-		controls = {};
+	// Current action
+	RLGSC::Action controls = {};
 
 	// Persistent info
 	bool updateAction = true;
+	bool hasApplied = false, isLate = false;
 	float prevTime = 0;
+	float submitTime = 0;
 	int ticks = -1;
 
-	RLBotBot(int _index, int _team, std::string _name, const RLBotParams& params);
+	// Decisions that were not inferred by the tick they were due, and were applied as soon as they were
+	uint64_t lateDecisions = 0;
+	// Decisions that were not inferred within two tick skips, and were replaced by a decision from a newer state
+	uint64_t missedDecisions = 0;
+	uint64_t totalDecisions = 0;
+	uint64_t lastReportedLate = 0, lastReportedMissed = 0;
+
+	// Arena that decision states are simulated ahead in, only made with latencyCompTicks
+	RLGSC::Arena* compArena = NULL;
+	// Our car's position in the last simulated state, and in the packet it was simulated from
+	// Both are checked against the packet of the tick the state was simulated to
+	RLGSC::Vec compPredPos = {}, compRawPos = {};
+	float compCheckTime = -1; // -1 if there is nothing to check
+	// Simulated states checked, and how many of them were closer to the real position than the packet they came from
+	uint64_t compChecks = 0, compHits = 0;
+	double compPredErrorTotal = 0, compRawErrorTotal = 0; // In uu
+	uint64_t lastReportedCompChecks = 0;
+	float lastReportTime = 0;
+
+	RLBotBot(int _index, int _team, std::string _name, const RLBotParams& params, RLBotInferServer* inferServer);
 	~RLBotBot();
 
 	rlbot::Controller GetOutput(rlbot::GameTickPacket gameTickPacket) override;
 };
 
 namespace RLBotClient {
+	// Most bots a match can have, the batch sizes we warm up for
+	constexpr int MAX_BOTS = 8;
+
 	void Run(const RLBotParams& params);
 }
\ No newline at end of file
@@ -793,8 +793,109 @@ void btQuantizedBvh::assignInternalNodeFromLeafNode(int internalNode, int leafNo
 
 //PCK: include
 #include <new>
+#include <string.h>
 #include "../CollisionShapes/btConcaveShape.h"
 
+struct btQuantizedBvhSerializeHeader
+{
+	btVector3 m_bvhAabbMin;
+	btVector3 m_bvhAabbMax;
+	btVector3 m_bvhQuantization;
+	int m_bulletVersion;
+	int m_curNodeIndex;
+	int m_useQuantization;
+	int m_numContiguousNodes;
+	int m_numQuantizedContiguousNodes;
+	int m_numSubtreeHeaders;
+};
+
+unsigned btQuantizedBvh::calculateSerializeBufferSize() const
+{
+	return sizeof(btQuantizedBvhSerializeHeader) +
+		   m_contiguousNodes.size() * sizeof(btOptimizedBvhNode) +
+		   m_quantizedContiguousNodes.size() * sizeof(btQuantizedBvhNode) +
+		   m_SubtreeHeaders.size() * sizeof(btBvhSubtreeInfo);
+}
+
+void btQuantizedBvh::serialize(void* o_dataBuffer) const
+{
+	btAssert(m_leafNodes.size() == 0 && m_quantizedLeafNodes.size() == 0);  // Tree must be built
+
+	btQuantizedBvhSerializeHeader header;
+	header.m_bvhAabbMin = m_bvhAabbMin;
+	header.m_bvhAabbMax = m_bvhAabbMax;
+	header.m_bvhQuantization = m_bvhQuantization;
+	header.m_bulletVersion = m_bulletVersion;
+	header.m_curNodeIndex = m_curNodeIndex;
+	header.m_useQuantization = m_useQuantization;
+	header.m_numContiguousNodes = m_contiguousNodes.size();
+	header.m_numQuantizedContiguousNodes = m_quantizedContiguousNodes.size();
+	header.m_numSubtreeHeaders = m_SubtreeHeaders.size();
+
+	unsigned char* out = (unsigned char*)o_dataBuffer;
+	memcpy(out, &header, sizeof(header));
+	out += sizeof(header);
+
+	if (header.m_numContiguousNodes)
+		memcpy(out, &m_contiguousNodes[0], header.m_numContiguousNodes * sizeof(btOptimizedBvhNode));
+	out += header.m_numContiguousNodes * sizeof(btOptimizedBvhNode);
+
+	if (header.m_numQuantizedContiguousNodes)
+		memcpy(out, &m_quantizedContiguousNodes[0], header.m_numQuantizedContiguousNodes * sizeof(btQuantizedBvhNode));
+	out += header.m_numQuantizedContiguousNodes * sizeof(btQuantizedBvhNode);
+
+	if (header.m_numSubtreeHeaders)
+		memcpy(out, &m_SubtreeHeaders[0], header.m_numSubtreeHeaders * sizeof(btBvhSubtreeInfo));
+}
+
+bool btQuantizedBvh::deSerialize(const void* i_dataBuffer, unsigned i_dataBufferSize)
+{
+	if (i_dataBufferSize < sizeof(btQuantizedBvhSerializeHeader))
+		return false;
+
+	btQuantizedBvhSerializeHeader header;
+	const unsigned char* in = (const unsigned char*)i_dataBuffer;
+	memcpy(&header, in, sizeof(header));
+	in += sizeof(header);
+
+	if (header.m_bulletVersion != BT_BULLET_VERSION ||
+		header.m_numContiguousNodes < 0 || header.m_numQuantizedContiguousNodes < 0 || header.m_numSubtreeHeaders < 0)
+		return false;
+
+	size_t expectedSize = sizeof(header) +
+						  (size_t)header.m_numContiguousNodes * sizeof(btOptimizedBvhNode) +
+						  (size_t)header.m_numQuantizedContiguousNodes * sizeof(btQuantizedBvhNode) +
+						  (size_t)header.m_numSubtreeHeaders * sizeof(btBvhSubtreeInfo);
+	if (i_dataBufferSize != expectedSize)
+		return false;
+
+	m_bvhAabbMin = header.m_bvhAabbMin;
+	m_bvhAabbMax = header.m_bvhAabbMax;
+	m_bvhQuantization = header.m_bvhQuantization;
+	m_curNodeIndex = header.m_curNodeIndex;
+	m_useQuantization = header.m_useQuantization != 0;
+
+	m_leafNodes.clear();
+	m_quantizedLeafNodes.clear();
+
+	m_contiguousNodes.resize(header.m_numContiguousNodes);
+	if (header.m_numContiguousNodes)
+		memcpy(&m_contiguousNodes[0], in, header.m_numContiguousNodes * sizeof(btOptimizedBvhNode));
+	in += header.m_numContiguousNodes * sizeof(btOptimizedBvhNode);
+
+	m_quantizedContiguousNodes.resize(header.m_numQuantizedContiguousNodes);
+	if (header.m_numQuantizedContiguousNodes)
+		memcpy(&m_quantizedContiguousNodes[0], in, header.m_numQuantizedContiguousNodes * sizeof(btQuantizedBvhNode));
+	in += header.m_numQuantizedContiguousNodes * sizeof(btQuantizedBvhNode);
+
+	m_SubtreeHeaders.resize(header.m_numSubtreeHeaders);
+	if (header.m_numSubtreeHeaders)
+		memcpy(&m_SubtreeHeaders[0], in, header.m_numSubtreeHeaders * sizeof(btBvhSubtreeInfo));
+	m_subtreeHeaderCount = m_SubtreeHeaders.size();
+
+	return true;
+}
+
 #if 0
 //PCK: consts
 static const unsigned BVH_ALIGNMENT = 16;
@@ -429,6 +429,12 @@ public:
 		return m_useQuantization;
 	}
 
+	///Raw copy of a built tree, for caching. Only readable by the same build of the library.
+	unsigned calculateSerializeBufferSize() const;
+	void serialize(void* o_dataBuffer) const;
+	///Returns false if the buffer is not a valid tree
+	bool deSerialize(const void* i_dataBuffer, unsigned i_dataBufferSize);
+
 private:
 	// Special "copy" constructor that allows for in-place deserialization
 	// Prevents btVector3's default constructor from being called, but doesn't inialize much else
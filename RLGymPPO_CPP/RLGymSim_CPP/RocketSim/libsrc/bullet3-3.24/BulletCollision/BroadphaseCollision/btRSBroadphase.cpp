@@ -145,7 +145,7 @@ btBroadphaseProxy* btRSBroadphase::createProxy(const btVector3& aabbMin, const b
 	btAssert(aabbMin[0] <= aabbMax[0] && aabbMin[1] <= aabbMax[1] && aabbMin[2] <= aabbMax[2]);
 
 	// TODO: Stupid
-	bool isStatic = (shapeType == TRIANGLE_MESH_SHAPE_PROXYTYPE || shapeType == STATIC_PLANE_PROXYTYPE);
+	bool isStatic = (shapeType == TRIANGLE_MESH_SHAPE_PROXYTYPE || shapeType == STATIC_PLANE_PROXYTYPE || shapeType == CUSTOM_CONCAVE_SHAPE_TYPE);
 
 	int newHandleIndex = allocHandle();
 	int cellIdx = GetCellIdx(aabbMin);
@@ -161,6 +161,15 @@ btBroadphaseProxy* btRSBroadphase::createProxy(const btVector3& aabbMin, const b
 	if (isStatic) {
 		_UpdateCellsStatic<true>(this, proxy);
 
+		for (int i = 0; i < 64; i++) {
+			unsigned long long bit = 1ull << i;
+			if (!(usedStaticIdxBits & bit)) {
+				usedStaticIdxBits |= bit;
+				proxy->staticIdx = i;
+				break;
+			}
+		}
+
 	} else {
 		if (aabbMin.distance2(aabbMax) > cellSizeSq)
 			THROW_ERR("Object AABB size exceeds maximum cell size (" + std::to_string(aabbMin.distance(aabbMax)) + " > " + std::to_string(cellSize) + ")");
@@ -205,14 +214,17 @@ void btRSBroadphase::destroyProxy(btBroadphaseProxy* proxyOrg, btCollisionDispat
 	
 	if (sbp->isStatic) {
 		_UpdateCellsStatic<false>(this, sbp);
-	} else {
-		Cell& cell = cells[sbp->cellIdx];
-		for (int i = 0; i < cell.dynHandles.size(); i++) {
-			if (cell.dynHandles[i] == proxyOrg) {
-				cell.dynHandles.erase(cell.dynHandles.begin() + i);
-				break;
-			}
+
+		if (sbp->staticIdx >= 0) {
+			// Pairs with this proxy were just removed
+			unsigned long long bit = 1ull << sbp->staticIdx;
+			for (int i = 0; i <= m_LastHandleIndex; i++)
+				m_pHandles[i].staticPairBits &= ~bit;
+			usedStaticIdxBits &= ~bit;
 		}
+	} else {
+		// Dynamic proxies are in every cell around theirs, not just their own
+		_UpdateCellsDynamic<false>(this, sbp, sbp->iIdx, sbp->jIdx, sbp->kIdx);
 		numDynProxies--;
 	}
 
@@ -347,6 +359,24 @@ void btRSBroadphase::calculateOverlappingPairs(btCollisionDispatcher* dispatcher
 			for (auto& otherProxy : cell.staticHandles) {
 				totalStaticPairs++;
 
+				if (shouldRemove && otherProxy->staticIdx >= 0) {
+					// We already know if we have this pair, so only touch the pair cache when that changes
+					unsigned long long bit = 1ull << otherProxy->staticIdx;
+					bool overlapping = aabbOverlap(proxy, otherProxy);
+					bool hasPair = (proxy->staticPairBits & bit) != 0;
+					if (overlapping != hasPair) {
+						if (overlapping) {
+							m_pairCache->addOverlappingPair(proxy, otherProxy);
+							proxy->staticPairBits |= bit;
+							totalRealPairs++;
+						} else {
+							m_pairCache->removeOverlappingPair(proxy, otherProxy, dispatcher);
+							proxy->staticPairBits &= ~bit;
+						}
+					}
+					continue;
+				}
+
 				if (aabbOverlap(proxy, otherProxy)) {
 					if (!m_pairCache->findPair(proxy, otherProxy)) {
 						m_pairCache->addOverlappingPair(proxy, otherProxy);
@@ -399,6 +429,19 @@ bool btRSBroadphase::testAabbOverlap(btBroadphaseProxy* proxy0, btBroadphaseProx
 	return aabbOverlap(p0, p1);
 }
 
+void btRSBroadphase::sortFreeHandles() {
+	// The last free handle links back to the first, as in the constructor
+	int nextFree = (m_highestUsedHandleIndex + 1 < m_maxHandles) ? (m_highestUsedHandleIndex + 1) : 0;
+	for (int i = m_highestUsedHandleIndex; i >= 0; i--) {
+		if (m_pHandles[i].m_clientObject)
+			continue;
+
+		m_pHandles[i].SetNextFree(nextFree);
+		nextFree = i;
+	}
+	m_firstFreeHandle = nextFree;
+}
+
 void btRSBroadphase::resetPool(btCollisionDispatcher* dispatcher) {
 	//not yet
 }
@@ -13,6 +13,13 @@ struct btRSBroadphaseProxy : public btBroadphaseProxy
 	int shapeType;
 	int m_nextFree;
 
+	// Static proxies: Bit index for staticPairBits, or -1 if all bits are taken
+	int staticIdx = -1;
+
+	// Dynamic proxies: Bits of the static proxies we have added pairs with (or tried to, if filtered out)
+	// Lets us skip looking up static pairs in the pair cache every time we check them
+	unsigned long long staticPairBits = 0;
+
 	//	int			m_handleId;
 
 	btRSBroadphaseProxy() {};
@@ -39,6 +46,7 @@ public:
 	int m_numHandles;  // number of active handles
 	int m_maxHandles;  // max number of handles
 	int m_LastHandleIndex;
+	int m_highestUsedHandleIndex = -1; // Handles after this one have never been used, so they are still linked in order
 
 	btVector3 minPos, maxPos;
 	float cellSize, cellSizeSq;
@@ -47,6 +55,9 @@ public:
 
 	int numDynProxies = 0;
 
+	// Static proxy bit indices in use, see btRSBroadphaseProxy::staticIdx
+	unsigned long long usedStaticIdxBits = 0;
+
 	int totalStaticPairs = 0, totalDynPairs = 0;
 	int totalRealPairs = 0;
 	int totalItrs = 0;
@@ -114,6 +125,9 @@ public:
 		if (freeHandle > m_LastHandleIndex) {
 			m_LastHandleIndex = freeHandle;
 		}
+		if (freeHandle > m_highestUsedHandleIndex) {
+			m_highestUsedHandleIndex = freeHandle;
+		}
 		return freeHandle;
 	}
 
@@ -149,6 +163,10 @@ public:
 	///reset broadphase internal structures, to ensure determinism/reproducability
 	virtual void resetPool(btCollisionDispatcher* dispatcher);
 
+	// Relinks the free handles in index order, as in a new broadphase
+	// Proxies made after this get the same handles (and so unique IDs) as they would in a new broadphase with the same proxies in use
+	void sortFreeHandles();
+
 	void validate();
 
 protected:
@@ -87,6 +87,7 @@ btPersistentManifold* btCollisionDispatcher::getNewManifold(const btCollisionObj
 		//we got a pool memory overflow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
 		if ((m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) == 0)
 		{
+			m_manifoldPoolOverflows++;
 			mem = btAlignedAlloc(sizeof(btPersistentManifold), 16);
 		}
 		else
@@ -275,7 +276,7 @@ void* btCollisionDispatcher::allocateCollisionAlgorithm(int size)
 	void* mem = m_collisionAlgorithmPoolAllocator->allocate(size);
 	if (NULL == mem)
 	{
-		//warn user for overflow?
+		m_algorithmPoolOverflows++;
 		return btAlignedAlloc(static_cast<size_t>(size), 16);
 	}
 	return mem;
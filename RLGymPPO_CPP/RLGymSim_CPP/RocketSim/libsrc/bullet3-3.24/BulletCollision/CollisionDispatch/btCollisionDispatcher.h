@@ -58,6 +58,10 @@ protected:
 	btCollisionConfiguration* m_collisionConfiguration;
 
 public:
+	///allocations that didn't fit in the pools, and were made on the heap instead
+	unsigned long long m_manifoldPoolOverflows = 0;
+	unsigned long long m_algorithmPoolOverflows = 0;
+
 	enum DispatcherFlags
 	{
 		CD_STATIC_STATIC_REPORTED = 1,
@@ -165,6 +169,11 @@ public:
 	{
 		return m_persistentManifoldPoolAllocator;
 	}
+
+	const btPoolAllocator* getInternalCollisionAlgorithmPool() const
+	{
+		return m_collisionAlgorithmPoolAllocator;
+	}
 };
 
 #endif  //BT_COLLISION__DISPATCHER_H
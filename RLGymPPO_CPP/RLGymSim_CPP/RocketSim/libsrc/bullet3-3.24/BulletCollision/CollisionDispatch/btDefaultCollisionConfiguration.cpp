@@ -91,16 +91,7 @@ void btDefaultCollisionConfiguration::setup(const btDefaultCollisionConstruction
 	m_planeConvexCF = new (mem) btConvexPlaneCollisionAlgorithm::CreateFunc;
 	m_planeConvexCF->m_swapped = true;
 
-	///calculate maximum element size, big enough to fit any collision algorithm in the memory pool
-	int maxSize = sizeof(btConvexConvexAlgorithm);
-	int maxSize2 = sizeof(btConvexConcaveCollisionAlgorithm);
-	int maxSize3 = sizeof(btCompoundCollisionAlgorithm);
-	int maxSize4 = sizeof(btCompoundCompoundCollisionAlgorithm);
-
-	int collisionAlgorithmMaxElementSize = btMax(maxSize, constructionInfo.m_customCollisionAlgorithmMaxElementSize);
-	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize2);
-	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize3);
-	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize4);
+	int collisionAlgorithmMaxElementSize = getCollisionAlgorithmPoolElementSize(constructionInfo.m_customCollisionAlgorithmMaxElementSize);
 
 	if (constructionInfo.m_persistentManifoldPool)
 	{
@@ -114,7 +105,6 @@ void btDefaultCollisionConfiguration::setup(const btDefaultCollisionConstruction
 		m_persistentManifoldPool = new (mem) btPoolAllocator(sizeof(btPersistentManifold), constructionInfo.m_defaultMaxPersistentManifoldPoolSize);
 	}
 
-	collisionAlgorithmMaxElementSize = (collisionAlgorithmMaxElementSize + 16) & 0xffffffffffff0;
 	if (constructionInfo.m_collisionAlgorithmPool)
 	{
 		m_ownsCollisionAlgorithmPool = false;
@@ -128,6 +118,22 @@ void btDefaultCollisionConfiguration::setup(const btDefaultCollisionConstruction
 	}
 }
 
+int btDefaultCollisionConfiguration::getCollisionAlgorithmPoolElementSize(int customCollisionAlgorithmMaxElementSize)
+{
+	///calculate maximum element size, big enough to fit any collision algorithm in the memory pool
+	int maxSize = sizeof(btConvexConvexAlgorithm);
+	int maxSize2 = sizeof(btConvexConcaveCollisionAlgorithm);
+	int maxSize3 = sizeof(btCompoundCollisionAlgorithm);
+	int maxSize4 = sizeof(btCompoundCompoundCollisionAlgorithm);
+
+	int collisionAlgorithmMaxElementSize = btMax(maxSize, customCollisionAlgorithmMaxElementSize);
+	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize2);
+	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize3);
+	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize4);
+
+	return (collisionAlgorithmMaxElementSize + 16) & 0xffffffffffff0;
+}
+
 btDefaultCollisionConfiguration::~btDefaultCollisionConfiguration()
 {
 	if (m_ownsCollisionAlgorithmPool)
@@ -82,6 +82,9 @@ public:
 
 	virtual ~btDefaultCollisionConfiguration();
 
+	///element size of the collision algorithm pool, for creating pools to pass in btDefaultCollisionConstructionInfo
+	static int getCollisionAlgorithmPoolElementSize(int customCollisionAlgorithmMaxElementSize = 0);
+
 	///memory pools
 	virtual btPoolAllocator* getPersistentManifoldPool()
 	{
@@ -32,6 +32,8 @@ void btConcaveShape::processAllTriangles(btTriangleCallback* callback, const btV
 		return ((btBvhTriangleMeshShape*)this)->processAllTriangles(callback, aabbMin, aabbMax);
 	case STATIC_PLANE_PROXYTYPE:
 		return ((btStaticPlaneShape*)this)->processAllTriangles(callback, aabbMin, aabbMax);
+	case CUSTOM_CONCAVE_SHAPE_TYPE:
+		return; // Custom shapes collide through their own algorithms, and have no triangles
 	default:
 		btAssert(false);
 	}
@@ -32,6 +32,9 @@ enum btSolverMode
 	SOLVER_ALLOW_ZERO_LENGTH_FRICTION_DIRECTIONS = 1024,
 	SOLVER_DISABLE_IMPLICIT_CONE_FRICTION = 2048,
 	SOLVER_USE_ARTICULATED_WARMSTARTING = 4096,
+	// ROCKETSIM CHANGE: Always use the generic iterations, instead of the contact-only ones when there are no joints
+	// Both give the same results, this is only used to compare their performance
+	SOLVER_RS_GENERIC_ITERATIONS = 8192,
 };
 
 struct btContactSolverInfoData
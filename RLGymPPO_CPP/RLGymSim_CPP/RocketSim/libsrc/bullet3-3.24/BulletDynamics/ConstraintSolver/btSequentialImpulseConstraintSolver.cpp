@@ -1812,6 +1812,13 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyIterations(
 {
 	BT_PROFILE("solveGroupCacheFriendlyIterations");
 
+	// ROCKETSIM CHANGE: Use the contact-only iterations when we can
+	if (canSolveContactsOnly(numConstraints, infoGlobal))
+	{
+		m_leastSquaresResidual = solveContactsOnlyIterations(bodies, numBodies, manifoldPtr, numManifolds, infoGlobal);
+		return 0.f;
+	}
+
 	{
 		///this is a special step to resolve penetrations (just for contacts)
 		solveGroupCacheFriendlySplitImpulseIterations(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal);
@@ -1827,6 +1834,101 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyIterations(
 	return 0.f;
 }
 
+// ROCKETSIM CHANGE: Contact-only iterations
+bool btSequentialImpulseConstraintSolver::canSolveContactsOnly(int numConstraints, const btContactSolverInfo& infoGlobal) const
+{
+	// Rows must be solved in the same order as solveSingleIteration(), so its other orders are left to it
+	const int genericModes = SOLVER_RANDMIZE_ORDER | SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS | SOLVER_RS_GENERIC_ITERATIONS;
+	return numConstraints == 0 && m_tmpSolverNonContactConstraintPool.size() == 0 && (infoGlobal.m_solverMode & genericModes) == 0;
+}
+
+btScalar btSequentialImpulseConstraintSolver::solveContactsOnlyIterations(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, const btContactSolverInfo& infoGlobal)
+{
+	BT_PROFILE("solveContactsOnlyIterations");
+
+	int numContactPool = m_tmpSolverContactConstraintPool.size();
+	int numFrictionPool = m_tmpSolverContactFrictionConstraintPool.size();
+	int numRollingFrictionPool = m_tmpSolverContactRollingFrictionConstraintPool.size();
+	if (numContactPool == 0 && numFrictionPool == 0 && numRollingFrictionPool == 0)
+		return 0.f;
+
+	solveGroupCacheFriendlySplitImpulseIterations(bodies, numBodies, manifoldPtr, numManifolds, NULL, 0, infoGlobal);
+
+	// Solver bodies are never added during the iterations, so their pointers stay valid
+	m_rsContactRows.resizeNoInitialize(0);
+	for (int i = 0; i < numContactPool; i++)
+	{
+		btSolverConstraint& constraint = m_tmpSolverContactConstraintPool[i];
+		if (constraint.m_isSpecial)  // Only resolve non-special manifolds
+			continue;
+
+		btRSContactRow& row = m_rsContactRows.expandNonInitializing();
+		row.m_constraint = &constraint;
+		row.m_bodyA = &m_tmpSolverBodyPool[constraint.m_solverBodyIdA];
+		row.m_bodyB = &m_tmpSolverBodyPool[constraint.m_solverBodyIdB];
+		row.m_contact = NULL;
+	}
+
+	m_rsFrictionRows.resizeNoInitialize(numFrictionPool);
+	for (int i = 0; i < numFrictionPool; i++)
+	{
+		btSolverConstraint& constraint = m_tmpSolverContactFrictionConstraintPool[i];
+		btRSContactRow& row = m_rsFrictionRows[i];
+		row.m_constraint = &constraint;
+		row.m_bodyA = &m_tmpSolverBodyPool[constraint.m_solverBodyIdA];
+		row.m_bodyB = &m_tmpSolverBodyPool[constraint.m_solverBodyIdB];
+		row.m_contact = &m_tmpSolverContactConstraintPool[constraint.m_frictionIndex];
+	}
+
+	int numContactRows = m_rsContactRows.size();
+	btScalar leastSquaresResidual = 0.f;
+	for (int iteration = 0; iteration < infoGlobal.m_numIterations; iteration++)
+	{
+		leastSquaresResidual = 0.f;
+
+		for (int j = 0; j < numContactRows; j++)
+		{
+			btRSContactRow& row = m_rsContactRows[j];
+			btScalar residual = m_resolveSingleConstraintRowLowerLimit(*row.m_bodyA, *row.m_bodyB, *row.m_constraint);
+			leastSquaresResidual = btMax(leastSquaresResidual, residual * residual);
+		}
+
+		for (int j = 0; j < numFrictionPool; j++)
+		{
+			btRSContactRow& row = m_rsFrictionRows[j];
+			btScalar totalImpulse = row.m_contact->m_appliedImpulse;
+			if (totalImpulse > btScalar(0))
+			{
+				btSolverConstraint& constraint = *row.m_constraint;
+				constraint.m_lowerLimit = -(constraint.m_friction * totalImpulse);
+				constraint.m_upperLimit = constraint.m_friction * totalImpulse;
+
+				btScalar residual = m_resolveSingleConstraintRowGeneric(*row.m_bodyA, *row.m_bodyB, constraint);
+				leastSquaresResidual = btMax(leastSquaresResidual, residual * residual);
+			}
+		}
+
+		for (int j = 0; j < numRollingFrictionPool; j++)
+		{
+			btSolverConstraint& rollingFrictionConstraint = m_tmpSolverContactRollingFrictionConstraintPool[j];
+			btScalar totalImpulse = m_tmpSolverContactConstraintPool[rollingFrictionConstraint.m_frictionIndex].m_appliedImpulse;
+			if (totalImpulse > btScalar(0))
+			{
+				btScalar rollingFrictionMagnitude = rollingFrictionConstraint.m_friction * totalImpulse;
+				if (rollingFrictionMagnitude > rollingFrictionConstraint.m_friction)
+					rollingFrictionMagnitude = rollingFrictionConstraint.m_friction;
+
+				rollingFrictionConstraint.m_lowerLimit = -rollingFrictionMagnitude;
+				rollingFrictionConstraint.m_upperLimit = rollingFrictionMagnitude;
+
+				btScalar residual = m_resolveSingleConstraintRowGeneric(m_tmpSolverBodyPool[rollingFrictionConstraint.m_solverBodyIdA], m_tmpSolverBodyPool[rollingFrictionConstraint.m_solverBodyIdB], rollingFrictionConstraint);
+				leastSquaresResidual = btMax(leastSquaresResidual, residual * residual);
+			}
+		}
+	}
+	return leastSquaresResidual;
+}
+
 void btSequentialImpulseConstraintSolver::writeBackContacts(int iBegin, int iEnd, const btContactSolverInfo& infoGlobal)
 {
 	for (int j = iBegin; j < iEnd; j++)
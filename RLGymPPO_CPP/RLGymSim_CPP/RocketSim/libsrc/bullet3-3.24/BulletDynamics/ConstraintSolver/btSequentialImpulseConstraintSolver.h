@@ -80,6 +80,17 @@ public:
 
 	btScalar m_leastSquaresResidual;
 
+	// ROCKETSIM CHANGE: Rows of the contact-only iterations, with their solver bodies looked up once per solve
+	struct btRSContactRow
+	{
+		btSolverConstraint* m_constraint;
+		btSolverBody* m_bodyA;
+		btSolverBody* m_bodyB;
+		const btSolverConstraint* m_contact; // Contact of a friction row, whose impulse limits it
+	};
+	btAlignedObjectArray<btRSContactRow> m_rsContactRows;
+	btAlignedObjectArray<btRSContactRow> m_rsFrictionRows;
+
 	void setupFrictionConstraint(btSolverConstraint & solverConstraint, const btVector3& normalAxis, int solverBodyIdA, int solverBodyIdB,
 		btManifoldPoint& cp, const btVector3& rel_pos1, const btVector3& rel_pos2,
 		btCollisionObject* colObj0, btCollisionObject* colObj1, btScalar relaxation,
@@ -157,6 +168,11 @@ protected:
 	btScalar solveGroupCacheFriendlySetup(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal);
 	btScalar solveGroupCacheFriendlyIterations(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal);
 
+	// ROCKETSIM CHANGE: Same as solveGroupCacheFriendlyIterations() and solveSingleIteration() without joints, which RocketSim never has
+	// Returns right away when there are no contacts (most ticks), and otherwise skips the order tables and joint handling of every iteration
+	bool canSolveContactsOnly(int numConstraints, const btContactSolverInfo& infoGlobal) const;
+	btScalar solveContactsOnlyIterations(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, const btContactSolverInfo& infoGlobal);
+
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
 
@@ -232,7 +232,8 @@ inline int btIsDoublePrecision()
 							#include <emmintrin.h>
 						#endif
 					#endif //BT_USE_SSE
-				#elif defined( __ARM_NEON__ )
+				#elif defined( __ARM_NEON__ ) || (defined(BT_ARM64_NEON) && defined(__aarch64__))
+					// BT_ARM64_NEON opts 64-bit ARM compilers that don't define __ARM_NEON__ (i.e. on Linux) into these paths
 					#ifdef __clang__
 						#define BT_USE_NEON 1
 						#define BT_USE_SIMD_VECTOR3
@@ -25,5 +25,14 @@ enum : int {
 	BT_USERINFO_NONE,
 
 	BT_USERINFO_TYPE_CAR,
-	BT_USERINFO_TYPE_BALL
+	BT_USERINFO_TYPE_BALL,
+
+	BT_USERINFO_TYPE_AMOUNT
 };
+
+// Bullet's default user index, used by our static world collision objects
+#define BT_USERINFO_WORLD -1
+
+// Compact ID of a collision object's user index (world is 0), for use in lookup tables
+#define BT_USERINFO_TO_ID(userIndex) ((userIndex) - BT_USERINFO_WORLD)
+#define BT_USERINFO_ID_AMOUNT BT_USERINFO_TO_ID(BT_USERINFO_TYPE_AMOUNT)
@@ -4,14 +4,94 @@
 
 #include "../../libsrc/bullet3-3.24/BulletDynamics/Dynamics/btRigidBody.h"
 #include "../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
-#include "../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btTriangleMesh.h"
+#include "../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 RS_NS_START
 
+struct CollisionMeshFile::Storage {
+	const byte* mapData = NULL;
+	size_t mapSize = 0;
+	void* _mapHandle = NULL; // Windows only
+
+	// Only used if the file can't be read in place (big-endian)
+	std::vector<Triangle> tris;
+	std::vector<Vertex> vertices;
+
+	Storage() = default;
+	Storage(const Storage&) = delete;
+	Storage& operator=(const Storage&) = delete;
+
+	~Storage() {
+#ifdef _WIN32
+		if (mapData)
+			UnmapViewOfFile(mapData);
+		if (_mapHandle)
+			CloseHandle(_mapHandle);
+#else
+		if (mapData)
+			munmap((void*)mapData, mapSize);
+#endif
+	}
+};
+
+// Bullet mesh over a mesh file's triangles and vertices, which keeps their storage alive
+struct _MappedBulletMesh : public btTriangleIndexVertexArray {
+	std::shared_ptr<CollisionMeshFile::Storage> storage;
+};
+
 void CollisionMeshFile::ReadFromFile(std::string filePath) {
 	constexpr char ERROR_PREFIX_STR[] = " > CollisionMeshFile::ReadFromFile(): ";
 
-	DataStreamIn in = DataStreamIn(filePath, false);
+	auto storage = std::make_shared<Storage>();
+	_storage = storage;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(std::filesystem::path(filePath).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		RS_ERR_CLOSE(ERROR_PREFIX_STR << "Failed to open \"" << filePath << "\"");
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	storage->mapSize = fileSize.QuadPart;
+
+	if (storage->mapSize > 0) {
+		storage->_mapHandle = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (storage->_mapHandle)
+			storage->mapData = (const byte*)MapViewOfFile(storage->_mapHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+	CloseHandle(file);
+#else
+	int file = open(filePath.c_str(), O_RDONLY);
+	if (file == -1)
+		RS_ERR_CLOSE(ERROR_PREFIX_STR << "Failed to open \"" << filePath << "\"");
+
+	struct stat fileStat;
+	fstat(file, &fileStat);
+	storage->mapSize = fileStat.st_size;
+
+	if (storage->mapSize > 0) {
+		void* map = mmap(NULL, storage->mapSize, PROT_READ, MAP_PRIVATE, file, 0);
+		if (map != MAP_FAILED)
+			storage->mapData = (const byte*)map;
+	}
+	close(file); // The mapping stays valid
+#endif
+
+	if (!storage->mapData)
+		RS_ERR_CLOSE(ERROR_PREFIX_STR << "Failed to map \"" << filePath << "\" (" << storage->mapSize << " bytes)");
+
+	DataStreamIn in = DataStreamIn::FromBuffer(storage->mapData, storage->mapSize);
 
 	constexpr int MAX_VERT_OR_TRI_COUNT = 1000 * 1000;
 
@@ -26,24 +106,34 @@ void CollisionMeshFile::ReadFromFile(std::string filePath) {
 			"\" (bad triangle/vertex count: [" << numTris << ", " << numVertices << "])");
 	}
 
-	tris.resize(numTris);
-	vertices.resize(numVertices);
+	// Always checked, since the triangles and vertices are read in place
+	size_t dataSize = (numTris * sizeof(Triangle)) + (numVertices * sizeof(Vertex));
+	if (in.GetNumBytesLeft() < dataSize) {
+		RS_ERR_CLOSE(
+			ERROR_PREFIX_STR << "Invalid collision mesh file at \"" << filePath <<
+			"\" (input data overflown by " << (dataSize - in.GetNumBytesLeft()) << " bytes!)");
+	}
 
-	for (Triangle& tri : tris)
-		tri = in.Read<Triangle>();
+	if (RS_IS_BIG_ENDIAN) {
+		storage->tris.resize(numTris);
+		storage->vertices.resize(numVertices);
 
-	for (Vertex& vert : vertices)
-		vert = in.Read<Vertex>();
+		for (Triangle& tri : storage->tris)
+			tri = in.Read<Triangle>();
 
-#ifndef RS_MAX_SPEED
-	if (in.IsOverflown()) {
-		RS_ERR_CLOSE(
-			ERROR_PREFIX_STR << "Invalid collision mesh file at \"" << filePath <<
-			"\" (input data overflown by " << (in.pos - in.data.size()) << " bytes!)");
+		for (Vertex& vert : storage->vertices)
+			vert = in.Read<Vertex>();
+
+		tris = storage->tris;
+		vertices = storage->vertices;
+	} else {
+		tris = { (const Triangle*)(in.GetData() + in.pos), (size_t)numTris };
+		vertices = { (const Vertex*)(in.GetData() + in.pos + numTris * sizeof(Triangle)), (size_t)numVertices };
 	}
 
+#ifndef RS_MAX_SPEED
 	// Verify that the triangle data is correct
-	for (Triangle& tri : tris) {
+	for (const Triangle& tri : tris) {
 		for (int i = 0; i < 3; i++) {
 			int vertIndex = tri.vertexIndexes[i];
 			if (vertIndex < 0 || vertIndex >= numVertices) {
@@ -60,14 +150,18 @@ void CollisionMeshFile::ReadFromFile(std::string filePath) {
 	RS_LOG("   > Loaded " << numVertices << " verts and " << numTris << " tris, hash: 0x" << std::hex << hash);
 }
 
-btTriangleMesh* CollisionMeshFile::MakeBulletMesh() {
-	btTriangleMesh* result = new btTriangleMesh();
-
-	for (Vertex& vert : vertices)
-		result->findOrAddVertex(btVector3(vert.x, vert.y, vert.z), false);
+btStridingMeshInterface* CollisionMeshFile::MakeBulletMesh() const {
+	_MappedBulletMesh* result = new _MappedBulletMesh();
+	result->storage = _storage;
 
-	for (Triangle& tri : tris)
-		result->addTriangleIndices(tri.vertexIndexes[0], tri.vertexIndexes[1], tri.vertexIndexes[2]);
+	btIndexedMesh mesh;
+	mesh.m_numTriangles = tris.size();
+	mesh.m_triangleIndexBase = (const unsigned char*)tris.data();
+	mesh.m_triangleIndexStride = sizeof(Triangle);
+	mesh.m_numVertices = vertices.size();
+	mesh.m_vertexBase = (const unsigned char*)vertices.data();
+	mesh.m_vertexStride = sizeof(Vertex);
+	result->addIndexedMesh(mesh);
 
 	return result;
 }
@@ -81,7 +175,7 @@ void CollisionMeshFile::UpdateHash() {
 		HASH_VAL_MUELLER = 0x45D9F3B,
 		HASH_VAL_SHIFT = 0x9E3779B9;
 
-	for (Triangle& tri : tris) {
+	for (const Triangle& tri : tris) {
 		for (int i = 0; i < 3; i++) {
 			for (int j = 0; j < 3; j++) {
 				uint32_t curVal = vertices[tri.vertexIndexes[i]][j];
@@ -2,10 +2,13 @@
 #include "../Framework.h"
 #include "../BulletLink.h"
 
+#include <memory>
+#include <span>
+
 #define COLLISION_MESH_BASE_PATH "./collision_meshes/"
 #define COLLISION_MESH_FILE_EXTENSION ".cmf"
 
-class btTriangleMesh;
+class btStridingMeshInterface;
 
 RS_NS_START
 
@@ -23,15 +26,28 @@ struct CollisionMeshFile {
 			assert(index < 3);
 			return (index == 0) ? x : ((index == 1) ? y : z);
 		}
+
+		float operator[](uint32_t index) const {
+			assert(index < 3);
+			return (index == 0) ? x : ((index == 1) ? y : z);
+		}
 	};
 
-	std::vector<Triangle> tris;
-	std::vector<Vertex> vertices;
+	// Memory that the triangles and vertices are in, shared with the Bullet meshes made from them
+	// The file is memory-mapped, so processes loading the same meshes share their pages
+	struct Storage;
+	std::shared_ptr<Storage> _storage;
+
+	// Point into _storage, read-only
+	std::span<const Triangle> tris;
+	std::span<const Vertex> vertices;
 
 	uint32_t hash;
 
 	void ReadFromFile(std::string filePath);
-	btTriangleMesh* MakeBulletMesh();
+
+	// The mesh reads the triangles and vertices in place, without copying them
+	btStridingMeshInterface* MakeBulletMesh() const;
 	void UpdateHash();
 };
 
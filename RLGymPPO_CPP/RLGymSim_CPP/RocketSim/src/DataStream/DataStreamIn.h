@@ -6,53 +6,78 @@
 RS_NS_START
 
 // Basic struct for reading raw data from a file
+// Can also read directly from an external buffer, without copying it
 struct DataStreamIn {
 	std::vector<byte> data;
 	size_t pos = 0;
 
+	// External buffer to read from instead of data, see FromBuffer()
+	const byte* _extData = NULL;
+	size_t _extSize = 0;
+
 	DataStreamIn() = default;
 
 	DataStreamIn(std::filesystem::path filePath, bool versionCheck) {
-		std::ifstream fileStream = std::ifstream(filePath, std::ios::binary);
+		std::ifstream fileStream = std::ifstream(filePath, std::ios::binary | std::ios::ate);
 		if (!fileStream.good())
 			RS_ERR_CLOSE("Failed to read file " << filePath << ", cannot open file.");
 		
-		fileStream >> std::noskipws;
-		data = std::vector<byte>(std::istreambuf_iterator<char>(fileStream), std::istreambuf_iterator<char>());
+		// Read the whole file at once
+		std::streamsize fileSize = fileStream.tellg();
+		fileStream.seekg(0, std::ios::beg);
+		data.resize(RS_MAX(fileSize, 0));
+		if (!data.empty() && !fileStream.read((char*)data.data(), data.size()))
+			RS_ERR_CLOSE("Failed to read file " << filePath << ", cannot read file data.");
 
 		if (versionCheck && !DoVersionCheck()) {
 			RS_ERR_CLOSE("Failed to read file " << filePath << ", file is invalid or from a different version of RocketSim.");
 		}
 	}
 
+	// Reads from an external buffer, which must outlive this stream
+	static DataStreamIn FromBuffer(const void* buffer, size_t size) {
+		DataStreamIn result = {};
+		result._extData = (const byte*)buffer;
+		result._extSize = size;
+		return result;
+	}
+
+	const byte* GetData() const {
+		return _extData ? _extData : data.data();
+	}
+
+	size_t GetSize() const {
+		return _extData ? _extSize : data.size();
+	}
+
 	bool DoVersionCheck() {
 		uint32_t versionID = Read<uint32_t>();
 		return versionID == RS_VERSION_ID;
 	}
 
 	bool IsDone() const {
-		return pos >= data.size();
+		return pos >= GetSize();
 	}
 
 	bool IsOverflown() const {
-		return pos > data.size();
+		return pos > GetSize();
 	}
 
 	size_t GetNumBytesLeft() const {
 		if (IsDone()) {
 			return 0;
 		} else {
-			return data.size() - pos;
+			return GetSize() - pos;
 		}
 	}
 
 	void ReadBytes(void* out, size_t amount) {
 		if (GetNumBytesLeft() >= amount) {
 			byte* asBytes = (byte*)out;
-			memcpy(asBytes, data.data() + pos, amount);
+			memcpy(asBytes, GetData() + pos, amount);
 
 			if (RS_IS_BIG_ENDIAN)
-				std::reverse(asBytes, asBytes + sizeof(amount));
+				std::reverse(asBytes, asBytes + amount);
 		}
 
 		pos += amount;
@@ -70,7 +95,7 @@ struct DataStreamIn {
 		out = Read<T>();
 	}
 
-	void ReadMultipleFromList(std::vector<SerializeObject> objs) {
+	void ReadMultipleFromList(std::initializer_list<SerializeObject> objs) {
 		uint32_t amount = Read<uint32_t>();
 		if (amount != objs.size())
 			RS_ERR_CLOSE("DataStreamIn::ReadMultipleFromList(): Prop count mismatch, expected " << objs.size() << " but have " << amount << ".");
@@ -81,7 +106,7 @@ struct DataStreamIn {
 
 	template <typename... Args>
 	void ReadMultiple(Args&... args) {
-		ReadMultipleFromList({ args... });
+		ReadMultipleFromList({ SerializeObject(args)... });
 	}
 };
 
@@ -6,22 +6,50 @@
 RS_NS_START
 
 // Basic struct for writing raw data to a file
+// Writes into data, or straight to an output stream (file, socket, etc.) if one is given
+// NOTE: To write repeatedly without allocating, reuse the same DataStreamOut and call Clear() between writes
 struct DataStreamOut {
 	std::vector<byte> data;
-	size_t pos = 0;
+	size_t pos = 0; // Total bytes written
+
+	// If set, bytes are written to this stream instead of data
+	std::ostream* stream = NULL;
 
 	DataStreamOut() = default;
 
-	void WriteBytes(const void* ptr, size_t amount) {
+	explicit DataStreamOut(std::ostream& stream) : stream(&stream) {}
+
+	// Preallocate space for this many total bytes
+	void Reserve(size_t amount) {
 		data.reserve(amount);
-		if (RS_IS_BIG_ENDIAN) {
-			byte* reversed = (byte*)malloc(amount);
-			memcpy(reversed, ptr, amount);
-			std::reverse(reversed, reversed + amount);
-			data.insert(data.end(), (byte*)reversed, (byte*)reversed + amount);
-			free(reversed);
+	}
+
+	// Removes all written data, keeping the allocated space
+	void Clear() {
+		data.clear();
+		pos = 0;
+	}
+
+	void WriteBytes(const void* ptr, size_t amount) {
+		const byte* asBytes = (const byte*)ptr;
+
+		if (stream) {
+			if (RS_IS_BIG_ENDIAN) {
+				// Reverse through a small buffer, starting from the end
+				byte reversed[256];
+				for (size_t remaining = amount; remaining > 0;) {
+					size_t chunkSize = RS_MIN(remaining, sizeof(reversed));
+					std::reverse_copy(asBytes + remaining - chunkSize, asBytes + remaining, reversed);
+					stream->write((const char*)reversed, chunkSize);
+					remaining -= chunkSize;
+				}
+			} else {
+				stream->write((const char*)asBytes, amount);
+			}
 		} else {
-			data.insert(data.end(), (byte*)ptr, (byte*)ptr + amount);
+			data.insert(data.end(), asBytes, asBytes + amount);
+			if (RS_IS_BIG_ENDIAN)
+				std::reverse(data.end() - amount, data.end());
 		}
 
 		pos += amount;
@@ -32,26 +60,28 @@ struct DataStreamOut {
 		WriteBytes(&val, sizeof(T));
 	}
 
-	void WriteMultipleFromList(std::vector<SerializeObject> objs) {
+	void WriteMultipleFromList(std::initializer_list<SerializeObject> objs) {
 		Write<uint32_t>(objs.size());
 		for (const SerializeObject& obj : objs)
 			WriteBytes(obj.ptr, obj.size);
 	}
 
 	template<typename... Args>
-	void WriteMultiple(Args... args) {
-		WriteMultipleFromList({ args... });
+	void WriteMultiple(const Args&... args) {
+		WriteMultipleFromList({ SerializeObject(args)... });
 	}
 
 	void WriteToFile(std::filesystem::path filePath, bool writeVersionCheck) {
+		if (stream)
+			RS_ERR_CLOSE("Failed to write to file " << filePath << ", data was already written to a stream.");
+
 		std::ofstream fileStream = std::ofstream(filePath, std::ios::binary);
 		if (!fileStream.good())
 			RS_ERR_CLOSE("Failed to write to file " << filePath << ", cannot open file.");
 
 		if (writeVersionCheck) {
 			uint32_t version = RS_VERSION_ID;
-			byte* versionBytes = (byte*)&version;
-			data.insert(data.begin(), versionBytes, versionBytes + sizeof(version));
+			fileStream.write((char*)&version, sizeof(version));
 		}
 
 		if (!data.empty())
@@ -13,6 +13,13 @@ struct SerializeObject {
 		size = sizeof(T);
 	}
 
+	// For writing only
+	template<typename T>
+	SerializeObject(const T& val) {
+		ptr = (void*)&val;
+		size = sizeof(T);
+	}
+
 	// TODO: Override for Vec/RotMat so that we don't write/read the always-0 fourth component
 
 	SerializeObject(const SerializeObject& other) {
@@ -105,7 +105,4 @@ constexpr uint32_t __RS_GET_VERSION_ID() {
 }
 #define RS_VERSION_ID (__RS_GET_VERSION_ID())
 
-#define RS_IS_BIG_ENDIAN (std::endian::native == std::endian::big)
-
-// TODO: Remove more permanently
-#define RS_NO_SUSPCOLGRID
\ No newline at end of file
+#define RS_IS_BIG_ENDIAN (std::endian::native == std::endian::big)
\ No newline at end of file
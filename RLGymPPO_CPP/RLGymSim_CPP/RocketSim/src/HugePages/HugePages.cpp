@@ -0,0 +1,114 @@
+#include "HugePages.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+RS_NS_START
+
+void* HugePages::Alloc(size_t size, HugePageMode mode, HugePageMode* outMode) {
+	assert(mode != HugePageMode::NONE);
+	size = RoundSize(RS_MAX(size, (size_t)1));
+
+#ifdef _WIN32
+	// Large pages need the "Lock pages in memory" privilege, without it we just get regular pages
+	if (mode == HugePageMode::RESERVED && GetLargePageMinimum() > 0) {
+		void* result = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (result) {
+			if (outMode)
+				*outMode = HugePageMode::RESERVED;
+			return result;
+		}
+	}
+
+	if (outMode)
+		*outMode = HugePageMode::NONE;
+	return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+
+#ifdef MAP_HUGETLB
+	if (mode == HugePageMode::RESERVED) {
+		// Fails if the pool doesn't have enough free pages
+		void* result = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (result != MAP_FAILED) {
+			if (outMode)
+				*outMode = HugePageMode::RESERVED;
+			return result;
+		}
+	}
+#endif
+
+	// Transparent huge pages can only be used for 2MB-aligned ranges, so we map an extra page and cut off what's around the aligned part
+	uint8_t* map = (uint8_t*)mmap(NULL, size + PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	uint8_t* result = (uint8_t*)(((uintptr_t)map + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE);
+	size_t headSize = result - map, tailSize = PAGE_SIZE - headSize;
+	if (headSize > 0)
+		munmap(map, headSize);
+	if (tailSize > 0)
+		munmap(result + size, tailSize);
+
+#ifdef MADV_HUGEPAGE
+	// Only a hint, this can fail if transparent huge pages are disabled
+	madvise(result, size, MADV_HUGEPAGE);
+	if (outMode)
+		*outMode = HugePageMode::MADVISE;
+#else
+	if (outMode)
+		*outMode = HugePageMode::NONE;
+#endif
+
+	return result;
+#endif
+}
+
+void HugePages::Free(void* ptr, size_t size) {
+	if (!ptr)
+		return;
+
+#ifdef _WIN32
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+	munmap(ptr, RoundSize(RS_MAX(size, (size_t)1)));
+#endif
+}
+
+int64_t HugePages::GetProcessHugeBytes() {
+#ifdef __linux__
+	std::ifstream fIn("/proc/self/smaps_rollup");
+	if (!fIn.good())
+		return 0;
+
+	int64_t totalKB = 0;
+	std::string line;
+	while (std::getline(fIn, line)) {
+		for (const char* field : { "AnonHugePages:", "Shared_Hugetlb:", "Private_Hugetlb:" }) {
+			size_t len = strlen(field);
+			if (line.compare(0, len, field) == 0)
+				totalKB += std::stoll(line.substr(len));
+		}
+	}
+	return totalKB * 1024;
+#else
+	return 0;
+#endif
+}
+
+const char* HugePages::GetModeName(HugePageMode mode) {
+	switch (mode) {
+	case HugePageMode::MADVISE:
+		return "madvise";
+	case HugePageMode::RESERVED:
+		return "reserved";
+	default:
+		return "none";
+	}
+}
+
+RS_NS_END
@@ -0,0 +1,37 @@
+#pragma once
+#include "../Framework.h"
+
+RS_NS_START
+
+// How large blocks of memory should be backed by huge (2MB) pages, to cut down on TLB misses when accessed all over
+enum class HugePageMode : uint8_t {
+	NONE,		// Regular pages, allocated the usual way
+	MADVISE,	// Ask for transparent huge pages (Linux only), the kernel may still use regular pages
+	RESERVED,	// Use pages from the reserved huge page pool (hugetlbfs on Linux, large pages on Windows), falls back to MADVISE if there aren't enough
+};
+
+// Allocation of memory blocks with huge pages
+// Blocks are page-aligned and zeroed, and their size is rounded up to a whole amount of huge pages
+namespace HugePages {
+	constexpr size_t PAGE_SIZE = 2 * 1024 * 1024;
+
+	inline size_t RoundSize(size_t size) {
+		return (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+	}
+
+	// Returns NULL if the memory can't be allocated
+	// mode must not be NONE
+	// outMode is set to the mode that was actually used (i.e. MADVISE if RESERVED fell back to it), and can be NULL
+	void* Alloc(size_t size, HugePageMode mode, HugePageMode* outMode = NULL);
+
+	// size must be the same size the block was allocated with
+	void Free(void* ptr, size_t size);
+
+	// Bytes of this process's memory that are currently in huge pages, both transparent and reserved
+	// Returns 0 if unknown
+	int64_t GetProcessHugeBytes();
+
+	const char* GetModeName(HugePageMode mode);
+}
+
+RS_NS_END
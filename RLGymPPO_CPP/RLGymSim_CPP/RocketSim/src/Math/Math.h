@@ -3,10 +3,62 @@
 
 RS_NS_START
 
+// Piecewise linear mapping of inputs to outputs, clamped to the outputs of the first and last points
+// Points are kept in a flat sorted array, so finding the segment of an input is a branch-free count instead of walking a tree
 struct LinearPieceCurve {
-	std::map<float, float> valueMappings;
+	constexpr static int MAX_POINTS = 8;
 
-	RSAPI float GetOutput(float input, float defaultOutput = 1) const;
+	struct Point {
+		float input, output;
+	};
+
+	Point points[MAX_POINTS] = {};
+	int numPoints = 0;
+
+	constexpr LinearPieceCurve() = default;
+
+	// Points can be in any order, and only the first of points with the same input is kept
+	constexpr LinearPieceCurve(std::initializer_list<Point> pointList) {
+		for (const Point& point : pointList) {
+			int index = 0;
+			while (index < numPoints && points[index].input < point.input)
+				index++;
+
+			if (index < numPoints && points[index].input == point.input)
+				continue;
+
+			if (numPoints == MAX_POINTS)
+				throw std::length_error("LinearPieceCurve: Too many points");
+
+			for (int i = numPoints; i > index; i--)
+				points[i] = points[i - 1];
+			points[index] = point;
+			numPoints++;
+		}
+	}
+
+	constexpr float GetOutput(float input, float defaultOutput = 1) const {
+		if (numPoints == 0)
+			return defaultOutput;
+
+		if (input <= points[0].input)
+			return points[0].output;
+
+		// Index of the first point past the input, or numPoints if there is none (also if the input is NaN)
+		int index = numPoints;
+		for (int i = 1; i < MAX_POINTS; i++)
+			index -= (i < numPoints) & (points[i].input > input);
+
+		if (index == numPoints)
+			return points[numPoints - 1].output;
+
+		const Point& before = points[index - 1];
+		const Point& after = points[index];
+		float rangeBetween = after.input - before.input;
+		float valDiffBetween = after.output - before.output;
+		float linearInterpFactor = (input - before.input) / rangeBetween;
+		return before.output + valDiffBetween * linearInterpFactor;
+	}
 };
 
 namespace Math {
@@ -4,58 +4,15 @@
 
 RS_NS_START
 
-#define VEC_OP_VEC(op) \
-Vec Vec::operator op(const Vec& other) const { return Vec(x op other.x, y op other.y, z op other.z, _w op other._w); } \
-Vec& Vec::operator op##=(const Vec& other) { return *this = *this op other; }
+// Vec and RotMat ops are inline in MathTypes.h
 
 #define VEC_OP_FLT(op) \
-Vec Vec::operator op(float val) const { return Vec(x op val, y op val, z op val, _w op val); } \
-Vec operator op(float val, const Vec& vec) { return Vec(val op vec.x, val op vec.y, val op vec.z, val op vec._w); } \
-Vec& Vec::operator op##=(float val) { return *this = *this op val; }
-
-VEC_OP_VEC(+)
-VEC_OP_VEC(-)
-VEC_OP_VEC(*)
-VEC_OP_VEC(/)
+Vec operator op(float val, const Vec& vec) { return Vec(val op vec.x, val op vec.y, val op vec.z, val op vec._w); }
 
 VEC_OP_FLT(*)
 VEC_OP_FLT(/)
 
-////////////////////////////////////
-
-#define MAT_OP_EACH_MAT(op) \
-RotMat RotMat::operator op(const RotMat& other) const { \
-	RotMat result; \
-	for (int i = 0; i < 3; i++) \
-		for (int j = 0; j < 4; j++) \
-			result[i][j] = (*this)[i][j] op other[i][j]; \
-	return result; \
-} \
-RotMat& RotMat::operator op##=(const RotMat& other) { \
-	return *this = *this op other; \
-}
-
-MAT_OP_EACH_MAT(+)
-MAT_OP_EACH_MAT(-)
-
-#undef MAT_OP_EACH_MAT
-
-#define MAT_OP_EACH_FLT(op) \
-RotMat RotMat::operator op(float val) const { \
-	RotMat result; \
-	for (int i = 0; i < 3; i++) \
-		for (int j = 0; j < 4; j++) \
-			result[i][j] = (*this)[i][j] op val; \
-	return result; \
-} \
-RotMat& RotMat::operator op##=(float val) { \
-	return *this = *this op val; \
-}
-
-MAT_OP_EACH_FLT(*)
-MAT_OP_EACH_FLT(/)
-
-#undef MAT_OP_EACH_FLT
+#undef VEC_OP_FLT
 
 //////////////////////////////////////
 
@@ -3,6 +3,37 @@
 
 RS_NS_START
 
+// Component-wise ops of Vec run on all 4 floats at once, with the SIMD type Bullet uses (see btScalar.h)
+// Each lane computes exactly what the scalar op would, so results don't depend on which is used
+#if defined(BT_USE_SSE)
+#define RS_VEC_SIMD_SSE
+#elif defined(BT_USE_NEON)
+#define RS_VEC_SIMD_NEON
+#endif
+
+#if defined(RS_VEC_SIMD_SSE)
+#define RS_VEC_OP_VEC(op, sseFunc, neonFunc) \
+	Vec operator op(const Vec& other) const { return FromSIMD(sseFunc(ToSIMD(), other.ToSIMD())); } \
+	Vec& operator op##=(const Vec& other) { return *this = *this op other; }
+#define RS_VEC_OP_FLT(op, sseFunc, neonFunc) \
+	Vec operator op(float val) const { return FromSIMD(sseFunc(ToSIMD(), _mm_set1_ps(val))); } \
+	Vec& operator op##=(float val) { return *this = *this op val; }
+#elif defined(RS_VEC_SIMD_NEON)
+#define RS_VEC_OP_VEC(op, sseFunc, neonFunc) \
+	Vec operator op(const Vec& other) const { return FromSIMD(neonFunc(ToSIMD(), other.ToSIMD())); } \
+	Vec& operator op##=(const Vec& other) { return *this = *this op other; }
+#define RS_VEC_OP_FLT(op, sseFunc, neonFunc) \
+	Vec operator op(float val) const { return FromSIMD(neonFunc(ToSIMD(), vdupq_n_f32(val))); } \
+	Vec& operator op##=(float val) { return *this = *this op val; }
+#else
+#define RS_VEC_OP_VEC(op, sseFunc, neonFunc) \
+	Vec operator op(const Vec& other) const { return Vec(x op other.x, y op other.y, z op other.z, _w op other._w); } \
+	Vec& operator op##=(const Vec& other) { return *this = *this op other; }
+#define RS_VEC_OP_FLT(op, sseFunc, neonFunc) \
+	Vec operator op(float val) const { return Vec(x op val, y op val, z op val, _w op val); } \
+	Vec& operator op##=(float val) { return *this = *this op val; }
+#endif
+
 // RocketSim 3D vector struct
 struct RS_ALIGN_16 Vec {
 	float x, y, z;
@@ -15,9 +46,9 @@ struct RS_ALIGN_16 Vec {
 
 	constexpr Vec(float x, float y, float z, float _w = 0) : x(x), y(y), z(z), _w(_w) {}
 
-	Vec(const btVector3& bulletVec) {
-		*(btVector3*)this = bulletVec;
-	}
+	// Copied per component rather than with a pointer cast, as our inline ops would otherwise be reordered around it (strict aliasing)
+	Vec(const btVector3& bulletVec) :
+		x(bulletVec.m_floats[0]), y(bulletVec.m_floats[1]), z(bulletVec.m_floats[2]), _w(bulletVec.m_floats[3]) {}
 
 	bool IsZero() const {
 		return (x == 0 && y == 0 && z == 0 && _w == 0);
@@ -105,24 +136,29 @@ struct RS_ALIGN_16 Vec {
 	}
 
 	operator btVector3() const {
-		return *(btVector3*)(this);
+		btVector3 result;
+		result.m_floats[0] = x;
+		result.m_floats[1] = y;
+		result.m_floats[2] = z;
+		result.m_floats[3] = _w;
+		return result;
 	}
 
-	RSAPI Vec operator+(const Vec& other) const;
-	RSAPI Vec operator-(const Vec& other) const;
-	RSAPI Vec operator*(const Vec& other) const;
-	RSAPI Vec operator/(const Vec& other) const;
-
-	RSAPI Vec& operator+=(const Vec& other);
-	RSAPI Vec& operator-=(const Vec& other);
-	RSAPI Vec& operator*=(const Vec& other);
-	RSAPI Vec& operator/=(const Vec& other);
+#if defined(RS_VEC_SIMD_SSE)
+	__m128 ToSIMD() const { return _mm_load_ps(&x); }
+	static Vec FromSIMD(__m128 v) { Vec result; _mm_store_ps(&result.x, v); return result; }
+#elif defined(RS_VEC_SIMD_NEON)
+	float32x4_t ToSIMD() const { return vld1q_f32(&x); }
+	static Vec FromSIMD(float32x4_t v) { Vec result; vst1q_f32(&result.x, v); return result; }
+#endif
 
-	RSAPI Vec operator*(float val) const;
-	RSAPI Vec operator/(float val) const;
+	RS_VEC_OP_VEC(+, _mm_add_ps, vaddq_f32)
+	RS_VEC_OP_VEC(-, _mm_sub_ps, vsubq_f32)
+	RS_VEC_OP_VEC(*, _mm_mul_ps, vmulq_f32)
+	RS_VEC_OP_VEC(/, _mm_div_ps, vdivq_f32)
 
-	RSAPI Vec& operator*=(float val);
-	RSAPI Vec& operator/=(float val);
+	RS_VEC_OP_FLT(*, _mm_mul_ps, vmulq_f32)
+	RS_VEC_OP_FLT(/, _mm_div_ps, vdivq_f32)
 
 	bool operator<(const Vec& other) const {
 		return (x < other.x) && (y < other.y) && (z < other.z);
@@ -154,8 +190,12 @@ struct RS_ALIGN_16 Vec {
 	}
 };
 
+#undef RS_VEC_OP_VEC
+#undef RS_VEC_OP_FLT
+
 // Vec needs to be equal in both size and structure layout to btVector3, because they are type-punned to and from
 static_assert(sizeof(Vec) == sizeof(btVector3), "RocketSim Vec size must match btVector3 size");
+static_assert(alignof(Vec) == 16, "RocketSim Vec must be 16-byte aligned, its SIMD ops use aligned loads");
 
 // RocketSim 3x3 rotation matrix struct
 // NOTE: Column-major
@@ -169,12 +209,8 @@ struct RS_ALIGN_16 RotMat {
 	RotMat(Vec forward, Vec right, Vec up) : forward(forward), right(right), up(up) {}
 
 	RotMat(const btMatrix3x3& bulletMat) {
-		for (int i = 0; i < 3; i++) {
-			for (int j = 0; j < 3; j++) {
-				// NOTE: btMatrix3x3 is row-major, whereas we are column-major
-				(*this)[i][j] = bulletMat[j][i];
-			}
-		}
+		// NOTE: btMatrix3x3 is row-major, whereas we are column-major
+		*this = _Transposed(bulletMat[0], bulletMat[1], bulletMat[2]);
 	}
 
 	static RotMat GetIdentity() {
@@ -207,27 +243,25 @@ struct RS_ALIGN_16 RotMat {
 	}
 
 	operator btMatrix3x3() const {
+		// NOTE: btMatrix3x3 is row-major, whereas we are column-major
+		RotMat rows = Transpose();
 		btMatrix3x3 result;
-		for (int i = 0; i < 3; i++) {
-			for (int j = 0; j < 3; j++) {
-				// NOTE: btMatrix3x3 is row-major, whereas we are column-major
-				result[i][j] = (*this)[j][i];
-			}
-		}
+		for (int i = 0; i < 3; i++)
+			result[i] = rows[i];
 		return result;
 	}
 
-	RSAPI RotMat operator+(const RotMat& other) const;
-	RSAPI RotMat operator-(const RotMat& other) const;
+	RotMat operator+(const RotMat& other) const { return RotMat(forward + other.forward, right + other.right, up + other.up); }
+	RotMat operator-(const RotMat& other) const { return RotMat(forward - other.forward, right - other.right, up - other.up); }
 
-	RSAPI RotMat& operator+=(const RotMat& other);
-	RSAPI RotMat& operator-=(const RotMat& other);
+	RotMat& operator+=(const RotMat& other) { return *this = *this + other; }
+	RotMat& operator-=(const RotMat& other) { return *this = *this - other; }
 
-	RSAPI RotMat operator*(float val) const;
-	RSAPI RotMat operator/(float val) const;
+	RotMat operator*(float val) const { return RotMat(forward * val, right * val, up * val); }
+	RotMat operator/(float val) const { return RotMat(forward / val, right / val, up / val); }
 
-	RSAPI RotMat& operator*=(float val);
-	RSAPI RotMat& operator/=(float val);
+	RotMat& operator*=(float val) { return *this = *this * val; }
+	RotMat& operator/=(float val) { return *this = *this / val; }
 
 	bool operator==(const RotMat& other) const {
 		return
@@ -260,11 +294,22 @@ struct RS_ALIGN_16 RotMat {
 	}
 
 	RotMat Transpose() const {
-		RotMat result;
-		for (int i = 0; i < 3; i++)
-			for (int j = 0; j < 3; j++)
-				result[i][j] = (*this)[j][i];
-		return result;
+		return _Transposed(forward, right, up);
+	}
+
+	// Matrix whose vectors are the components of a, b, and c, with zeroed 4th components
+	static RotMat _Transposed(const Vec& a, const Vec& b, const Vec& c) {
+#if defined(RS_VEC_SIMD_SSE)
+		__m128 r0 = a.ToSIMD(), r1 = b.ToSIMD(), r2 = c.ToSIMD(), r3 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		return RotMat(Vec::FromSIMD(r0), Vec::FromSIMD(r1), Vec::FromSIMD(r2));
+#else
+		return RotMat(
+			Vec(a.x, b.x, c.x),
+			Vec(a.y, b.y, c.y),
+			Vec(a.z, b.z, c.z)
+		);
+#endif
 	}
 
 	friend std::ostream& operator<<(std::ostream& stream, const RotMat& mat) {
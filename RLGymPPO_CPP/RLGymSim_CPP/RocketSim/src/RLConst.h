@@ -327,7 +327,7 @@ namespace RLConst {
 
 	// Input: Forward car speed
 	// Output: Max steering angle (radians)
-	const static LinearPieceCurve STEER_ANGLE_FROM_SPEED_CURVE = {
+	constexpr static LinearPieceCurve STEER_ANGLE_FROM_SPEED_CURVE = {
 		{
 			{0,		0.53356f},
 			{500,	0.31930f},
@@ -340,7 +340,7 @@ namespace RLConst {
 
 	// Input: Forward car speed 
 	// Output: Extended steering angle (radians)
-	const static LinearPieceCurve POWERSLIDE_STEER_ANGLE_FROM_SPEED_CURVE = {
+	constexpr static LinearPieceCurve POWERSLIDE_STEER_ANGLE_FROM_SPEED_CURVE = {
 		{
 			{0,		0.39235f},
 			{2500,	0.12610f},
@@ -349,7 +349,7 @@ namespace RLConst {
 
 	// Input: Forward car speed 
 	// Output: Torque factor
-	const static LinearPieceCurve DRIVE_SPEED_TORQUE_FACTOR_CURVE = {
+	constexpr static LinearPieceCurve DRIVE_SPEED_TORQUE_FACTOR_CURVE = {
 		{
 			{0,		1.0f},
 			{1400,	0.1f},
@@ -357,7 +357,7 @@ namespace RLConst {
 		}
 	};
 
-	const static LinearPieceCurve NON_STICKY_FRICTION_FACTOR_CURVE = {
+	constexpr static LinearPieceCurve NON_STICKY_FRICTION_FACTOR_CURVE = {
 		{
 			{0,			0.1f},
 			{0.7075f,	0.5f},
@@ -365,33 +365,33 @@ namespace RLConst {
 		}
 	};
 
-	const static LinearPieceCurve LAT_FRICTION_CURVE = {
+	constexpr static LinearPieceCurve LAT_FRICTION_CURVE = {
 		{
 			{0,	1.0f},
 			{1,	0.2f},
 		}
 	};
 
-	const static LinearPieceCurve LONG_FRICTION_CURVE = {
+	constexpr static LinearPieceCurve LONG_FRICTION_CURVE = {
 		{
 			// Empty curve
 		}
 	};
 
-	const static LinearPieceCurve HANDBRAKE_LAT_FRICTION_FACTOR_CURVE = {
+	constexpr static LinearPieceCurve HANDBRAKE_LAT_FRICTION_FACTOR_CURVE = {
 		{
 			{0,	0.1f},
 		}
 	};
 
-	const static LinearPieceCurve HANDBRAKE_LONG_FRICTION_FACTOR_CURVE = {
+	constexpr static LinearPieceCurve HANDBRAKE_LONG_FRICTION_FACTOR_CURVE = {
 		{
 			{0,	0.5f},
 			{1,	0.9f}
 		}
 	};
 
-	const static LinearPieceCurve BALL_CAR_EXTRA_IMPULSE_FACTOR_CURVE = {
+	constexpr static LinearPieceCurve BALL_CAR_EXTRA_IMPULSE_FACTOR_CURVE = {
 		{
 			{     0, 0.65f},
 			{ 500.f, 0.65f},
@@ -400,7 +400,7 @@ namespace RLConst {
 		}
 	};
 
-	const static LinearPieceCurve BUMP_VEL_AMOUNT_GROUND_CURVE = {
+	constexpr static LinearPieceCurve BUMP_VEL_AMOUNT_GROUND_CURVE = {
 		{
 			{0.f, (5.f / 6.f)},
 			{1400.f, 1100.f},
@@ -408,7 +408,7 @@ namespace RLConst {
 		}
 	};
 
-	const static LinearPieceCurve BUMP_VEL_AMOUNT_AIR_CURVE = {
+	constexpr static LinearPieceCurve BUMP_VEL_AMOUNT_AIR_CURVE = {
 		{
 			{0.f, (5.f / 6.f)},
 			{1400.f, 1390.f},
@@ -416,7 +416,7 @@ namespace RLConst {
 		}
 	};
 
-	const static LinearPieceCurve BUMP_UPWARD_VEL_AMOUNT_CURVE = {
+	constexpr static LinearPieceCurve BUMP_UPWARD_VEL_AMOUNT_CURVE = {
 		{
 			{0.f, (2.f / 6.f)},
 			{1400.f, 278.f},
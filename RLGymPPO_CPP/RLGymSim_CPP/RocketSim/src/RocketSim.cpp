@@ -1,8 +1,12 @@
 #include "RocketSim.h"
 
 #include "../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
-#include "../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btTriangleMesh.h"
 #include "../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btInternalEdgeUtility.h"
+#include "../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btOptimizedBvh.h"
+
+#include "Sim/Arena/ArenaSlab/ArenaSlab.h"
+
+#include <atomic>
 
 using namespace RocketSim;
 
@@ -47,27 +51,337 @@ RocketSimStage RocketSim::GetStage() {
 	return stage;
 }
 
-std::vector<btBvhTriangleMeshShape*>& RocketSim::GetArenaCollisionShapes(GameMode gameMode) {
-	static std::vector<btBvhTriangleMeshShape*> arenaCollisionMeshes;
-	static std::vector<btBvhTriangleMeshShape*> arenaCollisionMeshes_hoops;
+// Arena collision of a game mode, each part is built the first time it's needed
+struct ArenaCollisionData {
+	GameMode gameMode;
+
+	bool meshesLoaded = false;
+	std::vector<btBvhTriangleMeshShape*> meshes;
+	std::vector<uint32_t> meshHashes;
+
+#ifndef RS_NO_SUSPCOLGRID
+	// Heavy, then light
+	// A grid is built once it has world data
+	SuspensionCollisionGrid suspColGrids[2];
+#endif
+
+	std::mutex mutex;
+
+	ArenaCollisionData(GameMode gameMode) : gameMode(gameMode)
+#ifndef RS_NO_SUSPCOLGRID
+		, suspColGrids{ {gameMode, false}, {gameMode, true} }
+#endif
+	{}
+};
+
+static ArenaCollisionData arenaCollisionData[] = { ArenaCollisionData(GameMode::SOCCAR), ArenaCollisionData(GameMode::HOOPS) };
+static ArenaCollisionData& _GetArenaCollisionData(GameMode gameMode) {
+	return arenaCollisionData[gameMode == GameMode::HOOPS];
+}
+
+static bool useArenaCache = true;
+
+// Runs fn(0 ... amount - 1) across threads
+static void _ParallelFor(size_t amount, std::function<void(size_t)> fn) {
+	size_t threadAmount = RS_MIN(amount, (size_t)RS_MAX(std::thread::hardware_concurrency(), 1u));
+	if (threadAmount <= 1) {
+		for (size_t i = 0; i < amount; i++)
+			fn(i);
+		return;
+	}
+
+	std::atomic<size_t> nextIndex = 0;
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < threadAmount; i++) {
+		threads.emplace_back(
+			[&]() {
+				for (size_t j = nextIndex++; j < amount; j = nextIndex++)
+					fn(j);
+			}
+		);
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+// Cache of each game mode's built arena collision (BVHs, triangle info maps, and any suspension grids built so far)
+// Stored raw, so it is only valid for the exact meshes and build of RocketSim that wrote it
+constexpr char ARENA_CACHE_FILE_NAME[] = "arena_collision_cache.bin";
+constexpr uint32_t ARENA_CACHE_FORMAT = 1;
+
+static std::filesystem::path _GetArenaCachePath(GameMode gameMode) {
+	return RocketSim::_collisionMeshesFolder / GAMEMODE_STRS[(int)gameMode] / ARENA_CACHE_FILE_NAME;
+}
+
+static std::vector<uint32_t> _GetArenaCacheKey(const std::vector<uint32_t>& meshHashes) {
+	std::vector<uint32_t> key = {
+		ARENA_CACHE_FORMAT,
+		sizeof(btScalar),
+		sizeof(btQuantizedBvhNode), sizeof(btOptimizedBvhNode), sizeof(btBvhSubtreeInfo), sizeof(btTriangleInfo),
+#ifndef RS_NO_SUSPCOLGRID
+		sizeof(SuspensionCollisionGrid::Triangle), sizeof(SuspensionCollisionGrid::TriangleGroup),
+#else
+		0, 0,
+#endif
+		(uint32_t)meshHashes.size()
+	};
 
-	return (gameMode == GameMode::HOOPS ? arenaCollisionMeshes_hoops : arenaCollisionMeshes);
+	// Grids refer to meshes by index, so the order matters
+	key.insert(key.end(), meshHashes.begin(), meshHashes.end());
+	return key;
 }
 
+static void _WriteArenaCache(const ArenaCollisionData& data) {
+	std::filesystem::path cachePath = _GetArenaCachePath(data.gameMode);
+
+	DataStreamOut out = {};
+	for (uint32_t val : _GetArenaCacheKey(data.meshHashes))
+		out.Write<uint32_t>(val);
+
+	for (btBvhTriangleMeshShape* mesh : data.meshes) {
+		btOptimizedBvh* bvh = mesh->getOptimizedBvh();
+		std::vector<byte> bvhData = std::vector<byte>(bvh->calculateSerializeBufferSize());
+		bvh->serialize(bvhData.data());
+		out.Write<uint32_t>(bvhData.size());
+		out.WriteBytes(bvhData.data(), bvhData.size());
+
+		const btTriangleInfoMap* infoMap = mesh->getTriangleInfoMap();
+		out.Write<uint32_t>(infoMap->size());
+		for (int i = 0; i < infoMap->size(); i++) {
+			out.Write<int>(infoMap->getKeyAtIndex(i).getUid1());
+			out.Write<btTriangleInfo>(*infoMap->getAtIndex(i));
+		}
+	}
+
 #ifndef RS_NO_SUSPCOLGRID
-static SuspensionCollisionGrid
-	suspColGrids_soccar[] = { {GameMode::SOCCAR, true}, {GameMode::SOCCAR, false} },
-	suspColGrids_hoops[] = { {GameMode::HOOPS, true}, {GameMode::HOOPS, false} };
-	SuspensionCollisionGrid& RocketSim::GetDefaultSuspColGrid(GameMode gameMode, bool isLight) {
-	if (gameMode == GameMode::HOOPS) {
-		return suspColGrids_hoops[isLight];
-	} else {
-		return suspColGrids_soccar[isLight];
+	for (auto& grid : data.suspColGrids)
+		grid.WriteWorldCollision(out);
+#endif
+
+	// Write to a temporary file first, so other processes never read a partial cache
+	std::filesystem::path tempPath = cachePath;
+	tempPath += RS_STR(".tmp" << std::hex << std::hash<std::thread::id>()(std::this_thread::get_id()) << RS_CUR_MS());
+	try {
+		out.WriteToFile(tempPath, true);
+		std::filesystem::rename(tempPath, cachePath);
+	} catch (std::exception& e) {
+		RS_WARN("Failed to write arena collision cache to " << cachePath << ": " << e.what());
+		std::error_code ec;
+		std::filesystem::remove(tempPath, ec);
 	}
 }
+
+// Returns false if there is no valid cache for these meshes
+static bool _ReadArenaCache(ArenaCollisionData& data, const std::vector<CollisionMeshFile>& meshFiles) {
+	std::filesystem::path cachePath = _GetArenaCachePath(data.gameMode);
+	if (!std::filesystem::exists(cachePath))
+		return false;
+
+	DataStreamIn in;
+	try {
+		in = DataStreamIn(cachePath, false);
+	} catch (std::exception&) {
+		return false;
+	}
+
+	if (!in.DoVersionCheck())
+		return false;
+
+	for (uint32_t val : _GetArenaCacheKey(data.meshHashes))
+		if (in.Read<uint32_t>() != val)
+			return false;
+
+	std::vector<btOptimizedBvh*> bvhs;
+	std::vector<btTriangleInfoMap*> infoMaps;
+	auto fnFail = [&]() {
+		for (btOptimizedBvh* bvh : bvhs) {
+			bvh->~btOptimizedBvh();
+			btAlignedFree(bvh);
+		}
+		for (btTriangleInfoMap* infoMap : infoMaps)
+			delete infoMap;
+		return false;
+	};
+
+	for (size_t i = 0; i < meshFiles.size(); i++) {
+		uint32_t bvhDataSize = in.Read<uint32_t>();
+		if (bvhDataSize > in.GetNumBytesLeft())
+			return fnFail();
+
+		btOptimizedBvh* bvh = new (btAlignedAlloc(sizeof(btOptimizedBvh), 16)) btOptimizedBvh();
+		bvhs.push_back(bvh);
+		if (!bvh->deSerialize(in.GetData() + in.pos, bvhDataSize))
+			return fnFail();
+		in.pos += bvhDataSize;
+
+		btTriangleInfoMap* infoMap = new btTriangleInfoMap();
+		infoMaps.push_back(infoMap);
+		uint32_t infoAmount = in.Read<uint32_t>();
+		if (infoAmount > in.GetNumBytesLeft() / (sizeof(int) + sizeof(btTriangleInfo)))
+			return fnFail();
+
+		for (uint32_t j = 0; j < infoAmount; j++) {
+			int key = in.Read<int>();
+			infoMap->insert(key, in.Read<btTriangleInfo>());
+		}
+	}
+
+#ifndef RS_NO_SUSPCOLGRID
+	SuspensionCollisionGrid grids[2] = { data.suspColGrids[0], data.suspColGrids[1] };
+	for (auto& grid : grids) {
+		grid.Allocate();
+		if (!grid.ReadWorldCollision(in))
+			return fnFail();
+	}
 #endif
 
-void RocketSim::Init(std::filesystem::path collisionMeshesFolder) {
+	if (in.IsOverflown() || !in.IsDone())
+		return fnFail();
+
+	for (size_t i = 0; i < meshFiles.size(); i++) {
+		// NOTE: The mesh doesn't own the BVH, but arena meshes are never freed anyway
+		auto bvtMesh = new btBvhTriangleMeshShape(meshFiles[i].MakeBulletMesh(), true, false);
+		bvtMesh->setOptimizedBvh(bvhs[i]);
+		bvtMesh->setTriangleInfoMap(infoMaps[i]);
+		data.meshes.push_back(bvtMesh);
+	}
+
+#ifndef RS_NO_SUSPCOLGRID
+	for (int i = 0; i < 2; i++)
+		data.suspColGrids[i] = grids[i];
+#endif
+
+	return true;
+}
+
+// Raw cache data is little-endian only
+static bool _IsArenaCacheUsable() {
+	return useArenaCache && !RS_IS_BIG_ENDIAN;
+}
+
+static void _LoadArenaMeshes(ArenaCollisionData& data) {
+	constexpr char MSG_PREFIX[] = "RocketSim::_LoadArenaMeshes(): ";
+
+	GameMode gameMode = data.gameMode;
+	data.meshesLoaded = true;
+
+	std::filesystem::path soccarMeshesFolder = RocketSim::_collisionMeshesFolder / GAMEMODE_STRS[(int)gameMode];
+
+	RS_LOG("Loading arena meshes from " << soccarMeshesFolder << "...");
+
+	if (!std::filesystem::exists(soccarMeshesFolder)) {
+		RS_LOG("No arena meshes for " << GAMEMODE_STRS[(int)gameMode] << ", skipping...");
+		return;
+	}
+
+	MeshHashSet targetHashes = MeshHashSet(gameMode);
+
+	// Load collision meshes
+	std::vector<CollisionMeshFile> meshFiles;
+	auto dirItr = std::filesystem::directory_iterator(soccarMeshesFolder);
+	for (auto& entry : dirItr) {
+		auto entryPath = entry.path();
+		if (!entryPath.has_extension() || entryPath.extension() != COLLISION_MESH_FILE_EXTENSION)
+			continue;
+
+		CollisionMeshFile meshFile = {};
+		meshFile.ReadFromFile(entryPath.string());
+		int& hashCount = targetHashes[meshFile.hash];
+
+		if (hashCount > 0) {
+			RS_WARN(MSG_PREFIX << "Collision mesh " << entryPath << " is a duplicate (0x" << std::hex << meshFile.hash << "), " <<
+				"already loaded a mesh with the same hash."
+			);
+		} else if (targetHashes.hashes.count(meshFile.hash) == 0) {
+			RS_WARN(MSG_PREFIX <<
+				"Collision mesh " << entryPath << " does not match any known soccar collision file (0x" << std::hex << meshFile.hash << "), " <<
+				"make sure they were dumped from a normal soccar arena."
+			)
+		}
+		hashCount++;
+
+		data.meshHashes.push_back(meshFile.hash);
+		meshFiles.push_back(std::move(meshFile));
+	}
+
+	if (_IsArenaCacheUsable() && _ReadArenaCache(data, meshFiles)) {
+		RS_LOG("Loaded built arena collision from cache " << _GetArenaCachePath(gameMode));
+		return;
+	}
+
+	// Meshes don't depend on each other, so build them all at once
+	data.meshes.resize(meshFiles.size());
+	_ParallelFor(meshFiles.size(),
+		[&](size_t i) {
+			btStridingMeshInterface* triMesh = meshFiles[i].MakeBulletMesh();
+
+			auto bvtMesh = new btBvhTriangleMeshShape(triMesh, true);
+			btTriangleInfoMap* infoMap = new btTriangleInfoMap();
+			btGenerateInternalEdgeInfo(bvtMesh, infoMap);
+			bvtMesh->setTriangleInfoMap(infoMap);
+			data.meshes[i] = bvtMesh;
+		}
+	);
+
+	if (_IsArenaCacheUsable() && !data.meshes.empty())
+		_WriteArenaCache(data);
+}
+
+#ifndef RS_NO_SUSPCOLGRID
+static void _BuildSuspColGrids(ArenaCollisionData& data, const bool buildGrids[2]) {
+	std::vector<SuspensionCollisionGrid*> gridsToBuild;
+	for (int i = 0; i < 2; i++)
+		if (buildGrids[i] && !data.suspColGrids[i].worldData)
+			gridsToBuild.push_back(&data.suspColGrids[i]);
+
+	if (gridsToBuild.empty() || data.meshes.empty())
+		return;
+
+	RS_LOG("Building collision suspension grids from " << GAMEMODE_STRS[(int)data.gameMode] << " arena meshes...");
+	_ParallelFor(gridsToBuild.size(),
+		[&](size_t i) {
+			gridsToBuild[i]->Allocate();
+			gridsToBuild[i]->SetupWorldCollision(data.meshes);
+		}
+	);
+
+	if (_IsArenaCacheUsable())
+		_WriteArenaCache(data);
+}
+#endif
+
+// Builds whatever isn't built yet
+static ArenaCollisionData& _GetBuiltArenaCollision(GameMode gameMode, const bool buildSuspColGrids[2]) {
+	auto& data = _GetArenaCollisionData(gameMode);
+	std::lock_guard<std::mutex> lock = std::lock_guard<std::mutex>(data.mutex);
+
+	// Shared by every arena, so never placed in the slab of the arena that happens to build it
+	ArenaSlab::Scope slabScope = ArenaSlab::Scope(NULL);
+
+	if (!data.meshesLoaded)
+		_LoadArenaMeshes(data);
+
+#ifndef RS_NO_SUSPCOLGRID
+	_BuildSuspColGrids(data, buildSuspColGrids);
+#endif
+
+	return data;
+}
+
+std::vector<btBvhTriangleMeshShape*>& RocketSim::GetArenaCollisionShapes(GameMode gameMode) {
+	constexpr bool BUILD_SUSPCOLGRIDS[2] = { false, false };
+	return _GetBuiltArenaCollision(gameMode, BUILD_SUSPCOLGRIDS).meshes;
+}
+
+#ifndef RS_NO_SUSPCOLGRID
+SuspensionCollisionGrid& RocketSim::GetDefaultSuspColGrid(GameMode gameMode, bool isLight) {
+	bool buildSuspColGrids[2] = { !isLight, isLight };
+	return _GetBuiltArenaCollision(gameMode, buildSuspColGrids).suspColGrids[isLight];
+}
+#endif
+
+void RocketSim::Init(std::filesystem::path collisionMeshesFolder, bool useCache, const InitModes& modes) {
 
 	constexpr char MSG_PREFIX[] = "RocketSim::Init(): ";
 
@@ -81,81 +395,29 @@ void RocketSim::Init(std::filesystem::path collisionMeshesFolder) {
 
 		RS_LOG("Initializing RocketSim version " RS_VERSION ", created by ZealanL...");
 
+		// Before anything is allocated through Bullet, as our allocator can only free its own allocations
+		ArenaSlab::_InstallBulletAllocator();
+
 		_collisionMeshesFolder = collisionMeshesFolder;
+		useArenaCache = useCache;
 		stage = RocketSimStage::INITIALIZING;
 
 		uint64_t startMS = RS_CUR_MS();
 
-		for (int i = 0; i < 2; i++) { // Load collision meshes for soccar and hoops
-			GameMode gameMode = (i > 0) ? GameMode::HOOPS : GameMode::SOCCAR;
-			auto& meshes = GetArenaCollisionShapes(gameMode);
-
-			std::filesystem::path basePath = collisionMeshesFolder;
-			std::filesystem::path soccarMeshesFolder = basePath / GAMEMODE_STRS[(int)gameMode];
-
-			RS_LOG("Loading arena meshes from " << soccarMeshesFolder << "...");
+		bool buildSuspColGrids[2] = {};
+		for (ArenaMemWeightMode memWeightMode : modes.memWeightModes)
+			buildSuspColGrids[IsLightMemWeightMode(memWeightMode)] = true;
 
-			if (!std::filesystem::exists(soccarMeshesFolder)) {
-				RS_LOG("No arena meshes for " << GAMEMODE_STRS[(int)gameMode] << ", skipping...");
+		for (GameMode gameMode : modes.gameModes) {
+			if (gameMode == GameMode::THE_VOID)
 				continue;
-			}
 
-			MeshHashSet targetHashes = MeshHashSet(gameMode);
-
-			// Load collision meshes
-			auto dirItr = std::filesystem::directory_iterator(soccarMeshesFolder);
-			for (auto& entry : dirItr) {
-				auto entryPath = entry.path();
-				if (entryPath.has_extension() && entryPath.extension() == COLLISION_MESH_FILE_EXTENSION) {
-					CollisionMeshFile meshFile = {};
-					meshFile.ReadFromFile(entryPath.string());
-					int& hashCount = targetHashes[meshFile.hash];
-
-					if (hashCount > 0) {
-						RS_WARN(MSG_PREFIX << "Collision mesh " << entryPath << " is a duplicate (0x" << std::hex << meshFile.hash << "), " <<
-							"already loaded a mesh with the same hash."
-						);
-					} else if (targetHashes.hashes.count(meshFile.hash) == 0) {
-						RS_WARN(MSG_PREFIX <<
-							"Collision mesh " << entryPath << " does not match any known soccar collision file (0x" << std::hex << meshFile.hash << "), " <<
-							"make sure they were dumped from a normal soccar arena."
-						)
-					}
-					hashCount++;
-
-					btTriangleMesh* triMesh = meshFile.MakeBulletMesh();
-
-					auto bvtMesh = new btBvhTriangleMeshShape(triMesh, true);
-					btTriangleInfoMap* infoMap = new btTriangleInfoMap();
-					btGenerateInternalEdgeInfo(bvtMesh, infoMap);
-					bvtMesh->setTriangleInfoMap(infoMap);
-					meshes.push_back(bvtMesh);
-				}
-			}
+			_GetBuiltArenaCollision(gameMode, buildSuspColGrids);
 		}
 
 		RS_LOG(MSG_PREFIX << "Finished loading arena collision meshes:");
-		RS_LOG(" > Soccar: " << GetArenaCollisionShapes(GameMode::SOCCAR).size());
-		RS_LOG(" > Hoops: " << GetArenaCollisionShapes(GameMode::HOOPS).size());
-
-#ifndef RS_NO_SUSPCOLGRID
-		{ // Set up suspension collision grid
-			for (int i = 0; i < 2; i++) {
-				GameMode gameMode = i > 0 ? GameMode::HOOPS : GameMode::SOCCAR;
-				auto& meshes = GetArenaCollisionShapes(gameMode);
-
-				if (!meshes.empty()) {
-					RS_LOG("Building collision suspension grids from " << GAMEMODE_STRS[(int)gameMode] << " arena meshes...");
-
-					for (int j = 0; j < 2; j++) {
-						auto& grid = GetDefaultSuspColGrid(gameMode, j);
-						grid.Allocate();
-						grid.SetupWorldCollision(meshes);
-					}
-				}
-			}
-		}
-#endif
+		RS_LOG(" > Soccar: " << _GetArenaCollisionData(GameMode::SOCCAR).meshes.size());
+		RS_LOG(" > Hoops: " << _GetArenaCollisionData(GameMode::HOOPS).meshes.size());
 
 		uint64_t elapsedMS = RS_CUR_MS() - startMS;
 		RS_LOG("Finished initializing RocketSim in " << (elapsedMS / 1000.f) << "s!");
@@ -23,7 +23,21 @@ namespace RocketSim {
 	extern std::filesystem::path _collisionMeshesFolder;
 	extern std::mutex _beginInitMutex;
 
-	void Init(std::filesystem::path collisionMeshesFolder);
+	// Game modes and memory weight modes to build arena collision for during RocketSim::Init()
+	// Anything else is built the first time an arena needs it
+	struct InitModes {
+		std::vector<GameMode> gameModes = { GameMode::SOCCAR, GameMode::HOOPS };
+		std::vector<ArenaMemWeightMode> memWeightModes = { ArenaMemWeightMode::HEAVY, ArenaMemWeightMode::LIGHT };
+
+		// Build nothing until arenas need it
+		static InitModes Lazy() {
+			return { {}, {} };
+		}
+	};
+
+	// The built arena collision is cached in the collision meshes folder, so later inits can skip building it
+	// If useCache is false, the cache is neither read nor written
+	void Init(std::filesystem::path collisionMeshesFolder, bool useCache = true, const InitModes& modes = {});
 	void AssertInitialized(const char* errorMsgPrefix);
 
 	RocketSimStage GetStage();
@@ -0,0 +1,40 @@
+#pragma once
+#include "../../../BaseInc.h"
+
+RS_NS_START
+
+// Settings for Arena::StepAdaptive()
+// Ticks where nothing can start or stop touching anything are combined into larger substeps, which is approximate
+// An arena is only "quiet" when every car is driving on the flat floor, and every car, the ball and the walls are far enough apart
+//	that no contact, suspension change, jump or goal can happen during the substep
+struct AdaptiveStepConfig {
+	// Largest amount of ticks that can be combined into one substep
+	// Larger substeps are faster, but drift further from full-rate stepping
+	int maxSubstepTicks = 2;
+
+	// Gap (in UU) that must stay between any two objects, and between objects and the walls/ceiling, for the whole substep
+	// This is on top of how far the objects can move during it
+	float minGap = 60;
+
+	// Cars with a vertical speed above this (in UU/s) are still settling on their suspension, so they aren't quiet
+	float maxCarVelZ = 50;
+
+	// The ball is only quiet on the floor if its vertical speed is below this (in UU/s), so it is rolling instead of bouncing
+	float maxRollingBallVelZ = 20;
+};
+
+// How much of an arena's stepping was done with larger substeps by Arena::StepAdaptive()
+// Never resets on its own, reset it by assigning {}
+struct AdaptiveStepStats {
+	uint64_t
+		ticks = 0, // Ticks stepped by StepAdaptive()
+		substepTicks = 0, // Ticks of those that were part of a larger substep
+		substeps = 0; // Larger substeps taken
+
+	// Fraction of ticks that were stepped as part of a larger substep
+	float GetSubstepFraction() const {
+		return ticks ? (float)substepTicks / ticks : 0;
+	}
+};
+
+RS_NS_END
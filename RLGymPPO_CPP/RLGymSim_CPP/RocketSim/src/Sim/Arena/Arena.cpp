@@ -7,6 +7,8 @@
 #include "../../../libsrc/bullet3-3.24/BulletCollision/BroadphaseCollision/btRSBroadphase.h"
 #include "../../../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
 #include "../../../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btInternalEdgeUtility.h"
+#include "../../../libsrc/bullet3-3.24/BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "../../../libsrc/bullet3-3.24/LinearMath/btPoolAllocator.h"
 #include "../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btBoxShape.h"
 #include "../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btSphereShape.h"
 
@@ -46,6 +48,7 @@ RSAPI void Arena::SetMutatorConfig(const MutatorConfig& mutatorConfig) {
 }
 
 Car* Arena::AddCar(Team team, const CarConfig& config) {
+	ArenaSlab::Scope slabScope = ArenaSlab::Scope(_slab);
 	Car* car = Car::_AllocateCar();
 	
 	car->config = config;
@@ -64,10 +67,10 @@ bool Arena::_AddCarFromPtr(Car* car) {
 	car->id = ++_lastCarID;
 
 	if (_carIDMap.find(car->id) == _carIDMap.end()) {
-		assert(!_cars.count(car));
+		assert(std::find(_cars.begin(), _cars.end(), car) == _cars.end());
 		
 		_carIDMap[car->id] = car;
-		_cars.insert(car);
+		_cars.push_back(car);
 		return true;
 
 	} else {
@@ -81,8 +84,9 @@ bool Arena::RemoveCar(uint32_t id) {
 	if (itr != _carIDMap.end()) {
 		Car* car = itr->second;
 		_carIDMap.erase(itr);
-		_cars.erase(car);
-		_bulletWorld.removeCollisionObject(&car->_rigidBody);
+		_cars.erase(std::find(_cars.begin(), _cars.end(), car));
+		if (car->_isInWorld)
+			_bulletWorld.removeCollisionObject(&car->_rigidBody);
 		if (ownsCars)
 			delete car;
 		return true;
@@ -207,6 +211,51 @@ void Arena::ResetToRandomKickoff(int seed) {
 	}
 }
 
+enum class ContactPairType : uint8_t {
+	NONE,
+	CAR_WORLD,
+	CAR_CAR,
+	CAR_BALL,
+	BALL_WORLD
+};
+
+struct ContactPairInfo {
+	ContactPairType type = ContactPairType::NONE;
+	bool shouldSwap = false; // Swap bodies so that A is the lower type
+};
+
+// Dispatch table of every pair of collision object user indices, built at compile time
+constexpr auto CONTACT_PAIR_TABLE = [] {
+	std::array<std::array<ContactPairInfo, BT_USERINFO_ID_AMOUNT>, BT_USERINFO_ID_AMOUNT> result = {};
+	for (int a = BT_USERINFO_WORLD; a < BT_USERINFO_TYPE_AMOUNT; a++) {
+		for (int b = BT_USERINFO_WORLD; b < BT_USERINFO_TYPE_AMOUNT; b++) {
+			ContactPairInfo& info = result[BT_USERINFO_TO_ID(a)][BT_USERINFO_TO_ID(b)];
+
+			if ((a != BT_USERINFO_WORLD) && (b != BT_USERINFO_WORLD)) {
+				// If both bodies have a user index, the lower user index should be A
+				info.shouldSwap = a > b;
+			} else {
+				// If only one body has a user index, make sure that body is A
+				info.shouldSwap = (b != BT_USERINFO_WORLD);
+			}
+
+			int typeA = info.shouldSwap ? b : a, typeB = info.shouldSwap ? a : b;
+			if (typeA == BT_USERINFO_TYPE_CAR) {
+				if (typeB == BT_USERINFO_TYPE_BALL) {
+					info.type = ContactPairType::CAR_BALL;
+				} else if (typeB == BT_USERINFO_TYPE_CAR) {
+					info.type = ContactPairType::CAR_CAR;
+				} else if (typeB == BT_USERINFO_WORLD) {
+					info.type = ContactPairType::CAR_WORLD;
+				}
+			} else if (typeA == BT_USERINFO_TYPE_BALL && typeB == BT_USERINFO_WORLD) {
+				info.type = ContactPairType::BALL_WORLD;
+			}
+		}
+	}
+	return result;
+}();
+
 bool Arena::_BulletContactAddedCallback(
 	btManifoldPoint& contactPoint,
 	const btCollisionObjectWrapper* objA, int partID_A, int indexA,
@@ -216,52 +265,55 @@ bool Arena::_BulletContactAddedCallback(
 		bodyA = objA->m_collisionObject,
 		bodyB = objB->m_collisionObject;
 
-	if (!objA->m_collisionObject->hasContactResponse() || !objB->m_collisionObject->hasContactResponse())
+	if (!bodyA->hasContactResponse() || !bodyB->hasContactResponse())
 		return true;
 
-	bool shouldSwap = false;
-	if ((bodyA->getUserIndex() != -1) && (bodyB->getUserIndex() != -1)) {
-		// If both bodies have a user index, the lower user index should be A
-		shouldSwap = bodyA->getUserIndex() > bodyB->getUserIndex();
-	} else {
-		// If only one body has a user index, make sure that body is A
-		shouldSwap = (bodyB->getUserIndex() != -1);
-	}
-
-	if (shouldSwap)
-		std::swap(bodyA, bodyB);
-
 	int
 		userIndexA = bodyA->getUserIndex(),
 		userIndexB = bodyB->getUserIndex();
 
-	bool carInvolved = (userIndexA == BT_USERINFO_TYPE_CAR);
-	if (carInvolved) {
+	assert(userIndexA >= BT_USERINFO_WORLD && userIndexA < BT_USERINFO_TYPE_AMOUNT);
+	assert(userIndexB >= BT_USERINFO_WORLD && userIndexB < BT_USERINFO_TYPE_AMOUNT);
+	ContactPairInfo pairInfo = CONTACT_PAIR_TABLE[BT_USERINFO_TO_ID(userIndexA)][BT_USERINFO_TO_ID(userIndexB)];
 
+	bool shouldSwap = pairInfo.shouldSwap;
+	if (shouldSwap)
+		std::swap(bodyA, bodyB);
+
+	switch (pairInfo.type) {
+	case ContactPairType::CAR_WORLD:
+	{
+		// Most common pair, world objects point straight to their arena
+		Arena* arenaInst = (Arena*)bodyB->getUserPointer();
+		arenaInst->_BtCallback_OnCarWorldCollision((Car*)bodyA->getUserPointer(), (btCollisionObject*)bodyB, contactPoint);
+		break;
+	}
+	case ContactPairType::CAR_CAR:
+	{
 		Car* car = (Car*)bodyA->getUserPointer();
 		Arena* arenaInst = (Arena*)car->_bulletVehicle.m_dynamicsWorld->getWorldUserInfo();
-
-		if (userIndexB == BT_USERINFO_TYPE_BALL) {
-			// Car + Ball
-			arenaInst->
-				_BtCallback_OnCarBallCollision(car, (Ball*)bodyB->getUserPointer(), contactPoint, shouldSwap);
-		} else if (userIndexB == BT_USERINFO_TYPE_CAR) {
-			// Car + Car
-			arenaInst->
-				_BtCallback_OnCarCarCollision(car, (Car*)bodyB->getUserPointer(), contactPoint);
-		} else {
-			// Car + World
-			arenaInst->
-				_BtCallback_OnCarWorldCollision(car, (btCollisionObject*)bodyB->getUserPointer(), contactPoint);
-		}
-	} else if (userIndexA == BT_USERINFO_TYPE_BALL && userIndexB == -1) {
-		// Ball + World
+		arenaInst->_BtCallback_OnCarCarCollision(car, (Car*)bodyB->getUserPointer(), contactPoint);
+		break;
+	}
+	case ContactPairType::CAR_BALL:
+	{
+		Car* car = (Car*)bodyA->getUserPointer();
+		Arena* arenaInst = (Arena*)car->_bulletVehicle.m_dynamicsWorld->getWorldUserInfo();
+		arenaInst->_BtCallback_OnCarBallCollision(car, (Ball*)bodyB->getUserPointer(), contactPoint, shouldSwap);
+		break;
+	}
+	case ContactPairType::BALL_WORLD:
+	{
 		Arena* arenaInst = (Arena*)bodyB->getUserPointer();
 		arenaInst->ball->_OnWorldCollision(arenaInst->gameMode, contactPoint.m_normalWorldOnB, arenaInst->tickTime);
 		
 		// Set as special
 		if (arenaInst->gameMode != GameMode::SNOWDAY)
 			contactPoint.m_isSpecial = true;
+		break;
+	}
+	default:
+		break;
 	}
 	
 	btAdjustInternalEdgeContacts(
@@ -286,6 +338,16 @@ void Arena::_BtCallback_OnCarBallCollision(Car* car, Ball* ball, btManifoldPoint
 
 	ballHitInfo.isValid = true;
 
+	{ // Update team's latest touches
+		auto& touches = _teamBallTouches[(int)car->team];
+		if (touches.carIDs[0] != car->id) {
+			touches.carIDs[1] = touches.carIDs[0];
+			touches.ticks[1] = touches.ticks[0];
+			touches.carIDs[0] = car->id;
+		}
+		touches.ticks[0] = this->tickCount;
+	}
+
 	ballHitInfo.relativePosOnBall = (ballIsBodyA ? manifoldPoint.m_localPointA : manifoldPoint.m_localPointB) * BT_TO_UU;
 	ballHitInfo.tickCountWhenHit = this->tickCount;
 
@@ -401,6 +463,9 @@ void Arena::_BtCallback_OnCarCarCollision(Car* car1, Car* car2, btManifoldPoint&
 					car1->_internalState.carContact.otherCarID = car2->id;
 					car1->_internalState.carContact.cooldownTimer = _mutatorConfig.bumpCooldownTime;
 
+					if (queueEvents)
+						_eventQueue.push_back({ isDemo ? ArenaEvent::Type::DEMO : ArenaEvent::Type::BUMP, car1->id, car2->id });
+
 					if (_carBumpCallback.func)
 						_carBumpCallback.func(this, car1, car2, isDemo, _carBumpCallback.userInfo);
 				}
@@ -427,13 +492,28 @@ Arena::Arena(GameMode gameMode, const ArenaConfig& config, float tickRate) : _mu
 
 	this->gameMode = gameMode;
 	this->tickTime = 1 / tickRate;
+	this->_stepTickFns = _GetStepTickFns(gameMode);
+
+	// Everything we allocate from here on is placed in our slab, as long as it fits
+	_slab = ArenaSlab::Create((size_t)_config.slabKB * 1024, _config.slabHugePages);
+	ArenaSlab::Scope slabScope = ArenaSlab::Scope(_slab);
 
 	{ // Initialize world
 
 		btDefaultCollisionConstructionInfo collisionConfigConstructionInfo = {};
 
-		// These take up a ton of memory normally
-		if (_config.memWeightMode == ArenaMemWeightMode::LIGHT) {
+		_collisionPools = _config.collisionPools ? _config.collisionPools : ArenaCollisionPools::_GetCurrent();
+		if (_collisionPools) {
+			collisionConfigConstructionInfo.m_persistentManifoldPool = _collisionPools->manifoldPool;
+			collisionConfigConstructionInfo.m_collisionAlgorithmPool = _collisionPools->algorithmPool;
+		} else if (_config.expectedCars > 0) {
+			collisionConfigConstructionInfo.m_defaultMaxPersistentManifoldPoolSize = ArenaCollisionPools::GetManifoldAmount(_config.expectedCars);
+			collisionConfigConstructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = ArenaCollisionPools::GetAlgorithmAmount(_config.expectedCars);
+		} else if (_config.memWeightMode == ArenaMemWeightMode::ULTRALIGHT) {
+			// These take up a ton of memory normally
+			collisionConfigConstructionInfo.m_defaultMaxPersistentManifoldPoolSize /= 128;
+			collisionConfigConstructionInfo.m_defaultMaxCollisionAlgorithmPoolSize /= 256;
+		} else if (_config.memWeightMode == ArenaMemWeightMode::LIGHT) {
 			collisionConfigConstructionInfo.m_defaultMaxPersistentManifoldPoolSize /= 32;
 			collisionConfigConstructionInfo.m_defaultMaxCollisionAlgorithmPoolSize /= 64;
 		} else {
@@ -450,7 +530,7 @@ Arena::Arena(GameMode gameMode, const ArenaConfig& config, float tickRate) : _mu
 
 		if (_config.useCustomBroadphase) {
 			float cellSizeMultiplier = 1;
-			if (_config.memWeightMode == ArenaMemWeightMode::LIGHT) {
+			if (IsLightMemWeightMode(_config.memWeightMode)) {
 				// Increase cell size
 				cellSizeMultiplier = 2.0f;
 			}
@@ -486,8 +566,10 @@ Arena::Arena(GameMode gameMode, const ArenaConfig& config, float tickRate) : _mu
 		_SetupArenaCollisionShapes();
 
 #ifndef RS_NO_SUSPCOLGRID
-		_suspColGrid = RocketSim::GetDefaultSuspColGrid(gameMode, memWeightMode == ArenaMemWeightMode::LIGHT);
-		_suspColGrid.defaultWorldCollisionRB = &_worldCollisionRBs[0];
+		_suspColGrid = RocketSim::GetDefaultSuspColGrid(gameMode, IsLightMemWeightMode(_config.memWeightMode));
+		_suspColGrid.worldCollisionRBs = _worldCollisionRBs;
+		_suspColGrid.worldCollisionRBAmount = _worldCollisionRBAmount;
+		_suspColGrid.rsBroadphase = _config.useCustomBroadphase ? (btRSBroadphase*)_bulletWorldParams.broadphase : NULL;
 #endif
 
 		// Give arena collision shapes the proper restitution/friction values
@@ -498,6 +580,13 @@ Arena::Arena(GameMode gameMode, const ArenaConfig& config, float tickRate) : _mu
 			rb->setFriction(0.6f);
 			rb->setRollingFriction(0.f);
 		}
+
+		if (_config.useArenaSDF) {
+			_SetupArenaSDF();
+			_worldSDFRB->setRestitution(0.3f);
+			_worldSDFRB->setFriction(0.6f);
+			_worldSDFRB->setRollingFriction(0.f);
+		}
 	} else {
 		_worldCollisionRBs = NULL;
 		_worldCollisionRBAmount = 0;
@@ -617,6 +706,10 @@ Arena* Arena::DeserializeNew(DataStreamIn& in) {
 		}
 
 		newArena->_lastCarID = lastCarID;
+
+		// Latest touches aren't serialized, rebuild them from the cars when needed
+		for (auto& touches : newArena->_teamBallTouches)
+			touches.isValid = false;
 	}
 
 	// Deserialize boost pads
@@ -651,11 +744,16 @@ Arena* Arena::DeserializeNew(DataStreamIn& in) {
 }
 
 Arena* Arena::Clone(bool copyCallbacks) {
-	Arena* newArena = new Arena(this->gameMode, this->_config, this->GetTickRate());
+	// Clones may be stepped on other threads, so they never share our pools
+	ArenaConfig cloneConfig = _config;
+	cloneConfig.collisionPools = NULL;
+
+	Arena* newArena = new Arena(this->gameMode, cloneConfig, this->GetTickRate());
 	
 	if (copyCallbacks) {
 		newArena->_goalScoreCallback = this->_goalScoreCallback;
 		newArena->_carBumpCallback = this->_carBumpCallback;
+		newArena->queueEvents = this->queueEvents;
 	}
 
 	newArena->ball->SetState(this->ball->GetState());
@@ -677,10 +775,97 @@ Arena* Arena::Clone(bool copyCallbacks) {
 	newArena->tickCount = this->tickCount;
 	newArena->_lastCarID = this->_lastCarID;
 
+	for (int i = 0; i < 2; i++)
+		newArena->_teamBallTouches[i] = this->_teamBallTouches[i];
+
 	return newArena;
 }
 
+Arena* Arena::Fork() const {
+	// ULTRALIGHT arenas share static world collision, and simulate the same as LIGHT ones
+	ArenaConfig forkConfig = _config;
+	if (IsLightMemWeightMode(forkConfig.memWeightMode))
+		forkConfig.memWeightMode = ArenaMemWeightMode::ULTRALIGHT;
+	forkConfig.collisionPools = NULL; // Same as clones
+
+	Arena* fork = new Arena(this->gameMode, forkConfig, this->GetTickRate());
+	fork->SetMutatorConfig(this->_mutatorConfig);
+
+	for (Car* car : this->_cars) {
+		Car* newCar = fork->AddCar(car->team, car->config);
+
+		// Keep the same ID
+		fork->_carIDMap.erase(newCar->id);
+		fork->_carIDMap[car->id] = newCar;
+		newCar->id = car->id;
+	}
+	fork->_lastCarID = this->_lastCarID;
+
+	CopyStateTo(fork);
+
+	// Car IDs are the same, so the latest touches still apply
+	for (int i = 0; i < 2; i++)
+		fork->_teamBallTouches[i] = this->_teamBallTouches[i];
+	return fork;
+}
+
+void Arena::CopyStateTo(Arena* other) const {
+	// Match tick counts first so restored ball hit ticks aren't shifted
+	other->tickCount = this->tickCount;
+
+	// Before restoring, so demoed cars are taken out of the world like in a new arena
+	other->_ResetDynamicBodies();
+
+	TakeSnapshot(other->_copyStateSnapshot);
+	other->RestoreSnapshot(other->_copyStateSnapshot);
+
+	other->ball->_velocityImpulseCache = this->ball->_velocityImpulseCache;
+	for (int i = 0; i < _cars.size(); i++)
+		other->_cars[i]->_velocityImpulseCache = this->_cars[i]->_velocityImpulseCache;
+
+	// Suspension pushback of the next tick uses the time step of our last one (see btVehicleRL::rayCast())
+	other->_bulletWorld.getSolverInfo().m_timeStep = this->_bulletWorld.getSolverInfo().m_timeStep;
+}
+
+void Arena::_ClearContactCache() {
+	btCollisionDispatcher& dispatcher = _bulletWorldParams.collisionDispatcher;
+	for (int i = 0; i < dispatcher.getNumManifolds(); i++)
+		dispatcher.getManifoldByIndexInternal(i)->clearManifold();
+}
+
+void Arena::_ResetDynamicBodies() {
+	// Static world collision is always added before the ball and cars, so removing them never moves it
+	btBroadphaseProxy* ballProxy = ball->_rigidBody.getBroadphaseHandle();
+	int ballGroup = ballProxy->m_collisionFilterGroup, ballMask = ballProxy->m_collisionFilterMask;
+	_bulletWorld.removeRigidBody(&ball->_rigidBody);
+	for (Car* car : _cars)
+		if (car->_isInWorld)
+			_bulletWorld.removeRigidBody(&car->_rigidBody);
+
+	// Our broadphase goes through proxies in handle order, so they need the same handles as in a new arena
+	if (_config.useCustomBroadphase)
+		((btRSBroadphase*)_bulletWorldParams.broadphase)->sortFreeHandles();
+
+	// Proxies start in the cell they are added in, so add them where a new arena does (see Ball::_BulletSetup() and Car::_BulletSetup())
+	// Interpolation transforms are also reset, as restoring doesn't set them, and they widen the AABBs of the next tick
+	auto fnResetTransform = [](btRigidBody& rb, const btTransform& transform) {
+		rb.setWorldTransform(transform);
+		rb.setInterpolationWorldTransform(transform);
+		rb.setInterpolationLinearVelocity(btVector3(0, 0, 0));
+		rb.setInterpolationAngularVelocity(btVector3(0, 0, 0));
+	};
+
+	fnResetTransform(ball->_rigidBody, btTransform(btMatrix3x3::getIdentity(), btVector3(0, 0, _mutatorConfig.ballRadius * UU_TO_BT)));
+	_bulletWorld.addRigidBody(&ball->_rigidBody, ballGroup, ballMask);
+	for (Car* car : _cars) {
+		fnResetTransform(car->_rigidBody, btTransform::getIdentity());
+		_bulletWorld.addRigidBody(&car->_rigidBody);
+		car->_isInWorld = true;
+	}
+}
+
 Car* Arena::DeserializeNewCar(DataStreamIn& in, Team team) {
+	ArenaSlab::Scope slabScope = ArenaSlab::Scope(_slab);
 	Car* car = Car::_AllocateCar();
 	car->_Deserialize(in);
 	car->team = team;
@@ -693,94 +878,420 @@ Car* Arena::DeserializeNewCar(DataStreamIn& in, Team team) {
 	return car;
 }
 
-void Arena::Step(int ticksToSimulate) {
-	for (int i = 0; i < ticksToSimulate; i++) {
+// Adds the time since the last phase ended to this phase of the arena's profile
+#ifdef RS_PROFILE
+#define RS_PROFILE_PHASES_BEGIN() uint64_t _profileTime = ArenaProfile::GetTimestamp();
+#define RS_PROFILE_PHASE_END(phase) { \
+	uint64_t _profileNow = ArenaProfile::GetTimestamp(); \
+	profile.phaseTimes[(int)ArenaProfilePhase::phase] += _profileNow - _profileTime; \
+	_profileTime = _profileNow; \
+}
+#else
+#define RS_PROFILE_PHASES_BEGIN() {}
+#define RS_PROFILE_PHASE_END(phase) {}
+#endif
 
-		_bulletWorld.setWorldUserInfo(this);
+template<GameMode GAME_MODE, bool BALL_ONLY>
+void Arena::_StepTickPre() {
+	RS_PROFILE_PHASES_BEGIN();
 
-		{ // Ball zero-vel sleeping
-			if (ball->_rigidBody.m_linearVelocity.length2() == 0 && ball->_rigidBody.m_angularVelocity.length2() == 0) {
-				ball->_rigidBody.setActivationState(ISLAND_SLEEPING);
-			} else {
-				ball->_rigidBody.setActivationState(ACTIVE_TAG);
-			}
-		}
+	_bulletWorld.setWorldUserInfo(this);
 
-		bool ballOnly = _cars.empty();
+	{ // Ball zero-vel sleeping
+		if (ball->_rigidBody.m_linearVelocity.length2() == 0 && ball->_rigidBody.m_angularVelocity.length2() == 0) {
+			ball->_rigidBody.setActivationState(ISLAND_SLEEPING);
+		} else {
+			ball->_rigidBody.setActivationState(ACTIVE_TAG);
+		}
+	}
 
-		bool hasArenaStuff = (gameMode != GameMode::THE_VOID);
-		bool shouldUpdateSuspColGrid = hasArenaStuff && !ballOnly;
-		if (shouldUpdateSuspColGrid) {
+	constexpr bool HAS_ARENA_STUFF = (GAME_MODE != GameMode::THE_VOID);
+	constexpr bool SHOULD_UPDATE_SUSP_COL_GRID = HAS_ARENA_STUFF && !BALL_ONLY;
+	if constexpr (SHOULD_UPDATE_SUSP_COL_GRID) {
 #ifndef RS_NO_SUSPCOLGRID
-			{ // Add dynamic bodies to suspension grid
-				for (Car* car : _cars) {
-					if (car->_internalState.isDemoed)
-						continue;
-
-					btVector3 min, max;
-					car->_rigidBody.getAabb(min, max);
-					_suspColGrid.UpdateDynamicCollisions(min, max, false);
-				}
+		{ // Add dynamic bodies to suspension grid
+			for (Car* car : _cars) {
+				if (car->_internalState.isDemoed)
+					continue;
 
 				btVector3 min, max;
-				ball->_rigidBody.getAabb(min, max);
-				_suspColGrid.UpdateDynamicCollisions(min, max, false);
+				car->_rigidBody.getAabb(min, max);
+				_suspColGrid.UpdateDynamicCollisions(&car->_rigidBody, min, max);
 			}
-#endif
+
+			btVector3 min, max;
+			ball->_rigidBody.getAabb(min, max);
+			_suspColGrid.UpdateDynamicCollisions(&ball->_rigidBody, min, max);
 		}
 
-		for (Car* car : _cars) {
-			SuspensionCollisionGrid* suspColGridPtr;
-#ifdef RS_NO_SUSPCOLGRID
-			suspColGridPtr = NULL;
-#else
-			if (shouldUpdateSuspColGrid) {
-				suspColGridPtr = &_suspColGrid;
+		{ // Cast every car's wheel rays together, cars will only redo rays that have changed when they update
+			auto precastFn = [this](size_t i) {
+				Car* car = _cars[i];
+				car->_bulletVehicle.precastWheelRays(car->_internalState.isDemoed ? NULL : &_suspColGrid);
+			};
+
+			if (_carTaskPool) {
+				_carTaskPool->Run(_cars.size(), precastFn);
 			} else {
-				suspColGridPtr = NULL;
+				for (size_t i = 0; i < _cars.size(); i++)
+					precastFn(i);
 			}
-#endif
-			car->_PreTickUpdate(gameMode, tickTime, _mutatorConfig, suspColGridPtr);
 		}
+#endif
+	}
+
+	bool updateCarsInParallel = false;
+	if constexpr (!BALL_ONLY) {
+		if (_carTaskPool)
+			updateCarsInParallel = _PrepareParallelCarUpdate();
+	}
+	RS_PROFILE_PHASE_END(SUSP_COL_GRID);
+
+	SuspensionCollisionGrid* suspColGridPtr;
+#ifdef RS_NO_SUSPCOLGRID
+	suspColGridPtr = NULL;
+#else
+	if constexpr (SHOULD_UPDATE_SUSP_COL_GRID) {
+		suspColGridPtr = &_suspColGrid;
+	} else {
+		suspColGridPtr = NULL;
+	}
+#endif
 
-		if (shouldUpdateSuspColGrid) {
+	if (updateCarsInParallel) {
+		_carTaskPool->Run(_cars.size(),
+			[this, suspColGridPtr](size_t i) {
+				_cars[i]->_PreTickUpdate(GAME_MODE, tickTime, _mutatorConfig, suspColGridPtr);
+			}
+		);
+	} else {
+		for (Car* car : _cars)
+			car->_PreTickUpdate(GAME_MODE, tickTime, _mutatorConfig, suspColGridPtr);
+	}
+
+	if constexpr (SHOULD_UPDATE_SUSP_COL_GRID) {
 #ifndef RS_NO_SUSPCOLGRID
-			_suspColGrid.ClearDynamicCollisions();
+		_suspColGrid.ClearDynamicCollisions();
 #endif
+	}
+	RS_PROFILE_PHASE_END(CAR_PRE_TICK);
+
+	// Update ball, which only does anything in heatseeker and snowday
+	if constexpr (GAME_MODE == GameMode::HEATSEEKER || GAME_MODE == GameMode::SNOWDAY)
+		ball->_PreTickUpdate(GAME_MODE, tickTime);
+	RS_PROFILE_PHASE_END(BALL_PRE_TICK);
+}
+
+template<GameMode GAME_MODE, bool BALL_ONLY>
+void Arena::_StepTickBullet() {
+	RS_PROFILE_PHASES_BEGIN();
+
+	// Update world
+	_bulletWorld.stepSimulation(tickTime, 0, tickTime);
+	RS_PROFILE_PHASE_END(BULLET_STEP);
+}
+
+template<GameMode GAME_MODE, bool BALL_ONLY>
+void Arena::_StepTickCarsPost() {
+	RS_PROFILE_PHASES_BEGIN();
+
+	if (_carTaskPool && !BALL_ONLY) {
+		// Post-tick and finishing only touch the car itself
+		_carTaskPool->Run(_cars.size(),
+			[this](size_t i) {
+				_cars[i]->_PostTickUpdate(GAME_MODE, tickTime, _mutatorConfig);
+				_cars[i]->_FinishPhysicsTick(_mutatorConfig);
+			}
+		);
+	} else {
+		for (Car* car : _cars) {
+			car->_PostTickUpdate(GAME_MODE, tickTime, _mutatorConfig);
+			car->_FinishPhysicsTick(_mutatorConfig);
 		}
+	}
+	RS_PROFILE_PHASE_END(CAR_POST_TICK);
+}
+
+template<GameMode GAME_MODE, bool BALL_ONLY>
+void Arena::_StepTickPads() {
+	RS_PROFILE_PHASES_BEGIN();
+
+	// Nothing reads the pads during the tick, so they do all of theirs here in one pass
+	// Pads are shared, so cars still pick them up in order
+	if constexpr (GAME_MODE != GameMode::THE_VOID && !BALL_ONLY)
+		_boostPadGrid.UpdatePads(_cars, tickTime, _mutatorConfig);
+	RS_PROFILE_PHASE_END(BOOST_PADS);
+}
 
-		if (hasArenaStuff && !ballOnly) {
-			for (BoostPad* pad : _boostPads)
-				pad->_PreTickUpdate(tickTime);
+template<GameMode GAME_MODE, bool BALL_ONLY>
+void Arena::_StepTickFinish() {
+	RS_PROFILE_PHASES_BEGIN();
+
+	ball->_FinishPhysicsTick(_mutatorConfig);
+	RS_PROFILE_PHASE_END(BALL_FINISH);
+
+	if (_goalScoreCallback.func != NULL) { // Potentially fire goal score callback
+		if (IsBallScored()) {
+			_goalScoreCallback.func(this, RS_TEAM_FROM_Y(-ball->_rigidBody.m_worldTransform.m_origin.y()), _goalScoreCallback.userInfo);
 		}
+	}
+	RS_PROFILE_PHASE_END(GOAL_CHECK);
 
-		// Update ball
-		ball->_PreTickUpdate(gameMode, tickTime);
+#ifdef RS_PROFILE
+	{ // Count what this tick worked with, outside of the timed phases
+		profile.ticks++;
 
-		// Update world
-		_bulletWorld.stepSimulation(tickTime, 0, tickTime);
+		btCollisionDispatcher* dispatcher = _bulletWorld.getDispatcher();
+		for (int j = 0; j < dispatcher->getNumManifolds(); j++)
+			profile.contactPoints += dispatcher->getManifoldByIndexInternal(j)->getNumContacts();
+
+		profile.broadphasePairs += _bulletWorld.getBroadphase()->getOverlappingPairCache()->getNumOverlappingPairs();
 
 		for (Car* car : _cars) {
-			car->_PostTickUpdate(gameMode, tickTime, _mutatorConfig);
-			car->_FinishPhysicsTick(_mutatorConfig);
-			if (hasArenaStuff)
-				_boostPadGrid.CheckCollision(car);
+			profile.suspensionRays += car->_bulletVehicle.m_profileRayAmount;
+			profile.suspensionBulletRays += car->_bulletVehicle.m_profileBulletRayAmount;
+			car->_bulletVehicle.m_profileRayAmount = 0;
+			car->_bulletVehicle.m_profileBulletRayAmount = 0;
 		}
+	}
+#endif
 
-		if (hasArenaStuff && !ballOnly)
-			for (BoostPad* pad : _boostPads)
-				pad->_PostTickUpdate(tickTime, _mutatorConfig);
+	tickCount++;
+}
+
+template<GameMode GAME_MODE, bool BALL_ONLY>
+void Arena::_StepTick() {
+	_StepTickPre<GAME_MODE, BALL_ONLY>();
+	_StepTickBullet<GAME_MODE, BALL_ONLY>();
+	_StepTickCarsPost<GAME_MODE, BALL_ONLY>();
+	_StepTickPads<GAME_MODE, BALL_ONLY>();
+	_StepTickFinish<GAME_MODE, BALL_ONLY>();
+}
 
-		ball->_FinishPhysicsTick(_mutatorConfig);
+Arena::StepTickFns Arena::_GetStepTickFns(GameMode gameMode) {
+#define RS_STEP_TICK_PHASE_FNS(gameMode, ballOnly) { \
+	&Arena::_StepTickPre<gameMode, ballOnly>, \
+	&Arena::_StepTickBullet<gameMode, ballOnly>, \
+	&Arena::_StepTickCarsPost<gameMode, ballOnly>, \
+	&Arena::_StepTickPads<gameMode, ballOnly>, \
+	&Arena::_StepTickFinish<gameMode, ballOnly> \
+}
+#define RS_STEP_TICK_FNS(gameMode) { \
+	{ &Arena::_StepTick<gameMode, false>, &Arena::_StepTick<gameMode, true> }, \
+	{ RS_STEP_TICK_PHASE_FNS(gameMode, false), RS_STEP_TICK_PHASE_FNS(gameMode, true) } \
+}
+	switch (gameMode) {
+	case GameMode::SOCCAR:
+		return RS_STEP_TICK_FNS(GameMode::SOCCAR);
+	case GameMode::HOOPS:
+		return RS_STEP_TICK_FNS(GameMode::HOOPS);
+	case GameMode::HEATSEEKER:
+		return RS_STEP_TICK_FNS(GameMode::HEATSEEKER);
+	case GameMode::SNOWDAY:
+		return RS_STEP_TICK_FNS(GameMode::SNOWDAY);
+	case GameMode::THE_VOID:
+		return RS_STEP_TICK_FNS(GameMode::THE_VOID);
+	default:
+		RS_ERR_CLOSE("Arena::_GetStepTickFns(): Unknown game mode " << (int)gameMode);
+	}
+#undef RS_STEP_TICK_FNS
+#undef RS_STEP_TICK_PHASE_FNS
+}
+
+bool Arena::_PrepareParallelCarUpdate() {
+	for (Car* car : _cars) {
+		// Leaving and rejoining the world changes bullet's object lists, and respawning uses the shared random generator
+		// Demoed cars that are already out of the world only count down their respawn timer
+		if (car->_internalState.isDemoed && (car->_isInWorld || car->_internalState.demoRespawnTimer - tickTime <= 0))
+			return false;
+	}
+
+	for (Car* car : _cars) {
+		if (car->_internalState.isDemoed)
+			continue;
+
+		car->_bulletVehicle.precastRemainingWheelRays();
+
+		// Wheel friction reads the velocity of the car under it, which that car changes during its own update
+		for (int i = 0; i < car->_bulletVehicle.getNumWheels(); i++) {
+			btCollisionObject* groundObject = car->_bulletVehicle.m_wheelInfo[i].m_precastRay.object;
+			if (groundObject && groundObject->getUserIndex() == BT_USERINFO_TYPE_CAR)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void Arena::SetCarUpdateThreads(int numThreads) {
+	if (numThreads < 1)
+		RS_ERR_CLOSE("Arena::SetCarUpdateThreads(): Invalid thread count (" << numThreads << ")");
+
+	delete _carTaskPool;
+	_carTaskPool = (numThreads > 1) ? new ArenaTaskPool(numThreads) : NULL;
+}
 
-		if (_goalScoreCallback.func != NULL) { // Potentially fire goal score callback
-			if (IsBallScored()) {
-				_goalScoreCallback.func(this, RS_TEAM_FROM_Y(-ball->_rigidBody.m_worldTransform.m_origin.y()), _goalScoreCallback.userInfo);
+void Arena::Step(int ticksToSimulate) {
+	// Bullet can allocate while stepping, i.e. past the end of its collision pools
+	ArenaSlab::Scope slabScope = ArenaSlab::Scope(_slab);
+	for (int i = 0; i < ticksToSimulate; i++) {
+		// Cars can be added or removed by callbacks, so this is picked every tick
+		(this->*_stepTickFns.fns[_cars.empty()])();
+	}
+}
+
+bool Arena::_MayRespawnCarsWithin(int ticks) const {
+	// Cars demolished during the step could respawn in it
+	float time = ticks * tickTime;
+	if (time >= _mutatorConfig.respawnDelay)
+		return true;
+
+	// A tick of margin, as the respawn timer counts down by adding up tick times
+	for (Car* car : _cars)
+		if (car->_internalState.isDemoed && car->_internalState.demoRespawnTimer <= time + tickTime)
+			return true;
+
+	return false;
+}
+
+void Arena::StepMultiple(Arena* const* arenas, size_t amount, int ticksToSimulate) {
+	// Arenas that may respawn a car draw from the shared random generator, so they are stepped on their own, in order
+	// Every other arena never draws, so the draws are in the same order as stepping every arena on its own
+	thread_local std::vector<Arena*> interleaved = {};
+	interleaved.clear();
+	for (size_t i = 0; i < amount; i++) {
+		if (arenas[i]->_MayRespawnCarsWithin(ticksToSimulate)) {
+			arenas[i]->Step(ticksToSimulate);
+		} else {
+			interleaved.push_back(arenas[i]);
+		}
+	}
+
+	for (int i = 0; i < ticksToSimulate; i++) {
+		// Cars can be added or removed by callbacks, so this is picked at the start of every tick, and kept for all of its phases
+		for (Arena* arena : interleaved)
+			arena->_tickBallOnly = arena->_cars.empty();
+
+		for (int phase = 0; phase < STEP_TICK_PHASE_AMOUNT; phase++) {
+			for (Arena* arena : interleaved) {
+				ArenaSlab::Scope slabScope = ArenaSlab::Scope(arena->_slab);
+				(arena->*arena->_stepTickFns.phaseFns[arena->_tickBallOnly][phase])();
 			}
 		}
+	}
+}
 
-		tickCount++;
+void Arena::StepAdaptive(int ticksToSimulate, const AdaptiveStepConfig& config) {
+	ArenaSlab::Scope slabScope = ArenaSlab::Scope(_slab);
+
+	float baseTickTime = tickTime;
+	for (int ticksLeft = ticksToSimulate; ticksLeft > 0;) {
+		// Use the largest substep we can, halving it until we're quiet for all of it
+		int substepTicks = RS_MIN(config.maxSubstepTicks, ticksLeft);
+		while (substepTicks > 1 && !_IsQuietFor(baseTickTime * substepTicks, config))
+			substepTicks /= 2;
+		substepTicks = RS_MAX(substepTicks, 1);
+
+		// Everything that advances with time scales with our tick time, so one longer tick covers the whole substep
+		tickTime = baseTickTime * substepTicks;
+		(this->*_stepTickFns.fns[_cars.empty()])();
+		tickTime = baseTickTime;
+
+		tickCount += substepTicks - 1;
+		if (substepTicks > 1) {
+			adaptiveStepStats.substepTicks += substepTicks;
+			adaptiveStepStats.substeps++;
+		}
+		ticksLeft -= substepTicks;
 	}
+	adaptiveStepStats.ticks += ticksToSimulate;
+}
+
+bool Arena::_IsQuietFor(float time, const AdaptiveStepConfig& config) const {
+	if (gameMode != GameMode::SOCCAR)
+		return false;
+
+	using namespace RLConst;
+
+	// Objects must stay within these bounds, which keep them off of the walls, the ceiling, the corners,
+	//	and the ramps between the floor and the walls
+	constexpr float
+		RAMP_SIZE = 256,
+		CORNER_EXTENT = ARENA_EXTENT_X + ARENA_EXTENT_Y - 1152, // |x| + |y| of the corner walls
+		MAX_X = ARENA_EXTENT_X - RAMP_SIZE,
+		MAX_Y = ARENA_EXTENT_Y - RAMP_SIZE,
+		MAX_CORNER = CORNER_EXTENT - RAMP_SIZE * (float)M_SQRT2,
+		MAX_Z = ARENA_HEIGHT - RAMP_SIZE;
+
+	// Bounding boxes of everything, grown by how far each can move in the time, in UU
+	// Boxes are kept half of the min gap apart from each other, so objects are the full gap apart
+	constexpr int MAX_OBJECTS = 64;
+	Vec mins[MAX_OBJECTS], maxes[MAX_OBJECTS];
+	int numObjects = 0;
+
+	auto fnAddObject = [&](const btRigidBody& rb) -> bool {
+		btVector3 btMin, btMax;
+		rb.getAabb(btMin, btMax);
+		float grow = rb.m_linearVelocity.length() * BT_TO_UU * time + config.minGap / 2;
+		Vec min = Vec(btMin * BT_TO_UU) - Vec(grow, grow, grow);
+		Vec max = Vec(btMax * BT_TO_UU) + Vec(grow, grow, grow);
+
+		float maxAbsX = RS_MAX(abs(min.x), abs(max.x)), maxAbsY = RS_MAX(abs(min.y), abs(max.y));
+		if (maxAbsX > MAX_X || maxAbsY > MAX_Y || maxAbsX + maxAbsY > MAX_CORNER || max.z > MAX_Z)
+			return false;
+
+		for (int i = 0; i < numObjects; i++)
+			if (min.x < maxes[i].x && max.x > mins[i].x && min.y < maxes[i].y && max.y > mins[i].y && min.z < maxes[i].z && max.z > mins[i].z)
+				return false;
+
+		mins[numObjects] = min;
+		maxes[numObjects] = max;
+		numObjects++;
+		return true;
+	};
+
+	if (_cars.size() + 1 > MAX_OBJECTS)
+		return false;
+
+	for (Car* car : _cars) {
+		const CarState& state = car->_internalState;
+		if (state.isDemoed || state.isJumping || state.isFlipping || state.isAutoFlipping || state.worldContact.hasContact)
+			return false;
+
+		// Pressing jump on the ground would start a jump
+		if (car->controls.jump)
+			return false;
+
+		// Driving on the flat floor, and not moving on the suspension
+		if (abs(car->_rigidBody.m_linearVelocity.z() * BT_TO_UU) > config.maxCarVelZ)
+			return false;
+		for (int i = 0; i < car->_bulletVehicle.getNumWheels(); i++) {
+			auto& raycastInfo = car->_bulletVehicle.m_wheelInfo[i].m_raycastInfo;
+			if (!raycastInfo.m_isInContact || raycastInfo.m_contactNormalWS.z() < 0.99f)
+				return false;
+		}
+
+		if (!fnAddObject(car->_rigidBody))
+			return false;
+	}
+
+	{ // Ball must either be rolling on the floor, or stay above it
+		float ballZ = ball->_rigidBody.m_worldTransform.m_origin.z() * BT_TO_UU;
+		float ballVelZ = ball->_rigidBody.m_linearVelocity.z() * BT_TO_UU;
+		float ballBottom = ballZ - _mutatorConfig.ballRadius;
+
+		bool rolling = ballBottom < (BALL_REST_Z - BALL_COLLISION_RADIUS_SOCCAR) * 2 && abs(ballVelZ) < config.maxRollingBallVelZ;
+		if (!rolling) {
+			float lowestBottom = ballBottom + RS_MIN(ballVelZ * time + _mutatorConfig.gravity.z * time * time / 2, 0);
+			if (lowestBottom < config.minGap)
+				return false;
+		}
+
+		if (!fnAddObject(ball->_rigidBody))
+			return false;
+	}
+
+	return true;
 }
 
 // Returns negative: within
@@ -946,7 +1457,24 @@ RSAPI bool Arena::IsBallScored() const {
 	}
 }
 
+ArenaCollisionPoolStats Arena::GetCollisionPoolStats() const {
+	auto& dispatcher = _bulletWorldParams.collisionDispatcher;
+	const btPoolAllocator* manifoldPool = dispatcher.getInternalManifoldPool();
+	const btPoolAllocator* algorithmPool = dispatcher.getInternalCollisionAlgorithmPool();
+
+	ArenaCollisionPoolStats stats = {};
+	stats.manifoldsUsed = manifoldPool->getUsedCount();
+	stats.manifoldPoolSize = manifoldPool->getMaxCount();
+	stats.algorithmsUsed = algorithmPool->getUsedCount();
+	stats.algorithmPoolSize = algorithmPool->getMaxCount();
+	stats.shared = _collisionPools != NULL;
+	stats.manifoldOverflows = dispatcher.m_manifoldPoolOverflows;
+	stats.algorithmOverflows = dispatcher.m_algorithmPoolOverflows;
+	return stats;
+}
+
 Arena::~Arena() {
+	delete _carTaskPool;
 
 	// Remove all from bullet world constraints
 	while (_bulletWorld.getNumConstraints() > 0)
@@ -978,19 +1506,25 @@ Arena::~Arena() {
 		delete[] _worldCollisionRBs;
 		delete[] _worldCollisionPlaneShapes;
 		delete[] _worldCollisionBvhShapes;
+		delete _worldSDFRB;
+		delete _worldSDFShape;
 	}
 
 	_bulletWorldParams.overlappingPairCache->~btHashedOverlappingPairCache();
 	btAlignedFree(_bulletWorldParams.overlappingPairCache);
 
 	delete _bulletWorldParams.broadphase;
+
+	// Our members still free into it once this returns, so it is only freed after them
+	if (_slab)
+		_slab->Release();
 }
 
 void Arena::_SetupArenaCollisionShapes() {
 	assert(gameMode != GameMode::THE_VOID);
 	bool isHoops = gameMode == GameMode::HOOPS;
 
-	auto collisionMeshes = RocketSim::GetArenaCollisionShapes(gameMode);
+	auto& collisionMeshes = RocketSim::GetArenaCollisionShapes(gameMode);
 
 	if (collisionMeshes.empty()) {
 		RS_ERR_CLOSE(
@@ -999,10 +1533,45 @@ void Arena::_SetupArenaCollisionShapes() {
 		)
 	}
 
-	_worldCollisionBvhShapes = new btBvhTriangleMeshShape[collisionMeshes.size()];
+	// Static shapes are never modified during simulation, so ULTRALIGHT arenas can all point at the same ones
+	// Only the rigid bodies (which belong to a single world) are per-arena
+	bool shareShapes = _config.memWeightMode == ArenaMemWeightMode::ULTRALIGHT;
+
+	using namespace RLConst;
+
+	float
+		extentX = isHoops ? ARENA_EXTENT_X_HOOPS : ARENA_EXTENT_X,
+		extentY = isHoops ? ARENA_EXTENT_Y_HOOPS : ARENA_EXTENT_Y,
+		height = isHoops ? ARENA_HEIGHT_HOOPS : ARENA_HEIGHT;
+
+	// Floor, ceiling, side walls, then the Y walls (hoops only)
+	constexpr size_t PLANE_AMOUNT_MAX = 6;
+	static btStaticPlaneShape sharedPlaneShapes[PLANE_AMOUNT_MAX] = {
+		{ btVector3(0, 0, 1), 0 },
+		{ btVector3(0, 0, -1), 0 },
+		{ btVector3(1, 0, 0), 0 },
+		{ btVector3(-1, 0, 0), 0 },
+		{ btVector3(0, 1, 0), 0 },
+		{ btVector3(0, -1, 0), 0 },
+	};
+	Vec planePositions[PLANE_AMOUNT_MAX] = {
+		Vec(0, 0, 0),
+		Vec(0, 0, height),
+		Vec(-extentX, 0, height / 2),
+		Vec(extentX, 0, height / 2),
+		Vec(0, -extentY, height / 2),
+		Vec(0, extentY, height / 2),
+	};
 
 	size_t planeAmount = isHoops ? 6 : 4;
-	_worldCollisionPlaneShapes = new btStaticPlaneShape[planeAmount];
+
+	if (shareShapes) {
+		_worldCollisionBvhShapes = NULL;
+		_worldCollisionPlaneShapes = NULL;
+	} else {
+		_worldCollisionBvhShapes = new btBvhTriangleMeshShape[collisionMeshes.size()];
+		_worldCollisionPlaneShapes = new btStaticPlaneShape[planeAmount];
+	}
 
 	_worldCollisionRBAmount = collisionMeshes.size() + planeAmount;
 	_worldCollisionRBs = new btRigidBody[_worldCollisionRBAmount];
@@ -1010,88 +1579,153 @@ void Arena::_SetupArenaCollisionShapes() {
 	for (size_t i = 0; i < collisionMeshes.size(); i++) {
 		auto mesh = collisionMeshes[i];
 
-		bool isHoopsNet = false;
-
-		if (isHoops) { // Detect net mesh and disable car collision
-			const unsigned char* vertexBase;
-			int numVerts, stride;
-			const unsigned char* indexBase;
-			int indexStride, numFaces;
-			mesh->getMeshInterface()->getLockedReadOnlyVertexIndexBase(&vertexBase, numVerts, stride, &indexBase, indexStride, numFaces);
-			
-			constexpr int HOOPS_NET_NUM_VERTS = 505;
-			if (numVerts == HOOPS_NET_NUM_VERTS) {
-				isHoopsNet = true;
-			}
-		}
+		// Detect net mesh and disable car collision
+		bool isHoopsNet = isHoops && SuspensionCollisionGrid::IsHoopsNetMesh(mesh);
 
-		_AddStaticCollisionShape(i, i, mesh, _worldCollisionBvhShapes, btVector3(0,0,0), isHoopsNet);
+		if (shareShapes) {
+			_AddStaticCollisionRB(i, mesh, btVector3(0, 0, 0), isHoopsNet);
+		} else {
+			_AddStaticCollisionShape(i, i, mesh, _worldCollisionBvhShapes, btVector3(0, 0, 0), isHoopsNet);
 
-		// Don't free the BVH when we deconstruct this arena
-		_worldCollisionBvhShapes[i].m_ownsBvh = false;
+			// Don't free the BVH when we deconstruct this arena
+			_worldCollisionBvhShapes[i].m_ownsBvh = false;
+		}
 	}
 
-	{ // Add arena collision planes (floor/walls/ceiling)
-		using namespace RLConst;
+	// Add arena collision planes (floor/walls/ceiling)
+	for (size_t i = 0; i < planeAmount; i++) {
+		size_t rbIndex = collisionMeshes.size() + i;
+		btVector3 posBT = planePositions[i] * UU_TO_BT;
+		if (shareShapes) {
+			_AddStaticCollisionRB(rbIndex, &sharedPlaneShapes[i], posBT);
+		} else {
+			_AddStaticCollisionShape(rbIndex, i, &sharedPlaneShapes[i], _worldCollisionPlaneShapes, posBT);
+		}
+	}
+}
 
-		float 
-			extentX = isHoops ? ARENA_EXTENT_X_HOOPS : ARENA_EXTENT_X,
-			extentY = isHoops ? ARENA_EXTENT_Y_HOOPS : ARENA_EXTENT_Y,
-			height  = isHoops ? ARENA_HEIGHT_HOOPS : ARENA_HEIGHT;
+// With ArenaConfig::useArenaSDF, the arena meshes and planes are only there for raycasts
+// Their pairs are skipped, as contacts with them come from the SDF instead
+void _ArenaSDFNearCallback(btBroadphasePair& pair, btCollisionDispatcher& dispatcher, const btDispatcherInfo& dispatchInfo) {
+	for (btBroadphaseProxy* proxy : { pair.m_pProxy0, pair.m_pProxy1 }) {
+		int shapeType = ((btCollisionObject*)proxy->m_clientObject)->getCollisionShape()->getShapeType();
+		if (shapeType == TRIANGLE_MESH_SHAPE_PROXYTYPE || shapeType == STATIC_PLANE_PROXYTYPE)
+			return;
+	}
 
-		// TODO: This is all very repetitive and silly
+	btCollisionDispatcher::defaultNearCallback(pair, dispatcher, dispatchInfo);
+}
 
-		// Floor
-		auto floorShape = btStaticPlaneShape(btVector3(0, 0, 1), 0);
-		_AddStaticCollisionShape(
-			collisionMeshes.size() + 0,
-			0,
-			&floorShape, _worldCollisionPlaneShapes
-		);
-		
-		// Ceiling
-		auto ceilingShape = btStaticPlaneShape(btVector3(0, 0, -1), 0);
-		_AddStaticCollisionShape(
-			collisionMeshes.size() + 1,
-			1,
-			&ceilingShape, _worldCollisionPlaneShapes,
-			Vec(0, 0, height) * UU_TO_BT
+void Arena::_SetupArenaSDF() {
+	if (gameMode != GameMode::SOCCAR)
+		RS_ERR_CLOSE("ArenaConfig::useArenaSDF is only supported in soccar, not " << GAMEMODE_STRS[(int)gameMode]);
+
+	// The SDF doesn't change, so its error only needs to be measured once
+	static std::once_flag measureOnce;
+	static ArenaSDF::MeshError meshError;
+	std::call_once(measureOnce, [] {
+		meshError = ArenaSDF::MeasureMeshError(RocketSim::GetArenaCollisionShapes(GameMode::SOCCAR));
+		RS_LOG(
+			"RocketSim: Arena SDF is within " << meshError.p99 << "uu of 99% of the arena meshes " <<
+			"(mean: " << meshError.mean << "uu, max: " << meshError.max << "uu, samples: " << meshError.numSamples << ")"
 		);
+	});
 
-		// Side walls
-		auto leftWallShape = btStaticPlaneShape(btVector3(1, 0, 0), 0);
-		_AddStaticCollisionShape(
-			collisionMeshes.size() + 2,
-			2,
-			&leftWallShape, _worldCollisionPlaneShapes,
-			Vec(-extentX, 0, height / 2) * UU_TO_BT
-		);
-		auto rightWallShape = btStaticPlaneShape(btVector3(-1, 0, 0), 0);
-		_AddStaticCollisionShape(
-			collisionMeshes.size() + 3,
-			3,
-			&rightWallShape, _worldCollisionPlaneShapes,
-			Vec(extentX, 0, height / 2) * UU_TO_BT
+	if (meshError.p99 > _config.arenaSDFMaxError) {
+		RS_ERR_CLOSE(
+			"Arena SDF is too far from the arena meshes (" << meshError.p99 << "uu at 99% of their area, " <<
+			"ArenaConfig::arenaSDFMaxError is " << _config.arenaSDFMaxError << "uu)"
 		);
+	}
+
+	_worldSDFShape = new btArenaSDFShape();
+	_worldSDFRB = new btRigidBody(0, NULL, _worldSDFShape);
+	_worldSDFRB->setWorldTransform(btTransform::getIdentity());
+	_worldSDFRB->setUserPointer(this);
+	_bulletWorld.addRigidBody(_worldSDFRB);
+
+	btArenaSDFAlgorithm::Register(&_bulletWorldParams.collisionDispatcher);
+	_bulletWorldParams.collisionDispatcher.setNearCallback(_ArenaSDFNearCallback);
+}
+
+void Arena::TakeSnapshot(ArenaSnapshot& snapshot) const {
+	snapshot.tickCount = tickCount;
+	snapshot.ballState = ball->GetState();
+
+	auto fnFindCarIndex = [&](uint32_t id) -> int {
+		for (int i = 0; i < _cars.size(); i++)
+			if (_cars[i]->id == id)
+				return i;
+		return -1;
+	};
+
+	snapshot.cars.resize(_cars.size());
+	for (int i = 0; i < _cars.size(); i++) {
+		Car* car = _cars[i];
+		auto& carData = snapshot.cars[i];
+		carData.state = car->GetState();
+		carData.controls = car->controls;
+		for (int j = 0; j < 4; j++)
+			carData.wheels[j] = car->_bulletVehicle.m_wheelInfo[j];
+	}
 
-		if (isHoops) {
-			// Y walls
-			auto blueWallShape = btStaticPlaneShape(btVector3(0, 1, 0), 0);
-			_AddStaticCollisionShape(
-				collisionMeshes.size() + 4,
-				4,
-				&blueWallShape, _worldCollisionPlaneShapes,
-				Vec(0, -extentY, height / 2) * UU_TO_BT
-			);
-			auto orangeWallShape = btStaticPlaneShape(btVector3(0, -1, 0), 0);
-			_AddStaticCollisionShape(
-				collisionMeshes.size() + 5,
-				5,
-				&orangeWallShape, _worldCollisionPlaneShapes,
-				Vec(0, extentY, height / 2) * UU_TO_BT
-			);
+	snapshot.boostPads.resize(_boostPads.size());
+	for (int i = 0; i < _boostPads.size(); i++) {
+		auto& padState = _boostPads[i]->_internalState;
+		auto& padData = snapshot.boostPads[i];
+		padData.state = padState;
+		padData.lockedCarIndex = padState.curLockedCar ? fnFindCarIndex(padState.curLockedCar->id) : -1;
+		padData.prevLockedCarIndex = padState.prevLockedCarID ? fnFindCarIndex(padState.prevLockedCarID) : -1;
+	}
+}
+
+void Arena::RestoreSnapshot(const ArenaSnapshot& snapshot) {
+	constexpr char ERROR_PREFIX[] = "Arena::RestoreSnapshot(): ";
+
+	if (snapshot.cars.size() != _cars.size())
+		RS_ERR_CLOSE(ERROR_PREFIX << "Snapshot has " << snapshot.cars.size() << " cars, but arena has " << _cars.size());
+	if (snapshot.boostPads.size() != _boostPads.size())
+		RS_ERR_CLOSE(ERROR_PREFIX << "Snapshot has " << snapshot.boostPads.size() << " boost pads, but arena has " << _boostPads.size());
+
+	// Ticks of valid ball hits are moved by the difference in tick count, unset ones stay unset
+	uint64_t tickOffset = tickCount - snapshot.tickCount;
+	auto fnShiftTick = [&](uint64_t& tick) {
+		if (tick != ~0ULL)
+			tick += tickOffset;
+	};
+
+	for (int i = 0; i < _cars.size(); i++) {
+		Car* car = _cars[i];
+		auto& carData = snapshot.cars[i];
+
+		CarState state = carData.state;
+		fnShiftTick(state.ballHitInfo.tickCountWhenHit);
+		fnShiftTick(state.ballHitInfo.tickCountWhenExtraImpulseApplied);
+		car->SetState(state);
+		car->controls = carData.controls;
+
+		for (int j = 0; j < 4; j++) {
+			auto& wheel = car->_bulletVehicle.m_wheelInfo[j];
+			void* clientInfo = wheel.m_clientInfo;
+			wheel = carData.wheels[j];
+			wheel.m_clientInfo = clientInfo;
+			wheel.m_raycastInfo.m_groundObject = NULL; // Set again by the next raycast
 		}
 	}
+
+	ball->SetState(snapshot.ballState);
+
+	// Restored cars have different ball hits
+	for (auto& touches : _teamBallTouches)
+		touches.isValid = false;
+
+	for (int i = 0; i < _boostPads.size(); i++) {
+		auto& padData = snapshot.boostPads[i];
+		BoostPadState padState = padData.state;
+		padState.curLockedCar = (padData.lockedCarIndex >= 0) ? _cars[padData.lockedCarIndex] : NULL;
+		padState.prevLockedCarID = (padData.prevLockedCarIndex >= 0) ? _cars[padData.prevLockedCarIndex]->id : 0;
+		_boostPads[i]->SetState(padState);
+	}
 }
 
 RS_NS_END
\ No newline at end of file
@@ -10,6 +10,11 @@
 #include "../SuspensionCollisionGrid/SuspensionCollisionGrid.h"
 #include "../MutatorConfig/MutatorConfig.h"
 #include "ArenaConfig/ArenaConfig.h"
+#include "ArenaProfile/ArenaProfile.h"
+#include "ArenaTaskPool/ArenaTaskPool.h"
+#include "ArenaSlab/ArenaSlab.h"
+#include "ArenaSDF/ArenaSDF.h"
+#include "AdaptiveStepConfig/AdaptiveStepConfig.h"
 
 #include "../../../libsrc/bullet3-3.24/BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
 #include "../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btStaticPlaneShape.h"
@@ -24,6 +29,43 @@ RS_NS_START
 typedef std::function<void(class Arena* arena, Team scoringTeam, void* userInfo)> GoalScoreEventFn;
 typedef std::function<void(class Arena* arena, Car* bumper, Car* victim, bool isDemo, void* userInfo)> CarBumpEventFn;
 
+// An event recorded into an arena's event queue, as plain data (see Arena::queueEvents)
+struct ArenaEvent {
+	enum class Type : uint8_t {
+		BUMP,
+		DEMO,
+		SHOT, // From GameEventTracker
+		GOAL, // From GameEventTracker
+		SAVE // From GameEventTracker
+	};
+
+	Type type;
+	uint32_t carID; // Bumper, shooter, scorer or saver
+	uint32_t otherCarID; // Victim or passer, 0 if none
+};
+
+// Dynamic state of an arena's cars, ball and boost pads, as plain data
+// Used to quickly reset arenas to prebaked states, see Arena::TakeSnapshot() and Arena::RestoreSnapshot()
+struct ArenaSnapshot {
+	struct CarData {
+		CarState state;
+		CarControls controls;
+		btWheelInfoRL wheels[4]; // Includes suspension state
+	};
+
+	struct BoostPadData {
+		BoostPadState state;
+		// Index of the pad's locked cars in cars, or -1
+		// Stored instead of pointers/IDs so the snapshot can be restored to other arenas
+		int lockedCarIndex, prevLockedCarIndex;
+	};
+
+	uint64_t tickCount = 0; // Tick count of the arena when taken, not restored
+	BallState ballState;
+	std::vector<CarData> cars; // In the arena's car order
+	std::vector<BoostPadData> boostPads;
+};
+
 // The container for all game simulation
 // Stores cars, the ball, all arena collisions, and manages the overall game state
 class Arena {
@@ -32,9 +74,11 @@ public:
 	GameMode gameMode;
 
 	uint32_t _lastCarID = 0;
-	std::unordered_set<Car*> _cars;
+	// In the order they were added, so iteration order is the same every run
+	std::vector<Car*> _cars;
 	bool ownsCars = true; // If true, deleting this arena instance deletes all cars
 
+	// Only used to find cars by ID
 	std::unordered_map<uint32_t, Car*> _carIDMap;
 	
 	Ball* ball;
@@ -63,7 +107,11 @@ public:
 	// Total ticks this arena instance has been simulated for, never resets
 	uint64_t tickCount = 0;
 
-	const std::unordered_set<Car*>& GetCars() { return _cars; }
+	// Where the time of our steps went, only measured if RocketSim is built with RS_PROFILE
+	// Never resets on its own, reset it by assigning {}
+	ArenaProfile profile = {};
+
+	const std::vector<Car*>& GetCars() { return _cars; }
 	const std::vector<BoostPad*>& GetBoostPads() { return _boostPads; }
 
 	// Returns true if added, false if car was already added
@@ -81,6 +129,10 @@ public:
 
 	RSAPI Car* GetCar(uint32_t id);
 
+	// Pools our collision config allocates from, if shared with other arenas
+	// Declared before the Bullet world, so that they outlive everything in it
+	std::shared_ptr<ArenaCollisionPools> _collisionPools = NULL;
+
 	btDiscreteDynamicsWorld _bulletWorld;
 	struct {
 		btDefaultCollisionConfiguration collisionConfig;
@@ -95,6 +147,10 @@ public:
 	btBvhTriangleMeshShape* _worldCollisionBvhShapes;
 	btStaticPlaneShape* _worldCollisionPlaneShapes;
 
+	// Only used with ArenaConfig::useArenaSDF
+	btArenaSDFShape* _worldSDFShape = NULL;
+	btRigidBody* _worldSDFRB = NULL;
+
 	struct {
 		GoalScoreEventFn func = NULL;
 		void* userInfo = NULL;
@@ -107,6 +163,21 @@ public:
 	} _carBumpCallback;
 	RSAPI void SetCarBumpCallback(CarBumpEventFn callbackFn, void* userInfo = NULL);
 
+	// If true, bumps and demos are also appended to _eventQueue, as are the events of a GameEventTracker updated with us
+	// The queue keeps growing until its owner drains it, so only enable this if something clears it regularly
+	bool queueEvents = false;
+	std::vector<ArenaEvent> _eventQueue = {};
+
+	// Latest ball touches of each team, updated by car-ball collisions so finding who last touched the ball doesn't need to loop over every car
+	// Index 0 is the last car of the team to touch the ball, index 1 is the last different car before it (car ID 0 if none)
+	// Setting car states can make this out of date, so check it against the car's ballHitInfo before trusting it
+	// If isValid is false, it needs to be rebuilt from the cars (see GameEventTracker)
+	struct TeamBallTouches {
+		bool isValid = true;
+		uint32_t carIDs[2] = {};
+		uint64_t ticks[2] = {};
+	} _teamBallTouches[2] = {};
+
 	// NOTE: Arena should be destroyed after use
 	RSAPI static Arena* Create(GameMode gameMode, const ArenaConfig& arenaConfig = {}, float tickRate = 120);
 	
@@ -125,14 +196,79 @@ public:
 	// Get a deep copy of the arena
 	RSAPI Arena* Clone(bool copyCallbacks);
 
+	// Creates a lightweight child arena for lookahead (searching, sampling actions, etc.)
+	// Shares this arena's static world collision, and starts with a copy of its cars and state
+	// Forking still builds a Bullet world, so keep forks around and roll them back with CopyStateTo() or RestoreSnapshot()
+	// NOTE: Callbacks and car update threads are not copied
+	RSAPI Arena* Fork() const;
+
+	// Copies the current dynamic state and tick count of this arena into another with the same car and boost pad amounts, such as a fork of it
+	// The other arena's overlapping pairs and contacts are reset to those of a new arena, so the same inputs always simulate the same way from the copied state
+	RSAPI void CopyStateTo(Arena* other) const;
+
+	// Reused by CopyStateTo() when copying into this arena
+	ArenaSnapshot _copyStateSnapshot;
+
+	// Removes all cached contact points, so the next tick doesn't depend on contacts from previous ones
+	void _ClearContactCache();
+
+	// Re-adds the ball and cars to the Bullet world in the order a new arena adds them
+	// This drops all of their overlapping pairs and contacts, so new ones are made in the same order as in a new arena
+	void _ResetDynamicBodies();
+
 	// NOTE: Car ID will not be restored
 	RSAPI Car* DeserializeNewCar(DataStreamIn& in, Team team);
 
 	// Simulate everything in the arena for a given number of ticks
 	RSAPI void Step(int ticksToSimulate = 1);
 
+	// Same as calling Step() on each arena in order, with identical results, but each tick runs one phase of every arena before the next phase
+	//	(car pre-tick, Bullet step, car post-tick, boost pads, then ball finish and goal checks)
+	// Each phase then runs the same code over many arenas in a row, which keeps it in the instruction cache and branch predictors
+	// Arenas that could respawn a car during the step are stepped on their own first, as respawning draws from the shared random generator
+	// NOTE: Callbacks of different arenas are interleaved, so they must not depend on the order that arenas are stepped in
+	RSAPI static void StepMultiple(Arena* const* arenas, size_t amount, int ticksToSimulate = 1);
+
+	// Returns true if a car could respawn within this many ticks, which draws from the shared random generator
+	bool _MayRespawnCarsWithin(int ticks) const;
+
+	// Same as Step(), but ticks where the arena is quiet are combined into larger substeps (see AdaptiveStepConfig)
+	// Only soccar arenas use larger substeps, other game modes are stepped normally
+	// NOTE: This is approximate, the arena will drift from where Step() would have taken it
+	RSAPI void StepAdaptive(int ticksToSimulate, const AdaptiveStepConfig& config);
+
+	// Where StepAdaptive() used larger substeps
+	// NOTE: Not copied by Clone()
+	AdaptiveStepStats adaptiveStepStats = {};
+
+	// Returns true if nothing can start or stop touching anything within this much time (see AdaptiveStepConfig)
+	bool _IsQuietFor(float time, const AdaptiveStepConfig& config) const;
+
+	// Runs the per-car parts of each tick on this many threads (including the one stepping), 1 to disable
+	// Results are identical either way, this is only worth it for a few arenas with many cars
+	// NOTE: Not copied by Clone()
+	RSAPI void SetCarUpdateThreads(int numThreads);
+
+	ArenaTaskPool* _carTaskPool = NULL;
+
+	// Current while we are constructed, add cars, and step, NULL if ArenaConfig::slabKB is 0
+	// Released when we are destroyed, it is then freed once everything allocated from it is
+	ArenaSlab* _slab = NULL;
+
+	// Casts the wheel rays that need Bullet ahead of time, since Bullet's ray tests can't run on multiple threads
+	// Returns false if the cars can't update in parallel this tick
+	bool _PrepareParallelCarUpdate();
+
 	RSAPI void ResetToRandomKickoff(int seed = -1);
 
+	// Copies the dynamic state of everything in the arena into the snapshot, reusing its memory
+	RSAPI void TakeSnapshot(ArenaSnapshot& snapshot) const;
+
+	// Copies a snapshot back into the arena, which must have the same car and boost pad amounts
+	// Can be restored to any such arena, cars are matched by their order
+	// The tick count is not restored, ball hit tick counts are shifted to match this arena's tick count instead
+	RSAPI void RestoreSnapshot(const ArenaSnapshot& snapshot);
+
 	// Returns true if the ball is probably going in, does not account for wall or ceiling bounces
 	// NOTE: Purposefully overestimates, just like the real RL's shot prediction
 	// To check which goal it will score in, use the ball's velocity
@@ -143,6 +279,9 @@ public:
 	// Works for all gamemodes (and does nothing in THE_VOID)
 	RSAPI bool IsBallScored() const;
 
+	// How full our collision pools are, and how often they have overflowed
+	RSAPI ArenaCollisionPoolStats GetCollisionPoolStats() const;
+
 	// Free all associated memory
 	RSAPI ~Arena();
 
@@ -155,9 +294,15 @@ public:
 		static_assert(std::is_base_of<btCollisionShape, T>::value);
 		meshList[meshListIndex] = *shape;
 
+		return _AddStaticCollisionRB(rbIndex, &meshList[meshListIndex], posBT, isHoopsNet);
+	}
+
+	// Adds a static rigid body using the shape directly, without copying it
+	// NOTE: The shape must outlive this arena, and will not be freed by it
+	btRigidBody* _AddStaticCollisionRB(size_t rbIndex, btCollisionShape* shape, btVector3 posBT = btVector3(0, 0, 0), bool isHoopsNet = false) {
 		assert(rbIndex < _worldCollisionRBAmount);
 		btRigidBody& shapeRB = _worldCollisionRBs[rbIndex];
-		shapeRB = btRigidBody(0, NULL, &meshList[meshListIndex]);
+		shapeRB = btRigidBody(0, NULL, shape);
 		shapeRB.setWorldTransform(btTransform(btMatrix3x3::getIdentity(), posBT));
 		shapeRB.setUserPointer(this);
 		if (isHoopsNet) {
@@ -169,6 +314,7 @@ public:
 	}
 
 	void _SetupArenaCollisionShapes();
+	void _SetupArenaSDF();
 
 	// Static function called by Bullet internally when adding a collision point
 	static bool _BulletContactAddedCallback(
@@ -190,6 +336,31 @@ public:
 		return _config.memWeightMode;
 	}
 
+	// Simulates one tick, with everything that depends on the game mode or having cars decided at compile time
+	// Runs each phase below in order, StepMultiple() runs them separately
+	template<GameMode GAME_MODE, bool BALL_ONLY>
+	void _StepTick();
+
+	template<GameMode GAME_MODE, bool BALL_ONLY> void _StepTickPre(); // Suspension grid, wheel ray precasts, car and ball pre-tick
+	template<GameMode GAME_MODE, bool BALL_ONLY> void _StepTickBullet();
+	template<GameMode GAME_MODE, bool BALL_ONLY> void _StepTickCarsPost(); // Car post-tick and finishing
+	template<GameMode GAME_MODE, bool BALL_ONLY> void _StepTickPads();
+	template<GameMode GAME_MODE, bool BALL_ONLY> void _StepTickFinish(); // Ball finishing, goal checks, and the tick count
+	constexpr static int STEP_TICK_PHASE_AMOUNT = 5;
+
+	typedef void(Arena::*StepTickFn)();
+	struct StepTickFns {
+		StepTickFn fns[2]; // Indexed by whether the arena has no cars
+		StepTickFn phaseFns[2][STEP_TICK_PHASE_AMOUNT]; // Same, for each phase of _StepTick()
+	};
+	static StepTickFns _GetStepTickFns(GameMode gameMode);
+
+	// Picked once for our game mode when we're constructed
+	StepTickFns _stepTickFns;
+
+	// Whether the current tick of StepMultiple() runs the ball-only phases, kept from its start as callbacks can add or remove cars
+	bool _tickBallOnly = false;
+
 private:
 	
 	// Constructor for use by Arena::Create()
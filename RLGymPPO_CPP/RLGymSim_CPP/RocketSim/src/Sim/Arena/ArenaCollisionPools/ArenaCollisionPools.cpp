@@ -0,0 +1,69 @@
+#include "ArenaCollisionPools.h"
+#include "../ArenaSlab/ArenaSlab.h"
+
+#include "../../../../libsrc/bullet3-3.24/LinearMath/btPoolAllocator.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+
+RS_NS_START
+
+thread_local std::shared_ptr<ArenaCollisionPools> _curPools = NULL;
+
+// Pieces of world collision a car or the ball can be near at once (i.e. a corner, or the ground under a wall)
+constexpr int WORLD_PAIRS_PER_OBJECT = 4;
+
+int ArenaCollisionPools::GetManifoldAmount(int carAmount) {
+	// Every pair of cars and the ball, and each of them near the world
+	int objectAmount = RS_MAX(carAmount, 0) + 1;
+	int pairAmount = (objectAmount * (objectAmount - 1)) / 2 + objectAmount * WORLD_PAIRS_PER_OBJECT;
+
+	// Twice that, overlaps of AABBs are a lot more common than contacts, but pile-ups still happen
+	return pairAmount * 2;
+}
+
+int ArenaCollisionPools::GetAlgorithmAmount(int carAmount) {
+	// Every overlapping pair has an algorithm, contact or not, and compound shapes create child algorithms on top
+	// Measured at around 3 per manifold in use
+	return GetManifoldAmount(carAmount) * 3;
+}
+
+btPoolAllocator* _CreatePool(int elemSize, int maxElements) {
+	void* mem = btAlignedAlloc(sizeof(btPoolAllocator), 16);
+	return new (mem) btPoolAllocator(elemSize, maxElements);
+}
+
+void _DestroyPool(btPoolAllocator* pool) {
+	pool->~btPoolAllocator();
+	btAlignedFree(pool);
+}
+
+ArenaCollisionPools::ArenaCollisionPools(int arenaAmount, int carAmount) {
+	arenaAmount = RS_MAX(arenaAmount, 1);
+
+	ArenaSlab::Scope slabScope = ArenaSlab::Scope(NULL);
+	manifoldPool = _CreatePool(sizeof(btPersistentManifold), GetManifoldAmount(carAmount) * arenaAmount);
+	algorithmPool = _CreatePool(
+		btDefaultCollisionConfiguration::getCollisionAlgorithmPoolElementSize(),
+		GetAlgorithmAmount(carAmount) * arenaAmount
+	);
+}
+
+ArenaCollisionPools::~ArenaCollisionPools() {
+	_DestroyPool(manifoldPool);
+	_DestroyPool(algorithmPool);
+}
+
+ArenaCollisionPools::Scope::Scope(std::shared_ptr<ArenaCollisionPools> pools) {
+	prevPools = _curPools;
+	_curPools = pools;
+}
+
+ArenaCollisionPools::Scope::~Scope() {
+	_curPools = prevPools;
+}
+
+std::shared_ptr<ArenaCollisionPools> ArenaCollisionPools::_GetCurrent() {
+	return _curPools;
+}
+
+RS_NS_END
\ No newline at end of file
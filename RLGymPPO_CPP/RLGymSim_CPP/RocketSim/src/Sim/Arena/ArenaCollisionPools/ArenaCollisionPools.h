@@ -0,0 +1,59 @@
+#pragma once
+#include "../../../BaseInc.h"
+
+#include <memory>
+
+class btPoolAllocator;
+
+RS_NS_START
+
+// Bullet's pools of persistent manifolds (contacts) and collision algorithms, that an arena's collisions are allocated from
+// Arenas normally own their pools, but arenas that are always stepped by the same thread can share pools,
+//	so memory spent on contacts scales with threads instead of arenas
+// Bullet allocates past the pools when they are full, which each arena counts (see Arena::GetCollisionPoolStats())
+// NOTE: Bullet's pools are not thread-safe, arenas sharing pools must never be stepped or created at the same time
+struct ArenaCollisionPools {
+	btPoolAllocator* manifoldPool;
+	btPoolAllocator* algorithmPool;
+
+	// Pool sizes needed by one arena with this many cars
+	RSAPI static int GetManifoldAmount(int carAmount);
+	RSAPI static int GetAlgorithmAmount(int carAmount);
+
+	// Sized for arenaAmount arenas with carAmount cars each
+	// Pools are always allocated on the heap, not in the slab of the current arena
+	RSAPI ArenaCollisionPools(int arenaAmount, int carAmount);
+	RSAPI ~ArenaCollisionPools();
+
+	// Arenas created on this thread while a scope is active share its pools, unless their config gives other ones
+	// Scopes can be nested, pools can be NULL to make arenas create their own again
+	struct Scope {
+		std::shared_ptr<ArenaCollisionPools> prevPools;
+
+		RSAPI Scope(std::shared_ptr<ArenaCollisionPools> pools);
+		RSAPI ~Scope();
+
+		Scope(const Scope& other) = delete;
+		Scope& operator=(const Scope& other) = delete;
+	};
+
+	// Pools of the current scope of this thread, or NULL
+	static std::shared_ptr<ArenaCollisionPools> _GetCurrent();
+
+	// No copying
+	ArenaCollisionPools(const ArenaCollisionPools& other) = delete;
+	ArenaCollisionPools& operator=(const ArenaCollisionPools& other) = delete;
+};
+
+// Usage of an arena's collision pools
+struct ArenaCollisionPoolStats {
+	// If the pools are shared, these are for all of the arenas sharing them
+	int manifoldsUsed, manifoldPoolSize;
+	int algorithmsUsed, algorithmPoolSize;
+	bool shared;
+
+	// Allocations of this arena that didn't fit in the pools and went to the heap, since the arena was created
+	uint64_t manifoldOverflows, algorithmOverflows;
+};
+
+RS_NS_END
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "../../../Math/MathTypes/MathTypes.h"
 #include "../../../DataStream/DataStreamOut.h"
 #include "../../../DataStream/DataStreamIn.h"
+#include "../ArenaCollisionPools/ArenaCollisionPools.h"
+#include "../../../HugePages/HugePages.h"
 
 RS_NS_START
 
@@ -9,10 +11,19 @@ RS_NS_START
 // Will affect whether high memory consumption is used to slightly increase speed or not
 enum class ArenaMemWeightMode : byte {
 	HEAVY, // ~1,263KB per arena with 4 cars
-	LIGHT  // ~383KB per arena with 4 cars
+	LIGHT, // ~383KB per arena with 4 cars
 	// Measurements last updated 2024/5/9
+
+	// Like LIGHT, but with even smaller collision pools (Bullet allocates past them when needed),
+	//	and world collision shapes are shared by all ULTRALIGHT arenas instead of copied into each one
+	// Use this when running thousands of arenas at once
+	ULTRALIGHT
 };
 
+constexpr bool IsLightMemWeightMode(ArenaMemWeightMode mode) {
+	return mode != ArenaMemWeightMode::HEAVY;
+}
+
 struct ArenaConfig {
 
 	ArenaMemWeightMode memWeightMode = ArenaMemWeightMode::LIGHT;
@@ -38,11 +49,40 @@ struct ArenaConfig {
 	// Maximum number of objects
 	int maxObjects = 512;
 
+	// Car and ball contacts with the arena come from an analytic model of it (see ArenaSDF), instead of Bullet against the arena meshes
+	// Much faster than the meshes, but only approximates their curves, so contacts on them differ slightly
+	// The meshes are still used for suspension raycasts
+	// Only supported in soccar
+	bool useArenaSDF = false;
+
+	// With useArenaSDF, 99% of the soccar meshes' area must be within this many UU of the model's surface, otherwise creating the arena fails
+	// The meshes are only checked once per process
+	float arenaSDFMaxError = 40;
+
+	// Size of the memory slab that the arena's objects and Bullet pools are allocated from (see ArenaSlab), in KB
+	// Allocations past it go to the heap as usual, set to 0 to allocate everything on the heap
+	// Not serialized, as it doesn't change the simulation
+	uint32_t slabKB = 512;
+
+	// Pages to back the arena's slab with (see HugePageMode), only used if slabKB is not 0
+	// Huge pages round the slab up to a multiple of 2MB, so this is mostly worth it with a larger slabKB
+	// Not serialized, as it doesn't change the simulation
+	HugePageMode slabHugePages = HugePageMode::NONE;
+
+	// Collision pools to share with other arenas stepped by the same thread (see ArenaCollisionPools)
+	// If NULL, the pools of the thread's current ArenaCollisionPools::Scope are used, if there is one
+	// Not serialized, and not passed on to clones or forks of the arena
+	std::shared_ptr<ArenaCollisionPools> collisionPools = NULL;
+
+	// If the arena has its own pools, they are sized for this many cars instead of by memWeightMode
+	// Set to 0 to size by memWeightMode, not serialized
+	int expectedCars = 0;
+
 	RSAPI void Serialize(DataStreamOut& out) const;
 	RSAPI void Deserialize(DataStreamIn& in);
 };
 
 #define ARENA_CONFIG_SERIALIZATION_FIELDS \
-minPos, maxPos, maxAABBLen, noBallRot, useCustomBroadphase
+minPos, maxPos, maxAABBLen, noBallRot, useCustomBroadphase, useArenaSDF
 
 RS_NS_END
\ No newline at end of file
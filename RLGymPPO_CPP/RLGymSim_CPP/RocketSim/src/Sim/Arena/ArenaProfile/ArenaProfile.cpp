@@ -0,0 +1,37 @@
+#include "ArenaProfile.h"
+
+RS_NS_START
+
+double ArenaProfile::GetTimestampsPerSecond() {
+#ifdef RS_PROFILE_HAS_TSC
+	static double rate = [] {
+		auto startTime = std::chrono::steady_clock::now();
+		uint64_t startStamp = __rdtsc();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		uint64_t endStamp = __rdtsc();
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		return (endStamp - startStamp) / elapsed;
+	}();
+	return rate;
+#else
+	return 1e9;
+#endif
+}
+
+const char* ArenaProfile::GetPhaseName(ArenaProfilePhase phase) {
+	constexpr const char* NAMES[] = {
+		"Suspension Grid",
+		"Car Pre-Tick",
+		"Ball Pre-Tick",
+		"Bullet Step",
+		"Car Post-Tick",
+		"Boost Pads",
+		"Ball Finish",
+		"Goal Check"
+	};
+	static_assert(sizeof(NAMES) / sizeof(*NAMES) == (int)ArenaProfilePhase::AMOUNT);
+
+	return NAMES[(int)phase];
+}
+
+RS_NS_END
\ No newline at end of file
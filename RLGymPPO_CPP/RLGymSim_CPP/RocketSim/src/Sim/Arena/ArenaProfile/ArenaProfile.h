@@ -0,0 +1,81 @@
+#pragma once
+#include "../../../BaseInc.h"
+
+#if defined(RS_PROFILE) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define RS_PROFILE_HAS_TSC
+#endif
+
+RS_NS_START
+
+// Phases of Arena::Step(), in the order they run
+enum class ArenaProfilePhase : byte {
+	SUSP_COL_GRID,		// Adding dynamic bodies to the suspension grid, and casting wheel rays ahead of time
+	CAR_PRE_TICK,
+	BALL_PRE_TICK,
+	BULLET_STEP,		// btDiscreteDynamicsWorld::stepSimulation()
+	CAR_POST_TICK,		// Car post-tick and finishing
+	BOOST_PADS,			// Boost pad cooldowns, pickups, and boost giving
+	BALL_FINISH,
+	GOAL_CHECK,
+
+	AMOUNT
+};
+
+// Where the time of an arena's steps went, since it was last reset
+// Only measured if RocketSim is built with RS_PROFILE, otherwise this stays empty
+// Times are in timestamps (see GetTimestampsPerSecond())
+struct ArenaProfile {
+	uint64_t phaseTimes[(int)ArenaProfilePhase::AMOUNT] = {};
+	uint64_t
+		ticks = 0,
+		contactPoints = 0, // Contact points in Bullet's manifolds after each tick
+		broadphasePairs = 0, // Overlapping broadphase pairs after each tick
+		suspensionRays = 0, // Wheel rays used by the cars
+		suspensionBulletRays = 0; // Wheel rays that needed a Bullet ray test
+
+	uint64_t GetTotalTime() const {
+		uint64_t total = 0;
+		for (uint64_t time : phaseTimes)
+			total += time;
+		return total;
+	}
+
+	ArenaProfile& operator+=(const ArenaProfile& other) {
+		for (int i = 0; i < (int)ArenaProfilePhase::AMOUNT; i++)
+			phaseTimes[i] += other.phaseTimes[i];
+		ticks += other.ticks;
+		contactPoints += other.contactPoints;
+		broadphasePairs += other.broadphasePairs;
+		suspensionRays += other.suspensionRays;
+		suspensionBulletRays += other.suspensionBulletRays;
+		return *this;
+	}
+
+	static bool IsEnabled() {
+#ifdef RS_PROFILE
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	static uint64_t GetTimestamp() {
+#ifdef RS_PROFILE_HAS_TSC
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	// Rate of GetTimestamp(), the TSC rate is measured on the first call
+	RSAPI static double GetTimestampsPerSecond();
+
+	RSAPI static const char* GetPhaseName(ArenaProfilePhase phase);
+};
+
+RS_NS_END
\ No newline at end of file
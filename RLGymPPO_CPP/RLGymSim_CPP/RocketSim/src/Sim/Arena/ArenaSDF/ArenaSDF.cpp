@@ -0,0 +1,244 @@
+#include "ArenaSDF.h"
+
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btSphereShape.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btBoxShape.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btManifoldResult.h"
+
+RS_NS_START
+
+namespace {
+	// A side of a convex region, which is inside where Dot(normal, pos) < offset
+	struct SDFPlane {
+		Vec normal; // Points out of the region
+		float offset;
+	};
+
+	// Distance into a convex region whose edges are rounded by radius (negative if outside)
+	// The region is the planes moved in by radius, grown by radius in every direction
+	// NOTE: Near the edges of planes that aren't perpendicular, distances outside of the moved-in planes are approximate
+	template <size_t N>
+	float _GetRoundedRegionDist(const SDFPlane(&planes)[N], float radius, Vec pos, Vec& normalOut) {
+		float maxPlaneDist = -FLT_MAX;
+		int maxPlaneIdx = 0;
+		float outsideDistSq = 0;
+		Vec outsideDir = Vec(0, 0, 0);
+		for (size_t i = 0; i < N; i++) {
+			float planeDist = planes[i].normal.Dot(pos) - planes[i].offset + radius;
+			if (planeDist > maxPlaneDist) {
+				maxPlaneDist = planeDist;
+				maxPlaneIdx = i;
+			}
+			if (planeDist > 0) {
+				outsideDistSq += planeDist * planeDist;
+				outsideDir += planes[i].normal * planeDist;
+			}
+		}
+
+		if (outsideDistSq > 0) {
+			float outsideDist = sqrtf(outsideDistSq);
+			normalOut = outsideDir / -outsideDist;
+			return radius - outsideDist;
+		} else {
+			normalOut = -planes[maxPlaneIdx].normal;
+			return radius - maxPlaneDist;
+		}
+	}
+}
+
+float ArenaSDF::GetDist(Vec pos, Vec& normalOut) {
+	using namespace RLConst;
+
+	// The arena is symmetrical on X and Y, so we solve it for positive X and Y
+	float signX = pos.x >= 0 ? 1 : -1, signY = pos.y >= 0 ? 1 : -1;
+	Vec absPos = Vec(abs(pos.x), abs(pos.y), pos.z);
+
+	constexpr float SQRT_HALF = (float)M_SQRT1_2;
+	static const SDFPlane ARENA_PLANES[] = {
+		{ Vec(0, 0, -1), 0 },
+		{ Vec(0, 0, 1), ARENA_HEIGHT },
+		{ Vec(1, 0, 0), ARENA_EXTENT_X },
+		{ Vec(0, 1, 0), ARENA_EXTENT_Y },
+		{ Vec(SQRT_HALF, SQRT_HALF, 0), CORNER_XY_SUM * SQRT_HALF },
+	};
+
+	// Starts EDGE_RADIUS before the back wall, so the floor of the goal mouth isn't curved
+	static const SDFPlane GOAL_PLANES[] = {
+		{ Vec(0, 0, -1), 0 },
+		{ Vec(0, 0, 1), GOAL_HEIGHT },
+		{ Vec(1, 0, 0), GOAL_HALF_WIDTH },
+		{ Vec(0, 1, 0), ARENA_EXTENT_Y + GOAL_DEPTH },
+		{ Vec(0, -1, 0), -(ARENA_EXTENT_Y - EDGE_RADIUS) },
+	};
+
+	Vec arenaNormal, goalNormal;
+	float arenaDist = _GetRoundedRegionDist(ARENA_PLANES, EDGE_RADIUS, absPos, arenaNormal);
+	float goalDist = _GetRoundedRegionDist(GOAL_PLANES, 0, absPos, goalNormal);
+
+	// Union of the two, so the distance is the larger one
+	float dist;
+	Vec absNormal;
+	if (arenaDist >= goalDist) {
+		dist = arenaDist;
+		absNormal = arenaNormal;
+	} else {
+		dist = goalDist;
+		absNormal = goalNormal;
+	}
+
+	normalOut = Vec(absNormal.x * signX, absNormal.y * signY, absNormal.z);
+	return dist;
+}
+
+namespace {
+	struct MeshErrorCallback : public btTriangleCallback {
+		std::vector<std::pair<float, float>> errorWeights = {};
+
+		virtual void processTriangle(btVector3* triangle, int partId, int triangleIndex) {
+			Vec verts[3];
+			for (int i = 0; i < 3; i++)
+				verts[i] = Vec(triangle[i]) * BT_TO_UU;
+
+			float area = (verts[1] - verts[0]).Cross(verts[2] - verts[0]).Length() / 2;
+			if (area <= 0)
+				return;
+
+			Vec samples[4] = { verts[0], verts[1], verts[2], (verts[0] + verts[1] + verts[2]) / 3 };
+			for (Vec& sample : samples) {
+				Vec normal;
+				float error = abs(ArenaSDF::GetDist(sample, normal));
+				errorWeights.push_back({ error, area / 4 });
+			}
+		}
+	};
+}
+
+ArenaSDF::MeshError ArenaSDF::MeasureMeshError(const std::vector<btBvhTriangleMeshShape*>& meshes) {
+	MeshErrorCallback callback = {};
+	btVector3 aabbMin = btVector3(-1, -1, -1) * 1e6f, aabbMax = btVector3(1, 1, 1) * 1e6f;
+	for (auto mesh : meshes)
+		mesh->processAllTriangles(&callback, aabbMin, aabbMax);
+
+	MeshError result = {};
+	auto& errorWeights = callback.errorWeights;
+	result.numSamples = errorWeights.size();
+	if (errorWeights.empty())
+		return result;
+
+	std::sort(errorWeights.begin(), errorWeights.end());
+
+	double totalWeight = 0, totalError = 0;
+	for (auto& pair : errorWeights) {
+		totalWeight += pair.second;
+		totalError += pair.first * pair.second;
+	}
+
+	result.mean = totalError / totalWeight;
+	result.max = errorWeights.back().first;
+
+	double p99Weight = totalWeight * 0.99, weightSoFar = 0;
+	result.p99 = result.max;
+	for (auto& pair : errorWeights) {
+		weightSoFar += pair.second;
+		if (weightSoFar >= p99Weight) {
+			result.p99 = pair.first;
+			break;
+		}
+	}
+
+	return result;
+}
+
+btArenaSDFShape::btArenaSDFShape() {
+	using namespace RLConst;
+	m_shapeType = CUSTOM_CONCAVE_SHAPE_TYPE;
+
+	// btCollisionShape::getAabb() only knows built-in shape types, so we give it a cached AABB for our identity transform
+	m_aabbCached = true;
+	m_aabbCacheTrans = btTransform::getIdentity();
+	m_aabbMinCache = btVector3(-ARENA_EXTENT_X, -ARENA_EXTENT_Y - ArenaSDF::GOAL_DEPTH, 0) * UU_TO_BT;
+	m_aabbMaxCache = btVector3(ARENA_EXTENT_X, ARENA_EXTENT_Y + ArenaSDF::GOAL_DEPTH, ARENA_HEIGHT) * UU_TO_BT;
+}
+
+btArenaSDFAlgorithm::btArenaSDFAlgorithm(
+	btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci,
+	const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped)
+	: btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap), m_manifoldPtr(mf), m_ownManifold(false), m_isSwapped(isSwapped) {
+
+	const btCollisionObjectWrapper* objWrap = m_isSwapped ? body1Wrap : body0Wrap;
+	const btCollisionObjectWrapper* sdfWrap = m_isSwapped ? body0Wrap : body1Wrap;
+	if (!m_manifoldPtr && m_dispatcher->needsCollision(objWrap->getCollisionObject(), sdfWrap->getCollisionObject())) {
+		m_manifoldPtr = m_dispatcher->getNewManifold(objWrap->getCollisionObject(), sdfWrap->getCollisionObject());
+		m_ownManifold = true;
+	}
+}
+
+btArenaSDFAlgorithm::~btArenaSDFAlgorithm() {
+	if (m_ownManifold && m_manifoldPtr)
+		m_dispatcher->releaseManifold(m_manifoldPtr);
+}
+
+void btArenaSDFAlgorithm::processCollision(
+	const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap,
+	const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) {
+	if (!m_manifoldPtr)
+		return;
+
+	const btCollisionObjectWrapper* objWrap = m_isSwapped ? body1Wrap : body0Wrap;
+	resultOut->setPersistentManifold(m_manifoldPtr);
+
+	// Contacts are given on the manifold's second body, which is the SDF unless a shared manifold says otherwise
+	bool sdfIsB = m_manifoldPtr->getBody0() == objWrap->getCollisionObject();
+
+	// Adds a contact for a point of the object that is this far from the surface (UU)
+	auto fnAddContact = [&](Vec surfacePoint, Vec normal, float depth) {
+		btVector3 surfacePointBT = surfacePoint * UU_TO_BT, normalBT = normal;
+		float depthBT = depth * UU_TO_BT;
+		if (sdfIsB) {
+			resultOut->addContactPoint(normalBT, surfacePointBT, depthBT);
+		} else {
+			resultOut->addContactPoint(-normalBT, surfacePointBT + normalBT * depthBT, depthBT);
+		}
+	};
+
+	const btCollisionShape* shape = objWrap->getCollisionShape();
+	const btTransform& transform = objWrap->getWorldTransform();
+	if (shape->getShapeType() == SPHERE_SHAPE_PROXYTYPE) {
+		float radius = ((const btSphereShape*)shape)->getRadius() * BT_TO_UU;
+		Vec center = Vec(transform.getOrigin()) * BT_TO_UU;
+
+		Vec normal;
+		float dist = ArenaSDF::GetDist(center, normal);
+		fnAddContact(center - normal * dist, normal, dist - radius - ArenaSDF::SURFACE_MARGIN);
+
+	} else if (shape->getShapeType() == BOX_SHAPE_PROXYTYPE) {
+		btVector3 halfExtents = ((const btBoxShape*)shape)->getHalfExtentsWithMargin();
+		for (int i = 0; i < 8; i++) {
+			btVector3 localCorner = btVector3(
+				(i & 1) ? halfExtents.x() : -halfExtents.x(),
+				(i & 2) ? halfExtents.y() : -halfExtents.y(),
+				(i & 4) ? halfExtents.z() : -halfExtents.z()
+			);
+			Vec corner = Vec(transform * localCorner) * BT_TO_UU;
+
+			Vec normal;
+			float dist = ArenaSDF::GetDist(corner, normal);
+			fnAddContact(corner - normal * dist, normal, dist - ArenaSDF::SURFACE_MARGIN);
+		}
+	}
+
+	if (m_ownManifold && m_manifoldPtr->getNumContacts())
+		resultOut->refreshContactPoints();
+}
+
+void btArenaSDFAlgorithm::Register(btCollisionDispatcher* dispatcher) {
+	static CreateFunc createFunc = {}, swappedCreateFunc = {};
+	swappedCreateFunc.m_swapped = true;
+
+	for (int shapeType : { SPHERE_SHAPE_PROXYTYPE, BOX_SHAPE_PROXYTYPE }) {
+		dispatcher->registerCollisionCreateFunc(shapeType, CUSTOM_CONCAVE_SHAPE_TYPE, &createFunc);
+		dispatcher->registerCollisionCreateFunc(CUSTOM_CONCAVE_SHAPE_TYPE, shapeType, &swappedCreateFunc);
+	}
+}
+
+RS_NS_END
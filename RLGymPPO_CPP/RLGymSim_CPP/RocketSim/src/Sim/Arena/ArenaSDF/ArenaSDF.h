@@ -0,0 +1,91 @@
+#pragma once
+#include "../../../BaseInc.h"
+#include "../../../RLConst.h"
+
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btConcaveShape.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btActivatingCollisionAlgorithm.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+#include "../../../../libsrc/bullet3-3.24/BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+
+RS_NS_START
+
+// Analytic model of the soccar arena, as a signed distance function
+// The arena is a box with 45-degree corners, whose edges are rounded by EDGE_RADIUS, plus a goal box at each end
+// Used instead of the arena meshes for car and ball contacts with ArenaConfig::useArenaSDF
+namespace ArenaSDF {
+	constexpr float
+		// Corner walls are along abs(x) + abs(y) = CORNER_XY_SUM
+		CORNER_XY_SUM = 8064,
+
+		// Radius of the curves between the floor, ceiling, walls, and corners
+		EDGE_RADIUS = 256,
+
+		GOAL_HALF_WIDTH = 892.755f,
+		GOAL_HEIGHT = 642.775f,
+		GOAL_DEPTH = 880,
+
+		// Objects rest this far above the meshes, because of their collision margin
+		SURFACE_MARGIN = RLConst::BALL_REST_Z - RLConst::BALL_COLLISION_RADIUS_SOCCAR;
+
+	// Distance from this position to the arena's surface, negative if outside of the arena (UU)
+	// Also returns the surface's normal, pointing into the arena
+	float GetDist(Vec pos, Vec& normalOut);
+
+	// How far the surface of some meshes is from the surface of the SDF (UU)
+	// Sampled at the vertices and centers of every triangle, weighted by triangle area
+	struct MeshError {
+		float mean, p99, max;
+		size_t numSamples;
+	};
+	MeshError MeasureMeshError(const std::vector<btBvhTriangleMeshShape*>& meshes);
+}
+
+// Bullet shape of the arena SDF, only collides through btArenaSDFAlgorithm
+// Has no triangles, so raycasts never hit it (suspension rays still hit the arena meshes)
+// NOTE: The body using this shape must have an identity transform
+ATTRIBUTE_ALIGNED16(class)
+btArenaSDFShape : public btConcaveShape {
+public:
+	btArenaSDFShape();
+
+	virtual const char* getName() const {
+		return "ArenaSDF";
+	}
+};
+
+// Contacts between the arena SDF and spheres or boxes
+// Spheres get one contact at their closest point, and boxes get one at each corner near the surface
+// Box edges against the goal posts aren't handled, as those are the only convex edges of the arena
+class btArenaSDFAlgorithm : public btActivatingCollisionAlgorithm {
+public:
+	btPersistentManifold* m_manifoldPtr;
+	bool m_ownManifold;
+	bool m_isSwapped; // If the SDF is body 0
+
+	btArenaSDFAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped);
+	virtual ~btArenaSDFAlgorithm();
+
+	virtual void processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	virtual btScalar calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) {
+		return 1;
+	}
+
+	virtual void getAllContactManifolds(btManifoldArray& manifoldArray) {
+		if (m_manifoldPtr && m_ownManifold)
+			manifoldArray.push_back(m_manifoldPtr);
+	}
+
+	struct CreateFunc : public btCollisionAlgorithmCreateFunc {
+		virtual btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap) {
+			void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(btArenaSDFAlgorithm));
+			return new (mem) btArenaSDFAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap, m_swapped);
+		}
+	};
+
+	// Makes the dispatcher use this algorithm for spheres and boxes against btArenaSDFShape
+	static void Register(btCollisionDispatcher* dispatcher);
+};
+
+RS_NS_END
@@ -0,0 +1,97 @@
+#include "ArenaSlab.h"
+
+#include "../../../../libsrc/bullet3-3.24/LinearMath/btAlignedAllocator.h"
+
+RS_NS_START
+
+thread_local ArenaSlab* _curSlab = NULL;
+
+// Put before every allocation, so that it can be freed without knowing where it came from
+// Its size keeps allocations aligned to any alignment up to it
+struct alignas(16) _AllocHeader {
+	ArenaSlab* slab; // NULL if allocated on the heap
+	void* real; // Start of the heap allocation, if on the heap
+};
+
+// Same as Bullet's default, aligned allocations come zeroed
+void* _SlabAlignedAlloc(size_t size, int alignment) {
+	alignment = RS_MAX(alignment, (int)alignof(_AllocHeader));
+
+	ArenaSlab* slab = _curSlab;
+	uint8_t* result = NULL;
+	void* real = NULL;
+	if (slab) {
+		size_t start = (size_t)btAlignPointer(slab->_data + slab->_used + sizeof(_AllocHeader), alignment) - (size_t)slab->_data;
+		if (start + size <= slab->_size) {
+			result = slab->_data + start;
+			slab->_used = start + size;
+			slab->_refCount++;
+		} else {
+			slab = NULL;
+		}
+	}
+
+	if (!result) {
+		real = malloc(size + sizeof(_AllocHeader) + alignment - 1);
+		if (!real)
+			return NULL;
+		result = (uint8_t*)btAlignPointer((uint8_t*)real + sizeof(_AllocHeader), alignment);
+	}
+
+	((_AllocHeader*)result)[-1] = { slab, real };
+	memset(result, 0, size);
+	return result;
+}
+
+void _SlabAlignedFree(void* ptr) {
+	auto& header = ((_AllocHeader*)ptr)[-1];
+	if (header.slab) {
+		header.slab->Release();
+	} else {
+		free(header.real);
+	}
+}
+
+ArenaSlab* ArenaSlab::Create(size_t size, HugePageMode hugePages) {
+	if (size == 0)
+		return NULL;
+
+	// The slab's own memory is never from a slab
+	auto slab = new ArenaSlab();
+	if (hugePages != HugePageMode::NONE) {
+		size = HugePages::RoundSize(size);
+		slab->_data = (uint8_t*)HugePages::Alloc(size, hugePages);
+		slab->_isHugeAlloc = true;
+	} else {
+		slab->_data = (uint8_t*)malloc(size);
+	}
+	if (!slab->_data)
+		RS_ERR_CLOSE("ArenaSlab::Create(): Failed to allocate " << size << " bytes");
+	slab->_size = size;
+	return slab;
+}
+
+void ArenaSlab::Release() {
+	if (--_refCount == 0) {
+		if (_isHugeAlloc) {
+			HugePages::Free(_data, _size);
+		} else {
+			free(_data);
+		}
+		delete this;
+	}
+}
+
+void ArenaSlab::_InstallBulletAllocator() {
+	btAlignedAllocSetCustomAligned(_SlabAlignedAlloc, _SlabAlignedFree);
+}
+
+ArenaSlab::Scope::Scope(ArenaSlab* slab) : prevSlab(_curSlab) {
+	_curSlab = slab;
+}
+
+ArenaSlab::Scope::~Scope() {
+	_curSlab = prevSlab;
+}
+
+RS_NS_END
\ No newline at end of file
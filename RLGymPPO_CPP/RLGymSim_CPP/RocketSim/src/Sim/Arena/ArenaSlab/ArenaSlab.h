@@ -0,0 +1,57 @@
+#pragma once
+#include "../../../BaseInc.h"
+#include "../../../HugePages/HugePages.h"
+
+#include <atomic>
+
+RS_NS_START
+
+// A contiguous block of memory that Bullet allocations of one arena are bump-allocated from
+// While a Scope is active on a thread, every btAlignedAlloc() on that thread comes from its slab, until the slab is full
+// This keeps an arena's objects and Bullet pools together in memory, and keeps arenas on different threads off of the global allocator
+// Memory is never reused within a slab, it is freed once the slab's owner and every allocation from it have been released
+// NOTE: Allocations can be freed from any thread, and after the arena is gone (i.e. cars the arena doesn't own)
+struct ArenaSlab {
+	// Allocations that don't fit in the slab go to the heap
+	// Returns NULL if size is 0
+	// If hugePages is not NONE, the slab is backed by huge pages, and its size is rounded up to fill them
+	static ArenaSlab* Create(size_t size, HugePageMode hugePages = HugePageMode::NONE);
+
+	// Releases the owner's reference, the slab is freed once everything allocated from it is too
+	void Release();
+
+	uint8_t* _data;
+	size_t _size, _used = 0;
+
+	// If set, our data is from HugePages::Alloc() instead of the heap
+	bool _isHugeAlloc = false;
+
+	// One for the owner, and one for each allocation that is still alive
+	std::atomic<size_t> _refCount = 1;
+
+	// Installs our allocation functions into Bullet, called by RocketSim::Init()
+	// Allocations outside of any scope are made on the heap, like Bullet's default allocator
+	static void _InstallBulletAllocator();
+
+	// Makes a slab the current one of this thread, for as long as the scope lives
+	// Scopes can be nested, the previous slab becomes current again once the inner one ends
+	// slab can be NULL, which makes allocations go to the heap
+	struct Scope {
+		ArenaSlab* prevSlab;
+
+		Scope(ArenaSlab* slab);
+		~Scope();
+
+		Scope(const Scope& other) = delete;
+		Scope& operator=(const Scope& other) = delete;
+	};
+
+	// No copying
+	ArenaSlab(const ArenaSlab& other) = delete;
+	ArenaSlab& operator=(const ArenaSlab& other) = delete;
+
+private:
+	ArenaSlab() = default;
+};
+
+RS_NS_END
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "ArenaTaskPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RS_SPIN_PAUSE() _mm_pause()
+#else
+#define RS_SPIN_PAUSE() {}
+#endif
+
+RS_NS_START
+
+// How many times workers check for a new job before sleeping
+constexpr int WORKER_SPIN_AMOUNT = 2000;
+
+// How many times Run() checks for workers finishing before yielding, in case there are more threads than cores
+constexpr int FINISH_SPIN_AMOUNT = 200;
+
+ArenaTaskPool::ArenaTaskPool(int numThreads) {
+	if (numThreads < 1)
+		RS_ERR_CLOSE("ArenaTaskPool::ArenaTaskPool(): Invalid thread count (" << numThreads << ")");
+
+	for (int i = 1; i < numThreads; i++)
+		_workers.push_back(std::thread([this] { _WorkerFunc(); }));
+}
+
+ArenaTaskPool::~ArenaTaskPool() {
+	_shouldStop = true;
+	_jobCounter++;
+	_jobCounter.notify_all();
+
+	for (std::thread& worker : _workers)
+		worker.join();
+}
+
+void ArenaTaskPool::Run(size_t amount, const std::function<void(size_t)>& fn) {
+	if (_workers.empty() || amount < 2) {
+		for (size_t i = 0; i < amount; i++)
+			fn(i);
+		return;
+	}
+
+	_fn = &fn;
+	_amount = amount;
+	_nextIndex.store(0, std::memory_order_relaxed);
+	_busyWorkers.store(_workers.size(), std::memory_order_relaxed);
+
+	// Publishes the job above
+	_jobCounter++;
+	if (_sleepingWorkers.load() > 0)
+		_jobCounter.notify_all();
+
+	_DoWork();
+
+	for (int i = 0; _busyWorkers.load(std::memory_order_acquire) > 0; i++) {
+		if (i < FINISH_SPIN_AMOUNT) {
+			RS_SPIN_PAUSE();
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ArenaTaskPool::_DoWork() {
+	while (true) {
+		size_t index = _nextIndex.fetch_add(1, std::memory_order_relaxed);
+		if (index >= _amount)
+			break;
+
+		(*_fn)(index);
+	}
+}
+
+void ArenaTaskPool::_WorkerFunc() {
+	uint32_t lastJob = 0;
+	while (true) {
+		uint32_t job;
+		for (int i = 0; (job = _jobCounter.load(std::memory_order_acquire)) == lastJob; i++) {
+			if (i < WORKER_SPIN_AMOUNT) {
+				RS_SPIN_PAUSE();
+			} else {
+				_sleepingWorkers++;
+				_jobCounter.wait(lastJob);
+				_sleepingWorkers--;
+			}
+		}
+		lastJob = job;
+
+		if (_shouldStop)
+			return;
+
+		_DoWork();
+		_busyWorkers.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+RS_NS_END
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include "../../../BaseInc.h"
+
+#include <atomic>
+
+RS_NS_START
+
+// A few worker threads that an arena runs the per-car phases of its ticks on
+// Phases are only microseconds apart, so workers spin for a while before sleeping until the next one
+struct ArenaTaskPool {
+	// numThreads includes the thread that calls Run()
+	ArenaTaskPool(int numThreads);
+	~ArenaTaskPool();
+
+	// No copying
+	ArenaTaskPool(const ArenaTaskPool& other) = delete;
+	ArenaTaskPool& operator=(const ArenaTaskPool& other) = delete;
+
+	int GetNumThreads() const {
+		return _workers.size() + 1;
+	}
+
+	// Calls fn(i) for every i in [0, amount) across all threads, returns once all calls are done
+	// NOTE: fn must not throw
+	void Run(size_t amount, const std::function<void(size_t)>& fn);
+
+	std::vector<std::thread> _workers;
+
+	const std::function<void(size_t)>* _fn = NULL;
+	size_t _amount = 0;
+	std::atomic<size_t> _nextIndex = 0;
+
+	// Incremented to start each job, workers wait on this
+	std::atomic<uint32_t> _jobCounter = 0;
+	std::atomic<int> _busyWorkers = 0, _sleepingWorkers = 0;
+	std::atomic<bool> _shouldStop = false;
+
+	void _DoWork();
+	void _WorkerFunc();
+};
+
+RS_NS_END
\ No newline at end of file
@@ -47,6 +47,8 @@ hsInfo.yTargetDir, hsInfo.curTargetSpeed, hsInfo.timeSinceHit
 
 class Ball {
 public:
+	// Allocated through Bullet, so arenas can place us in their slab (see ArenaSlab)
+	BT_DECLARE_ALIGNED_ALLOCATOR();
 
 	BallState _internalState;
 	RSAPI BallState GetState();
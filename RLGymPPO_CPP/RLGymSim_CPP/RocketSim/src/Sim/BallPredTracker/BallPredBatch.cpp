@@ -0,0 +1,24 @@
+#include "BallPredBatch.h"
+
+RS_NS_START
+
+BallPredBatch::~BallPredBatch() {
+	for (BallPredTracker* tracker : trackers)
+		delete tracker;
+}
+
+void BallPredBatch::Add(Arena* arena) {
+	trackers.push_back(new BallPredTracker(arena, numPredTicks, useFastPath));
+}
+
+void BallPredBatch::Update(Arena* const* arenas, size_t start, size_t end) {
+	lastUpdatePredTicks = 0;
+	for (size_t i = start; i < end; i++) {
+		BallPredTracker* tracker = trackers[i];
+		size_t startIndex = tracker->_PrepareUpdate(arenas[i]);
+		tracker->_PredictFrom(startIndex);
+		lastUpdatePredTicks += numPredTicks - startIndex;
+	}
+}
+
+RS_NS_END
\ No newline at end of file
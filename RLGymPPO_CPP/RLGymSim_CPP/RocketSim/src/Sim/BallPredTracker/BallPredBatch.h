@@ -0,0 +1,39 @@
+#pragma once
+#include "BallPredTracker.h"
+
+RS_NS_START
+
+// Predicts the balls of many arenas together, with one BallPredTracker per arena
+// Each update only re-predicts the ticks of each arena that its last prediction doesn't already cover
+struct BallPredBatch {
+	std::vector<BallPredTracker*> trackers;
+	size_t numPredTicks;
+	bool useFastPath;
+
+	BallPredBatch(size_t numPredTicks, bool useFastPath = true) : numPredTicks(numPredTicks), useFastPath(useFastPath) {}
+	~BallPredBatch();
+
+	// No copying
+	BallPredBatch(const BallPredBatch& other) = delete;
+	BallPredBatch& operator=(const BallPredBatch& other) = delete;
+
+	// Adds a tracker for this arena, which is then always updated at the same index
+	void Add(Arena* arena);
+
+	size_t Size() const {
+		return trackers.size();
+	}
+
+	// Updates the predictions of trackers [start, end), arenas[i] being the arena of tracker i
+	void Update(Arena* const* arenas, size_t start, size_t end);
+
+	// Predicted ball states of an arena, [0] being the state after its next tick
+	const BallState* GetPred(size_t index) const {
+		return trackers[index]->predData.data();
+	}
+
+	// How many ticks had to be predicted during the last update
+	size_t lastUpdatePredTicks = 0;
+};
+
+RS_NS_END
\ No newline at end of file
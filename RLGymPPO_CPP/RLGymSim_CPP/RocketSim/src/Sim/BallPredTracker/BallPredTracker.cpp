@@ -1,11 +1,35 @@
 #include "BallPredTracker.h"
 
+#include "../../../libsrc/bullet3-3.24/BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+
 RS_NS_START
 
-BallPredTracker::BallPredTracker(Arena* arena, size_t numPredTicks) : numPredTicks(numPredTicks) {
+// Approximate distance from a point to the soccar arena, in uu
+// This is the signed distance to a box that only shares the arena's floor, and is ARENA_FEATURE_MARGIN inside everything else,
+//	so it never overestimates: all ramps, corners, and goals are within that margin of the arena's outer planes
+// The margin matches the pads nearest the walls (e.g. the mid boost pads at x = +/-3584), which sit on flat floor
+float _GetSoccarClearance(Vec pos) {
+	using namespace RLConst;
+
+	constexpr float
+		ARENA_FEATURE_MARGIN = 512,
+		CORNER_XY_SUM = 3072 + 4096; // Corner boost pads, corner walls and their ramps are all beyond these
+
+	float absX = abs(pos.x), absY = abs(pos.y);
+	return RS_MIN(
+		RS_MIN(pos.z, ARENA_HEIGHT - ARENA_FEATURE_MARGIN - pos.z),
+		RS_MIN(
+			RS_MIN(ARENA_EXTENT_X - ARENA_FEATURE_MARGIN - absX, ARENA_EXTENT_Y - ARENA_FEATURE_MARGIN - absY),
+			(CORNER_XY_SUM - absX - absY) * (float)M_SQRT1_2
+		)
+	);
+}
+
+BallPredTracker::BallPredTracker(Arena* arena, size_t numPredTicks, bool useFastPath) : numPredTicks(numPredTicks), useFastPath(useFastPath) {
 	// Make ball pred arena
 	this->ballPredArena = Arena::Create(arena->gameMode, arena->GetArenaConfig(), arena->GetTickRate());
 	this->ballPredArena->tickCount = arena->tickCount;
+	this->ballPredArena->SetMutatorConfig(arena->GetMutatorConfig());
 
 	predData.reserve(numPredTicks);
 	UpdatePred(arena);
@@ -16,46 +40,49 @@ BallPredTracker::~BallPredTracker() {
 }
 
 void BallPredTracker::UpdatePred(Arena* arena) {
+	_PredictFrom(_PrepareUpdate(arena));
+}
+
+void BallPredTracker::ForceUpdateAllPred(Arena* arena) {
+	ballPredArena->ball->SetState(arena->ball->GetState());
+	ballPredArena->tickCount = arena->tickCount;
+	predData.resize(numPredTicks);
+	_PredictFrom(0);
+}
+
+size_t BallPredTracker::_PrepareUpdate(Arena* arena) {
 	uint64_t curTickCount = arena->tickCount;
-	uint64_t lastPredTickCount = ballPredArena->tickCount;
 
-	if (lastPredTickCount > curTickCount) {
+	// predData[i] is the ball state at predStartTickCount + i + 1, and the ball pred arena is at the last of them
+	uint64_t predStartTickCount = ballPredArena->tickCount - predData.size();
+
+	if (predData.size() == numPredTicks && curTickCount >= predStartTickCount) {
 		// How many ball pred ticks are now old
-		uint64_t predStartOffset = numPredTicks - (lastPredTickCount - curTickCount);
+		uint64_t ticksPassed = curTickCount - predStartTickCount;
 
-		// Data may be re-usable
-		if (predStartOffset == numPredTicks) {
+		if (ticksPassed == 0) {
 			// Already predicted for this tick
-			return;
+			return numPredTicks;
 		}
 
-		if (predStartOffset < predData.size()) {
-			BallState curBallState = arena->ball->GetState();
-			if (curBallState.Matches(predData[predStartOffset])) {
-				// Pred matches real ball, continue prediction from here
-				ballPredArena->ball->SetState(curBallState);
-				predData.erase(predData.begin(), predData.begin() + predStartOffset);
-				predData.resize(numPredTicks);
-				for (uint64_t i = predStartOffset; i < numPredTicks; i++) {
-					ballPredArena->Step();
-					predData[i] = ballPredArena->ball->GetState();
-				}
-				return;
-			} else {
-				// Doesn't match
-			}
+		if (ticksPassed <= numPredTicks && arena->ball->GetState().Matches(predData[ticksPassed - 1])) {
+			// Pred matches real ball, continue prediction from the last predicted tick
+			predData.erase(predData.begin(), predData.begin() + ticksPassed);
+			predData.resize(numPredTicks);
+			return numPredTicks - ticksPassed;
 		}
 	}
 
 	// Full re-simulation required
-	ForceUpdateAllPred(arena);
-}
-
-void BallPredTracker::ForceUpdateAllPred(Arena* arena) {
 	ballPredArena->ball->SetState(arena->ball->GetState());
+	ballPredArena->tickCount = curTickCount;
 	predData.resize(numPredTicks);
-	for (size_t i = 0; i < numPredTicks; i++) {
-		ballPredArena->Step();
+	return 0;
+}
+
+void BallPredTracker::_PredictFrom(size_t startIndex) {
+	for (size_t i = startIndex; i < numPredTicks; i++) {
+		_StepPred();
 		predData[i] = ballPredArena->ball->GetState();
 	}
 }
@@ -64,4 +91,76 @@ BallState BallPredTracker::GetBallStateForTime(float predTime) const {
 	return BallState();
 }
 
+void BallPredTracker::_StepPred() {
+	bool fast = useFastPath && _TryFastStep();
+	if (!fast)
+		ballPredArena->Step();
+	_lastStepWasFast = fast;
+}
+
+bool BallPredTracker::_TryFastStep() {
+	Ball* ball = ballPredArena->ball;
+	btRigidBody& rb = ball->_rigidBody;
+
+	if (ballPredArena->gameMode != GameMode::SOCCAR || !ball->IsSphere() || ballPredArena->_goalScoreCallback.func)
+		return false;
+
+	// Arena::Step() puts a motionless ball to sleep
+	if (rb.m_linearVelocity.length2() == 0 && rb.m_angularVelocity.length2() == 0)
+		return false;
+
+	// Bullet finds contacts before moving the ball, so the tick is free flight if there are none at the starting position
+	// The pad covers collision margins and bullet's contact threshold
+	constexpr float CONTACT_PAD = 10;
+	float clearance = _GetSoccarClearance(rb.m_worldTransform.m_origin * BT_TO_UU);
+	if (clearance < ball->GetRadiusBullet() * BT_TO_UU + CONTACT_PAD)
+		return false;
+
+	float tickTime = ballPredArena->tickTime;
+
+	// Same operations as a ball-only btDiscreteDynamicsWorld step with no contacts, in the same order
+	btVector3 vel = rb.m_linearVelocity * btPow(1 - rb.m_linearDamping, tickTime); // btRigidBody::applyDamping()
+	btVector3 angVel = rb.m_angularVelocity * btPow(1 - rb.m_angularDamping, tickTime);
+
+	// Velocity integration and writeback of btSequentialImpulseConstraintSolver
+	btVector3 totalForce = rb.m_totalForce + rb.m_gravity * rb.m_linearFactor;
+	vel = (vel + btVector3(0, 0, 0)) + (totalForce * rb.m_inverseMass * tickTime);
+	angVel = (angVel + btVector3(0, 0, 0)) + (rb.m_totalTorque * rb.m_invInertiaTensorWorld * tickTime);
+
+	// Bullet would put a slow ball to sleep
+	float linSleepThresh = rb.getLinearSleepingThreshold(), angSleepThresh = rb.getAngularSleepingThreshold();
+	if (vel.length2() < linSleepThresh * linSleepThresh && angVel.length2() < angSleepThresh * angSleepThresh)
+		return false;
+
+	// Contacts left over from the last Bullet tick would have been removed during this one
+	if (!_lastStepWasFast) {
+		btCollisionDispatcher* dispatcher = ballPredArena->_bulletWorld.getDispatcher();
+		for (int i = 0; i < dispatcher->getNumManifolds(); i++) {
+			btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+			if (manifold->getBody0() == &rb || manifold->getBody1() == &rb)
+				manifold->clearManifold();
+		}
+	}
+
+	rb.m_linearVelocity = vel;
+	rb.m_angularVelocity = angVel;
+
+	btTransform newTransform;
+	if (rb.m_noRot) {
+		btTransformUtil::integrateTransformNoRot(rb.m_worldTransform, vel, angVel, tickTime, newTransform);
+	} else {
+		btTransformUtil::integrateTransform(rb.m_worldTransform, vel, angVel, tickTime, newTransform);
+	}
+	rb.m_worldTransform = newTransform;
+
+	rb.m_totalForce = btVector3(0, 0, 0);
+	rb.m_totalTorque = btVector3(0, 0, 0);
+	rb.setActivationState(ACTIVE_TAG);
+	rb.m_deactivationTime = 0;
+
+	ball->_FinishPhysicsTick(ballPredArena->GetMutatorConfig());
+	ballPredArena->tickCount++;
+	return true;
+}
+
 RS_NS_END
\ No newline at end of file
@@ -9,9 +9,14 @@ struct BallPredTracker {
 	std::vector<BallState> predData;
 	size_t numPredTicks;
 
+	// Predict ticks where the ball can't be touching the arena without Bullet (soccar only)
+	// These ticks use the same math as Bullet, so predictions only differ from Bullet's if the ball touches the arena
+	//	in a spot that _GetSoccarClearance() thinks is clear (see BallPredTracker.cpp)
+	bool useFastPath;
+
 	// arena: The arena you want to predict the ball for (BallPredTracker will make a copy of it without the cars)
 	// You do not need to make another arena for BallPredTracker, it does that itself
-	BallPredTracker(Arena* arena, size_t numPredTicks);
+	BallPredTracker(Arena* arena, size_t numPredTicks, bool useFastPath = true);
 	~BallPredTracker();
 
 	// No copying
@@ -26,6 +31,21 @@ struct BallPredTracker {
 
 	// Get the predicted ball state at a given future time delta
 	BallState GetBallStateForTime(float predTime) const;
+
+	// Keeps the predictions that still match the arena's ball, or restarts prediction from it if none do
+	// Returns the index of the first tick of predData that still needs to be predicted
+	size_t _PrepareUpdate(Arena* arena);
+
+	// Predicts ticks [startIndex, numPredTicks) of predData
+	void _PredictFrom(size_t startIndex);
+
+	// Steps the ball pred arena by one tick, using the fast path if possible
+	void _StepPred();
+
+	// Returns false (having changed nothing) if Bullet is needed for this tick
+	bool _TryFastStep();
+
+	bool _lastStepWasFast = false;
 };
 
 RS_NS_END
\ No newline at end of file
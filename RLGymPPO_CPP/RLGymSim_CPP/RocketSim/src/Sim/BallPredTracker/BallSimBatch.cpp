@@ -0,0 +1,169 @@
+#include "BallSimBatch.h"
+
+RS_NS_START
+
+namespace {
+	constexpr float
+		// Same as the arena's collision meshes (see Arena::Arena())
+		// Contacts with static objects use the lower friction and higher restitution (see btManifoldResult::calculateCombinedFriction())
+		ARENA_FRICTION = 0.6f,
+		ARENA_RESTITUTION = 0.3f,
+
+		// Ball rests above the mesh by this much, because of its collision margin
+		CONTACT_MARGIN = RLConst::BALL_REST_Z - RLConst::BALL_COLLISION_RADIUS_SOCCAR,
+
+		// btContactSolverInfo::m_restitutionVelocityThreshold
+		RESTITUTION_VEL_THRESH = 0.2f * BT_TO_UU,
+
+		// Corner walls are along abs(x) + abs(y) = CORNER_XY_SUM
+		CORNER_XY_SUM = 8064,
+
+		// Same as Arena::IsBallProbablyGoingIn()'s goal approximation
+		GOAL_HALF_WIDTH = 892.755f,
+		GOAL_HEIGHT = 642.775f,
+		GOAL_DEPTH = 880;
+}
+
+size_t BallSimBatch::Add(const BallState& state) {
+	pos.push_back({});
+	vel.push_back({});
+	angVel.push_back({});
+	scoringTeam.push_back(-1);
+	SetState(Size() - 1, state);
+	return Size() - 1;
+}
+
+void BallSimBatch::SetState(size_t index, const BallState& state) {
+	pos[index] = state.pos;
+	vel[index] = state.vel;
+	angVel[index] = state.angVel;
+	scoringTeam[index] = -1;
+}
+
+BallState BallSimBatch::GetState(size_t index) const {
+	BallState state = {};
+	state.pos = pos[index];
+	state.vel = vel[index];
+	state.angVel = angVel[index];
+	return state;
+}
+
+void BallSimBatch::Clear() {
+	pos.clear();
+	vel.clear();
+	angVel.clear();
+	scoringTeam.clear();
+}
+
+float BallSimBatch::GetArenaDist(Vec pos, Vec& normalOut) {
+	using namespace RLConst;
+
+	float absX = abs(pos.x), absY = abs(pos.y);
+	float signX = pos.x >= 0 ? 1 : -1, signY = pos.y >= 0 ? 1 : -1;
+
+	// Intersection of half-spaces, so the distance is the smallest one
+	float dist = pos.z;
+	normalOut = Vec(0, 0, 1);
+	auto fnAddPlane = [&](float planeDist, Vec normal) {
+		if (planeDist < dist) {
+			dist = planeDist;
+			normalOut = normal;
+		}
+	};
+
+	fnAddPlane(ARENA_HEIGHT - pos.z, Vec(0, 0, -1));
+	fnAddPlane(ARENA_EXTENT_X - absX, Vec(-signX, 0, 0));
+	fnAddPlane((CORNER_XY_SUM - absX - absY) * (float)M_SQRT1_2, Vec(-signX, -signY, 0) * (float)M_SQRT1_2);
+
+	bool inGoalMouth = absX < GOAL_HALF_WIDTH && pos.z < GOAL_HEIGHT;
+	if (inGoalMouth) {
+		fnAddPlane(ARENA_EXTENT_Y + GOAL_DEPTH - absY, Vec(0, -signY, 0));
+		if (absY > ARENA_EXTENT_Y) {
+			fnAddPlane(GOAL_HALF_WIDTH - absX, Vec(-signX, 0, 0));
+			fnAddPlane(GOAL_HEIGHT - pos.z, Vec(0, 0, -1));
+		}
+	} else {
+		fnAddPlane(ARENA_EXTENT_Y - absY, Vec(0, -signY, 0));
+	}
+
+	return dist;
+}
+
+void BallSimBatch::Step(size_t numTicks, size_t start, size_t end) {
+	using namespace RLConst;
+
+	float
+		radius = mutatorConfig.ballRadius,
+		dampingScale = powf(1 - mutatorConfig.ballDrag, tickTime),
+		friction = RS_MIN(mutatorConfig.ballWorldFriction, ARENA_FRICTION),
+		restitution = RS_MAX(mutatorConfig.ballWorldRestitution, ARENA_RESTITUTION),
+		maxSpeed = mutatorConfig.ballMaxSpeed,
+		scoreY = SOCCAR_GOAL_SCORE_BASE_THRESHOLD_Y + radius;
+	Vec gravityDelta = mutatorConfig.gravity * tickTime;
+
+	for (size_t i = start; i < end; i++) {
+		if (scoringTeam[i] != -1)
+			continue;
+
+		Vec p = pos[i], v = vel[i], w = angVel[i];
+		for (size_t tick = 0; tick < numTicks; tick++) {
+
+			// Same order as a Bullet step: damping, gravity, contacts, integration, then Ball::_FinishPhysicsTick()
+			v = v * dampingScale + gravityDelta;
+
+			Vec normal;
+			float dist = GetArenaDist(p, normal);
+			if (dist < radius + CONTACT_MARGIN) {
+				float normalVel = v.Dot(normal);
+				if (normalVel < 0) {
+					float normalImpulse = -normalVel;
+					if (-normalVel >= RESTITUTION_VEL_THRESH)
+						normalImpulse += -normalVel * restitution;
+					v += normal * normalImpulse;
+
+					// Friction at the contact point, limited by the normal impulse
+					// A solid sphere's contact point changes speed 3.5x as much as its center (1 + mr^2/I)
+					Vec contactOffset = normal * -radius;
+					Vec contactVel = v + w.Cross(contactOffset);
+					Vec tangentVel = contactVel - normal * contactVel.Dot(normal);
+					float tangentSpeed = tangentVel.Length();
+					if (tangentSpeed > 0) {
+						float frictionDeltaSpeed = RS_MIN(tangentSpeed / 3.5f, friction * normalImpulse);
+						Vec frictionDelta = tangentVel * (-frictionDeltaSpeed / tangentSpeed);
+						v += frictionDelta;
+						w += contactOffset.Cross(frictionDelta) * (2.5f / (radius * radius));
+					}
+				}
+
+				// Bullet's split impulse pushes the ball back out
+				if (dist < radius)
+					p += normal * (radius - dist);
+			}
+
+			p += v * tickTime;
+
+			if (v.LengthSq() > maxSpeed * maxSpeed)
+				v = v.Normalized() * maxSpeed;
+			if (w.LengthSq() > BALL_MAX_ANG_SPEED * BALL_MAX_ANG_SPEED)
+				w = w.Normalized() * BALL_MAX_ANG_SPEED;
+
+			if (abs(p.y) > scoreY) {
+				scoringTeam[i] = (int8_t)RS_TEAM_FROM_Y(-p.y);
+				break;
+			}
+		}
+
+		pos[i] = p;
+		vel[i] = v;
+		angVel[i] = w;
+	}
+}
+
+void BallSimBatch::Predict(size_t numTicks, Vec* posOut) {
+	for (size_t tick = 0; tick < numTicks; tick++) {
+		Step(1);
+		std::copy(pos.begin(), pos.end(), posOut + tick * Size());
+	}
+}
+
+RS_NS_END
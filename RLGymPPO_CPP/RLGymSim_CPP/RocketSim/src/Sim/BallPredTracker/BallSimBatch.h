@@ -0,0 +1,52 @@
+#pragma once
+#include "../Ball/Ball.h"
+#include "../Car/Car.h"
+#include "../MutatorConfig/MutatorConfig.h"
+
+RS_NS_START
+
+// Steps many independent soccar balls together, without Bullet or arenas
+// The arena is simplified to a signed distance function of planes (floor, ceiling, walls, corners and goal mouths),
+//	and contacts are resolved with one impulse using the same friction and restitution as Bullet's ball-world contacts
+// Free flight (gravity, drag, speed limits) uses the same math as Bullet, so only bounces near curved parts of the arena differ
+// Meant for ball-only scenarios and long ball predictions, where thousands of balls are stepped at once
+// NOTE: Ball rotation is not tracked, GetState() always returns an identity rotMat
+struct BallSimBatch {
+	MutatorConfig mutatorConfig;
+	float tickTime;
+
+	// State of each ball, stored contiguously so that many balls can be read at once
+	std::vector<Vec> pos, vel, angVel; // UU, UU/s, rad/s
+
+	// Balls that went into a goal are no longer stepped, this is the team that scored (or -1)
+	std::vector<int8_t> scoringTeam;
+
+	BallSimBatch(float tickRate = 120, const MutatorConfig& mutatorConfig = MutatorConfig(GameMode::SOCCAR))
+		: mutatorConfig(mutatorConfig), tickTime(1 / tickRate) {}
+
+	size_t Size() const {
+		return pos.size();
+	}
+
+	// Returns the index of the new ball
+	size_t Add(const BallState& state);
+	void SetState(size_t index, const BallState& state);
+	BallState GetState(size_t index) const;
+
+	void Clear();
+
+	// Steps balls [start, end) by this many ticks
+	void Step(size_t numTicks, size_t start, size_t end);
+	void Step(size_t numTicks = 1) {
+		Step(numTicks, 0, Size());
+	}
+
+	// Steps every ball by numTicks, writing the position of each ball after each tick to posOut ([numTicks][Size()])
+	void Predict(size_t numTicks, Vec* posOut);
+
+	// Distance from this position to the nearest surface of the simplified arena (negative if outside of it)
+	// Also returns the surface's normal, pointing into the arena
+	static float GetArenaDist(Vec pos, Vec& normalOut);
+};
+
+RS_NS_END
@@ -36,32 +36,6 @@ void BoostPad::_PreTickUpdate(float tickTime) {
 	_internalState.curLockedCar = NULL;
 }
 
-void BoostPad::_CheckCollide(Car* car) {
-	using namespace RLConst::BoostPads;
-
-	Vec carPosBT = car->_rigidBody.m_worldTransform.m_origin;
-
-	bool colliding = false;
-	if (_internalState.prevLockedCarID == car->id) {
-		// Check with AABB-hitbox collision
-
-		btVector3 carMinBT, carMaxBT;
-		car->_rigidBody.getAabb(carMinBT, carMaxBT);
-
-		// TODO: Account for orientation
-		colliding = (_boxMaxBT > carMinBT) && (_boxMinBT < carMaxBT);
-	} else {
-		// Check with cylinder-origin collision
-
-		float rad = (isBig ? CYL_RAD_BIG : CYL_RAD_SMALL) * UU_TO_BT;
-		if (carPosBT.DistSq2D(this->_posBT) < (rad * rad))
-			colliding = abs(carPosBT.z - this->_posBT.z) < (CYL_HEIGHT * UU_TO_BT);
-	}
-
-	if (colliding)
-		_internalState.curLockedCar = car;
-}
-
 void BoostPad::_PostTickUpdate(float tickTime, const MutatorConfig& mutatorConfig) {
 	using namespace RLConst::BoostPads;
 
@@ -25,6 +25,9 @@ isActive, cooldown, prevLockedCarID
 
 class BoostPad {
 public:
+	// Allocated through Bullet, so arenas can place us in their slab (see ArenaSlab)
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
 	bool isBig;
 	Vec pos;
 
@@ -40,8 +43,7 @@ public:
 	static BoostPad* _AllocBoostPad();
 	void _Setup(bool isBig, Vec pos);
 
-	void _CheckCollide(Car* car);
-
+	// Pickups are checked by BoostPadGrid::CheckCollision()
 	void _PreTickUpdate(float tickTime);
 	void _PostTickUpdate(float tickTime, const MutatorConfig& mutatorConfig);
 private:
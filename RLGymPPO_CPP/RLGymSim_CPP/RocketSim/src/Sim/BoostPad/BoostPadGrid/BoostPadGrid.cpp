@@ -2,11 +2,25 @@
 
 RS_NS_START
 
+void BoostPadGrid::UpdatePads(const std::vector<Car*>& cars, float tickTime, const MutatorConfig& mutatorConfig) {
+	for (BoostPad* pad : padList)
+		pad->_PreTickUpdate(tickTime);
+
+	for (Car* car : cars)
+		CheckCollision(car);
+
+	for (BoostPad* pad : padList)
+		pad->_PostTickUpdate(tickTime, mutatorConfig);
+}
+
 void BoostPadGrid::CheckCollision(Car* car) {
+	using namespace RLConst::BoostPads;
+
 	if (car->_internalState.isDemoed || car->_internalState.boost >= 100)
 		return;
 
-	Vec carPos = car->_rigidBody.m_worldTransform.m_origin * BT_TO_UU;
+	Vec carPosBT = car->_rigidBody.m_worldTransform.m_origin;
+	Vec carPos = carPosBT * BT_TO_UU;
 
 	if (carPos.z > EXTENT_Z)
 		return;
@@ -14,12 +28,39 @@ void BoostPadGrid::CheckCollision(Car* car) {
 	int indexX = carPos.x / CELL_SIZE_X + (CELLS_X / 2);
 	int indexY = carPos.y / CELL_SIZE_Y + (CELLS_Y / 2);
 
-	for (int i = RS_MAX(indexX - 1, 0); i < CELLS_X; i++) {
-		for (int j = RS_MAX(indexY - 1, 0); j < CELLS_Y; j++) {
-			BoostPad* pad = pads[i][j];
-			if (pad) {
-				pad->_CheckCollide(car);
+	// Cells are much bigger than pads, so only neighboring cells can have pads we touch
+	int
+		minX = RS_MAX(indexX - 1, 0), maxX = RS_MIN(indexX + 1, CELLS_X - 1),
+		minY = RS_MAX(indexY - 1, 0), maxY = RS_MIN(indexY + 1, CELLS_Y - 1);
+
+	for (int i = minX; i <= maxX; i++) {
+		for (int j = minY; j <= maxY; j++) {
+			int padIndex = padIndices[i][j];
+			if (padIndex < 0)
+				continue;
+
+			BoostPadState& padState = padList[padIndex]->_internalState;
+
+			bool colliding = false;
+			if (padState.prevLockedCarID == car->id) {
+				// Check with AABB-hitbox collision
+
+				btVector3 carMinBT, carMaxBT;
+				car->_rigidBody.getAabb(carMinBT, carMaxBT);
+
+				// TODO: Account for orientation
+				colliding = (padData.boxMaxBT[padIndex] > carMinBT) && (padData.boxMinBT[padIndex] < carMaxBT);
+			} else {
+				// Check with cylinder-origin collision
+
+				float dx = carPosBT.x - padData.xBT[padIndex];
+				float dy = carPosBT.y - padData.yBT[padIndex];
+				if ((dx * dx + dy * dy) < padData.cylRadSqBT[padIndex])
+					colliding = abs(carPosBT.z - padData.zBT[padIndex]) < (CYL_HEIGHT * UU_TO_BT);
 			}
+
+			if (colliding)
+				padState.curLockedCar = car;
 		}
 	}
 }
@@ -38,6 +79,21 @@ void BoostPadGrid::Add(BoostPad* pad) {
 	} else {
 		ptrInArray = pad;
 	}
+
+	padIndices[indexX][indexY] = padList.size();
+	padList.push_back(pad);
+
+	{
+		using namespace RLConst::BoostPads;
+
+		float rad = (pad->isBig ? CYL_RAD_BIG : CYL_RAD_SMALL) * UU_TO_BT;
+		padData.xBT.push_back(pad->_posBT.x);
+		padData.yBT.push_back(pad->_posBT.y);
+		padData.zBT.push_back(pad->_posBT.z);
+		padData.cylRadSqBT.push_back(rad * rad);
+		padData.boxMinBT.push_back(pad->_boxMinBT);
+		padData.boxMaxBT.push_back(pad->_boxMaxBT);
+	}
 }
 
 RS_NS_END
\ No newline at end of file
@@ -21,7 +21,25 @@ struct BoostPadGrid {
 
 	BoostPad* pads[CELLS_X][CELLS_Y] = {};
 
-	BoostPadGrid() = default;
+	// Pad of each cell as an index into padList, or -1
+	int padIndices[CELLS_X][CELLS_Y];
+
+	// Pads in the order they were added
+	std::vector<BoostPad*> padList;
+
+	// Static pad collision data as SoA, indexed the same as padList
+	struct {
+		std::vector<float> xBT, yBT, zBT;
+		std::vector<float> cylRadSqBT;
+		std::vector<Vec> boxMinBT, boxMaxBT;
+	} padData;
+
+	BoostPadGrid() {
+		std::fill(&padIndices[0][0], &padIndices[0][0] + CELL_AMOUNT, -1);
+	}
+
+	// Updates all pads for a tick after the cars have finished it: cooldowns first, then pickups by the cars (in order), then boost giving
+	void UpdatePads(const std::vector<Car*>& cars, float tickTime, const MutatorConfig& mutatorConfig);
 
 	void CheckCollision(Car* car);
 	void Add(BoostPad* pad);
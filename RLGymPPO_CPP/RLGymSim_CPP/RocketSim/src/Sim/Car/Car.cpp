@@ -26,6 +26,7 @@ void Car::SetState(const CarState& state) {
 	rbTransform.setBasis(state.rotMat);
 
 	_rigidBody.m_worldTransform = rbTransform;
+	_rigidBody.updateInertiaTensor(); // Torques are applied with it before Bullet updates it
 
 	_rigidBody.m_linearVelocity = state.vel * UU_TO_BT;
 	_rigidBody.m_angularVelocity = state.angVel;
@@ -34,6 +35,20 @@ void Car::SetState(const CarState& state) {
 
 	_internalState = state;
 	_internalState.updateCounter = 0;
+
+	_SetInWorld(!state.isDemoed);
+}
+
+void Car::_SetInWorld(bool inWorld) {
+	if (inWorld == _isInWorld)
+		return;
+
+	if (inWorld) {
+		_bulletVehicle.m_dynamicsWorld->addRigidBody(&_rigidBody);
+	} else {
+		_bulletVehicle.m_dynamicsWorld->removeRigidBody(&_rigidBody);
+	}
+	_isInWorld = inWorld;
 }
 
 void Car::Demolish(float respawnDelay) {
@@ -76,6 +91,9 @@ void Car::_PreTickUpdate(GameMode gameMode, float tickTime, const MutatorConfig&
 			_rigidBody.m_activationState1 = DISABLE_SIMULATION;
 			_rigidBody.m_collisionFlags |= btCollisionObject::CF_NO_CONTACT_RESPONSE;
 
+			// Leave the world until we respawn, we can't be removed during the physics tick we were demoed in
+			_SetInWorld(!_internalState.isDemoed);
+
 			// Don't bother updating anything
 		} else {
 			// Prevent the car's RB from becoming inactive
@@ -413,29 +431,12 @@ void Car::_UpdateWheels(float tickTime, const MutatorConfig& mutatorConfig, int
 	}
 
 	{ // Update friction
+		_bulletVehicle.updateFrictionCurveInputs();
+
 		for (int i = 0; i < 4; i++) {
 			auto& wheel = _bulletVehicle.m_wheelInfo[i];
 			if (wheel.m_raycastInfo.m_groundObject) {
-
-				btVector3
-					vel = _rigidBody.m_linearVelocity,
-					angularVel = _rigidBody.m_angularVelocity;
-
-				btVector3
-					latDir = wheel.m_worldTransform.getBasis().getColumn(1),
-					longDir = latDir.cross(wheel.m_raycastInfo.m_contactNormalWS);
-
-				float frictionCurveInput = 0;
-
-				btVector3 wheelDelta = wheel.m_raycastInfo.m_hardPointWS - _rigidBody.m_worldTransform.m_origin;
-
-				auto crossVec = (angularVel.cross(wheelDelta) + vel) * BT_TO_UU;
-
-				float baseFriction = abs(crossVec.dot(latDir));
-
-				// Significant friction results in lateral slip
-				if (baseFriction > 5)
-					frictionCurveInput = baseFriction / (abs(crossVec.dot(longDir)) + baseFriction);
+				float frictionCurveInput = _bulletVehicle.m_wheelLanes.frictionCurveInput[i];
 
 				float latFriction = LAT_FRICTION_CURVE.GetOutput(frictionCurveInput);
 				float longFriction = LONG_FRICTION_CURVE.GetOutput(frictionCurveInput);
@@ -131,6 +131,9 @@ enum class Team : byte {
 
 class Car {
 public:
+	// Allocated through Bullet, so arenas can place us in their slab (see ArenaSlab)
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
 	// Configuration for this car
 	CarConfig config;
 	Team team;
@@ -181,6 +184,10 @@ public:
 	Vec _velocityImpulseCache = { 0,0,0 };
 	void _FinishPhysicsTick(const MutatorConfig& mutatorConfig);
 
+	// Demoed cars are taken out of the bullet world until they respawn, but keep their last state
+	bool _isInWorld = true;
+	void _SetInWorld(bool inWorld);
+
 	void _BulletSetup(GameMode gameMode, class btDynamicsWorld* bulletWorld, const MutatorConfig& mutatorConfig);
 	
 	// For construction by Arena
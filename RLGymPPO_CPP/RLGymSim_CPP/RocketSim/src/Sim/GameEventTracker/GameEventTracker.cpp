@@ -2,10 +2,22 @@
 
 RS_NS_START
 
-bool GetShooterPasser(Arena* arena, Team team, Car*& shooterOut, bool findPasser, Car*& passerOut, uint64_t maxShooterTicks, uint64_t maxPasserTicks) {
-	shooterOut = passerOut = NULL;
-	// TODO: Instead of looping over cars to find who hit it last, use persistent info
+// Returns the car if it still has the ball hit the team's latest touches say it has
+Car* _GetTouchCar(Arena* arena, Team team, uint32_t carID, uint64_t tick) {
+	Car* car = arena->GetCar(carID);
+	if (!car || car->team != team)
+		return NULL;
 
+	auto& ballHitInfo = car->_internalState.ballHitInfo;
+	if (!ballHitInfo.isValid || ballHitInfo.tickCountWhenHit != tick)
+		return NULL;
+
+	return car;
+}
+
+// Finds the team's latest touches from the cars themselves
+void _RebuildTeamBallTouches(Arena* arena, Team team) {
+	Car* touchCars[2] = {};
 	for (Car* car : arena->_cars) {
 		if (car->team != team)
 			continue;
@@ -13,38 +25,70 @@ bool GetShooterPasser(Arena* arena, Team team, Car*& shooterOut, bool findPasser
 		if (!car->_internalState.ballHitInfo.isValid)
 			continue;
 
-		if (car->_internalState.ballHitInfo.tickCountWhenHit + maxShooterTicks >= arena->tickCount) {
-			if (!shooterOut || car->_internalState.ballHitInfo.tickCountWhenHit > shooterOut->_internalState.ballHitInfo.tickCountWhenHit) {
-				shooterOut = car;
-			}
+		uint64_t tick = car->_internalState.ballHitInfo.tickCountWhenHit;
+		if (!touchCars[0] || tick > touchCars[0]->_internalState.ballHitInfo.tickCountWhenHit) {
+			touchCars[1] = touchCars[0];
+			touchCars[0] = car;
+		} else if (!touchCars[1] || tick > touchCars[1]->_internalState.ballHitInfo.tickCountWhenHit) {
+			touchCars[1] = car;
 		}
 	}
 
-	if (shooterOut && findPasser) { // Look for passer
-		uint64_t shootTick = shooterOut->_internalState.ballHitInfo.tickCountWhenHit;
-
-		// TODO: Repetitive code
-		for (Car* car : arena->_cars) {
-			if (car->team != team)
-				continue;
-
-			if (!car->_internalState.ballHitInfo.isValid)
-				continue;
+	auto& touches = arena->_teamBallTouches[(int)team];
+	touches.isValid = true;
+	for (int i = 0; i < 2; i++) {
+		touches.carIDs[i] = touchCars[i] ? touchCars[i]->id : 0;
+		touches.ticks[i] = touchCars[i] ? touchCars[i]->_internalState.ballHitInfo.tickCountWhenHit : 0;
+	}
+}
 
-			if (car == shooterOut)
-				continue;
+bool GetShooterPasser(Arena* arena, Team team, Car*& shooterOut, bool findPasser, Car*& passerOut, uint64_t maxShooterTicks, uint64_t maxPasserTicks) {
+	shooterOut = passerOut = NULL;
 
-			if (car->_internalState.ballHitInfo.tickCountWhenHit + maxPasserTicks >= shootTick) {
-				if (!passerOut || car->_internalState.ballHitInfo.tickCountWhenHit > passerOut->_internalState.ballHitInfo.tickCountWhenHit) {
-					passerOut = car;
-				}
+	auto& touches = arena->_teamBallTouches[(int)team];
+	Car* touchCars[2] = {};
+	for (int attempt = 0; attempt < 2; attempt++) {
+		if (!touches.isValid)
+			_RebuildTeamBallTouches(arena, team);
+
+		bool upToDate = true;
+		for (int i = 0; i < 2; i++) {
+			if (touches.carIDs[i]) {
+				touchCars[i] = _GetTouchCar(arena, team, touches.carIDs[i], touches.ticks[i]);
+				upToDate &= (touchCars[i] != NULL);
+			} else {
+				touchCars[i] = NULL;
 			}
 		}
+
+		if (upToDate)
+			break;
+
+		// Car states were set since, rebuild
+		touches.isValid = false;
+	}
+
+	// Only the latest touch can be recent enough
+	Car* lastTouchCar = touchCars[0];
+	if (lastTouchCar && lastTouchCar->_internalState.ballHitInfo.tickCountWhenHit + maxShooterTicks >= arena->tickCount)
+		shooterOut = lastTouchCar;
+
+	if (shooterOut && findPasser) { // Passer is the last other car to touch it
+		uint64_t shootTick = shooterOut->_internalState.ballHitInfo.tickCountWhenHit;
+
+		Car* prevTouchCar = touchCars[1];
+		if (prevTouchCar && prevTouchCar->_internalState.ballHitInfo.tickCountWhenHit + maxPasserTicks >= shootTick)
+			passerOut = prevTouchCar;
 	}
 
 	return shooterOut != NULL;
 }
 
+static void _QueueEvent(Arena* arena, ArenaEvent::Type type, Car* car, Car* otherCar) {
+	if (arena->queueEvents)
+		arena->_eventQueue.push_back({ type, car->id, otherCar ? otherCar->id : 0 });
+}
+
 void GameEventTracker::Update(Arena* arena) {
 	bool scored = arena->IsBallScored();
 	
@@ -71,6 +115,7 @@ void GameEventTracker::Update(Arena* arena) {
 				config.passMaxTouchTime * tickrate
 			)) {
 
+				_QueueEvent(arena, ArenaEvent::Type::GOAL, shooter, passer);
 				if (_goalCallback.func)
 					_goalCallback.func(arena, shooter, passer, _goalCallback.userInfo);
 			}
@@ -107,6 +152,7 @@ void GameEventTracker::Update(Arena* arena) {
 									_ballShot = true;
 									_ballShotGoalTeam = goalTeam;
 									_shotCooldown = config.shotEventCooldown;
+									_QueueEvent(arena, ArenaEvent::Type::SHOT, shooter, passer);
 									if (_shotCallback.func)
 										_shotCallback.func(arena, shooter, passer, _shotCallback.userInfo);
 								}
@@ -134,6 +180,7 @@ void GameEventTracker::Update(Arena* arena) {
 
 						// A car from the team the ball has just hit the ball
 						// Since it's no longer scoring, this was a save
+						_QueueEvent(arena, ArenaEvent::Type::SAVE, saver, NULL);
 						if (_saveCallback.func)
 							_saveCallback.func(arena, saver, _saveCallback.userInfo);
 					} else {
@@ -151,6 +198,10 @@ void GameEventTracker::Update(Arena* arena) {
 		// Ball update count decreased
 		// Reset persistent info
 		ResetPersistentInfo();
+
+		// Cars were probably stateset too
+		for (auto& touches : arena->_teamBallTouches)
+			touches.isValid = false;
 	}
 
 	_ballScoredLast = scored;
@@ -44,6 +44,7 @@ struct GameEventTrackerConfig {
 
 // An external tool struct that tracks saves, shots, assists, and goals
 // When Update() is called and one of these events occurs, the associated callback will be called (if a callback is registered)
+// They are also added to the arena's event queue, if it has queueEvents
 // Note that bumps and demos are not tracked as they are already trackable through arena callbacks
 struct GameEventTracker {
 	GameEventTrackerConfig config = {};
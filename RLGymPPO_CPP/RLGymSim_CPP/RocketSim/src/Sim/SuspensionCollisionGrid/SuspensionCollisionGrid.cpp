@@ -2,114 +2,143 @@
 
 #include "../../../libsrc/bullet3-3.24/BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 #include "../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
+#include "../../../libsrc/bullet3-3.24/BulletCollision/CollisionShapes/btStaticPlaneShape.h"
+#include "../../../libsrc/bullet3-3.24/BulletCollision/BroadphaseCollision/btRSBroadphase.h"
+#include "../../../libsrc/bullet3-3.24/LinearMath/btAabbUtil2.h"
 
-RS_NS_START
-
-// Quick virtual btTriangleCallback child class to simply check if any triangles are processed
-struct BoolHitTriangleCallback : public btTriangleCallback {
+#include <bit>
 
-	bool hit = false;
-	
-	BoolHitTriangleCallback() {}
-	virtual void processTriangle(btVector3* triangle, int partId, int triangleIndex) {
-		hit = true;
-	}
-};
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
-template <bool LIGHT>
-void _SetupWorldCollision(SuspensionCollisionGrid& grid, const std::vector<btBvhTriangleMeshShape*>& triMeshShapes) {
+RS_NS_START
 
-	int totalCellsWithin = 0;
-	int totalCellsBled = 0;
-	BoolHitTriangleCallback boolCallback = BoolHitTriangleCallback();
+// Collects every triangle of a mesh
+struct CollectTrianglesCallback : public btTriangleCallback {
 
-	Vec cellSizeBT = grid.GetCellSize<LIGHT>() * UU_TO_BT;
+	std::vector<SuspensionCollisionGrid::Triangle>* triangles;
+	uint32_t meshIndex;
 
-	// Enable cell.worldCollision for all cells that contain one or more triangle mesh's geometry
-	for (btBvhTriangleMeshShape* triMeshShape : triMeshShapes) {	
-		btVector3 rbMinBT, rbMaxBT;
-		triMeshShape->getAabb(btTransform(), rbMinBT, rbMaxBT);
+	CollectTrianglesCallback(std::vector<SuspensionCollisionGrid::Triangle>* triangles, uint32_t meshIndex) 
+		: triangles(triangles), meshIndex(meshIndex) {}
 
-		for (int i = 0; i < grid.CELL_AMOUNT_X[LIGHT]; i++) {
+	virtual void processTriangle(btVector3* triangle, int partId, int triangleIndex) {
+		triangles->push_back({ { triangle[0], triangle[1], triangle[2] }, meshIndex });
+	}
+};
 
-			Vec
-				cellPlaneMinBT = grid.GetCellMin<LIGHT>(i, 0, 0) * UU_TO_BT,
-				cellPlaneMaxBT = grid.GetCellMin<LIGHT>(i, grid.CELL_AMOUNT_Y[LIGHT] - 1, grid.CELL_AMOUNT_Z[LIGHT] - 1) * UU_TO_BT + cellSizeBT;
+bool SuspensionCollisionGrid::IsHoopsNetMesh(btBvhTriangleMeshShape* mesh) {
+	const unsigned char* vertexBase;
+	int numVerts, stride;
+	const unsigned char* indexBase;
+	int indexStride, numFaces;
+	mesh->getMeshInterface()->getLockedReadOnlyVertexIndexBase(&vertexBase, numVerts, stride, &indexBase, indexStride, numFaces);
+	mesh->getMeshInterface()->unLockReadOnlyVertexBase(0);
 
-			boolCallback.hit = false;
-			triMeshShape->processAllTriangles(&boolCallback, cellPlaneMinBT, cellPlaneMaxBT);
-			if (boolCallback.hit) {
-				for (int j = 0; j < grid.CELL_AMOUNT_Y[LIGHT]; j++) {
+	constexpr int HOOPS_NET_NUM_VERTS = 505;
+	return numVerts == HOOPS_NET_NUM_VERTS;
+}
 
-					Vec
-						cellColumnMinBT = grid.GetCellMin<LIGHT>(i, j, 0) * UU_TO_BT,
-						cellColumnMaxBT = grid.GetCellMin<LIGHT>(i, j, grid.CELL_AMOUNT_Z[LIGHT] - 1) * UU_TO_BT + cellSizeBT;
+template <bool LIGHT>
+void _SetupWorldCollision(SuspensionCollisionGrid& grid, const std::vector<btBvhTriangleMeshShape*>& triMeshShapes) {
+	using Grid = SuspensionCollisionGrid;
 
-					boolCallback.hit = false;
-					triMeshShape->processAllTriangles(&boolCallback, cellColumnMinBT, cellColumnMaxBT);
+	auto worldData = std::make_shared<Grid::WorldData>();
 
-					if (boolCallback.hit) {
-						for (int k = 0; k < grid.CELL_AMOUNT_Z[LIGHT]; k++) {
+	for (uint32_t i = 0; i < triMeshShapes.size(); i++) {
+		btBvhTriangleMeshShape* triMeshShape = triMeshShapes[i];
+		if (grid.gameMode == GameMode::HOOPS && Grid::IsHoopsNetMesh(triMeshShape))
+			continue;
 
-							SuspensionCollisionGrid::Cell& cell = grid.Get<LIGHT>(i, j, k);
+		btVector3 meshMinBT, meshMaxBT;
+		triMeshShape->getAabb(btTransform::getIdentity(), meshMinBT, meshMaxBT);
 
-							if (!cell.worldCollision) {
+		CollectTrianglesCallback callback = CollectTrianglesCallback(&worldData->triangles, i);
+		triMeshShape->processAllTriangles(&callback, meshMinBT, meshMaxBT);
+	}
 
-								Vec
-									cellMinBT = grid.GetCellMin<LIGHT>(i, j, k) * UU_TO_BT,
-									cellMaxBT = cellMinBT + cellSizeBT;
+	// Finds the cells a triangle can matter to
+	// Cells are expanded by MAX_RAY_LENGTH in each direction, so that rays only need the cell they start in
+	auto fnGetTriangleCellRange = [&](const Grid::Triangle& tri, int& i1, int& j1, int& k1, int& i2, int& j2, int& k2) {
+		btVector3 minBT = tri.verts[0], maxBT = tri.verts[0];
+		for (int i = 1; i < 3; i++) {
+			minBT.setMin(tri.verts[i]);
+			maxBT.setMax(tri.verts[i]);
+		}
 
-								boolCallback.hit = false;
-								triMeshShape->processAllTriangles(&boolCallback, cellMinBT, cellMaxBT);
-								if (boolCallback.hit) {
-									cell.worldCollision = true;
-									totalCellsWithin++;
-								}
-							}
-						}
-					}
+		grid.GetCellIndicesFromPos<LIGHT>(minBT * BT_TO_UU - Vec(1, 1, 1) * Grid::MAX_RAY_LENGTH, i1, j1, k1);
+		grid.GetCellIndicesFromPos<LIGHT>(maxBT * BT_TO_UU + Vec(1, 1, 1) * Grid::MAX_RAY_LENGTH, i2, j2, k2);
+	};
+
+	// Make each cell's triangle list
+	int cellAmount = Grid::CELL_AMOUNT_TOTAL[LIGHT];
+	std::vector<std::vector<uint32_t>> cellTriIndices = std::vector<std::vector<uint32_t>>(cellAmount);
+	size_t totalTriRefs = 0;
+	for (uint32_t triIndex = 0; triIndex < worldData->triangles.size(); triIndex++) {
+		int i1, j1, k1, i2, j2, k2;
+		fnGetTriangleCellRange(worldData->triangles[triIndex], i1, j1, k1, i2, j2, k2);
+		for (int i = i1; i <= i2; i++) {
+			for (int j = j1; j <= j2; j++) {
+				for (int k = k1; k <= k2; k++) {
+					cellTriIndices[Grid::GetCellIndex<LIGHT>(i, j, k)].push_back(triIndex);
+					totalTriRefs++;
 				}
 			}
 		}
 	}
 
-	SuspensionCollisionGrid clone = SuspensionCollisionGrid(grid.gameMode, grid.lightMem);
-	clone.Allocate();
-
-	// Make cell.worldCollision bleed to all surrounding cells
-	for (int i = 0; i < grid.CELL_AMOUNT_X[LIGHT]; i++) {
-		for (int j = 0; j < grid.CELL_AMOUNT_Y[LIGHT]; j++) {
-			for (int k = 0; k < grid.CELL_AMOUNT_Z[LIGHT]; k++) {
-
-				SuspensionCollisionGrid::Cell& cell = grid.Get<LIGHT>(i, j, k);
-				if (cell.worldCollision) {
-					for (int i2 = -1; i2 < 2; i2++) {
-						for (int j2 = -1; j2 < 2; j2++) {
-							for (int k2 = -1; k2 < 2; k2++) {
-
-								SuspensionCollisionGrid::Cell& otherCell = clone.Get<LIGHT>(
-									RS_CLAMP(i + i2, 0, grid.CELL_AMOUNT_X[LIGHT] - 1),
-									RS_CLAMP(j + j2, 0, grid.CELL_AMOUNT_Y[LIGHT] - 1),
-									RS_CLAMP(k + k2, 0, grid.CELL_AMOUNT_Z[LIGHT] - 1)
-								);
-
-								if (!otherCell.worldCollision)
-									totalCellsBled++;
-								otherCell.worldCollision = true;
-							}
-						}
-					}
-				}
-			}
+	// Pack the lists into triangle groups
+	// Tolerances are far larger than the float error of the pre-filter, and than bullet's own edge tolerance
+	constexpr float PLANE_TOLERANCE_BT = 0.01f, EDGE_TOLERANCE_SCALE = 0.01f;
+	Grid::TriangleGroup emptyGroup = {};
+	for (int lane = 0; lane < Grid::TRI_GROUP_SIZE; lane++) {
+		emptyGroup.dist[lane] = -1; // Zero normal, so both ends of any ray are 1 above the plane
+		emptyGroup.triIndex[lane] = UINT32_MAX;
+	}
+
+	worldData->cellTriGroupStart.assign(cellAmount + 1, 0);
+	for (int cellIndex = 0; cellIndex < cellAmount; cellIndex++) {
+		auto& triIndices = cellTriIndices[cellIndex];
+		for (size_t i = 0; i < triIndices.size(); i++) {
+			int lane = i % Grid::TRI_GROUP_SIZE;
+			if (lane == 0)
+				worldData->cellTriGroups.push_back(emptyGroup);
+
+			auto& group = worldData->cellTriGroups.back();
+			auto& tri = worldData->triangles[triIndices[i]];
+
+			btVector3 normal = (tri.verts[1] - tri.verts[0]).cross(tri.verts[2] - tri.verts[0]);
+			for (int vert = 0; vert < 3; vert++)
+				for (int axis = 0; axis < 3; axis++)
+					group.verts[vert][axis][lane] = tri.verts[vert][axis];
+			for (int axis = 0; axis < 3; axis++)
+				group.normal[axis][lane] = normal[axis];
+			group.dist[lane] = tri.verts[0].dot(normal);
+			group.planeTolerance[lane] = normal.length() * PLANE_TOLERANCE_BT;
+			group.edgeTolerance[lane] = -normal.length2() * EDGE_TOLERANCE_SCALE;
+			group.triIndex[lane] = triIndices[i];
+		}
+
+		worldData->cellTriGroupStart[cellIndex + 1] = worldData->cellTriGroups.size();
+	}
+
+	int totalCellsWithin = 0;
+	worldData->worldBits.assign((cellAmount + 63) / 64, 0);
+	for (int i = 0; i < cellAmount; i++) {
+		if (!cellTriIndices[i].empty()) {
+			Grid::SetBit(worldData->worldBits, i, true);
+			totalCellsWithin++;
 		}
 	}
 
-	grid = clone;
+	worldData->meshAmount = triMeshShapes.size();
+	grid.worldData = worldData;
 
 	RS_LOG(
 		"SuspensionCollisionGrid::Setup(): Built suspension collision grid, " <<
-		totalCellsWithin << "/" << grid.CELL_AMOUNT_TOTAL[LIGHT] << " cells contain world collision meshes, " <<
-		"bled to an additional " << totalCellsBled << " surrounding cells."
+		totalCellsWithin << "/" << cellAmount << " cells are near world collision meshes, " <<
+		"with " << totalTriRefs << " triangle references to " << worldData->triangles.size() << " triangles."
 	);
 }
 
@@ -121,108 +150,373 @@ void SuspensionCollisionGrid::SetupWorldCollision(const std::vector<btBvhTriangl
 	}
 }
 
+template <typename T>
+void _WriteRawVector(DataStreamOut& out, const std::vector<T>& vec) {
+	out.Write<uint64_t>(vec.size());
+	out.WriteBytes(vec.data(), vec.size() * sizeof(T));
+}
+
+template <typename T>
+bool _ReadRawVector(DataStreamIn& in, std::vector<T>& vec) {
+	uint64_t size = in.Read<uint64_t>();
+	if (size > in.GetNumBytesLeft() / sizeof(T))
+		return false;
+
+	vec.resize(size);
+	in.ReadBytes(vec.data(), size * sizeof(T));
+	return true;
+}
+
+void SuspensionCollisionGrid::WriteWorldCollision(DataStreamOut& out) const {
+	out.Write<uint32_t>(CELL_AMOUNT_TOTAL[lightMem]);
+	out.Write<bool>(worldData != NULL);
+	if (!worldData)
+		return;
+
+	out.Write<uint64_t>(worldData->meshAmount);
+	_WriteRawVector(out, worldData->worldBits);
+	_WriteRawVector(out, worldData->triangles);
+	_WriteRawVector(out, worldData->cellTriGroupStart);
+	_WriteRawVector(out, worldData->cellTriGroups);
+}
+
+bool SuspensionCollisionGrid::ReadWorldCollision(DataStreamIn& in) {
+	if (in.Read<uint32_t>() != CELL_AMOUNT_TOTAL[lightMem])
+		return false;
+
+	if (!in.Read<bool>()) {
+		worldData = NULL;
+		return !in.IsOverflown();
+	}
+
+	auto newWorldData = std::make_shared<WorldData>();
+	newWorldData->meshAmount = in.Read<uint64_t>();
+	bool valid =
+		_ReadRawVector(in, newWorldData->worldBits) &&
+		_ReadRawVector(in, newWorldData->triangles) &&
+		_ReadRawVector(in, newWorldData->cellTriGroupStart) &&
+		_ReadRawVector(in, newWorldData->cellTriGroups);
+
+	if (!valid || in.IsOverflown())
+		return false;
+
+	// Make sure the cell lists can't index out of bounds
+	int cellAmount = CELL_AMOUNT_TOTAL[lightMem];
+	if (newWorldData->worldBits.size() != (cellAmount + 63) / 64 || newWorldData->cellTriGroupStart.size() != cellAmount + 1)
+		return false;
+
+	if (newWorldData->cellTriGroupStart.back() != newWorldData->cellTriGroups.size())
+		return false;
+
+	for (int i = 0; i < cellAmount; i++)
+		if (newWorldData->cellTriGroupStart[i] > newWorldData->cellTriGroupStart[i + 1])
+			return false;
+
+	for (auto& group : newWorldData->cellTriGroups)
+		for (uint32_t triIndex : group.triIndex)
+			if (triIndex != UINT32_MAX && triIndex >= newWorldData->triangles.size())
+				return false;
+
+	for (auto& tri : newWorldData->triangles)
+		if (tri.meshIndex >= newWorldData->meshAmount)
+			return false;
+
+	worldData = newWorldData;
+	return true;
+}
+
+// Keeps the closest triangle hit, exactly as btCollisionWorld's closest-hit raycasts would
+struct SuspensionRayCallback : public btTriangleRaycastCallback {
+	btVector3 hitNormal; // In the space of the hit rigid body
+	int hitRBIndex = -1;
+	int curRBIndex = -1;
+
+	SuspensionRayCallback(const btVector3& from, const btVector3& to) : btTriangleRaycastCallback(from, to) {}
+
+	virtual btScalar reportHit(const btVector3& hitNormalLocal, btScalar hitFraction, int partId, int triangleIndex) {
+		hitNormal = hitNormalLocal;
+		hitRBIndex = curRBIndex;
+		return hitFraction;
+	}
+};
+
+// Returns a bit for each lane of the group that the ray could possibly hit
+// Conservative: bullet's own test (btTriangleRaycastCallback::processTriangle()) still has the final say
+int _GetTriangleGroupCandidates(const SuspensionCollisionGrid::TriangleGroup& group, const btVector3& from, const btVector3& to) {
+#if defined(__SSE2__) || defined(_M_X64)
+	__m128 
+		fromX = _mm_set1_ps(from.x()), fromY = _mm_set1_ps(from.y()), fromZ = _mm_set1_ps(from.z()),
+		deltaX = _mm_set1_ps(to.x() - from.x()), deltaY = _mm_set1_ps(to.y() - from.y()), deltaZ = _mm_set1_ps(to.z() - from.z());
+
+	__m128 
+		nX = _mm_load_ps(group.normal[0]), nY = _mm_load_ps(group.normal[1]), nZ = _mm_load_ps(group.normal[2]),
+		dist = _mm_load_ps(group.dist);
+
+	auto fnDot = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	};
+
+	// Signed (unnormalized) distances of the ray's ends to each triangle's plane
+	__m128 distFrom = _mm_sub_ps(fnDot(nX, nY, nZ, fromX, fromY, fromZ), dist);
+	__m128 distTo = _mm_add_ps(distFrom, fnDot(nX, nY, nZ, deltaX, deltaY, deltaZ));
+
+	// Ray must reach the plane
+	__m128 planeTol = _mm_load_ps(group.planeTolerance);
+	__m128 crossesPlane = _mm_and_ps(
+		_mm_cmple_ps(_mm_min_ps(distFrom, distTo), planeTol),
+		_mm_cmpge_ps(_mm_max_ps(distFrom, distTo), _mm_sub_ps(_mm_setzero_ps(), planeTol))
+	);
+	if (!_mm_movemask_ps(crossesPlane))
+		return 0;
+
+	// Point where the ray crosses the plane
+	__m128 frac = _mm_div_ps(distFrom, _mm_sub_ps(distFrom, distTo));
+	__m128 fracIsFinite = _mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.f), frac), _mm_set1_ps(FLT_MAX));
+	__m128 pX = _mm_add_ps(fromX, _mm_mul_ps(deltaX, frac)), pY = _mm_add_ps(fromY, _mm_mul_ps(deltaY, frac)), pZ = _mm_add_ps(fromZ, _mm_mul_ps(deltaZ, frac));
+
+	// Point must be (about) within all edges
+	__m128 vpX[3], vpY[3], vpZ[3];
+	for (int i = 0; i < 3; i++) {
+		vpX[i] = _mm_sub_ps(_mm_load_ps(group.verts[i][0]), pX);
+		vpY[i] = _mm_sub_ps(_mm_load_ps(group.verts[i][1]), pY);
+		vpZ[i] = _mm_sub_ps(_mm_load_ps(group.verts[i][2]), pZ);
+	}
+
+	__m128 edgeTol = _mm_load_ps(group.edgeTolerance);
+	__m128 withinEdges = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		__m128 
+			cX = _mm_sub_ps(_mm_mul_ps(vpY[i], vpZ[j]), _mm_mul_ps(vpZ[i], vpY[j])),
+			cY = _mm_sub_ps(_mm_mul_ps(vpZ[i], vpX[j]), _mm_mul_ps(vpX[i], vpZ[j])),
+			cZ = _mm_sub_ps(_mm_mul_ps(vpX[i], vpY[j]), _mm_mul_ps(vpY[i], vpX[j]));
+		withinEdges = _mm_and_ps(withinEdges, _mm_cmpge_ps(fnDot(cX, cY, cZ, nX, nY, nZ), edgeTol));
+	}
+
+	// Rays parallel to the plane can't be checked this way, so keep them
+	return _mm_movemask_ps(_mm_and_ps(crossesPlane, _mm_or_ps(withinEdges, _mm_andnot_ps(fracIsFinite, crossesPlane))));
+#else
+	int result = 0;
+	btVector3 delta = to - from;
+	for (int lane = 0; lane < SuspensionCollisionGrid::TRI_GROUP_SIZE; lane++) {
+		btVector3 normal = btVector3(group.normal[0][lane], group.normal[1][lane], group.normal[2][lane]);
+		float distFrom = normal.dot(from) - group.dist[lane];
+		float distTo = distFrom + normal.dot(delta);
+		float planeTol = group.planeTolerance[lane];
+		if (RS_MIN(distFrom, distTo) > planeTol || RS_MAX(distFrom, distTo) < -planeTol)
+			continue;
+
+		float frac = distFrom / (distFrom - distTo);
+		if (abs(frac) < FLT_MAX) {
+			btVector3 point = from + delta * frac;
+			btVector3 vp[3];
+			for (int i = 0; i < 3; i++)
+				vp[i] = btVector3(group.verts[i][0][lane], group.verts[i][1][lane], group.verts[i][2][lane]) - point;
+
+			bool withinEdges = true;
+			for (int i = 0; i < 3; i++)
+				withinEdges &= vp[i].cross(vp[(i + 1) % 3]).dot(normal) >= group.edgeTolerance[lane];
+			if (!withinEdges)
+				continue;
+		}
+
+		result |= 1 << lane;
+	}
+	return result;
+#endif
+}
+
 template <bool LIGHT>
-btCollisionObject* _CastSuspensionRay(
-	SuspensionCollisionGrid& grid, btVehicleRaycaster* raycaster, 
-	Vec start, Vec end, const btCollisionObject* ignoreObj, btVehicleRaycaster::btVehicleRaycasterResult& result
+bool _TryCastSuspensionRay(
+	const SuspensionCollisionGrid& grid,
+	Vec start, Vec end, const btCollisionObject* ignoreObj, btVehicleRaycaster::btVehicleRaycasterResult& result, btCollisionObject*& hitObj
 ) {
-	SuspensionCollisionGrid::Cell& cell = grid.GetCellFromPos<LIGHT>(start * BT_TO_UU);
+	using Grid = SuspensionCollisionGrid;
+
+	Vec startUU = start * BT_TO_UU;
+	bool startInGrid =
+		abs(startUU.x) < Grid::EXTENT_X && abs(startUU.y) < Grid::EXTENT_Y &&
+		startUU.z > 0 && startUU.z < Grid::HEIGHT;
+
+	constexpr float MAX_RAY_LENGTH_BT = Grid::MAX_RAY_LENGTH * UU_TO_BT;
+	bool rayIsShort = start.DistSq(end) < MAX_RAY_LENGTH_BT * MAX_RAY_LENGTH_BT;
+
+	if (!grid.worldData || !grid.worldCollisionRBs || !startInGrid || !rayIsShort || grid.worldCollisionRBAmount > 64)
+		return false;
+
+	int i, j, k;
+	grid.GetCellIndicesFromPos<LIGHT>(startUU, i, j, k);
+	int cellIndex = Grid::GetCellIndex<LIGHT>(i, j, k);
+
+	// Cars and the ball aren't in the grid, let bullet handle rays that could hit them
+	// The casting car always marks its own cells, so check the objects themselves
+	if (Grid::GetBit(grid.dynamicBits, cellIndex)) {
+		constexpr float DYNAMIC_AABB_MARGIN_BT = 0.1f;
+		btVector3 rayMinBT = start, rayMaxBT = start;
+		rayMinBT.setMin(end);
+		rayMaxBT.setMax(end);
+		rayMinBT -= btVector3(1, 1, 1) * DYNAMIC_AABB_MARGIN_BT;
+		rayMaxBT += btVector3(1, 1, 1) * DYNAMIC_AABB_MARGIN_BT;
+
+		for (auto& dynObj : grid.dynamicObjects) {
+			if (dynObj.obj != ignoreObj && TestAabbAgainstAabb2(rayMinBT, rayMaxBT, dynObj.minBT, dynObj.maxBT))
+				return false;
+		}
+	}
 
-	if (cell.worldCollision || cell.dynamicCollision) {
-		// TODO: Do world-only or dynamic-only raycasts
-		return (btCollisionObject*)raycaster->castRay(start, end, ignoreObj, result);
-	} else {
-		Vec delta = end - start;
-		float dist = delta.Length();
-
-		if (dist == 0)
-			return NULL;
-
-		Vec dir = delta / dist;
-
-		float distToPlane = FLT_MAX;
-		Vec planeNormal;
-		if (end.z <= 0 || end.z >= grid.cache.height_bt) {
-			if (dir.z < 0) {
-				static float groundHitZ = 5.96e-8;
-				distToPlane = (groundHitZ - start.z) / dir.z;
-				planeNormal = Vec(0, 0, 1);
-			} else {
-				distToPlane = (grid.cache.height_bt - start.z) / dir.z; // NOTE: Could theoretically be NAN
-				planeNormal = Vec(0, 0, -1);
-			}
-		} else {
-			if (RS_SGN(dir.x) == RS_SGN(start.x)) {
-				distToPlane = abs(abs(start.x) - grid.cache.extentX_bt) / abs(dir.x);
-				planeNormal = Vec(-RS_SGN(end.x), 0, 0);
-			}
+	// Bullet's own raycast only tests the static objects in the broadphase cell the ray starts in, so we must as well
+	uint64_t rbMask = ~0ull;
+	if (grid.rsBroadphase && start.DistSq(end) < grid.rsBroadphase->cellSizeSq) {
+		rbMask = 0;
+		auto& bpCell = grid.rsBroadphase->cells[grid.rsBroadphase->GetCellIdx(start)];
+		for (btRSBroadphaseProxy* proxy : bpCell.staticHandles) {
+			btRigidBody* rb = (btRigidBody*)proxy->m_clientObject;
+			if (rb >= grid.worldCollisionRBs && rb < grid.worldCollisionRBs + grid.worldCollisionRBAmount)
+				rbMask |= 1ull << (rb - grid.worldCollisionRBs);
+		}
+	}
 
-			if (grid.gameMode == GameMode::HOOPS && RS_SGN(dir.y) == RS_SGN(start.y)) {
-				distToPlane = abs(abs(start.y) - grid.cache.extentY_bt) / abs(dir.y);
-				planeNormal = Vec(0, -RS_SGN(end.y), 0);
-			}
+	SuspensionRayCallback callback = SuspensionRayCallback(start, end);
+
+	// Arena planes come after the meshes
+	const auto& worldData = *grid.worldData;
+	for (size_t rbIndex = worldData.meshAmount; rbIndex < grid.worldCollisionRBAmount; rbIndex++) {
+		btRigidBody& rb = grid.worldCollisionRBs[rbIndex];
+		if (!(rbMask & (1ull << rbIndex)))
+			continue;
+
+		// Plane rigid bodies are never rotated, so this can be done in world space
+		auto planeShape = (btStaticPlaneShape*)rb.getCollisionShape();
+		const btVector3& planeNormal = planeShape->getPlaneNormal();
+		float planeDist = planeShape->getPlaneConstant() + planeNormal.dot(rb.getWorldTransform().getOrigin());
+		float
+			distFrom = planeNormal.dot(start) - planeDist,
+			distTo = planeNormal.dot(end) - planeDist;
+
+#ifdef RS_ANALYTIC_PLANE_RAYS
+		// Solves the ray against the plane directly
+		// Bullet instead raycasts two triangles it makes around the ray, which only gives the same hit up to float rounding
+		// Ends must be strictly on opposite sides, as in btTriangleRaycastCallback::processTriangle()
+		if (distFrom * distTo >= 0)
+			continue;
+
+		float hitFraction = distFrom / (distFrom - distTo);
+		if (hitFraction < callback.m_hitFraction) {
+			callback.m_hitFraction = hitFraction;
+			callback.hitNormal = distFrom > 0 ? planeNormal : -planeNormal; // Faces the side the ray came from
+			callback.hitRBIndex = rbIndex;
+		}
+#else
+		// Skip planes the ray is clearly nowhere near crossing
+		constexpr float PLANE_SKIP_MARGIN_BT = 0.01f;
+		if (RS_MIN(distFrom, distTo) > PLANE_SKIP_MARGIN_BT || RS_MAX(distFrom, distTo) < -PLANE_SKIP_MARGIN_BT)
+			continue;
+
+		// Raycast in the plane's local space, as Bullet would
+		btTransform worldToLocal = rb.getWorldTransform().inverse();
+		btVector3 fromLocal = worldToLocal * start, toLocal = worldToLocal * end;
+
+		SuspensionRayCallback planeCallback = SuspensionRayCallback(fromLocal, toLocal);
+		planeCallback.m_hitFraction = callback.m_hitFraction;
+		planeCallback.curRBIndex = rbIndex;
+
+		btVector3 aabbMinLocal = fromLocal, aabbMaxLocal = fromLocal;
+		aabbMinLocal.setMin(toLocal);
+		aabbMaxLocal.setMax(toLocal);
+		planeShape->processAllTriangles(&planeCallback, aabbMinLocal, aabbMaxLocal);
+
+		if (planeCallback.hitRBIndex != -1) {
+			callback.m_hitFraction = planeCallback.m_hitFraction;
+			callback.hitNormal = planeCallback.hitNormal;
+			callback.hitRBIndex = planeCallback.hitRBIndex;
 		}
+#endif
+	}
 
-		if (distToPlane < dist) {
-			result.m_distFraction = distToPlane / dist;
-			result.m_hitPointInWorld = start + dir * distToPlane;
-			result.m_hitNormalInWorld = planeNormal;
-			return grid.defaultWorldCollisionRB;
-		} else {
-			return NULL;
+	// Mesh rigid bodies have identity transforms, so their triangles are already in world space
+	assert(worldData.meshAmount <= grid.worldCollisionRBAmount);
+	if (Grid::GetBit(worldData.worldBits, cellIndex)) {
+		for (uint32_t groupIdx = worldData.cellTriGroupStart[cellIndex]; groupIdx < worldData.cellTriGroupStart[cellIndex + 1]; groupIdx++) {
+			const Grid::TriangleGroup& group = worldData.cellTriGroups[groupIdx];
+
+			// Candidates are tested in list order, so ties between triangles resolve like before
+			for (int candidates = _GetTriangleGroupCandidates(group, start, end); candidates; candidates &= candidates - 1) {
+				int lane = std::countr_zero((uint32_t)candidates);
+				const Grid::Triangle& tri = worldData.triangles[group.triIndex[lane]];
+				if (!(rbMask & (1ull << tri.meshIndex)))
+					continue;
+
+				callback.curRBIndex = tri.meshIndex;
+				callback.btTriangleRaycastCallback::processTriangle((btVector3*)tri.verts, 0, 0);
+			}
 		}
 	}
+
+	if (callback.hitRBIndex == -1) {
+		hitObj = NULL;
+		return true;
+	}
+
+	// Same results as btDefaultVehicleRaycaster::castRay()
+	btRigidBody* hitRB = &grid.worldCollisionRBs[callback.hitRBIndex];
+	result.m_hitPointInWorld.setInterpolate3(start, end, callback.m_hitFraction);
+	result.m_hitNormalInWorld = hitRB->getWorldTransform().getBasis() * callback.hitNormal;
+	result.m_hitNormalInWorld.normalize();
+	result.m_distFraction = callback.m_hitFraction;
+	hitObj = hitRB;
+	return true;
 }
 
-btCollisionObject* SuspensionCollisionGrid::CastSuspensionRay(btVehicleRaycaster* raycaster, Vec start, Vec end, const btCollisionObject* ignoreObj, btVehicleRaycaster::btVehicleRaycasterResult& result) {
+bool SuspensionCollisionGrid::TryCastSuspensionRay(Vec start, Vec end, const btCollisionObject* ignoreObj, btVehicleRaycaster::btVehicleRaycasterResult& result, btCollisionObject*& hitObj) const {
 	if (lightMem) {
-		return _CastSuspensionRay<true>(*this, raycaster, start, end, ignoreObj, result);
+		return _TryCastSuspensionRay<true>(*this, start, end, ignoreObj, result, hitObj);
 	} else {
-		return _CastSuspensionRay<false>(*this, raycaster, start, end, ignoreObj, result);
+		return _TryCastSuspensionRay<false>(*this, start, end, ignoreObj, result, hitObj);
 	}
 }
 
-template <bool LIGHT>
-void _UpdateDynamicCollisions(SuspensionCollisionGrid& grid, Vec minBT, Vec maxBT, bool remove) {
-	int deltaVal = remove ? -1 : 1;
+btCollisionObject* SuspensionCollisionGrid::CastSuspensionRay(btVehicleRaycaster* raycaster, Vec start, Vec end, const btCollisionObject* ignoreObj, btVehicleRaycaster::btVehicleRaycasterResult& result) {
+	btCollisionObject* hitObj;
+	if (TryCastSuspensionRay(start, end, ignoreObj, result, hitObj))
+		return hitObj;
 
-	int i1, j1, k1;
-	grid.GetCellIndicesFromPos<LIGHT>(minBT * BT_TO_UU - grid.GetCellSize<LIGHT>(), i1, j1, k1);
+	return (btCollisionObject*)raycaster->castRay(start, end, ignoreObj, result);
+}
 
-	int i2, j2, k2;
-	grid.GetCellIndicesFromPos<LIGHT>((maxBT * BT_TO_UU + grid.GetCellSize<LIGHT>()), i2, j2, k2);
+template <bool LIGHT>
+void _UpdateDynamicCollisions(SuspensionCollisionGrid& grid, const btCollisionObject* obj, Vec minBT, Vec maxBT) {
+	using Grid = SuspensionCollisionGrid;
 
-	for (int i = i1; i <= i2; i++)
-		for (int j = j1; j <= j2; j++)
-			for (int k = k1; k <= k2; k++)
-				grid.Get<LIGHT>(i, j, k).dynamicCollision = true;
+	Grid::DynamicObject dynObj = { obj, minBT, maxBT };
+	grid.GetCellIndicesFromPos<LIGHT>(minBT * BT_TO_UU - Vec(1, 1, 1) * Grid::MAX_RAY_LENGTH, dynObj.minX, dynObj.minY, dynObj.minZ);
+	grid.GetCellIndicesFromPos<LIGHT>(maxBT * BT_TO_UU + Vec(1, 1, 1) * Grid::MAX_RAY_LENGTH, dynObj.maxX, dynObj.maxY, dynObj.maxZ);
 
-	grid.dynamicCellRanges.push_back(
-		{
-			i1, j1, k1,
-			i2, j2, k2
-		}
-	);
+	for (int i = dynObj.minX; i <= dynObj.maxX; i++)
+		for (int j = dynObj.minY; j <= dynObj.maxY; j++)
+			for (int k = dynObj.minZ; k <= dynObj.maxZ; k++)
+				Grid::SetBit(grid.dynamicBits, Grid::GetCellIndex<LIGHT>(i, j, k), true);
+
+	grid.dynamicObjects.push_back(dynObj);
 }
 
-void SuspensionCollisionGrid::UpdateDynamicCollisions(Vec minBT, Vec maxBT, bool remove) {
+void SuspensionCollisionGrid::UpdateDynamicCollisions(const btCollisionObject* obj, Vec minBT, Vec maxBT) {
 	if (lightMem) {
-		return _UpdateDynamicCollisions<true>(*this, minBT, maxBT, remove);
+		return _UpdateDynamicCollisions<true>(*this, obj, minBT, maxBT);
 	} else {
-		return _UpdateDynamicCollisions<false>(*this, minBT, maxBT, remove);
+		return _UpdateDynamicCollisions<false>(*this, obj, minBT, maxBT);
 	}
 }
 
 template <bool LIGHT>
 void _ClearDynamicCollisions(SuspensionCollisionGrid& grid) {
-	for (auto& range : grid.dynamicCellRanges) {
-		for (int i = range.minX; i <= range.maxX; i++)
-			for (int j = range.minY; j <= range.maxY; j++)
-				for (int k = range.minZ; k <= range.maxZ; k++)
-					grid.Get<LIGHT>(i, j, k).dynamicCollision = false;
+	for (auto& dynObj : grid.dynamicObjects) {
+		for (int i = dynObj.minX; i <= dynObj.maxX; i++)
+			for (int j = dynObj.minY; j <= dynObj.maxY; j++)
+				for (int k = dynObj.minZ; k <= dynObj.maxZ; k++)
+					SuspensionCollisionGrid::SetBit(grid.dynamicBits, SuspensionCollisionGrid::GetCellIndex<LIGHT>(i, j, k), false);
 	}
 
-	grid.dynamicCellRanges.clear();
+	grid.dynamicObjects.clear();
 }
 
 void SuspensionCollisionGrid::ClearDynamicCollisions() {
@@ -2,6 +2,7 @@
 #include "../Car/Car.h"
 
 class btBvhTriangleMeshShape;
+class btRSBroadphase;
 
 RS_NS_START
 
@@ -28,17 +29,59 @@ struct SuspensionCollisionGrid {
 	// Make sure cell sizes arent't too small, a ray shouldn't be able to travel through multiple cells
 	static_assert(RS_MIN(CELL_SIZE_X[0], RS_MIN(CELL_SIZE_Y[0], CELL_SIZE_Z[0])) > 60, "SuspensionCollisionGrid cells are too small");
 
-	struct Cell {
-		bool 
-			worldCollision = false, 
-			dynamicCollision = false;
+	// Longest ray that can use the cell triangle lists, longer rays go through bullet
+	// Suspension rays are ~40uu
+	constexpr static float MAX_RAY_LENGTH = 60;
+
+	// Candidate world triangle for suspension raycasts, in bullet units
+	struct Triangle {
+		btVector3 verts[3];
+		uint32_t meshIndex; // Index into the arena's world collision rigid bodies
+	};
+
+	constexpr static int TRI_GROUP_SIZE = 4;
+
+	// Structure-of-arrays copies of triangles, used to quickly reject triangles a ray can't hit
+	// Unused lanes have a triIndex of UINT32_MAX and can never pass
+	struct alignas(16) TriangleGroup {
+		float verts[3][3][TRI_GROUP_SIZE]; // [vert][axis][lane]
+		float normal[3][TRI_GROUP_SIZE]; // Not normalized, same as btTriangleRaycastCallback's
+		float dist[TRI_GROUP_SIZE];
+		float planeTolerance[TRI_GROUP_SIZE]; // Generous compared to bullet's, this is only a pre-filter
+		float edgeTolerance[TRI_GROUP_SIZE];
+		uint32_t triIndex[TRI_GROUP_SIZE];
 	};
 
-	struct CellRange {
+	// Read-only world collision data, built once and shared by every arena using this grid
+	struct WorldData {
+		// Bit-packed, set for cells that have any triangles
+		std::vector<uint64_t> worldBits;
+
+		// All triangles of the (non-net) arena meshes, referenced by index from the cells
+		std::vector<Triangle> triangles;
+
+		// Triangles near each cell (within MAX_RAY_LENGTH of it), in groups of TRI_GROUP_SIZE for SIMD
+		// Cell N uses cellTriGroups[cellTriGroupStart[N] ... cellTriGroupStart[N + 1]]
+		std::vector<uint32_t> cellTriGroupStart;
+		std::vector<TriangleGroup> cellTriGroups;
+
+		// Number of meshes given to SetupWorldCollision(), including skipped ones
+		size_t meshAmount = 0;
+	};
+	std::shared_ptr<const WorldData> worldData;
+
+	// Bit-packed, set for cells a ray could reach a car or the ball from this tick
+	// This and dynamicObjects are the only per-arena parts of the grid
+	std::vector<uint64_t> dynamicBits;
+
+	// Cars and the ball this tick, along with the range of cells they marked
+	struct DynamicObject {
+		const btCollisionObject* obj;
+		btVector3 minBT, maxBT;
 		int minX, minY, minZ;
 		int maxX, maxY, maxZ;
 	};
-	std::vector<CellRange> dynamicCellRanges;
+	std::vector<DynamicObject> dynamicObjects;
 
 	struct {
 		float extentX_bt, extentY_bt, height_bt;
@@ -52,16 +95,26 @@ struct SuspensionCollisionGrid {
 		cache.height_bt = (isHoops ? RLConst::ARENA_HEIGHT : RLConst::ARENA_HEIGHT) * UU_TO_BT;
 	}
 
-	std::vector<Cell> cellData;
-
 	void Allocate() {
-		cellData.resize(CELL_AMOUNT_TOTAL[lightMem]);
+		dynamicBits.assign((CELL_AMOUNT_TOTAL[lightMem] + 63) / 64, 0);
 	}
 
 	template <bool LIGHT>
-	Cell& Get(int i, int j, int k) {
-		int index = (i * CELL_AMOUNT_Y[LIGHT] * CELL_AMOUNT_Z[LIGHT]) + (j * CELL_AMOUNT_Z[LIGHT]) + k;
-		return cellData[index];
+	static int GetCellIndex(int i, int j, int k) {
+		return (i * CELL_AMOUNT_Y[LIGHT] * CELL_AMOUNT_Z[LIGHT]) + (j * CELL_AMOUNT_Z[LIGHT]) + k;
+	}
+
+	static bool GetBit(const std::vector<uint64_t>& bits, int index) {
+		return (bits[index / 64] >> (index % 64)) & 1;
+	}
+
+	static void SetBit(std::vector<uint64_t>& bits, int index, bool val) {
+		uint64_t mask = 1ull << (index % 64);
+		if (val) {
+			bits[index / 64] |= mask;
+		} else {
+			bits[index / 64] &= ~mask;
+		}
 	}
 
 	template <bool LIGHT>
@@ -80,26 +133,35 @@ struct SuspensionCollisionGrid {
 		k = (int)RS_CLAMP(pos.z / CELL_SIZE_Z[LIGHT], 0, CELL_AMOUNT_Z[LIGHT] - 1);
 	}
 
-	template <bool LIGHT>
-	Cell& GetCellFromPos(Vec pos) {
-		int i, j, k;
-		GetCellIndicesFromPos<LIGHT>(pos, i, j, k);
-		return Get<LIGHT>(i, j, k);
-	}
-
 	template <bool LIGHT>
 	Vec GetCellSize() const {
 		return Vec(CELL_SIZE_X[LIGHT], CELL_SIZE_Y[LIGHT], CELL_SIZE_Z[LIGHT]);
 	}
 
+	// Hoops net meshes don't collide with cars, and are ignored by suspension raycasts
+	static bool IsHoopsNetMesh(btBvhTriangleMeshShape* mesh);
+
 	void SetupWorldCollision(const std::vector<btBvhTriangleMeshShape*>& triMeshShapes);
 
+	// For caching the result of SetupWorldCollision(), only readable by the same build of RocketSim
+	// ReadWorldCollision() returns false if the data doesn't match this grid
+	void WriteWorldCollision(DataStreamOut& out) const;
+	bool ReadWorldCollision(DataStreamIn& in);
+
+	// Casts a ray using only the grid, returns false if bullet is needed for this ray (it could hit a dynamic object, for example)
+	bool TryCastSuspensionRay(Vec start, Vec end, const btCollisionObject* ignoreObj, btVehicleRaycaster::btVehicleRaycasterResult& result, btCollisionObject*& hitObj) const;
+
 	btCollisionObject* CastSuspensionRay(btVehicleRaycaster* raycaster, Vec start, Vec end, const btCollisionObject* ignoreObj, btVehicleRaycaster::btVehicleRaycasterResult& result);
 	
-	void UpdateDynamicCollisions(Vec minBT, Vec maxBT, bool remove);
+	void UpdateDynamicCollisions(const btCollisionObject* obj, Vec minBT, Vec maxBT);
     void ClearDynamicCollisions();
 
-	btRigidBody* defaultWorldCollisionRB = NULL;
+	// The arena's world collision rigid bodies: meshes first (in the order given to SetupWorldCollision), then planes
+	btRigidBody* worldCollisionRBs = NULL;
+	size_t worldCollisionRBAmount = 0;
+
+	// The arena's broadphase, if it is a btRSBroadphase
+	btRSBroadphase* rsBroadphase = NULL;
 };
 
 RS_NS_END
\ No newline at end of file
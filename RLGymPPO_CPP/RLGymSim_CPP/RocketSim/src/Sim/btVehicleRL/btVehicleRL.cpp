@@ -7,6 +7,10 @@
 #include "../../../libsrc/bullet3-3.24/BulletDynamics/Dynamics/btDynamicsWorld.h"
 #include "../../../libsrc/bullet3-3.24/BulletDynamics/ConstraintSolver/btContactConstraint.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 RS_NS_START
 
 btVehicleRL::btVehicleRL(const btVehicleTuning& tuning, btRigidBody* chassis, btVehicleRaycaster* raycaster, btDynamicsWorld* world)
@@ -115,6 +119,17 @@ void btVehicleRL::updateWheelTransformsWS(btWheelInfoRL& wheel) {
 	wheel.m_raycastInfo.m_wheelAxleWS = chassisTrans.getBasis() * wheel.m_wheelAxleCS;
 }
 
+// Same math as updateWheelTransformsWS(), without modifying the wheel
+void btVehicleRL::getWheelRay(const btWheelInfoRL& wheel, btVector3& source, btVector3& target) const {
+	float suspensionTravel = wheel.m_maxSuspensionTravelCm / 100;
+	float realRayLength = wheel.getSuspensionRestLength() + suspensionTravel + wheel.m_wheelsRadius - RLConst::BTVehicle::SUSPENSION_SUBTRACTION;
+
+	// See: I21
+	btTransform chassisTrans = getChassisWorldTransform();
+	source = chassisTrans(wheel.m_chassisConnectionPointCS);
+	target = source + ((chassisTrans.getBasis() * wheel.m_wheelDirectionCS) * realRayLength);
+}
+
 float btVehicleRL::rayCast(btWheelInfoRL& wheel, SuspensionCollisionGrid* grid) {
 	updateWheelTransformsWS(wheel);
 
@@ -134,11 +149,21 @@ float btVehicleRL::rayCast(btWheelInfoRL& wheel, SuspensionCollisionGrid* grid)
 	
 	btAssert(m_vehicleRaycaster);
 	btCollisionObject* object;
-	if (grid) {
-		object = grid->CastSuspensionRay(m_vehicleRaycaster, source, target, m_chassisBody, rayResults);
+	if (wheel.m_precastRay.valid && wheel.m_precastRay.source == source && wheel.m_precastRay.target == target) {
+		object = wheel.m_precastRay.object;
+		rayResults = wheel.m_precastRay.result;
+	} else if (grid && grid->TryCastSuspensionRay(source, target, m_chassisBody, rayResults, object)) {
+		// Grid found the result without Bullet
 	} else {
 		object = (btCollisionObject*)m_vehicleRaycaster->castRay(source, target, m_chassisBody, rayResults);
+#ifdef RS_PROFILE
+		m_profileBulletRayAmount++;
+#endif
 	}
+	wheel.m_precastRay.valid = false;
+#ifdef RS_PROFILE
+	m_profileRayAmount++;
+#endif
 
 	// See: I23
 	if (object) {
@@ -211,6 +236,34 @@ float btVehicleRL::rayCast(btWheelInfoRL& wheel, SuspensionCollisionGrid* grid)
 	return depth;
 }
 
+void btVehicleRL::precastWheelRays(const SuspensionCollisionGrid* grid) {
+	for (int i = 0; i < m_wheelInfo.size(); i++) {
+		btWheelInfoRL& wheel = m_wheelInfo[i];
+		auto& precast = wheel.m_precastRay;
+		if (grid) {
+			getWheelRay(wheel, precast.source, precast.target);
+			precast.valid = grid->TryCastSuspensionRay(precast.source, precast.target, m_chassisBody, precast.result, precast.object);
+		} else {
+			precast.valid = false;
+		}
+	}
+}
+
+void btVehicleRL::precastRemainingWheelRays() {
+	for (int i = 0; i < m_wheelInfo.size(); i++) {
+		btWheelInfoRL& wheel = m_wheelInfo[i];
+		auto& precast = wheel.m_precastRay;
+		if (!precast.valid) {
+			getWheelRay(wheel, precast.source, precast.target);
+			precast.object = (btCollisionObject*)m_vehicleRaycaster->castRay(precast.source, precast.target, m_chassisBody, precast.result);
+			precast.valid = true;
+#ifdef RS_PROFILE
+			m_profileBulletRayAmount++;
+#endif
+		}
+	}
+}
+
 const btTransform& btVehicleRL::getChassisWorldTransform() const {
 	return getRigidBody()->getCenterOfMassTransform();
 }
@@ -275,31 +328,68 @@ void btVehicleRL::setBrake(float brake, int wheelIndex) {
 
 // See: I24
 void btVehicleRL::updateSuspension(float deltaTime) {
-	
-	for (int i = 0; i < getNumWheels(); i++) {
+	btAssert(getNumWheels() == btWheelLanesRL::NUM_LANES);
+	btWheelLanesRL& lanes = m_wheelLanes;
+
+	for (int i = 0; i < btWheelLanesRL::NUM_LANES; i++) {
 		btWheelInfoRL& wheel_info = m_wheelInfo[i];
+		lanes.restLength[i] = wheel_info.getSuspensionRestLength();
+		lanes.suspensionLength[i] = wheel_info.m_raycastInfo.m_suspensionLength;
+		lanes.stiffness[i] = wheel_info.m_suspensionStiffness;
+		lanes.clippedInvContactDotSuspension[i] = wheel_info.m_clippedInvContactDotSuspension;
+		lanes.relativeVelocity[i] = wheel_info.m_suspensionRelativeVelocity;
+		lanes.dampingCompression[i] = wheel_info.m_wheelsDampingCompression;
+		lanes.dampingRelaxation[i] = wheel_info.m_wheelsDampingRelaxation;
+		lanes.forceScale[i] = wheel_info.m_suspensionForceScale;
+		lanes.inContactMask[i] = wheel_info.m_raycastInfo.m_isInContact ? ~0u : 0;
+	}
+
+#if defined(__SSE2__) || defined(_M_X64)
+	__m128 zero = _mm_setzero_ps();
+	__m128 relVel = _mm_load_ps(lanes.relativeVelocity);
+
+	__m128 force = _mm_mul_ps(
+		_mm_mul_ps(_mm_sub_ps(_mm_load_ps(lanes.restLength), _mm_load_ps(lanes.suspensionLength)), _mm_load_ps(lanes.stiffness)),
+		_mm_load_ps(lanes.clippedInvContactDotSuspension)
+	);
+
+	__m128 isCompressing = _mm_cmplt_ps(relVel, zero);
+	__m128 dampingVelScale = _mm_or_ps(
+		_mm_and_ps(isCompressing, _mm_load_ps(lanes.dampingCompression)),
+		_mm_andnot_ps(isCompressing, _mm_load_ps(lanes.dampingRelaxation))
+	);
+
+	force = _mm_mul_ps(_mm_sub_ps(force, _mm_mul_ps(dampingVelScale, relVel)), _mm_load_ps(lanes.forceScale));
+
+	// RL never uses downwards suspension forces
+	force = _mm_andnot_ps(_mm_cmplt_ps(force, zero), force);
+	force = _mm_and_ps(force, _mm_load_ps((const float*)lanes.inContactMask));
+	_mm_store_ps(lanes.suspensionForce, force);
+#else
+	for (int i = 0; i < btWheelLanesRL::NUM_LANES; i++) {
+		if (lanes.inContactMask[i]) {
+			float force = (lanes.restLength[i] - lanes.suspensionLength[i]) * lanes.stiffness[i] * lanes.clippedInvContactDotSuspension[i];
 
-		if (wheel_info.m_raycastInfo.m_isInContact) {
-			float force =
-				(wheel_info.getSuspensionRestLength() - wheel_info.m_raycastInfo.m_suspensionLength)
-				* wheel_info.m_suspensionStiffness * wheel_info.m_clippedInvContactDotSuspension;
-			
-			float dampingVelScale = (wheel_info.m_suspensionRelativeVelocity < 0) ? wheel_info.m_wheelsDampingCompression : wheel_info.m_wheelsDampingRelaxation;
+			float dampingVelScale = (lanes.relativeVelocity[i] < 0) ? lanes.dampingCompression[i] : lanes.dampingRelaxation[i];
 
-			wheel_info.m_wheelsSuspensionForce = force - (dampingVelScale * wheel_info.m_suspensionRelativeVelocity);
-			wheel_info.m_wheelsSuspensionForce *= wheel_info.m_suspensionForceScale;
+			force -= dampingVelScale * lanes.relativeVelocity[i];
+			force *= lanes.forceScale[i];
 
 			// RL never uses downwards suspension forces
-			if (wheel_info.m_wheelsSuspensionForce < 0)
-				wheel_info.m_wheelsSuspensionForce = 0;
+			if (force < 0)
+				force = 0;
 
+			lanes.suspensionForce[i] = force;
 		} else {
-			wheel_info.m_wheelsSuspensionForce = 0;
+			lanes.suspensionForce[i] = 0;
 		}
 	}
+#endif
 
-	for (int i = 0; i < getNumWheels(); i++) {
+	// Impulses are applied one wheel at a time, in order, since they all add to the chassis
+	for (int i = 0; i < btWheelLanesRL::NUM_LANES; i++) {
 		btWheelInfoRL& wheel = m_wheelInfo[i];
+		wheel.m_wheelsSuspensionForce = lanes.suspensionForce[i];
 		if (wheel.m_wheelsSuspensionForce != 0) {
 			btVector3 contactPointOffset = wheel.m_raycastInfo.m_contactPointWS - getRigidBody()->getCenterOfMassPosition();
 			float baseForceScale = (wheel.m_wheelsSuspensionForce * deltaTime) + wheel.m_extraPushback;
@@ -309,6 +399,86 @@ void btVehicleRL::updateSuspension(float deltaTime) {
 	}
 }
 
+void btVehicleRL::updateFrictionCurveInputs() {
+	btAssert(getNumWheels() == btWheelLanesRL::NUM_LANES);
+	constexpr int NUM_LANES = btWheelLanesRL::NUM_LANES;
+
+	const btVector3& vel = m_chassisBody->m_linearVelocity;
+	const btVector3& angularVel = m_chassisBody->m_angularVelocity;
+	const btVector3& chassisPos = m_chassisBody->m_worldTransform.m_origin;
+
+#if defined(__SSE2__) || defined(_M_X64)
+	// Transpose the wheels' vectors, so each component of all 4 wheels is one register
+	alignas(16) float latDir[3][NUM_LANES], normal[3][NUM_LANES], wheelDelta[3][NUM_LANES];
+	for (int i = 0; i < NUM_LANES; i++) {
+		btWheelInfoRL& wheel = m_wheelInfo[i];
+		btVector3 wheelLatDir = wheel.m_worldTransform.getBasis().getColumn(1);
+		btVector3 wheelDeltaPos = wheel.m_raycastInfo.m_hardPointWS - chassisPos;
+		for (int j = 0; j < 3; j++) {
+			latDir[j][i] = wheelLatDir[j];
+			normal[j][i] = wheel.m_raycastInfo.m_contactNormalWS[j];
+			wheelDelta[j][i] = wheelDeltaPos[j];
+		}
+	}
+
+	__m128
+		latX = _mm_load_ps(latDir[0]), latY = _mm_load_ps(latDir[1]), latZ = _mm_load_ps(latDir[2]),
+		nX = _mm_load_ps(normal[0]), nY = _mm_load_ps(normal[1]), nZ = _mm_load_ps(normal[2]),
+		dX = _mm_load_ps(wheelDelta[0]), dY = _mm_load_ps(wheelDelta[1]), dZ = _mm_load_ps(wheelDelta[2]);
+
+	__m128
+		angX = _mm_set1_ps(angularVel.x()), angY = _mm_set1_ps(angularVel.y()), angZ = _mm_set1_ps(angularVel.z()),
+		velX = _mm_set1_ps(vel.x()), velY = _mm_set1_ps(vel.y()), velZ = _mm_set1_ps(vel.z()),
+		toUU = _mm_set1_ps(BT_TO_UU);
+
+	// Same operation order as btVector3's cross() and dot(), so results match the scalar path exactly
+	auto fnDot = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	};
+	auto fnAbs = [](__m128 v) {
+		return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+	};
+
+	__m128
+		longX = _mm_sub_ps(_mm_mul_ps(latY, nZ), _mm_mul_ps(latZ, nY)),
+		longY = _mm_sub_ps(_mm_mul_ps(latZ, nX), _mm_mul_ps(latX, nZ)),
+		longZ = _mm_sub_ps(_mm_mul_ps(latX, nY), _mm_mul_ps(latY, nX));
+
+	__m128
+		crossX = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(angY, dZ), _mm_mul_ps(angZ, dY)), velX), toUU),
+		crossY = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(angZ, dX), _mm_mul_ps(angX, dZ)), velY), toUU),
+		crossZ = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(angX, dY), _mm_mul_ps(angY, dX)), velZ), toUU);
+
+	__m128 baseFriction = fnAbs(fnDot(crossX, crossY, crossZ, latX, latY, latZ));
+	__m128 longFriction = fnAbs(fnDot(crossX, crossY, crossZ, longX, longY, longZ));
+
+	// Significant friction results in lateral slip
+	__m128 hasSlip = _mm_cmpgt_ps(baseFriction, _mm_set1_ps(5));
+	__m128 slip = _mm_div_ps(baseFriction, _mm_add_ps(longFriction, baseFriction));
+	_mm_store_ps(m_wheelLanes.frictionCurveInput, _mm_and_ps(hasSlip, slip));
+#else
+	for (int i = 0; i < NUM_LANES; i++) {
+		btWheelInfoRL& wheel = m_wheelInfo[i];
+
+		btVector3
+			latDir = wheel.m_worldTransform.getBasis().getColumn(1),
+			longDir = latDir.cross(wheel.m_raycastInfo.m_contactNormalWS);
+
+		btVector3 wheelDelta = wheel.m_raycastInfo.m_hardPointWS - chassisPos;
+		btVector3 crossVec = (angularVel.cross(wheelDelta) + vel) * BT_TO_UU;
+
+		float frictionCurveInput = 0;
+		float baseFriction = abs(crossVec.dot(latDir));
+
+		// Significant friction results in lateral slip
+		if (baseFriction > 5)
+			frictionCurveInput = baseFriction / (abs(crossVec.dot(longDir)) + baseFriction);
+
+		m_wheelLanes.frictionCurveInput[i] = frictionCurveInput;
+	}
+#endif
+}
+
 // See: I25
 void btVehicleRL::calcFrictionImpulses(float timeStep) {
 
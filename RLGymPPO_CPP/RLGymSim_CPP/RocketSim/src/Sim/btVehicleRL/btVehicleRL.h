@@ -21,11 +21,43 @@ struct btWheelInfoRL : public btWheelInfo {
 	// Extra force applied when compressed significantly
 	float m_extraPushback = 0;
 
+	// Suspension ray cast ahead of time by btVehicleRL::precastWheelRays()
+	// Only used by btVehicleRL::rayCast() if the ray is still the same
+	struct {
+		bool valid = false;
+		btVector3 source, target;
+		btCollisionObject* object;
+		btVehicleRaycaster::btVehicleRaycasterResult result;
+	} m_precastRay;
+
 	btWheelInfoRL() {}
 
 	btWheelInfoRL(btWheelInfoConstructionInfo& constructionInfo) : btWheelInfo(constructionInfo) {}
 };
 
+// Per-wheel values that every wheel computes the same way, with one lane per wheel so all 4 are updated together
+// Gathered from btWheelInfoRL each time they are needed, the wheels themselves are still the state that gets copied and restored
+struct btWheelLanesRL {
+	constexpr static int NUM_LANES = 4;
+
+	// Suspension inputs, from btVehicleRL::updateSuspension()
+	alignas(16) float restLength[NUM_LANES];
+	alignas(16) float suspensionLength[NUM_LANES];
+	alignas(16) float stiffness[NUM_LANES];
+	alignas(16) float clippedInvContactDotSuspension[NUM_LANES];
+	alignas(16) float relativeVelocity[NUM_LANES];
+	alignas(16) float dampingCompression[NUM_LANES];
+	alignas(16) float dampingRelaxation[NUM_LANES];
+	alignas(16) float forceScale[NUM_LANES];
+	alignas(16) uint32_t inContactMask[NUM_LANES]; // All bits set if the wheel is in contact
+
+	alignas(16) float suspensionForce[NUM_LANES];
+
+	// Lateral slip of each wheel, from btVehicleRL::updateFrictionCurveInputs()
+	// Only meaningful for wheels with a ground object
+	alignas(16) float frictionCurveInput[NUM_LANES];
+};
+
 // This is a modified version of btRaycastVehicle to more accurately follow Rocket League
 class btVehicleRL : public btActionInterface {
 public:
@@ -61,6 +93,11 @@ public:
 	};
 
 	btVehicleRaycaster* m_vehicleRaycaster;
+
+	// Suspension rays cast, and how many of them needed a Bullet ray test
+	// Only counted if RocketSim is built with RS_PROFILE, Arena::Step() moves them into its profile
+	uint32_t m_profileRayAmount = 0, m_profileBulletRayAmount = 0;
+
 	float m_pitchControl;
 	float m_steeringValue;
 
@@ -86,8 +123,17 @@ public:
 
 	const btTransform& getChassisWorldTransform() const;
 
+	void getWheelRay(const btWheelInfoRL& wheel, btVector3& source, btVector3& target) const;
+
 	float rayCast(btWheelInfoRL& wheel, struct SuspensionCollisionGrid* grid);
 
+	// Casts all wheel rays that the grid can handle on its own, so the arena can do every car's together
+	// Pass a null grid to just discard previous results
+	void precastWheelRays(const struct SuspensionCollisionGrid* grid);
+
+	// Casts the wheel rays that weren't precast with Bullet, so that rayCast() won't need to
+	void precastRemainingWheelRays();
+
 	void updateVehicleFirst(float step, struct SuspensionCollisionGrid* grid);
 	void updateVehicleSecond(float step);
 
@@ -113,6 +159,9 @@ public:
 
 	btAlignedObjectArray<btWheelInfoRL> m_wheelInfo;
 
+	// Scratch lanes for the per-wheel math, see btWheelLanesRL
+	btWheelLanesRL m_wheelLanes;
+
 	const btWheelInfoRL& getWheelInfo(int index) const;
 
 	btWheelInfoRL& getWheelInfo(int index);
@@ -127,6 +176,10 @@ public:
 
 	void updateSuspension(float deltaTime);
 
+	// Finds how much each wheel is slipping sideways, from the chassis velocity at the wheel
+	// Results go in m_wheelLanes.frictionCurveInput, as the input of RL's friction curves
+	void updateFrictionCurveInputs();
+
 	virtual void calcFrictionImpulses(float timeStep);
 	void applyFrictionImpulses(float timeStep);
 
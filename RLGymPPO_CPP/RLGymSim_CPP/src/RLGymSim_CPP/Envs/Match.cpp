@@ -1,32 +1,119 @@
 #include "Match.h"
 
 namespace RLGSC {
+	void Match::SetScripted(int carIndex, ScriptedController* controller) {
+		if (carIndex < 0 || carIndex >= GetCarAmount())
+			RG_ERR_CLOSE("Match::SetScripted(): Invalid car index (" << carIndex << "), there are " << GetCarAmount() << " cars");
+
+		auto itr = std::find(policyPlayers.begin(), policyPlayers.end(), carIndex);
+		if (itr == policyPlayers.end())
+			RG_ERR_CLOSE("Match::SetScripted(): Car " << carIndex << " is already scripted");
+
+		policyPlayers.erase(itr);
+		playerAmount = policyPlayers.size();
+
+		for (auto& group : scriptedGroups) {
+			if (group.controller == controller) {
+				group.players.push_back(carIndex);
+				return;
+			}
+		}
+		scriptedGroups.push_back({ controller, { carIndex } });
+	}
+
+	void Match::SetScriptedControls(const GameState& state, Arena* arena) {
+		for (auto& group : scriptedGroups) {
+			_scriptedControls.resize(group.players.size());
+			group.controller->GetControls(state, group.players, _scriptedControls.data());
+
+			for (int i = 0; i < group.players.size(); i++) {
+				int player = group.players[i];
+				arena->_cars[player]->controls = _scriptedControls[i];
+				prevActions[player] = Action(_scriptedControls[i]);
+			}
+		}
+	}
+
 	void Match::EpisodeReset(const GameState& initialState) {
 		prevActions = ActionSet(initialState.players.size());
 		for (auto cond : terminalConditions)
 			cond->Reset(initialState);
 		rewardFn->Reset(initialState);
 		obsBuilder->Reset(initialState);
+		for (auto& group : scriptedGroups)
+			group.controller->Reset(initialState);
+		stateFields = GetStateFields();
+	}
+
+	StateFields Match::GetStateFields() {
+		StateFields result = extraStateFields;
+		result |= rewardFn->GetStateFields();
+		result |= obsBuilder->GetStateFields();
+		result |= actionParser->GetStateFields();
+		for (auto cond : terminalConditions)
+			result |= cond->GetStateFields();
+		for (auto& group : scriptedGroups)
+			result |= group.controller->GetStateFields();
+		return result;
 	}
 
 	FList2 Match::BuildObservations(const GameState& state) {
-		auto result = FList2(state.players.size());
+		auto result = FList2(playerAmount);
 
 		obsBuilder->PreStep(state);
 
-		for (int i = 0; i < state.players.size(); i++) {
+		for (int i = 0; i < playerAmount; i++) {
+			int player = policyPlayers[i];
 			result[i] =
-				obsBuilder->BuildOBS(state.players[i], state, prevActions[i]);
+				obsBuilder->BuildOBS(state.players[player], state, prevActions[player]);
 		}
 
 		return result;
 	}
 
+	void Match::BuildObservationsInto(const GameState& state, float* out, int obsSize) {
+		obsBuilder->PreStep(state);
+
+		int builderOBSSize = obsBuilder->GetOBSSize(state);
+		if (builderOBSSize != -1 && builderOBSSize != obsSize) {
+			RG_ERR_CLOSE(
+				"Match::BuildObservationsInto(): OBS builder has an OBS size of " << builderOBSSize <<
+				", expected " << obsSize <<
+				" (to mix games of different team sizes, use an OBS builder with a fixed size, i.e. DefaultOBSPadded)"
+			);
+		}
+
+		for (int i = 0; i < playerAmount; i++) {
+			int player = policyPlayers[i];
+			auto playerOut = std::span<float>(out + (size_t)i * obsSize, obsSize);
+			obsBuilder->BuildOBSInto(playerOut, state.players[player], state, prevActions[player]);
+		}
+	}
+
 	FList Match::GetRewards(const GameState& state, bool done) {
-		auto result = FList(state.players.size());
+		rewardFn->PreStep(state);
+		FList allRewards = rewardFn->GetAllRewards(state, prevActions, done);
+		if (scriptedGroups.empty())
+			return allRewards;
 
+		FList result = FList(playerAmount);
+		for (int i = 0; i < playerAmount; i++)
+			result[i] = allRewards[policyPlayers[i]];
+		return result;
+	}
+
+	void Match::GetRewardsInto(const GameState& state, bool done, float* out) {
 		rewardFn->PreStep(state);
-		return rewardFn->GetAllRewards(state, prevActions, done);
+		if (scriptedGroups.empty()) {
+			rewardFn->GetAllRewardsInto(state, prevActions, done, out);
+			return;
+		}
+
+		// Rewards are of every car, such as for zero-sum rewards, we only keep those of our players
+		_allRewards.resize(state.players.size());
+		rewardFn->GetAllRewardsInto(state, prevActions, done, _allRewards.data());
+		for (int i = 0; i < playerAmount; i++)
+			out[i] = _allRewards[policyPlayers[i]];
 	}
 
 	bool Match::IsDone(const GameState& state) {
@@ -45,13 +132,17 @@ namespace RLGSC {
 		return actionParser->ParseActions(actionsData, gameState);
 	}
 
+	void Match::ParseActionsInto(const ActionParser::Input& actionsData, const GameState& gameState, ActionSet& out) {
+		actionParser->ParseActionsInto(actionsData, gameState, out);
+	}
+
 	GameState Match::ResetState(Arena* arena) {
-		GameState newState = stateSetter->ResetState(arena);
+		GameState newState = stateSetter->ResetState(arena, randEngine);
 
-		if (newState.players.size() != playerAmount) {
+		if (newState.players.size() != GetCarAmount()) {
 			RG_ERR_CLOSE(
 				"Match::ResetState(): New state has a different amount of players, "
-				"expected " << playerAmount << " but got " << newState.players.size() << ".\n"
+				"expected " << GetCarAmount() << " but got " << newState.players.size() << ".\n"
 				"Changing number of players at state reset is currently not supported.\n" <<
 				"If you want variable player amounts, set a differing player amount per env."
 			);
@@ -6,6 +6,7 @@
 #include "../Utils/OBSBuilders/OBSBuilder.h"
 #include "../Utils/ActionParsers/ActionParser.h"
 #include "../Utils/StateSetters/StateSetter.h"
+#include "../Utils/ScriptedControllers/ScriptedController.h"
 
 namespace RLGSC {
 
@@ -20,10 +21,41 @@ namespace RLGSC {
 
 		int teamSize;
 		bool spawnOpponents;
+
+		// Players controlled by the policy, which get observations, actions and rewards
+		// This is every car, minus those controlled by scripted controllers (see SetScripted())
 		int playerAmount;
 
+		// Index of each player the policy controls in the state's players ([playerAmount])
+		// Observations, actions and rewards are in this order
+		IList policyPlayers;
+
+		// Cars controlled by each scripted controller, as indices in the state's players
+		struct ScriptedGroup {
+			ScriptedController* controller;
+			IList players;
+		};
+		std::vector<ScriptedGroup> scriptedGroups;
+
+		// Reused every step, only with scripted cars
+		ActionSet _policyActions;
+		FList _allRewards;
+		std::vector<CarControls> _scriptedControls;
+
+		// Last action of every car, including scripted cars
 		ActionSet prevActions;
 
+		// Fields of the state needed by things other than our OBS builder, rewards, terminal conditions and action parser
+		// Set this if you read the gym's states yourself (i.e. from a step callback), see StateFields
+		StateFields extraStateFields = StateFields::NONE;
+
+		// Fields of the state filled each step, updated from GetStateFields() on every EpisodeReset()
+		StateFields stateFields = StateFields::ALL;
+
+		// Random engine of this game, given to the state setter on reset
+		// Randomly seeded, seed it for reproducible resets
+		Math::RandEngine randEngine = Math::RandEngine(Math::GetRandEngine()());
+
 		Match(
 			RewardFunction* rewardFn,
 			std::vector<TerminalCondition*> terminalConditions,
@@ -43,14 +75,47 @@ namespace RLGSC {
 			playerAmount(teamSize * (spawnOpponents ? 2 : 1))
 		{
 			prevActions.resize(playerAmount);
+			for (int i = 0; i < playerAmount; i++)
+				policyPlayers.push_back(i);
+		}
+
+		// Cars of the arena, including scripted cars
+		int GetCarAmount() const {
+			return teamSize * (spawnOpponents ? 2 : 1);
 		}
 
+		// Has a controller drive a car instead of the policy, the car is removed from the players the policy controls
+		// carIndex is the car's index in the state's players, which are in the order the gym added the cars (alternating blue and orange)
+		// A controller can drive multiple cars, and is given all of them at once
+		// NOTE: Must be called before the gym is used, i.e. in your env create function, as it changes playerAmount
+		// NOTE: The controller isn't owned by the match
+		void SetScripted(int carIndex, ScriptedController* controller);
+
+		// Sets the controls of every scripted car from the state before the step
+		void SetScriptedControls(const GameState& state, Arena* arena);
+
 		void EpisodeReset(const GameState& initialState);
+
+		// Union of the fields needed by everything that reads our states, and extraStateFields
+		StateFields GetStateFields();
+
+		// Adds to extraStateFields, starting from the next step
+		void AddExtraStateFields(StateFields fields) {
+			extraStateFields |= fields;
+			stateFields |= fields;
+		}
+
 		FList2 BuildObservations(const GameState& state);
+
+		// Observations and rewards are only of the players the policy controls (see policyPlayers)
+		// Writes the observations of all players directly into "out", which must be [playerAmount][obsSize]
+		void BuildObservationsInto(const GameState& state, float* out, int obsSize);
 		FList GetRewards(const GameState& state, bool done);
+		void GetRewardsInto(const GameState& state, bool done, float* out); // out is [playerAmount]
 		bool IsDone(const GameState& state);
 		ScoreLine GetScoreLine(const GameState& state);
 		ActionSet ParseActions(const ActionParser::Input& actionsData, const GameState& gameState);
+		void ParseActionsInto(const ActionParser::Input& actionsData, const GameState& gameState, ActionSet& out);
 		GameState ResetState(Arena* arena);
 	};
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #define RS_DONT_LOG // Prevent annoying log spam
 #include "../RocketSim/src/RocketSim.h"
 #include "../RocketSim/src/Sim/GameEventTracker/GameEventTracker.h"
+#include "../RocketSim/src/Sim/BallPredTracker/BallPredBatch.h"
+
+#include <span>
 
 // Use RocketSim namespace
 using namespace RocketSim;
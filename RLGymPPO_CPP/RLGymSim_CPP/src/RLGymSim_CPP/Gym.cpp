@@ -1,104 +1,368 @@
 #include "Gym.h"
+#include "Utils/AllocTracker/AllocTracker.h"
 
 namespace RLGSC {
 
-	template<int PlayerData::* DATA_VAR>
-	void IncPlayerCounter(Car* car, void* userInfo) {
-		if (!car)
-			return;
+	// Adds the events that the arena queued during the last step to the counters of their players
+	void _ApplyArenaEvents(Gym* gym) {
+		auto& events = gym->arena->_eventQueue;
+		auto& players = gym->prevState.players;
+		for (const ArenaEvent& event : events) {
+			PlayerData& player = players[gym->_carIDToPlayer[event.carID]];
+			PlayerData* otherPlayer = event.otherCarID ? &players[gym->_carIDToPlayer[event.otherCarID]] : NULL;
 
-		Gym* gym = (Gym*)userInfo;
-		for (auto& player : gym->prevState.players)
-			if (player.carId == car->id)
-				(player.*DATA_VAR)++;
+			switch (event.type) {
+			case ArenaEvent::Type::BUMP:
+			case ArenaEvent::Type::DEMO:
+				if (player.team != otherPlayer->team) {
+					player.matchBumps++;
+					if (event.type == ArenaEvent::Type::DEMO)
+						player.matchDemos++;
+				}
+				break;
+			case ArenaEvent::Type::SHOT:
+				player.matchShots++;
+				if (otherPlayer)
+					otherPlayer->matchShotPasses++;
+				break;
+			case ArenaEvent::Type::GOAL:
+				player.matchGoals++;
+				if (otherPlayer)
+					otherPlayer->matchAssists++;
+				break;
+			case ArenaEvent::Type::SAVE:
+				player.matchSaves++;
+				break;
+			}
+		}
+		events.clear();
 	}
 
-	void _ShotEventCallback(Arena* arena, Car* shooter, Car* passer, void* userInfo) {
-		IncPlayerCounter<&PlayerData::matchShots>(shooter, userInfo);
-		IncPlayerCounter<&PlayerData::matchShotPasses>(passer, userInfo);
-	}
+	Gym::Gym(Match* match, int tickSkip, CarConfig carConfig, GameMode gameMode, MutatorConfig mutatorConfig, const ArenaConfig& arenaConfig, float tickRate) :
+		match(match), tickSkip(tickSkip), carConfig(carConfig) {
+		if (tickRate < 15 || tickRate > 120)
+			RG_ERR_CLOSE("Gym::Gym(): Tick rate must be from 15 to 120, got " << tickRate);
+
+		arena = Arena::Create(gameMode, arenaConfig, tickRate);
+		arena->SetMutatorConfig(mutatorConfig);
+
+		for (int i = 0; i < match->teamSize; i++) {
+			arena->AddCar(Team::BLUE, carConfig);
+			if (match->spawnOpponents)
+				arena->AddCar(Team::ORANGE, carConfig);
+		}
 
-	void _GoalEventCallback(Arena* arena, Car* scorer, Car* passer, void* userInfo) {
-		IncPlayerCounter<&PlayerData::matchGoals>(scorer, userInfo);
-		IncPlayerCounter<&PlayerData::matchAssists>(passer, userInfo);
+		// Events are queued by the arena and tracker, then applied once per step
+		arena->queueEvents = true;
+		_UpdateCarIDMap();
 	}
 
-	void _SaveEventCallback(Arena* arena, Car* saver, void* userInfo) {
-		IncPlayerCounter<&PlayerData::matchSaves>(saver, userInfo);
+	void Gym::_UpdateCarIDMap() {
+		for (int i = 0; i < arena->_cars.size(); i++) {
+			uint32_t id = arena->_cars[i]->id;
+			if (id >= _carIDToPlayer.size())
+				_carIDToPlayer.resize(id + 1, -1);
+			_carIDToPlayer[id] = i;
+		}
 	}
 
-	void _BumpCallback(Arena* arena, Car* bumper, Car* victim, bool isDemo, void* userInfo) {
-		if (bumper->team == victim->team)
+	void Gym::_ApplySwap() {
+		_hasPendingSwap = false;
+		EnvSwap swap = _pendingSwap;
+		_pendingSwap = {};
+
+		if (swap.rewardFn)
+			match->rewardFn = swap.rewardFn;
+		if (!swap.terminalConditions.empty())
+			match->terminalConditions = swap.terminalConditions;
+		if (swap.obsBuilder)
+			match->obsBuilder = swap.obsBuilder;
+		if (swap.stateSetter)
+			match->stateSetter = swap.stateSetter;
+
+		// A reset made ahead was made by the old components
+		_standbyReady = false;
+
+		if (swap.teamSize < 0 || swap.teamSize == match->teamSize)
 			return;
 
-		IncPlayerCounter<&PlayerData::matchBumps>(bumper, userInfo);
+		if (swap.teamSize < 1)
+			RG_ERR_CLOSE("Gym::_ApplySwap(): Team size must be at least 1, got " << swap.teamSize);
+		if (!match->scriptedGroups.empty())
+			RG_ERR_CLOSE("Gym::_ApplySwap(): Can't change the team size of a match with scripted cars");
 
-		if (isDemo)
-			IncPlayerCounter<&PlayerData::matchDemos>(bumper, userInfo);
-	}
+		// Cars are in the order the constructor adds them, so the cars of the last team slots are at the end
+		match->teamSize = swap.teamSize;
+		int carAmount = match->GetCarAmount();
+		while (arena->_cars.size() > carAmount)
+			arena->RemoveCar(arena->_cars.back());
+		while (arena->_cars.size() < carAmount) {
+			Team team = (match->spawnOpponents && (arena->_cars.size() % 2) == 1) ? Team::ORANGE : Team::BLUE;
+			arena->AddCar(team, carConfig);
+		}
 
-	Gym::Gym(Match* match, int tickSkip, CarConfig carConfig, GameMode gameMode, MutatorConfig mutatorConfig) :
-		match(match), tickSkip(tickSkip) {
-		arena = Arena::Create(gameMode);
-		arena->SetMutatorConfig(mutatorConfig);
+		// Touches of removed cars can't be looked up anymore
+		for (auto& touches : arena->_teamBallTouches)
+			touches.isValid = false;
 
-		for (int i = 0; i < match->teamSize; i++) {
-			arena->AddCar(Team::BLUE, carConfig);
-			if (match->spawnOpponents)
-				arena->AddCar(Team::ORANGE, carConfig);
+		match->playerAmount = carAmount;
+		match->policyPlayers.resize(carAmount);
+		for (int i = 0; i < carAmount; i++)
+			match->policyPlayers[i] = i;
+		match->prevActions.resize(carAmount);
+
+		_UpdateCarIDMap();
+
+		// Our fork has the old cars
+		delete _standbyArena;
+		_standbyArena = NULL;
+	}
+
+	FList2 Gym::BuildObservations(const GameState& state) {
+		RG_ALLOC_SCOPE(OBS);
+		if (obsOutput) {
+			match->BuildObservationsInto(state, obsOutput, obsOutputSize);
+			return {};
+		} else {
+			return match->BuildObservations(state);
 		}
+	}
+
+	void Gym::PrepareReset() {
+		if (!resetAhead || _standbyReady)
+			return;
 
-		eventTracker.SetShotCallback(_ShotEventCallback, this);
-		eventTracker.SetGoalCallback(_GoalEventCallback, this);
-		eventTracker.SetSaveCallback(_SaveEventCallback, this);
+		if (!_standbyArena)
+			_standbyArena = arena->Fork();
 
-		arena->SetCarBumpCallback(_BumpCallback, this);
+		match->ResetState(_standbyArena);
+		_standbyArena->TakeSnapshot(_standbySnapshot);
+		_standbyReady = true;
 	}
 
 	FList2 Gym::Reset() {
-		GameState resetState = match->ResetState(arena);
+		RG_ALLOC_SCOPE(SIM);
+		auto resetStartTime = std::chrono::steady_clock::now();
+
+		if (_hasPendingSwap)
+			_ApplySwap();
+
+		GameState resetState;
+		if (resetAhead) {
+			PrepareReset();
+			arena->RestoreSnapshot(_standbySnapshot);
+			arena->_ClearContactCache(); // So the episode doesn't depend on contacts from the last one
+			_standbyReady = false;
+			resetState = GameState(arena);
+		} else {
+			resetState = match->ResetState(arena);
+		}
+
+		arena->_eventQueue.clear();
 		match->EpisodeReset(resetState);
 		prevState = resetState;
 		eventTracker.ResetPersistentInfo();
 
-		FList2 obs = match->BuildObservations(resetState);
+		FList2 obs = BuildObservations(resetState);
+		resetTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - resetStartTime).count();
+		resets++;
 		return obs;
 	}
 
-	Gym::StepResult Gym::Step(const ActionParser::Input& actionsData) {
-		ActionSet actions = match->ParseActions(actionsData, prevState);
-		match->prevActions = actions;
+	void _SetActions(Gym* gym, const ActionParser::Input& actionsData) {
+		auto match = gym->match;
+		auto arena = gym->arena;
+
+		// Cars are in the order they were added, same as the players of our states
+		if (match->scriptedGroups.empty()) {
+			match->ParseActionsInto(actionsData, gym->prevState, match->prevActions);
+			auto& actions = match->prevActions;
+			for (int i = 0; i < actions.size(); i++)
+				arena->_cars[i]->controls = (CarControls)actions[i];
+		} else {
+			// Actions are only of the players the policy controls
+			match->ParseActionsInto(actionsData, gym->prevState, match->_policyActions);
+			for (int i = 0; i < match->playerAmount; i++) {
+				int player = match->policyPlayers[i];
+				match->prevActions[player] = match->_policyActions[i];
+				arena->_cars[player]->controls = (CarControls)match->_policyActions[i];
+			}
+			match->SetScriptedControls(gym->prevState, arena);
+		}
+	}
 
-		GameState state;
+	void _SetActions(Gym* gym, const int64_t* actions) {
+		auto match = gym->match;
+		auto arena = gym->arena;
 
-		{ // Step arena with actions
-			auto carItr = arena->_cars.begin();
-			for (int i = 0; i < actions.size(); i++) {
-				(*carItr)->controls = (CarControls)actions[i];
-				carItr++;
+		const Action* actionTable = match->actionParser->GetActionTable();
+		const CarControls* controlsTable = match->actionParser->GetControlsTable();
+		if (actionTable && controlsTable) {
+			for (int i = 0; i < match->playerAmount; i++) {
+				int player = match->policyPlayers[i];
+				match->prevActions[player] = actionTable[actions[i]];
+				arena->_cars[player]->controls = controlsTable[actions[i]];
 			}
+			match->SetScriptedControls(gym->prevState, arena);
+		} else {
+			gym->_actionInput.assign(actions, actions + match->playerAmount);
+			_SetActions(gym, gym->_actionInput);
+		}
+	}
+
+	// Seconds since startTime, and resets startTime to now
+	double _Lap(std::chrono::steady_clock::time_point& startTime) {
+		auto now = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double>(now - startTime).count();
+		startTime = now;
+		return elapsed;
+	}
+
+	// Steps the arena with the actions, and updates prevState
+	template <typename T>
+	void _StepArena(Gym* gym, const T& actions) {
+		RG_ALLOC_SCOPE(SIM);
+		auto startTime = std::chrono::steady_clock::now();
+		auto arena = gym->arena;
+		_SetActions(gym, actions);
 
-			arena->Step(1);
-			if (arena->gameMode != GameMode::HEATSEEKER)
-				eventTracker.Update(arena);
-			state = prevState; // All callbacks have been hit
-			state.UpdateFromArena(arena);
-			arena->Step(tickSkip - 1);
-			totalTicks += tickSkip;
-			totalSteps++;
+		arena->Step(1);
+		if (arena->gameMode != GameMode::HEATSEEKER)
+			gym->eventTracker.Update(arena);
+		gym->_nextState = gym->prevState; // All callbacks have been hit, reuses the memory of our second state
+		gym->_nextState.UpdateFromArena(arena, gym->match->stateFields);
+		if (gym->adaptiveStep) {
+			arena->StepAdaptive(gym->tickSkip - 1, gym->adaptiveStepConfig);
+		} else {
+			arena->Step(gym->tickSkip - 1);
 		}
+		std::swap(gym->prevState, gym->_nextState);
+		_ApplyArenaEvents(gym);
+		gym->totalTicks += gym->tickSkip;
+		gym->totalSteps++;
+		gym->simTime += _Lap(startTime);
+	}
+
+	template <typename T>
+	Gym::StepResult _Step(Gym* gym, const T& actions) {
+		_StepArena(gym, actions);
 
-		FList2 obs = match->BuildObservations(state);
-		bool done = match->IsDone(state);
-		FList rewards = match->GetRewards(state, done);
-		prevState = state;
-		
+		auto& state = gym->prevState;
+		auto startTime = std::chrono::steady_clock::now();
+		FList2 obs = gym->BuildObservations(state);
+		gym->obsBuildTime += _Lap(startTime);
+		bool done;
+		FList rewards;
+		{
+			RG_ALLOC_SCOPE(REWARD);
+			done = gym->match->IsDone(state);
+			gym->terminalTime += _Lap(startTime);
+			rewards = gym->match->GetRewards(state, done);
+			gym->rewardTime += _Lap(startTime);
+		}
 
-		return StepResult {
+		return Gym::StepResult {
 			obs,
 			rewards,
 			done,
 			state
 		};
 	}
+
+	template <typename T>
+	void _StepInto(Gym* gym, const T& actions, float* outRewards, bool& outDone) {
+		if (!gym->obsOutput)
+			RG_ERR_CLOSE("Gym::StepInto(): No OBS output is set, use SetOBSOutput() first");
+
+		_StepArena(gym, actions);
+		gym->FinishStepInto(outRewards, outDone);
+	}
+
+	Gym::StepResult Gym::Step(const ActionParser::Input& actionsData) {
+		return _Step(this, actionsData);
+	}
+
+	Gym::StepResult Gym::Step(const int64_t* actions) {
+		return _Step(this, actions);
+	}
+
+	void Gym::StepInto(const ActionParser::Input& actionsData, float* outRewards, bool& outDone) {
+		_StepInto(this, actionsData, outRewards, outDone);
+	}
+
+	void Gym::StepInto(const int64_t* actions, float* outRewards, bool& outDone) {
+		_StepInto(this, actions, outRewards, outDone);
+	}
+
+	void Gym::StepArena(const int64_t* actions) {
+		_StepArena(this, actions);
+	}
+
+	void Gym::StepArenas(Gym* const* gyms, size_t amount, const int64_t* const* actions) {
+		RG_ALLOC_SCOPE(SIM);
+
+		// Stepping gyms on their own keeps them in order with each other, and the rest never draw from the shared random generator
+		thread_local std::vector<Gym*> interleaved = {};
+		thread_local std::vector<Arena*> arenas = {};
+		interleaved.clear();
+		arenas.clear();
+		int tickSkip = 0;
+		for (size_t i = 0; i < amount; i++) {
+			Gym* gym = gyms[i];
+			bool canInterleave =
+				!gym->adaptiveStep && (tickSkip == 0 || gym->tickSkip == tickSkip) &&
+				!gym->arena->_MayRespawnCarsWithin(gym->tickSkip);
+
+			if (canInterleave) {
+				_SetActions(gym, actions[i]);
+				interleaved.push_back(gym);
+				arenas.push_back(gym->arena);
+				tickSkip = gym->tickSkip;
+			} else {
+				_StepArena(gym, actions[i]);
+			}
+		}
+
+		if (interleaved.empty())
+			return;
+
+		// Same as _StepArena(), one stage at a time
+		auto startTime = std::chrono::steady_clock::now();
+		Arena::StepMultiple(arenas.data(), arenas.size(), 1);
+		for (Gym* gym : interleaved) {
+			if (gym->arena->gameMode != GameMode::HEATSEEKER)
+				gym->eventTracker.Update(gym->arena);
+			gym->_nextState = gym->prevState;
+			gym->_nextState.UpdateFromArena(gym->arena, gym->match->stateFields);
+		}
+		Arena::StepMultiple(arenas.data(), arenas.size(), tickSkip - 1);
+		for (Gym* gym : interleaved) {
+			std::swap(gym->prevState, gym->_nextState);
+			_ApplyArenaEvents(gym);
+			gym->totalTicks += gym->tickSkip;
+			gym->totalSteps++;
+		}
+
+		// Shared evenly, as the time of each arena can't be told apart
+		double simTime = _Lap(startTime) / interleaved.size();
+		for (Gym* gym : interleaved)
+			gym->simTime += simTime;
+	}
+
+	void Gym::FinishStepInto(float* outRewards, bool& outDone) {
+		if (!obsOutput)
+			RG_ERR_CLOSE("Gym::FinishStepInto(): No OBS output is set, use SetOBSOutput() first");
+
+		auto startTime = std::chrono::steady_clock::now();
+		{
+			RG_ALLOC_SCOPE(OBS);
+			match->BuildObservationsInto(prevState, obsOutput, obsOutputSize);
+		}
+		obsBuildTime += _Lap(startTime);
+		RG_ALLOC_SCOPE(REWARD);
+		outDone = match->IsDone(prevState);
+		terminalTime += _Lap(startTime);
+		match->GetRewardsInto(prevState, outDone, outRewards);
+		rewardTime += _Lap(startTime);
+	}
 }
\ No newline at end of file
@@ -2,24 +2,126 @@
 #include "Envs/Match.h"
 
 namespace RLGSC {
+	// Components swapped into a gym's match at the start of its next episode (see Gym::QueueSwap())
+	// Anything left unset is kept
+	struct EnvSwap {
+		RewardFunction* rewardFn = NULL;
+		std::vector<TerminalCondition*> terminalConditions = {}; // Kept if empty
+		OBSBuilder* obsBuilder = NULL; // Must make observations of the same size
+		StateSetter* stateSetter = NULL;
+		int teamSize = -1;
+	};
+
 	class Gym {
 	public:
 		Arena* arena;
 		GameEventTracker eventTracker;
 		Match* match;
+
+		// Arena ticks per step
+		// This counts ticks at the arena's tick rate, so at 60Hz a tickSkip of 4 covers as much game time as 8 does at 120Hz
 		int tickSkip;
+
+		// If set, every tick of a step after the first is stepped with Arena::StepAdaptive(), which is faster in quiet phases of play but approximate
+		// The first tick is always stepped normally, since the step's events are tracked after it
+		bool adaptiveStep = false;
+		AdaptiveStepConfig adaptiveStepConfig = {};
+
 		GameState prevState;
+		// Second state buffer for stepping, swapped with prevState every step so that steps don't need to allocate
+		GameState _nextState;
 		std::vector<uint32_t> carIds;
+		// Index of each car's player in our states, by car ID
+		IList _carIDToPlayer;
+
+		// Action indices copied into a list for parsers without lookup tables, reused every step
+		ActionParser::Input _actionInput;
 
 		int totalTicks = 0;
 		int totalSteps = 0;
 
-		Gym(Match* match, int tickSkip, CarConfig carConfig = CAR_CONFIG_OCTANE, GameMode gameMode = GameMode::SOCCAR, MutatorConfig mutatorConfig = MutatorConfig(GameMode::SOCCAR));
+		// Total time spent stepping the arena and updating the state in Step() and StepInto(), in seconds
+		double simTime = 0;
+
+		// Total time spent building observations in Step() and StepInto(), in seconds
+		double obsBuildTime = 0;
+
+		// Total time spent in terminal conditions and reward functions in Step() and StepInto(), in seconds
+		double terminalTime = 0, rewardTime = 0;
+
+		// Total time spent in Reset(), in seconds
+		double resetTime = 0;
+		// Calls of Reset(), i.e. episodes started
+		uint64_t resets = 0;
+
+		// If set, the start state of the next episode is made ahead of time by PrepareReset(), on a fork of our arena
+		// Reset() then only restores it into our arena, instead of running the state setter
+		// NOTE: State setters are then called before the episode they are for ends, so they can't depend on how it went
+		// NOTE: Episodes don't carry over suspension or contacts from the last one, so they won't simulate exactly like without this
+		bool resetAhead = false;
+
+		// Fork of our arena that the state setter is run on, only made with resetAhead
+		Arena* _standbyArena = NULL;
+		ArenaSnapshot _standbySnapshot = {};
+		bool _standbyReady = false;
+
+		// Config new cars are added with, when a swap changes the team size
+		CarConfig carConfig;
+
+		// Swap applied on the next Reset(), if _hasPendingSwap
+		EnvSwap _pendingSwap = {};
+		bool _hasPendingSwap = false;
+
+		// If set, observations are written directly into this memory ([playerAmount][obsOutputSize]) instead of being returned
+		float* obsOutput = NULL;
+		int obsOutputSize = 0;
+
+		Gym(
+			Match* match, int tickSkip, CarConfig carConfig = CAR_CONFIG_OCTANE, GameMode gameMode = GameMode::SOCCAR, MutatorConfig mutatorConfig = MutatorConfig(GameMode::SOCCAR),
+			const ArenaConfig& arenaConfig = {}, float tickRate = 120
+		);
 
 		RG_NO_COPY(Gym);
 
+		float GetTickRate() const {
+			return arena->GetTickRate();
+		}
+
+		// Seconds of game time simulated by each step
+		float GetStepTime() const {
+			return tickSkip * arena->tickTime;
+		}
+
+		// NOTE: Once set, Reset() and Step() will return empty observations
+		void SetOBSOutput(float* output, int obsSize) {
+			obsOutput = output;
+			obsOutputSize = obsSize;
+		}
+
+		FList2 BuildObservations(const GameState& state);
+
 		virtual FList2 Reset();
 
+		// Swaps components of our match at the start of the next episode, replacing any swap still queued
+		// Our arena is kept, cars are only added or removed from the end if the team size changes
+		// NOTE: Changing the team size changes playerAmount, and with it the size of the OBS output
+		// NOTE: Swapped out components aren't deleted
+		void QueueSwap(const EnvSwap& swap) {
+			_pendingSwap = swap;
+			_hasPendingSwap = true;
+		}
+
+		void _ApplySwap();
+		void _UpdateCarIDMap();
+
+		// Makes the start state of the next episode if we reset ahead and it isn't made yet, otherwise does nothing
+		// Call this when there is nothing else to do, such as while waiting on inference
+		void PrepareReset();
+
+		bool IsResetPrepared() const {
+			return _standbyReady;
+		}
+
 		struct StepResult {
 			FList2 obs;
 			FList reward;
@@ -28,7 +130,29 @@ namespace RLGSC {
 		};
 		virtual StepResult Step(const ActionParser::Input& actionsData);
 
+		// Step() that writes into existing memory, and never allocates once warmed up (with the default action parser and reward functions)
+		// Rewards are written to outRewards ([playerAmount]), observations are only written to the OBS output (see SetOBSOutput())
+		// The resulting state is prevState
+		virtual void StepInto(const ActionParser::Input& actionsData, float* outRewards, bool& outDone);
+
+		// Same as the above, but with the action index of each player ([playerAmount]), e.g. straight from the policy's output
+		// With an action lookup table (see ActionParser::GetControlsTable()), the controls are copied straight into the cars
+		virtual StepResult Step(const int64_t* actions);
+		virtual void StepInto(const int64_t* actions, float* outRewards, bool& outDone);
+
+		// StepInto() in two stages, so that stepping many games can interleave the stages of different games across threads
+		// StepArena() steps the arena and updates prevState, FinishStepInto() then builds observations, terminals and rewards from it
+		// NOTE: Both only touch this gym, its match, and its arena
+		void StepArena(const int64_t* actions);
+		void FinishStepInto(float* outRewards, bool& outDone);
+
+		// StepArena() of each gym in order (with the actions of each in actions), with identical results,
+		//	but their arenas are stepped together one tick phase at a time (see Arena::StepMultiple())
+		// Gyms with adaptiveStep, a different tickSkip than the others, or cars that could respawn during the step are stepped on their own
+		static void StepArenas(Gym* const* gyms, size_t amount, const int64_t* const* actions);
+
 		virtual ~Gym() {
+			delete _standbyArena;
 			delete arena;
 		}
 	};
@@ -11,3 +11,26 @@ Vec RLGSC::Math::RandVec(Vec min, Vec max) {
 		::Math::RandFloat(min.z, max.z)
 	);
 }
+
+RLGSC::Math::RandEngine& RLGSC::Math::GetRandEngine() {
+	static thread_local RandEngine randEngine = RandEngine(std::random_device()());
+	return randEngine;
+}
+
+float RLGSC::Math::RandFloat(float min, float max, RandEngine& randEngine) {
+	// Top 24 bits, so the result is exactly representable and never reaches 1
+	float frac = (randEngine() >> 40) * (1.f / (1 << 24));
+	return min + frac * (max - min);
+}
+
+int RLGSC::Math::RandInt(int min, int max, RandEngine& randEngine) {
+	return min + (int)(randEngine() % (uint64_t)(max - min));
+}
+
+Vec RLGSC::Math::RandVec(Vec min, Vec max, RandEngine& randEngine) {
+	// Separate statements, so the order of the draws doesn't depend on the compiler
+	float x = RandFloat(min.x, max.x, randEngine);
+	float y = RandFloat(min.y, max.y, randEngine);
+	float z = RandFloat(min.z, max.z, randEngine);
+	return Vec(x, y, z);
+}
@@ -5,5 +5,56 @@ namespace RLGSC {
 	namespace Math {
 		bool IsBallScored(Vec pos);
 		Vec RandVec(Vec min, Vec max);
+
+		// Small and fast random engine (xoshiro256**), works with std distributions
+		// Each game has its own (see Match::randEngine) so resets don't share state between threads and can be reproduced
+		struct RandEngine {
+			typedef uint64_t result_type;
+
+			uint64_t state[4];
+
+			RandEngine(uint64_t seed = 0) {
+				Seed(seed);
+			}
+
+			// Similar seeds still give unrelated sequences
+			void Seed(uint64_t seed) {
+				// Expand the seed with splitmix64
+				for (int i = 0; i < 4; i++) {
+					uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+					z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+					z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+					state[i] = z ^ (z >> 31);
+				}
+			}
+
+			static constexpr result_type min() { return 0; }
+			static constexpr result_type max() { return UINT64_MAX; }
+
+			result_type operator()() {
+				uint64_t result = _RotL(state[1] * 5, 7) * 9;
+				uint64_t t = state[1] << 17;
+
+				state[2] ^= state[0];
+				state[3] ^= state[1];
+				state[1] ^= state[2];
+				state[0] ^= state[3];
+				state[2] ^= t;
+				state[3] = _RotL(state[3], 45);
+
+				return result;
+			}
+
+			static uint64_t _RotL(uint64_t x, int k) {
+				return (x << k) | (x >> (64 - k));
+			}
+		};
+
+		// This thread's own randomly-seeded engine, for when there is no game engine to use
+		RandEngine& GetRandEngine();
+
+		float RandFloat(float min, float max, RandEngine& randEngine);
+		int RandInt(int min, int max, RandEngine& randEngine); // From min to (max - 1)
+		Vec RandVec(Vec min, Vec max, RandEngine& randEngine);
 	}
 }
\ No newline at end of file
@@ -11,6 +11,42 @@ namespace RLGSC {
 		typedef IList Input;
 
 		virtual ActionSet ParseActions(const Input& actionsData, const GameState& gameState) = 0;
+
+		// Parses into an existing action set, override this to avoid allocating every step
+		virtual void ParseActionsInto(const Input& actionsData, const GameState& gameState, ActionSet& out) {
+			out = ParseActions(actionsData, gameState);
+		}
+
+		// Lookup tables from action index to action and car controls, for parsers where each index is a fixed action
+		// If both are set, games skip parsing and copy from these tables straight into the cars (see Gym::StepInto())
+		virtual const Action* GetActionTable() { return NULL; }
+		virtual const CarControls* GetControlsTable() { return NULL; }
+
 		virtual int GetActionAmount() = 0;
+
+		// Fields of the state read by this, only the fields needed by a match are filled each step (see StateFields)
+		// Default implementation needs everything
+		virtual StateFields GetStateFields() {
+			return StateFields::ALL;
+		}
+
+		// Index of the left-right mirror of each action (see Action::MirrorX()), or empty if not every action has one
+		// Used by the learner to mirror samples during learning (see LearnerConfig::mirrorFraction)
+		// Default implementation finds the mirror of each action in the action table
+		virtual IList GetMirrorActionMap() {
+			const Action* actionTable = GetActionTable();
+			if (!actionTable)
+				return {};
+
+			int actionAmount = GetActionAmount();
+			IList result = IList(actionAmount);
+			for (int i = 0; i < actionAmount; i++) {
+				const Action* mirror = std::find(actionTable, actionTable + actionAmount, actionTable[i].MirrorX());
+				if (mirror == actionTable + actionAmount)
+					return {};
+				result[i] = mirror - actionTable;
+			}
+			return result;
+		}
 	};
 }
\ No newline at end of file
@@ -59,6 +59,9 @@ RLGSC::DiscreteAction::DiscreteAction() {
 		}
 	}
 
+	for (const Action& action : actions)
+		controlsTable.push_back((CarControls)action);
+
 	static std::once_flag onceFlag;
 	std::call_once(onceFlag, 
 		[=] {
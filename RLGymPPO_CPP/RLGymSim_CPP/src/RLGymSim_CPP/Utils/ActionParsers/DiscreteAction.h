@@ -8,6 +8,8 @@ namespace RLGSC {
 	public:
 
 		std::vector<Action> actions;
+		// Controls of each action, so stepping doesn't need to convert them
+		std::vector<CarControls> controlsTable;
 
 		DiscreteAction();
 
@@ -18,8 +20,26 @@ namespace RLGSC {
 			return result;
 		}
 
+		virtual void ParseActionsInto(const Input& actionsData, const GameState& gameState, ActionSet& out) {
+			out.resize(actionsData.size());
+			for (int i = 0; i < actionsData.size(); i++)
+				out[i] = actions[actionsData[i]];
+		}
+
+		virtual const Action* GetActionTable() {
+			return actions.data();
+		}
+
+		virtual const CarControls* GetControlsTable() {
+			return controlsTable.data();
+		}
+
 		virtual int GetActionAmount() {
 			return actions.size();
 		}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::NONE;
+		}
 	};
 }
\ No newline at end of file
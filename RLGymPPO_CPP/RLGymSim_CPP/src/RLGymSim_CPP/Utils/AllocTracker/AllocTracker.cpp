@@ -0,0 +1,58 @@
+#include "AllocTracker.h"
+
+namespace RLGSC {
+	// Each on its own cache line, as every thread adds to them
+	struct alignas(64) _TagCounts {
+		std::atomic<uint64_t> allocs = 0, bytes = 0;
+	};
+	_TagCounts _tagCounts[(int)AllocTag::AMOUNT] = {};
+
+	thread_local AllocTag _threadTag = AllocTag::OTHER;
+	thread_local uint64_t _threadAllocs = 0;
+
+	const char* AllocTracker::GetTagName(AllocTag tag) {
+		constexpr const char* NAMES[] = {
+			"Other",
+			"Sim",
+			"OBS",
+			"Reward",
+			"Inference",
+			"Trajectory",
+			"Learner"
+		};
+		static_assert(sizeof(NAMES) / sizeof(NAMES[0]) == (int)AllocTag::AMOUNT);
+
+		return NAMES[(int)tag];
+	}
+
+	AllocTracker::Counts AllocTracker::GetTotal(AllocTag tag) {
+		auto& counts = _tagCounts[(int)tag];
+		return Counts{ counts.allocs.load(std::memory_order_relaxed), counts.bytes.load(std::memory_order_relaxed) };
+	}
+
+	uint64_t AllocTracker::GetThreadAllocs() {
+		return _threadAllocs;
+	}
+
+	AllocTag AllocTracker::_SetThreadTag(AllocTag tag) {
+		AllocTag prevTag = _threadTag;
+		_threadTag = tag;
+		return prevTag;
+	}
+
+	void* AllocTracker::_Alloc(size_t size) {
+		_threadAllocs++;
+		auto& counts = _tagCounts[(int)_threadTag];
+		counts.allocs.fetch_add(1, std::memory_order_relaxed);
+		counts.bytes.fetch_add(size, std::memory_order_relaxed);
+		return malloc(size ? size : 1);
+	}
+
+	void AllocTracker::_Free(void* ptr) {
+		free(ptr);
+	}
+}
+
+#ifdef RG_ALLOC_TRACKING
+RG_REPLACE_GLOBAL_NEW()
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+#include "../../Framework.h"
+
+#include <new>
+
+namespace RLGSC {
+	// Subsystems that heap allocations are counted under (see AllocTracker)
+	enum class AllocTag : uint8_t {
+		OTHER, // Outside of any scope
+		SIM,
+		OBS,
+		REWARD, // Also terminal conditions
+		INFERENCE,
+		TRAJECTORY,
+		LEARNER,
+
+		AMOUNT
+	};
+
+	// Counts heap allocations and their bytes per subsystem, through a replaced global operator new
+	// Only built with RG_ALLOC_TRACKING, otherwise nothing is counted and scopes compile to nothing
+	// Each thread counts under the tag of its innermost RG_ALLOC_SCOPE()
+	// NOTE: Memory from allocators that don't use operator new (e.g. the data of torch tensors) isn't counted
+	// NOTE: On Windows, only allocations made from within the library this is linked into are counted
+	namespace AllocTracker {
+		struct Counts {
+			uint64_t allocs = 0, bytes = 0;
+		};
+
+#ifdef RG_ALLOC_TRACKING
+		constexpr bool ENABLED = true;
+#else
+		constexpr bool ENABLED = false;
+#endif
+
+		const char* GetTagName(AllocTag tag);
+
+		// Totals of all threads since the process started
+		Counts GetTotal(AllocTag tag);
+
+		// Allocations of the calling thread since it started, under any tag
+		uint64_t GetThreadAllocs();
+
+		// Returns the tag the calling thread had
+		AllocTag _SetThreadTag(AllocTag tag);
+
+		// Used by the replaced operator new and delete (see RG_REPLACE_GLOBAL_NEW())
+		// Out of line, so that the compiler never sees malloc() and free() paired with new and delete
+		void* _Alloc(size_t size);
+		void _Free(void* ptr);
+	}
+
+	// Counts allocations of the calling thread under a tag, from its construction to its destruction
+	struct AllocScope {
+		AllocTag prevTag;
+
+		AllocScope(AllocTag tag) {
+			prevTag = AllocTracker::_SetThreadTag(tag);
+		}
+
+		RG_NO_COPY(AllocScope);
+
+		~AllocScope() {
+			AllocTracker::_SetThreadTag(prevTag);
+		}
+	};
+}
+
+#ifdef RG_ALLOC_TRACKING
+#define _RG_ALLOC_CONCAT(a, b) a##b
+#define _RG_ALLOC_NAME(line) _RG_ALLOC_CONCAT(_allocScope, line)
+
+// Counts allocations of the rest of the current scope under an AllocTag
+#define RG_ALLOC_SCOPE(tag) RLGSC::AllocScope _RG_ALLOC_NAME(__LINE__)(RLGSC::AllocTag::tag)
+#else
+#define RG_ALLOC_SCOPE(tag) {}
+#endif
+
+// Replaces every form of the global operator new and delete with ones that count through AllocTracker
+// Used by AllocTracker itself with RG_ALLOC_TRACKING, and by RG_COUNTING_ALLOCATOR() (see ComponentBench) otherwise
+// NOTE: Must only be used once in a program
+#define RG_REPLACE_GLOBAL_NEW() \
+void* operator new(size_t size) { \
+	if (void* ptr = RLGSC::AllocTracker::_Alloc(size)) \
+		return ptr; \
+	throw std::bad_alloc(); \
+} \
+void* operator new[](size_t size) { \
+	if (void* ptr = RLGSC::AllocTracker::_Alloc(size)) \
+		return ptr; \
+	throw std::bad_alloc(); \
+} \
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return RLGSC::AllocTracker::_Alloc(size); } \
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return RLGSC::AllocTracker::_Alloc(size); } \
+void operator delete(void* ptr) noexcept { RLGSC::AllocTracker::_Free(ptr); } \
+void operator delete[](void* ptr) noexcept { RLGSC::AllocTracker::_Free(ptr); } \
+void operator delete(void* ptr, size_t) noexcept { RLGSC::AllocTracker::_Free(ptr); } \
+void operator delete[](void* ptr, size_t) noexcept { RLGSC::AllocTracker::_Free(ptr); } \
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { RLGSC::AllocTracker::_Free(ptr); } \
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { RLGSC::AllocTracker::_Free(ptr); }
@@ -60,6 +60,19 @@ namespace RLGSC {
 			assert(index < ELEM_AMOUNT);
 			return begin()[index];
 		}
+
+		bool operator==(const Action& other) const {
+			return std::equal(begin(), end(), other.begin());
+		}
+
+		// Same action with the field mirrored left-right (see PhysObj::MirrorX()), which turns the other way
+		Action MirrorX() const {
+			Action result = *this;
+			result.steer *= -1;
+			result.yaw *= -1;
+			result.roll *= -1;
+			return result;
+		}
 	};
 
 	typedef std::vector<Action> ActionSet;
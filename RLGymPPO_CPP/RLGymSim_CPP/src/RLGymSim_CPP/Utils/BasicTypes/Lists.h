@@ -6,6 +6,25 @@ namespace RLGSC {
 	typedef std::vector<std::vector<float>> FList2;
 	typedef std::vector<int> IList;
 	typedef std::vector<std::vector<int>> IList2;
+
+	// Writes floats sequentially into existing memory
+	// Works like the FList operators, but never allocates
+	struct FListWriter {
+		float* cur;
+		float* end;
+
+		FListWriter(std::span<float> span) : cur(span.data()), end(span.data() + span.size()) {}
+
+		size_t Remaining() const {
+			return end - cur;
+		}
+
+		void Write(float val) {
+			RG_PARA_ASSERT(cur < end);
+			*cur = val;
+			cur++;
+		}
+	};
 }
 
 // FList operators
@@ -29,4 +48,23 @@ inline RLGSC::FList& operator +=(RLGSC::FList& list, const std::initializer_list
 inline RLGSC::FList& operator +=(RLGSC::FList& list, const RLGSC::FList& other) {
 	list.insert(list.end(), other.begin(), other.end());
 	return list;
+}
+
+// FListWriter operators
+inline RLGSC::FListWriter& operator +=(RLGSC::FListWriter& writer, float val) {
+	writer.Write(val);
+	return writer;
+}
+
+inline RLGSC::FListWriter& operator +=(RLGSC::FListWriter& writer, const Vec& val) {
+	writer.Write(val.x);
+	writer.Write(val.y);
+	writer.Write(val.z);
+	return writer;
+}
+
+inline RLGSC::FListWriter& operator +=(RLGSC::FListWriter& writer, const std::initializer_list<float>& other) {
+	for (float val : other)
+		writer.Write(val);
+	return writer;
 }
\ No newline at end of file
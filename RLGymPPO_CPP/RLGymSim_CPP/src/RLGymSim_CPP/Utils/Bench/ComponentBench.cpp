@@ -0,0 +1,243 @@
+#include "ComponentBench.h"
+#include "../AllocTracker/AllocTracker.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace RLGSC;
+
+bool RLGSC::ComponentBench::_countingAllocator = false;
+
+ComponentBench::StateCorpus RLGSC::ComponentBench::RecordStates(int teamSize, int numStates, int tickSkip, int seed) {
+	constexpr uint64_t RESET_TICKS = 120 * 30;
+
+	StateCorpus corpus = {};
+	corpus.states.reserve(numStates);
+	corpus.prevActions.reserve(numStates);
+
+	Arena* arena = Arena::Create(GameMode::SOCCAR);
+	for (int i = 0; i < teamSize; i++) {
+		arena->AddCar(Team::BLUE);
+		arena->AddCar(Team::ORANGE);
+	}
+	arena->ResetToRandomKickoff(seed);
+
+	std::mt19937 rng = std::mt19937(seed);
+	std::uniform_real_distribution<float> dist = std::uniform_real_distribution<float>(-1, 1);
+
+	GameState state = {};
+	uint64_t ticksSinceReset = 0;
+	for (int i = 0; i < numStates; i++) {
+		ActionSet actions = {};
+		for (Car* car : arena->_cars) {
+			CarControls& controls = car->controls;
+			controls.throttle = dist(rng);
+			controls.steer = dist(rng);
+			controls.pitch = dist(rng);
+			controls.yaw = dist(rng);
+			controls.roll = dist(rng);
+			controls.boost = dist(rng) > 0;
+			controls.jump = dist(rng) > 0.8f;
+			controls.handbrake = dist(rng) > 0.8f;
+			actions.push_back(Action(controls));
+		}
+
+		arena->Step(tickSkip);
+		ticksSinceReset += tickSkip;
+		state.UpdateFromArena(arena);
+
+		corpus.states.push_back(state);
+		corpus.states.back().lastArena = NULL;
+		corpus.prevActions.push_back(actions);
+
+		if (ticksSinceReset >= RESET_TICKS || arena->IsBallScored()) {
+			arena->ResetToRandomKickoff(rng());
+			ticksSinceReset = 0;
+		}
+	}
+
+	delete arena;
+	return corpus;
+}
+
+// Counts cache misses of this thread, only on Linux with perf events available
+struct _CacheMissCounter {
+	int fd = -1;
+
+	_CacheMissCounter() {
+#ifdef __linux__
+		perf_event_attr attr = {};
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	}
+
+	RG_NO_COPY(_CacheMissCounter);
+
+	void Start() {
+#ifdef __linux__
+		if (fd != -1) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	// Returns NAN if not available
+	double Stop() {
+#ifdef __linux__
+		if (fd != -1) {
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			uint64_t count;
+			if (read(fd, &count, sizeof(count)) == sizeof(count))
+				return (double)count;
+		}
+#endif
+		return NAN;
+	}
+
+	~_CacheMissCounter() {
+#ifdef __linux__
+		if (fd != -1)
+			close(fd);
+#endif
+	}
+};
+
+// States are reused across passes, so their lazily computed parts have to be computed again like in a fresh step
+void _ResetCaches(GameState& state) {
+	state.InvalidateCaches();
+	for (auto& player : state.players)
+		player._physInvValid = false;
+}
+
+// Runs fnStep(state, prevActions) on every state of the corpus until minSeconds have passed
+template <typename T>
+ComponentBench::Result _Bench(const std::string& name, ComponentBench::StateCorpus& corpus, double minSeconds, T fnStep) {
+	if (corpus.states.empty())
+		RG_ERR_CLOSE("ComponentBench: State corpus is empty");
+
+	uint64_t playersPerPass = 0;
+	for (auto& state : corpus.states)
+		playersPerPass += state.players.size();
+
+	_CacheMissCounter cacheMissCounter = {};
+	uint64_t startAllocCount = AllocTracker::GetThreadAllocs();
+	uint64_t passes = 0;
+
+	cacheMissCounter.Start();
+	auto startTime = std::chrono::steady_clock::now();
+	double elapsed;
+	do {
+		for (size_t i = 0; i < corpus.states.size(); i++) {
+			_ResetCaches(corpus.states[i]);
+			fnStep(corpus.states[i], corpus.prevActions[i]);
+		}
+		passes++;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	} while (elapsed < minSeconds);
+	double cacheMisses = cacheMissCounter.Stop();
+	uint64_t allocs = AllocTracker::GetThreadAllocs() - startAllocCount;
+
+	ComponentBench::Result result = {};
+	result.name = name;
+	result.steps = passes * corpus.states.size();
+
+	double playerSteps = (double)passes * playersPerPass;
+	result.nsPerPlayerStep = elapsed * 1e9 / playerSteps;
+	result.allocsPerStep = ComponentBench::_countingAllocator ? (allocs / (double)result.steps) : NAN;
+	result.cacheMissesPerPlayerStep = cacheMisses / playerSteps;
+
+	RG_LOG(
+		"ComponentBench: " << name << ": " << result.nsPerPlayerStep << "ns/player-step, " << 
+		result.allocsPerStep << " allocs/step, " << result.cacheMissesPerPlayerStep << " cache misses/player-step"
+	);
+	return result;
+}
+
+ComponentBench::Result RLGSC::ComponentBench::BenchOBS(const std::string& name, OBSBuilder* obsBuilder, StateCorpus& corpus, double minSeconds) {
+	obsBuilder->Reset(corpus.states[0]);
+
+	FList obs = {};
+	return _Bench(name, corpus, minSeconds, [&](const GameState& state, const ActionSet& prevActions) {
+		obsBuilder->PreStep(state);
+
+		int obsSize = obsBuilder->GetOBSSize(state);
+		if (obsSize == -1) {
+			// Can only be built by allocating
+			for (int i = 0; i < state.players.size(); i++)
+				obs = obsBuilder->BuildOBS(state.players[i], state, prevActions[i]);
+		} else {
+			obs.resize((size_t)obsSize * state.players.size());
+			for (int i = 0; i < state.players.size(); i++)
+				obsBuilder->BuildOBSInto(std::span<float>(obs.data() + (size_t)i * obsSize, obsSize), state.players[i], state, prevActions[i]);
+		}
+	});
+}
+
+ComponentBench::Result RLGSC::ComponentBench::BenchReward(const std::string& name, RewardFunction* rewardFn, StateCorpus& corpus, double minSeconds) {
+	rewardFn->Reset(corpus.states[0]);
+
+	FList rewards = {};
+	return _Bench(name, corpus, minSeconds, [&](const GameState& state, const ActionSet& prevActions) {
+		rewards.resize(state.players.size());
+		rewardFn->PreStep(state);
+		rewardFn->GetAllRewardsInto(state, prevActions, false, rewards.data());
+	});
+}
+
+ComponentBench::Result RLGSC::ComponentBench::BenchTerminal(const std::string& name, TerminalCondition* condition, StateCorpus& corpus, double minSeconds) {
+	condition->Reset(corpus.states[0]);
+
+	volatile bool terminal = false; // So the calls can't be optimized out
+	return _Bench(name, corpus, minSeconds, [&](const GameState& state, const ActionSet& prevActions) {
+		terminal = condition->IsTerminal(state);
+	});
+}
+
+ComponentBench::Result RLGSC::ComponentBench::BenchActionParser(const std::string& name, ActionParser* actionParser, StateCorpus& corpus, double minSeconds) {
+	// Same random action indices every time
+	std::mt19937 rng = std::mt19937(0);
+	std::vector<ActionParser::Input> inputs = {};
+	for (auto& state : corpus.states) {
+		ActionParser::Input input = {};
+		for (int i = 0; i < state.players.size(); i++)
+			input.push_back(rng() % actionParser->GetActionAmount());
+		inputs.push_back(input);
+	}
+
+	ActionSet actions = {};
+	size_t stateIndex = 0;
+	return _Bench(name, corpus, minSeconds, [&](const GameState& state, const ActionSet& prevActions) {
+		actionParser->ParseActionsInto(inputs[stateIndex], state, actions);
+		stateIndex = (stateIndex + 1) % inputs.size();
+	});
+}
+
+std::string RLGSC::ComponentBench::ToJSON(const std::vector<Result>& results) {
+	auto fnNumber = [](double val) {
+		return isnan(val) ? std::string("null") : RS_STR(val);
+	};
+
+	std::stringstream stream;
+	stream << "[\n";
+	for (int i = 0; i < results.size(); i++) {
+		auto& result = results[i];
+		stream << "\t{ \"name\": \"" << result.name << "\", \"steps\": " << result.steps;
+		stream << ", \"ns_per_player_step\": " << fnNumber(result.nsPerPlayerStep);
+		stream << ", \"allocs_per_step\": " << fnNumber(result.allocsPerStep);
+		stream << ", \"cache_misses_per_player_step\": " << fnNumber(result.cacheMissesPerPlayerStep) << " }";
+		stream << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	stream << "]";
+	return stream.str();
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include "../OBSBuilders/OBSBuilder.h"
+#include "../RewardFunctions/RewardFunction.h"
+#include "../TerminalConditions/TerminalCondition.h"
+#include "../ActionParsers/ActionParser.h"
+#include "../AllocTracker/AllocTracker.h"
+
+// Micro-benchmarks for the components plugged into a Match, run over a corpus of recorded states
+// Each component is called the same way a Match calls it every step, through its non-allocating methods
+namespace RLGSC {
+	namespace ComponentBench {
+		struct StateCorpus {
+			// NOTE: lastArena of these is NULL, as the arena they were recorded from is gone
+			std::vector<GameState> states;
+			std::vector<ActionSet> prevActions; // Actions the players took to get to each state
+		};
+
+		// Records states of a soccar arena where every car takes random actions
+		StateCorpus RecordStates(int teamSize, int numStates, int tickSkip = 8, int seed = 0);
+
+		struct Result {
+			std::string name;
+			uint64_t steps; // Steps of the corpus the component was run on, one call per step
+			double nsPerPlayerStep;
+
+			// NAN if not available
+			double allocsPerStep; // Needs RG_COUNTING_ALLOCATOR()
+			double cacheMissesPerPlayerStep; // Needs Linux perf events
+		};
+
+		// Each runs through the corpus as many times as fit in minSeconds, at least once
+		Result BenchOBS(const std::string& name, OBSBuilder* obsBuilder, StateCorpus& corpus, double minSeconds = 1);
+		Result BenchReward(const std::string& name, RewardFunction* rewardFn, StateCorpus& corpus, double minSeconds = 1);
+		Result BenchTerminal(const std::string& name, TerminalCondition* condition, StateCorpus& corpus, double minSeconds = 1);
+		Result BenchActionParser(const std::string& name, ActionParser* actionParser, StateCorpus& corpus, double minSeconds = 1);
+
+		std::string ToJSON(const std::vector<Result>& results);
+
+		// Set by RG_COUNTING_ALLOCATOR(), allocations are counted through AllocTracker
+		extern bool _countingAllocator;
+	}
+}
+
+// Replaces the global operator new with one that counts allocations for ComponentBench (see RG_REPLACE_GLOBAL_NEW())
+// Put this once in the .cpp of your benchmark's main(), never in a program that doesn't need it
+// With RG_ALLOC_TRACKING, AllocTracker already replaces it, so this only enables counting
+#ifdef RG_ALLOC_TRACKING
+#define RG_COUNTING_ALLOCATOR() \
+static bool _rgCountingAllocator = (RLGSC::ComponentBench::_countingAllocator = true);
+#else
+#define RG_COUNTING_ALLOCATOR() \
+RG_REPLACE_GLOBAL_NEW() \
+static bool _rgCountingAllocator = (RLGSC::ComponentBench::_countingAllocator = true);
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+#include "../CommonValues.h"
+
+namespace RLGSC {
+	// Which boost pads are active, as one bit per pad, in the order of CommonValues::BOOST_LOCATIONS
+	struct BoostPadMask {
+		constexpr static int PAD_AMOUNT = CommonValues::BOOST_LOCATIONS_AMOUNT;
+		constexpr static uint64_t ALL_PADS = (1ull << PAD_AMOUNT) - 1;
+
+		uint64_t bits = ALL_PADS;
+
+		bool operator[](size_t index) const {
+			return (bits >> index) & 1;
+		}
+
+		void Set(size_t index, bool active) {
+			bits = (bits & ~(1ull << index)) | ((uint64_t)active << index);
+		}
+
+		void SetAll(bool active) {
+			bits = active ? ALL_PADS : 0;
+		}
+
+		// The same pads from the other side of the field
+		// Inverting the field reverses BOOST_LOCATIONS, so this just reverses the bits
+		constexpr BoostPadMask Inverted() const {
+			uint64_t reversed = bits;
+			reversed = ((reversed >> 1) & 0x5555555555555555ull) | ((reversed & 0x5555555555555555ull) << 1);
+			reversed = ((reversed >> 2) & 0x3333333333333333ull) | ((reversed & 0x3333333333333333ull) << 2);
+			reversed = ((reversed >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((reversed & 0x0F0F0F0F0F0F0F0Full) << 4);
+			reversed = ((reversed >> 8) & 0x00FF00FF00FF00FFull) | ((reversed & 0x00FF00FF00FF00FFull) << 8);
+			reversed = ((reversed >> 16) & 0x0000FFFF0000FFFFull) | ((reversed & 0x0000FFFF0000FFFFull) << 16);
+			reversed = (reversed >> 32) | (reversed << 32);
+			return BoostPadMask{ reversed >> (64 - PAD_AMOUNT) };
+		}
+
+		// Writes each pad as 1 if active or 0 if not, out must have room for PAD_AMOUNT
+		void WriteTo(float* out) const {
+			for (int i = 0; i < PAD_AMOUNT; i++)
+				out[i] = (float)((bits >> i) & 1);
+		}
+
+		std::array<bool, PAD_AMOUNT> ToArray() const {
+			std::array<bool, PAD_AMOUNT> result;
+			for (int i = 0; i < PAD_AMOUNT; i++)
+				result[i] = (*this)[i];
+			return result;
+		}
+	};
+}
\ No newline at end of file
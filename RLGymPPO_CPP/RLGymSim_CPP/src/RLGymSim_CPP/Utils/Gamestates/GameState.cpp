@@ -4,86 +4,142 @@
 
 using namespace RLGSC;
 
-static int boostPadIndexMap[CommonValues::BOOST_LOCATIONS_AMOUNT] = {};
-static bool boostPadIndexMapBuilt = false;
-static std::mutex boostPadIndexMapMutex = {};
-void _BuildBoostPadIndexMap(Arena* arena) {
-	constexpr const char* ERROR_PREFIX = "_BuildBoostPadIndexMap(): ";
-	RG_LOG("Building boost pad index map...");
-
-	if (arena->_boostPads.size() != CommonValues::BOOST_LOCATIONS_AMOUNT) {
-		RG_ERR_CLOSE(
-			ERROR_PREFIX << "Arena boost pad count does not match CommonValues::BOOST_LOCATIONS_AMOUNT " <<
-			"(" << arena->_boostPads.size() << "/" << CommonValues::BOOST_LOCATIONS_AMOUNT << ")"
-		);
+// Arenas create their big boost pads first, then their small ones
+// This finds the arena pad index of each of CommonValues::BOOST_LOCATIONS, at compile time
+constexpr int _FindArenaBoostPad(Vec location) {
+	using namespace RLConst::BoostPads;
+
+	for (int i = 0; i < LOCS_AMOUNT_BIG + LOCS_AMOUNT_SMALL_SOCCAR; i++) {
+		Vec padPos = (i < LOCS_AMOUNT_BIG) ? LOCS_BIG_SOCCAR[i] : LOCS_SMALL_SOCCAR[i - LOCS_AMOUNT_BIG];
+		float dx = padPos.x - location.x, dy = padPos.y - location.y;
+		if (dx * dx + dy * dy < 10)
+			return i;
 	}
-	
-	bool found[CommonValues::BOOST_LOCATIONS_AMOUNT] = {};
-	for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++) {
-		Vec targetPos = CommonValues::BOOST_LOCATIONS[i];
-		for (int j = 0; j < arena->_boostPads.size(); j++) {
-			Vec padPos = arena->_boostPads[j]->pos;
-
-			if (padPos.DistSq2D(targetPos) < 10) {
-				if (!found[i]) {
-					found[i] = true;
-					boostPadIndexMap[i] = j;
-				} else {
-					RG_ERR_CLOSE(
-						ERROR_PREFIX << "Matched duplicate boost pad at " << targetPos << "=" << padPos
-					);
-				}
-				break;
-			}
-		}
 
-		if (!found[i])
-			RS_ERR_CLOSE(ERROR_PREFIX << "Failed to find matching pad at " << targetPos);
+	return -1;
+}
+
+constexpr auto BOOST_PAD_INDEX_MAP = [] {
+	std::array<int, CommonValues::BOOST_LOCATIONS_AMOUNT> result = {};
+	for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++)
+		result[i] = _FindArenaBoostPad(CommonValues::BOOST_LOCATIONS[i]);
+	return result;
+}();
+
+constexpr bool _IsBoostPadIndexMapValid() {
+	bool found[CommonValues::BOOST_LOCATIONS_AMOUNT] = {};
+	for (int index : BOOST_PAD_INDEX_MAP) {
+		if (index < 0 || index >= CommonValues::BOOST_LOCATIONS_AMOUNT || found[index])
+			return false;
+		found[index] = true;
 	}
+	return true;
+}
+static_assert(_IsBoostPadIndexMapValid(), "CommonValues::BOOST_LOCATIONS don't match the boost pads of RocketSim's soccar arena");
 
-	RG_LOG(" > Done");
-	boostPadIndexMapBuilt = true;
+// BoostPadMask::Inverted() relies on inverting the field reversing BOOST_LOCATIONS
+constexpr bool _IsBoostLocationsInverseReversed() {
+	for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++) {
+		Vec pos = CommonValues::BOOST_LOCATIONS[i];
+		Vec mirrorPos = CommonValues::BOOST_LOCATIONS[CommonValues::BOOST_LOCATIONS_AMOUNT - i - 1];
+		float dx = pos.x + mirrorPos.x, dy = pos.y + mirrorPos.y;
+		if (dx * dx + dy * dy >= 10)
+			return false;
+	}
+	return true;
 }
+static_assert(_IsBoostLocationsInverseReversed(), "Inverting CommonValues::BOOST_LOCATIONS must reverse them");
 
-void RLGSC::GameState::UpdateFromArena(Arena* arena) {
+void RLGSC::GameState::UpdateFromArena(Arena* arena, StateFields fields) {
 	lastArena = arena;
+	tickTime = arena->tickTime;
+	validFields = fields;
+	InvalidateCaches();
 	int tickSkip = RS_MAX(arena->tickCount - lastTickCount, 0);
 
-	ballState = arena->ball->GetState();
-	ball = PhysObj(ballState);
-	ballInv = ball.Invert();
+	if (HasStateFields(fields, StateFields::BALL | StateFields::SCORE_LINE)) {
+		ballState = arena->ball->GetState();
+		ball = PhysObj(ballState);
+	}
 
 	players.resize(arena->_cars.size());
 
-	auto carItr = arena->_cars.begin();
 	for (int i = 0; i < players.size(); i++) {
 		auto& player = players[i];
-		player.UpdateFromCar(*carItr, arena->tickCount, tickSkip);
-		if (player.ballTouchedStep)
+		player.UpdateFromCar(arena->_cars[i], arena->tickCount, tickSkip, fields);
+		if (HasStateFields(fields, StateFields::PLAYERS) && player.ballTouchedStep)
 			lastTouchCarID = player.carId;
-
-		carItr++;
 	}
 
-	if (!boostPadIndexMapBuilt) {
-		boostPadIndexMapMutex.lock();
-		// Check again? This seems stupid but also makes sense to me
-		//	Without this, we could lock as the index map is building, then go build again
-		//	I would like to keep the mutex inside the if statement so it is only checked a few times
-		if (!boostPadIndexMapBuilt) 
-			_BuildBoostPadIndexMap(arena);
-		boostPadIndexMapMutex.unlock();
-	}
+	if (HasStateFields(fields, StateFields::BOOST_PADS)) {
+		if (arena->_boostPads.size() != CommonValues::BOOST_LOCATIONS_AMOUNT) {
+			RG_ERR_CLOSE(
+				"GameState::UpdateFromArena(): Arena boost pad count does not match CommonValues::BOOST_LOCATIONS_AMOUNT " <<
+				"(" << arena->_boostPads.size() << "/" << CommonValues::BOOST_LOCATIONS_AMOUNT << ")"
+			);
+		}
 
-	for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++) {
-		boostPads[i] = arena->_boostPads[boostPadIndexMap[i]]->GetState().isActive;
-		boostPadsInv[i] = arena->_boostPads[boostPadIndexMap[CommonValues::BOOST_LOCATIONS_AMOUNT - i - 1]]->GetState().isActive;
+		uint64_t padBits = 0;
+		for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++)
+			padBits |= (uint64_t)arena->_boostPads[BOOST_PAD_INDEX_MAP[i]]->_internalState.isActive << i;
+		boostPads.bits = padBits;
 	}
 
 	// Update goal scoring
 	// If you don't have a GoalScoreCondition then that's not my problem lmao
-	if (Math::IsBallScored(ball.pos))
+	if (HasStateFields(fields, StateFields::SCORE_LINE) && Math::IsBallScored(ball.pos))
 		scoreLine[1 - (int)RS_TEAM_FROM_Y(ball.pos.y)]++;
 
+#ifndef NDEBUG
+	constexpr float NaN = std::numeric_limits<float>::quiet_NaN();
+	if (!HasStateFields(fields, StateFields::BALL)) {
+		ballState.pos = ballState.vel = ballState.angVel = Vec(NaN, NaN, NaN);
+		ball.pos = ball.vel = ball.angVel = Vec(NaN, NaN, NaN);
+	}
+	if (!HasStateFields(fields, StateFields::PLAYERS))
+		lastTouchCarID = -1;
+	if (!HasStateFields(fields, StateFields::BOOST_PADS))
+		boostPads.bits = ~0ull;
+#endif
+
 	lastTickCount = arena->tickCount;
+}
+
+void RLGSC::GameState::_UpdateInverted() const {
+	ballInv = ball.Invert();
+	_invValid = true;
+}
+
+const RLGSC::StateSoA& RLGSC::GameState::GetSoA() const {
+	if (!_soaValid) {
+		if (_soa.numCars != players.size()) {
+			_soa = {};
+			_soa.AddArena(players.size());
+		}
+
+		_soa.SetArena(0, *this);
+		_soaValid = true;
+	}
+
+	return _soa;
+}
+
+const RLGSC::StateFeatures& RLGSC::GameState::GetFeatures() const {
+	if (!_featuresValid) {
+		_features.Build(*this);
+		_featuresValid = true;
+	}
+
+	return _features;
+}
+
+RLGSC::PlayerFeatures RLGSC::GameState::GetPlayerFeatures(const PlayerData& player, bool inverted) const {
+	PlayerFeatures result;
+	if (&player >= players.data() && &player < players.data() + players.size()) {
+		result = GetFeatures().players[&player - players.data()];
+	} else {
+		result = PlayerFeatures(player, ball);
+	}
+
+	return inverted ? result.Invert() : result;
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #pragma once
 #include "PlayerData.h"
+#include "StateFields.h"
+#include "StateSoA.h"
+#include "StateFeatures.h"
+#include "BoostPadMask.h"
 #include "../CommonValues.h"
 
 namespace RLGSC {
@@ -22,10 +26,13 @@ namespace RLGSC {
 		std::vector<PlayerData> players;
 
 		BallState ballState;
-		PhysObj ball, ballInv;
+		PhysObj ball;
+		BoostPadMask boostPads;
 
-		std::array<bool, CommonValues::BOOST_LOCATIONS_AMOUNT> boostPads;
-		std::array<bool, CommonValues::BOOST_LOCATIONS_AMOUNT> boostPadsInv;
+		// Inverted ball, only computed when first needed each step
+		// NOTE: Read through GetBallPhys(true), this is not up to date otherwise
+		mutable PhysObj ballInv;
+		mutable bool _invValid = false;
 
 		// Last arena we updated with
 		// Can be used to determine current arena from within reward function, for example
@@ -35,19 +42,54 @@ namespace RLGSC {
 		// Last tick count when updated
 		uint64_t lastTickCount = 0;
 
+		// Tick time of the last arena we updated with, for turning tick counts into game time
+		float tickTime = 1 / 120.f;
+
+		// Fields filled by the last update, others are left from before (see StateFields)
+		StateFields validFields = StateFields::ALL;
+
 		GameState() = default;
 		explicit GameState(Arena* arena) {
 			UpdateFromArena(arena);
 		}
 
 		const PhysObj& GetBallPhys(bool inverted) const {
+			if (inverted && !_invValid)
+				_UpdateInverted();
 			return inverted ? ballInv : ball;
 		}
 
-		const auto& GetBoostPads(bool inverted) const {
-			return inverted ? boostPadsInv : boostPads;
+		BoostPadMask GetBoostPads(bool inverted) const {
+			return inverted ? boostPads.Inverted() : boostPads;
+		}
+
+		void _UpdateInverted() const;
+
+		// Only fills "fields", the rest are left as they were
+		// NOTE: In debug builds, fields that aren't filled are set to NaN/garbage so that reading them is noticed
+		void UpdateFromArena(Arena* arena, StateFields fields = StateFields::ALL);
+
+		// Caches below are built on first use after each update, so they are shared by everything that reads them that step
+		// NOTE: If you modify the players or ball yourself, call InvalidateCaches() afterward
+
+		// This state as a single arena in structure-of-arrays form, for batched reward functions
+		const StateSoA& GetSoA() const;
+
+		// Features of the players relative to the ball, and ball directions to the goals
+		const StateFeatures& GetFeatures() const;
+
+		// Cached features of a player, or computed now if the player isn't one of ours
+		PlayerFeatures GetPlayerFeatures(const PlayerData& player, bool inverted = false) const;
+
+		void InvalidateCaches() {
+			_invValid = false;
+			_soaValid = false;
+			_featuresValid = false;
 		}
 
-		void UpdateFromArena(Arena* arena);
+		mutable StateSoA _soa = {};
+		mutable bool _soaValid = false;
+		mutable StateFeatures _features = {};
+		mutable bool _featuresValid = false;
 	};
 }
\ No newline at end of file
@@ -1,34 +1,66 @@
 #include "PlayerData.h"
 
 namespace RLGSC {
-	void PlayerData::UpdateFromCar(Car* car, uint64_t tickCount, int tickSkip) {
+	void PlayerData::UpdateFromCar(Car* car, uint64_t tickCount, int tickSkip, StateFields fields) {
 		carId = car->id;
 		team = car->team;
+
+		bool wantPlayer = HasStateFields(fields, StateFields::PLAYERS);
+		bool wantCarState = HasStateFields(fields, StateFields::CAR_STATES);
+
+#ifndef NDEBUG
+		constexpr float NaN = std::numeric_limits<float>::quiet_NaN();
+		if (!wantPlayer) {
+			phys.pos = phys.vel = phys.angVel = Vec(NaN, NaN, NaN);
+			boostFraction = NaN;
+		}
+		if (!wantCarState) {
+			carState.pos = carState.vel = carState.angVel = Vec(NaN, NaN, NaN);
+			carState.boost = NaN;
+		}
+#endif
+
+		if (!wantPlayer && !wantCarState)
+			return;
+
 		CarState newState = car->GetState();
 
-		if (newState.isDemoed && newState.pos.z == -50000) {
-			newState.pos = carState.pos;
-			newState.vel = carState.vel;
-			newState.angVel = carState.angVel;
+		// Demoed cars are moved far below the field, keep their last position instead
+		bool keepLastPos = newState.isDemoed && newState.pos.z == -50000;
+
+		if (wantCarState) {
+			if (keepLastPos) {
+				newState.pos = carState.pos;
+				newState.vel = carState.vel;
+				newState.angVel = carState.angVel;
+			}
+			carState = newState;
 		}
 
-		carState = newState;
+		if (!wantPlayer)
+			return;
 
-		phys = PhysObj(carState);
-		physInv = PhysObj(phys.Invert());
+		PhysObj newPhys = PhysObj(newState);
+		if (keepLastPos && !wantCarState) {
+			newPhys.pos = phys.pos;
+			newPhys.vel = phys.vel;
+			newPhys.angVel = phys.angVel;
+		}
+		phys = newPhys;
+		_physInvValid = false;
 
-		if (carState.ballHitInfo.isValid) {
-			ballTouchedStep = carState.ballHitInfo.tickCountWhenHit >= (tickCount - tickSkip);
-			ballTouchedTick = carState.ballHitInfo.tickCountWhenHit == (tickCount - 1);
+		if (newState.ballHitInfo.isValid) {
+			ballTouchedStep = newState.ballHitInfo.tickCountWhenHit >= (tickCount - tickSkip);
+			ballTouchedTick = newState.ballHitInfo.tickCountWhenHit == (tickCount - 1);
 		} else {
 			ballTouchedStep = ballTouchedTick = false;
 		}
 
-		hasJump = !carState.hasJumped;
+		hasJump = !newState.hasJumped;
 		hasFlip =
-			!carState.hasDoubleJumped && !carState.hasFlipped
-			&& carState.airTimeSinceJump < RLConst::DOUBLEJUMP_MAX_DELAY;
+			!newState.hasDoubleJumped && !newState.hasFlipped
+			&& newState.airTimeSinceJump < RLConst::DOUBLEJUMP_MAX_DELAY;
 
-		boostFraction = carState.boost / 100;
+		boostFraction = newState.boost / 100;
 	}
-}
\ No newline at end of file
+}
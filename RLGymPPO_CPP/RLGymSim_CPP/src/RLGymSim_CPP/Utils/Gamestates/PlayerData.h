@@ -1,6 +1,7 @@
 #pragma once
 #include "../../Framework.h"
 #include "PhysObj.h"
+#include "StateFields.h"
 
 namespace RLGSC {
 	// https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/gamestates/player_data.py
@@ -8,7 +9,11 @@ namespace RLGSC {
 		uint32_t carId;
 		Team team;
 
-		PhysObj phys, physInv;
+		PhysObj phys;
+		// Inverted phys, only computed when first needed each step
+		// NOTE: Read through GetPhys(true), this is not up to date otherwise
+		mutable PhysObj physInv;
+		mutable bool _physInvValid = false;
 		CarState carState;
 
 		// matchAssists: being the passer to a teammate who shot and scored
@@ -30,10 +35,19 @@ namespace RLGSC {
 		bool ballTouchedStep; // True if the player touched the ball during any of tick of the step
 		bool ballTouchedTick; // True if the player is touching the ball on the final tick of the step
 
-		void UpdateFromCar(Car* car, uint64_t tickCount, int tickSkip);
+		// Only fills the player fields of "fields" (see StateFields)
+		// NOTE: In debug builds, fields that aren't filled are set to NaN/garbage so that reading them is noticed
+		void UpdateFromCar(Car* car, uint64_t tickCount, int tickSkip, StateFields fields = StateFields::ALL);
 
 		const PhysObj& GetPhys(bool inverted) const {
-			return inverted ? physInv : phys;
+			if (!inverted)
+				return phys;
+
+			if (!_physInvValid) {
+				physInv = phys.Invert();
+				_physInvValid = true;
+			}
+			return physInv;
 		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "StateFeatures.h"
+#include "GameState.h"
+
+inline Vec _InvertVec(const Vec& vec) {
+	return Vec(-vec.x, -vec.y, vec.z);
+}
+
+RLGSC::PlayerFeatures::PlayerFeatures(const PlayerData& player, const PhysObj& ball) {
+	relBallPos = ball.pos - player.phys.pos;
+	relBallVel = ball.vel - player.phys.vel;
+	ballDist = relBallPos.Length();
+	dirToBall = relBallPos.Normalized();
+}
+
+RLGSC::PlayerFeatures RLGSC::PlayerFeatures::Invert() const {
+	PlayerFeatures result = *this;
+	result.relBallPos = _InvertVec(relBallPos);
+	result.relBallVel = _InvertVec(relBallVel);
+	result.dirToBall = _InvertVec(dirToBall);
+	return result;
+}
+
+void RLGSC::StateFeatures::Build(const GameState& state) {
+	players.resize(state.players.size());
+	for (int i = 0; i < state.players.size(); i++)
+		players[i] = PlayerFeatures(state.players[i], state.ball);
+
+	Vec goalBacks[2] = { CommonValues::BLUE_GOAL_BACK, CommonValues::ORANGE_GOAL_BACK };
+	for (int i = 0; i < 2; i++) {
+		ballDirToGoal[i] = (goalBacks[i] - state.ball.pos).Normalized();
+		ballDirToGoalInv[i] = _InvertVec(ballDirToGoal[i]);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include "PhysObj.h"
+
+namespace RLGSC {
+	struct GameState;
+	struct PlayerData;
+
+	// Features of a player relative to the ball, in the normal orientation
+	// Inverted versions are the same with X and Y negated, see Invert()
+	struct PlayerFeatures {
+		Vec relBallPos; // Ball position - player position
+		Vec relBallVel; // Ball velocity - player velocity
+		float ballDist;
+		Vec dirToBall; // Normalized relBallPos, or zero if the player is at the ball
+
+		PlayerFeatures() = default;
+		PlayerFeatures(const PlayerData& player, const PhysObj& ball);
+
+		// Rotate 180 degrees around Z axis, like PhysObj::Invert()
+		PlayerFeatures Invert() const;
+	};
+
+	// Features that rewards and obs builders commonly share within a step
+	// Built by GameState::GetFeatures()
+	struct StateFeatures {
+		// Same order as GameState::players
+		std::vector<PlayerFeatures> players;
+
+		// Normalized direction from the ball to the back of each team's goal, indexed by team
+		Vec ballDirToGoal[2];
+		Vec ballDirToGoalInv[2];
+
+		void Build(const GameState& state);
+
+		const Vec& GetBallDirToGoal(Team goalTeam, bool inverted) const {
+			return inverted ? ballDirToGoalInv[(int)goalTeam] : ballDirToGoal[(int)goalTeam];
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include "../../Framework.h"
+
+namespace RLGSC {
+	// Parts of a GameState that GameState::UpdateFromArena() fills
+	// OBS builders, rewards and terminal conditions declare the ones they read, so each step only fills what is used (see Match::stateFields)
+	// NOTE: PlayerData::carId and team, GameState::lastArena, lastTickCount and tickTime are always filled
+	enum class StateFields : uint32_t {
+		NONE = 0,
+
+		BALL = 1 << 0, // GameState::ballState and ball
+		PLAYERS = 1 << 1, // PlayerData::phys, hasJump, hasFlip, boostFraction, ball touches, and GameState::lastTouchCarID
+		CAR_STATES = 1 << 2, // PlayerData::carState
+		BOOST_PADS = 1 << 3, // GameState::boostPads
+		SCORE_LINE = 1 << 4, // GameState::scoreLine
+
+		// Everything read by StateSoA::SetArena() and StateFeatures::Build()
+		SOA = BALL | PLAYERS | CAR_STATES,
+
+		ALL = BALL | PLAYERS | CAR_STATES | BOOST_PADS | SCORE_LINE
+	};
+
+	constexpr StateFields operator|(StateFields a, StateFields b) {
+		return (StateFields)((uint32_t)a | (uint32_t)b);
+	}
+
+	constexpr StateFields operator&(StateFields a, StateFields b) {
+		return (StateFields)((uint32_t)a & (uint32_t)b);
+	}
+
+	inline StateFields& operator|=(StateFields& a, StateFields b) {
+		return a = a | b;
+	}
+
+	// True if any of "fields" is in "set"
+	constexpr bool HasStateFields(StateFields set, StateFields fields) {
+		return (set & fields) != StateFields::NONE;
+	}
+}
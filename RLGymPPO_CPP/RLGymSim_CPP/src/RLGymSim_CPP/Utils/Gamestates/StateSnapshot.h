@@ -0,0 +1,138 @@
+#pragma once
+#include "GameState.h"
+
+namespace RLGSC {
+	// A GameState as fixed-capacity plain data, with room for up to MAX_CARS players
+	// It has no pointers or heap memory, so it can be memcpy'd, kept in ring buffers, or written straight to a socket
+	// Only the essentials of each car's state are kept, and the caches and arena of the state aren't
+	template <int MAX_CARS = 8>
+	struct StateSnapshot {
+		// Essentials of a player besides its physics
+		struct Car {
+			uint32_t carId;
+			Team team;
+			bool isOnGround, isDemoed;
+			bool hasJump, hasFlip;
+			bool ballTouchedStep, ballTouchedTick;
+			float boostFraction;
+
+			int
+				matchGoals,
+				matchSaves,
+				matchAssists,
+				matchShots,
+				matchShotPasses,
+				matchBumps,
+				matchDemos,
+				boostPickups;
+		};
+
+		PhysObj ball;
+		PhysObj carPhys[MAX_CARS];
+		Car cars[MAX_CARS];
+		int numCars = 0;
+
+		BoostPadMask boostPads;
+		ScoreLine scoreLine;
+		int lastTouchCarID = -1;
+		uint64_t lastTickCount = 0;
+		float tickTime = 1 / 120.f;
+
+		StateSnapshot() = default;
+		explicit StateSnapshot(const GameState& state) {
+			FromGameState(state);
+		}
+
+		void FromGameState(const GameState& state) {
+			if (state.players.size() > MAX_CARS)
+				RG_ERR_CLOSE("StateSnapshot::FromGameState(): State has " << state.players.size() << " players, snapshot only has room for " << MAX_CARS);
+
+			ball = state.ball;
+			numCars = state.players.size();
+			for (int i = 0; i < numCars; i++) {
+				const PlayerData& player = state.players[i];
+				carPhys[i] = player.phys;
+				cars[i] = Car{
+					player.carId, player.team,
+					player.carState.isOnGround, player.carState.isDemoed,
+					player.hasJump, player.hasFlip,
+					player.ballTouchedStep, player.ballTouchedTick,
+					player.boostFraction,
+
+					player.matchGoals,
+					player.matchSaves,
+					player.matchAssists,
+					player.matchShots,
+					player.matchShotPasses,
+					player.matchBumps,
+					player.matchDemos,
+					player.boostPickups
+				};
+			}
+
+			boostPads = state.boostPads;
+			scoreLine = state.scoreLine;
+			lastTouchCarID = state.lastTouchCarID;
+			lastTickCount = state.lastTickCount;
+			tickTime = state.tickTime;
+		}
+
+		// Fills a state from this snapshot, reusing its player memory
+		// Car states only get the essentials we keep, everything else of them is default
+		void ToGameState(GameState& state) const {
+			state.ball = ball;
+			state.ballState = {};
+			state.ballState.pos = ball.pos;
+			state.ballState.rotMat = ball.rotMat;
+			state.ballState.vel = ball.vel;
+			state.ballState.angVel = ball.angVel;
+
+			state.players.resize(numCars);
+			for (int i = 0; i < numCars; i++) {
+				const Car& car = cars[i];
+				PlayerData& player = state.players[i];
+
+				player.carId = car.carId;
+				player.team = car.team;
+				player.phys = carPhys[i];
+				player._physInvValid = false;
+
+				player.carState = {};
+				player.carState.pos = carPhys[i].pos;
+				player.carState.rotMat = carPhys[i].rotMat;
+				player.carState.vel = carPhys[i].vel;
+				player.carState.angVel = carPhys[i].angVel;
+				player.carState.boost = car.boostFraction * 100;
+				player.carState.isOnGround = car.isOnGround;
+				player.carState.isDemoed = car.isDemoed;
+				player.carState.hasJumped = !car.hasJump;
+
+				player.hasJump = car.hasJump;
+				player.hasFlip = car.hasFlip;
+				player.ballTouchedStep = car.ballTouchedStep;
+				player.ballTouchedTick = car.ballTouchedTick;
+				player.boostFraction = car.boostFraction;
+
+				player.matchGoals = car.matchGoals;
+				player.matchSaves = car.matchSaves;
+				player.matchAssists = car.matchAssists;
+				player.matchShots = car.matchShots;
+				player.matchShotPasses = car.matchShotPasses;
+				player.matchBumps = car.matchBumps;
+				player.matchDemos = car.matchDemos;
+				player.boostPickups = car.boostPickups;
+			}
+
+			state.boostPads = boostPads;
+			state.scoreLine = scoreLine;
+			state.lastTouchCarID = lastTouchCarID;
+			state.lastTickCount = lastTickCount;
+			state.tickTime = tickTime;
+			state.lastArena = NULL;
+			state.validFields = StateFields::ALL;
+			state.InvalidateCaches();
+		}
+	};
+
+	static_assert(std::is_trivially_copyable_v<StateSnapshot<>>);
+}
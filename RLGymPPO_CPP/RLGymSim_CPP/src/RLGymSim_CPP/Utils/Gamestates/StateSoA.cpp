@@ -0,0 +1,46 @@
+#include "StateSoA.h"
+#include "GameState.h"
+
+void RLGSC::StateSoA::AddArena(int arenaCars) {
+	numArenas++;
+	numCars += arenaCars;
+	arenaCarStart.push_back(numCars);
+
+	for (Vec3Arrays* arrays : { &carPos, &carVel, &carAngVel, &carForward, &carUp })
+		arrays->Resize(numCars);
+	carBoost.resize(numCars);
+	for (auto* list : { &carTeam, &carOnGround, &carHasFlip, &carDemoed, &carBallTouched })
+		list->resize(numCars);
+	carArena.resize(numCars, numArenas - 1);
+
+	for (Vec3Arrays* arrays : { &ballPos, &ballVel, &ballAngVel })
+		arrays->Resize(numArenas);
+}
+
+void RLGSC::StateSoA::SetArena(int arenaIndex, const GameState& state) {
+	int carStart = arenaCarStart[arenaIndex];
+	if (state.players.size() != arenaCarStart[arenaIndex + 1] - carStart)
+		RG_ERR_CLOSE("StateSoA::SetArena(): State has " << state.players.size() << " players, expected " << (arenaCarStart[arenaIndex + 1] - carStart));
+
+	for (int i = 0; i < state.players.size(); i++) {
+		auto& player = state.players[i];
+		int carIndex = carStart + i;
+
+		carPos.Set(carIndex, player.phys.pos);
+		carVel.Set(carIndex, player.phys.vel);
+		carAngVel.Set(carIndex, player.phys.angVel);
+		carForward.Set(carIndex, player.phys.rotMat.forward);
+		carUp.Set(carIndex, player.phys.rotMat.up);
+		carBoost[carIndex] = player.boostFraction;
+
+		carTeam[carIndex] = (uint8_t)player.team;
+		carOnGround[carIndex] = player.carState.isOnGround;
+		carHasFlip[carIndex] = player.hasFlip;
+		carDemoed[carIndex] = player.carState.isDemoed;
+		carBallTouched[carIndex] = player.ballTouchedStep;
+	}
+
+	ballPos.Set(arenaIndex, state.ball.pos);
+	ballVel.Set(arenaIndex, state.ball.vel);
+	ballAngVel.Set(arenaIndex, state.ball.angVel);
+}
\ No newline at end of file
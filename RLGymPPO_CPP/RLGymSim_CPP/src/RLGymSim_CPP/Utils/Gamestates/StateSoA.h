@@ -0,0 +1,56 @@
+#pragma once
+#include "PhysObj.h"
+#include "../BasicTypes/Lists.h"
+
+namespace RLGSC {
+	struct GameState;
+
+	// Vectors stored as a separate array for each component, so they can be processed in batched/SIMD passes
+	struct Vec3Arrays {
+		FList x, y, z;
+
+		size_t Size() const {
+			return x.size();
+		}
+
+		void Resize(size_t size) {
+			x.resize(size);
+			y.resize(size);
+			z.resize(size);
+		}
+
+		void Set(size_t index, const Vec& vec) {
+			x[index] = vec.x;
+			y[index] = vec.y;
+			z[index] = vec.z;
+		}
+
+		Vec Get(size_t index) const {
+			return Vec(x[index], y[index], z[index]);
+		}
+	};
+
+	// State of many arenas, in structure-of-arrays form
+	// Cars of all arenas are stored together, arena i has cars [arenaCarStart[i], arenaCarStart[i + 1])
+	// Car indices match the player indices of each arena's GameState
+	struct StateSoA {
+		int numArenas = 0, numCars = 0;
+		IList arenaCarStart = { 0 };
+
+		// Per car
+		Vec3Arrays carPos, carVel, carAngVel, carForward, carUp;
+		FList carBoost; // From 0 to 1
+		std::vector<uint8_t> carTeam, carOnGround, carHasFlip, carDemoed, carBallTouched;
+		IList carArena; // Index of each car's arena
+
+		// Per arena
+		Vec3Arrays ballPos, ballVel, ballAngVel;
+
+		// Adds an arena at the end, with space for this many cars
+		void AddArena(int arenaCars);
+
+		// Copies the state of an arena into our arrays
+		// NOTE: The state must have the number of players the arena was added with
+		void SetArena(int arenaIndex, const GameState& state);
+	};
+}
\ No newline at end of file
@@ -1,14 +1,14 @@
 #include "DefaultOBS.h"
 
-void RLGSC::DefaultOBS::AddPlayerToOBS(FList& obs, const PlayerData& player, bool inv) {
-	PhysObj phys = player.GetPhys(inv);
+void RLGSC::DefaultOBS::AddPlayerToOBS(FListWriter& obs, const PlayerData& player, bool inv) {
+	auto& phys = player.GetPhys(inv);
 
 	obs += phys.pos * posCoef;
 	obs += phys.rotMat.forward;
 	obs += phys.rotMat.up;
 	obs += phys.vel * velCoef;
-	obs += phys.angVel * angVelCoef,
-		
+	obs += phys.angVel * angVelCoef;
+
 	obs += {
 		player.boostFraction,
 		(float)player.carState.isOnGround,
@@ -17,40 +17,174 @@ void RLGSC::DefaultOBS::AddPlayerToOBS(FList& obs, const PlayerData& player, boo
 	};
 }
 
-RLGSC::FList RLGSC::DefaultOBS::BuildOBS(const PlayerData& player, const GameState& state, const Action& prevAction) {
-	FList result = {};
+void RLGSC::DefaultOBS::AddPlayerToOBS(FList& obs, const PlayerData& player, bool inv) {
+	size_t startSize = obs.size();
+	obs.resize(startSize + PLAYER_OBS_SIZE);
 
-	bool inv = player.team == Team::ORANGE;
+	FListWriter writer = std::span<float>(obs.data() + startSize, PLAYER_OBS_SIZE);
+	AddPlayerToOBS(writer, player, inv);
+}
 
+void RLGSC::DefaultOBS::AddBaseToOBS(FListWriter& obs, const PlayerData& player, const GameState& state, const Action& prevAction, bool inv) {
 	auto& ball = state.GetBallPhys(inv);
-	auto& pads = state.GetBoostPads(inv);
 
-	result += ball.pos * posCoef;
-	result += ball.vel * velCoef;
-	result += ball.angVel * angVelCoef;
+	obs += ball.pos * posCoef;
+	obs += ball.vel * velCoef;
+	obs += ball.angVel * angVelCoef;
 
 	for (int i = 0; i < prevAction.ELEM_AMOUNT; i++)
-		result += prevAction[i];
+		obs += prevAction[i];
 
-	for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++)
-		result += (float)pads[i];
+	RG_PARA_ASSERT(obs.Remaining() >= BoostPadMask::PAD_AMOUNT);
+	state.GetBoostPads(inv).WriteTo(obs.cur);
+	obs.cur += BoostPadMask::PAD_AMOUNT;
+}
+
+const RLGSC::OBSBlockCache::Side& RLGSC::DefaultOBS::GetBlocks(const GameState& state, bool inv) {
+	return blockCache.Get(
+		state, inv,
+		[&](FListWriter& obs, const GameState& state, bool inv) {
+			auto& ball = state.GetBallPhys(inv);
+			obs += ball.pos * posCoef;
+			obs += ball.vel * velCoef;
+			obs += ball.angVel * angVelCoef;
+
+			state.GetBoostPads(inv).WriteTo(obs.cur);
+			obs.cur += BoostPadMask::PAD_AMOUNT;
+		},
+		[&](FListWriter& obs, const PlayerData& player, bool inv) {
+			AddPlayerToOBS(obs, player, inv);
+		}
+	);
+}
 
-	AddPlayerToOBS(result, player, inv);
+void RLGSC::DefaultOBS::AddBaseFromBlocks(FListWriter& obs, const OBSBlockCache::Side& blocks, const Action& prevAction) {
+	RG_PARA_ASSERT(obs.Remaining() >= BASE_OBS_SIZE);
+	constexpr int BALL_SIZE = 9;
+	const float* gameBlock = blocks.gameBlock.data();
 
-	FList teammates = {}, opponents = {};
+	obs.cur = std::copy(gameBlock, gameBlock + BALL_SIZE, obs.cur);
+	for (int i = 0; i < prevAction.ELEM_AMOUNT; i++)
+		obs += prevAction[i];
+	obs.cur = std::copy(gameBlock + BALL_SIZE, gameBlock + GAME_BLOCK_SIZE, obs.cur);
+}
 
-	for (auto& otherPlayer : state.players) {
-		if (otherPlayer.carId == player.carId)
-			continue;
+RLGSC::FList RLGSC::DefaultOBS::GetOBSScales(const GameState& state) {
+	// Things can go a bit past the walls (i.e. into the goal nets), so leave some room
+	Vec posScale = Vec(CommonValues::SIDE_WALL_X, CommonValues::BACK_NET_Y, CommonValues::CEILING_Z) * posCoef * 1.25f;
+	float velScale = CommonValues::BALL_MAX_SPEED * velCoef * 1.25f;
+	float angVelScale = 6 * angVelCoef * 1.25f; // Ball max angular velocity is 6, which is above CAR_MAX_ANG_VEL
 
-		AddPlayerToOBS(
-			(otherPlayer.team == player.team) ? teammates : opponents,
-			otherPlayer,
-			inv
-		);
+	FList result = {};
+	auto fnAddPhys = [&](bool withRot) {
+		result += posScale;
+		if (withRot)
+			result += FList(6, 1); // Forward and up
+		result += FList(3, velScale);
+		result += FList(3, angVelScale);
+	};
+
+	// Ball
+	fnAddPhys(false);
+
+	// Previous action and boost pads
+	result += FList(Action::ELEM_AMOUNT + CommonValues::BOOST_LOCATIONS_AMOUNT, 1);
+
+	// Players (this also covers the padding of DefaultOBSPadded)
+	size_t obsSize = GetOBSSize(state);
+	while (result.size() + PLAYER_OBS_SIZE <= obsSize) {
+		fnAddPhys(true);
+		result += FList(4, 1); // Boost and flags
 	}
 
-	result += teammates;
-	result += opponents;
+	// Anything after the players (i.e. slot masks of DefaultOBSPadded) is 0 or 1
+	result.resize(obsSize, 1);
+
+	RG_PARA_ASSERT(result.size() == obsSize);
 	return result;
-}
\ No newline at end of file
+}
+
+// Index of the boost pad at the left-right mirror of each of CommonValues::BOOST_LOCATIONS
+RLGSC::IList _GetBoostPadMirrorSources() {
+	using namespace RLGSC;
+
+	IList result = {};
+	for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++) {
+		Vec mirrorPos = CommonValues::BOOST_LOCATIONS[i] * Vec(-1, 1, 1);
+		for (int j = 0; j < CommonValues::BOOST_LOCATIONS_AMOUNT; j++) {
+			if (CommonValues::BOOST_LOCATIONS[j].DistSq2D(mirrorPos) < 10) {
+				result.push_back(j);
+				break;
+			}
+		}
+	}
+
+	if (result.size() != CommonValues::BOOST_LOCATIONS_AMOUNT)
+		RG_ERR_CLOSE("DefaultOBS: CommonValues::BOOST_LOCATIONS are not left-right symmetric");
+	return result;
+}
+
+RLGSC::OBSMirrorMap RLGSC::DefaultOBS::GetOBSMirrorMap(const GameState& state) {
+	// Orange players see the field inverted, mirroring doesn't depend on that as the inversion and mirror commute
+	OBSMirrorMap result = {};
+
+	// Ball
+	result.AddVec();
+	result.AddVec();
+	result.AddAngVel();
+
+	// Previous action, steer, yaw and roll flip
+	result.Add({ 1, -1, 1, -1, -1, 1, 1, 1 });
+
+	// Boost pads
+	static const IList BOOST_PAD_MIRROR_SOURCES = _GetBoostPadMirrorSources();
+	result.AddPermuted(BOOST_PAD_MIRROR_SOURCES);
+
+	// Players (this also covers the padding of DefaultOBSPadded)
+	size_t obsSize = GetOBSSize(state);
+	while (result.sourceIndices.size() + PLAYER_OBS_SIZE <= obsSize) {
+		result.AddVec(); // Position
+		result.AddVec(); // Forward
+		result.AddVec(); // Up
+		result.AddVec(); // Velocity
+		result.AddAngVel();
+		result.AddSame(4); // Boost and flags
+	}
+
+	// Anything after the players (i.e. slot masks of DefaultOBSPadded) stays the same
+	result.AddSame(obsSize - result.sourceIndices.size());
+
+	RG_PARA_ASSERT(result.sourceIndices.size() == obsSize);
+	return result;
+}
+
+void RLGSC::DefaultOBS::BuildOBSInto(std::span<float> out, const PlayerData& player, const GameState& state, const Action& prevAction) {
+	RG_PARA_ASSERT(out.size() == GetOBSSize(state));
+	FListWriter writer = out;
+
+	bool inv = player.team == Team::ORANGE;
+	auto& blocks = GetBlocks(state, inv);
+
+	auto fnAddCarBlock = [&](int playerIndex) {
+		const float* carBlock = blocks.carBlocks.data() + (size_t)playerIndex * PLAYER_OBS_SIZE;
+		writer.cur = std::copy(carBlock, carBlock + PLAYER_OBS_SIZE, writer.cur);
+	};
+
+	AddBaseFromBlocks(writer, blocks, prevAction);
+	for (int i = 0; i < state.players.size(); i++)
+		if (state.players[i].carId == player.carId)
+			fnAddCarBlock(i);
+
+	// Teammates first, then opponents
+	for (int i = 0; i < 2; i++) {
+		bool teammates = (i == 0);
+		for (int j = 0; j < state.players.size(); j++) {
+			auto& otherPlayer = state.players[j];
+			if (otherPlayer.carId == player.carId)
+				continue;
+
+			if ((otherPlayer.team == player.team) == teammates)
+				fnAddCarBlock(j);
+		}
+	}
+}
@@ -1,11 +1,21 @@
 #pragma once
 #include "OBSBuilder.h"
+#include "OBSBlockCache.h"
 
 // https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/obs_builders/default_obs.py
 namespace RLGSC {
 	class DefaultOBS : public OBSBuilder {
 	public:
 
+		// Ball, previous action, and boost pads
+		constexpr static int BASE_OBS_SIZE = 9 + Action::ELEM_AMOUNT + CommonValues::BOOST_LOCATIONS_AMOUNT;
+
+		// Size of the OBS from AddPlayerToOBS()
+		constexpr static int PLAYER_OBS_SIZE = 19;
+
+		// Ball and boost pads, which are the same for every player on the same team
+		constexpr static int GAME_BLOCK_SIZE = 9 + CommonValues::BOOST_LOCATIONS_AMOUNT;
+
 		Vec posCoef;
 		float velCoef, angVelCoef;
 		DefaultOBS(
@@ -16,8 +26,36 @@ namespace RLGSC {
 
 		}
 
+		void AddPlayerToOBS(FListWriter& obs, const PlayerData& player, bool inv);
 		void AddPlayerToOBS(FList& obs, const PlayerData& player, bool inv);
 
-		virtual FList BuildOBS(const PlayerData& player, const GameState& state, const Action& prevAction);
+		// Adds the ball, previous action, and boost pads
+		void AddBaseToOBS(FListWriter& obs, const PlayerData& player, const GameState& state, const Action& prevAction, bool inv);
+
+		// The ball, boost pads, and AddPlayerToOBS() of every car, built once per step for each team's orientation
+		// Every player's OBS is then copied together from these
+		OBSBlockCache blockCache = OBSBlockCache(GAME_BLOCK_SIZE, PLAYER_OBS_SIZE);
+		const OBSBlockCache::Side& GetBlocks(const GameState& state, bool inv);
+
+		// Same as AddBaseToOBS(), but copied from the blocks
+		void AddBaseFromBlocks(FListWriter& obs, const OBSBlockCache::Side& blocks, const Action& prevAction);
+
+		virtual void PreStep(const GameState& state) {
+			blockCache.Invalidate();
+		}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::BALL | StateFields::PLAYERS | StateFields::CAR_STATES | StateFields::BOOST_PADS;
+		}
+
+		virtual int GetOBSSize(const GameState& state) {
+			return BASE_OBS_SIZE + PLAYER_OBS_SIZE * state.players.size();
+		}
+
+		virtual FList GetOBSScales(const GameState& state);
+
+		virtual OBSMirrorMap GetOBSMirrorMap(const GameState& state);
+
+		virtual void BuildOBSInto(std::span<float> out, const PlayerData& player, const GameState& state, const Action& prevAction);
 	};
-}
\ No newline at end of file
+}
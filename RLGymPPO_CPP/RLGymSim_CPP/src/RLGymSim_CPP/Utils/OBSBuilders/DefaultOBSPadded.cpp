@@ -1,67 +1,86 @@
 #include "DefaultOBSPadded.h"
 
-RLGSC::FList RLGSC::DefaultOBSPadded::BuildOBS(const PlayerData& player, const GameState& state, const Action& prevAction) {
-	FList result = {};
-
-	bool inv = player.team == Team::ORANGE;
-
-	auto& ball = state.GetBallPhys(inv);
-	auto& pads = state.GetBoostPads(inv);
-
-	result += ball.pos * posCoef;
-	result += ball.vel * velCoef;
-	result += ball.angVel * angVelCoef;
-
-	for (int i = 0; i < prevAction.ELEM_AMOUNT; i++)
-		result += prevAction[i];
-
-	for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++)
-		result += (float)pads[i];
-
-	FList selfOBS = {};
-	AddPlayerToOBS(selfOBS, player, inv);
-	result += selfOBS;
-	int playerObsSize = selfOBS.size();
+// Shuffles blocks of floats in-place
+// If set, mask has a float for each block, which is shuffled along with it
+void _ShuffleOBSBlocks(float* data, int blockCount, int blockSize, float* mask = NULL) {
+	auto& randEngine = ::Math::GetRandEngine();
+	for (int i = blockCount - 1; i > 0; i--) {
+		int j = std::uniform_int_distribution<int>(0, i)(randEngine);
+		if (j != i) {
+			std::swap_ranges(data + i * blockSize, data + (i + 1) * blockSize, data + j * blockSize);
+			if (mask)
+				std::swap(mask[i], mask[j]);
+		}
+	}
+}
 
-	FList2 teammates = {}, opponents = {};
+void RLGSC::DefaultOBSPadded::BuildOBSInto(std::span<float> out, const PlayerData& player, const GameState& state, const Action& prevAction) {
+	RG_PARA_ASSERT(out.size() == GetOBSSize(state));
 
+	int teammateCount = 0, opponentCount = 0;
 	for (auto& otherPlayer : state.players) {
 		if (otherPlayer.carId == player.carId)
 			continue;
 
-		FList playerObs = {};
-		AddPlayerToOBS(
-			playerObs,
-			otherPlayer,
-			inv
-		);
-		((otherPlayer.team == player.team) ? teammates : opponents).push_back(playerObs);
+		((otherPlayer.team == player.team) ? teammateCount : opponentCount)++;
 	}
 
-	if (teammates.size() > maxPlayers - 1)
+	if (teammateCount > maxPlayers - 1)
 		RG_ERR_CLOSE("DefaultOBSPadded: Too many teammates for OBS, maximum is " << (maxPlayers - 1));
 	
-	if (opponents.size() > maxPlayers)
+	if (opponentCount > maxPlayers)
 		RG_ERR_CLOSE("DefaultOBSPadded: Too many opponents for OBS, maximum is " << maxPlayers);
 
+	FListWriter writer = out;
+
+	bool inv = player.team == Team::ORANGE;
+	auto& blocks = GetBlocks(state, inv);
+
+	auto fnAddCarBlock = [&](int playerIndex) {
+		const float* carBlock = blocks.carBlocks.data() + (size_t)playerIndex * PLAYER_OBS_SIZE;
+		writer.cur = std::copy(carBlock, carBlock + PLAYER_OBS_SIZE, writer.cur);
+	};
+
+	AddBaseFromBlocks(writer, blocks, prevAction);
+	for (int i = 0; i < state.players.size(); i++)
+		if (state.players[i].carId == player.carId)
+			fnAddCarBlock(i);
+
+	// Slot masks go after all slots, in the same order
+	float* maskStart = addSlotMasks ? (writer.cur + PLAYER_OBS_SIZE * GetSlotAmount()) : NULL;
+
+	// Teammates first, then opponents
 	for (int i = 0; i < 2; i++) {
-		auto& playerList = i ? teammates : opponents;
-		int targetCount = i ? maxPlayers - 1 : maxPlayers;
+		bool teammates = (i == 0);
+		int targetCount = teammates ? maxPlayers - 1 : maxPlayers;
+		float* listStart = writer.cur;
 
-		while (playerList.size() < targetCount) {
-			FList pad = FList(playerObsSize);
-			playerList.push_back(pad);
+		for (int j = 0; j < state.players.size(); j++) {
+			auto& otherPlayer = state.players[j];
+			if (otherPlayer.carId == player.carId)
+				continue;
+
+			if ((otherPlayer.team == player.team) == teammates)
+				fnAddCarBlock(j);
 		}
-	}
 
-	// Shuffle both lists
-	std::shuffle(teammates.begin(), teammates.end(), ::Math::GetRandEngine());
-	std::shuffle(opponents.begin(), opponents.end(), ::Math::GetRandEngine());
+		// Pad the remaining slots with zeros
+		float* listEnd = listStart + targetCount * PLAYER_OBS_SIZE;
+		int filledCount = (writer.cur - listStart) / PLAYER_OBS_SIZE;
+		std::fill(writer.cur, listEnd, 0.f);
+		writer.cur = listEnd;
+
+		float* listMask = NULL;
+		if (addSlotMasks) {
+			listMask = maskStart + (teammates ? 0 : maxPlayers - 1);
+			std::fill(listMask, listMask + targetCount, 0.f);
+			std::fill(listMask, listMask + filledCount, 1.f);
+		}
 
-	for (auto& teammate : teammates)
-		result += teammate;
-	for (auto& opponent : opponents)
-		result += opponent;
+		// Shuffle slots to prevent slot bias
+		_ShuffleOBSBlocks(listStart, targetCount, PLAYER_OBS_SIZE, listMask);
+	}
 
-	return result;
-}
\ No newline at end of file
+	if (addSlotMasks)
+		writer.cur += GetSlotAmount();
+}
@@ -5,20 +5,36 @@ namespace RLGSC {
 	// Verion of DefaultOBS that supports a varying number of players (i.e. 1v1, 2v2, 3v3, etc.)
 	// Maximum player count can be however high you want
 	// Opponent and teammate slots are randomly shuffled to prevent slot bias
+	// As every player's OBS has the same size, games of different team sizes can be mixed in one agent (and so in one inference batch and experience buffer)
 	class DefaultOBSPadded : public DefaultOBS {
 	public:
 
 		int maxPlayers;
 
+		// If set, a mask of which teammate and opponent slots hold a car is added after the slots
+		// Otherwise, padded slots are only told apart by being all zeros
+		bool addSlotMasks;
+
 		DefaultOBSPadded(
 			int maxPlayers,
 			Vec posCoef = Vec(1 / CommonValues::SIDE_WALL_X, 1 / CommonValues::BACK_WALL_Y, 1 / CommonValues::CEILING_Z),
 			float velCoef = 1 / CommonValues::CAR_MAX_SPEED,
-			float angVelCoef = 1 / CommonValues::CAR_MAX_ANG_VEL
-		) : DefaultOBS(posCoef, velCoef, angVelCoef), maxPlayers(maxPlayers) {
+			float angVelCoef = 1 / CommonValues::CAR_MAX_ANG_VEL,
+			bool addSlotMasks = false
+		) : DefaultOBS(posCoef, velCoef, angVelCoef), maxPlayers(maxPlayers), addSlotMasks(addSlotMasks) {
+
+		}
+
+		// Amount of teammate and opponent slots
+		int GetSlotAmount() const {
+			return maxPlayers * 2 - 1;
+		}
 
+		// Self, (maxPlayers - 1) teammates, maxPlayers opponents, and their slot masks if addSlotMasks
+		virtual int GetOBSSize(const GameState& state) {
+			return BASE_OBS_SIZE + PLAYER_OBS_SIZE * (maxPlayers * 2) + (addSlotMasks ? GetSlotAmount() : 0);
 		}
 
-		virtual FList BuildOBS(const PlayerData& player, const GameState& state, const Action& prevAction);
+		virtual void BuildOBSInto(std::span<float> out, const PlayerData& player, const GameState& state, const Action& prevAction);
 	};
 }
\ No newline at end of file
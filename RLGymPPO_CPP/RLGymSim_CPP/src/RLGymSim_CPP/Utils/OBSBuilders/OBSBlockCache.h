@@ -0,0 +1,64 @@
+#pragma once
+#include "../Gamestates/GameState.h"
+#include "../BasicTypes/Lists.h"
+
+namespace RLGSC {
+	// Blocks of OBS features that don't depend on which player the OBS is for, so they only need to be built once per step
+	// The game block is shared by every player that sees the game from the same side (i.e. the ball and boost pads)
+	// Car blocks are one per player, and are the same in the OBS of every player on the same side (i.e. physics of each car)
+	// Each orientation (normal or inverted) is built on first use, builders then copy blocks into each player's OBS
+	// NOTE: Blocks are rebuilt after Invalidate() (i.e. from OBSBuilder::PreStep()), or when used with a different state or tick
+	class OBSBlockCache {
+	public:
+		int gameBlockSize, carBlockSize;
+
+		struct Side {
+			FList gameBlock; // [gameBlockSize]
+			FList carBlocks; // [players][carBlockSize], in the order of GameState::players
+			bool valid = false;
+		};
+		Side sides[2] = {}; // Normal, inverted
+
+		OBSBlockCache(int gameBlockSize, int carBlockSize) : gameBlockSize(gameBlockSize), carBlockSize(carBlockSize) {}
+
+		void Invalidate() {
+			for (auto& side : sides)
+				side.valid = false;
+		}
+
+		// fnGameBlock(FListWriter&, const GameState&, bool inverted) writes the game block
+		// fnCarBlock(FListWriter&, const PlayerData&, bool inverted) writes the block of a car
+		template <typename GameBlockFn, typename CarBlockFn>
+		const Side& Get(const GameState& state, bool inverted, GameBlockFn&& fnGameBlock, CarBlockFn&& fnCarBlock) {
+			if (&state != _lastState || state.lastTickCount != _lastTickCount) {
+				Invalidate();
+				_lastState = &state;
+				_lastTickCount = state.lastTickCount;
+			}
+
+			Side& side = sides[inverted];
+			if (side.valid)
+				return side;
+
+			// Only allocates when the player amount grows
+			side.gameBlock.resize(gameBlockSize);
+			side.carBlocks.resize(state.players.size() * (size_t)carBlockSize);
+
+			FListWriter gameWriter = std::span<float>(side.gameBlock);
+			fnGameBlock(gameWriter, state, inverted);
+			RG_PARA_ASSERT(gameWriter.Remaining() == 0);
+
+			for (size_t i = 0; i < state.players.size(); i++) {
+				FListWriter carWriter = std::span<float>(side.carBlocks.data() + i * carBlockSize, carBlockSize);
+				fnCarBlock(carWriter, state.players[i], inverted);
+				RG_PARA_ASSERT(carWriter.Remaining() == 0);
+			}
+
+			side.valid = true;
+			return side;
+		}
+
+		const GameState* _lastState = NULL;
+		uint64_t _lastTickCount = 0;
+	};
+}
\ No newline at end of file
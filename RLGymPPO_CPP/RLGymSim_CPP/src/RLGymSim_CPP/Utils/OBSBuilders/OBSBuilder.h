@@ -5,13 +5,105 @@
 
 // https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/obs_builders/obs_builder.py
 namespace RLGSC {
+	// How an OBS changes when the field is mirrored left-right (across the X axis, see PhysObj::MirrorX())
+	// Feature i of the mirrored OBS is feature sourceIndices[i] of the OBS, times signs[i]
+	struct OBSMirrorMap {
+		IList sourceIndices;
+		FList signs;
+
+		bool IsSet() const {
+			return !sourceIndices.empty();
+		}
+
+		// Adds features that keep their place, with the sign of each
+		void Add(std::initializer_list<float> featureSigns) {
+			for (float sign : featureSigns) {
+				sourceIndices.push_back(sourceIndices.size());
+				signs.push_back(sign);
+			}
+		}
+
+		// Adds features that stay the same
+		void AddSame(int amount) {
+			for (int i = 0; i < amount; i++)
+				Add({ 1 });
+		}
+
+		// Adds a vector whose X flips, such as a position, velocity, or rotation axis
+		void AddVec() {
+			Add({ -1, 1, 1 });
+		}
+
+		// Adds an angular velocity, whose Y and Z flip
+		void AddAngVel() {
+			Add({ 1, -1, -1 });
+		}
+
+		// Adds features that swap places, feature i of them comes from feature sources[i]
+		void AddPermuted(const IList& sources) {
+			int start = sourceIndices.size();
+			for (int source : sources) {
+				sourceIndices.push_back(start + source);
+				signs.push_back(1);
+			}
+		}
+	};
+
 	class OBSBuilder {
 	public:
+		// Builders can own and delete other builders through this base (e.g. StackingOBS)
+		virtual ~OBSBuilder() = default;
+
 		virtual void Reset(const GameState& initialState) {}
 
 		virtual void PreStep(const GameState& state) {}
 
+		// Fields of the state read by this, only the fields needed by a match are filled each step (see StateFields)
+		// Default implementation needs everything
+		virtual StateFields GetStateFields() {
+			return StateFields::ALL;
+		}
+
+		// Size of the OBS each player will get in this state, or -1 if it is not known ahead of time
+		// NOTE: Must be overriden to use the default BuildOBS()
+		virtual int GetOBSSize(const GameState& state) {
+			return -1;
+		}
+
+		// Writes the OBS directly into "out", which has a size of GetOBSSize()
+		// Builders should override this instead of BuildOBS() for the OBS to be built without any heap allocation
+		// Default implementation copies the result of BuildOBS()
+		// NOTE: You must override either this or BuildOBS()
+		virtual void BuildOBSInto(std::span<float> out, const PlayerData& player, const GameState& state, const Action& prevAction) {
+			FList obs = BuildOBS(player, state, prevAction);
+			if (obs.size() != out.size())
+				RG_ERR_CLOSE("OBSBuilder::BuildOBSInto(): OBS has a size of " << obs.size() << ", expected " << out.size());
+
+			std::copy(obs.begin(), obs.end(), out.begin());
+		}
+
+		// Maximum absolute value of each OBS feature in this state, or empty if not known
+		// Used by the learner to store observations as scaled int16, features outside of their range are clamped
+		virtual FList GetOBSScales(const GameState& state) {
+			return {};
+		}
+
+		// Left-right mirror of the OBS in this state, or empty if the OBS can't be mirrored
+		// Used by the learner to mirror samples during learning (see LearnerConfig::mirrorFraction)
+		virtual OBSMirrorMap GetOBSMirrorMap(const GameState& state) {
+			return {};
+		}
+
 		// NOTE: May be called once during environment initialization to determine policy neuron size
-		virtual FList BuildOBS(const PlayerData& player, const GameState& state, const Action& prevAction) = 0;
+		// Default implementation builds the OBS with BuildOBSInto()
+		virtual FList BuildOBS(const PlayerData& player, const GameState& state, const Action& prevAction) {
+			int obsSize = GetOBSSize(state);
+			if (obsSize < 0)
+				RG_ERR_CLOSE("OBSBuilder::BuildOBS(): OBS builder must override either BuildOBS() or GetOBSSize()");
+
+			FList result = FList(obsSize);
+			BuildOBSInto(result, player, state, prevAction);
+			return result;
+		}
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,111 @@
+#include "StackingOBS.h"
+
+void RLGSC::StackingOBS::Reset(const GameState& initialState) {
+	childBuilder->Reset(initialState);
+
+	// Cars keep their stacks across episodes, so they aren't re-allocated
+	for (auto& stack : _stacks)
+		stack.isEmpty = true;
+}
+
+RLGSC::FList RLGSC::StackingOBS::GetOBSScales(const GameState& state) {
+	FList childScales = childBuilder->GetOBSScales(state);
+	if (childScales.empty())
+		return {};
+
+	FList result = {};
+	result.reserve(childScales.size() * stackSize);
+	for (int i = 0; i < stackSize; i++)
+		result += childScales;
+	return result;
+}
+
+RLGSC::OBSMirrorMap RLGSC::StackingOBS::GetOBSMirrorMap(const GameState& state) {
+	OBSMirrorMap childMap = childBuilder->GetOBSMirrorMap(state);
+	if (!childMap.IsSet())
+		return {};
+
+	// Every frame is mirrored the same way
+	OBSMirrorMap result = {};
+	for (int i = 0; i < stackSize; i++) {
+		int frameStart = result.sourceIndices.size();
+		for (int j = 0; j < childMap.sourceIndices.size(); j++) {
+			result.sourceIndices.push_back(frameStart + childMap.sourceIndices[j]);
+			result.signs.push_back(childMap.signs[j]);
+		}
+	}
+	return result;
+}
+
+void RLGSC::StackingOBS::BuildOBSInto(std::span<float> out, const PlayerData& player, const GameState& state, const Action& prevAction) {
+	if (out.size() % stackSize != 0)
+		RG_ERR_CLOSE("StackingOBS::BuildOBSInto(): OBS size of " << out.size() << " is not a multiple of the stack size (" << stackSize << ")");
+
+	int frameSize = out.size() / stackSize;
+	auto& stack = _GetStack(player.carId, frameSize);
+	float* frame = _NextFrame(stack);
+	childBuilder->BuildOBSInto(std::span<float>(frame, frameSize), player, state, prevAction);
+	_WriteStack(stack, out.data());
+}
+
+RLGSC::FList RLGSC::StackingOBS::BuildOBS(const PlayerData& player, const GameState& state, const Action& prevAction) {
+	if (childBuilder->GetOBSSize(state) >= 0)
+		return OBSBuilder::BuildOBS(player, state, prevAction);
+
+	// The child's OBS size isn't known ahead of time, so we need to build it first
+	FList childOBS = childBuilder->BuildOBS(player, state, prevAction);
+	auto& stack = _GetStack(player.carId, childOBS.size());
+	std::copy(childOBS.begin(), childOBS.end(), _NextFrame(stack));
+
+	FList result = FList(childOBS.size() * stackSize);
+	_WriteStack(stack, result.data());
+	return result;
+}
+
+RLGSC::StackingOBS::PlayerStack& RLGSC::StackingOBS::_GetStack(uint32_t carId, int frameSize) {
+	PlayerStack* stack = NULL;
+	for (auto& otherStack : _stacks) {
+		if (otherStack.carId == carId) {
+			stack = &otherStack;
+			break;
+		}
+	}
+
+	if (!stack) {
+		_stacks.push_back({});
+		stack = &_stacks.back();
+		stack->carId = carId;
+		stack->frameSize = -1;
+	}
+
+	if (stack->frameSize != frameSize) {
+		stack->frameSize = frameSize;
+		stack->frames = FList((size_t)frameSize * stackSize);
+		stack->isEmpty = true;
+	}
+
+	return *stack;
+}
+
+float* RLGSC::StackingOBS::_NextFrame(PlayerStack& stack) {
+	stack.newest = stack.isEmpty ? 0 : (stack.newest + 1) % stackSize;
+	return stack.frames.data() + (size_t)stack.newest * stack.frameSize;
+}
+
+void RLGSC::StackingOBS::_WriteStack(PlayerStack& stack, float* out) {
+	int frameSize = stack.frameSize;
+	float* frames = stack.frames.data();
+
+	if (stack.isEmpty) {
+		// The newest frame is the first of the episode, which stands in for all of the frames before it
+		for (int i = 1; i < stackSize; i++)
+			memcpy(frames + (size_t)i * frameSize, frames, frameSize * sizeof(float));
+		stack.isEmpty = false;
+	}
+
+	// Oldest first: the frames after the newest, then the frames up to and including it
+	size_t oldestFrames = stackSize - 1 - stack.newest;
+	size_t newestFrames = stack.newest + 1;
+	memcpy(out, frames + newestFrames * frameSize, oldestFrames * frameSize * sizeof(float));
+	memcpy(out + oldestFrames * frameSize, frames, newestFrames * frameSize * sizeof(float));
+}
\ No newline at end of file
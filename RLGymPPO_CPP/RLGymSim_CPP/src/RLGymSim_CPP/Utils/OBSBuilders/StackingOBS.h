@@ -0,0 +1,68 @@
+#pragma once
+#include "OBSBuilder.h"
+
+namespace RLGSC {
+	// Wraps another OBS builder, giving each player its last stackSize observations from it, oldest first
+	// Each player's past observations are kept in a fixed ring buffer that the child builder writes into directly
+	// Building only copies the ring out (as two contiguous blocks), so stack depth adds memory but no allocation
+	// The stacks are filled with the first observation of every episode
+	// NOTE: Every build adds an observation to the player's stack, so each player's OBS must be built once per step
+	class StackingOBS : public OBSBuilder {
+	public:
+		OBSBuilder* childBuilder;
+		int stackSize;
+		bool ownsBuilder;
+
+		StackingOBS(OBSBuilder* childBuilder, int stackSize, bool ownsBuilder = true)
+			: childBuilder(childBuilder), stackSize(stackSize), ownsBuilder(ownsBuilder) {
+
+			if (stackSize < 1)
+				RG_ERR_CLOSE("StackingOBS: Stack size must be at least 1, got " << stackSize);
+		}
+
+		~StackingOBS() {
+			if (ownsBuilder)
+				delete childBuilder;
+		}
+
+		virtual void Reset(const GameState& initialState);
+
+		virtual void PreStep(const GameState& state) {
+			childBuilder->PreStep(state);
+		}
+
+		virtual StateFields GetStateFields() {
+			return childBuilder->GetStateFields();
+		}
+
+		virtual int GetOBSSize(const GameState& state) {
+			int childSize = childBuilder->GetOBSSize(state);
+			return childSize < 0 ? -1 : childSize * stackSize;
+		}
+
+		virtual FList GetOBSScales(const GameState& state);
+
+		virtual OBSMirrorMap GetOBSMirrorMap(const GameState& state);
+
+		virtual void BuildOBSInto(std::span<float> out, const PlayerData& player, const GameState& state, const Action& prevAction);
+		virtual FList BuildOBS(const PlayerData& player, const GameState& state, const Action& prevAction);
+
+		struct PlayerStack {
+			uint32_t carId;
+			int frameSize;
+			FList frames; // [stackSize][frameSize]
+			int newest = 0; // Index of the newest frame
+			bool isEmpty = true; // If set, the next frame fills the whole stack
+		};
+		std::vector<PlayerStack> _stacks = {};
+
+		// Finds the stack of this car, or makes one
+		PlayerStack& _GetStack(uint32_t carId, int frameSize);
+
+		// Advances the ring, returns where the new newest frame goes
+		float* _NextFrame(PlayerStack& stack);
+
+		// Writes the stack into out ([stackSize * frameSize]), once the newest frame is written
+		void _WriteStack(PlayerStack& stack, float* out);
+	};
+}
\ No newline at end of file
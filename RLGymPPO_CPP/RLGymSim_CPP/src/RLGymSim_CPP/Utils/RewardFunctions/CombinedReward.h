@@ -33,16 +33,32 @@ namespace RLGSC {
 				func->PreStep(state);
 		}
 
+		virtual StateFields GetStateFields() {
+			StateFields result = StateFields::NONE;
+			for (auto func : rewardFuncs)
+				result |= func->GetStateFields();
+			return result;
+		}
+
 		virtual std::vector<float> GetAllRewards(const GameState& state, const ActionSet& prevAction, bool final) {
 			std::vector<float> allRewards(state.players.size());
+			GetAllRewardsInto(state, prevAction, final, allRewards.data());
+			return allRewards;
+		}
+
+		// Rewards of each function are written here, so they can be combined without allocating
+		std::vector<float> _funcRewards = {};
+
+		virtual void GetAllRewardsInto(const GameState& state, const ActionSet& prevAction, bool final, float* out) {
+			int numPlayers = state.players.size();
+			std::fill(out, out + numPlayers, 0.f);
+			_funcRewards.resize(numPlayers);
 
 			for (int i = 0; i < rewardFuncs.size(); i++) {
-				auto rewards = rewardFuncs[i]->GetAllRewards(state, prevAction, final);
-				for (int j = 0; j < rewards.size(); j++)
-					allRewards[j] += rewards[j] * rewardWeights[i];
+				rewardFuncs[i]->GetAllRewardsInto(state, prevAction, final, _funcRewards.data());
+				for (int j = 0; j < numPlayers; j++)
+					out[j] += _funcRewards[j] * rewardWeights[i];
 			}
-
-			return allRewards;
 		}
 
 		virtual ~CombinedReward() {
@@ -39,4 +39,74 @@ float RLGSC::EventReward::GetReward(const PlayerData& player, const GameState& s
 
 	oldValues = newValues;
 	return reward;
+}
+
+// Batched rewards below are plain loops, each game only passes its own few cars (see RewardFunction::GetAllRewardsInto())
+
+constexpr float MIN_NORMALIZE_LENGTH_SQ = (FLT_EPSILON * FLT_EPSILON) * (FLT_EPSILON * FLT_EPSILON);
+
+// 1 / length where Vec::Normalized() would normalize, otherwise 0
+inline float _InvLengthForNormalize(float lengthSq) {
+	return lengthSq > MIN_NORMALIZE_LENGTH_SQ ? 1 / sqrtf(lengthSq) : 0;
+}
+
+bool RLGSC::VelocityBallToGoalReward::GetRewardsBatched(const StateSoA& state, int carStart, int carEnd, float* out) {
+	using namespace CommonValues;
+
+	const int* carArena = state.carArena.data();
+	const uint8_t* carTeam = state.carTeam.data();
+	const float
+		*bx = state.ballPos.x.data(), *by = state.ballPos.y.data(), *bz = state.ballPos.z.data(),
+		*bvx = state.ballVel.x.data(), *bvy = state.ballVel.y.data(), *bvz = state.ballVel.z.data();
+
+	for (int i = carStart; i < carEnd; i++) {
+		int arena = carArena[i];
+
+		bool targetOrangeGoal = (carTeam[i] == (uint8_t)Team::BLUE) != ownGoal;
+		Vec targetPos = targetOrangeGoal ? ORANGE_GOAL_BACK : BLUE_GOAL_BACK;
+
+		float dx = targetPos.x - bx[arena], dy = targetPos.y - by[arena], dz = targetPos.z - bz[arena];
+		float invLength = _InvLengthForNormalize(dx * dx + dy * dy + dz * dz);
+		out[i - carStart] = (dx * bvx[arena] + dy * bvy[arena] + dz * bvz[arena]) * invLength * (1 / BALL_MAX_SPEED);
+	}
+
+	return true;
+}
+
+bool RLGSC::VelocityPlayerToBallReward::GetRewardsBatched(const StateSoA& state, int carStart, int carEnd, float* out) {
+	using namespace CommonValues;
+
+	const int* carArena = state.carArena.data();
+	const float
+		*px = state.carPos.x.data(), *py = state.carPos.y.data(), *pz = state.carPos.z.data(),
+		*vx = state.carVel.x.data(), *vy = state.carVel.y.data(), *vz = state.carVel.z.data(),
+		*bx = state.ballPos.x.data(), *by = state.ballPos.y.data(), *bz = state.ballPos.z.data();
+
+	for (int i = carStart; i < carEnd; i++) {
+		int arena = carArena[i];
+
+		float dx = bx[arena] - px[i], dy = by[arena] - py[i], dz = bz[arena] - pz[i];
+		float invLength = _InvLengthForNormalize(dx * dx + dy * dy + dz * dz);
+		out[i - carStart] = (dx * vx[i] + dy * vy[i] + dz * vz[i]) * invLength * (1 / CAR_MAX_SPEED);
+	}
+
+	return true;
+}
+
+bool RLGSC::FaceBallReward::GetRewardsBatched(const StateSoA& state, int carStart, int carEnd, float* out) {
+	const int* carArena = state.carArena.data();
+	const float
+		*px = state.carPos.x.data(), *py = state.carPos.y.data(), *pz = state.carPos.z.data(),
+		*fx = state.carForward.x.data(), *fy = state.carForward.y.data(), *fz = state.carForward.z.data(),
+		*bx = state.ballPos.x.data(), *by = state.ballPos.y.data(), *bz = state.ballPos.z.data();
+
+	for (int i = carStart; i < carEnd; i++) {
+		int arena = carArena[i];
+
+		float dx = bx[arena] - px[i], dy = by[arena] - py[i], dz = bz[arena] - pz[i];
+		float invLength = _InvLengthForNormalize(dx * dx + dy * dy + dz * dz);
+		out[i - carStart] = (fx[i] * dx + fy[i] * dy + fz[i] * dz) * invLength;
+	}
+
+	return true;
 }
\ No newline at end of file
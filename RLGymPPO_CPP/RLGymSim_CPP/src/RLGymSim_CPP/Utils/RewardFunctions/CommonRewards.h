@@ -46,6 +46,10 @@ namespace RLGSC {
 
 		virtual void Reset(const GameState& state);
 		virtual float GetReward(const PlayerData& player, const GameState& state, const Action& prevAction);
+
+		virtual StateFields GetStateFields() {
+			return StateFields::PLAYERS | StateFields::CAR_STATES | StateFields::SCORE_LINE;
+		}
 	};
 
 	// https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/reward_functions/common_rewards/misc_rewards.py
@@ -56,6 +60,10 @@ namespace RLGSC {
 		virtual float GetReward(const PlayerData& player, const GameState& state, const Action& prevAction) {
 			return player.phys.vel.Length() / CommonValues::CAR_MAX_SPEED * (1 - 2 * isNegative);
 		}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::PLAYERS;
+		}
 	};
 
 	// https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/reward_functions/common_rewards/misc_rewards.py
@@ -67,6 +75,10 @@ namespace RLGSC {
 		virtual float GetReward(const PlayerData& player, const GameState& state, const Action& prevAction) {
 			return RS_CLAMP(powf(player.boostFraction, exponent), 0, 1);
 		}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::PLAYERS;
+		}
 	};
 
 	// https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/reward_functions/common_rewards/ball_goal_rewards.py
@@ -80,30 +92,46 @@ namespace RLGSC {
 			if (ownGoal)
 				targetOrangeGoal = !targetOrangeGoal;
 
-			Vec targetPos = targetOrangeGoal ? CommonValues::ORANGE_GOAL_BACK : CommonValues::BLUE_GOAL_BACK;
-			
-			Vec ballDirToGoal = (targetPos - state.ball.pos).Normalized();
+			Vec ballDirToGoal = state.GetFeatures().GetBallDirToGoal(targetOrangeGoal ? Team::ORANGE : Team::BLUE, false);
 			return ballDirToGoal.Dot(state.ball.vel / CommonValues::BALL_MAX_SPEED);
 		}
+
+		virtual bool GetRewardsBatched(const StateSoA& state, int carStart, int carEnd, float* out);
+
+		virtual StateFields GetStateFields() {
+			return StateFields::SOA;
+		}
 	};
 
 	// https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/reward_functions/common_rewards/player_ball_rewards.py
 	class VelocityPlayerToBallReward : public RewardFunction {
 	public:
 		virtual float GetReward(const PlayerData& player, const GameState& state, const Action& prevAction) {
-			Vec dirToBall = (state.ball.pos - player.phys.pos).Normalized();
+			Vec dirToBall = state.GetPlayerFeatures(player).dirToBall;
 			Vec normVel = player.phys.vel / CommonValues::CAR_MAX_SPEED;
 			return dirToBall.Dot(normVel);
 		}
+
+		virtual bool GetRewardsBatched(const StateSoA& state, int carStart, int carEnd, float* out);
+
+		virtual StateFields GetStateFields() {
+			return StateFields::SOA;
+		}
 	};
 
 	// https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/reward_functions/common_rewards/player_ball_rewards.py
 	class FaceBallReward : public RewardFunction {
 	public:
 		virtual float GetReward(const PlayerData& player, const GameState& state, const Action& prevAction) {
-			Vec dirToBall = (state.ball.pos - player.phys.pos).Normalized();
+			Vec dirToBall = state.GetPlayerFeatures(player).dirToBall;
 			return player.carState.rotMat.forward.Dot(dirToBall);
 		}
+
+		virtual bool GetRewardsBatched(const StateSoA& state, int carStart, int carEnd, float* out);
+
+		virtual StateFields GetStateFields() {
+			return StateFields::SOA;
+		}
 	};
 
 	// https://github.com/AechPro/rocket-league-gym-sim/blob/main/rlgym_sim/utils/reward_functions/common_rewards/player_ball_rewards.py
@@ -121,5 +149,9 @@ namespace RLGSC {
 				return 0;
 			}
 		}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::BALL | StateFields::PLAYERS;
+		}
 	};
 }
\ No newline at end of file
@@ -10,6 +10,12 @@ namespace RLGSC {
 
 		virtual void PreStep(const GameState& state) {}
 
+		// Fields of the state read by this, only the fields needed by a match are filled each step (see StateFields)
+		// Default implementation needs everything
+		virtual StateFields GetStateFields() {
+			return StateFields::ALL;
+		}
+
 		virtual float GetReward(const PlayerData& player, const GameState& state, const Action& prevAction) {
 			throw std::runtime_error("GetReward() is unimplemented");
 			return 0;
@@ -19,19 +25,59 @@ namespace RLGSC {
 			return GetReward(player, state, prevAction);
 		}
 
+		// Batched version of GetReward(), for cars [carStart, carEnd) of the state at once
+		// Writes the reward of car i to out[i - carStart], return false if there is no batched version
+		// Cars can be from different arenas, so use state.carArena for their ball
+		// NOTE: Not used for final rewards, those always come from GetFinalReward()
+		virtual bool GetRewardsBatched(const StateSoA& state, int carStart, int carEnd, float* out) {
+			return false;
+		}
+
 		// Get all rewards for all players
+		// NOTE: If you override this, don't call RewardFunction::GetAllRewards() from it (see GetAllRewardsInto())
 		virtual std::vector<float> GetAllRewards(const GameState& state, const ActionSet& prevActions, bool final) {
+			_calledDefaultAllRewards = true;
 
 			std::vector<float> rewards = std::vector<float>(state.players.size());
+			_GetPlayerRewardsInto(state, prevActions, final, rewards.data());
+			return rewards;
+		}
+
+		// Writes all rewards for all players into out ([players.size()]), without allocating
+		// Rewards that combine other rewards should override this as well as GetAllRewards()
+		// By default, this figures out on the first call whether GetAllRewards() was overridden, and only uses it if it was
+		virtual void GetAllRewardsInto(const GameState& state, const ActionSet& prevActions, bool final, float* out) {
+			if (_allRewardsOverridden == -1) {
+				_calledDefaultAllRewards = false;
+				auto rewards = GetAllRewards(state, prevActions, final);
+				_allRewardsOverridden = !_calledDefaultAllRewards;
+				std::copy(rewards.begin(), rewards.end(), out);
+			} else if (_allRewardsOverridden) {
+				auto rewards = GetAllRewards(state, prevActions, final);
+				std::copy(rewards.begin(), rewards.end(), out);
+			} else {
+				if (!final && _hasBatchedRewards) {
+					if (GetRewardsBatched(state.GetSoA(), 0, state.players.size(), out))
+						return;
+					_hasBatchedRewards = false;
+				}
+
+				_GetPlayerRewardsInto(state, prevActions, final, out);
+			}
+		}
+
+		int _allRewardsOverridden = -1; // -1 until the first GetAllRewardsInto() call
+		bool _calledDefaultAllRewards = false;
+		bool _hasBatchedRewards = true; // False once GetRewardsBatched() returns false
+
+		void _GetPlayerRewardsInto(const GameState& state, const ActionSet& prevActions, bool final, float* out) {
 			for (int i = 0; i < state.players.size(); i++) {
 				if (final) {
-					rewards[i] = GetFinalReward(state.players[i], state, prevActions[i]);
+					out[i] = GetFinalReward(state.players[i], state, prevActions[i]);
 				} else {
-					rewards[i] = GetReward(state.players[i], state, prevActions[i]);
+					out[i] = GetReward(state.players[i], state, prevActions[i]);
 				}
 			}
-
-			return rewards;
 		}
 
 		virtual ~RewardFunction() {};
@@ -0,0 +1,155 @@
+#pragma once
+#include "RewardFunction.h"
+
+#include <tuple>
+
+namespace RLGSC {
+	// True if R only computes rewards per player, so its GetReward()/GetFinalReward() can be called directly
+	// Rewards that override GetAllRewards() or GetAllRewardsInto(), or hide them, are false
+	template <typename R, typename = void>
+	struct _IsPerPlayerReward : std::false_type {};
+
+	template <typename R>
+	struct _IsPerPlayerReward<R, std::void_t<
+		decltype(&R::GetReward), decltype(&R::GetFinalReward),
+		decltype(&R::GetAllRewards), decltype(&R::GetAllRewardsInto)
+	>> : std::bool_constant<
+		std::is_same_v<decltype(&R::GetAllRewards), decltype(&RewardFunction::GetAllRewards)> &&
+		std::is_same_v<decltype(&R::GetAllRewardsInto), decltype(&RewardFunction::GetAllRewardsInto)>
+	> {};
+
+	// True unless R is known to not override GetRewardsBatched()
+	template <typename R, typename = void>
+	struct _HasBatchedRewards : std::true_type {};
+
+	template <typename R>
+	struct _HasBatchedRewards<R, std::void_t<decltype(&R::GetRewardsBatched)>> : std::bool_constant<
+		!std::is_same_v<decltype(&R::GetRewardsBatched), decltype(&RewardFunction::GetRewardsBatched)>
+	> {};
+
+	// Same as CombinedReward, but with the reward functions as template arguments, so they're known at compile time
+	// Rewards of all functions are computed in one loop over the players, with direct calls the compiler can inline
+	// Functions that have their own batched or all-player rewards are still computed separately, through those
+	// Results are identical to a CombinedReward of the same functions and weights
+	// NOTE: Functions are stored by value, so ones that own other functions through pointers (like ZeroSumReward) can't be combined this way
+	//
+	// Example:
+	//	auto rewards = new StaticCombinedReward(
+	//		{ 0.1f, 0.5f, 1.0f },
+	//		FaceBallReward(), VelocityPlayerToBallReward(), VelocityBallToGoalReward()
+	//	);
+	template <typename... Rs>
+	class StaticCombinedReward : public RewardFunction {
+	public:
+		constexpr static int FUNC_AMOUNT = sizeof...(Rs);
+		static_assert(FUNC_AMOUNT > 0, "StaticCombinedReward needs at least one reward function");
+		static_assert((std::is_base_of_v<RewardFunction, Rs> && ...), "StaticCombinedReward can only combine reward functions");
+
+		std::tuple<Rs...> rewardFuncs;
+		std::array<float, FUNC_AMOUNT> rewardWeights;
+
+		// If true, the unweighted reward of each function, averaged over the players, is written to lastFuncRewards every step
+		// Step callbacks can then add them to metrics (see RLGPC::RewardComponentMetrics)
+		bool recordFuncRewards = false;
+		std::array<float, FUNC_AMOUNT> lastFuncRewards = {};
+
+		StaticCombinedReward(std::array<float, FUNC_AMOUNT> rewardWeights, Rs... rewardFuncs) :
+			rewardFuncs(std::move(rewardFuncs)...), rewardWeights(rewardWeights) {
+		}
+
+		template <int I>
+		auto& GetFunc() {
+			return std::get<I>(rewardFuncs);
+		}
+
+	protected:
+		virtual void Reset(const GameState& initialState) {
+			_ForEachFunc([&](RewardFunction& func) { func.Reset(initialState); });
+		}
+
+		virtual void PreStep(const GameState& state) {
+			_ForEachFunc([&](RewardFunction& func) { func.PreStep(state); });
+		}
+
+		virtual StateFields GetStateFields() {
+			StateFields result = StateFields::NONE;
+			_ForEachFunc([&](RewardFunction& func) { result |= func.GetStateFields(); });
+			return result;
+		}
+
+		virtual std::vector<float> GetAllRewards(const GameState& state, const ActionSet& prevActions, bool final) {
+			std::vector<float> allRewards(state.players.size());
+			GetAllRewardsInto(state, prevActions, final, allRewards.data());
+			return allRewards;
+		}
+
+		virtual void GetAllRewardsInto(const GameState& state, const ActionSet& prevActions, bool final, float* out) {
+			if (final) {
+				recordFuncRewards ? _GetRewardsInto<true, true>(state, prevActions, out) : _GetRewardsInto<true, false>(state, prevActions, out);
+			} else {
+				recordFuncRewards ? _GetRewardsInto<false, true>(state, prevActions, out) : _GetRewardsInto<false, false>(state, prevActions, out);
+			}
+		}
+
+		// Rewards of the functions that aren't computed in the player loop, [FUNC_AMOUNT][players]
+		std::vector<float> _funcRewards[FUNC_AMOUNT] = {};
+
+		template <typename R, bool FINAL>
+		constexpr static bool _IsInPlayerLoop() {
+			// Batched rewards are only used for non-final steps (see RewardFunction::GetAllRewardsInto())
+			return _IsPerPlayerReward<R>::value && (FINAL || !_HasBatchedRewards<R>::value);
+		}
+
+		template <typename Fn>
+		void _ForEachFunc(Fn&& fn) {
+			std::apply([&](auto&... funcs) { (fn(static_cast<RewardFunction&>(funcs)), ...); }, rewardFuncs);
+		}
+
+		template <bool FINAL, bool RECORD>
+		void _GetRewardsInto(const GameState& state, const ActionSet& prevActions, float* out) {
+			int numPlayers = state.players.size();
+
+			[&]<size_t... I>(std::index_sequence<I...>) {
+				// Functions outside the player loop go first, through their own GetAllRewardsInto()
+				([&] {
+					using R = std::tuple_element_t<I, std::tuple<Rs...>>;
+					if constexpr (!_IsInPlayerLoop<R, FINAL>()) {
+						_funcRewards[I].resize(numPlayers);
+						static_cast<RewardFunction&>(std::get<I>(rewardFuncs)).GetAllRewardsInto(state, prevActions, FINAL, _funcRewards[I].data());
+					}
+				}(), ...);
+
+				float funcTotals[FUNC_AMOUNT] = {};
+				for (int i = 0; i < numPlayers; i++) {
+					const PlayerData& player = state.players[i];
+
+					// Summed in the same order as CombinedReward
+					float total = 0;
+					([&] {
+						using R = std::tuple_element_t<I, std::tuple<Rs...>>;
+						R& func = std::get<I>(rewardFuncs);
+
+						float reward;
+						if constexpr (!_IsInPlayerLoop<R, FINAL>()) {
+							reward = _funcRewards[I][i];
+						} else if constexpr (FINAL) {
+							reward = func.R::GetFinalReward(player, state, prevActions[i]);
+						} else {
+							reward = func.R::GetReward(player, state, prevActions[i]);
+						}
+
+						total += reward * rewardWeights[I];
+						if constexpr (RECORD)
+							funcTotals[I] += reward;
+					}(), ...);
+
+					out[i] = total;
+				}
+
+				if constexpr (RECORD)
+					for (int j = 0; j < FUNC_AMOUNT; j++)
+						lastFuncRewards[j] = numPlayers ? funcTotals[j] / numPlayers : 0;
+			}(std::index_sequence_for<Rs...>{});
+		}
+	};
+}
@@ -1,7 +1,13 @@
 #include "ZeroSumReward.h"
 
 std::vector<float> RLGSC::ZeroSumReward::GetAllRewards(const GameState& state, const ActionSet& prevActions, bool final) {
-	std::vector<float> rewards = childFunc->GetAllRewards(state, prevActions, final);
+	std::vector<float> rewards = std::vector<float>(state.players.size());
+	GetAllRewardsInto(state, prevActions, final, rewards.data());
+	return rewards;
+}
+
+void RLGSC::ZeroSumReward::GetAllRewardsInto(const GameState& state, const ActionSet& prevActions, bool final, float* rewards) {
+	childFunc->GetAllRewardsInto(state, prevActions, final, rewards);
 
 	int teamCounts[2] = {};
 	float avgTeamRewards[2] = {};
@@ -25,6 +31,4 @@ std::vector<float> RLGSC::ZeroSumReward::GetAllRewards(const GameState& state, c
 			+ (avgTeamRewards[teamIdx] * teamSpirit)
 			- (avgTeamRewards[1 - teamIdx] * opponentScale);
 	}
-
-	return rewards;
 }
\ No newline at end of file
@@ -33,7 +33,12 @@ namespace RLGSC {
 			childFunc->PreStep(state);
 		}
 
+		virtual StateFields GetStateFields() {
+			return childFunc->GetStateFields();
+		}
+
 		// Get all rewards for all players
 		virtual std::vector<float> GetAllRewards(const GameState& state, const ActionSet& prevActions, bool final);
+		virtual void GetAllRewardsInto(const GameState& state, const ActionSet& prevActions, bool final, float* out);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,279 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+
+// Thin portable SIMD layer of 4- and 8-wide floats and their masks, for our vectorized code (batched rewards, native inference, ...)
+// The backend is chosen at build time from the instruction sets we are compiled for (build with RG_NATIVE_ARCH to get AVX2 or AVX-512):
+//	Float4 is SSE on x86-64, NEON on ARM64, and scalar otherwise
+//	Float8 is one AVX2 register (also with AVX-512), and two Float4s otherwise
+// NOTE: Operations map 1:1 to intrinsics, so results are the same as hand-written intrinsics (MulAdd() is fused if the backend has FMA)
+
+// MSVC has no __FMA__, but allows FMA with /arch:AVX2
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define RG_SIMD_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RG_SIMD_SSE
+#include <immintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define RG_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace RLGSC {
+	namespace SIMD {
+#if defined(RG_SIMD_AVX2)
+		constexpr const char* BACKEND_NAME = "AVX2";
+#elif defined(RG_SIMD_SSE)
+		constexpr const char* BACKEND_NAME = "SSE";
+#elif defined(RG_SIMD_NEON)
+		constexpr const char* BACKEND_NAME = "NEON";
+#else
+		constexpr const char* BACKEND_NAME = "Scalar";
+#endif
+
+		//////////////////////////////////////////////////////////////////////////////////////////////
+
+		// Lanes are all ones (true) or all zeros (false)
+		struct Mask4 {
+#if defined(RG_SIMD_SSE)
+			__m128 m;
+#elif defined(RG_SIMD_NEON)
+			uint32x4_t m;
+#else
+			uint32_t m[4];
+#endif
+		};
+
+		struct Float4 {
+			constexpr static int WIDTH = 4;
+
+#if defined(RG_SIMD_SSE)
+			__m128 v;
+			Float4() = default;
+			Float4(float val) : v(_mm_set1_ps(val)) {}
+			explicit Float4(__m128 v) : v(v) {}
+
+			static Float4 Load(const float* data) { return Float4(_mm_loadu_ps(data)); }
+			void Store(float* data) const { _mm_storeu_ps(data, v); }
+#elif defined(RG_SIMD_NEON)
+			float32x4_t v;
+			Float4() = default;
+			Float4(float val) : v(vdupq_n_f32(val)) {}
+			explicit Float4(float32x4_t v) : v(v) {}
+
+			static Float4 Load(const float* data) { return Float4(vld1q_f32(data)); }
+			void Store(float* data) const { vst1q_f32(data, v); }
+#else
+			float v[4];
+			Float4() = default;
+			Float4(float val) : v{ val, val, val, val } {}
+
+			static Float4 Load(const float* data) { return Float4{ data[0], data[1], data[2], data[3] }; }
+			void Store(float* data) const { for (int i = 0; i < 4; i++) data[i] = v[i]; }
+
+			Float4(float a, float b, float c, float d) : v{ a, b, c, d } {}
+#endif
+
+			// base[indices[i]] for each lane
+			static Float4 Gather(const float* base, const int32_t* indices) {
+				float vals[4] = { base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]] };
+				return Load(vals);
+			}
+
+			// Each byte converted to a float
+			static Float4 FromBytes(const uint8_t* bytes) {
+				float vals[4] = { (float)bytes[0], (float)bytes[1], (float)bytes[2], (float)bytes[3] };
+				return Load(vals);
+			}
+		};
+
+#if defined(RG_SIMD_SSE)
+		inline Float4 operator+(Float4 a, Float4 b) { return Float4(_mm_add_ps(a.v, b.v)); }
+		inline Float4 operator-(Float4 a, Float4 b) { return Float4(_mm_sub_ps(a.v, b.v)); }
+		inline Float4 operator*(Float4 a, Float4 b) { return Float4(_mm_mul_ps(a.v, b.v)); }
+		inline Float4 operator/(Float4 a, Float4 b) { return Float4(_mm_div_ps(a.v, b.v)); }
+		inline Float4 Min(Float4 a, Float4 b) { return Float4(_mm_min_ps(a.v, b.v)); }
+		inline Float4 Max(Float4 a, Float4 b) { return Float4(_mm_max_ps(a.v, b.v)); }
+		inline Float4 Sqrt(Float4 a) { return Float4(_mm_sqrt_ps(a.v)); }
+#if defined(RG_SIMD_AVX2)
+		inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return Float4(_mm_fmadd_ps(a.v, b.v, c.v)); }
+#else
+		inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return a * b + c; }
+#endif
+
+		inline Mask4 operator>(Float4 a, Float4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+		inline Mask4 operator<(Float4 a, Float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+		inline Mask4 operator==(Float4 a, Float4 b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+		inline Mask4 operator&(Mask4 a, Mask4 b) { return { _mm_and_ps(a.m, b.m) }; }
+		inline Mask4 operator|(Mask4 a, Mask4 b) { return { _mm_or_ps(a.m, b.m) }; }
+		inline Mask4 operator^(Mask4 a, Mask4 b) { return { _mm_xor_ps(a.m, b.m) }; }
+
+		// ifTrue where the mask is set, otherwise ifFalse
+		inline Float4 Select(Mask4 mask, Float4 ifTrue, Float4 ifFalse) {
+			return Float4(_mm_or_ps(_mm_and_ps(mask.m, ifTrue.v), _mm_andnot_ps(mask.m, ifFalse.v)));
+		}
+		// a where the mask is set, otherwise 0
+		inline Float4 SelectOrZero(Mask4 mask, Float4 a) { return Float4(_mm_and_ps(mask.m, a.v)); }
+
+		inline float ReduceAdd(Float4 a) {
+			__m128 sum = _mm_add_ps(a.v, _mm_movehl_ps(a.v, a.v));
+			return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+		}
+		inline float ReduceMax(Float4 a) {
+			__m128 max = _mm_max_ps(a.v, _mm_movehl_ps(a.v, a.v));
+			return _mm_cvtss_f32(_mm_max_ss(max, _mm_shuffle_ps(max, max, 1)));
+		}
+#elif defined(RG_SIMD_NEON)
+		inline Float4 operator+(Float4 a, Float4 b) { return Float4(vaddq_f32(a.v, b.v)); }
+		inline Float4 operator-(Float4 a, Float4 b) { return Float4(vsubq_f32(a.v, b.v)); }
+		inline Float4 operator*(Float4 a, Float4 b) { return Float4(vmulq_f32(a.v, b.v)); }
+		inline Float4 operator/(Float4 a, Float4 b) { return Float4(vdivq_f32(a.v, b.v)); }
+		inline Float4 Min(Float4 a, Float4 b) { return Float4(vminq_f32(a.v, b.v)); }
+		inline Float4 Max(Float4 a, Float4 b) { return Float4(vmaxq_f32(a.v, b.v)); }
+		inline Float4 Sqrt(Float4 a) { return Float4(vsqrtq_f32(a.v)); }
+		inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return Float4(vfmaq_f32(c.v, a.v, b.v)); }
+
+		inline Mask4 operator>(Float4 a, Float4 b) { return { vcgtq_f32(a.v, b.v) }; }
+		inline Mask4 operator<(Float4 a, Float4 b) { return { vcltq_f32(a.v, b.v) }; }
+		inline Mask4 operator==(Float4 a, Float4 b) { return { vceqq_f32(a.v, b.v) }; }
+		inline Mask4 operator&(Mask4 a, Mask4 b) { return { vandq_u32(a.m, b.m) }; }
+		inline Mask4 operator|(Mask4 a, Mask4 b) { return { vorrq_u32(a.m, b.m) }; }
+		inline Mask4 operator^(Mask4 a, Mask4 b) { return { veorq_u32(a.m, b.m) }; }
+
+		inline Float4 Select(Mask4 mask, Float4 ifTrue, Float4 ifFalse) { return Float4(vbslq_f32(mask.m, ifTrue.v, ifFalse.v)); }
+		inline Float4 SelectOrZero(Mask4 mask, Float4 a) { return Float4(vreinterpretq_f32_u32(vandq_u32(mask.m, vreinterpretq_u32_f32(a.v)))); }
+
+		inline float ReduceAdd(Float4 a) { return vaddvq_f32(a.v); }
+		inline float ReduceMax(Float4 a) { return vmaxvq_f32(a.v); }
+#else
+		// Applies an expression to each lane
+#define RG_SIMD_LANES(expr) Float4{ [&](int i) { return (expr); }(0), [&](int i) { return (expr); }(1), [&](int i) { return (expr); }(2), [&](int i) { return (expr); }(3) }
+#define RG_SIMD_MASK_LANES(expr) Mask4{ { [&](int i) { return (expr) ? ~0u : 0u; }(0), [&](int i) { return (expr) ? ~0u : 0u; }(1), [&](int i) { return (expr) ? ~0u : 0u; }(2), [&](int i) { return (expr) ? ~0u : 0u; }(3) } }
+		inline Float4 operator+(Float4 a, Float4 b) { return RG_SIMD_LANES(a.v[i] + b.v[i]); }
+		inline Float4 operator-(Float4 a, Float4 b) { return RG_SIMD_LANES(a.v[i] - b.v[i]); }
+		inline Float4 operator*(Float4 a, Float4 b) { return RG_SIMD_LANES(a.v[i] * b.v[i]); }
+		inline Float4 operator/(Float4 a, Float4 b) { return RG_SIMD_LANES(a.v[i] / b.v[i]); }
+		inline Float4 Min(Float4 a, Float4 b) { return RG_SIMD_LANES(b.v[i] < a.v[i] ? b.v[i] : a.v[i]); }
+		inline Float4 Max(Float4 a, Float4 b) { return RG_SIMD_LANES(b.v[i] > a.v[i] ? b.v[i] : a.v[i]); }
+		inline Float4 Sqrt(Float4 a) { return RG_SIMD_LANES(sqrtf(a.v[i])); }
+		inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return a * b + c; }
+
+		inline Mask4 operator>(Float4 a, Float4 b) { return RG_SIMD_MASK_LANES(a.v[i] > b.v[i]); }
+		inline Mask4 operator<(Float4 a, Float4 b) { return RG_SIMD_MASK_LANES(a.v[i] < b.v[i]); }
+		inline Mask4 operator==(Float4 a, Float4 b) { return RG_SIMD_MASK_LANES(a.v[i] == b.v[i]); }
+		inline Mask4 operator&(Mask4 a, Mask4 b) { return RG_SIMD_MASK_LANES(a.m[i] & b.m[i]); }
+		inline Mask4 operator|(Mask4 a, Mask4 b) { return RG_SIMD_MASK_LANES(a.m[i] | b.m[i]); }
+		inline Mask4 operator^(Mask4 a, Mask4 b) { return RG_SIMD_MASK_LANES(a.m[i] ^ b.m[i]); }
+
+		inline Float4 Select(Mask4 mask, Float4 ifTrue, Float4 ifFalse) { return RG_SIMD_LANES(mask.m[i] ? ifTrue.v[i] : ifFalse.v[i]); }
+		inline Float4 SelectOrZero(Mask4 mask, Float4 a) { return RG_SIMD_LANES(mask.m[i] ? a.v[i] : 0.f); }
+
+		inline float ReduceAdd(Float4 a) { return (a.v[0] + a.v[2]) + (a.v[1] + a.v[3]); }
+		inline float ReduceMax(Float4 a) {
+			float max01 = a.v[1] > a.v[0] ? a.v[1] : a.v[0], max23 = a.v[3] > a.v[2] ? a.v[3] : a.v[2];
+			return max23 > max01 ? max23 : max01;
+		}
+#undef RG_SIMD_LANES
+#undef RG_SIMD_MASK_LANES
+#endif
+
+		//////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(RG_SIMD_AVX2)
+		struct Mask8 {
+			__m256 m;
+		};
+
+		struct Float8 {
+			constexpr static int WIDTH = 8;
+
+			__m256 v;
+			Float8() = default;
+			Float8(float val) : v(_mm256_set1_ps(val)) {}
+			explicit Float8(__m256 v) : v(v) {}
+
+			static Float8 Load(const float* data) { return Float8(_mm256_loadu_ps(data)); }
+			void Store(float* data) const { _mm256_storeu_ps(data, v); }
+
+			static Float8 Gather(const float* base, const int32_t* indices) {
+				return Float8(_mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i*)indices), sizeof(float)));
+			}
+
+			static Float8 FromBytes(const uint8_t* bytes) {
+				return Float8(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)bytes))));
+			}
+		};
+
+		inline Float8 operator+(Float8 a, Float8 b) { return Float8(_mm256_add_ps(a.v, b.v)); }
+		inline Float8 operator-(Float8 a, Float8 b) { return Float8(_mm256_sub_ps(a.v, b.v)); }
+		inline Float8 operator*(Float8 a, Float8 b) { return Float8(_mm256_mul_ps(a.v, b.v)); }
+		inline Float8 operator/(Float8 a, Float8 b) { return Float8(_mm256_div_ps(a.v, b.v)); }
+		inline Float8 Min(Float8 a, Float8 b) { return Float8(_mm256_min_ps(a.v, b.v)); }
+		inline Float8 Max(Float8 a, Float8 b) { return Float8(_mm256_max_ps(a.v, b.v)); }
+		inline Float8 Sqrt(Float8 a) { return Float8(_mm256_sqrt_ps(a.v)); }
+		inline Float8 MulAdd(Float8 a, Float8 b, Float8 c) { return Float8(_mm256_fmadd_ps(a.v, b.v, c.v)); }
+
+		inline Mask8 operator>(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+		inline Mask8 operator<(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+		inline Mask8 operator==(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+		inline Mask8 operator&(Mask8 a, Mask8 b) { return { _mm256_and_ps(a.m, b.m) }; }
+		inline Mask8 operator|(Mask8 a, Mask8 b) { return { _mm256_or_ps(a.m, b.m) }; }
+		inline Mask8 operator^(Mask8 a, Mask8 b) { return { _mm256_xor_ps(a.m, b.m) }; }
+
+		inline Float8 Select(Mask8 mask, Float8 ifTrue, Float8 ifFalse) { return Float8(_mm256_blendv_ps(ifFalse.v, ifTrue.v, mask.m)); }
+		inline Float8 SelectOrZero(Mask8 mask, Float8 a) { return Float8(_mm256_and_ps(mask.m, a.v)); }
+
+		inline float ReduceAdd(Float8 a) { return ReduceAdd(Float4(_mm_add_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1)))); }
+		inline float ReduceMax(Float8 a) { return ReduceMax(Float4(_mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1)))); }
+#else
+		// Two of each 4-wide type
+		struct Mask8 {
+			Mask4 lo, hi;
+		};
+
+		struct Float8 {
+			constexpr static int WIDTH = 8;
+
+			Float4 lo, hi;
+			Float8() = default;
+			Float8(float val) : lo(val), hi(val) {}
+			Float8(Float4 lo, Float4 hi) : lo(lo), hi(hi) {}
+
+			static Float8 Load(const float* data) { return { Float4::Load(data), Float4::Load(data + 4) }; }
+			void Store(float* data) const { lo.Store(data); hi.Store(data + 4); }
+
+			static Float8 Gather(const float* base, const int32_t* indices) {
+				return { Float4::Gather(base, indices), Float4::Gather(base, indices + 4) };
+			}
+
+			static Float8 FromBytes(const uint8_t* bytes) {
+				return { Float4::FromBytes(bytes), Float4::FromBytes(bytes + 4) };
+			}
+		};
+
+		inline Float8 operator+(Float8 a, Float8 b) { return { a.lo + b.lo, a.hi + b.hi }; }
+		inline Float8 operator-(Float8 a, Float8 b) { return { a.lo - b.lo, a.hi - b.hi }; }
+		inline Float8 operator*(Float8 a, Float8 b) { return { a.lo * b.lo, a.hi * b.hi }; }
+		inline Float8 operator/(Float8 a, Float8 b) { return { a.lo / b.lo, a.hi / b.hi }; }
+		inline Float8 Min(Float8 a, Float8 b) { return { Min(a.lo, b.lo), Min(a.hi, b.hi) }; }
+		inline Float8 Max(Float8 a, Float8 b) { return { Max(a.lo, b.lo), Max(a.hi, b.hi) }; }
+		inline Float8 Sqrt(Float8 a) { return { Sqrt(a.lo), Sqrt(a.hi) }; }
+		inline Float8 MulAdd(Float8 a, Float8 b, Float8 c) { return { MulAdd(a.lo, b.lo, c.lo), MulAdd(a.hi, b.hi, c.hi) }; }
+
+		inline Mask8 operator>(Float8 a, Float8 b) { return { a.lo > b.lo, a.hi > b.hi }; }
+		inline Mask8 operator<(Float8 a, Float8 b) { return { a.lo < b.lo, a.hi < b.hi }; }
+		inline Mask8 operator==(Float8 a, Float8 b) { return { a.lo == b.lo, a.hi == b.hi }; }
+		inline Mask8 operator&(Mask8 a, Mask8 b) { return { a.lo & b.lo, a.hi & b.hi }; }
+		inline Mask8 operator|(Mask8 a, Mask8 b) { return { a.lo | b.lo, a.hi | b.hi }; }
+		inline Mask8 operator^(Mask8 a, Mask8 b) { return { a.lo ^ b.lo, a.hi ^ b.hi }; }
+
+		inline Float8 Select(Mask8 mask, Float8 ifTrue, Float8 ifFalse) { return { Select(mask.lo, ifTrue.lo, ifFalse.lo), Select(mask.hi, ifTrue.hi, ifFalse.hi) }; }
+		inline Float8 SelectOrZero(Mask8 mask, Float8 a) { return { SelectOrZero(mask.lo, a.lo), SelectOrZero(mask.hi, a.hi) }; }
+
+		inline float ReduceAdd(Float8 a) { return ReduceAdd(a.lo + a.hi); }
+		inline float ReduceMax(Float8 a) { return ReduceMax(Max(a.lo, a.hi)); }
+#endif
+	}
+}
@@ -0,0 +1,62 @@
+#include "CommonControllers.h"
+#include "../CommonValues.h"
+
+using namespace RLGSC;
+
+// Controls that drive a car towards a target on the ground
+// Boosts only if allowed and the target is roughly ahead, and powerslides into sharp turns
+CarControls _DriveTo(const PlayerData& player, Vec target, bool allowBoost) {
+	const PhysObj& phys = player.phys;
+	Vec dir = target - phys.pos;
+
+	// Angle of the target from our forward direction, positive to our right
+	float angle = atan2f(dir.Dot(phys.rotMat.right), dir.Dot(phys.rotMat.forward));
+
+	CarControls controls = {};
+	controls.throttle = 1;
+	controls.steer = RS_CLAMP(angle * 3, -1, 1);
+	controls.handbrake = fabsf(angle) > 1.8f;
+	controls.boost = allowBoost && fabsf(angle) < 0.3f && player.boostFraction > 0;
+	return controls;
+}
+
+void IdleController::GetControls(const GameState& state, std::span<const int> playerIndices, CarControls* out) {
+	for (int i = 0; i < playerIndices.size(); i++)
+		out[i] = {};
+}
+
+void BallChaseController::GetControls(const GameState& state, std::span<const int> playerIndices, CarControls* out) {
+	for (int i = 0; i < playerIndices.size(); i++)
+		out[i] = _DriveTo(state.players[playerIndices[i]], state.ball.pos, useBoost);
+}
+
+void GoalieController::GetControls(const GameState& state, std::span<const int> playerIndices, CarControls* out) {
+	using namespace CommonValues;
+
+	for (int i = 0; i < playerIndices.size(); i++) {
+		const PlayerData& player = state.players[playerIndices[i]];
+		Vec goal = (player.team == Team::BLUE) ? BLUE_GOAL_CENTER : ORANGE_GOAL_CENTER;
+		goal.z = 0;
+
+		Vec toBall = state.ball.pos - goal;
+		toBall.z = 0;
+		float ballDist = toBall.Length();
+
+		if (ballDist < challengeDist) {
+			out[i] = _DriveTo(player, state.ball.pos, true);
+			continue;
+		}
+
+		Vec guardPos = goal + toBall * (guardDist / ballDist);
+		float guardDistLeft = (guardPos - player.phys.pos).Length2D();
+		if (guardDistLeft < 150) {
+			// Wait in place
+			out[i] = {};
+		} else {
+			out[i] = _DriveTo(player, guardPos, guardDistLeft > 2000);
+			// Slow down as we arrive
+			if (guardDistLeft < 600)
+				out[i].throttle = guardDistLeft / 600;
+		}
+	}
+}
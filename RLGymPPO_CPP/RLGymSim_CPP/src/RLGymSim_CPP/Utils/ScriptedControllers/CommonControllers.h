@@ -0,0 +1,43 @@
+#pragma once
+#include "ScriptedController.h"
+
+namespace RLGSC {
+	// Doesn't press anything
+	class IdleController : public ScriptedController {
+	public:
+		virtual StateFields GetStateFields() {
+			return StateFields::NONE;
+		}
+
+		virtual void GetControls(const GameState& state, std::span<const int> playerIndices, CarControls* out);
+	};
+
+	// Drives straight at the ball
+	class BallChaseController : public ScriptedController {
+	public:
+		bool useBoost;
+		BallChaseController(bool useBoost = true) : useBoost(useBoost) {}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::BALL | StateFields::PLAYERS;
+		}
+
+		virtual void GetControls(const GameState& state, std::span<const int> playerIndices, CarControls* out);
+	};
+
+	// Guards its own goal, staying between the ball and the goal, and only challenges once the ball comes close
+	class GoalieController : public ScriptedController {
+	public:
+		float guardDist, challengeDist;
+
+		// guardDist: How far out from the goal we wait, towards the ball
+		// challengeDist: We drive at the ball once it is this close to our goal
+		GoalieController(float guardDist = 800, float challengeDist = 2500) : guardDist(guardDist), challengeDist(challengeDist) {}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::BALL | StateFields::PLAYERS;
+		}
+
+		virtual void GetControls(const GameState& state, std::span<const int> playerIndices, CarControls* out);
+	};
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "../Gamestates/GameState.h"
+
+namespace RLGSC {
+	// Controls some cars of a match in C++ instead of the policy (see Match::SetScripted())
+	// Scripted cars are still in every state, so the other players' observations and rewards see them,
+	//	but they have no observation, action or reward of their own, so they cost nothing to infer or learn from
+	class ScriptedController {
+	public:
+		virtual void Reset(const GameState& initialState) {}
+
+		// Fields of the state read by this, only the fields needed by a match are filled each step (see StateFields)
+		// Default implementation needs everything
+		virtual StateFields GetStateFields() {
+			return StateFields::ALL;
+		}
+
+		// Writes the controls of each car into out ([playerIndices.size()]), from the state before each step
+		// playerIndices are indices into state.players, every car of a match that we control comes in the same call
+		virtual void GetControls(const GameState& state, std::span<const int> playerIndices, CarControls* out) = 0;
+
+		virtual ~ScriptedController() {}
+	};
+}
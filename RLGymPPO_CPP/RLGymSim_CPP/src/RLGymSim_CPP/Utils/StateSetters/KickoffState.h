@@ -8,5 +8,11 @@ namespace RLGSC {
 			arena->ResetToRandomKickoff();
 			return GameState(arena);
 		}
+
+		virtual GameState ResetState(Arena* arena, Math::RandEngine& randEngine) {
+			// Non-negative, -1 would use RocketSim's own random engine
+			arena->ResetToRandomKickoff(Math::RandInt(0, INT_MAX, randEngine));
+			return GameState(arena);
+		}
 	};
 }
\ No newline at end of file
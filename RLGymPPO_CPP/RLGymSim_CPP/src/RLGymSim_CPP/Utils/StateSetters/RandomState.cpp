@@ -1,11 +1,11 @@
 #include "RandomState.h"
 #include "../../Math.h"
 
-Vec RandNormVec() {
-	return RLGSC::Math::RandVec(Vec(-1, -1, -1), Vec(1, 1, 1)).Normalized();
+Vec RandNormVec(RLGSC::Math::RandEngine& randEngine) {
+	return RLGSC::Math::RandVec(Vec(-1, -1, -1), Vec(1, 1, 1), randEngine).Normalized();
 }
 
-RLGSC::GameState RLGSC::RandomState::ResetState(Arena* arena) {
+RLGSC::GameState RLGSC::RandomState::ResetState(Arena* arena, Math::RandEngine& randEngine) {
 	
 	constexpr float
 		X_MAX = 3500,
@@ -19,28 +19,31 @@ RLGSC::GameState RLGSC::RandomState::ResetState(Arena* arena) {
 
 	{ // Randomize ball
 		BallState bs = {};
-		bs.pos = Math::RandVec(Vec(-X_MAX, -Y_MAX, CommonValues::BALL_RADIUS), Vec(X_MAX, Y_MAX, Z_MAX));
+		bs.pos = Math::RandVec(Vec(-X_MAX, -Y_MAX, CommonValues::BALL_RADIUS), Vec(X_MAX, Y_MAX, Z_MAX), randEngine);
 		if (randBallSpeed) {
-			bs.vel = RandNormVec() * ::Math::RandFloat(0, 4000);
-			bs.angVel = Math::RandVec(Vec(-4, -4, -4), Vec(4, 4, 4));
+			bs.vel = RandNormVec(randEngine) * Math::RandFloat(0, 4000, randEngine);
+			bs.angVel = Math::RandVec(Vec(-4, -4, -4), Vec(4, 4, 4), randEngine);
 		}
 		arena->ball->SetState(bs);
 	}
 
 	for (Car* car : arena->_cars) { // Randomize cars
 		CarState cs = {};
-		cs.pos = Math::RandVec(Vec(-X_MAX, -Y_MAX, CAR_Z_MIN), Vec(X_MAX, Y_MAX, Z_MAX));
+		cs.pos = Math::RandVec(Vec(-X_MAX, -Y_MAX, CAR_Z_MIN), Vec(X_MAX, Y_MAX, Z_MAX), randEngine);
 
 		if (randCarSpeed) {
 			// Might go outside of max vel but I do not care
-			Vec randVelDir = Math::RandVec(Vec(-1, -1, -1), Vec(1, 1, 1)).Normalized();
-			cs.vel = RandNormVec() * ::Math::RandFloat(0, RLConst::CAR_MAX_SPEED);
-			cs.angVel = RandNormVec() * ANGVEL_MAX;
+			Vec randVelDir = Math::RandVec(Vec(-1, -1, -1), Vec(1, 1, 1), randEngine).Normalized();
+			cs.vel = RandNormVec(randEngine) * Math::RandFloat(0, RLConst::CAR_MAX_SPEED, randEngine);
+			cs.angVel = RandNormVec(randEngine) * ANGVEL_MAX;
 		}
 
-		Angle angle = Angle(::Math::RandFloat(-YAW_MAX, YAW_MAX), ::Math::RandFloat(-PITCH_MAX, PITCH_MAX), ::Math::RandFloat(-ROLL_MAX, ROLL_MAX));
+		Angle angle;
+		angle.yaw = Math::RandFloat(-YAW_MAX, YAW_MAX, randEngine);
+		angle.pitch = Math::RandFloat(-PITCH_MAX, PITCH_MAX, randEngine);
+		angle.roll = Math::RandFloat(-ROLL_MAX, ROLL_MAX, randEngine);
 
-		bool onGround = carsOnGround ? true : (::Math::RandFloat() > 0.5);
+		bool onGround = carsOnGround ? true : (Math::RandFloat(0, 1, randEngine) > 0.5);
 		if (onGround) {
 			cs.pos.z = 17;
 			angle.pitch = angle.roll = 0;
@@ -11,6 +11,9 @@ namespace RLGSC {
 			randBallSpeed(randBallSpeed), randCarSpeed(randCarSpeed), carsOnGround(carsOnGround) {
 		}
 
-		virtual GameState ResetState(Arena* arena);
+		virtual GameState ResetState(Arena* arena) {
+			return ResetState(arena, Math::GetRandEngine());
+		}
+		virtual GameState ResetState(Arena* arena, Math::RandEngine& randEngine);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "ReplayStateSetter.h"
+#include <mutex>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace RLGSC;
+
+// Followed by the team of each car, then the records
+struct _FileHeader {
+	uint32_t magic, version;
+	uint32_t carAmount, padAmount;
+	uint64_t recordSize, recordAmount;
+
+	// Records are raw structs, so they can only be read by builds with the same layouts
+	uint32_t ballStateSize, carStateSize;
+};
+
+uint64_t _AlignUp(uint64_t val, uint64_t alignment) {
+	return (val + alignment - 1) / alignment * alignment;
+}
+
+uint64_t _GetRecordSize(uint32_t carAmount, uint32_t padAmount) {
+	return _AlignUp(
+		sizeof(ReplayStateFile::RecordHeader) + carAmount * sizeof(CarState) + padAmount * sizeof(ReplayStateFile::PadRecord),
+		ReplayStateFile::RECORD_ALIGNMENT
+	);
+}
+
+uint64_t _GetRecordsOffset(uint32_t carAmount) {
+	return _AlignUp(sizeof(_FileHeader) + carAmount, ReplayStateFile::RECORD_ALIGNMENT);
+}
+
+RLGSC::ReplayStateFile::ReplayStateFile(std::filesystem::path path) : path(path) {
+	constexpr const char* ERROR_PREFIX = "ReplayStateFile: ";
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		RG_ERR_CLOSE(ERROR_PREFIX << "Failed to open " << path);
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	_mapSize = fileSize.QuadPart;
+
+	if (_mapSize > 0) {
+		_mapHandle = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (_mapHandle)
+			_mapData = (const uint8_t*)MapViewOfFile(_mapHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+	CloseHandle(file);
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file == -1)
+		RG_ERR_CLOSE(ERROR_PREFIX << "Failed to open " << path);
+
+	struct stat fileStat;
+	fstat(file, &fileStat);
+	_mapSize = fileStat.st_size;
+
+	if (_mapSize > 0) {
+		void* map = mmap(NULL, _mapSize, PROT_READ, MAP_PRIVATE, file, 0);
+		if (map != MAP_FAILED)
+			_mapData = (const uint8_t*)map;
+	}
+	close(file); // The mapping stays valid
+#endif
+
+	if (!_mapData)
+		RG_ERR_CLOSE(ERROR_PREFIX << "Failed to map " << path << " (" << _mapSize << " bytes)");
+
+	_FileHeader header;
+	if (_mapSize < sizeof(header))
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is too small to be a replay state file");
+	memcpy(&header, _mapData, sizeof(header));
+
+	if (header.magic != MAGIC)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is not a replay state file");
+	if (header.version != VERSION)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " has unsupported version " << header.version);
+	if (header.ballStateSize != sizeof(BallState) || header.carStateSize != sizeof(CarState))
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " was written by a build with different state layouts");
+	if (header.recordSize != _GetRecordSize(header.carAmount, header.padAmount))
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " has a corrupt header");
+
+	carAmount = header.carAmount;
+	padAmount = header.padAmount;
+	recordSize = header.recordSize;
+	recordAmount = header.recordAmount;
+	_recordsOffset = _GetRecordsOffset(carAmount);
+
+	if (_recordsOffset + recordAmount * recordSize > _mapSize)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is truncated");
+
+	for (uint32_t i = 0; i < carAmount; i++)
+		carTeams.push_back((Team)_mapData[sizeof(header) + i]);
+}
+
+std::shared_ptr<const ReplayStateFile> RLGSC::ReplayStateFile::Load(std::filesystem::path path) {
+	static std::mutex cacheMutex = {};
+	static std::unordered_map<std::wstring, std::weak_ptr<const ReplayStateFile>> cache = {};
+
+	std::wstring key = std::filesystem::absolute(path).lexically_normal().wstring();
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	auto file = cache[key].lock();
+	if (!file) {
+		file = std::make_shared<const ReplayStateFile>(path);
+		cache[key] = file;
+	}
+	return file;
+}
+
+void RLGSC::ReplayStateFile::CheckArena(Arena* arena) const {
+	if (arena->_cars.size() != carAmount)
+		RG_ERR_CLOSE("ReplayStateFile: " << path << " has " << carAmount << " cars, but arena has " << arena->_cars.size());
+	if (arena->_boostPads.size() != padAmount)
+		RG_ERR_CLOSE("ReplayStateFile: " << path << " has " << padAmount << " boost pads, but arena has " << arena->_boostPads.size());
+
+	for (int i = 0; i < carAmount; i++)
+		if (arena->_cars[i]->team != carTeams[i])
+			RG_ERR_CLOSE("ReplayStateFile: Car " << i << " of " << path << " is on a different team than in the arena");
+}
+
+void RLGSC::ReplayStateFile::Apply(uint64_t index, Arena* arena) const {
+	RG_ASSERT(index < recordAmount);
+	CheckArena(arena);
+
+	const RecordHeader* record = GetRecord(index);
+	const CarState* carStates = GetCarStates(record);
+	const PadRecord* pads = GetPads(record);
+
+	// Same as Arena::RestoreSnapshot()
+	uint64_t tickOffset = arena->tickCount - record->tickCount;
+	auto fnShiftTick = [&](uint64_t& tick) {
+		if (tick != ~0ULL)
+			tick += tickOffset;
+	};
+
+	for (int i = 0; i < carAmount; i++) {
+		Car* car = arena->_cars[i];
+		CarState state = carStates[i];
+		fnShiftTick(state.ballHitInfo.tickCountWhenHit);
+		fnShiftTick(state.ballHitInfo.tickCountWhenExtraImpulseApplied);
+		car->SetState(state);
+		car->controls = CarControls();
+	}
+
+	arena->ball->SetState(record->ballState);
+
+	for (auto& touches : arena->_teamBallTouches)
+		touches.isValid = false;
+
+	for (int i = 0; i < padAmount; i++) {
+		BoostPadState padState = {};
+		padState.isActive = pads[i].isActive;
+		padState.cooldown = pads[i].cooldown;
+		arena->_boostPads[i]->SetState(padState);
+	}
+}
+
+RLGSC::ReplayStateFile::~ReplayStateFile() {
+#ifdef _WIN32
+	if (_mapData)
+		UnmapViewOfFile(_mapData);
+	if (_mapHandle)
+		CloseHandle(_mapHandle);
+#else
+	if (_mapData)
+		munmap((void*)_mapData, _mapSize);
+#endif
+}
+
+RLGSC::ReplayStateWriter::ReplayStateWriter(std::filesystem::path path) : path(path) {
+	_tempPath = path;
+	_tempPath += ".tmp";
+	_out = std::ofstream(_tempPath, std::ios::binary);
+	if (!_out.good())
+		RG_ERR_CLOSE("ReplayStateWriter: Failed to open " << _tempPath);
+}
+
+void RLGSC::ReplayStateWriter::Add(Arena* arena) {
+	constexpr const char* ERROR_PREFIX = "ReplayStateWriter::Add(): ";
+
+	if (!_out.is_open())
+		RG_ERR_CLOSE(ERROR_PREFIX << "Writer for " << path << " is already closed");
+
+	if (recordAmount == 0) {
+		// First arena decides the layout, the header is written again with the record amount by Close()
+		_carAmount = arena->_cars.size();
+		_padAmount = arena->_boostPads.size();
+		_recordSize = _GetRecordSize(_carAmount, _padAmount);
+		_recordBuffer.resize(_recordSize);
+
+		_carTeams.clear();
+		for (Car* car : arena->_cars)
+			_carTeams.push_back(car->team);
+
+		_FileHeader header = { ReplayStateFile::MAGIC, ReplayStateFile::VERSION, _carAmount, _padAmount, _recordSize, 0, sizeof(BallState), sizeof(CarState) };
+		_out.write((const char*)&header, sizeof(header));
+		for (Team team : _carTeams)
+			_out.put((char)team);
+		const char zeros[ReplayStateFile::RECORD_ALIGNMENT] = {};
+		_out.write(zeros, _GetRecordsOffset(_carAmount) - (sizeof(header) + _carAmount));
+	} else {
+		if (arena->_cars.size() != _carAmount || arena->_boostPads.size() != _padAmount)
+			RG_ERR_CLOSE(ERROR_PREFIX << "Arena has different cars or boost pads than the first one added");
+		for (int i = 0; i < _carAmount; i++)
+			if (arena->_cars[i]->team != _carTeams[i])
+				RG_ERR_CLOSE(ERROR_PREFIX << "Car " << i << " is on a different team than in the first arena added");
+	}
+
+	memset(_recordBuffer.data(), 0, _recordSize);
+	byte* data = _recordBuffer.data();
+
+	ReplayStateFile::RecordHeader recordHeader = {};
+	recordHeader.tickCount = arena->tickCount;
+	recordHeader.ballState = arena->ball->GetState();
+	memcpy(data, &recordHeader, sizeof(recordHeader));
+	data += sizeof(recordHeader);
+
+	for (Car* car : arena->_cars) {
+		CarState state = car->GetState();
+		memcpy(data, &state, sizeof(state));
+		data += sizeof(state);
+	}
+
+	for (BoostPad* pad : arena->_boostPads) {
+		BoostPadState padState = pad->GetState();
+		ReplayStateFile::PadRecord padRecord = {};
+		padRecord.cooldown = padState.cooldown;
+		padRecord.isActive = padState.isActive;
+		memcpy(data, &padRecord, sizeof(padRecord));
+		data += sizeof(padRecord);
+	}
+
+	_out.write((const char*)_recordBuffer.data(), _recordSize);
+	recordAmount++;
+}
+
+void RLGSC::ReplayStateWriter::Close() {
+	if (!_out.is_open())
+		return;
+
+	if (recordAmount == 0) {
+		// Still write a valid (empty) file
+		_FileHeader header = { ReplayStateFile::MAGIC, ReplayStateFile::VERSION, 0, 0, _GetRecordSize(0, 0), 0, sizeof(BallState), sizeof(CarState) };
+		_out.write((const char*)&header, sizeof(header));
+		const char zeros[ReplayStateFile::RECORD_ALIGNMENT] = {};
+		_out.write(zeros, _GetRecordsOffset(0) - sizeof(header));
+	} else {
+		_out.seekp(offsetof(_FileHeader, recordAmount));
+		_out.write((const char*)&recordAmount, sizeof(recordAmount));
+	}
+
+	bool good = _out.good();
+	_out.close();
+	if (!good)
+		RG_ERR_CLOSE("ReplayStateWriter::Close(): Failed to write " << _tempPath);
+
+	std::filesystem::rename(_tempPath, path);
+}
+
+RLGSC::ReplayStateWriter::~ReplayStateWriter() {
+	Close();
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+#include "StateSetter.h"
+#include <filesystem>
+#include <fstream>
+
+namespace RLGSC {
+	// Read-only file of recorded arena states, written by ReplayStateWriter
+	// Layout: header, team of each car, then fixed-size records aligned to RECORD_ALIGNMENT
+	// The file is memory-mapped, so a record is used straight from the mapping with no parsing
+	// NOTE: Wheel/suspension state isn't recorded, to keep records small
+	class ReplayStateFile {
+	public:
+		constexpr static uint32_t MAGIC = 0x53524752; // "RGRS"
+		constexpr static uint32_t VERSION = 1;
+		constexpr static uint64_t RECORD_ALIGNMENT = 16;
+
+		struct PadRecord {
+			float cooldown;
+			bool isActive;
+		};
+
+		// Followed by the CarState of each car, then the PadRecord of each boost pad
+		struct RecordHeader {
+			uint64_t tickCount;
+			uint64_t reserved;
+			BallState ballState;
+		};
+
+		std::filesystem::path path;
+		uint32_t carAmount = 0, padAmount = 0;
+		uint64_t recordSize = 0, recordAmount = 0;
+		std::vector<Team> carTeams;
+
+		// Maps and checks the header of a replay state file
+		ReplayStateFile(std::filesystem::path path);
+		RG_NO_COPY(ReplayStateFile);
+
+		// Files are cached by path, so every state setter loading the same file shares one mapping
+		static std::shared_ptr<const ReplayStateFile> Load(std::filesystem::path path);
+
+		const RecordHeader* GetRecord(uint64_t index) const {
+			return (const RecordHeader*)(_mapData + _recordsOffset + index * recordSize);
+		}
+		const CarState* GetCarStates(const RecordHeader* record) const {
+			return (const CarState*)((const uint8_t*)record + sizeof(RecordHeader));
+		}
+		const PadRecord* GetPads(const RecordHeader* record) const {
+			return (const PadRecord*)((const uint8_t*)record + sizeof(RecordHeader) + carAmount * sizeof(CarState));
+		}
+
+		// Closes if the arena has different cars or boost pads than the records
+		void CheckArena(Arena* arena) const;
+
+		// Applies a record to an arena
+		// Ball hit ticks are moved to the arena's tick count, like Arena::RestoreSnapshot()
+		void Apply(uint64_t index, Arena* arena) const;
+
+		~ReplayStateFile();
+
+		const uint8_t* _mapData = NULL;
+		uint64_t _mapSize = 0;
+		uint64_t _recordsOffset = 0;
+		void* _mapHandle = NULL; // Windows only
+	};
+
+	// Streams arena states to a ReplayStateFile
+	// All added arenas must have the same cars (by team) and boost pads as the first one
+	class ReplayStateWriter {
+	public:
+		std::filesystem::path path;
+		uint64_t recordAmount = 0;
+
+		// Writes to a temporary file next to path, which is renamed to path by Close()
+		ReplayStateWriter(std::filesystem::path path);
+		RG_NO_COPY(ReplayStateWriter);
+
+		void Add(Arena* arena);
+
+		// Finishes the file, called by the destructor if it wasn't already
+		void Close();
+
+		~ReplayStateWriter();
+
+		std::ofstream _out;
+		std::filesystem::path _tempPath;
+		uint32_t _carAmount = 0, _padAmount = 0;
+		uint64_t _recordSize = 0;
+		std::vector<Team> _carTeams;
+		std::vector<byte> _recordBuffer;
+	};
+
+	// Resets to a random state from a ReplayStateFile
+	// The file is shared read-only by every ReplayStateSetter using it, so there is no per-game memory cost
+	class ReplayStateSetter : public StateSetter {
+	public:
+		std::shared_ptr<const ReplayStateFile> file;
+
+		ReplayStateSetter(std::filesystem::path path) : ReplayStateSetter(ReplayStateFile::Load(path)) {}
+		ReplayStateSetter(std::shared_ptr<const ReplayStateFile> file) : file(file) {
+			if (file->recordAmount == 0)
+				RG_ERR_CLOSE("ReplayStateSetter: " << file->path << " has no states");
+		}
+
+		virtual GameState ResetState(Arena* arena) {
+			return ResetState(arena, Math::GetRandEngine());
+		}
+
+		virtual GameState ResetState(Arena* arena, Math::RandEngine& randEngine) {
+			file->Apply(randEngine() % file->recordAmount, arena);
+			return GameState(arena);
+		}
+	};
+}
\ No newline at end of file
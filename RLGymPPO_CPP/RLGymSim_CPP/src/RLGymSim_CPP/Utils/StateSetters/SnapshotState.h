@@ -0,0 +1,27 @@
+#pragma once
+#include "StateSetter.h"
+
+namespace RLGSC {
+	// Resets to a random one of some prebaked arena snapshots (see Arena::TakeSnapshot())
+	// Much faster than setting up states from scratch, as snapshots are just copied back into the arena
+	// NOTE: Snapshots must have the same amount of cars as the arenas they are restored to
+	class SnapshotState : public StateSetter {
+	public:
+		std::vector<ArenaSnapshot> snapshots;
+
+		SnapshotState(const std::vector<ArenaSnapshot>& snapshots) : snapshots(snapshots) {
+			if (snapshots.empty())
+				RG_ERR_CLOSE("SnapshotState: No snapshots given");
+		}
+
+		virtual GameState ResetState(Arena* arena) {
+			return ResetState(arena, Math::GetRandEngine());
+		}
+
+		virtual GameState ResetState(Arena* arena, Math::RandEngine& randEngine) {
+			int index = Math::RandInt(0, snapshots.size(), randEngine);
+			arena->RestoreSnapshot(snapshots[index]);
+			return GameState(arena);
+		}
+	};
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "../Gamestates/GameState.h"
+#include "../../Math.h"
 
 namespace RLGSC {
 	class StateSetter {
@@ -7,5 +8,11 @@ namespace RLGSC {
 
 		// NOTE: Applies reset state to arena
 		virtual GameState ResetState(Arena* arena) = 0;
+
+		// Reset using the game's random engine, so resets can be reproduced (see Match::randEngine)
+		// Only needs to be overridden by state setters that are random
+		virtual GameState ResetState(Arena* arena, Math::RandEngine& randEngine) {
+			return ResetState(arena);
+		}
 	};
 }
\ No newline at end of file
@@ -9,5 +9,9 @@ namespace RLGSC {
 		virtual bool IsTerminal(const GameState& currentState) {
 			return Math::IsBallScored(currentState.ball.pos);
 		}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::BALL;
+		}
 	};
 }
\ No newline at end of file
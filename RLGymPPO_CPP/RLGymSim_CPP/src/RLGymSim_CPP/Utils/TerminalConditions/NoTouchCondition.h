@@ -8,23 +8,44 @@ namespace RLGSC {
 		int stepsSinceTouch = 0;
 		int maxSteps;
 
+		// If set, the timeout is in seconds of game time instead of steps, so it doesn't depend on the tick rate or tick skip
+		float maxSeconds = 0;
+		uint64_t touchTickCount = 0;
+
 		NoTouchCondition(int maxSteps) : maxSteps(maxSteps) {
 		}
 
+		static NoTouchCondition* FromSeconds(float maxSeconds) {
+			NoTouchCondition* result = new NoTouchCondition(0);
+			result->maxSeconds = maxSeconds;
+			return result;
+		}
+
 		virtual void Reset(const GameState& initialState) {
 			stepsSinceTouch = 0;
+			touchTickCount = initialState.lastTickCount;
 		};
 
 		virtual bool IsTerminal(const GameState& currentState) {
 			for (auto& player : currentState.players) {
 				if (player.ballTouchedStep) {
 					stepsSinceTouch = 0;
+					touchTickCount = currentState.lastTickCount;
 					return false;
 				}
 			}
 
 			stepsSinceTouch++;
-			return stepsSinceTouch >= maxSteps;
+			if (maxSeconds > 0) {
+				uint64_t maxTicks = (uint64_t)roundf(maxSeconds / currentState.tickTime);
+				return currentState.lastTickCount - touchTickCount >= maxTicks;
+			} else {
+				return stepsSinceTouch >= maxSteps;
+			}
+		}
+
+		virtual StateFields GetStateFields() {
+			return StateFields::PLAYERS;
 		}
 	};
 }
\ No newline at end of file
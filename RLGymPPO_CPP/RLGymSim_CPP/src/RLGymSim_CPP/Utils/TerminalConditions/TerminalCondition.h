@@ -6,5 +6,11 @@ namespace RLGSC {
 	public:
 		virtual void Reset(const GameState& initialState) {};
 		virtual bool IsTerminal(const GameState& currentState) = 0;
+
+		// Fields of the state read by this, only the fields needed by a match are filled each step (see StateFields)
+		// Default implementation needs everything
+		virtual StateFields GetStateFields() {
+			return StateFields::ALL;
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "VecGym.h"
+
+RLGSC::VecGym::VecGym(GymCreateFn createFn, int numGyms, int numThreads, int64_t seed) {
+	if (numGyms < 1)
+		RG_ERR_CLOSE("VecGym::VecGym(): Invalid gym count (" << numGyms << ")");
+
+	for (int i = 0; i < numGyms; i++) {
+		Gym* gym = createFn();
+		if (seed >= 0)
+			gym->match->randEngine.Seed(((uint64_t)seed << 32) | i);
+
+		gyms.push_back(gym);
+		totalPlayers += gym->match->playerAmount;
+		playerStart.push_back(totalPlayers);
+	}
+
+	// The observation size is only known once a gym has built observations
+	FList2 firstObs = gyms[0]->Reset();
+	obsSize = firstObs.empty() ? 0 : firstObs[0].size();
+	if (obsSize == 0)
+		RG_ERR_CLOSE("VecGym::VecGym(): Gyms have no observations");
+
+	obs.resize((size_t)totalPlayers * obsSize);
+	rewards.resize(totalPlayers);
+	dones.resize(totalPlayers);
+	for (int i = 0; i < numGyms; i++)
+		gyms[i]->SetOBSOutput(obs.data() + (size_t)playerStart[i] * obsSize, obsSize);
+
+	taskPool = new ArenaTaskPool(RS_MAX(numThreads, 1));
+}
+
+void RLGSC::VecGym::Reset() {
+	taskPool->Run(gyms.size(), [&](size_t i) {
+		gyms[i]->Reset();
+	});
+
+	std::fill(rewards.begin(), rewards.end(), 0.f);
+	std::fill(dones.begin(), dones.end(), 0);
+}
+
+void RLGSC::VecGym::Step(const int64_t* actions) {
+	taskPool->Run(gyms.size(), [&](size_t i) {
+		Gym* gym = gyms[i];
+		int firstPlayer = playerStart[i];
+
+		bool done;
+		gym->StepInto(actions + firstPlayer, rewards.data() + firstPlayer, done);
+		for (int j = firstPlayer; j < playerStart[i + 1]; j++)
+			dones[j] = done;
+
+		if (done)
+			gym->Reset();
+	});
+}
+
+RLGSC::VecGym::~VecGym() {
+	delete taskPool;
+	for (Gym* gym : gyms) {
+		delete gym->match;
+		delete gym;
+	}
+}
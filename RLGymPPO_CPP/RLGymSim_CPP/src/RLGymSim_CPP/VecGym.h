@@ -0,0 +1,47 @@
+#pragma once
+#include "Gym.h"
+
+namespace RLGSC {
+	// Many gyms stepped together on a pool of threads, as one vectorized environment
+	// Observations, rewards and dones of all players are written into buffers we own, laid out in the order of the gyms,
+	//	so they can be read in place (e.g. as numpy arrays) instead of being copied out every step
+	// Gyms that end are reset in Step(), so their observations after a done are the first of their next episode
+	class VecGym {
+	public:
+		typedef std::function<Gym*()> GymCreateFn;
+
+		// NOTE: Gyms and their matches will be deleted when we are deleted
+		std::vector<Gym*> gyms = {};
+
+		// Index of the first player of each gym, with the total amount of players at the end
+		IList playerStart = { 0 };
+		int totalPlayers = 0;
+		int obsSize = 0;
+
+		// [totalPlayers][obsSize]
+		FList obs = {};
+		// [totalPlayers]
+		FList rewards = {};
+		// [totalPlayers], 1 if the player's gym ended this step
+		std::vector<uint8_t> dones = {};
+
+		// Steps our gyms, includes the thread calling Step()
+		ArenaTaskPool* taskPool;
+
+		// If seed is non-negative, the match of each gym is seeded from it and the gym's index (see Match::randEngine)
+		VecGym(GymCreateFn createFn, int numGyms, int numThreads, int64_t seed = -1);
+		RG_NO_COPY(VecGym);
+
+		int Size() const {
+			return gyms.size();
+		}
+
+		// Resets every gym, observations are written into obs
+		void Reset();
+
+		// Steps every gym with the action index of each player ([totalPlayers]), writing into obs, rewards and dones
+		void Step(const int64_t* actions);
+
+		~VecGym();
+	};
+}
@@ -22,4 +22,9 @@ def init(py_exec_path, project, group, name, id = None):
 
 def add_metrics(metrics):
 	global wandb_run
-	wandb_run.log(metrics)
\ No newline at end of file
+	wandb_run.log(metrics)
+
+# Takes in a list of metrics dicts, oldest first
+def add_metrics_batch(metrics_list):
+	for metrics in metrics_list:
+		add_metrics(metrics)
\ No newline at end of file
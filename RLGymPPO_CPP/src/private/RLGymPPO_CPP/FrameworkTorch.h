@@ -9,15 +9,18 @@
 
 #define RG_NOGRAD torch::NoGradGuard _noGradGuard
 
+// Both CUDA and CPU autocast run in bf16, parameters and optimizer states stay in fp32
 #define RG_AUTOCAST_ON() { \
 at::autocast::set_enabled(true); \
+at::autocast::set_cpu_enabled(true); \
 at::autocast::set_autocast_gpu_dtype(torch::kBFloat16); \
-at::autocast::set_autocast_cpu_dtype(torch::kFloat); \
+at::autocast::set_autocast_cpu_dtype(torch::kBFloat16); \
 }
 
 #define RG_AUTOCAST_OFF() { \
 at::autocast::clear_cache(); \
 at::autocast::set_enabled(false); \
+at::autocast::set_cpu_enabled(false); \
 }
 
 #define RG_HALFPERC_TYPE torch::ScalarType::BFloat16
@@ -0,0 +1,142 @@
+#include "ActivationCheckpoint.h"
+#include "FusedLinear.h"
+
+#include <torch/nn/modules/linear.h>
+#include <torch/csrc/autograd/custom_function.h>
+#include <torch/csrc/autograd/autograd.h>
+
+using namespace torch::autograd;
+
+// Modules [start, end) of a seq, kept alive by the autograd graph until its backward pass
+struct _CheckpointBlock : public torch::CustomClassHolder {
+	torch::nn::Sequential seq;
+	size_t start, end;
+	bool fused;
+
+	// The backward pass runs on autograd's own threads, which don't have our autocast state
+	bool autocast, cpuAutocast;
+	torch::ScalarType autocastType, cpuAutocastType;
+
+	torch::Tensor Forward(torch::Tensor input) {
+		if (fused)
+			return RLGPC::FusedLinear::ForwardSeq(seq, input, end, start);
+
+		auto x = input;
+		for (auto itr = seq->begin() + start; itr < seq->begin() + end; itr++)
+			x = itr->forward(x);
+		return x;
+	}
+};
+
+struct _CheckpointFunction : public Function<_CheckpointFunction> {
+	// Parameters are inputs so that their gradients come from our backward pass
+	static torch::Tensor forward(AutogradContext* ctx, torch::Tensor input, c10::intrusive_ptr<_CheckpointBlock> block, variable_list params) {
+		variable_list saved = { input };
+		saved.insert(saved.end(), params.begin(), params.end());
+		ctx->save_for_backward(saved);
+		ctx->saved_data["block"] = c10::IValue::make_capsule(block);
+
+		// Custom functions always run their forward pass without grad, so nothing inside the block is stored
+		return block->Forward(input);
+	}
+
+	static variable_list backward(AutogradContext* ctx, variable_list gradOutputs) {
+		auto block = c10::static_intrusive_pointer_cast<_CheckpointBlock>(ctx->saved_data["block"].toCapsule());
+		auto saved = ctx->get_saved_variables();
+
+		bool inputNeedsGrad = ctx->needs_input_grad(0);
+		auto input = saved[0].detach().requires_grad_(inputNeedsGrad);
+
+		torch::Tensor output;
+		{
+			torch::AutoGradMode gradMode(true);
+			bool prevAutocast = at::autocast::is_enabled(), prevCPUAutocast = at::autocast::is_cpu_enabled();
+			auto prevAutocastType = at::autocast::get_autocast_gpu_dtype(), prevCPUAutocastType = at::autocast::get_autocast_cpu_dtype();
+			at::autocast::set_enabled(block->autocast);
+			at::autocast::set_autocast_gpu_dtype(block->autocastType);
+			at::autocast::set_cpu_enabled(block->cpuAutocast);
+			at::autocast::set_autocast_cpu_dtype(block->cpuAutocastType);
+
+			output = block->Forward(input);
+
+			at::autocast::set_enabled(prevAutocast);
+			at::autocast::set_cpu_enabled(prevCPUAutocast);
+			at::autocast::set_autocast_cpu_dtype(prevCPUAutocastType);
+			at::autocast::set_autocast_gpu_dtype(prevAutocastType);
+		}
+
+		// Only get gradients of what needs them, autograd::grad() fails on tensors that don't require grad
+		variable_list gradTargets = {};
+		std::vector<int> targetIndices = {};
+		if (inputNeedsGrad) {
+			gradTargets.push_back(input);
+			targetIndices.push_back(0);
+		}
+		for (int i = 1; i < saved.size(); i++) {
+			if (saved[i].requires_grad()) {
+				gradTargets.push_back(saved[i]);
+				targetIndices.push_back(i);
+			}
+		}
+
+		// The block is an input without a gradient, after the input tensor
+		variable_list result = variable_list(saved.size() + 1);
+		if (gradTargets.empty())
+			return result;
+
+		auto grads = torch::autograd::grad({ output }, gradTargets, { gradOutputs[0] }, false, false, true);
+		for (int i = 0; i < grads.size(); i++) {
+			int savedIndex = targetIndices[i];
+			result[savedIndex == 0 ? 0 : savedIndex + 1] = grads[i];
+		}
+		return result;
+	}
+};
+
+torch::Tensor RLGPC::ActivationCheckpoint::ForwardSeq(torch::nn::Sequential& seq, torch::Tensor input, int layersPerBlock, bool fused, size_t end) {
+	end = std::min(end, seq->size());
+
+	if (!torch::GradMode::is_enabled() || layersPerBlock <= 0) {
+		if (fused)
+			return FusedLinear::ForwardSeq(seq, input, end);
+
+		auto x = input;
+		for (auto itr = seq->begin(); itr < seq->begin() + end; itr++)
+			x = itr->forward(x);
+		return x;
+	}
+
+	auto x = input;
+	size_t blockStart = 0;
+	while (blockStart < end) {
+		// A block ends after the module following its last Linear (its ReLU), so fused pairs are never split
+		size_t blockEnd = blockStart;
+		int linearAmount = 0;
+		variable_list params = {};
+		while (blockEnd < end && linearAmount < layersPerBlock) {
+			auto module = seq->ptr(blockEnd);
+			if (module->as<torch::nn::Linear>()) {
+				linearAmount++;
+				auto moduleParams = module->parameters();
+				params.insert(params.end(), moduleParams.begin(), moduleParams.end());
+			}
+			blockEnd++;
+		}
+		if (blockEnd < end && !seq->ptr(blockEnd)->as<torch::nn::Linear>())
+			blockEnd++;
+
+		auto block = c10::make_intrusive<_CheckpointBlock>();
+		block->seq = seq;
+		block->start = blockStart;
+		block->end = blockEnd;
+		block->fused = fused;
+		block->autocast = at::autocast::is_enabled();
+		block->autocastType = at::autocast::get_autocast_gpu_dtype();
+		block->cpuAutocast = at::autocast::is_cpu_enabled();
+		block->cpuAutocastType = at::autocast::get_autocast_cpu_dtype();
+
+		x = _CheckpointFunction::apply(x, block, params);
+		blockStart = blockEnd;
+	}
+	return x;
+}
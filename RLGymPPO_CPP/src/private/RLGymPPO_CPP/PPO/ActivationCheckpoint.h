@@ -0,0 +1,14 @@
+#pragma once
+#include "../FrameworkTorch.h"
+
+#include <torch/nn/modules/container/sequential.h>
+
+namespace RLGPC {
+	namespace ActivationCheckpoint {
+		// Same as seq->forward() (or FusedLinear::ForwardSeq() if fused), but activations are only stored at the inputs of blocks of layersPerBlock Linear layers
+		// Everything inside a block is recomputed during the backward pass, which trades a second forward pass for much less activation memory
+		// Only the first (end) modules of seq are run
+		// Without grad mode, this is the same as a normal forward pass
+		torch::Tensor ForwardSeq(torch::nn::Sequential& seq, torch::Tensor input, int layersPerBlock, bool fused, size_t end = SIZE_MAX);
+	}
+}
@@ -1,5 +1,7 @@
 #include "DiscretePolicy.h"
 
+#include "../FrameworkTorch.h"
+
 #include <torch/nn/modules/linear.h>
 #include <torch/nn/modules/activation.h>
 
@@ -20,43 +22,121 @@ RLGPC::DiscretePolicy::DiscretePolicy(int inputAmount, int actionAmount, const I
 	}
 
 	// Output layer, for each action
+	// This outputs logits, softmax is done afterward with log_softmax
+	// NOTE: Softmax has no parameters, so checkpoints from models that had a Softmax layer here still load
 	seq->push_back(nn::Linear(layerSizes.back(), actionAmount));
-	seq->push_back(nn::Softmax(nn::SoftmaxOptions(-1)));
+	featureAmount = layerSizes.back();
 
 	register_module("seq", seq);
 
+	// From torch's generator, so sampling still follows torch::manual_seed()
+	sampleRNG.seed = torch::randint(1ll << 62, {}, torch::kInt64).item<int64_t>();
+
 	this->to(device, true);
 }
 
-torch::Tensor RLGPC::DiscretePolicy::GetActionProbs(torch::Tensor obs) {
-	auto probs = GetOutput(obs);
-	probs = probs.view({ -1, actionAmount });
-	probs = torch::clamp(probs, ACTION_MIN_PROB, 1);
-	return probs;
+torch::Tensor RLGPC::DiscretePolicy::GetLogProbs(torch::Tensor obs) {
+	if (halfPrec)
+		obs = obs.to(RG_HALFPERC_TYPE);
+
+	return _LogProbsFromLogits(GetOutput(obs));
+}
+
+torch::Tensor RLGPC::DiscretePolicy::GetFeatures(torch::Tensor obs) {
+	if (halfPrec)
+		obs = obs.to(RG_HALFPERC_TYPE);
+
+	auto features = obsStandardization.Apply(obs);
+	if (checkpointLayers > 0)
+		return ActivationCheckpoint::ForwardSeq(seq, features, checkpointLayers, fusedLayers, seq->size() - 1);
+	if (fusedLayers)
+		return FusedLinear::ForwardSeq(seq, features, seq->size() - 1);
+
+	for (auto itr = seq->begin(); itr != seq->end() - 1; itr++)
+		features = itr->forward(features);
+	return features;
+}
+
+torch::Tensor RLGPC::DiscretePolicy::GetLogProbsFromFeatures(torch::Tensor features) {
+	return _LogProbsFromLogits((seq->end() - 1)->forward(features));
+}
+
+torch::Tensor RLGPC::DiscretePolicy::_LogProbsFromLogits(torch::Tensor logits) {
+	// Log probs are always computed in full precision
+	logits = logits.to(torch::kFloat).view({ -1, actionAmount });
+	return torch::log_softmax(logits, -1);
 }
 
-RLGPC::DiscretePolicy::ActionResult RLGPC::DiscretePolicy::GetAction(torch::Tensor obs, bool deterministic) {
-	auto probs = GetActionProbs(obs);
+RLGPC::DiscretePolicy::ActionResult RLGPC::DiscretePolicy::GetActionDevice(torch::Tensor obs, bool deterministic) {
+	if (device.is_cpu()) {
+		// At the batch sizes we collect with, each of the ops below costs more in dispatching than in math
+		auto logits = GetOutput(halfPrec ? obs.to(RG_HALFPERC_TYPE) : obs).detach().to(torch::kFloat).contiguous().view({ -1, actionAmount });
+		int batchSize = logits.size(0);
+
+		auto action = torch::empty({ batchSize }, torch::kInt64);
+		auto logProb = torch::empty({ batchSize }, torch::kFloat);
+		NativeMLP::SampleActions(
+			logits.data_ptr<float>(), actionAmount, batchSize, actionAmount,
+			action.data_ptr<int64_t>(), logProb.data_ptr<float>(),
+			deterministic, sampleRNG.seed, sampleRNG.Reserve(batchSize)
+		);
+		return ActionResult{ action, logProb };
+	}
+
+	auto logProbs = GetLogProbs(obs);
 
 	if (deterministic) {
-		auto action = probs.argmax(1);
-		return { action.cpu().flatten(), torch::zeros(action.numel()) };
+		auto action = logProbs.argmax(1);
+		return { action.flatten(), torch::zeros({ action.numel() }, logProbs.options()) };
 	} else {
-		auto action = torch::multinomial(probs, 1, true);
-		auto logProb = torch::log(probs).gather(-1, action);
-		return ActionResult{ action.cpu().flatten(), logProb.cpu().flatten() };
+		// Gumbel-max sampling: argmax(logProbs + Gumbel noise) is distributed like softmax(logProbs)
+		// -log(Exponential(1)) is Gumbel noise
+		auto noise = torch::empty_like(logProbs).exponential_().log();
+		auto action = (logProbs - noise).argmax(-1, true);
+		auto logProb = logProbs.gather(-1, action);
+		return ActionResult{ action.flatten(), logProb.flatten() };
 	}
 }
 
+RLGPC::DiscretePolicy::ActionResult RLGPC::DiscretePolicy::GetAction(torch::Tensor obs, bool deterministic, torch::Tensor readback) {
+	auto result = GetActionDevice(obs, deterministic);
+	if (device.is_cpu())
+		return result;
+
+	return ReadBackResult(PackResult(result), readback);
+}
+
+torch::Tensor RLGPC::DiscretePolicy::PackResult(const ActionResult& result) {
+	return torch::stack({ result.action.to(torch::kFloat), result.logProb.to(torch::kFloat) });
+}
+
+RLGPC::DiscretePolicy::ActionResult RLGPC::DiscretePolicy::ReadBackResult(torch::Tensor packed, torch::Tensor readback) {
+	torch::Tensor packedCPU;
+	if (readback.defined()) {
+		readback.copy_(packed);
+		packedCPU = readback;
+	} else {
+		packedCPU = packed.cpu();
+	}
+
+	return ActionResult{ packedCPU[0].to(torch::kInt64), packedCPU[1] };
+}
+
 RLGPC::DiscretePolicy::BackpropResult RLGPC::DiscretePolicy::GetBackpropData(torch::Tensor obs, torch::Tensor acts) {
-	// Get probability of each action
+	return _GetBackpropData(GetLogProbs(obs), acts);
+}
+
+RLGPC::DiscretePolicy::BackpropResult RLGPC::DiscretePolicy::GetBackpropDataFromFeatures(torch::Tensor features, torch::Tensor acts) {
+	return _GetBackpropData(GetLogProbsFromFeatures(features), acts);
+}
+
+RLGPC::DiscretePolicy::BackpropResult RLGPC::DiscretePolicy::_GetBackpropData(torch::Tensor logProbs, torch::Tensor acts) {
+	// Get log probability of each action
 	acts = acts.to(torch::kInt64, true);
-	auto probs = GetActionProbs(obs);
 
-	// Compute log probs and entropy
-	auto logProbs = torch::log(probs);
+	// Compute action log probs and entropy
 	auto actionLogProbs = logProbs.gather(-1, acts);
-	auto entropy = -(logProbs * probs).sum(-1);
+	auto entropy = -(logProbs.exp() * logProbs).sum(-1);
 
 	return BackpropResult{ actionLogProbs.to(device, true), entropy.to(device).mean() };
 }
@@ -1,5 +1,9 @@
 #pragma once
 #include <RLGymPPO_CPP/Lists.h>
+#include "OBSStandardization.h"
+#include "FusedLinear.h"
+#include "ActivationCheckpoint.h"
+#include "NativeMLP.h"
 
 #include <torch/nn/modules/container/sequential.h>
 
@@ -12,26 +16,82 @@ namespace RLGPC {
 		int inputAmount;
 		int actionAmount;
 
-		// Min probability that an action will be taken
-		constexpr static float ACTION_MIN_PROB = 1e-11;
+		// If true, this is a half-precision copy of a policy, used for faster inference
+		// Inputs are converted to half precision, outputs are always full precision
+		bool halfPrec = false;
+
+		// If true, each Linear and ReLU of seq is run as one fused GEMM (see FusedLinear)
+		bool fusedLayers = false;
+
+		// If set, activations inside blocks of this many layers are recomputed during backward instead of stored (see ActivationCheckpoint)
+		int checkpointLayers = 0;
+
+		// Applied to inputs before the first layer, only if set
+		OBSStandardization obsStandardization = {};
+
+		// Actions sampled on the CPU draw from this, so agents sharing this policy can sample at once (see GetActionDevice())
+		NativeMLP::CounterRNG sampleRNG = {};
 
 		DiscretePolicy(int inputAmount, int actionAmount, const IList& layerSizes, torch::Device device);
 
+		// Copies the standardization to our device and precision
+		void SetOBSStandardization(const OBSStandardization& standardization) {
+			obsStandardization.CopyFrom(standardization, parameters()[0].options());
+		}
+
+		// Returns the logits of each action
 		torch::Tensor GetOutput(torch::Tensor input) {
-			return seq->forward(input);
+			auto x = obsStandardization.Apply(input);
+			if (checkpointLayers > 0)
+				return ActivationCheckpoint::ForwardSeq(seq, x, checkpointLayers, fusedLayers);
+			return fusedLayers ? FusedLinear::ForwardSeq(seq, x) : seq->forward(x);
 		}
 
-		torch::Tensor GetActionProbs(torch::Tensor obs);
+		// [batchSize][actionAmount], always full precision
+		torch::Tensor GetLogProbs(torch::Tensor obs);
+
+		// Output of every layer but the last, which the critic also uses with a shared trunk (see PPOLearnerConfig::sharedTrunk)
+		torch::Tensor GetFeatures(torch::Tensor obs);
+		int featureAmount;
+
+		// Same as GetLogProbs(), from the output of GetFeatures()
+		torch::Tensor GetLogProbsFromFeatures(torch::Tensor features);
+
+		torch::Tensor _LogProbsFromLogits(torch::Tensor logits);
+
+		torch::Tensor GetActionProbs(torch::Tensor obs) {
+			return GetLogProbs(obs).exp();
+		}
 
 		struct ActionResult {
 			torch::Tensor action, logProb;
+
+			// Only set if the critic was inferred alongside the policy (see LearnerConfig::rolloutValues)
+			torch::Tensor value;
 		};
-		ActionResult GetAction(torch::Tensor obs, bool deterministic);
+		// If readback is set, results are copied back into it (see ReadBackResult())
+		ActionResult GetAction(torch::Tensor obs, bool deterministic, torch::Tensor readback = {});
+
+		// Same as GetAction(), but results are left on our device
+		// Does not synchronize with the device, so it can be captured into a CUDA graph
+		// On the CPU, the log-softmax and sampling of the logits are one pass of NativeMLP::SampleActions()
+		ActionResult GetActionDevice(torch::Tensor obs, bool deterministic);
+
+		// Packs the actions and log probs of a result into one [2][batch size] float tensor, so they are copied back in one transfer
+		// Action indices are far below 2^24, so they are exact as floats
+		static torch::Tensor PackResult(const ActionResult& result);
+
+		// Copies a packed result back to the CPU, and unpacks it
+		// If set, readback is the [2][batch size] float CPU tensor to copy into, which should be pinned so the copy is a single DMA
+		// The log probs are then a view of readback, so it must not be written again until they are used
+		static ActionResult ReadBackResult(torch::Tensor packed, torch::Tensor readback = {});
 		
 		struct BackpropResult {
 			torch::Tensor actionLogProbs;
 			torch::Tensor entropy;
 		};
 		BackpropResult GetBackpropData(torch::Tensor obs, torch::Tensor acts);
+		BackpropResult GetBackpropDataFromFeatures(torch::Tensor features, torch::Tensor acts);
+		BackpropResult _GetBackpropData(torch::Tensor logProbs, torch::Tensor acts);
 	};
 }
\ No newline at end of file
@@ -1,15 +1,177 @@
 #include "ExperienceBuffer.h"
 
 #include "../Util/TorchFuncs.h"
+#include "../Util/CPUAffinity.h"
+#include "../Util/MappedFile.h"
+#include <RLGymPPO_CPP/Util/Timer.h>
+#include "../libsrc/json/nlohmann/json.hpp"
 
 using namespace torch;
 
-RLGPC::ExperienceBuffer::ExperienceBuffer(int64_t maxSize, int seed, torch::Device device) :
-	maxSize(maxSize), seed(seed), device(device), rng(seed) {
-	
+RLGPC::ExperienceBuffer::ExperienceBuffer(
+	int64_t maxSize, int seed, torch::Device device, bool storeOnDevice, OBSStorageType obsType, const FList& obsScales, 
+	HugePageMode hugePages, int actionAmount, const std::vector<IList>& shardCores, std::filesystem::path spillFolder) :
+	maxSize(maxSize), seed(seed), device(device), storeOnDevice(storeOnDevice), obsType(obsType), obsScales(obsScales), hugePages(hugePages), 
+	actionAmount(actionAmount), shardCores((storeOnDevice || !spillFolder.empty()) ? std::vector<IList>() : shardCores), 
+	spillFolder(storeOnDevice ? std::filesystem::path() : spillFolder), rng(seed) {
+
+	shardRows = IsSharded() ? (maxSize + this->shardCores.size() - 1) / this->shardCores.size() : maxSize;
+
+	if (actionAmount > 0 && actionAmount <= UINT8_MAX + 1) {
+		actionType = torch::kUInt8;
+	} else if (actionAmount > 0 && actionAmount <= INT16_MAX + 1) {
+		actionType = torch::kInt16;
+	} else {
+		actionType = torch::kInt32;
+	}
+
+	if (obsType == OBSStorageType::INT16) {
+		if (obsScales.empty())
+			RG_ERR_CLOSE("ExperienceBuffer: INT16 OBS storage requires OBS scales");
+
+		obsDecompressScales = (torch::tensor(obsScales) / INT16_MAX).to(device);
+	}
 }
 
-void RLGPC::ExperienceBuffer::SubmitExperience(ExperienceTensors& _data) {
+void RLGPC::ExperienceBuffer::SetMirror(float fraction, const IList& obsSourceIndices, const FList& obsSigns, const IList& actionMap) {
+	if (obsSourceIndices.size() != obsSigns.size())
+		RG_ERR_CLOSE("ExperienceBuffer::SetMirror(): OBS mirror map has " << obsSourceIndices.size() << " indices but " << obsSigns.size() << " signs");
+
+	mirrorFraction = fraction;
+	mirrorOBSIndices = torch::tensor(obsSourceIndices, torch::kInt64).to(device);
+	mirrorOBSSigns = torch::tensor(obsSigns).to(device);
+	mirrorActions = torch::tensor(actionMap, torch::kInt64).to(device);
+}
+
+void RLGPC::ExperienceBuffer::MirrorExperience(ExperienceTensors& data, DiscretePolicy* policy, int64_t chunkSize) {
+	RG_NOGRAD;
+
+	std::bernoulli_distribution mirrorDist = std::bernoulli_distribution(mirrorFraction);
+	std::vector<int64_t> mirrorIndices = {};
+	for (int64_t i = 0; i < data.states.size(0); i++)
+		if (mirrorDist(rng))
+			mirrorIndices.push_back(i);
+
+	if (mirrorIndices.empty())
+		return;
+
+	// Submitted tensors can still be used by the trajectory they came from
+	Tensor indices = torch::tensor(mirrorIndices, torch::kInt64).to(data.states.device());
+	data.states = data.states.clone();
+	data.actions = data.actions.clone();
+	data.logProbs = data.logProbs.clone();
+
+	// Split into minibatches to limit memory use
+	int64_t numMirrored = indices.size(0);
+	for (int64_t start = 0; start < numMirrored; start += chunkSize) {
+		Tensor chunkIndices = indices.slice(0, start, RS_MIN(start + chunkSize, numMirrored));
+		Tensor states = data.states.index_select(0, chunkIndices), actions = data.actions.index_select(0, chunkIndices);
+
+		Tensor mirroredStates = states.to(device, torch::kFloat).index_select(1, mirrorOBSIndices).mul_(mirrorOBSSigns);
+		Tensor mirroredActions = mirrorActions.index_select(0, actions.flatten().to(device, torch::kInt64)); // One action per sample
+		Tensor mirroredLogProbs = policy->GetLogProbs(mirroredStates).gather(-1, mirroredActions.view({ -1, 1 })).flatten();
+
+		data.states.index_put_({ chunkIndices }, mirroredStates.to(data.states.device(), data.states.scalar_type()));
+		data.actions.index_put_({ chunkIndices }, mirroredActions.view_as(actions).to(data.actions.device(), data.actions.scalar_type()));
+		data.logProbs.index_put_({ chunkIndices }, mirroredLogProbs.to(data.logProbs.device(), data.logProbs.scalar_type()));
+	}
+}
+
+void RLGPC::ExperienceBuffer::_NarrowExperience(ExperienceTensors& data) const {
+	data.states = _CompressOBS(data.states);
+	data.actions = data.actions.to(actionType);
+	data.dones = data.dones.to(torch::kUInt8);
+	data.truncated = data.truncated.to(torch::kUInt8);
+}
+
+torch::Tensor RLGPC::ExperienceBuffer::_CompressOBS(torch::Tensor states) const {
+	switch (obsType) {
+	case OBSStorageType::HALF:
+		return states.to(torch::kHalf);
+	case OBSStorageType::BF16:
+		return states.to(torch::kBFloat16);
+	case OBSStorageType::INT16:
+	{
+		if (states.size(1) != obsScales.size())
+			RG_ERR_CLOSE("ExperienceBuffer: OBS size is " << states.size(1) << ", but there are " << obsScales.size() << " OBS scales");
+
+		auto scales = torch::tensor(obsScales).to(states.device());
+		return (states / scales).clamp_(-1, 1).mul_(INT16_MAX).round_().to(torch::kInt16);
+	}
+	default:
+		return states;
+	}
+}
+
+torch::Tensor RLGPC::ExperienceBuffer::_DecompressOBS(torch::Tensor states) const {
+	switch (obsType) {
+	case OBSStorageType::HALF:
+	case OBSStorageType::BF16:
+		return states.to(torch::kFloat);
+	case OBSStorageType::INT16:
+		return states.to(torch::kFloat).mul_(obsDecompressScales);
+	default:
+		return states;
+	}
+}
+
+torch::Tensor RLGPC::ExperienceBuffer::_GetOrdered(torch::Tensor t) const {
+	if (curSize < maxSize || writeIdx == 0) {
+		return t.slice(0, 0, curSize);
+	} else {
+		return torch::cat({ t.slice(0, writeIdx, maxSize), t.slice(0, 0, writeIdx) });
+	}
+}
+
+torch::Tensor RLGPC::ExperienceBuffer::_MakeStorage(c10::IntArrayRef rowSizes, torch::ScalarType dtype) const {
+	auto sizes = rowSizes.vec();
+	sizes[0] = maxSize;
+	auto options = torch::TensorOptions().dtype(dtype).device(GetStorageDevice());
+
+	if ((hugePages == HugePageMode::NONE && !IsSpilled()) || storeOnDevice)
+		return torch::empty(sizes, options);
+
+	int64_t numel = 1;
+	for (int64_t size : sizes)
+		numel *= size;
+	size_t bytes = numel * c10::elementSize(dtype);
+
+	if (IsSpilled()) {
+		// The tensor keeps its file mapped
+		auto file = std::make_shared<SpillFile>(spillFolder, RS_MAX(bytes, 1), "ExperienceBuffer: ");
+		return torch::from_blob(file->data, sizes, [file](void* ptr) {}, options);
+	}
+
+	void* data = HugePages::Alloc(bytes, hugePages);
+	if (!data)
+		RG_ERR_CLOSE("ExperienceBuffer: Failed to allocate " << bytes << " bytes with huge pages");
+	return torch::from_blob(data, sizes, [bytes](void* ptr) { HugePages::Free(ptr, bytes); }, options);
+}
+
+void RLGPC::ExperienceBuffer::_RunOnShards(const std::vector<_ShardRun>& runs, const std::function<void(int64_t start, int64_t end)>& fn) const {
+	// Smaller pieces aren't worth a thread
+	constexpr int64_t MIN_PIECE_ROWS = 512;
+
+	std::vector<std::thread> threads = {};
+	for (auto& run : runs) {
+		auto& cores = shardCores[run.shard];
+		int64_t numPieces = RS_MAX(RS_MIN((run.end - run.start) / MIN_PIECE_ROWS, (int64_t)cores.size()), 1);
+		for (int64_t i = 0; i < numPieces; i++) {
+			int64_t
+				start = run.start + (run.end - run.start) * i / numPieces,
+				end = run.start + (run.end - run.start) * (i + 1) / numPieces;
+			threads.push_back(std::thread([&cores, &fn, start, end] {
+				CPUAffinity::PinCurrentThread(cores);
+				fn(start, end);
+			}));
+		}
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void RLGPC::ExperienceBuffer::SubmitExperience(ExperienceTensors& _data, bool narrowed) {
 	RG_NOGRAD;
 
 	bool empty = curSize == 0;
@@ -17,57 +179,98 @@ void RLGPC::ExperienceBuffer::SubmitExperience(ExperienceTensors& _data) {
 #ifdef RG_PARANOID_MODE
 	// Keep copy of target concatination result to keep track of
 	auto rewardsTarget = _Concat(
-		curSize > 0 ? data.rewards.slice(0, 0, curSize) : data.rewards,
+		curSize > 0 ? _GetOrdered(data.rewards).cpu() : data.rewards,
 		_data.rewards,
 		maxSize
 	);
 #endif
 
+	int64_t addAmount = RS_MIN(_data.begin()->size(0), maxSize);
+
+	if (!narrowed)
+		_NarrowExperience(_data);
+
 	for (auto itr1 = data.begin(), itr2 = _data.begin(); itr1 != data.end(); itr1++, itr2++) {
 		Tensor& ourTen = *itr1;
 		Tensor& addTen = *itr2;
 
-		int64_t addAmount = addTen.size(0);
-
-		if (addAmount > maxSize) {
-			addTen = addTen.slice(0, addAmount - maxSize);
-			addAmount = maxSize;
-		}
-		
-		int64_t overflow = RS_MAX((curSize + addAmount) - maxSize, 0);
-		int64_t startIdx = curSize - overflow;
-		int64_t endIdx = curSize + addAmount - overflow;
+		// If we are adding more than we can store, only the newest data will fit
+		if (addTen.size(0) > maxSize)
+			addTen = addTen.slice(0, addTen.size(0) - maxSize);
 
 		if (empty) {
 			// Initalize tensor
 			
-			// Make zero tensor of target size
-			auto sizes = addTen.sizes();
-			auto newSizes = std::vector<int64_t>(sizes.begin(), sizes.end());
-			newSizes[0] = maxSize;
-			ourTen = torch::zeros(newSizes);
+			// Make tensor of target size
+			ourTen = _MakeStorage(addTen.sizes(), addTen.scalar_type());
 
 			// Make ourTen NAN, such that it is obvious if uninitialized data is being used
-			ourTen.add_(NAN);
+			if (IsSharded()) {
+				// Pages are placed on the node of the thread that first touches them, so each shard's node fills its own rows
+				// Rows are copied from a filled one, as torch's own fill would run on threads of any node
+				Tensor row = torch::empty(ourTen.slice(0, 0, 1).sizes(), ourTen.options());
+				if (ourTen.is_floating_point()) {
+					row.fill_(NAN);
+				} else {
+					row.zero_();
+				}
 
-			RG_PARA_ASSERT(ourTen.size(0) == maxSize);
-		} else {
-			// We already have data
-			if (overflow > 0) {
-				auto fromData = ourTen.slice(0, overflow, curSize).clone();
-				auto toView = ourTen.slice(0, 0, curSize - overflow);
-				toView.copy_(fromData);
+				std::vector<_ShardRun> runs = {};
+				for (int i = 0; i < shardCores.size(); i++)
+					runs.push_back({ i, i * shardRows, RS_MIN((i + 1) * shardRows, maxSize) });
 
-				RG_PARA_ASSERT(ourTen[curSize - overflow - 1].equal(ourTen[curSize - 1]));
+				size_t rowBytes = row.nbytes();
+				auto rowData = (const byte*)row.data_ptr();
+				auto ourData = (byte*)ourTen.data_ptr();
+				_RunOnShards(runs, [&](int64_t start, int64_t end) {
+					for (int64_t j = start; j < end; j++)
+						memcpy(ourData + j * rowBytes, rowData, rowBytes);
+				});
+			} else if (IsSpilled()) {
+				// Filling would write out the whole file, it already reads as zeros
+			} else if (ourTen.is_floating_point()) {
+				ourTen.fill_(NAN);
+			} else {
+				ourTen.zero_();
 			}
+
+			RG_PARA_ASSERT(ourTen.size(0) == maxSize);
 		}
 
-		auto ourTenInsertView = ourTen.slice(0, startIdx, endIdx);
-		ourTenInsertView.copy_(addTen);
-		RG_PARA_ASSERT(ourTen[endIdx - 1].equal(addTen[addTen.size(0) - 1]));
+		// Write into the ring, starting from the oldest data
+		// If we pass the end, the rest wraps around to the start
+		int64_t firstAmount = RS_MIN(addAmount, maxSize - writeIdx);
+		if (IsSharded()) {
+			// Each shard's rows are written by its own node
+			addTen = addTen.cpu().contiguous();
+
+			std::vector<_ShardRun> runs = {};
+			for (int64_t i = 0; i < addAmount;) {
+				int64_t ringIdx = (writeIdx + i) % maxSize;
+				int shard = ringIdx / shardRows;
+				int64_t runAmount = RS_MIN(addAmount - i, RS_MIN((shard + 1) * shardRows, maxSize) - ringIdx);
+				runs.push_back({ shard, i, i + runAmount });
+				i += runAmount;
+			}
+
+			size_t rowBytes = ourTen.nbytes() / maxSize;
+			auto addData = (const byte*)addTen.data_ptr();
+			auto ourData = (byte*)ourTen.data_ptr();
+			int64_t writeIdx = this->writeIdx;
+			_RunOnShards(runs, [&](int64_t start, int64_t end) {
+				// Runs never wrap around
+				int64_t ringStart = (writeIdx + start) % maxSize;
+				memcpy(ourData + ringStart * rowBytes, addData + start * rowBytes, (end - start) * rowBytes);
+			});
+		} else {
+			ourTen.slice(0, writeIdx, writeIdx + firstAmount).copy_(addTen.slice(0, 0, firstAmount));
+			if (firstAmount < addAmount)
+				ourTen.slice(0, 0, addAmount - firstAmount).copy_(addTen.slice(0, firstAmount, addAmount));
+		}
 	}
 
-	curSize = RS_MIN(curSize + _data.begin()->size(0), maxSize);
+	writeIdx = (writeIdx + addAmount) % maxSize;
+	curSize = RS_MIN(curSize + addAmount, maxSize);
 
 #ifdef RG_PARANOID_MODE
 	// Make sure tensors are all the right size
@@ -75,11 +278,11 @@ void RLGPC::ExperienceBuffer::SubmitExperience(ExperienceTensors& _data) {
 		RG_PARA_ASSERT(t.size(0) == maxSize);
 
 	// Make sure our calculation of rewards matches the target
-	RG_PARA_ASSERT(data.rewards.slice(0, 0, curSize).equal(rewardsTarget));
+	RG_PARA_ASSERT(_GetOrdered(data.rewards).cpu().equal(rewardsTarget.cpu()));
 
 	// Make sure that the debug counters go up
 	// Games are merged together, meaning the number can reset back down, but never twice in a row
-	auto debugCounters = TENSOR_TO_ILIST(data.debugCounters.slice(0, 0, curSize).cpu());
+	auto debugCounters = TENSOR_TO_ILIST(_GetOrdered(data.debugCounters).cpu());
 	for (int i = 2; i < debugCounters.size(); i++) {
 		if (debugCounters[i] <= debugCounters[i - 1])
 			if (debugCounters[i - 1] <= debugCounters[i - 2])
@@ -88,40 +291,368 @@ void RLGPC::ExperienceBuffer::SubmitExperience(ExperienceTensors& _data) {
 #endif
 }
 
-RLGPC::ExperienceBuffer::SampleSet RLGPC::ExperienceBuffer::_GetSamples(const int64_t* indices, size_t size) const {
-	
-	// TODO: Slow, use blob
-	Tensor tIndices = torch::tensor(IList(indices, indices + size));
+RLGPC::ExperienceBuffer::SampleSet RLGPC::ExperienceBuffer::_GetSamples(torch::Tensor indices, bool pinned) const {
+	auto fnSelect = [&](const Tensor& from) -> Tensor {
+		if (pinned) {
+			// Gather directly into pinned memory, so that it can be copied to the GPU asynchronously
+			auto sizes = from.sizes().vec();
+			sizes[0] = indices.size(0);
+			Tensor out = torch::empty(sizes, from.options().pinned_memory(true));
+			return torch::index_select_out(out, from, 0, indices);
+		} else {
+			return torch::index_select(from, 0, indices);
+		}
+	};
+
+	if (IsSharded()) {
+		// Batches have the indices of each shard together (see _StratifyIndices()), so each shard's node gathers its own rows
+		auto indexData = indices.data_ptr<int64_t>();
+		int64_t count = indices.size(0);
+
+		std::vector<_ShardRun> runs = {};
+		for (int64_t i = 0; i < count;) {
+			int shard = indexData[i] / shardRows;
+			int64_t end = i + 1;
+			while (end < count && indexData[end] / shardRows == shard)
+				end++;
+			runs.push_back({ shard, i, end });
+			i = end;
+		}
+
+		SampleSet result;
+		std::pair<const Tensor*, Tensor*> tensors[] = {
+			{ &data.actions, &result.actions }, { &data.logProbs, &result.logProbs }, { &data.states, &result.states },
+			{ &data.values, &result.values }, { &data.advantages, &result.advantages }, { &data.isWeights, &result.isWeights }
+		};
+		for (auto& pair : tensors) {
+			auto sizes = pair.first->sizes().vec();
+			sizes[0] = count;
+			*pair.second = torch::empty(sizes, pair.first->options().pinned_memory(pinned));
+		}
+
+		_RunOnShards(runs, [&](int64_t start, int64_t end) {
+			for (auto& pair : tensors) {
+				size_t rowBytes = pair.first->nbytes() / maxSize;
+				auto from = (const byte*)pair.first->data_ptr();
+				auto to = (byte*)pair.second->data_ptr();
+				for (int64_t i = start; i < end; i++)
+					memcpy(to + i * rowBytes, from + indexData[i] * rowBytes, rowBytes);
+			}
+		});
+		return result;
+	}
+
+	if (IsSpilled()) {
+		// Rows are read in order, so reads of nearby rows are merged, and rows already read are still in memory for the next ones
+		// Samples of a batch are learned from together, so their order doesn't matter
+		indices = std::get<0>(indices.sort());
+		_PrefetchSpilledRows(indices.data_ptr<int64_t>(), indices.size(0));
+	}
 
-	// TODO: Reptitive
 	SampleSet result;
-	result.actions = torch::index_select(data.actions, 0, tIndices);
-	result.logProbs = torch::index_select(data.logProbs, 0, tIndices);
-	result.states = torch::index_select(data.states, 0, tIndices);
-	result.values = torch::index_select(data.values, 0, tIndices);
-	result.advantages = torch::index_select(data.advantages, 0, tIndices);
+	std::pair<const Tensor*, Tensor*> tensors[] = {
+		{ &data.actions, &result.actions }, { &data.logProbs, &result.logProbs }, { &data.states, &result.states },
+		{ &data.values, &result.values }, { &data.advantages, &result.advantages }, { &data.isWeights, &result.isWeights }
+	};
+	JobSystem::ParallelFor(storeOnDevice ? NULL : jobSystem, 0, std::size(tensors), 1,
+		[&](int64_t start, int64_t end) {
+			for (int64_t i = start; i < end; i++)
+				*tensors[i].second = fnSelect(*tensors[i].first);
+		}
+	);
 	return result;
 }
 
-std::vector<RLGPC::ExperienceBuffer::SampleSet> RLGPC::ExperienceBuffer::GetAllBatchesShuffled(int64_t batchSize) {
+void RLGPC::ExperienceBuffer::_PrefetchSpilledRows(const int64_t* sortedIndices, int64_t count) const {
+	// Rows closer than this are read together with the rows between them, as one large read is faster than many small ones
+	constexpr int64_t MAX_GAP_BYTES = 256 * 1024;
+
+	for (const Tensor* t : { &data.actions, &data.logProbs, &data.states, &data.values, &data.advantages, &data.isWeights }) {
+		int64_t rowBytes = t->nbytes() / maxSize;
+		auto tData = (const byte*)t->data_ptr();
+		for (int64_t i = 0; i < count;) {
+			int64_t start = sortedIndices[i], end = start + 1;
+			for (i++; i < count && (sortedIndices[i] - end) * rowBytes <= MAX_GAP_BYTES; i++)
+				end = sortedIndices[i] + 1;
+			SpillFile::Prefetch(tData + start * rowBytes, (end - start) * rowBytes);
+		}
+	}
+}
 
-	// Make list of shuffled sample indices
-	int64_t* indices = new int64_t[curSize];
-	std::iota(indices, indices + curSize, 0); // Fill ascending indices
-	std::shuffle(indices, indices + curSize, rng);
+void RLGPC::ExperienceBuffer::_FinishSamples(SampleSet& samples) const {
+	if (obsType != OBSStorageType::FLOAT)
+		samples.states = _DecompressOBS(samples.states.to(device));
+	samples.actions = samples.actions.to(device).to(torch::kInt64);
+}
+
+torch::Tensor RLGPC::ExperienceBuffer::_StratifyIndices(torch::Tensor indices, int64_t batchSize) const {
+	int numShards = shardCores.size();
+	int64_t count = indices.size(0);
+	int64_t numBatches = count / batchSize;
+	if (numBatches == 0)
+		return indices;
+
+	// Each shard's indices, still in shuffled order
+	auto inData = indices.data_ptr<int64_t>();
+	std::vector<std::vector<int64_t>> shardIndices = std::vector<std::vector<int64_t>>(numShards);
+	for (int64_t i = 0; i < count; i++)
+		shardIndices[inData[i] / shardRows].push_back(inData[i]);
+
+	Tensor result = torch::empty({ count }, torch::kInt64);
+	auto outData = result.data_ptr<int64_t>();
+	int64_t outIdx = 0;
+	std::vector<size_t> taken = std::vector<size_t>(numShards, 0);
+	for (int64_t batch = 0; batch < numBatches; batch++) {
+		// Each shard's share of the batches so far is proportional to its size
+		// Shares are rounded by largest remainder, so they always add up to the batches' size
+		int64_t targetTotal = (batch + 1) * batchSize;
+		std::vector<size_t> quotas = std::vector<size_t>(numShards);
+		std::vector<std::pair<double, int>> remainders = {};
+		int64_t quotaTotal = 0;
+		for (int i = 0; i < numShards; i++) {
+			double exactQuota = shardIndices[i].size() * ((double)targetTotal / count);
+			quotas[i] = (size_t)exactQuota;
+			quotaTotal += quotas[i];
+			remainders.push_back({ exactQuota - quotas[i], i });
+		}
+		std::sort(remainders.rbegin(), remainders.rend());
+		for (int i = 0; quotaTotal < targetTotal && i < numShards; i++, quotaTotal++)
+			quotas[remainders[i].second]++;
+
+		for (int i = 0; i < numShards; i++)
+			for (; taken[i] < quotas[i]; taken[i]++)
+				outData[outIdx++] = shardIndices[i][taken[i]];
+	}
+
+	// Leftovers that don't make a full batch
+	for (int i = 0; i < numShards; i++)
+		for (; taken[i] < shardIndices[i].size(); taken[i]++)
+			outData[outIdx++] = shardIndices[i][taken[i]];
+
+	return result;
+}
+
+torch::Tensor RLGPC::ExperienceBuffer::_GetShuffledIndices(int64_t numNewest, int64_t batchSize) {
+	if (IsSharded() && batchSize > 0)
+		return _StratifyIndices(_GetShuffledIndices(numNewest), batchSize);
+
+	if (numNewest > 0 && numNewest < curSize) {
+		// The newest samples end right before writeIdx, and can wrap around from the start to the end
+		auto options = torch::TensorOptions().dtype(torch::kInt64).device(storeOnDevice ? device : torch::Device(torch::kCPU));
+		Tensor tIndices = (torch::arange(numNewest, options) + (writeIdx - numNewest + maxSize)).remainder_(maxSize);
+		if (storeOnDevice) {
+			return tIndices.index_select(0, torch::randperm(numNewest, options));
+		} else {
+			int64_t* indices = tIndices.data_ptr<int64_t>();
+			std::shuffle(indices, indices + numNewest, rng);
+			return tIndices;
+		}
+	}
+
+	// The ring is always filled from the start, so the stored samples are always at [0, curSize), just not in order
+	// Since we shuffle anyway, we can use these physical indices directly
+	if (storeOnDevice) {
+		// Shuffle on the device so the indices never need to be transferred
+		return torch::randperm(curSize, torch::TensorOptions().dtype(torch::kInt64).device(device));
+	} else {
+		Tensor tIndices = torch::empty({ curSize }, torch::kInt64);
+		int64_t* indices = tIndices.data_ptr<int64_t>();
+		std::iota(indices, indices + curSize, 0); // Fill ascending indices
+		std::shuffle(indices, indices + curSize, rng);
+		return tIndices;
+	}
+}
+
+std::vector<RLGPC::ExperienceBuffer::SampleSet> RLGPC::ExperienceBuffer::GetAllBatchesShuffled(int64_t batchSize) {
+	Tensor tIndices = _GetShuffledIndices(0, batchSize);
 
 	// Get a sample set from each of the batches
 	std::vector<SampleSet> result;
 	for (int64_t startIdx = 0; startIdx + batchSize <= curSize; startIdx += batchSize) {
-		result.push_back(_GetSamples(indices + startIdx, batchSize));
+		SampleSet samples = _GetSamples(tIndices.slice(0, startIdx, startIdx + batchSize));
+		_FinishSamples(samples);
+		result.push_back(samples);
 	}
 
-	delete[] indices;
 	return result;
 }
 
+RLGPC::ExperienceBuffer::BatchIterator RLGPC::ExperienceBuffer::GetBatchIteratorShuffled(int64_t batchSize, int64_t numNewest) {
+	return BatchIterator(this, _GetShuffledIndices(numNewest, batchSize), batchSize);
+}
+
+RLGPC::ExperienceBuffer::BatchIterator::BatchIterator(const ExperienceBuffer* buffer, torch::Tensor indices, int64_t batchSize) :
+	buffer(buffer), indices(indices), batchSize(batchSize) {
+	_Prefetch();
+}
+
+void RLGPC::ExperienceBuffer::BatchIterator::_Prefetch() {
+	if (nextStartIdx + batchSize > indices.size(0))
+		return;
+
+	auto batchIndices = indices.slice(0, nextStartIdx, nextStartIdx + batchSize);
+	nextStartIdx += batchSize;
+
+	auto buffer = this->buffer;
+	prefetched = std::async(std::launch::async, [buffer, batchIndices] {
+		RG_NOGRAD;
+		Timer prepTimer = {};
+
+		// If our buffer is on the CPU but we learn on the GPU, we stage the batch in pinned memory and start uploading it now
+		bool upload = buffer->device.is_cuda() && !buffer->storeOnDevice;
+
+		PrefetchResult result;
+		result.batch = buffer->_GetSamples(batchIndices, upload);
+		if (upload) {
+			for (auto t : { &result.batch.actions, &result.batch.logProbs, &result.batch.states, &result.batch.values, &result.batch.advantages, &result.batch.isWeights })
+				*t = t->to(buffer->device, true);
+		}
+		buffer->_FinishSamples(result.batch);
+
+		result.prepTime = prepTimer.Elapsed();
+		return result;
+	});
+}
+
+bool RLGPC::ExperienceBuffer::BatchIterator::Next(SampleSet& outBatch) {
+	if (!prefetched.valid())
+		return false;
+
+	Timer waitTimer = {};
+	PrefetchResult result = prefetched.get();
+	totalWaitTime += waitTimer.Elapsed();
+	totalPrepTime += result.prepTime;
+
+	outBatch = result.batch;
+
+	// Start gathering the next batch while this one is used
+	_Prefetch();
+	return true;
+}
+
 void RLGPC::ExperienceBuffer::Clear() {
-	*this = ExperienceBuffer(maxSize, seed, device);
+	ExperienceBuffer cleared = ExperienceBuffer(maxSize, seed, device, storeOnDevice, obsType, obsScales, hugePages, actionAmount, shardCores, spillFolder);
+	cleared.mirrorFraction = mirrorFraction;
+	cleared.mirrorOBSIndices = mirrorOBSIndices;
+	cleared.mirrorOBSSigns = mirrorOBSSigns;
+	cleared.mirrorActions = mirrorActions;
+	*this = std::move(cleared);
+}
+
+RLGPC::ExperienceBuffer::Snapshot RLGPC::ExperienceBuffer::MakeSnapshot() const {
+	RG_NOGRAD;
+
+	Snapshot snapshot = {};
+
+	// Tensors are stored as raw bytes, their types and sizes go in a JSON entry
+	nlohmann::json jInfo = {};
+	auto& jTensors = jInfo["tensors"] = nlohmann::json::array();
+	if (curSize > 0) {
+		for (const Tensor& t : data) {
+			snapshot.tensors.push_back(_GetOrdered(t).to(torch::Device(torch::kCPU), t.scalar_type(), false, true).contiguous());
+
+			nlohmann::json jTensor = {};
+			jTensor["dtype"] = c10::toString(t.scalar_type());
+			jTensor["shape"] = snapshot.tensors.back().sizes().vec();
+			jTensors.push_back(jTensor);
+		}
+	}
+
+	std::stringstream rngStream;
+	rngStream << rng;
+	jInfo["rng"] = rngStream.str();
+
+	snapshot.infoJSON = jInfo.dump();
+	return snapshot;
+}
+
+void RLGPC::ExperienceBuffer::AddSnapshotToFile(CheckpointFileWriter& writer, const Snapshot& snapshot) {
+	writer.AddBytes(std::string(FILE_ENTRY_PREFIX) + "info", snapshot.infoJSON.data(), snapshot.infoJSON.size());
+
+	const char* const* name = ExperienceTensors::NAMES;
+	for (const Tensor& t : snapshot.tensors)
+		writer.AddBytes(std::string(FILE_ENTRY_PREFIX) + *(name++), t.data_ptr(), t.nbytes());
+}
+
+bool RLGPC::ExperienceBuffer::LoadFromFile(const CheckpointFile& file, int obsSize) {
+	RG_NOGRAD;
+
+	auto infoEntry = file.Find(std::string(FILE_ENTRY_PREFIX) + "info");
+	if (!infoEntry)
+		return false;
+
+	nlohmann::json jInfo = nlohmann::json::parse(std::string((const char*)infoEntry->data, infoEntry->size));
+	auto& jTensors = jInfo["tensors"];
+
+	ExperienceTensors loaded = {};
+	if (!jTensors.empty()) {
+		if (jTensors.size() != std::size(ExperienceTensors::NAMES)) {
+			RG_LOG("WARNING: Experience buffer in " << file.path << " has " << jTensors.size() << " tensors, expected " << std::size(ExperienceTensors::NAMES));
+			return false;
+		}
+
+		const char* const* name = ExperienceTensors::NAMES;
+		auto jTensor = jTensors.begin();
+		for (auto itr = loaded.begin(); itr != loaded.end(); itr++, jTensor++, name++) {
+			std::string dtypeName = (*jTensor)["dtype"];
+			std::vector<int64_t> shape = (*jTensor)["shape"];
+
+			torch::ScalarType dtype = torch::kFloat;
+			for (auto candidate : { torch::kFloat, torch::kHalf, torch::kBFloat16, torch::kInt16, torch::kInt32, torch::kInt64, torch::kUInt8 })
+				if (dtypeName == c10::toString(candidate))
+					dtype = candidate;
+
+			auto& entry = file.Get(std::string(FILE_ENTRY_PREFIX) + *name, CheckpointFile::EntryType::BYTES);
+			Tensor t = torch::from_blob((void*)entry.data, shape, torch::TensorOptions().dtype(dtype));
+			if (t.nbytes() != entry.size)
+				RG_ERR_CLOSE("ExperienceBuffer::LoadFromFile(): Entry \"" << *name << "\" of " << file.path << " has " << entry.size << " bytes, expected " << t.nbytes());
+
+			*itr = t;
+		}
+
+		// States must match how we store them, everything else is narrowed the same way for every config
+		torch::ScalarType statesType;
+		switch (obsType) {
+		case OBSStorageType::HALF: statesType = torch::kHalf; break;
+		case OBSStorageType::BF16: statesType = torch::kBFloat16; break;
+		case OBSStorageType::INT16: statesType = torch::kInt16; break;
+		default: statesType = torch::kFloat;
+		}
+
+		if (loaded.states.scalar_type() != statesType) {
+			RG_LOG("WARNING: Experience buffer in " << file.path << " stores states as " << loaded.states.scalar_type() << ", which doesn't match config.expBufferOBSType");
+			return false;
+		}
+
+		if (loaded.states.size(1) != obsSize) {
+			RG_LOG("WARNING: Experience buffer in " << file.path << " has an OBS size of " << loaded.states.size(1) << ", but the OBS size is " << obsSize);
+			return false;
+		}
+		loaded.actions = loaded.actions.to(actionType);
+	}
+
+	Clear();
+	if (loaded.states.defined()) {
+		// Tensors point into the file's mapping, which SubmitExperience() copies from
+		SubmitExperience(loaded, true);
+	}
+
+	std::stringstream rngStream = std::stringstream(jInfo["rng"].get<std::string>());
+	rngStream >> rng;
+	return true;
+}
+
+void RLGPC::ExperienceBuffer::GetMetrics(Report& report) const {
+	constexpr double MB = 1024 * 1024;
+
+	int64_t totalBytes = 0;
+	const char* const* name = ExperienceTensors::NAMES;
+	for (auto itr = data.begin(); itr != data.end(); itr++, name++) {
+		int64_t bytes = itr->defined() ? itr->nbytes() : 0;
+		report[std::string("Exp Buffer ") + *name + " MB"] = bytes / MB;
+		totalBytes += bytes;
+	}
+	report["Exp Buffer MB"] = totalBytes / MB;
 }
 
 Tensor RLGPC::ExperienceBuffer::_Concat(torch::Tensor t1, torch::Tensor t2, int64_t size) {
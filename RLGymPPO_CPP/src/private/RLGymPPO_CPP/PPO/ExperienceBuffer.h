@@ -1,6 +1,12 @@
 #pragma once
 #include <RLGymPPO_CPP/Lists.h>
+#include <RLGymPPO_CPP/LearnerConfig.h>
 #include "../FrameworkTorch.h"
+#include <RLGymPPO_CPP/Util/Report.h>
+#include "../Util/CheckpointFile.h"
+#include <RLGymPPO_CPP/Threading/JobSystem.h>
+#include "DiscretePolicy.h"
+#include <future>
 
 namespace RLGPC {
 
@@ -12,10 +18,22 @@ namespace RLGPC {
 			debugCounters,
 #endif
 
-			nextStates, dones, truncated, values, advantages;
+			dones, truncated, values, advantages,
+			isWeights; // Importance weights of the PPO loss, one unless the step is from an older policy (see LearnerConfig::offPolicyCorrection)
 
 		torch::Tensor* begin() { return &states; }
-		torch::Tensor* end() { return &advantages + 1; }
+		torch::Tensor* end() { return &isWeights + 1; }
+		const torch::Tensor* begin() const { return &states; }
+		const torch::Tensor* end() const { return &isWeights + 1; }
+
+		// Names of each tensor, in order
+		constexpr static const char* NAMES[] = {
+			"States", "Actions", "Log Probs", "Rewards",
+#ifdef RG_PARANOID_MODE
+			"Debug Counters",
+#endif
+			"Dones", "Truncated", "Values", "Advantages", "IS Weights"
+		};
 	};
 
 	// https://github.com/AechPro/rlgym-ppo/blob/main/rlgym_ppo/ppo/experience_buffer.py
@@ -25,28 +43,181 @@ namespace RLGPC {
 		torch::Device device;
 		int seed;
 
+		// Keep all experience on the device, so that minibatches can be gathered there
+		// Otherwise, experience is stored on the CPU
+		bool storeOnDevice;
+
+		// States are stored as this type, and converted back to float when batches are gathered
+		OBSStorageType obsType;
+		// Max absolute value of each OBS feature, only for INT16
+		FList obsScales;
+		// obsScales / INT16_MAX, on the device
+		torch::Tensor obsDecompressScales;
+
+		// Pages our tensors are backed by, only if stored on the CPU
+		HugePageMode hugePages;
+
+		// Actions are stored as the narrowest integer type that fits actionAmount (int32 if it is 0), and dones and truncateds as bytes
+		// Gathered actions are converted to int64 once their batch is on the device
+		int actionAmount;
+		torch::ScalarType actionType;
+
+		// Fraction of submitted samples that are mirrored left-right (see LearnerConfig::mirrorFraction), set with SetMirror()
+		float mirrorFraction = 0;
+		// Source feature and sign of each mirrored OBS feature, and the mirror of each action, on the device
+		torch::Tensor mirrorOBSIndices, mirrorOBSSigns, mirrorActions;
+
+		// Cores of the NUMA node of each shard, if the buffer is split across NUMA nodes (see LearnerConfig::expBufferNUMAShards)
+		// Shard i is rows [i * shardRows, (i + 1) * shardRows) of every tensor, which are first touched, written and gathered by threads on its node
+		std::vector<IList> shardCores;
+		int64_t shardRows;
+
+		// If set, each tensor of an unsharded batch is gathered as its own job (see LearnerConfig::jobThreads)
+		JobSystem* jobSystem = NULL;
+
+		// If set, our tensors are backed by spill files in this folder instead of memory (see LearnerConfig::expBufferSpillFolder)
+		// Only used if stored on the CPU, and overrides hugePages and shardCores
+		std::filesystem::path spillFolder;
+
 		ExperienceTensors data;
 
+		// Data is stored as a ring buffer
+		// New data is written at writeIdx, which is also the oldest data once the buffer is full
 		int64_t curSize = 0;
 		int64_t maxSize;
+		int64_t writeIdx = 0;
 
 		std::default_random_engine rng;
 
-		ExperienceBuffer(int64_t maxSize, int seed, torch::Device device);
+		ExperienceBuffer(
+			int64_t maxSize, int seed, torch::Device device, bool storeOnDevice = false,
+			OBSStorageType obsType = OBSStorageType::FLOAT, const FList& obsScales = {},
+			HugePageMode hugePages = HugePageMode::NONE, int actionAmount = 0, const std::vector<IList>& shardCores = {},
+			std::filesystem::path spillFolder = {}
+		);
+
+		bool IsSharded() const {
+			return shardCores.size() > 1;
+		}
+
+		bool IsSpilled() const {
+			return !spillFolder.empty();
+		}
+
+		torch::Device GetStorageDevice() const {
+			return storeOnDevice ? device : torch::Device(torch::kCPU);
+		}
+
+		// If narrowed, data is already stored as our types (see _NarrowExperience())
+		void SubmitExperience(ExperienceTensors& data, bool narrowed = false);
+
+		// Mirror this fraction of experience left-right before it is submitted, from the OBS builder's and action parser's mirror maps
+		void SetMirror(float fraction, const IList& obsSourceIndices, const FList& obsSigns, const IList& actionMap);
+
+		// Replaces a random mirrorFraction of the samples with their mirror images, before they are submitted
+		// Their log probs become those of the mirrored actions, from the policy that collected them, so PPO's ratios stay correct
+		// Values and advantages stay the same, as the mirrored step is just as good
+		// Each sample is only mirrored once, so it stays the same step for every epoch that learns from it
+		void MirrorExperience(ExperienceTensors& data, DiscretePolicy* policy, int64_t chunkSize);
 
-		void SubmitExperience(ExperienceTensors& data);
+		// Makes an empty tensor that can hold maxSize rows of these sizes, backed by a spill file or huge pages if we use them
+		torch::Tensor _MakeStorage(c10::IntArrayRef rowSizes, torch::ScalarType dtype) const;
+
+		// Rows [start, end) of work that only touches one shard
+		struct _ShardRun {
+			int shard;
+			int64_t start, end;
+		};
+
+		// Runs fn(start, end) over every run, with each run split between threads pinned to its shard's node
+		void _RunOnShards(const std::vector<_ShardRun>& runs, const std::function<void(int64_t start, int64_t end)>& fn) const;
+
+		// Converts each tensor of submitted experience to the type we store it as
+		void _NarrowExperience(ExperienceTensors& data) const;
+
+		torch::Tensor _CompressOBS(torch::Tensor states) const;
+		// States must be on the device
+		torch::Tensor _DecompressOBS(torch::Tensor states) const;
 
 		struct SampleSet {
-			torch::Tensor actions, logProbs, states, values, advantages;
+			torch::Tensor actions, logProbs, states, values, advantages, isWeights;
 		};
-		SampleSet _GetSamples(const int64_t* indices, size_t size) const;
+		// If pinned, samples are gathered into pinned memory
+		SampleSet _GetSamples(torch::Tensor indices, bool pinned = false) const;
+
+		// Starts reading the rows of sorted indices from our spill files, with rows close together merged into one read
+		void _PrefetchSpilledRows(const int64_t* sortedIndices, int64_t count) const;
+
+		// Decompresses states and widens actions of samples on the device
+		void _FinishSamples(SampleSet& samples) const;
 
 		// Not const because it uses our random engine
+		// If numNewest is not 0, only the indices of the newest numNewest samples are shuffled
+		// If sharded and batchSize is not 0, each batch takes its share of every shard, and the indices of each shard are together
+		torch::Tensor _GetShuffledIndices(int64_t numNewest = 0, int64_t batchSize = 0);
+
+		// Reorders shuffled indices so that each batch is stratified across shards
+		torch::Tensor _StratifyIndices(torch::Tensor indices, int64_t batchSize) const;
+
+		// NOTE: Gathers every batch at once, which makes a full copy of the buffer
+		// Use GetBatchIteratorShuffled() to only gather what is needed
 		std::vector<SampleSet> GetAllBatchesShuffled(int64_t batchSize);
 
+		// Gathers shuffled batches one at a time
+		// The next batch is gathered on another thread while the current one is being used
+		// If learning on the GPU with the buffer on the CPU, the next batch is also staged in pinned memory and uploaded ahead of time
+		// NOTE: The buffer must not be modified while iterating
+		class BatchIterator {
+		public:
+			const ExperienceBuffer* buffer;
+			torch::Tensor indices;
+			int64_t batchSize;
+			int64_t nextStartIdx = 0;
+
+			struct PrefetchResult {
+				SampleSet batch;
+				double prepTime;
+			};
+			std::future<PrefetchResult> prefetched;
+
+			// Total time spent gathering and uploading batches (on the prefetch thread)
+			double totalPrepTime = 0;
+			// Total time spent waiting for batches that were not ready yet
+			double totalWaitTime = 0;
+
+			BatchIterator(const ExperienceBuffer* buffer, torch::Tensor indices, int64_t batchSize);
+
+			// Returns false once there are no batches left
+			bool Next(SampleSet& outBatch);
+
+			void _Prefetch();
+		};
+		BatchIterator GetBatchIteratorShuffled(int64_t batchSize, int64_t numNewest = 0);
+
 		void Clear();
 
-		
+		// Copy of all stored data and our random engine, for saving while we keep learning
+		struct Snapshot {
+			std::vector<torch::Tensor> tensors; // Each of our tensors on the CPU, from oldest to newest
+			std::string infoJSON; // Types and sizes of the tensors, and the state of our random engine
+		};
+		Snapshot MakeSnapshot() const;
+
+		constexpr static const char* FILE_ENTRY_PREFIX = "exp_buffer/";
+
+		// Adds the entries of a snapshot, which must stay valid until the writer saves
+		static void AddSnapshotToFile(CheckpointFileWriter& writer, const Snapshot& snapshot);
+
+		// Replaces our data and random engine with a snapshot saved by AddSnapshotToFile()
+		// Returns false (keeping our data) if the file has no snapshot, or if it was stored with different types or OBS size
+		bool LoadFromFile(const CheckpointFile& file, int obsSize);
+
+		// Adds the memory used by each of our tensors
+		void GetMetrics(Report& report) const;
+
+		// Get all stored data of a tensor from oldest to newest
+		// NOTE: Makes a copy if the data wraps around
+		torch::Tensor _GetOrdered(torch::Tensor t) const;
 
 		// Combine two tensors into one, removing older data if needed to fit target size
 		static torch::Tensor _Concat(torch::Tensor t1, torch::Tensor t2, int64_t size);
@@ -0,0 +1,67 @@
+#include "FusedLinear.h"
+
+#include <torch/nn/modules/linear.h>
+#include <torch/nn/modules/activation.h>
+#include <torch/csrc/autograd/custom_function.h>
+
+using namespace torch::autograd;
+
+struct _LinearReLUFunction : public Function<_LinearReLUFunction> {
+	static torch::Tensor forward(AutogradContext* ctx, torch::Tensor input, torch::Tensor weight, torch::Tensor bias) {
+		auto output = at::_addmm_activation(bias, input, weight.t());
+		ctx->save_for_backward({ input, weight, output });
+		return output;
+	}
+
+	static variable_list backward(AutogradContext* ctx, variable_list gradOutputs) {
+		auto saved = ctx->get_saved_variables();
+		auto input = saved[0], weight = saved[1], output = saved[2];
+
+		// Gradient through the ReLU, which is zero wherever its output is
+		auto grad = at::threshold_backward(gradOutputs[0], output, 0);
+
+		torch::Tensor gradInput, gradWeight, gradBias;
+		if (ctx->needs_input_grad(0))
+			gradInput = grad.mm(weight);
+		if (ctx->needs_input_grad(1))
+			gradWeight = grad.t().mm(input);
+		if (ctx->needs_input_grad(2))
+			gradBias = grad.sum(0);
+
+		return { gradInput, gradWeight, gradBias };
+	}
+};
+
+torch::Tensor RLGPC::FusedLinear::LinearReLU(torch::Tensor input, torch::Tensor weight, torch::Tensor bias) {
+	// Autocast doesn't know about our function, so cast to what it would have run nn::Linear in
+	bool autocast = input.is_cuda() ? at::autocast::is_enabled() : (input.is_cpu() && at::autocast::is_cpu_enabled());
+	if (autocast) {
+		auto castType = input.is_cuda() ? at::autocast::get_autocast_gpu_dtype() : at::autocast::get_autocast_cpu_dtype();
+		input = input.to(castType);
+		weight = weight.to(castType);
+		bias = bias.to(castType);
+	}
+
+	// The GEMM is 2D, so any leading dimensions are flattened into rows
+	auto outSizes = input.sizes().vec();
+	outSizes.back() = weight.size(0);
+
+	auto output = _LinearReLUFunction::apply(input.reshape({ -1, input.size(-1) }), weight, bias);
+	return output.view(outSizes);
+}
+
+torch::Tensor RLGPC::FusedLinear::ForwardSeq(torch::nn::Sequential& seq, torch::Tensor input, size_t end, size_t start) {
+	auto itrEnd = seq->begin() + std::min(end, seq->size());
+
+	auto x = input;
+	for (auto itr = seq->begin() + start; itr < itrEnd; itr++) {
+		auto linear = itr->ptr()->as<torch::nn::Linear>();
+		if (linear && itr + 1 != itrEnd && (itr + 1)->ptr()->as<torch::nn::ReLU>()) {
+			x = LinearReLU(x, linear->weight, linear->bias);
+			itr++; // Skip the ReLU
+		} else {
+			x = itr->forward(x);
+		}
+	}
+	return x;
+}
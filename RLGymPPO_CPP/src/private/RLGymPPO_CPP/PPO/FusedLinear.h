@@ -0,0 +1,18 @@
+#pragma once
+#include "../FrameworkTorch.h"
+
+#include <torch/nn/modules/container/sequential.h>
+
+namespace RLGPC {
+	namespace FusedLinear {
+		// relu(input * weight^T + bias) as one GEMM, with the bias and ReLU done in the GEMM's epilogue (cuBLASLt on CUDA)
+		// The activation before the ReLU is never stored, and the backward pass only needs the output
+		// Under autocast, inputs are cast like nn::Linear would be
+		torch::Tensor LinearReLU(torch::Tensor input, torch::Tensor weight, torch::Tensor bias);
+
+		// Same as seq->forward(), but every Linear that is followed by a ReLU is done with LinearReLU()
+		// Only modules [start, end) of seq are run
+		// seq keeps its own modules and parameters, so checkpoints are the same as without fusing
+		torch::Tensor ForwardSeq(torch::nn::Sequential& seq, torch::Tensor input, size_t end = SIZE_MAX, size_t start = 0);
+	}
+}
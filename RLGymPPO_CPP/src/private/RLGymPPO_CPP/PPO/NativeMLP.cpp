@@ -0,0 +1,275 @@
+#include "NativeMLP.h"
+
+#include <RLGymSim_CPP/Utils/SIMD/SIMD.h>
+
+using namespace RLGPC;
+using RLGSC::SIMD::Float8;
+
+constexpr int OUTPUT_BLOCK = NativeMLP::OUTPUT_BLOCK;
+constexpr int ROW_BLOCK = NativeMLP::ROW_BLOCK;
+
+// Computes one OUTPUT_BLOCK of outputs for ROWS rows
+// in: [ROWS][inStride], weights: [inSize][OUTPUT_BLOCK], out: [ROWS][outStride]
+template <int ROWS>
+void _LayerKernel(const float* in, int inStride, int inSize, const float* weights, const float* biases, float* out, int outStride, bool relu) {
+#if defined(__AVX512F__)
+	static_assert(OUTPUT_BLOCK == 16);
+	__m512 acc[ROWS];
+	for (int r = 0; r < ROWS; r++)
+		acc[r] = _mm512_loadu_ps(biases);
+
+	for (int k = 0; k < inSize; k++) {
+		__m512 w = _mm512_loadu_ps(weights + k * OUTPUT_BLOCK);
+		for (int r = 0; r < ROWS; r++)
+			acc[r] = _mm512_fmadd_ps(_mm512_set1_ps(in[r * inStride + k]), w, acc[r]);
+	}
+
+	for (int r = 0; r < ROWS; r++) {
+		if (relu)
+			acc[r] = _mm512_max_ps(acc[r], _mm512_setzero_ps());
+		_mm512_storeu_ps(out + r * outStride, acc[r]);
+	}
+#else
+	// Two Float8s per OUTPUT_BLOCK, which is AVX2, SSE or NEON (see SIMD.h)
+	static_assert(OUTPUT_BLOCK == 16);
+	Float8 accLo[ROWS], accHi[ROWS];
+	for (int r = 0; r < ROWS; r++) {
+		accLo[r] = Float8::Load(biases);
+		accHi[r] = Float8::Load(biases + 8);
+	}
+
+	for (int k = 0; k < inSize; k++) {
+		Float8 wLo = Float8::Load(weights + k * OUTPUT_BLOCK);
+		Float8 wHi = Float8::Load(weights + k * OUTPUT_BLOCK + 8);
+		for (int r = 0; r < ROWS; r++) {
+			Float8 x = in[r * inStride + k];
+			accLo[r] = MulAdd(x, wLo, accLo[r]);
+			accHi[r] = MulAdd(x, wHi, accHi[r]);
+		}
+	}
+
+	for (int r = 0; r < ROWS; r++) {
+		if (relu) {
+			accLo[r] = Max(accLo[r], 0.f);
+			accHi[r] = Max(accHi[r], 0.f);
+		}
+		accLo[r].Store(out + r * outStride);
+		accHi[r].Store(out + r * outStride + 8);
+	}
+#endif
+}
+
+void _LayerForward(const NativeMLP::Layer& layer, const float* in, int inStride, int batchSize, float* out, bool relu) {
+	int outStride = layer.paddedOutSize;
+
+	// Each block of weights is small enough to stay in L1 while we go through all of the rows
+	for (int block = 0; block < layer.paddedOutSize / OUTPUT_BLOCK; block++) {
+		const float* weights = layer.weights.data() + (size_t)block * layer.inSize * OUTPUT_BLOCK;
+		const float* biases = layer.biases.data() + block * OUTPUT_BLOCK;
+		float* blockOut = out + block * OUTPUT_BLOCK;
+
+		int row = 0;
+		for (; row + ROW_BLOCK <= batchSize; row += ROW_BLOCK)
+			_LayerKernel<ROW_BLOCK>(in + (size_t)row * inStride, inStride, layer.inSize, weights, biases, blockOut + (size_t)row * outStride, outStride, relu);
+
+		for (; row < batchSize; row++)
+			_LayerKernel<1>(in + (size_t)row * inStride, inStride, layer.inSize, weights, biases, blockOut + (size_t)row * outStride, outStride, relu);
+	}
+}
+
+void RLGPC::NativeMLP::AddLayer(const float* weights, const float* biases, int inSize, int outSize) {
+	Layer layer = {};
+	layer.inSize = inSize;
+	layer.outSize = outSize;
+	layer.paddedOutSize = ((outSize + OUTPUT_BLOCK - 1) / OUTPUT_BLOCK) * OUTPUT_BLOCK;
+
+	// Padded outputs have zero weights and biases, so they are always zero
+	layer.weights = std::vector<float>((size_t)layer.paddedOutSize * inSize, 0);
+	layer.biases = std::vector<float>(layer.paddedOutSize, 0);
+
+	for (int i = 0; i < outSize; i++) {
+		int block = i / OUTPUT_BLOCK, blockIdx = i % OUTPUT_BLOCK;
+		float* blockWeights = layer.weights.data() + (size_t)block * inSize * OUTPUT_BLOCK;
+		for (int k = 0; k < inSize; k++)
+			blockWeights[k * OUTPUT_BLOCK + blockIdx] = weights[(size_t)i * inSize + k];
+		layer.biases[i] = biases[i];
+	}
+
+	if (layers.empty())
+		inputAmount = inSize;
+	actionAmount = outSize;
+	layers.push_back(layer);
+}
+
+bool RLGPC::NativeMLP::LoadParams(
+	const float* params, size_t numParams, int inputAmount, const IList& layerSizes, int actionAmount,
+	const float* obsScale, const float* obsShift) {
+	IList sizes = { inputAmount };
+	sizes.insert(sizes.end(), layerSizes.begin(), layerSizes.end());
+	sizes.push_back(actionAmount);
+
+	size_t expectedParams = 0;
+	for (int i = 0; i < sizes.size() - 1; i++)
+		expectedParams += (size_t)(sizes[i] + 1) * sizes[i + 1];
+	if (numParams != expectedParams)
+		return false;
+
+	layers.clear();
+	const float* layerParams = params;
+	for (int i = 0; i < sizes.size() - 1; i++) {
+		int inSize = sizes[i], outSize = sizes[i + 1];
+		const float* weights = layerParams;
+		const float* biases = weights + (size_t)inSize * outSize;
+		layerParams = biases + outSize;
+
+		if (i == 0 && obsScale && obsShift) {
+			// Same folding of standardization into the first layer as NativePolicy::Load()
+			// W * (obs * scale + shift) + b = (W * scale) * obs + (W * shift + b)
+			FList foldedWeights = FList((size_t)inSize * outSize), foldedBiases = FList(outSize);
+			for (int j = 0; j < outSize; j++) {
+				float bias = biases[j];
+				for (int k = 0; k < inSize; k++) {
+					float weight = weights[(size_t)j * inSize + k];
+					foldedWeights[(size_t)j * inSize + k] = weight * obsScale[k];
+					bias += weight * obsShift[k];
+				}
+				foldedBiases[j] = bias;
+			}
+			AddLayer(foldedWeights.data(), foldedBiases.data(), inSize, outSize);
+		} else {
+			AddLayer(weights, biases, inSize, outSize);
+		}
+	}
+	return true;
+}
+
+void RLGPC::NativeMLP::Infer(const float* obs, int batchSize, int64_t* outActions, float* outLogProbs, bool deterministic, std::mt19937& rng) const {
+	if (batchSize <= 0)
+		return;
+
+	// Two buffers we alternate between, as layer N writes into the buffer that layer N-1 didn't
+	thread_local std::vector<float> scratch[2];
+
+	const float* in = obs;
+	int inStride = inputAmount;
+	for (int i = 0; i < layers.size(); i++) {
+		auto& layer = layers[i];
+		auto& outBuffer = scratch[i % 2];
+		size_t outSize = (size_t)batchSize * layer.paddedOutSize;
+		if (outBuffer.size() < outSize)
+			outBuffer.resize(outSize);
+
+		bool isOutputLayer = (i == layers.size() - 1);
+		_LayerForward(layer, in, inStride, batchSize, outBuffer.data(), !isOutputLayer);
+
+		in = outBuffer.data();
+		inStride = layer.paddedOutSize;
+	}
+
+	SampleActions(in, inStride, batchSize, actionAmount, outActions, outLogProbs, deterministic, rng);
+}
+
+// Index of the largest of amount values, and that value
+int _ArgMax(const float* values, int amount, float& outMax) {
+	int i = 0;
+	float maxVal = values[0];
+
+	// Find the max vectorized, then the first index that has it
+#if defined(__AVX512F__)
+	if (amount >= 16) {
+		__m512 maxVec = _mm512_loadu_ps(values);
+		for (i = 16; i + 16 <= amount; i += 16)
+			maxVec = _mm512_max_ps(maxVec, _mm512_loadu_ps(values + i));
+		maxVal = _mm512_reduce_max_ps(maxVec);
+	}
+#else
+	if (amount >= 8) {
+		Float8 maxVec = Float8::Load(values);
+		for (i = 8; i + 8 <= amount; i += 8)
+			maxVec = Max(maxVec, Float8::Load(values + i));
+		maxVal = ReduceMax(maxVec);
+	}
+#endif
+	for (; i < amount; i++)
+		maxVal = RS_MAX(maxVal, values[i]);
+
+	outMax = maxVal;
+	for (i = 0; i < amount - 1; i++)
+		if (values[i] == maxVal)
+			break;
+	return i;
+}
+
+// Log-softmax and inverse-CDF sampling of each row in one pass over its logits, fnUniform(row) gives the uniform of a row
+template <typename UniformFn>
+void _SampleActions(
+	const float* logits, int stride, int batchSize, int actionAmount,
+	int64_t* outActions, float* outLogProbs, bool deterministic, UniformFn fnUniform) {
+
+	thread_local std::vector<float> probs;
+	probs.resize(actionAmount);
+
+	for (int row = 0; row < batchSize; row++) {
+		const float* rowLogits = logits + (size_t)row * stride;
+
+		float maxLogit;
+		int bestAction = _ArgMax(rowLogits, actionAmount, maxLogit);
+
+		if (deterministic) {
+			outActions[row] = bestAction;
+			outLogProbs[row] = 0;
+			continue;
+		}
+
+		float expSum = 0;
+		for (int i = 0; i < actionAmount; i++) {
+			probs[i] = expf(rowLogits[i] - maxLogit);
+			expSum += probs[i];
+		}
+
+		float target = fnUniform(row) * expSum;
+		int action = actionAmount - 1;
+		for (int i = 0; i < actionAmount; i++) {
+			target -= probs[i];
+			if (target < 0) {
+				action = i;
+				break;
+			}
+		}
+
+		outActions[row] = action;
+		outLogProbs[row] = rowLogits[action] - maxLogit - logf(expSum);
+	}
+}
+
+void RLGPC::NativeMLP::SampleActions(
+	const float* logits, int stride, int batchSize, int actionAmount, 
+	int64_t* outActions, float* outLogProbs, bool deterministic, std::mt19937& rng) {
+
+	std::uniform_real_distribution<float> dist = std::uniform_real_distribution<float>(0, 1);
+	_SampleActions(
+		logits, stride, batchSize, actionAmount, outActions, outLogProbs, deterministic,
+		[&](int row) { return dist(rng); }
+	);
+}
+
+float RLGPC::NativeMLP::CounterRNG::Uniform(uint64_t seed, uint64_t index) {
+	// SplitMix64 of the index, offset by the seed
+	uint64_t x = seed + (index + 1) * 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	x ^= x >> 31;
+
+	// Top 24 bits, as that is all a float can exactly hold
+	return (x >> 40) * (1.f / (1 << 24));
+}
+
+void RLGPC::NativeMLP::SampleActions(
+	const float* logits, int stride, int batchSize, int actionAmount,
+	int64_t* outActions, float* outLogProbs, bool deterministic, uint64_t seed, uint64_t firstIndex) {
+
+	_SampleActions(
+		logits, stride, batchSize, actionAmount, outActions, outLogProbs, deterministic,
+		[&](int row) { return CounterRNG::Uniform(seed, firstIndex + row); }
+	);
+}
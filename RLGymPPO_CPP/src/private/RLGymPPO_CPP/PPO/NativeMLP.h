@@ -0,0 +1,77 @@
+#pragma once
+#include <RLGymPPO_CPP/Lists.h>
+
+#include <random>
+#include <atomic>
+
+namespace RLGPC {
+	// Torch-free CPU inference of the MLP of a DiscretePolicy (Linear+ReLU layers, then a Linear output layer of action logits)
+	// For the small batches we infer during collection, most of libtorch's time is spent in dispatching, not math
+	// This runs the same MLP with our own kernels, which are vectorized with AVX-512 if we are built with it, and otherwise with SIMD::Float8 (AVX2, SSE or NEON)
+	// NOTE: This is a copy of the policy's weights, it needs to be re-loaded when the policy changes
+	class NativeMLP {
+	public:
+		int inputAmount = 0, actionAmount = 0;
+
+		// Amount of outputs each kernel computes at once, all layers are padded to a multiple of this
+		constexpr static int OUTPUT_BLOCK = 16;
+
+		// Amount of rows each kernel computes at once
+		constexpr static int ROW_BLOCK = 4;
+
+		struct Layer {
+			int inSize, outSize;
+			int paddedOutSize; // outSize, rounded up to a multiple of OUTPUT_BLOCK
+
+			// Packed as [paddedOutSize / OUTPUT_BLOCK][inSize][OUTPUT_BLOCK]
+			// Each kernel reads one contiguous block
+			std::vector<float> weights;
+
+			// [paddedOutSize]
+			std::vector<float> biases;
+		};
+		std::vector<Layer> layers;
+
+		NativeMLP() = default;
+
+		// Adds a layer from row-major [outSize][inSize] weights
+		void AddLayer(const float* weights, const float* biases, int inSize, int outSize);
+
+		// Replaces our layers with those of a DiscretePolicy with these hidden layer sizes, from all of its parameters in order
+		// (the weights, then the biases, of each layer, as written by RemoteProtocol::WriteParams())
+		// If obsScale and obsShift are set ([inputAmount]), the policy's OBS standardization is folded into the first layer
+		// Returns false if the amount of parameters doesn't match the layer sizes
+		bool LoadParams(
+			const float* params, size_t numParams, int inputAmount, const IList& layerSizes, int actionAmount,
+			const float* obsScale = NULL, const float* obsShift = NULL);
+
+		// Infers [batchSize][inputAmount] observations, writing an action and its log probability for each row
+		// NOTE: Thread-safe, scratch memory is per-thread
+		void Infer(const float* obs, int batchSize, int64_t* outActions, float* outLogProbs, bool deterministic, std::mt19937& rng) const;
+
+		// Log-softmax of [batchSize][stride] logits, then chooses an action for each row
+		static void SampleActions(
+			const float* logits, int stride, int batchSize, int actionAmount, 
+			int64_t* outActions, float* outLogProbs, bool deterministic, std::mt19937& rng);
+
+		// Counter-based randomness, the uniform of an index only depends on the seed and that index
+		// Unlike a shared std::mt19937, any amount of threads can draw from one at once, each reserving its own range of indices
+		struct CounterRNG {
+			uint64_t seed = std::random_device()();
+			std::atomic<uint64_t> counter = 0;
+
+			// Reserves amount indices, returns the first
+			uint64_t Reserve(uint64_t amount) {
+				return counter.fetch_add(amount, std::memory_order_relaxed);
+			}
+
+			// From [0, 1)
+			static float Uniform(uint64_t seed, uint64_t index);
+		};
+
+		// Same as above, row i draws from index (firstIndex + i) of the seed
+		static void SampleActions(
+			const float* logits, int stride, int batchSize, int actionAmount,
+			int64_t* outActions, float* outLogProbs, bool deterministic, uint64_t seed, uint64_t firstIndex);
+	};
+}
@@ -0,0 +1,51 @@
+#include "NativePolicy.h"
+
+#include "../FrameworkTorch.h"
+#include <torch/nn/modules/linear.h>
+
+RLGPC::NativePolicy::NativePolicy(DiscretePolicy* policy) {
+	Load(policy);
+}
+
+void RLGPC::NativePolicy::Load(DiscretePolicy* policy) {
+	RG_NOGRAD;
+	layers.clear();
+
+	auto children = policy->seq->children();
+	for (int i = 0; i < children.size(); i++) {
+		auto linear = children[i]->as<torch::nn::Linear>();
+		if (!linear)
+			continue;
+
+		auto weights = linear->weight.detach().to(torch::kCPU, torch::kFloat).contiguous();
+		auto biases = linear->bias.detach().to(torch::kCPU, torch::kFloat).contiguous();
+
+		// Standardization is linear, so it is folded into the first layer and costs nothing
+		// W * (obs * scale + shift) + b = (W * scale) * obs + (W * shift + b)
+		if (layers.empty() && policy->obsStandardization.IsSet()) {
+			auto scale = policy->obsStandardization.scale.to(torch::kCPU, torch::kFloat);
+			auto shift = policy->obsStandardization.shift.to(torch::kCPU, torch::kFloat);
+			biases = (biases + weights.matmul(shift)).contiguous();
+			weights = (weights * scale).contiguous();
+		}
+
+		AddLayer(weights.data_ptr<float>(), biases.data_ptr<float>(), weights.size(1), weights.size(0));
+	}
+
+	if (layers.empty() || inputAmount != policy->inputAmount || actionAmount != policy->actionAmount)
+		RG_ERR_CLOSE("NativePolicy::Load(): Policy has an unsupported architecture");
+}
+
+RLGPC::DiscretePolicy::ActionResult RLGPC::NativePolicy::GetAction(torch::Tensor obs, bool deterministic, std::mt19937& rng) const {
+	assert(obs.is_cpu() && obs.scalar_type() == torch::kFloat && obs.is_contiguous());
+
+	int batchSize = obs.dim() > 1 ? obs.size(0) : 1;
+	auto actions = torch::empty({ batchSize }, torch::kInt64);
+	auto logProbs = torch::empty({ batchSize }, torch::kFloat);
+	Infer(
+		obs.data_ptr<float>(), batchSize, actions.data_ptr<int64_t>(), logProbs.data_ptr<float>(),
+		deterministic, rng
+	);
+
+	return DiscretePolicy::ActionResult{ actions, logProbs };
+}
\ No newline at end of file
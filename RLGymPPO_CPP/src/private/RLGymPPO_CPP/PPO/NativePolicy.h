@@ -0,0 +1,20 @@
+#pragma once
+#include "DiscretePolicy.h"
+#include "NativeMLP.h"
+
+namespace RLGPC {
+	// NativeMLP inference of a DiscretePolicy, loaded directly from its modules
+	// NOTE: This is a copy of the policy's weights, it needs to be re-created or re-loaded when the policy changes
+	class NativePolicy : public NativeMLP {
+	public:
+		NativePolicy(DiscretePolicy* policy);
+		RG_NO_COPY(NativePolicy);
+
+		// Copies the weights of the policy
+		// The policy must have the architecture DiscretePolicy creates (Linear+ReLU layers, then a Linear output layer)
+		void Load(DiscretePolicy* policy);
+
+		// Same as DiscretePolicy::GetAction(), but the observations must be a contiguous float CPU tensor
+		DiscretePolicy::ActionResult GetAction(torch::Tensor obs, bool deterministic, std::mt19937& rng) const;
+	};
+}
@@ -0,0 +1,18 @@
+#include "OBSStandardization.h"
+#include "../libsrc/json/nlohmann/json.hpp"
+
+RLGPC::OBSStandardization RLGPC::OBSStandardization::FromStatsJSON(const std::string& statsJSON, int obsSize) {
+	auto j = nlohmann::json::parse(statsJSON);
+	if (!j.contains("obs_running_stats"))
+		return {};
+
+	auto& ors = j["obs_running_stats"];
+	if (ors["shape"] != obsSize)
+		RG_ERR_CLOSE("OBSStandardization::FromStatsJSON(): Stats have an OBS shape of " << ors["shape"] << ", but our OBS size is " << obsSize);
+
+	WelfordRunningStat obsStats = WelfordRunningStat(obsSize);
+	obsStats.runningMean = ors["mean"].get<std::vector<double>>();
+	obsStats.runningVariance = ors["var"].get<std::vector<double>>();
+	obsStats.count = ors["count"];
+	return FromStats(obsStats, ors["min_std"]);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include "../FrameworkTorch.h"
+#include <RLGymPPO_CPP/Util/WelfordRunningStat.h>
+
+namespace RLGPC {
+	// Standardizes observations before the first layer of a model, as (obs * scale + shift) (see LearnerConfig::standardizeOBS)
+	// Observations are stored raw, and only standardized inside the forward pass, in one fused multiply-add
+	// Both tensors are undefined until set, so models without standardization don't do any extra work
+	struct OBSStandardization {
+		torch::Tensor scale, shift; // [obsSize]
+
+		bool IsSet() const {
+			return scale.defined();
+		}
+
+		// Standardizes with the mean and standard deviation of the stats, standard deviations are clamped to at least minSTD
+		// Results are float CPU tensors
+		static OBSStandardization FromStats(const WelfordRunningStat& stats, float minSTD) {
+			FList mean = stats.Mean(), stdDevs = stats.GetSTD();
+
+			OBSStandardization result = {};
+			result.scale = torch::tensor(stdDevs).clamp_min(minSTD).reciprocal();
+			result.shift = -torch::tensor(mean) * result.scale;
+			return result;
+		}
+
+		// Standardizes like the learner that saved this stats JSON (see Learner::STATS_FILE_NAME)
+		// Not set if the learner didn't standardize observations
+		static OBSStandardization FromStatsJSON(const std::string& statsJSON, int obsSize);
+
+		// Copies the values of other, converted to options (our model's device and type)
+		// Once set, values are copied in-place, so CUDA graphs captured with them use the new values
+		void CopyFrom(const OBSStandardization& other, torch::TensorOptions options) {
+			RG_NOGRAD;
+			if (!other.IsSet()) {
+				*this = {};
+				return;
+			}
+
+			auto newScale = other.scale.to(options), newShift = other.shift.to(options);
+			if (IsSet() && scale.sizes() == newScale.sizes()) {
+				scale.copy_(newScale);
+				shift.copy_(newShift);
+			} else {
+				scale = newScale.clone();
+				shift = newShift.clone();
+			}
+		}
+
+		torch::Tensor Apply(torch::Tensor obs) const {
+			if (!IsSet())
+				return obs;
+
+			return torch::addcmul(shift, obs, scale);
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "OpponentPool.h"
+
+#include "PPOLearner.h"
+#include "../Util/TorchFuncs.h"
+#include <RLGymPPO_CPP/Learner.h>
+#include <torch/csrc/api/include/torch/serialize.h>
+
+// Reads a whole file into a string
+std::string _ReadFileString(std::filesystem::path path) {
+	std::ifstream fIn(path);
+	return std::string(std::istreambuf_iterator<char>(fIn), std::istreambuf_iterator<char>());
+}
+
+void RLGPC::OpponentPool::LoadFromFolder(std::filesystem::path folderPath) {
+	if (!std::filesystem::is_directory(folderPath))
+		return;
+
+	// Checkpoint folders are named by their timesteps
+	std::vector<int64_t> checkpoints = {};
+	for (auto entry : std::filesystem::directory_iterator(folderPath)) {
+		if (entry.is_directory()) {
+			try {
+				checkpoints.push_back(std::stoll(entry.path().filename()));
+			} catch (...) {}
+		}
+	}
+	std::sort(checkpoints.begin(), checkpoints.end());
+
+	size_t first = checkpoints.size() > maxSize ? checkpoints.size() - maxSize : 0;
+	for (size_t i = first; i < checkpoints.size(); i++)
+		LoadCheckpoint(folderPath / std::to_string(checkpoints[i]), checkpoints[i]);
+}
+
+void RLGPC::OpponentPool::LoadCheckpoint(std::filesystem::path checkpointPath, uint64_t timesteps) {
+	auto policy = new DiscretePolicy(obsSize, actionAmount, layerSizes, device);
+
+	auto filePath = checkpointPath / Learner::CHECKPOINT_FILE_NAME;
+	if (std::filesystem::exists(filePath)) {
+		CheckpointFile file = CheckpointFile(filePath);
+		TorchFuncs::LoadSeqFromFile(policy->seq, file, PPOLearner::POLICY_ENTRY_PREFIX);
+
+		if (auto statsEntry = file.Find(Learner::CHECKPOINT_STATS_ENTRY))
+			policy->SetOBSStandardization(
+				OBSStandardization::FromStatsJSON(std::string((const char*)statsEntry->data, statsEntry->size), obsSize)
+			);
+	} else {
+		try {
+			auto streamIn = std::ifstream(checkpointPath / PPOLearner::POLICY_FILE_NAME, std::ios::binary);
+			torch::load(policy->seq, streamIn, device);
+		} catch (std::exception& e) {
+			RG_ERR_CLOSE(
+				"OpponentPool::LoadCheckpoint(): Failed to load policy from " << checkpointPath << ", checkpoint may be corrupt or of different model arch.\n" <<
+				"Exception: " << e.what()
+			);
+		}
+
+		auto statsPath = checkpointPath / Learner::STATS_FILE_NAME;
+		if (std::filesystem::exists(statsPath))
+			policy->SetOBSStandardization(OBSStandardization::FromStatsJSON(_ReadFileString(statsPath), obsSize));
+	}
+
+	_Add(policy, timesteps);
+}
+
+void RLGPC::OpponentPool::AddCopy(DiscretePolicy* policy, uint64_t timesteps) {
+	RG_NOGRAD;
+	auto copy = new DiscretePolicy(obsSize, actionAmount, layerSizes, device);
+
+	auto fromParams = policy->parameters();
+	auto toParams = copy->parameters();
+	for (int i = 0; i < fromParams.size(); i++)
+		toParams[i].copy_(fromParams[i]);
+
+	if (policy->obsStandardization.IsSet())
+		copy->SetOBSStandardization(policy->obsStandardization);
+
+	_Add(copy, timesteps);
+}
+
+std::shared_ptr<const RLGPC::OpponentPool::Member> RLGPC::OpponentPool::Sample(std::mt19937& rng) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_members.empty())
+		return NULL;
+
+	return _members[std::uniform_int_distribution<size_t>(0, _members.size() - 1)(rng)];
+}
+
+void RLGPC::OpponentPool::_Add(DiscretePolicy* policy, uint64_t timesteps) {
+	// Never trained, so it doesn't need gradients
+	for (auto param : policy->parameters())
+		param.requires_grad_(false);
+
+	auto member = std::make_shared<const Member>(policy, timesteps);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_members.push_back(member);
+	while (_members.size() > maxSize)
+		_members.erase(_members.begin());
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include "DiscretePolicy.h"
+
+namespace RLGPC {
+	// Past versions of the policy for games to play against (see LearnerConfig::opponentPoolSize)
+	// Members stay resident on the device, and are shared by all agents
+	// Agents hold on to the members they use, so members removed from the pool stay valid until agents stop using them
+	class OpponentPool {
+	public:
+		struct Member {
+			DiscretePolicy* policy;
+			uint64_t timesteps; // Of the checkpoint the policy is from
+
+			Member(DiscretePolicy* policy, uint64_t timesteps) : policy(policy), timesteps(timesteps) {}
+			RG_NO_COPY(Member);
+
+			~Member() {
+				delete policy;
+			}
+		};
+
+		int obsSize, actionAmount;
+		IList layerSizes;
+		torch::Device device;
+
+		// Once full, the oldest member is removed to make room for a new one
+		int maxSize;
+
+		// Chance that a game plays its opponent team with a member, rolled whenever a game starts an episode
+		float opponentProb;
+
+		OpponentPool(int obsSize, int actionAmount, const IList& layerSizes, torch::Device device, int maxSize, float opponentProb) :
+			obsSize(obsSize), actionAmount(actionAmount), layerSizes(layerSizes), device(device), maxSize(maxSize), opponentProb(opponentProb) {}
+
+		RG_NO_COPY(OpponentPool);
+
+		// Loads the newest checkpoints in a checkpoint folder (see Learner::Save()), up to maxSize
+		void LoadFromFolder(std::filesystem::path folderPath);
+
+		// Loads the policy of a single checkpoint, in either checkpoint format
+		void LoadCheckpoint(std::filesystem::path checkpointPath, uint64_t timesteps);
+
+		// Adds a copy of a policy, including its OBS standardization
+		void AddCopy(DiscretePolicy* policy, uint64_t timesteps);
+
+		// Picks a random member, NULL if we have none
+		std::shared_ptr<const Member> Sample(std::mt19937& rng);
+
+		int Size() {
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _members.size();
+		}
+
+		// Oldest first
+		std::vector<std::shared_ptr<const Member>> _members = {};
+		std::mutex _mutex = {};
+
+		void _Add(DiscretePolicy* policy, uint64_t timesteps);
+	};
+}
\ No newline at end of file
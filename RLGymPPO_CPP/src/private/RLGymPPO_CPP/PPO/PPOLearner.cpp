@@ -1,15 +1,19 @@
 #include "PPOLearner.h"
 
 #include "../Util/TorchFuncs.h"
+#include "../Util/TraceRecorder.h"
 
 #include <torch/nn/utils/convert_parameters.h>
 #include <torch/nn/utils/clip_grad.h>
+#include <torch/nn/functional/loss.h>
 #include <torch/csrc/api/include/torch/serialize.h>
+#include <torch/cuda.h>
 
 using namespace torch;
 
+// Stays on the device of the module
 Tensor _CopyParams(nn::Module* mod) {
-	return torch::nn::utils::parameters_to_vector(mod->parameters()).cpu();
+	return torch::nn::utils::parameters_to_vector(mod->parameters()).detach().clone();
 }
 
 void _CopyModelParamsHalf(nn::Module* from, nn::Module* to) {
@@ -26,6 +30,35 @@ void _CopyModelParamsHalf(nn::Module* from, nn::Module* to) {
 	}
 }
 
+void _CopyModelParams(nn::Module* from, nn::Module* to) {
+	RG_NOGRAD;
+	auto fromParams = from->parameters();
+	auto toParams = to->parameters();
+	for (int i = 0; i < fromParams.size(); i++)
+		toParams[i].copy_(fromParams[i]);
+}
+
+// Adds the gradients of one model to those of another, then removes the gradients of the first model
+// The models can be on different devices
+void _AddModelGrads(nn::Module* from, nn::Module* to) {
+	RG_NOGRAD;
+	auto fromParams = from->parameters();
+	auto toParams = to->parameters();
+	for (int i = 0; i < fromParams.size(); i++) {
+		auto& fromGrad = fromParams[i].grad();
+		if (!fromGrad.defined())
+			continue;
+
+		auto& toGrad = toParams[i].mutable_grad();
+		if (toGrad.defined()) {
+			toGrad.add_(fromGrad.to(toGrad.device()));
+		} else {
+			toGrad = fromGrad.to(toParams[i].device()).clone();
+		}
+	}
+	from->zero_grad();
+}
+
 RLGPC::PPOLearner::PPOLearner(int obsSpaceSize, int actSpaceSize, PPOLearnerConfig _config, Device _device) 
 	: config(_config), device(_device) {
 
@@ -35,18 +68,28 @@ RLGPC::PPOLearner::PPOLearner(int obsSpaceSize, int actSpaceSize, PPOLearnerConf
 	if (config.batchSize % config.miniBatchSize != 0)
 		RG_ERR_CLOSE("PPOLearner: config.batchSize must be a multiple of config.miniBatchSize");
 
+	// With a shared trunk, the critic is only a head on top of the policy's features
+	auto fnMakeValueNet = [&](DiscretePolicy* trunk, Device valueDevice) {
+		if (config.sharedTrunk) {
+			return new ValueEstimator(trunk, config.criticHeadLayerSizes, valueDevice);
+		} else {
+			return new ValueEstimator(obsSpaceSize, config.criticLayerSizes, valueDevice);
+		}
+	};
+
 	policy = new DiscretePolicy(obsSpaceSize, actSpaceSize, config.policyLayerSizes, device);
-	valueNet = new ValueEstimator(obsSpaceSize, config.criticLayerSizes, device);
+	valueNet = fnMakeValueNet(policy, device);
 
 	if (config.halfPrecModels) {
 		policyHalf = new DiscretePolicy(obsSpaceSize, actSpaceSize, config.policyLayerSizes, device);
-		valueNetHalf = new ValueEstimator(obsSpaceSize, config.criticLayerSizes, device);
+		valueNetHalf = fnMakeValueNet(policyHalf, device);
 
 		_CopyModelParamsHalf(policy, policyHalf);
 		_CopyModelParamsHalf(valueNet, valueNetHalf);
 
 		policyHalf->to(RG_HALFPERC_TYPE);
 		valueNetHalf->to(RG_HALFPERC_TYPE);
+		policyHalf->halfPrec = true;
 	} else {
 		policyHalf = NULL;
 		valueNetHalf = NULL;
@@ -54,22 +97,148 @@ RLGPC::PPOLearner::PPOLearner(int obsSpaceSize, int actSpaceSize, PPOLearnerConf
 	policyOptimizer = new optim::Adam(policy->parameters(), optim::AdamOptions(config.policyLR));
 	valueOptimizer = new optim::Adam(valueNet->parameters(), optim::AdamOptions(config.criticLR));
 	valueLossFn = nn::MSELoss();
+
+	if (config.numGPUs > 1) {
+		if (!device.is_cuda())
+			RG_ERR_CLOSE("PPOLearner: config.numGPUs can only be used when learning on a CUDA GPU");
+
+		if (config.autocastLearn)
+			RG_ERR_CLOSE("PPOLearner: config.numGPUs is not compatible with config.autocastLearn");
+
+		int deviceCount = torch::cuda::device_count();
+		if (config.numGPUs > deviceCount)
+			RG_ERR_CLOSE("PPOLearner: config.numGPUs is " << config.numGPUs << ", but only " << deviceCount << " CUDA GPUs are available");
+
+		if (config.miniBatchSize < config.numGPUs)
+			RG_ERR_CLOSE("PPOLearner: config.miniBatchSize must be at least config.numGPUs");
+
+		// We stay on the first GPU, replicas are on the rest
+		for (int i = 1; i < config.numGPUs; i++) {
+			Device replicaDevice = Device(kCUDA, i);
+			Replica replica = {
+				replicaDevice,
+				new DiscretePolicy(obsSpaceSize, actSpaceSize, config.policyLayerSizes, replicaDevice),
+				NULL,
+				NULL
+			};
+			replica.valueNet = fnMakeValueNet(replica.policy, replicaDevice);
+
+			// Only used for collection inference, see LearnerConfig::spreadAgentsAcrossGPUs
+			if (config.halfPrecModels) {
+				replica.policyHalf = new DiscretePolicy(obsSpaceSize, actSpaceSize, config.policyLayerSizes, replicaDevice);
+				replica.policyHalf->to(RG_HALFPERC_TYPE);
+				replica.policyHalf->halfPrec = true;
+			}
+
+			replicas.push_back(replica);
+		}
+
+		_SyncReplicas(true);
+	}
+
+	if (config.fusedLayers) {
+		std::vector<DiscretePolicy*> policies = { policy, policyHalf };
+		std::vector<ValueEstimator*> valueNets = { valueNet, valueNetHalf };
+		for (auto& replica : replicas) {
+			policies.push_back(replica.policy);
+			policies.push_back(replica.policyHalf);
+			valueNets.push_back(replica.valueNet);
+		}
+
+		for (auto model : policies)
+			if (model)
+				model->fusedLayers = true;
+		for (auto model : valueNets)
+			if (model)
+				model->fusedLayers = true;
+	}
+
+	if (config.activationCheckpointLayers > 0) {
+		// Half-precision copies are only inferred, so only the models we learn with need it
+		std::vector<DiscretePolicy*> policies = { policy };
+		std::vector<ValueEstimator*> valueNets = { valueNet };
+		for (auto& replica : replicas) {
+			policies.push_back(replica.policy);
+			valueNets.push_back(replica.valueNet);
+		}
+
+		for (auto model : policies)
+			model->checkpointLayers = config.activationCheckpointLayers;
+		for (auto model : valueNets)
+			model->checkpointLayers = config.activationCheckpointLayers;
+	}
+
+	if (config.targetKL > 0)
+		klReader = new DeviceScalarReader(device);
+
+	if (config.gpuEventTiming) {
+		if (CUDAPhaseTimer::IsSupported(device)) {
+			gpuTimer = new CUDAPhaseTimer(device, GPU_PHASE_AMOUNT);
+		} else {
+			RG_LOG("PPOLearner: WARNING: config.gpuEventTiming needs a CUDA GPU and libtorch built with CUDA, GPU times will not be reported");
+		}
+	}
+}
+
+void RLGPC::PPOLearner::_SyncReplicas(bool withHalf) {
+	for (auto& replica : replicas) {
+		_CopyModelParams(policy, replica.policy);
+		_CopyModelParams(valueNet, replica.valueNet);
+		if (withHalf && replica.policyHalf)
+			_CopyModelParamsHalf(policy, replica.policyHalf);
+	}
+}
+
+void RLGPC::PPOLearner::Warmup() {
+	int64_t miniBatchSize = config.miniBatchSize ? config.miniBatchSize : config.batchSize;
+	Tensor obs = torch::zeros({ miniBatchSize, policy->inputAmount }, torch::TensorOptions().device(device));
+	Tensor acts = torch::zeros({ miniBatchSize }, torch::TensorOptions().dtype(kInt64).device(device));
+
+	if (config.autocastLearn) RG_AUTOCAST_ON();
+	Tensor features = config.sharedTrunk ? policy->GetFeatures(obs) : Tensor();
+	auto vals = features.defined() ? valueNet->ForwardFeatures(features) : valueNet->Forward(obs);
+	auto bpResult = features.defined() ? policy->GetBackpropDataFromFeatures(features, acts) : policy->GetBackpropData(obs, acts);
+	auto loss = bpResult.actionLogProbs.mean() - bpResult.entropy + vals.mean();
+	if (config.autocastLearn) RG_AUTOCAST_OFF();
+
+	loss.backward();
+
+	// Nothing was stepped, so the models are unchanged
+	policyOptimizer->zero_grad();
+	valueOptimizer->zero_grad();
 }
 
-void RLGPC::PPOLearner::Learn(ExperienceBuffer* expBuffer, Report& report) {
+void RLGPC::PPOLearner::Learn(ExperienceBuffer* expBuffer, Report& report, int numEpochs, int64_t numNewest) {
 	
 	bool autocast = config.autocastLearn;
+	// CPU autocast is bf16, which has the exponent range of fp32, so its gradients don't need scaling (and our grad scaler is CUDA-only)
+	bool gradScaling = autocast && !device.is_cpu();
 
 	static amp::GradScaler gradScaler = amp::GradScaler();
 
-	int
-		numIterations = 0,
-		numMinibatchIterations = 0;
-	float
-		meanEntropy = 0,
-		meanDivergence = 0,
-		meanValLoss = 0;
-	FList clipFractions = {};
+	int numIterations = 0;
+
+	// Rank 0 is us, the rest are our replicas on other GPUs
+	int numRanks = 1 + replicas.size();
+
+	// Metrics are accumulated on the device of each rank, and only moved to the CPU once we are done
+	// This prevents syncing with the device every minibatch
+	struct RankMetrics {
+		Tensor entropy, divergence, valLoss, clipFraction;
+		Tensor batchDivergence; // Of the current batch, only used with config.targetKL
+	};
+	std::vector<RankMetrics> rankMetrics = {};
+	for (int rank = 0; rank < numRanks; rank++) {
+		Device rankDevice = rank ? replicas[rank - 1].device : device;
+		rankMetrics.push_back({
+			torch::zeros({}, rankDevice),
+			torch::zeros({}, rankDevice),
+			torch::zeros({}, rankDevice),
+			torch::zeros({}, rankDevice),
+			torch::zeros({}, rankDevice)
+		});
+	}
+	int numShardIterations = 0;
 
 	// Save parameters first
 	auto policyBefore = _CopyParams(policy);
@@ -77,144 +246,361 @@ void RLGPC::PPOLearner::Learn(ExperienceBuffer* expBuffer, Report& report) {
 
 	float batchSizeRatio = config.miniBatchSize / (float)config.batchSize;
 
-	Timer totalTimer = {};
-	for (int epoch = 0; epoch < config.epochs; epoch++) {
-
-		// Get randomly-ordered timesteps for PPO
-		auto batches = expBuffer->GetAllBatchesShuffled(config.batchSize);
-
-		for (auto& batch : batches) {
-			auto batchActs = batch.actions;
-			auto batchOldProbs = batch.logProbs;
-			auto batchObs = batch.states;
-			auto batchTargetValues = batch.values;
-			auto batchAdvantages = batch.advantages;
-
-			batchActs = batchActs.view({ config.batchSize, -1 });
-			policyOptimizer->zero_grad();
-			valueOptimizer->zero_grad();
-
-			for (int mbs = 0; mbs < config.batchSize; mbs += config.miniBatchSize) {
-				Timer timer = {};
-
-				int start = mbs;
-				int stop = start + config.miniBatchSize;
-
-				// Send everything to the device and enforce correct shapes
-				auto acts = batchActs.slice(0, start, stop).to(device, true);
-				auto obs = batchObs.slice(0, start, stop).to(device, true);
+	double batchPrepTime = 0, batchWaitTime = 0;
+
+	// Sample of observations used to validate the half-precision policy
+	constexpr int64_t HALF_CHECK_SAMPLES = 1000;
+	Tensor halfCheckObs;
+
+	// Computes the losses and gradients of a shard of a minibatch, using the models of a rank
+	// Losses are scaled by shardRatio, so that the gradients of all shards add up to those of the whole minibatch
+	auto fnLearnShard = [&](
+		int rank, Tensor acts, Tensor obs, Tensor advantages, Tensor oldProbs, Tensor targetValues, Tensor isWeights, float shardRatio
+		) {
+		DiscretePolicy* rankPolicy = rank ? replicas[rank - 1].policy : policy;
+		ValueEstimator* rankValueNet = rank ? replicas[rank - 1].valueNet : valueNet;
+		Device rankDevice = rank ? replicas[rank - 1].device : device;
+		RankMetrics& metrics = rankMetrics[rank];
+
+		// Replicas run on other threads, and the report is not thread-safe
+		bool reportTimes = (rank == 0);
+
+		// Only our own device is timed
+		CUDAPhaseTimer* rankGPUTimer = (rank == 0) ? gpuTimer : NULL;
+		auto fnStartPhase = [&](GPUPhase phase) {
+			if (rankGPUTimer)
+				rankGPUTimer->StartPhase(phase);
+		};
+		auto fnEndPhase = [&](GPUPhase phase) {
+			if (rankGPUTimer)
+				rankGPUTimer->EndPhase(phase);
+		};
+
+		RG_TRACE_SCOPE("Minibatch", rankDevice);
+
+		Timer timer = {};
+
+		// Send everything to the device and enforce correct shapes
+		fnStartPhase(GPU_PHASE_TRANSFER);
+		acts = acts.to(rankDevice, true);
+		obs = obs.to(rankDevice, true);
+
+		if (rank == 0 && policyHalf && !halfCheckObs.defined())
+			halfCheckObs = obs.slice(0, 0, HALF_CHECK_SAMPLES).clone();
+
+		advantages = advantages.to(rankDevice, true);
+		oldProbs = oldProbs.to(rankDevice, true);
+		targetValues = targetValues.to(rankDevice, true);
+		isWeights = isWeights.to(rankDevice, true);
+		fnEndPhase(GPU_PHASE_TRANSFER);
+
+		fnStartPhase(GPU_PHASE_FORWARD);
+		timer.Reset();
+		if (autocast) RG_AUTOCAST_ON();
+
+		// With a shared trunk, both heads use the same pass through it
+		Tensor features = config.sharedTrunk ? rankPolicy->GetFeatures(obs) : Tensor();
+		auto vals = features.defined() ? rankValueNet->ForwardFeatures(features) : rankValueNet->Forward(obs);
+		if (reportTimes)
+			report.Accum("PPO Value Estimate Time", timer.Elapsed());
+
+		timer.Reset();
+		// Get policy log probs & entropy
+		DiscretePolicy::BackpropResult bpResult = 
+			features.defined() ? rankPolicy->GetBackpropDataFromFeatures(features, acts) : rankPolicy->GetBackpropData(obs, acts);
+
+		auto logProbs = bpResult.actionLogProbs;
+		auto entropy = bpResult.entropy;
+
+		logProbs = logProbs.view_as(oldProbs);
+		if (reportTimes)
+			report.Accum("PPO Backprop Data Time", timer.Elapsed());
+
+		// Compute PPO loss
+		auto ratio = exp(logProbs - oldProbs);
+		auto clipped = clamp(
+			ratio, 1 - config.clipRange, 1 + config.clipRange
+		);
+		vals = vals.view_as(targetValues);
+
+		// Compute policy loss
+		// Steps from older policies are importance-weighted, the rest have a weight of 1
+		auto policyLoss = -(min(
+			ratio * advantages, clipped * advantages
+		) * isWeights).mean();
+		auto valueLoss = valueLossFn(vals, targetValues);
+		auto ppoLoss = (policyLoss - entropy * config.entCoef) * batchSizeRatio;
+
+		// Only scales the gradients, metrics are of the whole shard
+		auto valueGradLoss = valueLoss;
+		if (config.valueLossCoef != 1)
+			valueGradLoss = valueGradLoss * config.valueLossCoef;
+		if (shardRatio != 1) {
+			ppoLoss = ppoLoss * shardRatio;
+			valueGradLoss = valueGradLoss * shardRatio;
+		}
 
-				auto advantages = batchAdvantages.slice(0, start, stop).to(device, true);
-				auto oldProbs = batchOldProbs.slice(0, start, stop).to(device, true);
-				auto targetValues = batchTargetValues.slice(0, start, stop).to(device, true);
+		if (autocast) RG_AUTOCAST_OFF();
 
-				timer.Reset();
-				if (autocast) RG_AUTOCAST_ON();
-				auto vals = valueNet->Forward(obs);
-				report.Accum("PPO Value Estimate Time", timer.Elapsed());
+		// Compute KL divergence & clip fraction using SB3 method for reporting
+		{
+			RG_NOGRAD;
 
-				timer.Reset();
-				// Get policy log probs & entropy
-				DiscretePolicy::BackpropResult bpResult = policy->GetBackpropData(obs, acts);
+			auto logRatio = logProbs - oldProbs;
+			auto klTensor = (exp(logRatio) - 1) - logRatio;
+			auto kl = klTensor.mean().detach().to(kFloat);
+			metrics.divergence += kl;
+			if (klReader)
+				metrics.batchDivergence += kl;
 
-				auto logProbs = bpResult.actionLogProbs;
-				auto entropy = bpResult.entropy;
+			metrics.clipFraction += mean((abs(ratio - 1) > config.clipRange).to(kFloat));
+		}
+		fnEndPhase(GPU_PHASE_FORWARD);
+
+		fnStartPhase(GPU_PHASE_BACKWARD);
+		timer.Reset();
+		// NOTE: These gradient calls are a substantial portion of learn time
+		//	From my testing, they are around 61% of learn time
+		//	Results will probably vary heavily depending on model size and GPU strength
+		// Both losses are backpropagated at once, as they share a graph with a shared trunk
+		if (gradScaling) {
+			gradScaler.scale(ppoLoss + valueGradLoss).backward();
+		} else {
+			(ppoLoss + valueGradLoss).backward();
+		}
+		fnEndPhase(GPU_PHASE_BACKWARD);
+		if (reportTimes)
+			report.Accum("PPO Gradient Time", timer.Elapsed());
+
+		{
+			RG_NOGRAD;
+			metrics.valLoss += valueLoss.detach().to(kFloat);
+			metrics.entropy += entropy.detach().to(kFloat);
+		}
+	};
 
-				logProbs = logProbs.view_as(oldProbs);
-				report.Accum("PPO Backprop Data Time", timer.Elapsed());
+	if (gpuTimer)
+		gpuTimer->Begin();
 
-				// Compute PPO loss
-				auto ratio = exp(logProbs - oldProbs);
-				auto clipped = clamp(
-					ratio, 1 - config.clipRange, 1 + config.clipRange
-				);
-				vals = vals.view_as(targetValues);
+	Timer totalTimer = {};
+	if (numEpochs < 0)
+		numEpochs = config.epochs;
+
+	// Stops learning once a batch's KL divergence is above config.targetKL
+	bool earlyStopped = false;
+	if (klReader)
+		klReader->Discard(); // From our last call
+
+	// Every batch is split into the same shards, so find them once
+	// Each minibatch is split into a shard for each rank, in order of rank
+	struct Shard {
+		int rank;
+		float ratio; // Of the minibatch
+	};
+	std::vector<std::vector<Shard>> minibatchShards = {};
+	std::vector<int64_t> shardSizes = {};
+	{
+		int64_t shardSize = (config.miniBatchSize + numRanks - 1) / numRanks;
+		for (int64_t start = 0; start < config.batchSize; start += config.miniBatchSize) {
+			int64_t stop = start + config.miniBatchSize;
+			auto& shards = minibatchShards.emplace_back();
+			for (int rank = 0; rank < numRanks; rank++) {
+				int64_t shardStart = start + shardSize * rank;
+				int64_t shardStop = RS_MIN(shardStart + shardSize, stop);
+				if (shardStart >= shardStop)
+					continue;
 
-				// Compute policy loss
-				auto policyLoss = -min(
-					ratio * advantages, clipped * advantages
-				).mean();
-				auto valueLoss = valueLossFn(vals, targetValues);
-				auto ppoLoss = (policyLoss - entropy * config.entCoef) * batchSizeRatio;
+				float shardRatio = (numRanks > 1) ? (shardStop - shardStart) / (float)config.miniBatchSize : 1;
+				shards.push_back({ rank, shardRatio });
+				shardSizes.push_back(shardStop - shardStart);
+			}
+		}
+	}
 
-				if (autocast) RG_AUTOCAST_OFF();
+	for (int epoch = 0; epoch < numEpochs; epoch++) {
 
-				// Compute KL divergence & clip fraction using SB3 method for reporting
-				float kl;
-				float clipFraction;
-				{
-					RG_NOGRAD;
+		// Get randomly-ordered timesteps for PPO
+		auto batchItr = expBuffer->GetBatchIteratorShuffled(config.batchSize, numNewest);
+
+		ExperienceBuffer::SampleSet batch;
+		while (batchItr.Next(batch)) {
+			// Split everything into shards at once
+			auto fnSplit = [&](const Tensor& t) { return t.split_with_sizes(shardSizes); };
+			auto actShards = fnSplit(batch.actions.view({ config.batchSize, -1 }));
+			auto oldProbShards = fnSplit(batch.logProbs);
+			auto obsShards = fnSplit(batch.states);
+			auto targetValueShards = fnSplit(batch.values);
+			auto advantageShards = fnSplit(batch.advantages);
+			auto isWeightShards = fnSplit(batch.isWeights);
 
-					auto logRatio = logProbs - oldProbs;
-					auto klTensor = (exp(logRatio) - 1) - logRatio;
-					kl = klTensor.mean().detach().cpu().item<float>();
+			policyOptimizer->zero_grad();
+			valueOptimizer->zero_grad();
 
-					clipFraction = mean((abs(ratio - 1) > config.clipRange).to(kFloat)).cpu().item<float>();
-					clipFractions.push_back(clipFraction);
+			int firstShardIdx = 0;
+			for (auto& shards : minibatchShards) {
+				// Replicas learn their shards on other threads while we learn ours, so they are started first
+				std::vector<std::future<void>> replicaFutures = {};
+				for (int i = shards.size() - 1; i >= 0; i--) {
+					int shardIdx = firstShardIdx + i;
+					Shard shard = shards[i];
+					auto fnRun = [&, shardIdx, shard] {
+						fnLearnShard(
+							shard.rank,
+							actShards[shardIdx],
+							obsShards[shardIdx],
+							advantageShards[shardIdx],
+							oldProbShards[shardIdx],
+							targetValueShards[shardIdx],
+							isWeightShards[shardIdx],
+							shard.ratio
+						);
+					};
+
+					if (shard.rank > 0) {
+						replicaFutures.push_back(std::async(std::launch::async, fnRun));
+					} else {
+						fnRun();
+					}
+					numShardIterations += 1;
 				}
+				firstShardIdx += shards.size();
 
-				timer.Reset();
-				// NOTE: These gradient calls are a substantial portion of learn time
-				//	From my testing, they are around 61% of learn time
-				//	Results will probably vary heavily depending on model size and GPU strength
-				if (autocast) {
-					gradScaler.scale(ppoLoss).backward();
-					gradScaler.scale(valueLoss).backward();
-				} else {
-					ppoLoss.backward();
-					valueLoss.backward();
-				}
-				report.Accum("PPO Gradient Time", timer.Elapsed());
+				for (auto& future : replicaFutures)
+					future.get();
+			}
 
-				meanValLoss += valueLoss.cpu().detach().item<float>();
-				meanDivergence += kl;
-				meanEntropy += entropy.cpu().detach().item<float>();
-				numMinibatchIterations += 1;
+			// Sum up the gradients of all ranks before clipping
+			for (auto& replica : replicas) {
+				_AddModelGrads(replica.policy, policy);
+				_AddModelGrads(replica.valueNet, valueNet);
 			}
 
-			nn::utils::clip_grad_norm_(valueNet->parameters(), 0.5f);
-			nn::utils::clip_grad_norm_(policy->parameters(), 0.5f);
+			RG_TRACE_SCOPE("Optimizer Step", device);
+			bool fused = config.fusedOptimizerStep && !gradScaling;
 
-			if (autocast) {
+			if (gpuTimer) gpuTimer->StartPhase(GPU_PHASE_CLIP);
+			if (fused) {
+				TorchFuncs::ClipGradNorms({ valueNet->parameters(), policy->parameters() }, 0.5f);
+			} else {
+				nn::utils::clip_grad_norm_(valueNet->parameters(), 0.5f);
+				nn::utils::clip_grad_norm_(policy->parameters(), 0.5f);
+			}
+			if (gpuTimer) gpuTimer->EndPhase(GPU_PHASE_CLIP);
+
+			if (gpuTimer) gpuTimer->StartPhase(GPU_PHASE_OPTIMIZER);
+			if (gradScaling) {
 				gradScaler.step(*policyOptimizer);
 				gradScaler.step(*valueOptimizer);
-			} else {
+			} else if (!fused || !TorchFuncs::FusedAdamStep({ policyOptimizer, valueOptimizer })) {
 				policyOptimizer->step();
 				valueOptimizer->step();
 			}
 
-			if (policyHalf)
-				_CopyModelParamsHalf(policy, policyHalf);
-			if (valueNetHalf)
-				_CopyModelParamsHalf(valueNet, valueNetHalf);
-			
-			if (autocast)
+			if (gradScaling)
 				gradScaler.update();
+			if (gpuTimer) gpuTimer->EndPhase(GPU_PHASE_OPTIMIZER);
+
+			// Replicas need our new parameters for the next batch
+			_SyncReplicas(false);
+
 			numIterations += 1;
+
+			if (klReader) {
+				// Check the KL of an earlier batch, once the device is done with it
+				float batchKL;
+				if (klReader->Poll(batchKL) && batchKL > config.targetKL)
+					earlyStopped = true;
+
+				if (!klReader->IsPending()) {
+					Tensor batchDivergence = rankMetrics[0].batchDivergence.clone();
+					for (int rank = 1; rank < numRanks; rank++)
+						batchDivergence += rankMetrics[rank].batchDivergence.to(device);
+					klReader->Start(batchDivergence / (int64_t)shardSizes.size());
+				}
+
+				for (auto& metrics : rankMetrics)
+					metrics.batchDivergence.zero_();
+
+				if (earlyStopped)
+					break;
+			}
 		}
+
+		batchPrepTime += batchItr.totalPrepTime;
+		batchWaitTime += batchItr.totalWaitTime;
+
+		if (earlyStopped)
+			break;
+	}
+
+	if (klReader) {
+		numLearns++;
+		if (earlyStopped)
+			numEarlyStops++;
+
+		// Estimate the time of the batches we skipped from those we ran
+		int64_t numSamples = (numNewest > 0) ? RS_MIN(numNewest, expBuffer->curSize) : expBuffer->curSize;
+		int64_t plannedBatches = (numSamples / config.batchSize) * numEpochs;
+		double savedTime = 0;
+		if (earlyStopped && numIterations > 0)
+			savedTime = RS_MAX(plannedBatches - numIterations, 0) * (totalTimer.Elapsed() / numIterations);
+
+		report["PPO Early Stop Saved Time"] = savedTime;
+		report["PPO Early Stop Fraction"] = numEarlyStops / (double)numLearns;
 	}
 
+	if (gpuTimer)
+		gpuTimer->End();
+
 	numIterations = RS_MAX(numIterations, 1);
-	numMinibatchIterations = RS_MAX(numMinibatchIterations, 1);
-
-	// Compute averages for the metrics that will be reported
-	meanEntropy /= numMinibatchIterations;
-	meanDivergence /= numMinibatchIterations;
-	meanValLoss /= numMinibatchIterations;
-
-	float meanClip = 0;
-	if (!clipFractions.empty()) {
-		for (float f : clipFractions)
-			meanClip += f;
-		meanClip /= clipFractions.size();
+	numShardIterations = RS_MAX(numShardIterations, 1);
+
+	// Half-precision models only need to be updated once we are done learning, as they are only used for collection
+	UpdateModelCopies();
+
+	// Check how far the half-precision policy is from the full-precision policy
+	if (policyHalf && halfCheckObs.defined()) {
+		RG_NOGRAD;
+		auto fullLogProbs = policy->GetLogProbs(halfCheckObs);
+		auto halfLogProbs = policyHalf->GetLogProbs(halfCheckObs);
+
+		// KL(full || half), and the largest log prob difference
+		auto halfKL = (fullLogProbs.exp() * (fullLogProbs - halfLogProbs)).sum(-1).mean();
+		auto halfMaxDiff = (fullLogProbs - halfLogProbs).abs().max();
+		report["Half Policy KL Divergence"] = halfKL.item<float>();
+		report["Half Policy Max Log Prob Diff"] = halfMaxDiff.item<float>();
 	}
 
 	// Compute magnitude of updates made to the policy and value estimator
 	auto policyAfter = _CopyParams(policy);
 	auto criticAfter = _CopyParams(valueNet);
 
-	float policyUpdateMagnitude = (policyBefore - policyAfter).norm().item<float>();
-	float criticUpdateMagnitude = (criticBefore - criticAfter).norm().item<float>();
+	// Sum up the metrics of all ranks
+	RankMetrics totalMetrics = rankMetrics[0];
+	for (int rank = 1; rank < numRanks; rank++) {
+		totalMetrics.entropy += rankMetrics[rank].entropy.to(device);
+		totalMetrics.divergence += rankMetrics[rank].divergence.to(device);
+		totalMetrics.valLoss += rankMetrics[rank].valLoss.to(device);
+		totalMetrics.clipFraction += rankMetrics[rank].clipFraction.to(device);
+	}
+
+	// Move all metrics to the CPU at once
+	Tensor metrics = torch::stack({
+		totalMetrics.entropy / numShardIterations,
+		totalMetrics.divergence / numShardIterations,
+		totalMetrics.valLoss / numShardIterations,
+		totalMetrics.clipFraction / numShardIterations,
+		(policyBefore - policyAfter).norm().to(kFloat),
+		(criticBefore - criticAfter).norm().to(kFloat)
+	}).cpu();
+	auto metricsData = metrics.accessor<float, 1>();
+
+	float meanEntropy = metricsData[0];
+	float meanDivergence = metricsData[1];
+	float meanValLoss = metricsData[2];
+	float meanClip = metricsData[3];
+	float policyUpdateMagnitude = metricsData[4];
+	float criticUpdateMagnitude = metricsData[5];
 
 	float totalTime = totalTimer.Elapsed();
 
@@ -229,6 +615,19 @@ void RLGPC::PPOLearner::Learn(ExperienceBuffer* expBuffer, Report& report) {
 	report["Policy Update Magnitude"] = policyUpdateMagnitude;
 	report["Value Function Update Magnitude"] = criticUpdateMagnitude;
 	report["PPO Learn Time"] = totalTimer.Elapsed();
+	report["PPO Batch Prep Time"] = batchPrepTime;
+	report["PPO Batch Wait Time"] = batchWaitTime;
+
+	if (gpuTimer) {
+		// The metrics above already waited for the GPU, so this doesn't wait any longer
+		auto gpuTimes = gpuTimer->Resolve();
+		report["PPO GPU Transfer Time"] = gpuTimes.phaseTimes[GPU_PHASE_TRANSFER];
+		report["PPO GPU Forward Time"] = gpuTimes.phaseTimes[GPU_PHASE_FORWARD];
+		report["PPO GPU Backward Time"] = gpuTimes.phaseTimes[GPU_PHASE_BACKWARD];
+		report["PPO GPU Clip Time"] = gpuTimes.phaseTimes[GPU_PHASE_CLIP];
+		report["PPO GPU Optimizer Time"] = gpuTimes.phaseTimes[GPU_PHASE_OPTIMIZER];
+		report["PPO GPU Idle Fraction"] = gpuTimes.idleFraction;
+	}
 
 	policyOptimizer->zero_grad();
 	valueOptimizer->zero_grad();
@@ -287,39 +686,72 @@ void TorchLoadSaveSeq(torch::nn::Sequential seq, std::filesystem::path path, c10
 	}
 }
 
-void TorchLoadSaveAll(RLGPC::PPOLearner* learner, std::filesystem::path folderPath, bool load) {
+constexpr const char* MODEL_FILE_NAMES[] = {
+	RLGPC::PPOLearner::POLICY_FILE_NAME,
+	"PPO_CRITIC.lt",
+};
 
-	constexpr const char* MODEL_FILE_NAMES[] = {
-		"PPO_POLICY.lt",
-		"PPO_CRITIC.lt",
-	};
+constexpr const char* OPTIM_FILE_NAMES[] = {
+	"PPO_POLICY_OPTIM.lt",
+	"PPO_CRITIC_OPTIM.lt",
+};
 
-	constexpr const char* OPTIM_FILE_NAMES[] = {
-		"PPO_POLICY_OPTIM.lt",
-		"PPO_CRITIC_OPTIM.lt",
-	};
+// With a shared trunk, the critic is only a head, and is saved under different names (see PPOLearnerConfig::sharedTrunk)
+constexpr const char* CRITIC_HEAD_FILE_NAME = "PPO_CRITIC_HEAD.lt";
+constexpr const char* CRITIC_HEAD_OPTIM_FILE_NAME = "PPO_CRITIC_HEAD_OPTIM.lt";
+
+const char* _GetModelFileName(int index, bool sharedTrunk) {
+	return (index && sharedTrunk) ? CRITIC_HEAD_FILE_NAME : MODEL_FILE_NAMES[index];
+}
+
+const char* _GetOptimFileName(int index, bool sharedTrunk) {
+	return (index && sharedTrunk) ? CRITIC_HEAD_OPTIM_FILE_NAME : OPTIM_FILE_NAMES[index];
+}
+
+void TorchLoadSaveAll(RLGPC::PPOLearner* learner, std::filesystem::path folderPath, bool load) {
+	bool sharedTrunk = learner->config.sharedTrunk;
+
+	// If false, the checkpoint has a separate critic that our critic head can't use
+	bool loadCritic = true;
 
 	if (load) {
-		for (const char* fileName : MODEL_FILE_NAMES)
-			if (!std::filesystem::exists(folderPath / fileName))
-				RG_ERR_CLOSE("PPOLearner: Failed to find file \"" << fileName << "\" in " << folderPath << ".")
+		if (!std::filesystem::exists(folderPath / MODEL_FILE_NAMES[0]))
+			RG_ERR_CLOSE("PPOLearner: Failed to find file \"" << MODEL_FILE_NAMES[0] << "\" in " << folderPath << ".");
+
+		// Detect the layout of the checkpoint from its critic
+		bool hasCritic = std::filesystem::exists(folderPath / MODEL_FILE_NAMES[1]);
+		bool hasCriticHead = std::filesystem::exists(folderPath / CRITIC_HEAD_FILE_NAME);
+		if (sharedTrunk && !hasCriticHead) {
+			if (!hasCritic)
+				RG_ERR_CLOSE("PPOLearner: Failed to find file \"" << CRITIC_HEAD_FILE_NAME << "\" in " << folderPath << ".");
+
+			RG_LOG("WARNING: Checkpoint has a separate critic, but config.ppo.sharedTrunk is enabled, only its policy will be loaded (the critic head will be reset)");
+			loadCritic = false;
+		} else if (!sharedTrunk && !hasCritic) {
+			if (hasCriticHead)
+				RG_ERR_CLOSE("PPOLearner: Checkpoint in " << folderPath << " has a shared trunk, enable config.ppo.sharedTrunk to load it");
+
+			RG_ERR_CLOSE("PPOLearner: Failed to find file \"" << MODEL_FILE_NAMES[1] << "\" in " << folderPath << ".");
+		}
 	}
 
 	TorchLoadSaveSeq(learner->policy->seq, folderPath / MODEL_FILE_NAMES[0], learner->device, load);
-	TorchLoadSaveSeq(learner->valueNet->seq, folderPath / MODEL_FILE_NAMES[1], learner->device, load);
+	if (loadCritic)
+		TorchLoadSaveSeq(learner->valueNet->seq, folderPath / _GetModelFileName(1, sharedTrunk), learner->device, load);
 
 	if (load) {
 		if (learner->policyHalf)
 			_CopyModelParamsHalf(learner->policy, learner->policyHalf);
 		if (learner->valueNetHalf)
 			_CopyModelParamsHalf(learner->valueNet, learner->valueNetHalf);
+		learner->_SyncReplicas(true);
 	}
 
 	// Load or save optimizers
 	if (load) {
 		try {
-			for (int i = 0; i < 2; i++) {
-				auto path = folderPath / OPTIM_FILE_NAMES[i];
+			for (int i = 0; i < (loadCritic ? 2 : 1); i++) {
+				auto path = folderPath / _GetOptimFileName(i, sharedTrunk);
 
 				if (!std::filesystem::exists(path)) {
 					RG_LOG("WARNING: No optimizer found at " << path << ", optimizer will be reset");
@@ -353,7 +785,7 @@ void TorchLoadSaveAll(RLGPC::PPOLearner* learner, std::filesystem::path folderPa
 		for (int i = 0; i < 2; i++) {
 			torch::serialize::OutputArchive policyOptArchive;
 			(i ? learner->valueOptimizer : learner->policyOptimizer)->save(policyOptArchive);
-			policyOptArchive.save_to((folderPath / OPTIM_FILE_NAMES[i]).string());
+			policyOptArchive.save_to((folderPath / _GetOptimFileName(i, sharedTrunk)).string());
 		}
 	}
 }
@@ -373,6 +805,139 @@ void RLGPC::PPOLearner::LoadFrom(std::filesystem::path folderPath)  {
 	UpdateLearningRates(config.policyLR, config.criticLR);
 }
 
+RLGPC::PPOLearner::Snapshot RLGPC::PPOLearner::MakeSnapshot() {
+	RG_NOGRAD;
+
+	Snapshot result = {};
+	result.sharedTrunk = config.sharedTrunk;
+	result.policy = MakePolicySnapshot();
+	result.valueNet = torch::nn::Sequential(std::dynamic_pointer_cast<torch::nn::SequentialImpl>(valueNet->seq->clone(torch::kCPU)));
+
+	// Optimizer archives only reference the optimizer's tensors, so they need to be serialized now
+	for (int i = 0; i < 2; i++) {
+		torch::serialize::OutputArchive optArchive;
+		(i ? valueOptimizer : policyOptimizer)->save(optArchive);
+
+		std::ostringstream stream;
+		optArchive.save_to(stream);
+		(i ? result.valueOptim : result.policyOptim) = stream.str();
+	}
+
+	return result;
+}
+
+torch::nn::Sequential RLGPC::PPOLearner::MakePolicySnapshot() {
+	RG_NOGRAD;
+	return torch::nn::Sequential(std::dynamic_pointer_cast<torch::nn::SequentialImpl>(policy->seq->clone(torch::kCPU)));
+}
+
+void RLGPC::PPOLearner::SavePolicySnapshotTo(const torch::nn::Sequential& policySnapshot, std::filesystem::path path) {
+	auto streamOut = std::ofstream(path, std::ios::binary);
+	torch::save(policySnapshot, streamOut);
+	if (!streamOut.good())
+		RG_ERR_CLOSE("PPOLearner::SavePolicySnapshotTo(): Failed to write " << path);
+}
+
+void RLGPC::PPOLearner::SaveSnapshotTo(const Snapshot& snapshot, std::filesystem::path folderPath) {
+	for (int i = 0; i < 2; i++) {
+		auto streamOut = std::ofstream(folderPath / _GetModelFileName(i, snapshot.sharedTrunk), std::ios::binary);
+		torch::save(i ? snapshot.valueNet : snapshot.policy, streamOut);
+	}
+
+	for (int i = 0; i < 2; i++) {
+		auto& optData = i ? snapshot.valueOptim : snapshot.policyOptim;
+		auto path = folderPath / _GetOptimFileName(i, snapshot.sharedTrunk);
+		auto streamOut = std::ofstream(path, std::ios::binary);
+		streamOut.write(optData.data(), optData.size());
+		if (!streamOut.good())
+			RG_ERR_CLOSE("PPOLearner::SaveSnapshotTo(): Failed to write " << path);
+	}
+}
+
+void RLGPC::PPOLearner::SaveSnapshotToFile(const Snapshot& snapshot, std::filesystem::path path, const std::map<std::string, std::string>& extraEntries) {
+	CheckpointFileWriter writer = {};
+	TorchFuncs::AddSeqToFile(writer, snapshot.policy, POLICY_ENTRY_PREFIX);
+	TorchFuncs::AddSeqToFile(writer, snapshot.valueNet, snapshot.sharedTrunk ? CRITIC_HEAD_ENTRY_PREFIX : CRITIC_ENTRY_PREFIX);
+	writer.AddBytes("policy_optim", snapshot.policyOptim.data(), snapshot.policyOptim.size());
+	writer.AddBytes(snapshot.sharedTrunk ? "critic_head_optim" : "critic_optim", snapshot.valueOptim.data(), snapshot.valueOptim.size());
+	for (auto& pair : extraEntries)
+		writer.AddBytes(pair.first, pair.second.data(), pair.second.size());
+
+	writer.Save(path);
+}
+
+void RLGPC::PPOLearner::LoadFromFile(const CheckpointFile& file) {
+	RG_LOG("PPOLearner(): Loading models from: " << file.path);
+
+	// Detect the layout of the checkpoint from its critic
+	std::string firstCriticParam = valueNet->seq->named_parameters().begin()->key();
+	bool hasCriticHead = file.Find(CRITIC_HEAD_ENTRY_PREFIX + firstCriticParam);
+	bool loadCritic = true;
+	if (config.sharedTrunk && !hasCriticHead) {
+		RG_LOG("WARNING: Checkpoint has a separate critic, but config.ppo.sharedTrunk is enabled, only its policy will be loaded (the critic head will be reset)");
+		loadCritic = false;
+	} else if (!config.sharedTrunk && hasCriticHead) {
+		RG_ERR_CLOSE("PPOLearner: Checkpoint " << file.path << " has a shared trunk, enable config.ppo.sharedTrunk to load it");
+	}
+
+	TorchFuncs::LoadSeqFromFile(policy->seq, file, POLICY_ENTRY_PREFIX);
+	if (loadCritic)
+		TorchFuncs::LoadSeqFromFile(valueNet->seq, file, config.sharedTrunk ? CRITIC_HEAD_ENTRY_PREFIX : CRITIC_ENTRY_PREFIX);
+
+	if (policyHalf)
+		_CopyModelParamsHalf(policy, policyHalf);
+	if (valueNetHalf)
+		_CopyModelParamsHalf(valueNet, valueNetHalf);
+	_SyncReplicas(true);
+
+	for (int i = 0; i < (loadCritic ? 2 : 1); i++) {
+		const char* name = i ? (config.sharedTrunk ? "critic_head_optim" : "critic_optim") : "policy_optim";
+		auto entry = file.Find(name);
+		if (!entry || entry->size == 0) {
+			RG_LOG("WARNING: No optimizer found in " << file.path << ", optimizer will be reset");
+			continue;
+		}
+
+		try {
+			torch::serialize::InputArchive optArchive;
+			optArchive.load_from((const char*)entry->data, entry->size, device);
+			(i ? valueOptimizer : policyOptimizer)->load(optArchive);
+		} catch (std::exception& e) {
+			RG_ERR_CLOSE(
+				"Failed to load optimizers, exception: " << e.what() << "\n" <<
+				"Checkpoint may be corrupt."
+			);
+		}
+	}
+
+	UpdateLearningRates(config.policyLR, config.criticLR);
+}
+
+RLGPC::PPOLearner::PretrainResult RLGPC::PPOLearner::PretrainPolicy(Tensor obs, Tensor actions) {
+	obs = obs.to(device, true);
+	actions = actions.to(device, true);
+
+	auto logProbs = policy->GetLogProbs(obs);
+	auto loss = nn::functional::nll_loss(logProbs, actions);
+
+	policyOptimizer->zero_grad();
+	loss.backward();
+	nn::utils::clip_grad_norm_(policy->parameters(), 0.5f);
+	policyOptimizer->step();
+
+	RG_NOGRAD;
+	auto accuracy = (logProbs.argmax(-1) == actions).to(kFloat).mean();
+	return PretrainResult{ loss.detach(), accuracy };
+}
+
+void RLGPC::PPOLearner::UpdateModelCopies() {
+	if (policyHalf)
+		_CopyModelParamsHalf(policy, policyHalf);
+	if (valueNetHalf)
+		_CopyModelParamsHalf(valueNet, valueNetHalf);
+	_SyncReplicas(true);
+}
+
 void RLGPC::PPOLearner::UpdateLearningRates(float policyLR, float criticLR) {
 	config.policyLR = policyLR;
 	config.criticLR = criticLR;
@@ -386,4 +951,20 @@ void RLGPC::PPOLearner::UpdateLearningRates(float policyLR, float criticLR) {
 	std::stringstream updatedMsg;
 	updatedMsg << std::scientific << "Updated learning rate to [" << policyLR << ", " << criticLR << "]";
 	RG_LOG("PPOLearner: " << updatedMsg.str());
+}
+
+void RLGPC::PPOLearner::SetOBSStandardization(const OBSStandardization& standardization) {
+	policy->SetOBSStandardization(standardization);
+	valueNet->SetOBSStandardization(standardization);
+	if (policyHalf)
+		policyHalf->SetOBSStandardization(standardization);
+	if (valueNetHalf)
+		valueNetHalf->SetOBSStandardization(standardization);
+
+	for (auto& replica : replicas) {
+		replica.policy->SetOBSStandardization(standardization);
+		replica.valueNet->SetOBSStandardization(standardization);
+		if (replica.policyHalf)
+			replica.policyHalf->SetOBSStandardization(standardization);
+	}
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include <torch/optim/adam.h>
 #include <torch/nn/modules/loss.h>
 #include "../Util/gradscaler.hpp"
+#include "../Util/CUDAPhaseTimer.h"
+#include "../Util/DeviceScalarReader.h"
 
 namespace RLGPC {
 	// https://github.com/AechPro/rlgym-ppo/blob/main/rlgym_ppo/ppo/ppo_learner.py
@@ -22,18 +24,89 @@ namespace RLGPC {
 		PPOLearnerConfig config;
 		torch::Device device;
 
+		// Copies of the models on the other GPUs, only used if config.numGPUs > 1
+		struct Replica {
+			torch::Device device;
+			DiscretePolicy* policy, *policyHalf;
+			ValueEstimator* valueNet;
+		};
+		std::vector<Replica> replicas;
+
 		int cumulativeModelUpdates = 0;
 
+		// Only used with config.targetKL
+		DeviceScalarReader* klReader = NULL;
+		int numLearns = 0, numEarlyStops = 0;
+
+		// Only used with config.gpuEventTiming
+		CUDAPhaseTimer* gpuTimer = NULL;
+		enum GPUPhase {
+			GPU_PHASE_TRANSFER,
+			GPU_PHASE_FORWARD,
+			GPU_PHASE_BACKWARD,
+			GPU_PHASE_CLIP,
+			GPU_PHASE_OPTIMIZER,
+			GPU_PHASE_AMOUNT
+		};
+
 		PPOLearner(
 			int obsSpaceSize, int actSpaceSize,
 			PPOLearnerConfig config, torch::Device device
 		);
 		
-		void Learn(ExperienceBuffer* expBuffer, Report& report);
+		// Runs a forward and backward pass of both models on a synthetic minibatch, like Learn() does, without changing the models
+		// Lets the device's allocator and GEMM libraries (cuBLAS, oneDNN) settle on our shapes before the first real learn
+		void Warmup();
+
+		// Runs numEpochs epochs (config.epochs if negative) on the experience buffer
+		// If numNewest is not 0, only the newest numNewest steps of the buffer are learned from
+		void Learn(ExperienceBuffer* expBuffer, Report& report, int numEpochs = -1, int64_t numNewest = 0);
 
 		void SaveTo(std::filesystem::path folderPath);
 		void LoadFrom(std::filesystem::path folderPath);
 
+		// Copy of everything SaveTo() writes, which can be saved from another thread while we keep learning
+		struct Snapshot {
+			torch::nn::Sequential policy, valueNet; // CPU copies
+			std::string policyOptim, valueOptim; // Serialized optimizer archives
+			bool sharedTrunk; // If valueNet is only a critic head (see PPOLearnerConfig::sharedTrunk)
+		};
+		Snapshot MakeSnapshot();
+
+		// CPU copy of only the policy, for policy snapshots (see LearnerConfig::timestepsPerPolicySnapshot)
+		torch::nn::Sequential MakePolicySnapshot();
+		static void SavePolicySnapshotTo(const torch::nn::Sequential& policySnapshot, std::filesystem::path path);
+		static void SaveSnapshotTo(const Snapshot& snapshot, std::filesystem::path folderPath);
+
+		// Name of the policy's file in checkpoint folders
+		constexpr static const char* POLICY_FILE_NAME = "PPO_POLICY.lt";
+
+		// Prefixes of the parameter entries of each model in a single-file checkpoint
+		constexpr static const char* POLICY_ENTRY_PREFIX = "policy.";
+		constexpr static const char* CRITIC_ENTRY_PREFIX = "critic.";
+		constexpr static const char* CRITIC_HEAD_ENTRY_PREFIX = "critic_head."; // With a shared trunk
+
+		// Saves a snapshot as a single checkpoint file (see CheckpointFile), along with extra BYTES entries
+		static void SaveSnapshotToFile(const Snapshot& snapshot, std::filesystem::path path, const std::map<std::string, std::string>& extraEntries);
+		void LoadFromFile(const class CheckpointFile& file);
+
 		void UpdateLearningRates(float policyLR, float criticLR);
+
+		// Behavior cloning: one supervised step of the policy towards choosing these actions, with the policy's optimizer
+		// The loss and accuracy are left on the device, so that this doesn't wait for the step to finish
+		struct PretrainResult {
+			torch::Tensor loss, accuracy;
+		};
+		PretrainResult PretrainPolicy(torch::Tensor obs, torch::Tensor actions);
+
+		// Copies our models to their half-precision copies and replicas, needed after they are updated
+		void UpdateModelCopies();
+
+		// Sets the observation standardization of all of our models and their copies
+		void SetOBSStandardization(const OBSStandardization& standardization);
+
+		// Copies our parameters to the replicas
+		// If withHalf, the half-precision policies of the replicas are also updated
+		void _SyncReplicas(bool withHalf);
 	};
 }
\ No newline at end of file
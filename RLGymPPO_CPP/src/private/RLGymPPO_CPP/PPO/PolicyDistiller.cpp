@@ -0,0 +1,52 @@
+#include "PolicyDistiller.h"
+#include "PPOLearner.h"
+
+#include <torch/nn/utils/clip_grad.h>
+#include <torch/csrc/api/include/torch/serialize.h>
+
+using namespace torch;
+
+RLGPC::PolicyDistiller::PolicyDistiller(DiscretePolicy* teacher, const IList& studentLayerSizes, float learningRate) {
+	student = new DiscretePolicy(teacher->inputAmount, teacher->actionAmount, studentLayerSizes, teacher->device);
+	if (teacher->obsStandardization.IsSet())
+		student->SetOBSStandardization(teacher->obsStandardization);
+
+	optimizer = new optim::Adam(student->parameters(), optim::AdamOptions(learningRate));
+}
+
+RLGPC::PolicyDistiller::StepResult RLGPC::PolicyDistiller::Step(DiscretePolicy* teacher, Tensor obs) {
+	obs = obs.to(student->device, true);
+
+	Tensor teacherLogProbs;
+	{
+		RG_NOGRAD;
+		teacherLogProbs = teacher->GetLogProbs(obs);
+	}
+
+	auto studentLogProbs = student->GetLogProbs(obs);
+	auto kl = (teacherLogProbs.exp() * (teacherLogProbs - studentLogProbs)).sum(-1).mean();
+
+	optimizer->zero_grad();
+	kl.backward();
+	nn::utils::clip_grad_norm_(student->parameters(), 0.5f);
+	optimizer->step();
+
+	RG_NOGRAD;
+	auto agreement = (studentLogProbs.argmax(-1) == teacherLogProbs.argmax(-1)).to(kFloat).mean();
+	return StepResult{ kl.detach(), agreement };
+}
+
+void RLGPC::PolicyDistiller::SaveTo(std::filesystem::path folderPath) {
+	std::filesystem::create_directories(folderPath);
+
+	auto path = folderPath / PPOLearner::POLICY_FILE_NAME;
+	auto streamOut = std::ofstream(path, std::ios::binary);
+	torch::save(student->seq, streamOut);
+	if (!streamOut.good())
+		RG_ERR_CLOSE("PolicyDistiller::SaveTo(): Failed to write " << path);
+}
+
+RLGPC::PolicyDistiller::~PolicyDistiller() {
+	delete optimizer;
+	delete student;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "DiscretePolicy.h"
+
+#include <torch/optim/adam.h>
+
+namespace RLGPC {
+	// Trains a smaller student policy to choose actions like a teacher policy, for cheaper inference
+	// The student minimizes KL(teacher || student) of their action distributions, on the same observations
+	class PolicyDistiller {
+	public:
+		DiscretePolicy* student;
+		torch::optim::Adam* optimizer;
+
+		// The student uses the teacher's OBS standardization
+		PolicyDistiller(DiscretePolicy* teacher, const IList& studentLayerSizes, float learningRate);
+		RG_NO_COPY(PolicyDistiller);
+
+		// Results are left on the device, so that this doesn't wait for the step to finish
+		struct StepResult {
+			torch::Tensor kl;
+			torch::Tensor agreement; // Fraction of observations where the most likely actions of the student and teacher are the same
+		};
+		StepResult Step(DiscretePolicy* teacher, torch::Tensor obs);
+
+		// Saves the student as PPOLearner::POLICY_FILE_NAME in folderPath
+		void SaveTo(std::filesystem::path folderPath);
+
+		~PolicyDistiller();
+	};
+}
@@ -0,0 +1,139 @@
+#include "PolicyGraph.h"
+
+#include "../FrameworkTorch.h"
+
+// Defined by CMake if libtorch was built with CUDA
+#ifdef RG_CUDA_GRAPHS
+#include <ATen/cuda/CUDAGraph.h>
+#include <c10/cuda/CUDAGuard.h>
+#include <c10/cuda/CUDAStream.h>
+#endif
+
+struct RLGPC::PolicyGraph::Graph {
+	int64_t batchSize;
+
+	// The graph always reads from and writes to these exact tensors
+	torch::Tensor staticObs, staticResult; // staticResult is packed (see DiscretePolicy::PackResult())
+
+	// Parameter memory the graph was captured with
+	// If the policy's parameters get re-allocated (i.e. from loading), the graph needs to be captured again
+	std::vector<void*> paramPtrs;
+
+#ifdef RG_CUDA_GRAPHS
+	at::cuda::CUDAGraph cudaGraph;
+#endif
+};
+
+RLGPC::PolicyGraph::PolicyGraph(DiscretePolicy* policy, bool deterministic) :
+	policy(policy), deterministic(deterministic) {
+
+	if (!IsSupported() || !policy->device.is_cuda())
+		disabled = true;
+}
+
+bool RLGPC::PolicyGraph::IsSupported() {
+#ifdef RG_CUDA_GRAPHS
+	return true;
+#else
+	return false;
+#endif
+}
+
+std::vector<void*> RLGPC::PolicyGraph::_GetParamPtrs() {
+	std::vector<void*> result = {};
+	for (auto& param : policy->parameters())
+		result.push_back(param.data_ptr());
+	return result;
+}
+
+RLGPC::PolicyGraph::Graph* RLGPC::PolicyGraph::_Capture(torch::Tensor obs) {
+#ifdef RG_CUDA_GRAPHS
+	RG_NOGRAD;
+
+	Graph* graph = new Graph();
+	graph->batchSize = obs.size(0);
+	graph->paramPtrs = _GetParamPtrs();
+
+	try {
+		graph->staticObs = obs.to(policy->device).clone();
+
+		// Capturing can't be done on the default stream
+		// The capture stream also needs to start after everything on the current stream is done
+		c10::cuda::getCurrentCUDAStream().synchronize();
+		auto captureStream = c10::cuda::getStreamFromPool();
+		{
+			c10::cuda::CUDAStreamGuard streamGuard(captureStream);
+
+			// Warm up so that lazy initialization (i.e. cuBLAS handles) doesn't happen during capture
+			for (int i = 0; i < WARMUP_ITERATIONS; i++)
+				policy->GetActionDevice(graph->staticObs, deterministic);
+			captureStream.synchronize();
+
+			// Thread-local capture mode, so other agents can keep using CUDA while we capture
+			graph->cudaGraph.capture_begin({ 0, 0 }, cudaStreamCaptureModeThreadLocal);
+			auto result = policy->GetActionDevice(graph->staticObs, deterministic);
+			graph->staticResult = DiscretePolicy::PackResult(result);
+			graph->cudaGraph.capture_end();
+			captureStream.synchronize();
+		}
+	} catch (std::exception& e) {
+		RG_LOG("PolicyGraph: Failed to capture CUDA graph for batch size " << graph->batchSize << ", falling back to normal inference");
+		RG_LOG("\tException: " << e.what());
+		delete graph;
+		disabled = true;
+		return NULL;
+	}
+
+	_graphs.push_back(graph);
+	return graph;
+#else
+	return NULL;
+#endif
+}
+
+RLGPC::DiscretePolicy::ActionResult RLGPC::PolicyGraph::GetAction(torch::Tensor obs, torch::Tensor readback) {
+	if (!disabled) {
+#ifdef RG_CUDA_GRAPHS
+		// The policy can be on a different GPU than the current one (see PPOLearnerConfig::numGPUs)
+		c10::cuda::OptionalCUDAGuard deviceGuard;
+		if (policy->device.has_index())
+			deviceGuard.set_index(policy->device.index());
+#endif
+
+		int64_t batchSize = obs.size(0);
+
+		Graph* graph = NULL;
+		for (int i = 0; i < _graphs.size(); i++) {
+			if (_graphs[i]->batchSize == batchSize) {
+				if (_graphs[i]->paramPtrs == _GetParamPtrs()) {
+					graph = _graphs[i];
+				} else {
+					// Parameters moved, this graph would read from old memory
+					delete _graphs[i];
+					_graphs.erase(_graphs.begin() + i);
+				}
+				break;
+			}
+		}
+
+		if (!graph && _graphs.size() < MAX_GRAPHS)
+			graph = _Capture(obs);
+
+#ifdef RG_CUDA_GRAPHS
+		if (graph) {
+			graph->staticObs.copy_(obs, true);
+			graph->cudaGraph.replay();
+
+			// Copying back to the CPU waits for the replay to finish
+			return DiscretePolicy::ReadBackResult(graph->staticResult, readback);
+		}
+#endif
+	}
+
+	return policy->GetAction(obs.to(policy->device, true), deterministic, readback);
+}
+
+RLGPC::PolicyGraph::~PolicyGraph() {
+	for (Graph* graph : _graphs)
+		delete graph;
+}
\ No newline at end of file
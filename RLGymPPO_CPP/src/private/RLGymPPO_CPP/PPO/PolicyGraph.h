@@ -0,0 +1,41 @@
+#pragma once
+#include "DiscretePolicy.h"
+
+namespace RLGPC {
+	// Captures DiscretePolicy::GetAction() into CUDA graphs, and replays them instead of launching every kernel again
+	// For small policies, kernel launch overhead is most of the inference time, and this removes nearly all of it
+	// A graph is captured for each batch size we see (up to MAX_GRAPHS), other batch sizes use normal inference
+	// If capturing fails, or we are not built with CUDA graph support, we always use normal inference
+	// NOTE: Not thread-safe, each thread that infers should have its own PolicyGraph
+	class PolicyGraph {
+	public:
+		DiscretePolicy* policy;
+		bool deterministic;
+
+		constexpr static int MAX_GRAPHS = 4;
+
+		// Amount of normal inferences to run on the capture stream before capturing
+		constexpr static int WARMUP_ITERATIONS = 3;
+
+		// Set if capturing failed, or graphs are not supported
+		bool disabled = false;
+
+		PolicyGraph(DiscretePolicy* policy, bool deterministic);
+		RG_NO_COPY(PolicyGraph);
+
+		// Returns true if CUDA graphs are supported by the libtorch we are built with
+		static bool IsSupported();
+
+		// NOTE: obs is copied into the graph's static input, and the results are copied back to the CPU (into readback if set, see DiscretePolicy::ReadBackResult())
+		DiscretePolicy::ActionResult GetAction(torch::Tensor obs, torch::Tensor readback = {});
+
+		~PolicyGraph();
+
+	private:
+		struct Graph;
+		std::vector<Graph*> _graphs;
+
+		Graph* _Capture(torch::Tensor obs);
+		std::vector<void*> _GetParamPtrs();
+	};
+}
\ No newline at end of file
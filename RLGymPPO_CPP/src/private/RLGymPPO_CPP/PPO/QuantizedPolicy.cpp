@@ -0,0 +1,350 @@
+#include "QuantizedPolicy.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace RLGPC;
+
+constexpr int OUTPUT_BLOCK = QuantizedPolicy::OUTPUT_BLOCK;
+constexpr int ROW_BLOCK = NativePolicy::ROW_BLOCK;
+
+constexpr uint32_t QUANT_FILE_MAGIC = 0x50514752; // "RGQP"
+constexpr uint32_t QUANT_FILE_VERSION = 1;
+
+inline uint16_t _FloatToBF16(float val) {
+	uint32_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+	// Round to nearest even
+	bits += 0x7FFF + ((bits >> 16) & 1);
+	return (uint16_t)(bits >> 16);
+}
+
+inline float _BF16ToFloat(uint16_t val) {
+	uint32_t bits = (uint32_t)val << 16;
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+// Quantizes each row of [rows][inStride] to int8 values, with one scale per row
+// Outputs are int16 as [rows][inPairs * 2], with zeros after inSize
+void _QuantizeRows(const float* in, int inStride, int inSize, int inPairs, int rows, int16_t* out, float* outScales) {
+	for (int r = 0; r < rows; r++) {
+		const float* row = in + (size_t)r * inStride;
+		int16_t* rowOut = out + (size_t)r * inPairs * 2;
+
+		float maxAbs = 0;
+		for (int k = 0; k < inSize; k++)
+			maxAbs = RS_MAX(maxAbs, fabsf(row[k]));
+
+		float scale = (maxAbs > 0) ? (maxAbs / 127) : 1;
+		float invScale = 1 / scale;
+		for (int k = 0; k < inSize; k++)
+			rowOut[k] = (int16_t)roundf(RS_CLAMP(row[k] * invScale, -127, 127));
+		for (int k = inSize; k < inPairs * 2; k++)
+			rowOut[k] = 0;
+		outScales[r] = scale;
+	}
+}
+
+// Computes one OUTPUT_BLOCK of outputs for ROWS rows, see NativePolicy's _LayerKernel()
+// in: [ROWS][inPairs * 2], weights: [inPairs][OUTPUT_BLOCK][2]
+// Inputs are done in pairs, so that two multiplies and an add are one instruction (pmaddwd)
+template <int ROWS>
+void _LayerKernelI8(
+	const int16_t* in, int inPairs, const float* rowScales,
+	const int8_t* weights, const float* scales, const float* biases, float* out, int outStride, bool relu) {
+
+	int32_t acc[ROWS][OUTPUT_BLOCK];
+
+#if defined(__AVX2__)
+	static_assert(OUTPUT_BLOCK == 16);
+	__m256i accLo[ROWS], accHi[ROWS];
+	for (int r = 0; r < ROWS; r++)
+		accLo[r] = accHi[r] = _mm256_setzero_si256();
+
+	for (int p = 0; p < inPairs; p++) {
+		__m256i w = _mm256_loadu_si256((const __m256i*)(weights + p * OUTPUT_BLOCK * 2));
+		__m256i wLo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(w));
+		__m256i wHi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(w, 1));
+		for (int r = 0; r < ROWS; r++) {
+			int32_t pair;
+			memcpy(&pair, in + (size_t)r * inPairs * 2 + p * 2, sizeof(pair));
+			__m256i x = _mm256_set1_epi32(pair);
+			accLo[r] = _mm256_add_epi32(accLo[r], _mm256_madd_epi16(wLo, x));
+			accHi[r] = _mm256_add_epi32(accHi[r], _mm256_madd_epi16(wHi, x));
+		}
+	}
+
+	for (int r = 0; r < ROWS; r++) {
+		_mm256_storeu_si256((__m256i*)acc[r], accLo[r]);
+		_mm256_storeu_si256((__m256i*)(acc[r] + 8), accHi[r]);
+	}
+#else
+	for (int r = 0; r < ROWS; r++)
+		for (int j = 0; j < OUTPUT_BLOCK; j++)
+			acc[r][j] = 0;
+
+	for (int p = 0; p < inPairs; p++) {
+		const int8_t* w = weights + p * OUTPUT_BLOCK * 2;
+		for (int r = 0; r < ROWS; r++) {
+			const int16_t* x = in + (size_t)r * inPairs * 2 + p * 2;
+			for (int j = 0; j < OUTPUT_BLOCK; j++)
+				acc[r][j] += x[0] * (int32_t)w[j * 2] + x[1] * (int32_t)w[j * 2 + 1];
+		}
+	}
+#endif
+
+	for (int r = 0; r < ROWS; r++) {
+		for (int j = 0; j < OUTPUT_BLOCK; j++) {
+			float val = acc[r][j] * rowScales[r] * scales[j] + biases[j];
+			if (relu && val < 0)
+				val = 0;
+			out[r * outStride + j] = val;
+		}
+	}
+}
+
+template <int ROWS>
+void _LayerKernelBF16(const float* in, int inStride, int inSize, const uint16_t* weights, const float* biases, float* out, int outStride, bool relu) {
+	float acc[ROWS][OUTPUT_BLOCK];
+	for (int r = 0; r < ROWS; r++)
+		for (int j = 0; j < OUTPUT_BLOCK; j++)
+			acc[r][j] = biases[j];
+
+	for (int k = 0; k < inSize; k++) {
+		float w[OUTPUT_BLOCK];
+		for (int j = 0; j < OUTPUT_BLOCK; j++)
+			w[j] = _BF16ToFloat(weights[k * OUTPUT_BLOCK + j]);
+
+		for (int r = 0; r < ROWS; r++) {
+			float x = in[r * inStride + k];
+			for (int j = 0; j < OUTPUT_BLOCK; j++)
+				acc[r][j] += x * w[j];
+		}
+	}
+
+	for (int r = 0; r < ROWS; r++) {
+		for (int j = 0; j < OUTPUT_BLOCK; j++) {
+			float val = acc[r][j];
+			if (relu && val < 0)
+				val = 0;
+			out[r * outStride + j] = val;
+		}
+	}
+}
+
+RLGPC::QuantizedPolicy::QuantizedPolicy(const NativePolicy& policy, PolicyQuantType type) :
+	type(type), inputAmount(policy.inputAmount), actionAmount(policy.actionAmount) {
+
+	for (auto& fromLayer : policy.layers) {
+		Layer layer = {};
+		layer.inSize = fromLayer.inSize;
+		layer.outSize = fromLayer.outSize;
+		layer.paddedOutSize = fromLayer.paddedOutSize;
+		layer.biases = fromLayer.biases;
+
+		if (type == PolicyQuantType::INT8) {
+			int numBlocks = layer.paddedOutSize / OUTPUT_BLOCK;
+			int inPairs = layer.GetInPairs();
+
+			layer.scales = std::vector<float>(layer.paddedOutSize, 1);
+			layer.weightsI8 = std::vector<int8_t>((size_t)numBlocks * inPairs * OUTPUT_BLOCK * 2, 0);
+			for (int block = 0; block < numBlocks; block++) {
+				const float* blockWeights = fromLayer.weights.data() + (size_t)block * layer.inSize * OUTPUT_BLOCK;
+				int8_t* toBlockWeights = layer.weightsI8.data() + (size_t)block * inPairs * OUTPUT_BLOCK * 2;
+
+				for (int j = 0; j < OUTPUT_BLOCK; j++) {
+					// Find the scale of this output channel
+					float maxAbs = 0;
+					for (int k = 0; k < layer.inSize; k++)
+						maxAbs = RS_MAX(maxAbs, fabsf(blockWeights[k * OUTPUT_BLOCK + j]));
+
+					float scale = (maxAbs > 0) ? (maxAbs / 127) : 1;
+					layer.scales[block * OUTPUT_BLOCK + j] = scale;
+
+					for (int k = 0; k < layer.inSize; k++) {
+						float val = roundf(RS_CLAMP(blockWeights[k * OUTPUT_BLOCK + j] / scale, -127, 127));
+						toBlockWeights[((k / 2) * OUTPUT_BLOCK + j) * 2 + (k % 2)] = (int8_t)val;
+					}
+				}
+			}
+		} else {
+			layer.weightsBF16.resize(fromLayer.weights.size());
+			for (size_t i = 0; i < fromLayer.weights.size(); i++)
+				layer.weightsBF16[i] = _FloatToBF16(fromLayer.weights[i]);
+		}
+
+		layers.push_back(layer);
+	}
+}
+
+template <typename T>
+void _WriteVals(std::ofstream& out, const T* vals, size_t amount) {
+	out.write((const char*)vals, amount * sizeof(T));
+}
+
+template <typename T>
+void _ReadVals(std::ifstream& in, T* vals, size_t amount) {
+	in.read((char*)vals, amount * sizeof(T));
+	if (!in)
+		RG_ERR_CLOSE("QuantizedPolicy: Unexpected end of file");
+}
+
+void RLGPC::QuantizedPolicy::Save(std::filesystem::path path) const {
+	std::ofstream out = std::ofstream(path, std::ios::binary);
+	if (!out.good())
+		RG_ERR_CLOSE("QuantizedPolicy::Save(): Failed to open " << path);
+
+	uint32_t header[] = { QUANT_FILE_MAGIC, QUANT_FILE_VERSION, (uint32_t)type, (uint32_t)layers.size() };
+	_WriteVals(out, header, 4);
+
+	for (auto& layer : layers) {
+		int32_t sizes[] = { layer.inSize, layer.outSize };
+		_WriteVals(out, sizes, 2);
+
+		if (type == PolicyQuantType::INT8) {
+			_WriteVals(out, layer.weightsI8.data(), layer.weightsI8.size());
+			_WriteVals(out, layer.scales.data(), layer.scales.size());
+		} else {
+			_WriteVals(out, layer.weightsBF16.data(), layer.weightsBF16.size());
+		}
+		_WriteVals(out, layer.biases.data(), layer.biases.size());
+	}
+}
+
+RLGPC::QuantizedPolicy::QuantizedPolicy(std::filesystem::path path) {
+	std::ifstream in = std::ifstream(path, std::ios::binary);
+	if (!in.good())
+		RG_ERR_CLOSE("QuantizedPolicy: Failed to open " << path);
+
+	uint32_t header[4];
+	_ReadVals(in, header, 4);
+	if (header[0] != QUANT_FILE_MAGIC)
+		RG_ERR_CLOSE("QuantizedPolicy: " << path << " is not a quantized policy");
+	if (header[1] != QUANT_FILE_VERSION)
+		RG_ERR_CLOSE("QuantizedPolicy: " << path << " has unsupported version " << header[1]);
+
+	type = (PolicyQuantType)header[2];
+	if (type != PolicyQuantType::INT8 && type != PolicyQuantType::BF16)
+		RG_ERR_CLOSE("QuantizedPolicy: " << path << " has unknown quantization type " << header[2]);
+
+	layers.resize(header[3]);
+	for (int i = 0; i < layers.size(); i++) {
+		Layer& layer = layers[i];
+		int32_t sizes[2];
+		_ReadVals(in, sizes, 2);
+		layer.inSize = sizes[0];
+		layer.outSize = sizes[1];
+		layer.paddedOutSize = ((layer.outSize + OUTPUT_BLOCK - 1) / OUTPUT_BLOCK) * OUTPUT_BLOCK;
+
+		if (i > 0 && layer.inSize != layers[i - 1].outSize)
+			RG_ERR_CLOSE("QuantizedPolicy: " << path << " has mismatched layer sizes");
+
+		if (type == PolicyQuantType::INT8) {
+			size_t numWeights = (size_t)layer.GetInPairs() * 2 * layer.paddedOutSize;
+			layer.weightsI8.resize(numWeights);
+			_ReadVals(in, layer.weightsI8.data(), numWeights);
+			layer.scales.resize(layer.paddedOutSize);
+			_ReadVals(in, layer.scales.data(), layer.paddedOutSize);
+		} else {
+			size_t numWeights = (size_t)layer.inSize * layer.paddedOutSize;
+			layer.weightsBF16.resize(numWeights);
+			_ReadVals(in, layer.weightsBF16.data(), numWeights);
+		}
+		layer.biases.resize(layer.paddedOutSize);
+		_ReadVals(in, layer.biases.data(), layer.paddedOutSize);
+	}
+
+	if (layers.empty())
+		RG_ERR_CLOSE("QuantizedPolicy: " << path << " has no layers");
+
+	inputAmount = layers.front().inSize;
+	actionAmount = layers.back().outSize;
+}
+
+void RLGPC::QuantizedPolicy::Infer(const float* obs, int batchSize, int64_t* outActions, float* outLogProbs, bool deterministic, std::mt19937& rng) const {
+	if (batchSize <= 0)
+		return;
+
+	thread_local std::vector<float> scratch[2];
+	thread_local std::vector<int16_t> quantIn;
+	thread_local std::vector<float> rowScales;
+
+	const float* in = obs;
+	int inStride = inputAmount;
+	for (int i = 0; i < layers.size(); i++) {
+		auto& layer = layers[i];
+		auto& outBuffer = scratch[i % 2];
+		size_t outSize = (size_t)batchSize * layer.paddedOutSize;
+		if (outBuffer.size() < outSize)
+			outBuffer.resize(outSize);
+
+		bool relu = (i < layers.size() - 1);
+		int outStride = layer.paddedOutSize;
+
+		if (type == PolicyQuantType::INT8) {
+			quantIn.resize((size_t)batchSize * layer.GetInPairs() * 2);
+			rowScales.resize(batchSize);
+			_QuantizeRows(in, inStride, layer.inSize, layer.GetInPairs(), batchSize, quantIn.data(), rowScales.data());
+		}
+
+		for (int block = 0; block < layer.paddedOutSize / OUTPUT_BLOCK; block++) {
+			const float* biases = layer.biases.data() + block * OUTPUT_BLOCK;
+			float* blockOut = outBuffer.data() + block * OUTPUT_BLOCK;
+
+			for (int row = 0; row < batchSize;) {
+				int rows = (row + ROW_BLOCK <= batchSize) ? ROW_BLOCK : 1;
+				float* rowOut = blockOut + (size_t)row * outStride;
+
+				if (type == PolicyQuantType::INT8) {
+					int inPairs = layer.GetInPairs();
+					const int16_t* rowIn = quantIn.data() + (size_t)row * inPairs * 2;
+					const int8_t* weights = layer.weightsI8.data() + (size_t)block * inPairs * OUTPUT_BLOCK * 2;
+					const float* scales = layer.scales.data() + block * OUTPUT_BLOCK;
+					if (rows == ROW_BLOCK) {
+						_LayerKernelI8<ROW_BLOCK>(rowIn, inPairs, rowScales.data() + row, weights, scales, biases, rowOut, outStride, relu);
+					} else {
+						_LayerKernelI8<1>(rowIn, inPairs, rowScales.data() + row, weights, scales, biases, rowOut, outStride, relu);
+					}
+				} else {
+					const float* rowIn = in + (size_t)row * inStride;
+					const uint16_t* weights = layer.weightsBF16.data() + (size_t)block * layer.inSize * OUTPUT_BLOCK;
+					if (rows == ROW_BLOCK) {
+						_LayerKernelBF16<ROW_BLOCK>(rowIn, inStride, layer.inSize, weights, biases, rowOut, outStride, relu);
+					} else {
+						_LayerKernelBF16<1>(rowIn, inStride, layer.inSize, weights, biases, rowOut, outStride, relu);
+					}
+				}
+
+				row += rows;
+			}
+		}
+
+		in = outBuffer.data();
+		inStride = outStride;
+	}
+
+	NativePolicy::SampleActions(in, inStride, batchSize, actionAmount, outActions, outLogProbs, deterministic, rng);
+}
+
+float RLGPC::QuantizedPolicy::GetActionAgreement(const NativePolicy& policy, const float* obs, int amount) const {
+	if (amount <= 0)
+		return 1;
+
+	std::vector<int64_t> actions = std::vector<int64_t>(amount), quantActions = std::vector<int64_t>(amount);
+	std::vector<float> logProbs = std::vector<float>(amount);
+
+	// Not used for deterministic actions
+	std::mt19937 rng = {};
+
+	policy.Infer(obs, amount, actions.data(), logProbs.data(), true, rng);
+	Infer(obs, amount, quantActions.data(), logProbs.data(), true, rng);
+
+	int numAgreed = 0;
+	for (int i = 0; i < amount; i++)
+		numAgreed += (actions[i] == quantActions[i]);
+
+	return numAgreed / (float)amount;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include "NativePolicy.h"
+#include <RLGymPPO_CPP/Util/PolicyInferUnit.h>
+
+namespace RLGPC {
+	// Reduced-precision version of a NativePolicy, for deployment on CPU
+	// INT8: Per-output-channel int8 weights, activations are quantized per-row when inferring, accumulation is in int32
+	// BF16: bfloat16 weights, accumulation is in fp32
+	// INT8 weights use a quarter of the memory of a NativePolicy, BF16 weights use half
+	class QuantizedPolicy {
+	public:
+		PolicyQuantType type;
+		int inputAmount, actionAmount;
+
+		constexpr static int OUTPUT_BLOCK = NativePolicy::OUTPUT_BLOCK;
+
+		struct Layer {
+			int inSize, outSize, paddedOutSize;
+
+			// Only for INT8, packed as [paddedOutSize / OUTPUT_BLOCK][GetInPairs()][OUTPUT_BLOCK][2]
+			// Each pair of inputs is packed together, with zeros if inSize is odd
+			std::vector<int8_t> weightsI8;
+
+			// Only for BF16, same packing as NativePolicy::Layer
+			std::vector<uint16_t> weightsBF16;
+
+			// [paddedOutSize], only for INT8
+			std::vector<float> scales;
+
+			// [paddedOutSize], always full precision
+			std::vector<float> biases;
+
+			int GetInPairs() const {
+				return (inSize + 1) / 2;
+			}
+		};
+		std::vector<Layer> layers;
+
+		QuantizedPolicy(const NativePolicy& policy, PolicyQuantType type);
+		QuantizedPolicy(std::filesystem::path path);
+		RG_NO_COPY(QuantizedPolicy);
+
+		void Save(std::filesystem::path path) const;
+
+		// Same as NativePolicy::Infer()
+		void Infer(const float* obs, int batchSize, int64_t* outActions, float* outLogProbs, bool deterministic, std::mt19937& rng) const;
+
+		// Fraction of observations where we choose the same deterministic action as the full-precision policy
+		float GetActionAgreement(const NativePolicy& policy, const float* obs, int amount) const;
+	};
+}
\ No newline at end of file
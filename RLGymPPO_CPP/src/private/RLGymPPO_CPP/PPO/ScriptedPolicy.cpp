@@ -0,0 +1,135 @@
+#include "ScriptedPolicy.h"
+
+#include "../FrameworkTorch.h"
+#include <torch/nn/modules/linear.h>
+#include <torch/script.h>
+
+using namespace RLGPC;
+
+struct RLGPC::ScriptedPolicy::Script {
+	torch::jit::Module module;
+	int layerAmount;
+
+	// Names of the attributes Load() copies into, in the order of the policy's tensors
+	std::vector<std::string> weightNames, biasNames;
+};
+
+std::vector<torch::nn::Linear> _GetLinearLayers(DiscretePolicy* policy) {
+	std::vector<torch::nn::Linear> result = {};
+	for (auto& child : policy->seq->children()) {
+		auto linear = std::dynamic_pointer_cast<torch::nn::LinearImpl>(child);
+		if (linear)
+			result.push_back(torch::nn::Linear(linear));
+	}
+	return result;
+}
+
+// Same as DiscretePolicy::GetActionDevice(), as TorchScript
+std::string _MakeScriptSource(int layerAmount) {
+	std::stringstream src;
+	src << "def forward(self, obs: Tensor, deterministic: bool) -> Tuple[Tensor, Tensor]:\n";
+	src << "    x = torch.addcmul(self.obs_shift, obs.to(self.obs_shift.dtype), self.obs_scale)\n";
+	for (int i = 0; i < layerAmount - 1; i++)
+		src << "    x = torch.relu(torch.linear(x, self.weight_" << i << ", self.bias_" << i << "))\n";
+	src << "    x = torch.linear(x, self.weight_" << (layerAmount - 1) << ", self.bias_" << (layerAmount - 1) << ")\n";
+
+	// Log probs are always computed in full precision
+	src << "    log_probs = torch.log_softmax(x.float(), -1)\n";
+	src << "    if deterministic:\n";
+	src << "        action = log_probs.argmax(1)\n";
+	src << "        return action.flatten(), torch.zeros_like(log_probs[:, 0])\n";
+
+	// Gumbel-max sampling, see DiscretePolicy::GetActionDevice()
+	src << "    noise = torch.empty_like(log_probs).exponential_().log()\n";
+	src << "    action = (log_probs - noise).argmax(-1, True)\n";
+	src << "    log_prob = log_probs.gather(-1, action)\n";
+	src << "    return action.flatten(), log_prob.flatten()\n";
+	return src.str();
+}
+
+RLGPC::ScriptedPolicy::ScriptedPolicy(DiscretePolicy* policy) : device(policy->device) {
+	RG_NOGRAD;
+
+	inputAmount = policy->inputAmount;
+	actionAmount = policy->actionAmount;
+
+	auto layers = _GetLinearLayers(policy);
+	if (layers.empty())
+		RG_ERR_CLOSE("ScriptedPolicy: Policy has an unsupported architecture");
+
+	auto options = policy->parameters()[0].options();
+
+	torch::jit::Module module = torch::jit::Module("ScriptedPolicy");
+	std::vector<std::string> preservedAttrs = {};
+
+	_script = new Script();
+	_script->layerAmount = layers.size();
+	for (int i = 0; i < layers.size(); i++) {
+		std::string weightName = "weight_" + std::to_string(i), biasName = "bias_" + std::to_string(i);
+		module.register_buffer(weightName, layers[i]->weight.detach().clone());
+		module.register_buffer(biasName, layers[i]->bias.detach().clone());
+		_script->weightNames.push_back(weightName);
+		_script->biasNames.push_back(biasName);
+		preservedAttrs.push_back(weightName);
+		preservedAttrs.push_back(biasName);
+	}
+
+	// Standardization is always in the graph, so it doesn't change if standardization is set later
+	// When it isn't set, it does nothing (obs * 1 + 0)
+	module.register_buffer("obs_scale", torch::ones({ inputAmount }, options));
+	module.register_buffer("obs_shift", torch::zeros({ inputAmount }, options));
+	preservedAttrs.push_back("obs_scale");
+	preservedAttrs.push_back("obs_shift");
+
+	module.define(_MakeScriptSource(_script->layerAmount));
+	module.eval();
+
+	// Freezing inlines everything into one graph, preserved attributes stay as attributes so Load() can copy into them
+	_script->module = torch::jit::freeze(module, preservedAttrs);
+	torch::jit::optimize_for_inference(_script->module);
+
+	Load(policy);
+}
+
+void RLGPC::ScriptedPolicy::Load(DiscretePolicy* policy) {
+	RG_NOGRAD;
+
+	auto layers = _GetLinearLayers(policy);
+	if (layers.size() != _script->layerAmount || policy->inputAmount != inputAmount || policy->actionAmount != actionAmount)
+		RG_ERR_CLOSE("ScriptedPolicy::Load(): Policy has a different architecture");
+
+	auto& module = _script->module;
+	for (int i = 0; i < layers.size(); i++) {
+		auto weight = module.attr(_script->weightNames[i]).toTensor();
+		auto bias = module.attr(_script->biasNames[i]).toTensor();
+		if (weight.sizes() != layers[i]->weight.sizes() || bias.sizes() != layers[i]->bias.sizes())
+			RG_ERR_CLOSE("ScriptedPolicy::Load(): Policy has a different architecture");
+
+		weight.copy_(layers[i]->weight);
+		bias.copy_(layers[i]->bias);
+	}
+
+	auto scale = module.attr("obs_scale").toTensor(), shift = module.attr("obs_shift").toTensor();
+	if (policy->obsStandardization.IsSet()) {
+		scale.copy_(policy->obsStandardization.scale);
+		shift.copy_(policy->obsStandardization.shift);
+	} else {
+		scale.fill_(1);
+		shift.fill_(0);
+	}
+}
+
+RLGPC::DiscretePolicy::ActionResult RLGPC::ScriptedPolicy::GetAction(torch::Tensor obs, bool deterministic, torch::Tensor readback) {
+	RG_NOGRAD;
+
+	auto output = _script->module.forward({ obs.to(device, true), deterministic }).toTuple();
+	auto result = DiscretePolicy::ActionResult{ output->elements()[0].toTensor(), output->elements()[1].toTensor() };
+	if (device.is_cpu())
+		return result;
+
+	return DiscretePolicy::ReadBackResult(DiscretePolicy::PackResult(result), readback);
+}
+
+RLGPC::ScriptedPolicy::~ScriptedPolicy() {
+	delete _script;
+}
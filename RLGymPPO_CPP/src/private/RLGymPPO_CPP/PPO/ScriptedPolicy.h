@@ -0,0 +1,31 @@
+#pragma once
+#include "DiscretePolicy.h"
+
+namespace RLGPC {
+	// Inference-only TorchScript copy of a DiscretePolicy
+	// All of GetAction() (standardization, layers, log softmax, sampling and gathering) is one scripted graph,
+	//	which is frozen and optimized for inference, so it runs without going through the eager module and per-op dispatch of GetAction()
+	// The graph is scripted once, its weights are graph attributes that Load() copies the policy's weights into
+	// NOTE: Like the half-precision policy, weights are copied in-place, so inferences running during Load() can see a mix of old and new weights
+	class ScriptedPolicy {
+	public:
+		int inputAmount, actionAmount;
+		torch::Device device;
+
+		ScriptedPolicy(DiscretePolicy* policy);
+		RG_NO_COPY(ScriptedPolicy);
+
+		// Copies the weights and standardization of the policy into our graph
+		// The policy must have the same architecture, device and precision as the one we were created from
+		void Load(DiscretePolicy* policy);
+
+		// Same as DiscretePolicy::GetAction()
+		DiscretePolicy::ActionResult GetAction(torch::Tensor obs, bool deterministic, torch::Tensor readback = {});
+
+		~ScriptedPolicy();
+
+	private:
+		struct Script;
+		Script* _script;
+	};
+}
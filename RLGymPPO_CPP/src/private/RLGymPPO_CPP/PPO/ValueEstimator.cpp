@@ -4,23 +4,27 @@
 #include <torch/nn/modules/activation.h>
 
 RLGPC::ValueEstimator::ValueEstimator(int inputAmount, const IList& layerSizes, torch::Device device) : device(device) {
+	_BuildSeq(inputAmount, layerSizes);
+}
+
+RLGPC::ValueEstimator::ValueEstimator(DiscretePolicy* trunk, const IList& headLayerSizes, torch::Device device) : device(device), trunk(trunk) {
+	_BuildSeq(trunk->featureAmount, headLayerSizes);
+}
+
+void RLGPC::ValueEstimator::_BuildSeq(int inputAmount, const IList& layerSizes) {
 	using namespace torch;
 
 	seq = {};
 
-	seq->push_back(nn::Linear(inputAmount, layerSizes[0]));
-	seq->push_back(nn::ReLU());
-
-	int prevLayerSize = layerSizes[0];
-	for (int i = 1; i < layerSizes.size(); i++) {
-		int layerSize = layerSizes[i];
+	int prevLayerSize = inputAmount;
+	for (int layerSize : layerSizes) {
 		seq->push_back(nn::Linear(prevLayerSize, layerSize));
 		seq->push_back(nn::ReLU());
 		prevLayerSize = layerSize;
 	}
 
 	// Output layer, just gives 1 output for value estimate
-	seq->push_back(nn::Linear(layerSizes.back(), 1));
+	seq->push_back(nn::Linear(prevLayerSize, 1));
 
 	register_module("seq", seq);
 
@@ -1,5 +1,7 @@
 #pragma once
 #include <RLGymPPO_CPP/Lists.h>
+#include "OBSStandardization.h"
+#include "DiscretePolicy.h"
 
 #include <torch/nn/modules/container/sequential.h>
 
@@ -10,10 +12,47 @@ namespace RLGPC {
 		torch::Device device;
 		torch::nn::Sequential seq;
 
+		// Applied to inputs before the first layer, only if set
+		OBSStandardization obsStandardization = {};
+
+		// If set, we are only a head on top of this policy's features (see PPOLearnerConfig::sharedTrunk)
+		// Its layers are not our parameters, so they are only stepped by the policy's optimizer
+		DiscretePolicy* trunk = NULL;
+
+		// If true, each Linear and ReLU of seq is run as one fused GEMM (see FusedLinear)
+		bool fusedLayers = false;
+
+		// If set, activations inside blocks of this many layers are recomputed during backward instead of stored (see ActivationCheckpoint)
+		int checkpointLayers = 0;
+
 		ValueEstimator(int inputAmount, const IList& layerSizes, torch::Device device);
 
+		// Head on top of the features of trunk, headLayerSizes can be empty to only have the output layer
+		ValueEstimator(DiscretePolicy* trunk, const IList& headLayerSizes, torch::Device device);
+
+		void _BuildSeq(int inputAmount, const IList& layerSizes);
+
+		// Copies the standardization to our device and precision
+		void SetOBSStandardization(const OBSStandardization& standardization) {
+			obsStandardization.CopyFrom(standardization, parameters()[0].options());
+		}
+
 		torch::Tensor Forward(torch::Tensor input) {
-			return seq->forward(input).to(device, true);
+			if (trunk)
+				return ForwardFeatures(trunk->GetFeatures(input));
+
+			return ForwardFeatures(obsStandardization.Apply(input));
+		}
+
+		// Gets the values from the input of seq, which is the features of the trunk if we have one
+		torch::Tensor ForwardFeatures(torch::Tensor features) {
+			torch::Tensor output;
+			if (checkpointLayers > 0) {
+				output = ActivationCheckpoint::ForwardSeq(seq, features, checkpointLayers, fusedLayers);
+			} else {
+				output = fusedLayers ? FusedLinear::ForwardSeq(seq, features) : seq->forward(features);
+			}
+			return output.to(device, true);
 		}
 	};
 }
\ No newline at end of file
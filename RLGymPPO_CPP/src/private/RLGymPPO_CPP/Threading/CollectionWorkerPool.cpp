@@ -0,0 +1,116 @@
+#include "CollectionWorkerPool.h"
+
+#include "ThreadAgentManager.h"
+#include <RLGymPPO_CPP/Util/Timer.h>
+#include <RLGymPPO_CPP/Util/TraceRecorder.h>
+#include <RLGymPPO_CPP/Util/SamplingProfiler.h>
+
+RLGPC::CollectionWorkerPool::CollectionWorkerPool(ThreadAgentManager* mgr, int numWorkers) : mgr(mgr) {
+	times.resize(numWorkers);
+	for (int i = 0; i < numWorkers; i++)
+		threads.push_back(std::thread(&CollectionWorkerPool::_Run, this, i));
+}
+
+RLGPC::CollectionWorkerPool::~CollectionWorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(mgr->collectMutex);
+		shouldRun = false;
+	}
+	mgr->collectCV.notify_all();
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+void RLGPC::CollectionWorkerPool::Add(ThreadAgent* agent) {
+	{
+		std::lock_guard<std::mutex> lock(mgr->collectMutex);
+		ready.push_back(agent);
+	}
+	mgr->collectCV.notify_all();
+}
+
+void RLGPC::CollectionWorkerPool::_Run(int index) {
+	RG_NOGRAD;
+	torch::set_num_threads(1); // Threads don't inherit the learner's count (see LearnerConfig::learnThreads)
+	TraceRecorder::SetThreadName("Collection Worker " + std::to_string(index));
+	SamplingProfiler::SetThreadRole("Agent");
+
+	WorkerTimes& workerTimes = times[index];
+
+	while (true) {
+		ThreadAgent* agent = NULL;
+		{
+			std::unique_lock<std::mutex> lock(mgr->collectMutex);
+
+			// Takes the first agent that can collect, or that was stopped and needs to be taken out
+			// Parked agents are skipped, and stay in the queue until they are unparked
+			auto fnTakeAgent = [&] {
+				if (!shouldRun)
+					return true;
+
+				bool canCollect = mgr->_CanCollect();
+				for (auto itr = ready.begin(); itr != ready.end(); itr++) {
+					ThreadAgent* readyAgent = *itr;
+					if (!readyAgent->shouldRun || (canCollect && !readyAgent->parked)) {
+						agent = readyAgent;
+						ready.erase(itr);
+						return true;
+					}
+				}
+				return false;
+			};
+
+			if (!fnTakeAgent()) {
+				RG_TRACE_SCOPE("Wait To Collect");
+				Timer waitTimer = {};
+				mgr->collectCV.wait(lock, fnTakeAgent);
+				workerTimes.waitTime += waitTimer.Elapsed();
+			}
+
+			if (!shouldRun) {
+				// Taken agents are put back, in case they are started again by a new pool
+				if (agent)
+					ready.push_front(agent);
+				break;
+			}
+		}
+
+		if (!agent->shouldRun) {
+			agent->isRunning = false;
+			agent->isRunning.notify_all();
+			continue;
+		}
+
+		Timer stepTimer = {};
+		agent->_WorkerStep();
+		workerTimes.stepTime += stepTimer.Elapsed();
+		workerTimes.agentSteps++;
+
+		{
+			std::lock_guard<std::mutex> lock(mgr->collectMutex);
+			ready.push_back(agent);
+		}
+		mgr->collectCV.notify_one();
+	}
+}
+
+void RLGPC::CollectionWorkerPool::GetMetrics(Report& report) {
+	WorkerTimes avgTimes = {};
+	for (auto& workerTimes : times) {
+		avgTimes.waitTime += workerTimes.waitTime;
+		avgTimes.stepTime += workerTimes.stepTime;
+		avgTimes.agentSteps += workerTimes.agentSteps;
+	}
+
+	int numWorkers = RS_MAX(GetNumWorkers(), 1);
+	report["Collection Workers"] = GetNumWorkers();
+	report["Collection Worker Wait Time"] = avgTimes.waitTime / numWorkers;
+	report["Collection Worker Step Time"] = avgTimes.stepTime / numWorkers;
+	report["Collection Worker Agent Steps"] = (double)avgTimes.agentSteps / numWorkers;
+}
+
+void RLGPC::CollectionWorkerPool::ResetMetrics() {
+	for (auto& workerTimes : times)
+		workerTimes = {};
+}
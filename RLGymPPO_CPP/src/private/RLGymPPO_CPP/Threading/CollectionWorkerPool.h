@@ -0,0 +1,48 @@
+#pragma once
+#include "ThreadAgent.h"
+#include <RLGymPPO_CPP/Util/Report.h>
+#include <deque>
+
+namespace RLGPC {
+	// Worker threads that collect the steps of agents, instead of each agent running on its own thread (see LearnerConfig::collectionWorkers)
+	// Agents that are ready to step wait in a shared queue, each worker takes the next one, collects one step of all of its games, and puts it back at the end
+	// An agent whose games are slow (resets, demos, cars on walls) then only holds up the worker stepping it, while the other workers keep taking the rest
+	class CollectionWorkerPool {
+	public:
+		class ThreadAgentManager* mgr;
+
+		// Agents waiting for a worker, guarded by the manager's collectMutex
+		// Workers wait on the manager's collectCV, so anything that lets agents collect again also wakes them up
+		std::deque<ThreadAgent*> ready = {};
+
+		std::vector<std::thread> threads = {};
+		bool shouldRun = true;
+
+		// Each on its own cache line, as only its worker writes it
+		struct alignas(64) WorkerTimes {
+			double
+				waitTime = 0, // Time spent waiting for an agent that could collect
+				stepTime = 0; // Time spent collecting steps of agents
+			uint64_t agentSteps = 0; // Steps collected, of any agent
+		};
+		std::vector<WorkerTimes> times = {};
+
+		CollectionWorkerPool(class ThreadAgentManager* mgr, int numWorkers);
+		RG_NO_COPY(CollectionWorkerPool);
+
+		// Stops and joins our workers, agents they were stepping finish their step first
+		~CollectionWorkerPool();
+
+		int GetNumWorkers() const {
+			return threads.size();
+		}
+
+		// Queues a started agent, it is taken out once it is stopped (see ThreadAgent::Stop())
+		void Add(ThreadAgent* agent);
+
+		void GetMetrics(Report& report);
+		void ResetMetrics();
+
+		void _Run(int index);
+	};
+}
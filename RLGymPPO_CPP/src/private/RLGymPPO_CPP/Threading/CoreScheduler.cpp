@@ -0,0 +1,67 @@
+#include "CoreScheduler.h"
+#include <RLGymPPO_CPP/Util/CPUAffinity.h>
+
+int RLGPC::CoreScheduler::BeginLearn() {
+	if (inLearnPhase)
+		RG_ERR_CLOSE("CoreScheduler::BeginLearn(): Already in the learn phase");
+	inLearnPhase = true;
+
+	int numAgents = agentMgr->agents.size();
+	int numCores = CPUAffinity::GetNumCores();
+
+	// At least one agent keeps collecting, so collection during learning never stops entirely
+	parkedAgents = RS_CLAMP((int)roundf(numAgents * learnFraction), 0, numAgents - 1);
+	agentMgr->SetParkedAgents(parkedAgents);
+
+	// Cores that only parked agents are pinned to
+	// Agents pinned to whole NUMA nodes share their cores with collecting agents, so those aren't pinned to
+	std::set<int> freeCores = {}, usedCores = {};
+	bool allPinned = numAgents > 0;
+	for (int i = 0; i < numAgents; i++) {
+		ThreadAgent* agent = agentMgr->agents[i];
+		if (!agent->pinned) {
+			allPinned = false;
+			break;
+		}
+		bool isParked = i >= numAgents - parkedAgents;
+		(isParked ? freeCores : usedCores).insert(agent->cores.begin(), agent->cores.end());
+	}
+
+	learnCores.clear();
+	if (allPinned) {
+		for (int core : freeCores)
+			if (!usedCores.count(core))
+				learnCores.push_back(core);
+	}
+
+	if (!learnCores.empty() && CPUAffinity::PinCurrentThread(learnCores)) {
+		// NOTE: OpenMP creates its workers from this thread, so they are only pinned here if they didn't already exist
+		learnThreads = learnCores.size();
+	} else {
+		// Without pinning, we match the share of the machine the parked agents were using
+		learnCores.clear();
+		learnThreads = RS_MAX(numAgents > 0 ? (numCores * parkedAgents / numAgents) : numCores, 1);
+	}
+
+	return learnThreads;
+}
+
+void RLGPC::CoreScheduler::EndLearn() {
+	if (!inLearnPhase)
+		RG_ERR_CLOSE("CoreScheduler::EndLearn(): Not in the learn phase");
+	inLearnPhase = false;
+
+	agentMgr->SetParkedAgents(0);
+
+	if (!learnCores.empty()) {
+		IList allCores = {};
+		for (int i = 0; i < CPUAffinity::GetNumCores(); i++)
+			allCores.push_back(i);
+		CPUAffinity::PinCurrentThread(allCores);
+	}
+}
+
+void RLGPC::CoreScheduler::GetMetrics(Report& report) {
+	report["Learn Threads"] = learnThreads;
+	report["Parked Agents"] = parkedAgents;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "ThreadAgentManager.h"
+
+namespace RLGPC {
+	// Hands CPU cores between agents and the learner as the learner changes phase (see LearnerConfig::coreScheduling)
+	// During collection, every agent collects and the learner uses one thread
+	// During learning, some agents are parked (they finish their current step, then wait), and the learner uses their cores instead
+	class CoreScheduler {
+	public:
+		ThreadAgentManager* agentMgr;
+
+		// Fraction of agents parked during learning
+		float learnFraction;
+
+		// Of the current (or last) learn phase
+		int parkedAgents = 0, learnThreads = 1;
+		// Cores the learner is pinned to during the current learn phase, empty if not pinned
+		IList learnCores = {};
+
+		bool inLearnPhase = false;
+
+		CoreScheduler(ThreadAgentManager* agentMgr, float learnFraction) : agentMgr(agentMgr), learnFraction(learnFraction) {}
+
+		RG_NO_COPY(CoreScheduler);
+
+		// Parks agents and gives their cores to the calling (learner) thread
+		// Returns how many threads to learn with
+		int BeginLearn();
+
+		// Unparks all agents, and unpins the calling thread
+		void EndLearn();
+
+		void GetMetrics(Report& report);
+	};
+}
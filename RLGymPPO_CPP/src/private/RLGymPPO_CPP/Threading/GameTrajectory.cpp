@@ -17,78 +17,83 @@ namespace RLGPC {
 			*itr1 = TorchFuncs::ConcatSafe(ourT, otherT);
 		}
 
+		truncNextStates = TorchFuncs::ConcatSafe(truncNextStates, other.truncNextStates);
+
 		size = oldSize + other.size;
 		capacity = oldSize + other.capacity;
 
 		assert(data.begin()->size(0) == capacity);
 	}
 
-	void GameTrajectory::MultiAppend(const std::vector<GameTrajectory>& others) {
+	void GameTrajectory::MultiAppend(const std::vector<GameTrajectory>& others, JobSystem* jobs) {
 
 		bool alreadyHaveData = size != 0;
 
-		for (int i = 0; i < TrajectoryTensors::TENSOR_AMOUNT; i++) {
-			std::vector<torch::Tensor> catList;
-			catList.reserve(others.size());
-
-			if (alreadyHaveData)
-				catList.push_back(this->data[i]); // We need to start with our own data
-
-			for (auto& otherTraj : others) {
-				// Remove capacity
-				torch::Tensor slicedData = otherTraj.data[i].slice(0, 0, otherTraj.size); 
-				catList.push_back(slicedData);
+		// Every tensor of our data, then truncNextStates
+		JobSystem::ParallelFor(jobs, 0, TrajectoryTensors::TENSOR_AMOUNT + 1, 1,
+			[&](int64_t start, int64_t end) {
+				for (int64_t i = start; i < end; i++) {
+					if (i == TrajectoryTensors::TENSOR_AMOUNT) {
+						std::vector<torch::Tensor> truncCatList;
+						if (alreadyHaveData)
+							truncCatList.push_back(truncNextStates);
+						for (auto& otherTraj : others)
+							truncCatList.push_back(otherTraj.truncNextStates);
+						truncNextStates = torch::cat(truncCatList);
+						continue;
+					}
+
+					std::vector<torch::Tensor> catList;
+					catList.reserve(others.size() + 1);
+
+					if (alreadyHaveData)
+						catList.push_back(this->data[i]); // We need to start with our own data
+
+					for (auto& otherTraj : others) {
+						// Remove capacity
+						torch::Tensor slicedData = otherTraj.data[i].slice(0, 0, otherTraj.size); 
+						catList.push_back(slicedData);
+					}
+					data[i] = torch::cat(catList);
+				}
 			}
-			data[i] = torch::cat(catList);
-		}
+		);
 		
 		size = capacity = data[0].size(0);
 	}
 
-	void GameTrajectory::RemoveCapacity() {
-		if (capacity > size)
-			for (torch::Tensor& t : data)
-				t = t.slice(0, 0, size);
-	}
+	void GameTrajectory::Reserve(size_t newCapacity, const GameTrajectory& like) {
+		if (newCapacity <= capacity)
+			return;
 
-	void GameTrajectory::AppendSingleStep(TrajectoryTensors step) {
+		for (int i = 0; i < TrajectoryTensors::TENSOR_AMOUNT; i++) {
+			auto sizes = like.data[i].sizes().vec();
+			sizes[0] = newCapacity;
+			torch::Tensor newTensor = torch::empty(sizes, like.data[i].options());
+			if (size > 0)
+				newTensor.slice(0, 0, size).copy_(data[i].slice(0, 0, size));
+			data[i] = newTensor;
+		}
 
-#ifdef RG_PARANOID_MODE
-		step.debugCounters = torch::tensor(debugCounter);
-		debugCounter++;
-#endif
+		capacity = newCapacity;
+	}
 
-		if (size > 0) {
-			if (size == capacity)
-				DoubleReserve();
+	void GameTrajectory::AppendInPlace(const GameTrajectory& other) {
+		if (other.size == 0)
+			return;
 
-			torch::Tensor indexTensor = torch::tensor((int64_t)size);
-			for (auto itr1 = data.begin(), itr2 = step.begin(); itr1 != data.end(); itr1++, itr2++) {
-				torch::Tensor& t = *itr1;
-				t.index_copy_(0, indexTensor, itr2->unsqueeze(0));
-			}
+		if (size + other.size > capacity)
+			Reserve(RS_MAX(capacity * 2, size + other.size), other);
 
-			size++;
-		} else {
-			for (auto itr1 = data.begin(), itr2 = step.begin(); itr1 != data.end(); itr1++, itr2++) {
-				*itr1 = itr2->unsqueeze(0);
-			}
+		for (int i = 0; i < TrajectoryTensors::TENSOR_AMOUNT; i++)
+			data[i].slice(0, size, size + other.size).copy_(other.data[i].slice(0, 0, other.size));
 
-			size = capacity = 1;
-		}
+		size += other.size;
 	}
 
-	void GameTrajectory::DoubleReserve() {
-		if (capacity > 0) {
-			for (torch::Tensor& t : data) {
-				// TODO: This is annoying, is there a better way to do this?
-				//	t.repeat() requires you specify the amount for all dimensions
-				auto repeatSize = std::vector<int64_t>(t.dim(), 1);
-				repeatSize[0] = 2;
-				t = t.repeat(repeatSize);
-			}
-
-			capacity *= 2;
-		}
+	void GameTrajectory::RemoveCapacity() {
+		if (capacity > size)
+			for (torch::Tensor& t : data)
+				t = t.slice(0, 0, size);
 	}
 }
\ No newline at end of file
@@ -12,17 +12,22 @@ namespace RLGPC {
 #ifdef RG_PARANOID_MODE
 			debugCounters,
 #endif
-			nextStates,
 			dones,
-			truncateds;
+			truncateds,
+			values, // Critic values from collection, zero if they were not inferred during collection
+			policyVersions, // Version of the policy that chose each action (see ThreadAgentManager::policyVersion)
+			policyIDs; // ID of the policy that chose each action (see LearnerConfig::playerPolicyIDs)
 
 		constexpr static size_t TENSOR_AMOUNT =
 #ifdef RG_PARANOID_MODE
-			8;
+			10;
 #else
-			7;
+			9;
 #endif
 
+		// Remote workers only play the main policy, so policyIDs (the last tensor) isn't sent to or from them
+		constexpr static size_t REMOTE_TENSOR_AMOUNT = TENSOR_AMOUNT - 1;
+
 		torch::Tensor* begin() { return &states; }
 		const torch::Tensor* begin() const { return &states; }
 		torch::Tensor* end() { return &states + TENSOR_AMOUNT; }
@@ -35,37 +40,31 @@ namespace RLGPC {
 	// A container for the timestep data of a specific agent
 	// https://github.com/AechPro/rlgym-ppo/blob/main/rlgym_ppo/batched_agents/batched_trajectory.py
 	// Unlike rlgym-ppo, this has a capacity allocation system like std::vector
-	// This class is designed to append single steps or merge multiple trajectories as fast as possible
+	// This class is designed to merge multiple trajectories as fast as possible
+	// NOTE: Timesteps are collected by RolloutStorage, this just holds the collected result
 	struct GameTrajectory {
 
 		TrajectoryTensors data;
 		size_t size = 0, capacity = 0;
 
-#ifdef RG_PARANOID_MODE
-		int64_t debugCounter = 0;
-#endif
+		// [numTruncated][obsSize], the next state of each truncated step, in the same order as the steps
+		// Next states of other steps are not stored, they are either the following step's state or unused (done)
+		torch::Tensor truncNextStates;
 
 		void Append(GameTrajectory& other);
-		void MultiAppend(const std::vector<GameTrajectory>& others); // Much faster than spamming Append()
+		void MultiAppend(const std::vector<GameTrajectory>& others, JobSystem* jobs = NULL); // Much faster than spamming Append(), each tensor is concatenated as its own job
 
-		void RemoveCapacity();
+		// Grows our capacity to at least newCapacity, with the same tensor shapes and types as like
+		void Reserve(size_t newCapacity, const GameTrajectory& like);
+
+		// Copies the data of other into our capacity, which grows if needed
+		// NOTE: Only copies data, truncNextStates is left for the caller to combine
+		void AppendInPlace(const GameTrajectory& other);
 
-		// NOTE: Assumes the passed in data is a SINGLE TIMESTEP, at a lower dimensionality than multiple timesteps,
-		//	e.g. data.rewards should actually just be a single float tensor
-		void AppendSingleStep(TrajectoryTensors step);
+		void RemoveCapacity();
 
 		void Clear() {
-#ifdef RG_PARANOID_MODE
-			int64_t debugCounterBackup = debugCounter;
-#endif
 			*this = GameTrajectory();
-
-#ifdef RG_PARANOID_MODE
-			debugCounter = debugCounterBackup;
-#endif
 		}
-
-		// Doubles the capacity
-		void DoubleReserve();
 	};
 }
\ No newline at end of file
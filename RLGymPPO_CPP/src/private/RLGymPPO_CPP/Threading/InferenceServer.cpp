@@ -0,0 +1,131 @@
+#include "InferenceServer.h"
+
+#include <RLGymPPO_CPP/FrameworkTorch.h>
+#include <RLGymPPO_CPP/Util/TraceRecorder.h>
+#include <RLGymPPO_CPP/Util/SamplingProfiler.h>
+
+using namespace RLGPC;
+
+void _InferenceServerRunFunc(InferenceServer* server) {
+	RG_NOGRAD;
+	torch::set_num_threads(1); // Threads don't inherit the learner's count (see LearnerConfig::learnThreads)
+	TraceRecorder::SetThreadName("Inference Server");
+	SamplingProfiler::SetThreadRole("Inference Server");
+
+	namespace chr = std::chrono;
+	auto maxWaitDuration = chr::duration_cast<chr::steady_clock::duration>(chr::duration<double>(server->maxWaitTime));
+
+	std::vector<InferenceServer::Request*> batch = {};
+	std::vector<torch::Tensor> batchObs = {};
+
+	while (true) {
+		{ // Wait for a batch worth of requests
+			std::unique_lock<std::mutex> lock(server->mutex);
+			server->requestCV.wait(lock, [&] { return !server->shouldRun || !server->pendingRequests.empty(); });
+			if (!server->shouldRun)
+				break;
+
+			auto deadline = chr::steady_clock::now() + maxWaitDuration;
+			server->requestCV.wait_until(lock, deadline, [&] {
+				return
+					!server->shouldRun ||
+					server->pendingRows >= server->minInferenceSize ||
+					server->pendingRequests.size() >= (size_t)server->numClients;
+			});
+			if (!server->shouldRun)
+				break;
+
+			batch.swap(server->pendingRequests);
+			server->pendingRows = 0;
+		}
+
+		batchObs.clear();
+		for (auto request : batch)
+			batchObs.push_back(request->obs);
+
+		DiscretePolicy::ActionResult batchResult;
+		try {
+			RG_TRACE_SCOPE("Batch Infer", server->device);
+			torch::Tensor input;
+			if (batchObs.size() == 1) {
+				input = batchObs[0];
+			} else if (server->device.is_cuda()) {
+				// Combine into pinned memory, so that the copy to the GPU is actually non-blocking
+				int64_t numRows = 0;
+				for (auto& obs : batchObs)
+					numRows += obs.size(0);
+
+				input = torch::empty({ numRows, batchObs[0].size(1) }, torch::TensorOptions().dtype(torch::kFloat).pinned_memory(true));
+				torch::cat_out(input, batchObs);
+			} else {
+				input = torch::cat(batchObs);
+			}
+
+			input = input.to(server->device, true);
+			batchResult = server->policy->GetAction(input, server->deterministic);
+			if (server->valueNet)
+				batchResult.value = server->valueNet->Forward(input).cpu().flatten();
+		} catch (std::exception& e) {
+			RG_ERR_CLOSE("InferenceServer: Exception during policy inference: " << e.what());
+		}
+
+		{ // Scatter results back to the requests
+			std::lock_guard<std::mutex> lock(server->mutex);
+			int64_t offset = 0;
+			for (auto request : batch) {
+				int64_t numRows = request->obs.size(0);
+				request->result.action = batchResult.action.slice(0, offset, offset + numRows);
+				request->result.logProb = batchResult.logProb.slice(0, offset, offset + numRows);
+				if (batchResult.value.defined())
+					request->result.value = batchResult.value.slice(0, offset, offset + numRows);
+				request->finished = true;
+				offset += numRows;
+			}
+
+			server->numBatches++;
+			server->numBatchedRows += offset;
+		}
+		server->resultCV.notify_all();
+		batch.clear();
+	}
+}
+
+DiscretePolicy::ActionResult RLGPC::InferenceServer::Infer(torch::Tensor obs) {
+	Request request = {};
+	request.obs = obs;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (!shouldRun)
+		RG_ERR_CLOSE("InferenceServer::Infer(): Server is not running");
+
+	pendingRequests.push_back(&request);
+	pendingRows += obs.size(0);
+	requestCV.notify_one();
+
+	resultCV.wait(lock, [&] { return request.finished; });
+	return request.result;
+}
+
+void RLGPC::InferenceServer::Start() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (shouldRun)
+			return;
+		shouldRun = true;
+	}
+
+	thread = std::thread(_InferenceServerRunFunc, this);
+}
+
+void RLGPC::InferenceServer::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!shouldRun)
+			return;
+		shouldRun = false;
+	}
+
+	requestCV.notify_all();
+	if (thread.joinable())
+		thread.join();
+}
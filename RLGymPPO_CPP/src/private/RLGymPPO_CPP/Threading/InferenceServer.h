@@ -0,0 +1,72 @@
+#pragma once
+#include "../PPO/DiscretePolicy.h"
+#include "../PPO/ValueEstimator.h"
+#include <condition_variable>
+
+namespace RLGPC {
+	// Runs policy inference for all ThreadAgents on a single thread
+	// Agents submit their observations, which are combined into one batch so the device runs one big forward pass instead of many small ones
+	class InferenceServer {
+	public:
+		DiscretePolicy* policy;
+		torch::Device device;
+		bool deterministic;
+
+		// If set, critic values are inferred in the same batch as the policy
+		ValueEstimator* valueNet = NULL;
+
+		// Minimum amount of observation rows to wait for before inferring
+		int minInferenceSize;
+
+		// Maximum time to wait for minInferenceSize rows, after the first request of a batch arrived
+		double maxWaitTime;
+
+		// Amount of agents using this server
+		// Once all of them are waiting, we infer immediately
+		int numClients = 0;
+
+		struct Request {
+			torch::Tensor obs;
+			DiscretePolicy::ActionResult result;
+			bool finished = false;
+		};
+
+		std::mutex mutex = {};
+		std::condition_variable requestCV = {}, resultCV = {};
+		std::vector<Request*> pendingRequests = {};
+		int64_t pendingRows = 0;
+
+		std::thread thread;
+		bool shouldRun = false;
+
+		// Stats, reset by ResetStats()
+		uint64_t numBatches = 0, numBatchedRows = 0;
+
+		InferenceServer(DiscretePolicy* policy, torch::Device device, bool deterministic, int minInferenceSize, double maxWaitTime) :
+			policy(policy), device(device), deterministic(deterministic), minInferenceSize(minInferenceSize), maxWaitTime(maxWaitTime) {}
+
+		RG_NO_COPY(InferenceServer);
+
+		// Blocks until the policy has inferred the observations
+		// Obs should be a CPU tensor of [numRows][obsSize]
+		DiscretePolicy::ActionResult Infer(torch::Tensor obs);
+
+		void Start();
+		void Stop();
+
+		// Average amount of rows inferred per forward pass
+		double GetAvgBatchSize() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return numBatches ? (double)numBatchedRows / numBatches : 0;
+		}
+
+		void ResetStats() {
+			std::lock_guard<std::mutex> lock(mutex);
+			numBatches = numBatchedRows = 0;
+		}
+
+		~InferenceServer() {
+			Stop();
+		}
+	};
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "GameTrajectory.h"
+
+namespace RLGPC {
+	// Layout of the shared memory between the learner and each of its process workers (see LearnerConfig::numProcessWorkers)
+	// The region is a header, the policy, then a ring of segments that only the worker writes and only the learner reads
+	namespace ProcessShared {
+		constexpr uint32_t MAGIC = 0x50574752; // "RGWP"
+		constexpr uint32_t VERSION = 1;
+
+		// Workers are started with the name of their shared memory in this environment variable
+		constexpr const char* SHM_ENV_VAR = "RLGPC_PROCESS_WORKER_SHM";
+
+		// Everything in the region starts on a cache line, so the sides don't share lines they write
+		constexpr uint64_t ALIGNMENT = 64;
+		constexpr uint64_t Align(uint64_t offset) {
+			return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		}
+
+		struct Header {
+			// Written by the learner before starting the worker
+			uint32_t magic, version;
+			int32_t workerIndex;
+			int32_t obsSize, actionAmount;
+			uint64_t policyOffset, policyCapacity;
+			uint64_t ringOffset, ringCapacity;
+
+			// Set by the learner to make the worker exit
+			alignas(ALIGNMENT) std::atomic<uint32_t> shouldStop;
+			// Set by the worker once it has opened the region
+			std::atomic<uint32_t> attached;
+
+			// Seqlock of the policy: odd while the learner is writing it, workers re-read if it changed while they read
+			alignas(ALIGNMENT) std::atomic<uint64_t> policySeq;
+			// Version and size of the policy data, in the format of RemoteWorkerServer::policyData
+			std::atomic<uint64_t> policyVersion, policySize;
+
+			// Bytes written to the ring in total, only advanced by the worker once a segment is fully written
+			alignas(ALIGNMENT) std::atomic<uint64_t> ringHead;
+			// Bytes freed from the ring in total, only advanced by the learner once it is done with a segment
+			alignas(ALIGNMENT) std::atomic<uint64_t> ringTail;
+		};
+
+		// Each segment in the ring starts with this, followed by its tensors as aligned raw floats
+		// Segments never wrap around the end of the ring, the space left before the end is skipped with a padding segment instead
+		struct SegmentHeader {
+			uint64_t size; // In bytes, including this header
+			uint64_t policyVersion; // Oldest policy version used to collect it
+			uint64_t numSteps; // 0 for padding
+			uint64_t numTrunc;
+		};
+
+		// Offsets of each tensor of a segment from the start of its header, TENSOR_AMOUNT tensors then truncNextStates
+		struct SegmentLayout {
+			uint64_t offsets[TrajectoryTensors::TENSOR_AMOUNT + 1];
+			uint64_t size;
+
+			SegmentLayout(uint64_t numSteps, uint64_t numTrunc, int obsSize) {
+				uint64_t offset = Align(sizeof(SegmentHeader));
+				for (int i = 0; i < TrajectoryTensors::TENSOR_AMOUNT; i++) {
+					offsets[i] = offset;
+
+					// States are the only tensor with more than one value per step
+					offset = Align(offset + numSteps * (i == 0 ? obsSize : 1) * sizeof(float));
+				}
+
+				offsets[TrajectoryTensors::TENSOR_AMOUNT] = offset;
+				size = Align(offset + numTrunc * obsSize * sizeof(float));
+			}
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "ProcessWorker.h"
+
+#include "ProcessShared.h"
+#include "ThreadAgentManager.h"
+#include "RemoteProtocol.h"
+#include "../Util/SharedMemory.h"
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#include <signal.h>
+#endif
+
+using namespace RLGPC::ProcessShared;
+
+bool RLGPC::ProcessWorker::IsWorkerProcess() {
+	return getenv(SHM_ENV_VAR) != NULL;
+}
+
+// Loads the learner's policy if it has a newer version than ours, returns false if it had none
+bool _UpdatePolicy(RLGPC::SharedMemory& shm, RLGPC::DiscretePolicy* policy, RLGPC::ThreadAgentManager* agentMgr, uint64_t& curVersion) {
+	auto header = (Header*)shm.data;
+
+	std::vector<byte> data = {};
+	uint64_t newVersion;
+	while (true) {
+		uint64_t seq = header->policySeq.load(std::memory_order_acquire);
+		if (seq % 2 == 1) {
+			RG_SLEEP(1); // Learner is writing it
+			continue;
+		}
+
+		newVersion = header->policyVersion.load(std::memory_order_relaxed);
+		if (newVersion == curVersion)
+			return newVersion != 0;
+
+		uint64_t size = RS_MIN(header->policySize.load(std::memory_order_relaxed), header->policyCapacity);
+		data.resize(size);
+		memcpy(data.data(), shm.data + header->policyOffset, size);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (header->policySeq.load(std::memory_order_relaxed) == seq)
+			break;
+	}
+
+	DataStreamIn in = DataStreamIn::FromBuffer(data.data(), data.size());
+	if (!RLGPC::RemoteProtocol::ReadParams(in, policy))
+		RG_ERR_CLOSE("ProcessWorker: Learner's policy is of a different size, its layer sizes must not depend on the process");
+
+	RLGPC::OBSStandardization standardization;
+	if (!RLGPC::RemoteProtocol::ReadOBSStandardization(in, header->obsSize, standardization))
+		RG_ERR_CLOSE("ProcessWorker: Learner's OBS standardization is invalid");
+	policy->SetOBSStandardization(standardization);
+
+	curVersion = newVersion;
+	agentMgr->UpdateNativePolicy();
+	agentMgr->UpdateScriptedPolicy();
+
+	// Our steps are tagged with the learner's version of the policy
+	agentMgr->policyVersion = newVersion;
+	return true;
+}
+
+// Writes the segment into our ring, once the learner has freed enough of it
+// Returns false if the learner stopped us while we were waiting
+bool _WriteSegment(RLGPC::SharedMemory& shm, RLGPC::GameTrajectory& segment) {
+	auto header = (Header*)shm.data;
+	uint8_t* ring = shm.data + header->ringOffset;
+	uint64_t ringCapacity = header->ringCapacity;
+
+	uint64_t numTrunc = segment.truncNextStates.size(0);
+	SegmentLayout layout = SegmentLayout(segment.size, numTrunc, header->obsSize);
+	if (layout.size > ringCapacity)
+		RG_ERR_CLOSE("ProcessWorker: Segment of " << layout.size << " bytes is larger than the ring (" << ringCapacity << " bytes), increase processRingMB");
+
+	// Segments don't wrap around, so skip the rest of the ring if it doesn't fit before the end
+	uint64_t head = header->ringHead.load(std::memory_order_relaxed);
+	uint64_t paddingSize = 0;
+	if ((head % ringCapacity) + layout.size > ringCapacity)
+		paddingSize = ringCapacity - (head % ringCapacity);
+
+	while (head + paddingSize + layout.size - header->ringTail.load(std::memory_order_acquire) > ringCapacity) {
+		if (header->shouldStop)
+			return false;
+		RG_SLEEP(1);
+	}
+
+	if (paddingSize > 0) {
+		auto paddingHeader = (SegmentHeader*)(ring + (head % ringCapacity));
+		*paddingHeader = { paddingSize, 0, 0, 0 };
+	}
+
+	uint8_t* segData = ring + ((head + paddingSize) % ringCapacity);
+	auto fnWriteTensor = [&](int index, const torch::Tensor& t) {
+		torch::Tensor floats = t.to(torch::kCPU, torch::kFloat).contiguous();
+		memcpy(segData + layout.offsets[index], floats.data_ptr<float>(), floats.numel() * sizeof(float));
+	};
+
+	for (int i = 0; i < RLGPC::TrajectoryTensors::TENSOR_AMOUNT; i++)
+		fnWriteTensor(i, segment.data[i]);
+	if (numTrunc > 0)
+		fnWriteTensor(RLGPC::TrajectoryTensors::TENSOR_AMOUNT, segment.truncNextStates);
+
+	uint64_t oldestVersion = (uint64_t)segment.data.policyVersions.min().item<float>();
+	*(SegmentHeader*)segData = { layout.size, oldestVersion, segment.size, numTrunc };
+
+	// The learner can read the segment once it sees the new head
+	header->ringHead.store(head + paddingSize + layout.size, std::memory_order_release);
+	return true;
+}
+
+void RLGPC::ProcessWorker::Run(EnvCreateFn envCreateFn, const LearnerConfig& config) {
+	auto shm = SharedMemory(getenv(SHM_ENV_VAR), 0, false, "ProcessWorker: ");
+	auto header = (Header*)shm.data;
+	if (shm.size < sizeof(Header) || header->magic != MAGIC || header->version != VERSION)
+		RG_ERR_CLOSE("ProcessWorker: Shared memory is invalid or from a different version of RLGymPPO_CPP");
+
+#ifdef __linux__
+	// Don't outlive the learner if it crashes
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+
+	header->attached = true;
+
+	int workerIndex = header->workerIndex;
+	RG_LOG("ProcessWorker " << workerIndex << ":");
+
+	if (RocketSim::GetStage() != RocketSimStage::INITIALIZED) {
+		RG_LOG("\tInitializing RocketSim...");
+		RocketSim::Init("collision_meshes", true, RocketSim::InitModes::Lazy());
+	}
+
+	// Seeded apart from the learner and every other worker
+	int randomSeed = config.randomSeed >= 0 ? (config.randomSeed + 1 + workerIndex) : -1;
+	torch::manual_seed(randomSeed >= 0 ? randomSeed : std::random_device()());
+
+	auto device = torch::Device(torch::kCPU);
+	auto policy = new DiscretePolicy(header->obsSize, header->actionAmount, config.ppo.policyLayerSizes, device);
+
+	auto agentMgr = new ThreadAgentManager(
+		policy, NULL, NULL,
+		false, config.deterministic,
+		(uint64_t)(config.timestepsPerIteration * 1.5f / config.numProcessWorkers),
+		device
+	);
+	agentMgr->pipelinedCollection = config.pipelinedCollection;
+	agentMgr->resetAhead = config.resetAhead;
+	agentMgr->useNativeInference = config.nativeInference;
+	agentMgr->useScriptedInference = config.scriptedInference && !config.nativeInference;
+	agentMgr->ballPredTicks = config.ballPredTicks;
+	agentMgr->shareCollisionPools = config.shareCollisionPools && config.stepHelperThreads <= 0; // See LearnerConfig::stepHelperThreads
+	agentMgr->stepHelperThreads = config.stepHelperThreads;
+	agentMgr->randomSeed = randomSeed;
+	agentMgr->parallelEnvCreation = config.parallelEnvCreation;
+	agentMgr->segmentSteps = config.processSegmentSteps;
+
+	RG_LOG("\tCreating " << config.processWorkerThreads << " agents...");
+	agentMgr->CreateAgents(envCreateFn, config.processWorkerThreads, config.numGamesPerThread);
+
+	// Don't collect until we have a policy
+	uint64_t policyVersion = 0;
+	while (!_UpdatePolicy(shm, policy, agentMgr, policyVersion)) {
+		if (header->shouldStop)
+			break;
+		RG_SLEEP(10);
+	}
+
+	if (!header->shouldStop) {
+		agentMgr->StartAgents();
+		agentMgr->stepsReadyTarget = 0; // Wake us up for every segment
+
+		while (!header->shouldStop) {
+			GameTrajectory segment;
+			if (!agentMgr->segmentQueue.Pop(segment)) {
+				// Also wakes up on its own, so we notice policy updates and being stopped
+				std::unique_lock<std::mutex> lock(agentMgr->collectMutex);
+				agentMgr->stepsReadyCV.wait_for(lock, std::chrono::milliseconds(10), [&] { return !agentMgr->segmentQueue.IsEmpty(); });
+				lock.unlock();
+
+				_UpdatePolicy(shm, policy, agentMgr, policyVersion);
+				continue;
+			}
+
+			if (!_WriteSegment(shm, segment))
+				break;
+
+			agentMgr->totalStepsCollected -= segment.size;
+			agentMgr->NotifyAgents();
+			_UpdatePolicy(shm, policy, agentMgr, policyVersion);
+		}
+
+		agentMgr->StopAgents();
+	}
+
+	delete agentMgr;
+	delete policy;
+	RG_LOG("ProcessWorker " << workerIndex << ": Stopped");
+}
\ No newline at end of file
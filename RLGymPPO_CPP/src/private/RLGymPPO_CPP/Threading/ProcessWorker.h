@@ -0,0 +1,15 @@
+#pragma once
+#include <RLGymPPO_CPP/LearnerConfig.h>
+#include <RLGymPPO_CPP/Threading/GameInst.h>
+
+namespace RLGPC {
+	// The side of a process worker (see LearnerConfig::numProcessWorkers) that runs in the worker process
+	// Workers are copies of the learner's executable, they collect segments with its agents and write them into their shared memory
+	namespace ProcessWorker {
+		// True if we were started by a learner's ProcessWorkerServer
+		bool IsWorkerProcess();
+
+		// Collects for the learner until it stops us, config should be the learner's
+		void Run(EnvCreateFn envCreateFn, const LearnerConfig& config);
+	}
+}
\ No newline at end of file
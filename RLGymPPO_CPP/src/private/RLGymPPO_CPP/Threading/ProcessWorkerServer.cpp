@@ -0,0 +1,217 @@
+#include "ProcessWorkerServer.h"
+
+using namespace RLGPC::ProcessShared;
+
+void RLGPC::ProcessWorkerServer::Worker::ReleaseSegment(uint64_t start, uint64_t end) {
+	std::lock_guard<std::mutex> lock(releaseMutex);
+
+	uint64_t tail = header->ringTail.load(std::memory_order_relaxed);
+	if (start != tail) {
+		// Segments before this one are still in use
+		releasedSegments[start] = end;
+		return;
+	}
+
+	tail = end;
+	for (auto itr = releasedSegments.begin(); itr != releasedSegments.end() && itr->first == tail; itr = releasedSegments.erase(itr))
+		tail = itr->second;
+
+	header->ringTail.store(tail, std::memory_order_release);
+}
+
+RLGPC::ProcessWorkerServer::ProcessWorkerServer(
+	int numWorkers, int obsSize, int actionAmount, int maxPolicyAge, uint64_t policyCapacity, uint64_t ringCapacity) :
+	numWorkers(numWorkers), obsSize(obsSize), actionAmount(actionAmount), ringCapacity(ringCapacity), maxPolicyAge(maxPolicyAge) {
+
+	uint64_t policyOffset = Align(sizeof(Header));
+	uint64_t ringOffset = Align(policyOffset + policyCapacity);
+	uint64_t shmSize = ringOffset + ringCapacity;
+
+	// Names only need to be unique among the learners running on this machine
+	std::string namePrefix = "rlgpc-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-";
+
+	for (int i = 0; i < numWorkers; i++) {
+		auto worker = std::make_shared<Worker>(i, namePrefix + std::to_string(i), shmSize);
+
+		auto header = worker->header;
+		header->magic = MAGIC;
+		header->version = VERSION;
+		header->workerIndex = i;
+		header->obsSize = obsSize;
+		header->actionAmount = actionAmount;
+		header->policyOffset = policyOffset;
+		header->policyCapacity = policyCapacity;
+		header->ringOffset = ringOffset;
+		header->ringCapacity = ringCapacity;
+
+		workers.push_back(worker);
+	}
+}
+
+void RLGPC::ProcessWorkerServer::Start() {
+	if (shouldRun)
+		return;
+
+	RG_LOG("ProcessWorkerServer: Starting " << numWorkers << " process worker(s)...");
+	for (auto& worker : workers)
+		worker->process.SpawnSelf(SHM_ENV_VAR, worker->shm.name);
+
+	shouldRun = true;
+	pollThread = std::thread([this] {
+		std::vector<bool> unlinked = std::vector<bool>(workers.size(), false);
+
+		while (shouldRun) {
+			bool anyRead = false;
+			for (int i = 0; i < workers.size(); i++) {
+				auto& worker = workers[i];
+
+				// Once the worker has it open, the name is no longer needed
+				// This way the memory is freed by the system even if we crash
+				if (!unlinked[i] && worker->header->attached) {
+					worker->shm.Unlink();
+					unlinked[i] = true;
+				}
+
+				anyRead |= _ReadSegments(worker);
+			}
+
+			if (!anyRead) {
+				for (auto& worker : workers)
+					if (!worker->process.IsRunning())
+						RG_ERR_CLOSE("ProcessWorkerServer: Process worker " << worker->index << " exited unexpectedly");
+
+				RG_SLEEP(1);
+			}
+		}
+	});
+}
+
+void RLGPC::ProcessWorkerServer::Stop() {
+	if (!shouldRun)
+		return;
+
+	shouldRun = false;
+	pollThread.join();
+
+	for (auto& worker : workers)
+		worker->header->shouldStop = true;
+
+	for (auto& worker : workers)
+		if (!worker->process.Wait(5000))
+			worker->process.Kill();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	pendingTrajs.clear();
+	pendingSteps = 0;
+}
+
+void RLGPC::ProcessWorkerServer::UpdatePolicy(DiscretePolicy* policy, uint64_t version) {
+	DataStreamOut data;
+	RemoteProtocol::WriteParams(data, policy);
+	RemoteProtocol::WriteOBSStandardization(data, policy->obsStandardization);
+
+	for (auto& worker : workers) {
+		auto header = worker->header;
+		if (data.data.size() > header->policyCapacity)
+			RG_ERR_CLOSE("ProcessWorkerServer: Policy data (" << data.data.size() << " bytes) does not fit in shared memory (" << header->policyCapacity << " bytes)");
+
+		header->policySeq.fetch_add(1, std::memory_order_acq_rel);
+		memcpy(worker->shm.data + header->policyOffset, data.data.data(), data.data.size());
+		header->policySize.store(data.data.size(), std::memory_order_relaxed);
+		header->policyVersion.store(version, std::memory_order_relaxed);
+		header->policySeq.fetch_add(1, std::memory_order_release);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	policyVersion = version;
+}
+
+std::vector<RLGPC::GameTrajectory> RLGPC::ProcessWorkerServer::TakeTrajectories(uint64_t& outSteps) {
+	std::lock_guard<std::mutex> lock(mutex);
+	outSteps = pendingSteps;
+	pendingSteps = 0;
+	return std::move(pendingTrajs);
+}
+
+void RLGPC::ProcessWorkerServer::GetMetrics(Report& report) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	double elapsed = RS_MAX(statsTimer.Elapsed(), 1e-6);
+
+	uint64_t totalSteps = 0, totalStale = 0;
+	for (auto& worker : workers) {
+		totalSteps += worker->stepsReceived;
+		totalStale += worker->staleStepsDropped;
+	}
+
+	report["Process Workers"] = numWorkers;
+	report["Process Steps/Second"] = (int64_t)(totalSteps / elapsed);
+	report["Process Stale Steps Dropped"] = totalStale;
+}
+
+void RLGPC::ProcessWorkerServer::ResetMetrics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& worker : workers)
+		worker->stepsReceived = worker->staleStepsDropped = 0;
+	statsTimer.Reset();
+}
+
+bool RLGPC::ProcessWorkerServer::_ReadSegments(const std::shared_ptr<Worker>& worker) {
+	uint64_t head = worker->header->ringHead.load(std::memory_order_acquire);
+	if (worker->readPos == head)
+		return false;
+
+	uint8_t* ring = worker->RingData();
+	while (worker->readPos < head) {
+		uint64_t start = worker->readPos;
+		auto segHeader = (const SegmentHeader*)(ring + (start % ringCapacity));
+		uint64_t end = start + segHeader->size;
+		if (segHeader->size < sizeof(SegmentHeader) || end > head)
+			RG_ERR_CLOSE("ProcessWorkerServer: Process worker " << worker->index << " wrote an invalid segment");
+		worker->readPos = end;
+
+		if (segHeader->numSteps == 0) {
+			// Padding before the end of the ring
+			worker->ReleaseSegment(start, end);
+			continue;
+		}
+
+		SegmentLayout layout = SegmentLayout(segHeader->numSteps, segHeader->numTrunc, obsSize);
+		if (layout.size != segHeader->size || segHeader->numTrunc > segHeader->numSteps)
+			RG_ERR_CLOSE("ProcessWorkerServer: Process worker " << worker->index << " wrote an invalid segment");
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (policyVersion - segHeader->policyVersion > (uint64_t)maxPolicyAge) {
+			worker->staleStepsDropped += segHeader->numSteps;
+			worker->ReleaseSegment(start, end);
+			continue;
+		}
+
+		// Every tensor of the segment holds this, so the segment is released once the last one is freed
+		auto lease = std::shared_ptr<void>((void*)NULL, [worker, start, end](void*) { worker->ReleaseSegment(start, end); });
+		auto fnTensor = [&](int index, std::vector<int64_t> sizes) {
+			return torch::from_blob((void*)((const uint8_t*)segHeader + layout.offsets[index]), sizes, [lease](void*) {}, torch::kFloat);
+		};
+
+		int64_t numSteps = segHeader->numSteps;
+		GameTrajectory traj = {};
+		for (int i = 0; i < TrajectoryTensors::TENSOR_AMOUNT; i++) {
+			if (i == 0) {
+				traj.data[i] = fnTensor(i, { numSteps, obsSize });
+			} else {
+				traj.data[i] = fnTensor(i, { numSteps });
+			}
+		}
+		traj.truncNextStates = fnTensor(TrajectoryTensors::TENSOR_AMOUNT, { (int64_t)segHeader->numTrunc, obsSize });
+		traj.size = traj.capacity = numSteps;
+
+		worker->stepsReceived += numSteps;
+		pendingSteps += numSteps;
+		pendingTrajs.push_back(std::move(traj));
+
+		if (onStepsReceived)
+			onStepsReceived(numSteps);
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+#include "ProcessShared.h"
+#include "RemoteProtocol.h"
+#include "../PPO/DiscretePolicy.h"
+#include "../Util/SharedMemory.h"
+#include "../Util/ChildProcess.h"
+#include <RLGymPPO_CPP/Util/Report.h>
+#include <RLGymPPO_CPP/Util/Timer.h>
+
+namespace RLGPC {
+	// Starts process workers (see LearnerConfig::numProcessWorkers) and collects their segments on the learner's side
+	// Each worker has its own shared memory (see ProcessShared), the segments it writes there are used without being copied out
+	// Trajectories we give out point into the ring, and their part of the ring is only freed once all of their tensors are gone
+	class ProcessWorkerServer {
+	public:
+		int numWorkers;
+		int obsSize, actionAmount;
+		uint64_t ringCapacity;
+
+		// Segments collected with a policy more than this many versions older than ours are dropped
+		int maxPolicyAge;
+
+		// Called with the amount of steps in each segment we keep, while our mutex is locked
+		std::function<void(uint64_t)> onStepsReceived = NULL;
+
+		struct Worker {
+			int index;
+			SharedMemory shm;
+			ChildProcess process = {};
+			ProcessShared::Header* header;
+
+			// Start of the next segment to read, in bytes written to the ring in total
+			uint64_t readPos = 0;
+
+			// Segments released out of order, by start position, until the ring's tail reaches them
+			std::map<uint64_t, uint64_t> releasedSegments = {};
+			std::mutex releaseMutex = {};
+
+			uint64_t stepsReceived = 0, staleStepsDropped = 0;
+
+			Worker(int index, const std::string& shmName, uint64_t shmSize) : index(index), shm(shmName, shmSize, true, "ProcessWorkerServer: ") {
+				header = new (shm.data) ProcessShared::Header();
+			}
+
+			uint8_t* RingData() {
+				return shm.data + header->ringOffset;
+			}
+
+			// Frees [start, end) of the ring, along with every segment after it that was already released
+			void ReleaseSegment(uint64_t start, uint64_t end);
+		};
+
+		// Workers are shared with the trajectories that point into their ring, so their memory outlives us if those do
+		std::vector<std::shared_ptr<Worker>> workers = {};
+
+		std::mutex mutex = {};
+
+		uint64_t policyVersion = 0;
+
+		std::vector<GameTrajectory> pendingTrajs = {};
+		uint64_t pendingSteps = 0;
+
+		Timer statsTimer = {};
+
+		std::thread pollThread;
+		std::atomic<bool> shouldRun = false;
+
+		// policyCapacity should fit the largest data from UpdatePolicy(), ringCapacity fit the largest segment
+		ProcessWorkerServer(int numWorkers, int obsSize, int actionAmount, int maxPolicyAge, uint64_t policyCapacity, uint64_t ringCapacity);
+
+		RG_NO_COPY(ProcessWorkerServer);
+
+		// Starts the worker processes and our thread reading their rings
+		void Start();
+		void Stop();
+
+		// Makes a new policy version for workers to use
+		// This should be the same as the agent manager's policy version, as workers tag their steps with it
+		void UpdatePolicy(DiscretePolicy* policy, uint64_t version);
+
+		// Takes all segments received since the last call
+		std::vector<GameTrajectory> TakeTrajectories(uint64_t& outSteps);
+
+		void GetMetrics(Report& report);
+		void ResetMetrics();
+
+		// Reads every complete segment of this worker, returns false if there were none
+		bool _ReadSegments(const std::shared_ptr<Worker>& worker);
+
+		~ProcessWorkerServer() {
+			Stop();
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "RemoteProtocol.h"
+
+#include <torch/nn/utils/convert_parameters.h>
+
+using namespace torch;
+
+void _WriteTensor(DataStreamOut& out, Tensor t) {
+	t = t.to(kCPU, kFloat).contiguous();
+	RLGPC::RemoteProtocol::WriteFloats(out, t.data_ptr<float>(), t.numel());
+}
+
+bool _ReadTensor(DataStreamIn& in, std::vector<int64_t> sizes, Tensor& out) {
+	uint64_t numel = in.Read<uint64_t>();
+
+	int64_t expectedNumel = 1;
+	for (int64_t size : sizes)
+		expectedNumel *= size;
+
+	if (numel != expectedNumel || numel * sizeof(float) > in.GetNumBytesLeft())
+		return false;
+
+	out = torch::empty(sizes, kFloat);
+	in.ReadBytes(out.data_ptr<float>(), numel * sizeof(float));
+	return true;
+}
+
+void RLGPC::RemoteProtocol::WriteTrajectory(DataStreamOut& out, GameTrajectory& traj) {
+	traj.RemoveCapacity();
+
+	int64_t numTrunc = traj.truncNextStates.defined() ? traj.truncNextStates.size(0) : 0;
+	out.Write<uint64_t>(traj.size);
+	out.Write<uint64_t>(numTrunc);
+
+	for (int i = 0; i < TrajectoryTensors::REMOTE_TENSOR_AMOUNT; i++)
+		_WriteTensor(out, traj.data[i]);
+
+	if (numTrunc > 0)
+		_WriteTensor(out, traj.truncNextStates);
+}
+
+bool RLGPC::RemoteProtocol::ReadTrajectory(DataStreamIn& in, int obsSize, GameTrajectory& outTraj) {
+	uint64_t size = in.Read<uint64_t>();
+	uint64_t numTrunc = in.Read<uint64_t>();
+	if (in.IsOverflown() || size == 0 || numTrunc > size)
+		return false;
+
+	outTraj = {};
+	for (int i = 0; i < TrajectoryTensors::REMOTE_TENSOR_AMOUNT; i++) {
+		// States are the only tensor with more than one value per step
+		std::vector<int64_t> sizes = { (int64_t)size };
+		if (i == 0)
+			sizes.push_back(obsSize);
+
+		if (!_ReadTensor(in, sizes, outTraj.data[i]))
+			return false;
+	}
+	outTraj.data.policyIDs = torch::zeros({ (int64_t)size });
+
+	if (numTrunc > 0) {
+		if (!_ReadTensor(in, { (int64_t)numTrunc, obsSize }, outTraj.truncNextStates))
+			return false;
+	} else {
+		outTraj.truncNextStates = torch::empty({ 0, obsSize }, kFloat);
+	}
+
+	outTraj.size = outTraj.capacity = size;
+	return !in.IsOverflown();
+}
+
+void RLGPC::RemoteProtocol::WriteParams(DataStreamOut& out, torch::nn::Module* model) {
+	RG_NOGRAD;
+	_WriteTensor(out, nn::utils::parameters_to_vector(model->parameters()));
+}
+
+bool RLGPC::RemoteProtocol::ReadParams(DataStreamIn& in, torch::nn::Module* model) {
+	RG_NOGRAD;
+	auto params = model->parameters();
+
+	int64_t numParams = 0;
+	for (auto& param : params)
+		numParams += param.numel();
+
+	Tensor paramVec;
+	if (!_ReadTensor(in, { numParams }, paramVec))
+		return false;
+
+	// Copy in-place, as agents might still be using the model
+	paramVec = paramVec.to(params[0].device());
+	int64_t offset = 0;
+	for (auto& param : params) {
+		param.copy_(paramVec.slice(0, offset, offset + param.numel()).view_as(param));
+		offset += param.numel();
+	}
+	return true;
+}
+
+void RLGPC::RemoteProtocol::WriteOBSStandardization(DataStreamOut& out, const OBSStandardization& standardization) {
+	out.Write<uint8_t>(standardization.IsSet());
+	if (standardization.IsSet()) {
+		_WriteTensor(out, standardization.scale);
+		_WriteTensor(out, standardization.shift);
+	}
+}
+
+bool RLGPC::RemoteProtocol::ReadOBSStandardization(DataStreamIn& in, int obsSize, OBSStandardization& outStandardization) {
+	outStandardization = {};
+	bool isSet = in.Read<uint8_t>();
+	if (in.IsOverflown())
+		return false;
+
+	if (!isSet)
+		return true;
+
+	return
+		_ReadTensor(in, { obsSize }, outStandardization.scale) &&
+		_ReadTensor(in, { obsSize }, outStandardization.shift);
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include "GameTrajectory.h"
+#include "RemoteProtocolBase.h"
+#include "../PPO/OBSStandardization.h"
+
+namespace RLGPC {
+	// Parts of the protocol that use torch, see RemoteProtocolBase.h for the rest
+	namespace RemoteProtocol {
+		// Tensors are written as raw floats
+		void WriteTrajectory(DataStreamOut& out, GameTrajectory& traj);
+
+		// Returns false if the data doesn't describe a valid trajectory of this OBS size
+		bool ReadTrajectory(DataStreamIn& in, int obsSize, GameTrajectory& outTraj);
+
+		void WriteParams(DataStreamOut& out, torch::nn::Module* model);
+
+		// Returns false if the amount of parameters doesn't match the model
+		bool ReadParams(DataStreamIn& in, torch::nn::Module* model);
+
+		void WriteOBSStandardization(DataStreamOut& out, const OBSStandardization& standardization);
+
+		// Returns false if the standardization is set, but not of this OBS size
+		bool ReadOBSStandardization(DataStreamIn& in, int obsSize, OBSStandardization& outStandardization);
+	}
+}
\ No newline at end of file
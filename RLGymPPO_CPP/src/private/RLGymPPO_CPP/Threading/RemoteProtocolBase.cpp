@@ -0,0 +1,50 @@
+#include "RemoteProtocolBase.h"
+
+bool RLGPC::RemoteProtocol::SendMsg(TCPSocket& socket, MsgType type, const DataStreamOut& data) {
+	MsgHeader header = { MAGIC, type, data.data.size() };
+	return socket.SendAll(&header, sizeof(header)) && socket.SendAll(data.data.data(), data.data.size());
+}
+
+bool RLGPC::RemoteProtocol::RecvMsg(TCPSocket& socket, MsgType& outType, DataStreamIn& outData) {
+	MsgHeader header;
+	if (!socket.RecvAll(&header, sizeof(header)))
+		return false;
+
+	if (header.magic != MAGIC || header.size > MAX_MSG_SIZE)
+		return false;
+
+	outType = header.type;
+	outData = {};
+	outData.data.resize(header.size);
+	return socket.RecvAll(outData.data.data(), header.size);
+}
+
+void RLGPC::RemoteProtocol::WriteString(DataStreamOut& out, const std::string& str) {
+	out.Write<uint32_t>(str.size());
+	out.WriteBytes(str.data(), str.size());
+}
+
+std::string RLGPC::RemoteProtocol::ReadString(DataStreamIn& in) {
+	uint32_t size = in.Read<uint32_t>();
+	if (size > in.GetNumBytesLeft())
+		return {};
+
+	std::string result = std::string(size, '\0');
+	in.ReadBytes(result.data(), size);
+	return result;
+}
+
+void RLGPC::RemoteProtocol::WriteFloats(DataStreamOut& out, const float* data, uint64_t amount) {
+	out.Write<uint64_t>(amount);
+	out.WriteBytes(data, amount * sizeof(float));
+}
+
+bool RLGPC::RemoteProtocol::ReadFloats(DataStreamIn& in, uint64_t expectedAmount, FList& out) {
+	uint64_t amount = in.Read<uint64_t>();
+	if (amount != expectedAmount || amount * sizeof(float) > in.GetNumBytesLeft())
+		return false;
+
+	out.resize(amount);
+	in.ReadBytes(out.data(), amount * sizeof(float));
+	return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "../Util/TCPSocket.h"
+#include <RLGymPPO_CPP/Lists.h>
+
+namespace RLGPC {
+	// Binary protocol between the learner and remote workers (see RemoteWorker)
+	// Every message is a header, followed by its data
+	// This is the part of the protocol that doesn't need torch, so torch-free workers can use it (see SimWorker)
+	namespace RemoteProtocol {
+		constexpr uint32_t MAGIC = 0x57524752; // "RGRW"
+		constexpr uint32_t VERSION = 3;
+
+		// Messages larger than this are treated as corrupt
+		constexpr uint64_t MAX_MSG_SIZE = 1ull << 32;
+
+		enum class MsgType : uint32_t {
+			HELLO,			// Worker -> learner: protocol version, worker name, OBS size, action amount
+			HELLO_REPLY,	// Learner -> worker: whether the worker was accepted, and why not
+			POLICY_REQUEST,	// Worker -> learner: policy version the worker has (0 for none)
+			POLICY,			// Learner -> worker: policy version, and its parameters and OBS standardization if the worker's version is different
+			TRAJECTORY		// Worker -> learner: oldest policy version used to collect it, and the trajectory
+		};
+
+		struct MsgHeader {
+			uint32_t magic;
+			MsgType type;
+			uint64_t size;
+		};
+
+		bool SendMsg(TCPSocket& socket, MsgType type, const DataStreamOut& data);
+
+		// Returns false if the connection was lost or the message is corrupt
+		bool RecvMsg(TCPSocket& socket, MsgType& outType, DataStreamIn& outData);
+
+		void WriteString(DataStreamOut& out, const std::string& str);
+		std::string ReadString(DataStreamIn& in);
+
+		// Arrays of floats (tensors, parameters, etc.) are written as their amount, then the raw floats
+		void WriteFloats(DataStreamOut& out, const float* data, uint64_t amount);
+
+		// Reads an array of floats into out, which is resized to its amount
+		// Returns false if the amount isn't expectedAmount, or is more than what is left
+		bool ReadFloats(DataStreamIn& in, uint64_t expectedAmount, FList& out);
+	}
+}
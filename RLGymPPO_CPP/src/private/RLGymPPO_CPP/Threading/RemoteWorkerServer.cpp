@@ -0,0 +1,222 @@
+#include "RemoteWorkerServer.h"
+
+using namespace RLGPC::RemoteProtocol;
+
+void RLGPC::RemoteWorkerServer::Start() {
+	if (shouldRun)
+		return;
+
+	listenSocket = TCPSocket::Listen(port);
+	if (!listenSocket.IsOpen())
+		RG_ERR_CLOSE("RemoteWorkerServer: Failed to listen on port " << port);
+
+	RG_LOG("RemoteWorkerServer: Listening for remote workers on port " << port);
+
+	shouldRun = true;
+	listenThread = std::thread([this] {
+		while (shouldRun) {
+			TCPSocket socket = listenSocket.Accept();
+			if (!socket.IsOpen())
+				continue;
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			// Clean up clients that have disconnected
+			for (auto itr = clients.begin(); itr != clients.end();) {
+				if ((*itr)->finished) {
+					(*itr)->thread.join();
+					delete *itr;
+					itr = clients.erase(itr);
+				} else {
+					itr++;
+				}
+			}
+
+			Client* client = new Client();
+			client->socket = std::move(socket);
+			client->thread = std::thread(&RemoteWorkerServer::_RunClient, this, client);
+			clients.push_back(client);
+		}
+	});
+}
+
+void RLGPC::RemoteWorkerServer::Stop() {
+	if (!shouldRun)
+		return;
+
+	shouldRun = false;
+	listenSocket.Close();
+	listenThread.join();
+
+	std::list<Client*> clientsToStop;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		clientsToStop = clients;
+		clients.clear();
+
+		// Wakes up their threads if they are waiting on the socket
+		for (Client* client : clientsToStop)
+			client->socket.Close();
+	}
+
+	for (Client* client : clientsToStop) {
+		client->thread.join();
+		delete client;
+	}
+}
+
+void RLGPC::RemoteWorkerServer::UpdatePolicy(DiscretePolicy* policy, uint64_t version) {
+	auto newData = std::make_shared<DataStreamOut>();
+	WriteParams(*newData, policy);
+	WriteOBSStandardization(*newData, policy->obsStandardization);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	policyData = newData;
+	policyVersion = version;
+}
+
+std::vector<RLGPC::GameTrajectory> RLGPC::RemoteWorkerServer::TakeTrajectories(uint64_t& outSteps) {
+	std::lock_guard<std::mutex> lock(mutex);
+	outSteps = pendingSteps;
+	pendingSteps = 0;
+	return std::move(pendingTrajs);
+}
+
+void RLGPC::RemoteWorkerServer::GetMetrics(Report& report) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	double elapsed = RS_MAX(statsTimer.Elapsed(), 1e-6);
+
+	int numConnected = 0;
+	uint64_t totalSteps = 0, totalStale = 0;
+	for (auto& pair : workerStats) {
+		auto& stats = pair.second;
+		numConnected += stats.connected;
+		totalSteps += stats.stepsReceived;
+		totalStale += stats.staleStepsDropped;
+
+		report["Remote Worker Steps/Second/" + pair.first] = (int64_t)(stats.stepsReceived / elapsed);
+	}
+
+	report["Remote Workers"] = numConnected;
+	report["Remote Steps/Second"] = (int64_t)(totalSteps / elapsed);
+	report["Remote Stale Steps Dropped"] = totalStale;
+}
+
+void RLGPC::RemoteWorkerServer::ResetMetrics() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Keep connected workers, so that they still show up if they sent nothing this iteration
+	for (auto itr = workerStats.begin(); itr != workerStats.end();) {
+		if (itr->second.connected) {
+			itr->second = { true };
+			itr++;
+		} else {
+			itr = workerStats.erase(itr);
+		}
+	}
+	statsTimer.Reset();
+}
+
+void RLGPC::RemoteWorkerServer::_RunClient(Client* client) {
+	auto& socket = client->socket;
+
+	MsgType type;
+	DataStreamIn in;
+
+	// Workers need to introduce themselves first
+	bool accepted = false;
+	if (RecvMsg(socket, type, in) && type == MsgType::HELLO) {
+		uint32_t protocolVersion = in.Read<uint32_t>();
+		client->name = ReadString(in);
+		int workerObsSize = in.Read<int32_t>();
+		int workerActionAmount = in.Read<int32_t>();
+
+		std::string rejectReason = {};
+		if (in.IsOverflown() || protocolVersion != VERSION) {
+			rejectReason = "Protocol version mismatch";
+		} else if (workerObsSize != obsSize || workerActionAmount != actionAmount) {
+			rejectReason = "OBS size or action amount does not match the learner";
+		} else {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (workerStats.count(client->name) && workerStats[client->name].connected) {
+				rejectReason = "A worker with this name is already connected";
+			} else {
+				workerStats[client->name].connected = true;
+				accepted = true;
+			}
+		}
+
+		DataStreamOut reply;
+		reply.Write<uint8_t>(accepted);
+		WriteString(reply, rejectReason);
+		SendMsg(socket, MsgType::HELLO_REPLY, reply);
+
+		if (accepted) {
+			RG_LOG("RemoteWorkerServer: Worker \"" << client->name << "\" connected");
+		} else {
+			RG_LOG("RemoteWorkerServer: Rejected worker \"" << client->name << "\": " << rejectReason);
+		}
+	}
+
+	while (accepted && shouldRun) {
+		if (!RecvMsg(socket, type, in))
+			break;
+
+		if (type == MsgType::POLICY_REQUEST) {
+			uint64_t workerVersion = in.Read<uint64_t>();
+
+			uint64_t curVersion;
+			std::shared_ptr<const DataStreamOut> curData;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				curVersion = policyVersion;
+				curData = policyData;
+			}
+
+			DataStreamOut reply;
+			reply.Write<uint64_t>(curVersion);
+			if (workerVersion != curVersion && curData)
+				reply.WriteBytes(curData->data.data(), curData->data.size());
+
+			if (!SendMsg(socket, MsgType::POLICY, reply))
+				break;
+
+		} else if (type == MsgType::TRAJECTORY) {
+			uint64_t trajVersion = in.Read<uint64_t>();
+
+			GameTrajectory traj;
+			if (!ReadTrajectory(in, obsSize, traj)) {
+				RG_LOG("RemoteWorkerServer: Received an invalid trajectory from worker \"" << client->name << "\", disconnecting it");
+				break;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			auto& stats = workerStats[client->name];
+			if (policyVersion - trajVersion > (uint64_t)maxPolicyAge) {
+				stats.staleStepsDropped += traj.size;
+			} else {
+				stats.stepsReceived += traj.size;
+				pendingSteps += traj.size;
+				pendingTrajs.push_back(std::move(traj));
+
+				if (onStepsReceived)
+					onStepsReceived(pendingTrajs.back().size);
+			}
+		} else {
+			RG_LOG("RemoteWorkerServer: Received an unexpected message from worker \"" << client->name << "\", disconnecting it");
+			break;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (accepted) {
+		workerStats[client->name].connected = false;
+		if (shouldRun)
+			RG_LOG("RemoteWorkerServer: Worker \"" << client->name << "\" disconnected");
+	}
+
+	// Stop() also closes our socket, so this needs to be locked
+	socket.Close();
+	client->finished = true;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#include "RemoteProtocol.h"
+#include "../PPO/DiscretePolicy.h"
+#include <RLGymPPO_CPP/Util/Report.h>
+#include <RLGymPPO_CPP/Util/Timer.h>
+
+namespace RLGPC {
+	// Accepts connections from remote workers (see RemoteWorker) on the learner's side
+	// Workers are sent the latest version of the policy, and the trajectories they send are kept until the next collection
+	class RemoteWorkerServer {
+	public:
+		int port;
+		int obsSize, actionAmount;
+
+		// Trajectories collected with a policy more than this many versions older than ours are dropped
+		int maxPolicyAge;
+
+		// Called with the amount of steps in each trajectory we keep, while our mutex is locked
+		std::function<void(uint64_t)> onStepsReceived = NULL;
+
+		struct WorkerStats {
+			bool connected = false;
+			uint64_t stepsReceived = 0, staleStepsDropped = 0;
+		};
+
+		struct Client {
+			std::string name;
+			TCPSocket socket;
+			std::thread thread;
+			bool finished = false;
+		};
+
+		std::mutex mutex = {};
+
+		uint64_t policyVersion = 0;
+		// Full-precision parameters of the current policy version, in the format of RemoteProtocol::WriteParams()
+		std::shared_ptr<const DataStreamOut> policyData = NULL;
+
+		std::vector<GameTrajectory> pendingTrajs = {};
+		uint64_t pendingSteps = 0;
+
+		// By worker name, reset by ResetMetrics()
+		std::map<std::string, WorkerStats> workerStats = {};
+		Timer statsTimer = {};
+
+		TCPSocket listenSocket;
+		std::thread listenThread;
+		std::list<Client*> clients = {};
+		std::atomic<bool> shouldRun = false;
+
+		RemoteWorkerServer(int port, int obsSize, int actionAmount, int maxPolicyAge) :
+			port(port), obsSize(obsSize), actionAmount(actionAmount), maxPolicyAge(maxPolicyAge) {}
+
+		RG_NO_COPY(RemoteWorkerServer);
+
+		void Start();
+		void Stop();
+
+		// Makes a new policy version for workers to use
+		// This should be the same as the agent manager's policy version, as workers tag their steps with it
+		void UpdatePolicy(DiscretePolicy* policy, uint64_t version);
+
+		// Takes all trajectories received since the last call
+		std::vector<GameTrajectory> TakeTrajectories(uint64_t& outSteps);
+
+		void GetMetrics(Report& report);
+		void ResetMetrics();
+
+		void _RunClient(Client* client);
+
+		~RemoteWorkerServer() {
+			Stop();
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "RolloutStorage.h"
+
+// Copies a 1D CPU tensor into float memory, without making a new tensor if the type is one we expect
+void _CopyTensorToFloats(torch::Tensor tensor, float* to, int64_t amount) {
+	assert(tensor.numel() == amount);
+	tensor = tensor.contiguous();
+
+	switch (tensor.scalar_type()) {
+	case torch::kFloat:
+		memcpy(to, tensor.data_ptr<float>(), amount * sizeof(float));
+		break;
+	case torch::kInt64:
+	{
+		const int64_t* from = tensor.data_ptr<int64_t>();
+		for (int64_t i = 0; i < amount; i++)
+			to[i] = (float)from[i];
+		break;
+	}
+	case torch::kInt32:
+	{
+		const int32_t* from = tensor.data_ptr<int32_t>();
+		for (int64_t i = 0; i < amount; i++)
+			to[i] = (float)from[i];
+		break;
+	}
+	default:
+		// Uncommon type, just let torch convert it
+		_CopyTensorToFloats(tensor.to(torch::kFloat), to, amount);
+	}
+}
+
+RLGPC::RolloutStorage::RolloutStorage(int numPlayers, int obsSize, uint64_t maxCollect, HugePageMode hugePages) :
+	numPlayers(numPlayers), obsSize(obsSize) {
+
+	for (auto list : { &states, &actions, &logProbs, &rewards, &dones, &values, &policyVersions })
+		*list = HugeFList(HugePageAllocator<float>(hugePages));
+
+	// Agents only stop stepping once they have collected more than maxCollect, so we can go one step over
+	Reserve((size_t)(maxCollect / RS_MAX(numPlayers, 1)) + 1);
+}
+
+void RLGPC::RolloutStorage::Reserve(size_t newCapacity) {
+	if (newCapacity <= capacity)
+		return;
+
+	capacity = newCapacity;
+	states.resize((capacity + 1) * GetStepSize());
+	for (auto list : { &actions, &logProbs, &rewards, &dones, &values, &policyVersions })
+		list->resize(capacity * numPlayers);
+	learned.resize(capacity * numPlayers);
+}
+
+size_t RLGPC::RolloutStorage::GetCapacityBytes() const {
+	size_t bytes = states.capacity() * sizeof(float) + learned.capacity();
+	for (auto list : { &actions, &logProbs, &rewards, &dones, &values, &policyVersions })
+		bytes += list->capacity() * sizeof(float);
+	return bytes;
+}
+
+size_t RLGPC::RolloutStorage::GetUsedBytes() const {
+	// Floats of every step, and the learned flag of each of its players
+	size_t stepBytes = (GetStepSize() + numPlayers * 6) * sizeof(float) + numPlayers;
+	return size * stepBytes + GetStepSize() * sizeof(float);
+}
+
+int RLGPC::RolloutStorage::AddStep(
+	const float* nextObs, const float* stepRewards, const float* stepDones, 
+	torch::Tensor stepActions, torch::Tensor stepLogProbs, torch::Tensor stepValues, float policyVersion,
+	const uint8_t* stepLearned) {
+	// Agents share a global step limit, so one agent can collect more than its share
+	if (size >= capacity)
+		Reserve(capacity * 2);
+
+	size_t offset = size * numPlayers;
+	_CopyTensorToFloats(stepActions, actions.data() + offset, numPlayers);
+	_CopyTensorToFloats(stepLogProbs, logProbs.data() + offset, numPlayers);
+	memcpy(rewards.data() + offset, stepRewards, numPlayers * sizeof(float));
+	memcpy(dones.data() + offset, stepDones, numPlayers * sizeof(float));
+	if (stepValues.defined()) {
+		_CopyTensorToFloats(stepValues, values.data() + offset, numPlayers);
+	} else {
+		std::fill(values.begin() + offset, values.begin() + offset + numPlayers, 0.f);
+	}
+	std::fill(policyVersions.begin() + offset, policyVersions.begin() + offset + numPlayers, policyVersion);
+
+	int learnedAmount = numPlayers;
+	if (stepLearned) {
+		memcpy(learned.data() + offset, stepLearned, numPlayers);
+		for (int i = 0; i < numPlayers; i++)
+			learnedAmount -= !stepLearned[i];
+		unlearnedAmount += numPlayers - learnedAmount;
+	} else {
+		std::fill(learned.begin() + offset, learned.begin() + offset + numPlayers, 1);
+	}
+
+	memcpy(GetStates(size + 1), nextObs, GetStepSize() * sizeof(float));
+
+	size++;
+	return learnedAmount;
+}
+
+RLGPC::GameTrajectory RLGPC::RolloutStorage::Collect() {
+	GameTrajectory result = {};
+	if (size == 0)
+		return result;
+
+	int64_t
+		numSteps = size,
+		numPlayers = this->numPlayers,
+		obsSize = this->obsSize;
+
+	auto options = torch::TensorOptions().dtype(torch::kFloat);
+
+	// Converts [step][player](...) data into [player][step](...), then flattens the first two dimensions
+	// We always want a copy, as the storage will be overwritten once collection continues
+	auto fnToPlayerMajor = [&](float* data, bool isObs) -> torch::Tensor {
+		std::vector<int64_t> sizes = { numSteps, numPlayers };
+		if (isObs)
+			sizes.push_back(obsSize);
+
+		auto t = torch::from_blob(data, sizes, options).transpose(0, 1).clone(torch::MemoryFormat::Contiguous);
+		return isObs ? t.view({ -1, obsSize }) : t.view({ -1 });
+	};
+
+	// If the last timestep is not a done, mark it as truncated
+	// The GAE needs to know when the environment state stops being continuous
+	// This happens either because the environment reset (i.e. goal scored), called "done",
+	//	or the data got cut short, called "truncated"
+	// Truncated steps are the only steps whose next state we need to keep
+	std::vector<float> truncateds = std::vector<float>(numSteps * numPlayers, 0);
+	std::vector<int64_t> truncPlayers = {};
+	for (int64_t i = 0; i < numPlayers; i++) {
+		// Players can only stop being learned after a done, so their last learned step is either done or their current one
+		int64_t lastStep = numSteps - 1;
+		if (unlearnedAmount > 0)
+			while (lastStep >= 0 && !learned[lastStep * numPlayers + i])
+				lastStep--;
+		if (lastStep < 0)
+			continue;
+
+		int64_t idx = lastStep * numPlayers + i;
+		truncateds[idx] = (dones[idx] == 0);
+		if (truncateds[idx])
+			truncPlayers.push_back(i);
+	}
+
+	auto& data = result.data;
+	data.states = fnToPlayerMajor(GetStates(0), true);
+	data.actions = fnToPlayerMajor(actions.data(), false);
+	data.logProbs = fnToPlayerMajor(logProbs.data(), false);
+	data.rewards = fnToPlayerMajor(rewards.data(), false);
+#ifdef RG_PARANOID_MODE
+	data.debugCounters = torch::arange(debugCounter, debugCounter + numSteps).repeat({ numPlayers });
+	debugCounter += numSteps;
+#endif
+	data.dones = fnToPlayerMajor(dones.data(), false);
+	data.truncateds = fnToPlayerMajor(truncateds.data(), false);
+	data.values = fnToPlayerMajor(values.data(), false);
+	data.policyVersions = fnToPlayerMajor(policyVersions.data(), false);
+	if (playerPolicyIDs.empty()) {
+		data.policyIDs = torch::zeros({ numSteps * numPlayers });
+	} else {
+		assert(playerPolicyIDs.size() == numPlayers);
+		data.policyIDs = torch::tensor(playerPolicyIDs).repeat_interleave(numSteps);
+	}
+
+	// The next state of each player's last step is our current observation
+	auto curObs = torch::from_blob(GetStates(size), { numPlayers, obsSize }, options);
+	auto truncPlayersTensor = torch::from_blob(truncPlayers.data(), { (int64_t)truncPlayers.size() }, torch::kInt64);
+	result.truncNextStates = curObs.index_select(0, truncPlayersTensor);
+
+	result.size = result.capacity = numSteps * numPlayers;
+
+	// Remove steps that aren't learned, keeping the player-major order
+	if (unlearnedAmount > 0) {
+		std::vector<int64_t> learnedIndices = {};
+		learnedIndices.reserve(result.size - unlearnedAmount);
+		for (int64_t i = 0; i < numPlayers; i++)
+			for (int64_t j = 0; j < numSteps; j++)
+				if (learned[j * numPlayers + i])
+					learnedIndices.push_back(i * numSteps + j);
+
+		auto learnedIndicesTensor = torch::from_blob(learnedIndices.data(), { (int64_t)learnedIndices.size() }, torch::kInt64);
+		for (auto& t : data)
+			t = t.index_select(0, learnedIndicesTensor);
+		result.size = result.capacity = learnedIndices.size();
+		unlearnedAmount = 0;
+	}
+
+	// Our current observation becomes the first row
+	memcpy(GetStates(0), GetStates(size), GetStepSize() * sizeof(float));
+	size = 0;
+
+	return result;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "GameTrajectory.h"
+#include "../Util/HugePageAllocator.h"
+
+namespace RLGPC {
+	// Preallocated columnar storage for the timesteps collected by a single ThreadAgent
+	// Every agent step adds exactly one timestep for every player of every game, so all player trajectories have the same length
+	// Because of this, data is stored step-major ([step][player]), which is exactly the layout the policy infers with
+	// The step path only allocates when the storage grows, the data is only re-ordered into player-major trajectories when collected
+	struct RolloutStorage {
+		int numPlayers = 0, obsSize = 0;
+
+		// Amount of steps we can store before growing
+		size_t capacity = 0;
+
+		// Amount of steps currently stored
+		size_t size = 0;
+
+		// [capacity + 1][numPlayers][obsSize]
+		// Row N is the observation that the action of step N was taken in
+		// Row (size) is always the current observation, which has not been acted on yet
+		HugeFList states;
+
+		// [capacity][numPlayers]
+		HugeFList actions, logProbs, rewards, dones, values, policyVersions;
+
+		// [capacity][numPlayers], 0 for steps whose action was not chosen by the learning policy (i.e. opponents from an OpponentPool)
+		// These steps are left out of collected trajectories
+		// NOTE: A player's steps may only switch between learned and not learned after a done, so that every trajectory stays continuous
+		std::vector<uint8_t> learned;
+		size_t unlearnedAmount = 0; // Amount of steps we currently store that aren't learned
+
+		// [numPlayers], the ID of the policy that controls each player (see LearnerConfig::playerPolicyIDs), all 0 if empty
+		// Players keep their policy, so this is only needed once per player rather than per step
+		FList playerPolicyIDs;
+
+#ifdef RG_PARANOID_MODE
+		int64_t debugCounter = 0;
+#endif
+
+		RolloutStorage() = default;
+
+		// Initial capacity is determined from the amount of player-steps we expect to collect
+		// Columns large enough for huge pages are backed by them if hugePages is not NONE
+		RolloutStorage(int numPlayers, int obsSize, uint64_t maxCollect, HugePageMode hugePages = HugePageMode::NONE);
+
+		// Grows the storage to fit at least newCapacity steps
+		// NOTE: Only allocates if newCapacity is greater than our current capacity
+		void Reserve(size_t newCapacity);
+
+		size_t GetStepSize() const {
+			return (size_t)numPlayers * obsSize;
+		}
+
+		// Bytes allocated for our capacity, which is more than we need once we have grown
+		size_t GetCapacityBytes() const;
+		// Bytes holding the steps we currently store
+		size_t GetUsedBytes() const;
+
+		float* GetStates(size_t step) {
+			return states.data() + step * GetStepSize();
+		}
+
+		// NOTE: Assumes that the current observations (row "size") are already written
+		// Writes the step data into row "size", and the next observations into row "size + 1"
+		// stepValues can be undefined if the critic was not inferred, values are then zero
+		// policyVersion is the version of the policy that inferred the actions
+		// stepLearned is which players' steps are learned ([numPlayers]), all of them if NULL
+		// Returns the amount of added steps that are learned
+		int AddStep(
+			const float* nextObs, const float* stepRewards, const float* stepDones, 
+			torch::Tensor stepActions, torch::Tensor stepLogProbs, torch::Tensor stepValues, float policyVersion,
+			const uint8_t* stepLearned = NULL);
+
+		// Builds player-major trajectory tensors from everything we have collected, then clears all collected steps
+		// The last learned step of each player is marked as truncated if it is not done
+		GameTrajectory Collect();
+	};
+}
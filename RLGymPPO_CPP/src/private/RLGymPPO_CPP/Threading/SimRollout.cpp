@@ -0,0 +1,123 @@
+#include "SimRollout.h"
+#include "RemoteProtocolBase.h"
+
+RLGPC::SimRollout::SimRollout(int numPlayers, int obsSize) : numPlayers(numPlayers), obsSize(obsSize) {
+	states.resize(GetStepSize());
+}
+
+void RLGPC::SimRollout::SetCurOBS(const float* obs) {
+	memcpy(GetStates(size), obs, GetStepSize() * sizeof(float));
+}
+
+void RLGPC::SimRollout::AddStep(
+	const float* nextObs, const int64_t* stepActions, const float* stepLogProbs,
+	const float* stepRewards, const float* stepDones, float policyVersion) {
+
+	for (int i = 0; i < numPlayers; i++)
+		actions.push_back(stepActions[i]);
+	logProbs.insert(logProbs.end(), stepLogProbs, stepLogProbs + numPlayers);
+	rewards.insert(rewards.end(), stepRewards, stepRewards + numPlayers);
+	dones.insert(dones.end(), stepDones, stepDones + numPlayers);
+	policyVersions.insert(policyVersions.end(), numPlayers, policyVersion);
+
+	size++;
+	states.resize((size + 1) * GetStepSize());
+	SetCurOBS(nextObs);
+}
+
+void RLGPC::SimRollout::Clear() {
+	// Our current observation becomes the first row
+	memmove(GetStates(0), GetStates(size), GetStepSize() * sizeof(float));
+	states.resize(GetStepSize());
+	size = 0;
+
+	actions.clear();
+	logProbs.clear();
+	rewards.clear();
+	dones.clear();
+	policyVersions.clear();
+}
+
+void RLGPC::SimRollout::WriteTrajectory(DataStreamOut& out, const std::vector<SimRollout*>& rollouts) {
+	uint64_t totalSize = 0, numTrunc = 0;
+	for (auto rollout : rollouts) {
+		if (rollout->size == 0)
+			continue;
+
+		totalSize += rollout->size * rollout->numPlayers;
+		for (int i = 0; i < rollout->numPlayers; i++)
+			numTrunc += (rollout->dones[(rollout->size - 1) * rollout->numPlayers + i] == 0);
+	}
+
+	out.Write<uint64_t>(totalSize);
+	out.Write<uint64_t>(numTrunc);
+
+	// Writes a column of all rollouts in player-major order, fnGetValue(rollout, step, player) is the value of each step
+	FList column = {};
+	auto fnWriteColumn = [&](auto fnGetValue) {
+		column.clear();
+		column.reserve(totalSize);
+		for (auto rollout : rollouts)
+			for (int i = 0; i < rollout->numPlayers; i++)
+				for (size_t j = 0; j < rollout->size; j++)
+					column.push_back(fnGetValue(rollout, j, i));
+		RemoteProtocol::WriteFloats(out, column.data(), column.size());
+	};
+
+	// States
+	column.clear();
+	column.reserve(totalSize * (rollouts.empty() ? 0 : rollouts[0]->obsSize));
+	for (auto rollout : rollouts) {
+		for (int i = 0; i < rollout->numPlayers; i++) {
+			for (size_t j = 0; j < rollout->size; j++) {
+				const float* obs = rollout->GetStates(j) + (size_t)i * rollout->obsSize;
+				column.insert(column.end(), obs, obs + rollout->obsSize);
+			}
+		}
+	}
+	RemoteProtocol::WriteFloats(out, column.data(), column.size());
+
+	auto fnIdx = [](SimRollout* rollout, size_t step, int player) {
+		return step * rollout->numPlayers + player;
+	};
+
+	fnWriteColumn([&](SimRollout* r, size_t j, int i) { return r->actions[fnIdx(r, j, i)]; });
+	fnWriteColumn([&](SimRollout* r, size_t j, int i) { return r->logProbs[fnIdx(r, j, i)]; });
+	fnWriteColumn([&](SimRollout* r, size_t j, int i) { return r->rewards[fnIdx(r, j, i)]; });
+#ifdef RG_PARANOID_MODE
+	fnWriteColumn([&](SimRollout* r, size_t j, int i) { return (float)(r->debugCounter + j); });
+#endif
+	fnWriteColumn([&](SimRollout* r, size_t j, int i) { return r->dones[fnIdx(r, j, i)]; });
+
+	// If the last timestep is not a done, it is truncated (see RolloutStorage::Collect())
+	fnWriteColumn([&](SimRollout* r, size_t j, int i) {
+		return (float)(j == r->size - 1 && r->dones[fnIdx(r, j, i)] == 0);
+	});
+
+	fnWriteColumn([&](SimRollout* r, size_t j, int i) { return 0.f; });
+	fnWriteColumn([&](SimRollout* r, size_t j, int i) { return r->policyVersions[fnIdx(r, j, i)]; });
+
+	// The next state of each truncated step is the current observation of its player
+	if (numTrunc > 0) {
+		column.clear();
+		for (auto rollout : rollouts) {
+			if (rollout->size == 0)
+				continue;
+
+			for (int i = 0; i < rollout->numPlayers; i++) {
+				if (rollout->dones[fnIdx(rollout, rollout->size - 1, i)] == 0) {
+					const float* obs = rollout->GetStates(rollout->size) + (size_t)i * rollout->obsSize;
+					column.insert(column.end(), obs, obs + rollout->obsSize);
+				}
+			}
+		}
+		RemoteProtocol::WriteFloats(out, column.data(), column.size());
+	}
+
+	for (auto rollout : rollouts) {
+#ifdef RG_PARANOID_MODE
+		rollout->debugCounter += rollout->size;
+#endif
+		rollout->Clear();
+	}
+}
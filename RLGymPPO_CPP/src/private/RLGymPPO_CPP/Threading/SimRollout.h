@@ -0,0 +1,53 @@
+#pragma once
+#include <RLGymPPO_CPP/Lists.h>
+
+namespace RLGPC {
+	// Torch-free version of RolloutStorage, for workers that only simulate (see SimWorker)
+	// Steps are stored step-major ([step][player]), and only re-ordered into player-major trajectories when written
+	// Critic values are never inferred, so they are always written as zero
+	struct SimRollout {
+		int numPlayers = 0, obsSize = 0;
+
+		// Amount of steps currently stored
+		size_t size = 0;
+
+		// [size + 1][numPlayers][obsSize]
+		// Row N is the observation that the action of step N was taken in
+		// Row (size) is always the current observation, which has not been acted on yet
+		FList states;
+
+		// [size][numPlayers]
+		FList actions, logProbs, rewards, dones, policyVersions;
+
+#ifdef RG_PARANOID_MODE
+		int64_t debugCounter = 0;
+#endif
+
+		SimRollout() = default;
+		SimRollout(int numPlayers, int obsSize);
+
+		size_t GetStepSize() const {
+			return (size_t)numPlayers * obsSize;
+		}
+
+		float* GetStates(size_t step) {
+			return states.data() + step * GetStepSize();
+		}
+
+		// Sets the current observations ([numPlayers][obsSize])
+		void SetCurOBS(const float* obs);
+
+		// Adds a step taken in the current observations, nextObs becomes the current observations
+		void AddStep(
+			const float* nextObs, const int64_t* stepActions, const float* stepLogProbs,
+			const float* stepRewards, const float* stepDones, float policyVersion);
+
+		// Clears all steps, keeping the current observations
+		void Clear();
+
+		// Writes the steps of all rollouts as one trajectory, in the same format as RemoteProtocol::WriteTrajectory()
+		// Trajectories of every player are written in order, with their last step marked as truncated if it is not done
+		// All rollouts are cleared afterward
+		static void WriteTrajectory(DataStreamOut& out, const std::vector<SimRollout*>& rollouts);
+	};
+}
@@ -0,0 +1,50 @@
+#include "Spectator.h"
+
+RLGPC::Spectator::Spectator(const std::string& address, int port, uint64_t gameIndex, float fps) :
+	gameIndex(gameIndex), fps(fps) {
+
+	renderSender = new RenderSender(address, port);
+}
+
+void RLGPC::Spectator::Start() {
+	if (_shouldRun)
+		return;
+
+	_shouldRun = true;
+	_thread = std::thread([this] {
+		auto frameTime = std::chrono::microseconds((int64_t)(1000 * 1000 / RS_MAX(fps, 1.f)));
+		auto nextFrameTime = std::chrono::steady_clock::now();
+		RLGSC::GameState sendState = {};
+		while (_shouldRun) {
+			const Frame* frame = mailbox.Take();
+			if (frame) {
+				frame->state.ToGameState(sendState);
+				renderSender->SendWithPads(sendState, frame->pads);
+			}
+
+			// Don't try to catch up on frames we missed, there is always only the newest state to send
+			nextFrameTime = RS_MAX(nextFrameTime + frameTime, std::chrono::steady_clock::now());
+			std::this_thread::sleep_until(nextFrameTime);
+		}
+	});
+}
+
+void RLGPC::Spectator::Stop() {
+	if (!_shouldRun)
+		return;
+
+	_shouldRun = false;
+	_thread.join();
+}
+
+void RLGPC::Spectator::Publish(const RLGSC::GameState& state) {
+	if (mailbox.HasNew() || _publishing.exchange(true, std::memory_order_acquire))
+		return;
+
+	Frame& frame = mailbox.GetWriteSlot();
+	RenderSender::GetPads(state, frame.pads);
+	frame.state.FromGameState(state);
+	mailbox.Publish();
+
+	_publishing.store(false, std::memory_order_release);
+}
\ No newline at end of file
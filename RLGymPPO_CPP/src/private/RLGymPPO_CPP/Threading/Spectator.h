@@ -0,0 +1,48 @@
+#pragma once
+#include "../Util/TripleBuffer.h"
+#include <RLGymPPO_CPP/Util/RenderSender.h>
+#include <RLGymSim_CPP/Utils/Gamestates/StateSnapshot.h>
+
+namespace RLGPC {
+	// Renders one game of a learner while it trains (see LearnerConfig::spectate)
+	// The game's agent publishes its state into a lock-free mailbox after it steps, if we took the last one
+	// So the agent only copies the state about once per frame we send, and never waits on rendering
+	// Our own thread takes the state at our frame rate and sends it
+	// NOTE: Games run as fast as training does, so the game is shown sped up, and only one step per frame is seen
+	class Spectator {
+	public:
+		// Index of the game to render across all agents, can be changed at any time
+		std::atomic<uint64_t> gameIndex;
+		float fps;
+
+		RenderSender* renderSender;
+
+		struct Frame {
+			RLGSC::StateSnapshot<> state;
+			std::vector<RenderSender::Pad> pads;
+		};
+		TripleBuffer<Frame> mailbox = {};
+
+		Spectator(const std::string& address, int port, uint64_t gameIndex, float fps);
+		RG_NO_COPY(Spectator);
+
+		void Start();
+		void Stop();
+
+		// Called by the agent with our game after it steps, does nothing if we haven't taken the last state yet
+		// The state is copied as a snapshot, as its arena keeps stepping while we send
+		void Publish(const RLGSC::GameState& state);
+
+		~Spectator() {
+			Stop();
+			delete renderSender;
+		}
+
+		// If gameIndex changes, the old and new game's agents could both be publishing for a moment
+		// The mailbox only has one writer, so whichever is late skips its step
+		std::atomic<bool> _publishing = false;
+
+		std::thread _thread;
+		std::atomic<bool> _shouldRun = false;
+	};
+}
\ No newline at end of file
@@ -1,163 +1,686 @@
 #include "ThreadAgent.h"
 
 #include "ThreadAgentManager.h"
+#include "CollectionWorkerPool.h"
 #include <RLGymPPO_CPP/Util/Timer.h>
+#include <RLGymPPO_CPP/Util/CPUAffinity.h>
+#include <RLGymPPO_CPP/Util/TraceRecorder.h>
+#include <RLGymPPO_CPP/Util/SamplingProfiler.h>
+#include <RLGymSim_CPP/Utils/AllocTracker/AllocTracker.h>
 
 using namespace RLGPC;
 
-torch::Tensor MakeGamesOBSTensor(std::vector<GameInst*>& games) {
-	// TODO: Use of torch::concat is likely slow
+// Returns the part of our readback buffer that the results for obs, starting at playerStart, should be copied into
+// Undefined if we have no readback buffer
+torch::Tensor _GetResultReadback(ThreadAgent* ta, torch::Tensor obs, int playerStart) {
+	if (!ta->resultReadback.defined())
+		return {};
 
-	assert(!games.empty());
-	std::vector<torch::Tensor> obsTensors = {};
-	for (auto game : games)
-		obsTensors.push_back(FLIST2_TO_TENSOR(game->curObs));
+	uint8_t& slot = ta->resultReadbackSlots[playerStart];
+	slot = !slot;
+	// Each player range gets a contiguous block, so the copy into it is a single transfer
+	int64_t numPlayers = obs.size(0);
+	return ta->resultReadback[slot].slice(0, playerStart * 2, (playerStart + numPlayers) * 2).view({ 2, numPlayers });
+}
 
-	try {
-		return torch::concat(obsTensors);
-	} catch (std::exception& e) {
-		RG_ERR_CLOSE("Failed to concat OBS tensors: " << e.what());
-		return {};
+// Infers the policy to get actions for the given observations, which start at playerStart
+DiscretePolicy::ActionResult _InferPolicyActions(ThreadAgent* ta, torch::Tensor obs, int playerStart) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+
+	// The server batches our observations with those of other agents
+	if (mgr->inferServer)
+		return mgr->inferServer->Infer(obs);
+
+	// Use the half-precision policy if we have one
+	// Its inputs are converted automatically, and its outputs are full precision
+	auto policy = (mgr->policyHalf ? mgr->policyHalf : mgr->policy);
+	if (ta->policy)
+		policy = ta->policy;
+
+	if (mgr->useNativeInference) {
+		auto nativePolicy = mgr->GetNativePolicy();
+		if (nativePolicy)
+			return nativePolicy->GetAction(obs, mgr->deterministic, ta->nativeRNG);
+	}
+
+	// Agents with their own policy infer it normally
+	if (mgr->useScriptedInference && !ta->policy) {
+		auto scriptedPolicy = mgr->scriptedPolicy.load();
+		if (scriptedPolicy)
+			return scriptedPolicy->GetAction(obs, mgr->deterministic, _GetResultReadback(ta, obs, playerStart));
+	}
+
+	// Infer the front policy buffer, and hold it until we are done so it isn't written to
+	int bufferIndex = ta->policy ? -1 : mgr->AcquirePolicyBuffer();
+	if (bufferIndex >= 0) {
+		policy = mgr->policyBuffers[bufferIndex].policy;
+
+		DiscretePolicy::ActionResult result;
+		if (mgr->useCUDAGraphs) {
+			auto& graph = ta->bufferPolicyGraphs[bufferIndex];
+			if (!graph)
+				graph = new PolicyGraph(policy, mgr->deterministic);
+			result = graph->GetAction(obs, _GetResultReadback(ta, obs, playerStart));
+		} else {
+			result = policy->GetAction(obs.to(policy->device, true), mgr->deterministic, _GetResultReadback(ta, obs, playerStart));
+		}
+
+		// Results are on the CPU, so the buffer is no longer being read
+		mgr->ReleasePolicyBuffer(bufferIndex);
+		return result;
+	}
+
+	if (mgr->useCUDAGraphs) {
+		// Created here so that it belongs to the thread that infers
+		if (!ta->policyGraph)
+			ta->policyGraph = new PolicyGraph(policy, mgr->deterministic);
+
+		return ta->policyGraph->GetAction(obs, _GetResultReadback(ta, obs, playerStart));
 	}
+
+	// Move our OBS tensor to the device we run the policy on
+	torch::Tensor obsDevice = obs.to(policy->device, true);
+
+	auto actionResults = policy->GetAction(obsDevice, mgr->deterministic, _GetResultReadback(ta, obs, playerStart));
+	return actionResults;
 }
 
-void _RunFunc(ThreadAgent* ta) {
-	RG_NOGRAD;
-	ta->isRunning = true;
+// Replaces the actions of players controlled by opponents from the manager's pool
+// Observations start at playerStart, which must be the first player of a game
+// Each opponent infers all of its players in one batch
+void _InferOpponents(ThreadAgent* ta, torch::Tensor obs, int playerStart, DiscretePolicy::ActionResult& result) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	if (!mgr->opponentPool)
+		return;
+
+	auto& games = ta->games;
+	int playerEnd = playerStart + obs.size(0);
+
+	// Rows of obs that each opponent controls
+	std::vector<std::pair<const OpponentPool::Member*, std::vector<int64_t>>> groups = {};
+	for (int i = 0; i < games.Size(); i++) {
+		auto opponent = ta->gameOpponents[i].get();
+		int gamePlayerStart = games.playerStart[i];
+		if (!opponent || gamePlayerStart < playerStart || gamePlayerStart >= playerEnd)
+			continue;
+
+		auto group = std::find_if(groups.begin(), groups.end(), [&](auto& pair) { return pair.first == opponent; });
+		if (group == groups.end()) {
+			groups.push_back({ opponent, {} });
+			group = groups.end() - 1;
+		}
+
+		for (int j = gamePlayerStart; j < games.playerStart[i + 1]; j++)
+			if (!ta->learnerPlayers[j])
+				group->second.push_back(j - playerStart);
+	}
 
+	if (groups.empty())
+		return;
+
+	Timer inferTimer = {};
+
+	// Always copies, as the actions may be on the device or be the policy's own output
+	result.action = result.action.to(torch::kCPU, torch::kInt64, false, true);
+	for (auto& [opponent, rows] : groups) {
+		auto rowsTensor = torch::from_blob(rows.data(), { (int64_t)rows.size() }, torch::kInt64);
+		auto opponentObs = obs.index_select(0, rowsTensor).to(opponent->policy->device, true);
+		auto opponentActions = opponent->policy->GetAction(opponentObs, mgr->deterministic).action;
+		result.action.index_copy_(0, rowsTensor, opponentActions.cpu().to(torch::kInt64));
+	}
+
+	ta->times.opponentInferTime += inferTimer.Elapsed();
+}
+
+// Replaces the actions and log probs of players controlled by the manager's extra policies
+// Observations start at playerStart
+// Each policy infers all of its players in one batch
+void _InferExtraPolicies(ThreadAgent* ta, torch::Tensor obs, int playerStart, DiscretePolicy::ActionResult& result) {
 	auto mgr = (ThreadAgentManager*)ta->_manager;
-	auto& games = ta->gameInsts;
-	int numGames = ta->numGames;
+	if (mgr->extraPolicies.empty())
+		return;
+
+	// Rows of obs that each extra policy controls
+	std::vector<std::vector<int64_t>> groups = std::vector<std::vector<int64_t>>(mgr->extraPolicies.size());
+	for (int64_t i = 0; i < obs.size(0); i++) {
+		int policyID = ta->playerPolicyIDs[playerStart + i];
+		if (policyID > 0)
+			groups[policyID - 1].push_back(i);
+	}
 
-	auto device = mgr->device;
+	// Always copies, as the results may be on the device or be the policy's own output
+	result.action = result.action.to(torch::kCPU, torch::kInt64, false, true);
+	result.logProb = result.logProb.to(torch::kCPU, torch::kFloat, false, true);
+	for (int i = 0; i < groups.size(); i++) {
+		auto& rows = groups[i];
+		if (rows.empty())
+			continue;
+
+		auto policy = mgr->extraPolicies[i];
+		auto rowsTensor = torch::from_blob(rows.data(), { (int64_t)rows.size() }, torch::kInt64);
+		auto policyObs = obs.index_select(0, rowsTensor).to(policy->device, true);
+		auto policyResult = policy->GetAction(policyObs, mgr->deterministic);
+		result.action.index_copy_(0, rowsTensor, policyResult.action.cpu().to(torch::kInt64));
+		result.logProb.index_copy_(0, rowsTensor, policyResult.logProb.cpu().to(torch::kFloat));
+	}
+}
 
-	bool render = mgr->renderSender;
-	bool deterministic = mgr->deterministic;
+// Infers the policy, and also the critic if the manager has a value net
+// Observations start at playerStart, which must be the first player of a game
+// NOTE: The learning policy infers all players, including those that are then replaced by opponents or extra policies
+//	This keeps its batches the same size, which CUDA graphs and the inference server rely on
+DiscretePolicy::ActionResult _InferPolicy(ThreadAgent* ta, torch::Tensor obs, int playerStart) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
 
-	Timer stepTimer = {};
+	// The inference server times its own device work
+	RG_TRACE_SCOPE("Infer", mgr->inferServer ? torch::Device(torch::kCPU) : mgr->device);
+	RG_ALLOC_SCOPE(INFERENCE);
 
-	// Start games
-	for (auto game : games)
-		game->Start();
+	auto result = _InferPolicyActions(ta, obs, playerStart);
+	_InferOpponents(ta, obs, playerStart, result);
+	_InferExtraPolicies(ta, obs, playerStart, result);
 
-	// Will stores our current observations for all our games
-	torch::Tensor curObsTensor = MakeGamesOBSTensor(games);
+	// The inference server infers values in the same batch
+	auto valueNet = ta->valueNet ? ta->valueNet : mgr->valueNet;
+	if (valueNet && !result.value.defined())
+		result.value = valueNet->Forward(obs.to(valueNet->device, true)).cpu().flatten();
 
-#if 0 // TODO: Potential cause of learning errors
-	bool halfPrec = mgr->policyHalf != NULL;
-#else
-	constexpr bool halfPrec = false;
-#endif
+	return result;
+}
 
-	auto policy = (halfPrec ? mgr->policyHalf : mgr->policy);
+// Updates the ball predictions of games [gameStart, gameEnd), if we predict the ball
+void _UpdateBallPred(ThreadAgent* ta, int gameStart, int gameEnd) {
+	if (!ta->ballPred)
+		return;
 
-	while (ta->shouldRun) {
+	ta->ballPred->Update(ta->_ballPredArenas.data(), gameStart, gameEnd);
+	for (int i = gameStart; i < gameEnd; i++)
+		ta->games.games[i]->ballPred = ta->ballPred->GetPred(i);
+}
 
-		if (render)
-			stepTimer.Reset();
+// Picks whether the orange team of a game is played by a member of the manager's pool, and which one
+// Only done when a game starts an episode, so that the steps of each player stay continuous (see RolloutStorage::learned)
+void _AssignOpponent(ThreadAgent* ta, int gameIndex) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	auto pool = mgr->opponentPool;
+	auto& games = ta->games;
+	auto& players = games.games[gameIndex]->gym->prevState.players;
+	int playerStart = games.playerStart[gameIndex];
+
+	bool hasOrange = false;
+	for (auto& player : players)
+		hasOrange |= (player.team == Team::ORANGE);
+
+	auto& opponent = ta->gameOpponents[gameIndex];
+	opponent = NULL;
+	if (hasOrange && std::uniform_real_distribution<float>(0, 1)(ta->opponentRNG) < pool->opponentProb)
+		opponent = pool->Sample(ta->opponentRNG);
+
+	for (int i = 0; i < players.size(); i++)
+		ta->learnerPlayers[playerStart + i] = !opponent || (players[i].team != Team::ORANGE);
+}
 
-		// Don't run if we reached our step limit
-		while (ta->stepsCollected > ta->maxCollect)
-			std::this_thread::yield();
+// Steps games [gameStart, gameEnd) with the actions of their players
+// Actions start at the first player of gameStart, rewards and dones are written for all players of the agent
+void _StepGames(ThreadAgent* ta, int gameStart, int gameEnd, torch::Tensor actions, FList& stepRewards, FList& stepDones) {
+	RG_TRACE_SCOPE("Env Step");
+	auto& games = ta->games;
 
-		while (mgr->disableCollection)
-			std::this_thread::yield();
+	// Make sure there is an action for every player of these games
+	// Otherwise there's a wrong number of actions for whatever reason
+	assert(actions.size(0) == games.playerStart[gameEnd] - games.playerStart[gameStart]);
 
-		// Move our current OBS tensor to the device we run the policy on
-		// This conversion time is not counted as a part of policy inference time
-		torch::Tensor curObsTensorDevice;
-		if (halfPrec) {
-			curObsTensorDevice = curObsTensor.to(RG_HALFPERC_TYPE).to(device, true);
-		} else {
-			curObsTensorDevice = curObsTensor.to(device, true);
+	// Does nothing if they are already CPU int64, which they are unless inferred on the GPU
+	actions = actions.cpu().to(torch::kInt64).contiguous();
+
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	if (mgr->opponentPool) {
+		// These are the assignments the actions were inferred with
+		int playerStart = games.playerStart[gameStart], playerEnd = games.playerStart[gameEnd];
+		std::copy(ta->learnerPlayers.begin() + playerStart, ta->learnerPlayers.begin() + playerEnd, ta->stepLearnerPlayers.begin() + playerStart);
+	}
+
+	ta->gameStepMutex.lock();
+	games.Step(gameStart, gameEnd, actions.data_ptr<int64_t>(), stepRewards.data(), stepDones.data());
+	_UpdateBallPred(ta, gameStart, gameEnd);
+	ta->gameStepMutex.unlock();
+
+	if (mgr->spectator) {
+		uint64_t spectateIndex = mgr->spectator->gameIndex;
+		if (spectateIndex >= ta->firstGameIndex + gameStart && spectateIndex < ta->firstGameIndex + gameEnd)
+			mgr->spectator->Publish(games.games[spectateIndex - ta->firstGameIndex]->gym->prevState);
+	}
+
+	// Games that are done have already reset, and start their next episode with new opponents
+	if (mgr->opponentPool)
+		for (int i = gameStart; i < gameEnd; i++)
+			if (stepDones[games.playerStart[i]])
+				_AssignOpponent(ta, i);
+}
+
+// Runs policy inference on a second thread, so that it can overlap with env stepping
+class _AsyncInferer {
+public:
+	ThreadAgent* ta;
+	std::thread thread;
+	std::mutex mutex = {};
+	std::condition_variable cv = {};
+
+	torch::Tensor input;
+	int inputPlayerStart = 0;
+	DiscretePolicy::ActionResult result;
+	double inferTime = 0;
+	bool hasJob = false, hasResult = false, shouldRun = true;
+
+	_AsyncInferer(ThreadAgent* ta) : ta(ta) {
+		thread = std::thread([this] {
+			RG_NOGRAD;
+			torch::set_num_threads(1); // Threads don't inherit the learner's count (see LearnerConfig::learnThreads)
+			TraceRecorder::SetThreadName("Agent " + std::to_string(this->ta->firstGameIndex / this->ta->games.Size()) + " Infer");
+			SamplingProfiler::SetThreadRole("Agent Infer");
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true) {
+				cv.wait(lock, [this] { return hasJob || !shouldRun; });
+				if (!shouldRun)
+					break;
+
+				torch::Tensor jobInput = input;
+				int jobPlayerStart = inputPlayerStart;
+				lock.unlock();
+				Timer inferTimer = {};
+				auto jobResult = _InferPolicy(this->ta, jobInput, jobPlayerStart);
+				double jobTime = inferTimer.Elapsed();
+				lock.lock();
+
+				result = jobResult;
+				inferTime = jobTime;
+				hasJob = false;
+				hasResult = true;
+				cv.notify_all();
+			}
+		});
+	}
+
+	RG_NO_COPY(_AsyncInferer);
+
+	void Submit(torch::Tensor obs, int playerStart) {
+		std::lock_guard<std::mutex> lock(mutex);
+		assert(!hasJob && !hasResult);
+		input = obs;
+		inputPlayerStart = playerStart;
+		hasJob = true;
+		cv.notify_all();
+	}
+
+	// True if the submitted job is done, so Wait() won't block
+	bool IsDone() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return hasResult;
+	}
+
+	DiscretePolicy::ActionResult Wait(double& outInferTime) {
+		RG_TRACE_SCOPE("Infer Wait");
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [this] { return hasResult; });
+		hasResult = false;
+		outInferTime = inferTime;
+		return result;
+	}
+
+	~_AsyncInferer() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			shouldRun = false;
 		}
+		cv.notify_all();
+		thread.join();
+	}
+};
 
-		// Infer the policy to get actions for all our agents in all our games
-		Timer policyInferTimer = {};
-		
-		auto actionResults = policy->GetAction(curObsTensorDevice, deterministic);
-		if (halfPrec) {
-			actionResults.action = actionResults.action.to(torch::ScalarType::Float);
-			actionResults.logProb = actionResults.logProb.to(torch::ScalarType::Float);
+// Copies the step we just added to our rollout into the segments of our recorded games
+// Full segments are handed to the recorder, which writes them on its own thread
+// NOTE: trajMutex must be locked
+void _RecordStep(ThreadAgent* ta) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	auto recorder = mgr->rolloutRecorder;
+	auto& games = ta->games;
+	auto& rollout = ta->rollout;
+	int obsSize = rollout.obsSize;
+
+	auto fnStartSegment = [&](RolloutRecorder::Segment& segment, uint64_t gameIndex, int playerAmount, uint64_t firstStep) {
+		segment = {};
+		segment.gameIndex = gameIndex;
+		segment.firstStep = firstStep;
+		segment.playerAmount = playerAmount;
+		segment.obsSize = obsSize;
+
+		size_t rows = (size_t)recorder->segmentSteps * playerAmount;
+		segment.obs.reserve(rows * obsSize);
+		segment.actions.reserve(rows);
+		segment.rewards.reserve(rows);
+		segment.dones.reserve(rows);
+	};
+
+	// Games that aren't recorded have no players in their segment
+	if (ta->recordSegments.empty()) {
+		ta->recordSegments.resize(games.Size());
+		for (int i = 0; i < games.Size(); i++) {
+			uint64_t gameIndex = ta->firstGameIndex + i;
+			if (recorder->ShouldRecordGame(gameIndex))
+				fnStartSegment(ta->recordSegments[i], gameIndex, games.playerStart[i + 1] - games.playerStart[i], 0);
 		}
+	}
 
-		float policyInferTime = policyInferTimer.Elapsed();
-		ta->times.policyInferTime += policyInferTime;
+	size_t step = rollout.size - 1;
+	const float* stepObs = rollout.GetStates(step);
+	size_t stepRow = step * rollout.numPlayers;
+
+	for (int i = 0; i < games.Size(); i++) {
+		auto& segment = ta->recordSegments[i];
+		if (segment.playerAmount == 0)
+			continue;
+
+		int playerStart = games.playerStart[i];
+		int playerEnd = playerStart + segment.playerAmount;
+		segment.obs.insert(segment.obs.end(), stepObs + (size_t)playerStart * obsSize, stepObs + (size_t)playerEnd * obsSize);
+		for (int j = playerStart; j < playerEnd; j++) {
+			segment.actions.push_back((int32_t)rollout.actions[stepRow + j]);
+			segment.rewards.push_back(rollout.rewards[stepRow + j]);
+			segment.dones.push_back(rollout.dones[stepRow + j] != 0);
+		}
+		segment.stepAmount++;
+
+		if (recorder->stateInterval > 0 && segment.stepAmount % recorder->stateInterval == 0) {
+			Arena* arena = games.games[i]->gym->arena;
+			segment.carAmount = arena->_cars.size();
+
+			auto fnAppend = [&](const void* data, size_t size) {
+				segment.states.insert(segment.states.end(), (const byte*)data, (const byte*)data + size);
+			};
+
+			uint32_t stateStep = segment.stepAmount - 1;
+			fnAppend(&stateStep, sizeof(stateStep));
+			BallState ballState = arena->ball->GetState();
+			fnAppend(&ballState, sizeof(ballState));
+			for (Car* car : arena->_cars) {
+				CarState carState = car->GetState();
+				fnAppend(&carState, sizeof(carState));
+			}
+			segment.stateAmount++;
+		}
 
-		// Step the gym with the actions we got
-		Timer gymStepTimer = {};
-		ta->gameStepMutex.lock();
-		float avgRew = 0;
-		auto stepResults = new RLGSC::Gym::StepResult[numGames];
-		int actionsOffset = 0;
-		for (int i = 0; i < numGames; i++) {
-			auto game = games[i];
-			int numPlayers = game->match->playerAmount;
+		if (segment.stepAmount >= recorder->segmentSteps) {
+			RolloutRecorder::Segment nextSegment;
+			fnStartSegment(nextSegment, segment.gameIndex, segment.playerAmount, segment.firstStep + segment.stepAmount);
+			recorder->Submit(std::move(segment));
+			segment = std::move(nextSegment);
+		}
+	}
+}
+
+// Adds the observations of the step we just added to our rollout to our stats, every mgr->stepsPerObsStatsInc steps
+// Our stats are pushed to the manager's queue every few increments, so the learner never has to stop us to read them
+// NOTE: trajMutex must be locked
+void _IncrementOBSStats(ThreadAgent* ta) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	auto& rollout = ta->rollout;
+
+	ta->obsStatsStepCounter++;
+	if (ta->obsStatsStepCounter < mgr->stepsPerObsStatsInc)
+		return;
+	ta->obsStatsStepCounter = 0;
+
+	if (ta->obsStats.shape != rollout.obsSize)
+		ta->obsStats = WelfordRunningStat(rollout.obsSize);
+
+	// All of the step's players at once
+	ta->obsStats.IncrementBatch(rollout.GetStates(rollout.size - 1), rollout.numPlayers);
+
+	ta->obsStatsIncrements++;
+	if (ta->obsStatsIncrements >= ThreadAgent::OBS_STATS_INCS_PER_PUSH) {
+		mgr->obsStatsQueue.Push(std::move(ta->obsStats));
+		ta->obsStats = WelfordRunningStat(rollout.obsSize);
+		ta->obsStatsIncrements = 0;
+	}
+}
+
+// Returns which players of the next step to add to our rollout are learned, NULL if all of them
+const uint8_t* _GetStepLearned(ThreadAgent* ta) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	return mgr->opponentPool ? ta->stepLearnerPlayers.data() : NULL;
+}
 
-			// Actions output has a dimension for each player, but not for each game
-			// So we will need to slice the section of it that is for this game
-			auto actionSlice = actionResults.action.slice(0, actionsOffset, actionsOffset + numPlayers);
+// Counts the step we just added to our rollout, handing off a segment if we have one
+// learnedAmount is the amount of the step's players that are learned
+// NOTE: trajMutex must be locked
+void _OnStepAdded(ThreadAgent* ta, int learnedAmount) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+
+	if (mgr->rolloutRecorder)
+		_RecordStep(ta);
 
-			stepResults[i] = game->Step(TENSOR_TO_ILIST(actionSlice));
+	if (mgr->standardizeOBS)
+		_IncrementOBSStats(ta);
 
-			actionsOffset += numPlayers;
+	ta->times.steps += learnedAmount;
+	if (mgr->segmentSteps > 0) {
+		if (ta->rollout.size >= mgr->segmentSteps) {
+			GameTrajectory segment = ta->rollout.Collect();
+			uint64_t segmentSize = segment.size;
+			if (segmentSize > 0) {
+				mgr->segmentQueue.Push(std::move(segment));
+				mgr->AddCollectedSteps(segmentSize);
+			}
 		}
-		ta->gameStepMutex.unlock();
+	} else {
+		ta->stepsCollected += learnedAmount;
+		mgr->AddCollectedSteps(learnedAmount);
+	}
+}
+
+// Makes the next start state of our games that reset ahead, until the inferer is done (see Gym::PrepareReset())
+// Games that end before theirs is made just make it when they reset
+void _PrepareResets(ThreadAgent* ta, _AsyncInferer& inferer) {
+	RG_TRACE_SCOPE("Prepare Resets");
+	for (auto game : ta->games.games) {
+		if (inferer.IsDone())
+			break;
+		game->gym->PrepareReset();
+	}
+}
+
+// Pipelined version of _RunFunc()
+// Our games are split into two halves, and each half is stepped while the policy infers the other half
+void _RunFuncPipelined(ThreadAgent* ta) {
+	RG_NOGRAD;
+
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	auto& games = ta->games;
+	int numGames = games.Size();
+	int totalPlayers = games.totalPlayers;
+
+	// Split games and players into halves
+	int gamesA = numGames / 2;
+	int playersA = games.playerStart[gamesA];
+	int playersB = totalPlayers - playersA;
+
+	torch::Tensor obsA = ta->obsBuffer.slice(0, 0, playersA);
+	torch::Tensor obsB = ta->obsBuffer.slice(0, playersA, totalPlayers);
+
+	FList stepRewards = FList(totalPlayers), stepDones = FList(totalPlayers);
+
+	_AsyncInferer inferer = _AsyncInferer(ta);
+
+	double inferTime;
+	Timer inferWaitTimer = {};
 
-		// Make sure we got the end of actions
-		// Otherwise there's a wrong number of actions for whatever reason
-		assert(actionsOffset == actionResults.action.size(0));
-		float envStepTime = gymStepTimer.Elapsed();
-		ta->times.envStepTime += envStepTime;
+	// Version of the policy when each half was submitted
+	uint64_t versionA, versionB;
 
-		// Update our tensor storing the next observation after the step, from each gym
-		torch::Tensor nextObsTensor = MakeGamesOBSTensor(games);
+	// Get the first actions of half A
+	versionA = mgr->policyVersion;
+	inferer.Submit(obsA, 0);
+	auto actionsA = inferer.Wait(inferTime);
+	ta->times.policyInferTime += inferTime;
 
-		if (!render) {
-			// Steps complete, add all timestep data to our trajectories, for each game
-			Timer trajAppendTimer = {};
+	while (ta->shouldRun) {
+
+		// Don't run if collection is disabled or we reached the step limit
+		// This limit is shared by all agents, so agents with faster games are not held back by slower ones
+		mgr->WaitUntilCanCollect(ta);
+		if (!ta->shouldRun)
+			break;
+
+		// Infer half B while stepping half A
+		versionB = mgr->policyVersion;
+		inferer.Submit(obsB, playersA);
+		Timer gymStepTimer = {};
+		_StepGames(ta, 0, gamesA, actionsA.action, stepRewards, stepDones);
+		ta->times.envStepTime += gymStepTimer.Elapsed();
+
+		if (mgr->resetAhead)
+			_PrepareResets(ta, inferer);
+
+		inferWaitTimer.Reset();
+		auto actionsB = inferer.Wait(inferTime);
+		ta->times.policyInferTime += inferTime;
+		ta->times.inferOverlapTime += RS_MAX(inferTime - inferWaitTimer.Elapsed(), 0);
+
+		// Infer half A's next observations while stepping half B
+		uint64_t nextVersionA = mgr->policyVersion;
+		inferer.Submit(obsA, 0);
+		gymStepTimer.Reset();
+		_StepGames(ta, gamesA, numGames, actionsB.action, stepRewards, stepDones);
+		ta->times.envStepTime += gymStepTimer.Elapsed();
+
+		// Both halves have now stepped, add the full step to our rollout storage
+		Timer trajAppendTimer = {};
+		{
+			RG_TRACE_SCOPE("Traj Append");
+			RG_ALLOC_SCOPE(TRAJECTORY);
 			ta->trajMutex.lock();
-			for (int i = 0, playerOffset = 0; i < numGames; i++) {
-				int numPlayers = games[i]->match->playerAmount;
-
-				auto& stepResult = stepResults[i];
-
-				float done = (float)stepResult.done;
-				float truncated = (float)false;
-
-				auto tDone = torch::tensor(done);
-				auto tTruncated = torch::tensor(truncated);
-
-				for (int j = 0; j < numPlayers; j++) {
-					ta->trajectories[i][j].AppendSingleStep(
-						{
-							curObsTensor[playerOffset + j],
-							actionResults.action[playerOffset + j],
-							actionResults.logProb[playerOffset + j],
-							torch::tensor(stepResult.reward[j]),
-
-#ifdef RG_PARANOID_MODE
-							torch::Tensor(),
-#endif
-
-							nextObsTensor[playerOffset + j],
-							tDone,
-							tTruncated
-						}
-					);
-				}
-
-				ta->stepsCollected += numPlayers;
-				playerOffset += numPlayers;
-			}
+			int learnedAmount = ta->rollout.AddStep(
+				ta->obsBuffer.data_ptr<float>(), stepRewards.data(), stepDones.data(),
+				torch::cat({ actionsA.action, actionsB.action }), torch::cat({ actionsA.logProb, actionsB.logProb }),
+				(ta->valueNet || mgr->valueNet) ? torch::cat({ actionsA.value, actionsB.value }) : torch::Tensor(),
+				(float)RS_MIN(versionA, versionB), _GetStepLearned(ta)
+			);
+			_OnStepAdded(ta, learnedAmount);
 			ta->trajMutex.unlock();
-			ta->times.trajAppendTime += trajAppendTimer.Elapsed();
-		} else {
-			// Update renderer
-			auto renderSender = mgr->renderSender;
-			auto renderGame = games[0];
-			renderSender->Send(renderGame->gym->prevState, RLGSC::ActionSet());
+		}
+		ta->times.trajAppendTime += trajAppendTimer.Elapsed();
+
+		if (mgr->resetAhead)
+			_PrepareResets(ta, inferer);
+
+		inferWaitTimer.Reset();
+		actionsA = inferer.Wait(inferTime);
+		versionA = nextVersionA;
+		ta->times.policyInferTime += inferTime;
+		ta->times.inferOverlapTime += RS_MAX(inferTime - inferWaitTimer.Elapsed(), 0);
+	}
+}
+
+// Starts our games, and copies their first observations into our rollout
+void _StartGames(ThreadAgent* ta) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	auto& games = ta->games;
+	int numGames = games.Size();
+
+	games.Start();
+	_UpdateBallPred(ta, 0, numGames);
+	if (mgr->opponentPool)
+		for (int i = 0; i < numGames; i++)
+			_AssignOpponent(ta, i);
+
+	ta->trajMutex.lock();
+	memcpy(ta->rollout.GetStates(ta->rollout.size), ta->obsBuffer.data_ptr<float>(), ta->rollout.GetStepSize() * sizeof(float));
+	ta->trajMutex.unlock();
+}
+
+// Infers the policy for all our agents in all our games, steps the games with the actions we got, and adds the step to our rollout
+// If rendering, the step isn't added, and the first game is sent to the renderer instead
+void _CollectStep(ThreadAgent* ta, bool render) {
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	auto& games = ta->games;
+
+	// Our games write their observations directly into this buffer
+	// Stores the current observations for all our games, and becomes the next observations once the games step
+	torch::Tensor curObsTensor = ta->obsBuffer;
+
+	// Infer the policy to get actions for all our agents in all our games
+	uint64_t policyVersion = mgr->policyVersion;
+	Timer policyInferTimer = {};
+	auto actionResults = _InferPolicy(ta, curObsTensor, 0);
+	float policyInferTime = policyInferTimer.Elapsed();
+	ta->times.policyInferTime += policyInferTime;
+
+	// Step the gym with the actions we got
+	Timer gymStepTimer = {};
+	_StepGames(ta, 0, games.Size(), actionResults.action, ta->stepRewards, ta->stepDones);
+	float envStepTime = gymStepTimer.Elapsed();
+	ta->times.envStepTime += envStepTime;
+
+	if (!render) {
+		// Steps complete, add all timestep data to our rollout storage
+		Timer trajAppendTimer = {};
+		RG_TRACE_SCOPE("Traj Append");
+		RG_ALLOC_SCOPE(TRAJECTORY);
+		ta->trajMutex.lock();
+		int learnedAmount = ta->rollout.AddStep(
+			curObsTensor.data_ptr<float>(), ta->stepRewards.data(), ta->stepDones.data(),
+			actionResults.action, actionResults.logProb, actionResults.value, (float)policyVersion,
+			_GetStepLearned(ta)
+		);
+		_OnStepAdded(ta, learnedAmount);
+		ta->trajMutex.unlock();
+		ta->times.trajAppendTime += trajAppendTimer.Elapsed();
+	} else {
+		// Update renderer
+		auto renderSender = mgr->renderSender;
+		auto renderGame = games.games[0];
+		renderSender->Send(renderGame->gym->prevState, RLGSC::ActionSet());
+	}
+}
+
+void _RunFunc(ThreadAgent* ta) {
+	RG_NOGRAD;
+
+	auto mgr = (ThreadAgentManager*)ta->_manager;
+	auto& games = ta->games;
+	int numGames = games.Size();
+
+	bool render = mgr->renderSender;
+
+	Timer stepTimer = {};
+
+	TraceRecorder::SetThreadName("Agent " + std::to_string(ta->firstGameIndex / numGames));
+	SamplingProfiler::SetThreadRole("Agent");
+	torch::set_num_threads(1); // Threads don't inherit the learner's count (see LearnerConfig::learnThreads)
+
+	_StartGames(ta);
+
+	if (mgr->pipelinedCollection && !render && numGames >= 2) {
+		_RunFuncPipelined(ta);
+		ta->isRunning = false;
+		ta->isRunning.notify_all();
+		return;
+	}
+
+	while (ta->shouldRun) {
+
+		if (render)
+			stepTimer.Reset();
+
+		// Don't run if collection is disabled or we reached the step limit
+		// This limit is shared by all agents, so agents with faster games are not held back by slower ones
+		mgr->WaitUntilCanCollect(ta);
+		if (!ta->shouldRun)
+			break;
 
+		_CollectStep(ta, render);
+
+		if (render) {
 			// Delay for render
 			// TODO: Somewhat dumb system using static variables
 			{
@@ -169,45 +692,155 @@ void _RunFunc(ThreadAgent* ta) {
 				int64_t micsSince = chr::duration_cast<chr::microseconds>(durationSince).count();
 
 				double timeTaken = stepTimer.Elapsed();
-				double targetTime = (1 / 120.0) * renderGame->gym->tickSkip / mgr->renderTimeScale;
+				double targetTime = games.games[0]->gym->GetStepTime() / mgr->renderTimeScale;
 				double sleepTime = RS_MAX(targetTime - timeTaken, 0);
 				int64_t sleepMics = (int64_t)(sleepTime * 1000.0 * 1000.0);
 
 				std::this_thread::sleep_for(chr::microseconds(sleepMics));
 			}
 		}
+	}
 
-		// Now that the step is done, our next OBS becomes our current
-		curObsTensor = nextObsTensor;
+	ta->isRunning = false;
+	ta->isRunning.notify_all();
+}
 
-		delete[] stepResults;
+// Called by the manager's worker pool, which runs us instead of our own thread
+void RLGPC::ThreadAgent::_WorkerStep() {
+	if (_needsStart) {
+		_StartGames(this);
+		_needsStart = false;
 	}
 
-	ta->isRunning = false;
+	_CollectStep(this, false);
 }
 
-RLGPC::ThreadAgent::ThreadAgent(void* manager, int numGames, uint64_t maxCollect, EnvCreateFn envCreateFn)
-	: _manager(manager), numGames(numGames), maxCollect(maxCollect) {
+RLGPC::ThreadAgent::ThreadAgent(void* manager, int index, int numGames, uint64_t maxCollect, int obsSize, EnvCreateFn envCreateFn, const IList& cores)
+	: _manager(manager), maxCollect(maxCollect), cores(cores) {
+
+	if (cores.empty()) {
+		_Init(index, numGames, obsSize, envCreateFn);
+	} else {
+		// Memory is placed on the NUMA node of the thread that first touches it
+		std::thread initThread = std::thread(
+			[&] {
+				pinned = CPUAffinity::PinCurrentThread(this->cores);
+				_Init(index, numGames, obsSize, envCreateFn);
+			}
+		);
+		initThread.join();
+	}
+}
+
+void RLGPC::ThreadAgent::_Init(int index, int numGames, int obsSize, EnvCreateFn envCreateFn) {
+	auto mgr = (ThreadAgentManager*)_manager;
 
-	trajectories.resize(numGames);
+	firstGameIndex = index * (uint64_t)numGames;
 	for (int i = 0; i < numGames; i++) {
-		auto envCreateResult = envCreateFn();
-		gameInsts.push_back(new GameInst(envCreateResult.gym, envCreateResult.match));
-		trajectories[i].resize(envCreateResult.match->playerAmount);
+		// Our first game tells us how many cars the pools of the rest need room for
+		if (mgr->shareCollisionPools && i == 1 && numGames > 1)
+			collisionPools = std::make_shared<ArenaCollisionPools>(numGames - 1, games.games[0]->gym->arena->_cars.size());
+		ArenaCollisionPools::Scope poolScope = ArenaCollisionPools::Scope(collisionPools);
+
+		EnvCreateResult envCreateResult;
+		if (index == 0 && i == 0 && mgr->firstEnv.gym) {
+			envCreateResult = mgr->firstEnv;
+			mgr->firstEnv = {};
+		} else {
+			envCreateResult = envCreateFn();
+		}
+
+		if (mgr->randomSeed >= 0)
+			envCreateResult.match->randEngine.Seed(((uint64_t)mgr->randomSeed << 32) | (firstGameIndex + i));
+		envCreateResult.gym->resetAhead = mgr->resetAhead;
+		games.Add(new GameInst(envCreateResult.gym, envCreateResult.match));
+	}
+	int totalPlayers = games.totalPlayers;
+	stepRewards = FList(totalPlayers);
+	stepDones = FList(totalPlayers);
+
+	if (mgr->stepHelperThreads > 0) {
+		int agentIndex = firstGameIndex / numGames;
+		stepExecutor = new StepGraphExecutor(mgr->stepHelperThreads,
+			[this, agentIndex](int helperIndex) {
+				if (pinned)
+					CPUAffinity::PinCurrentThread(cores);
+				TraceRecorder::SetThreadName("Agent " + std::to_string(agentIndex) + " Step Helper " + std::to_string(helperIndex));
+				SamplingProfiler::SetThreadRole("Agent Step Helper");
+			}
+		);
+		games.executor = stepExecutor;
+	}
+	games.interleaveArenas = mgr->interleaveArenaSteps;
+
+	if (mgr->ballPredTicks > 0) {
+		ballPred = new BallPredBatch(mgr->ballPredTicks);
+		for (auto game : games.games) {
+			ballPred->Add(game->gym->arena);
+			_ballPredArenas.push_back(game->gym->arena);
+		}
+	}
+
+	// With segments, we never store more than one segment
+	uint64_t rolloutCollect = mgr->segmentSteps > 0 ? (uint64_t)mgr->segmentSteps * totalPlayers : maxCollect;
+	rollout = RolloutStorage(totalPlayers, obsSize, rolloutCollect, mgr->hugePages);
+
+	// Pinned memory allows the non-blocking copy to the GPU to actually be async
+	auto device = mgr->device;
+	obsBuffer = torch::zeros(
+		{ totalPlayers, obsSize },
+		torch::TensorOptions().dtype(torch::kFloat).pinned_memory(device.is_cuda())
+	);
+
+	// Give each game its row range of the buffer
+	games.SetOBSOutput(obsBuffer.data_ptr<float>(), obsSize);
+
+	if (device.is_cuda()) {
+		resultReadback = torch::zeros({ 2, totalPlayers * 2 }, torch::TensorOptions().dtype(torch::kFloat).pinned_memory(true));
+		resultReadbackSlots.resize(totalPlayers);
+	}
+
+	if (mgr->opponentPool) {
+		gameOpponents.resize(numGames);
+		learnerPlayers = stepLearnerPlayers = std::vector<uint8_t>(totalPlayers, 1);
+	}
+
+	if (!mgr->extraPolicies.empty()) {
+		for (int i = 0; i < games.Size(); i++)
+			for (int j = games.playerStart[i]; j < games.playerStart[i + 1]; j++)
+				playerPolicyIDs.push_back(mgr->GetPolicyID(firstGameIndex + i, j - games.playerStart[i]));
+		rollout.playerPolicyIDs = FList(playerPolicyIDs.begin(), playerPolicyIDs.end());
 	}
 }
 
 void RLGPC::ThreadAgent::Start() {
 	this->shouldRun = true;
-	this->thread = std::thread(_RunFunc, this);
+	this->isRunning = true;
+
+	auto mgr = (ThreadAgentManager*)_manager;
+	if (mgr->workerPool) {
+		_needsStart = true;
+		mgr->workerPool->Add(this);
+		return;
+	}
+
+	this->thread = std::thread(
+		[this] {
+			if (pinned)
+				CPUAffinity::PinCurrentThread(cores);
+			_RunFunc(this);
+		}
+	);
 	this->thread.detach();
 }
 
 void RLGPC::ThreadAgent::Stop() {
 	this->shouldRun = false;
 
-	// Wait for thread to stop runing
-	// TODO: Lame solution
-	while (isRunning)
-		RG_SLEEP(1);
+	// Wake us up if we are waiting to collect
+	// If we are run by the manager's worker pool, this also wakes up a worker to take us out of its queue
+	((ThreadAgentManager*)_manager)->NotifyAgents();
+
+	// Wait for thread to stop running
+	isRunning.wait(true);
 }
\ No newline at end of file
@@ -1,7 +1,12 @@
 #pragma once
 #include "../PPO/DiscretePolicy.h"
-#include <RLGymPPO_CPP/Threading/GameInst.h>
-#include "GameTrajectory.h"
+#include "../PPO/ValueEstimator.h"
+#include "../PPO/PolicyGraph.h"
+#include "../PPO/OpponentPool.h"
+#include <RLGymPPO_CPP/Threading/GymBatch.h>
+#include "RolloutStorage.h"
+#include "../Util/RolloutRecorder.h"
+#include <RLGymPPO_CPP/Util/WelfordRunningStat.h>
 
 namespace RLGPC {
 	class ThreadAgent {
@@ -10,48 +15,134 @@ namespace RLGPC {
 		void* _manager;
 		std::thread thread;
 
-		int numGames;
-		std::vector<GameInst*> gameInsts;
+		// All of our games, stepped together
+		GymBatch games = {};
+		// Index of our first game across all agents
+		uint64_t firstGameIndex = 0;
 
-		bool shouldRun = false; // Set from thread
+		std::atomic<bool> shouldRun = false; // Set from thread
 		std::atomic<bool> isRunning = false;
 
 		struct Times {
 			double
 				envStepTime = 0,
 				policyInferTime = 0,
-				trajAppendTime = 0;
+				trajAppendTime = 0,
+				opponentInferTime = 0, // Included in policy inference time
+				inferOverlapTime = 0, // Policy inference time hidden behind env stepping, only in pipelined mode
+				collectLimitWaitTime = 0, // Time spent waiting because the manager's maxCollect was reached, which is the learner holding us back
+				disabledWaitTime = 0, // Time spent waiting while collection was disabled or we were parked
+				steps = 0; // Not a time, steps collected since the metrics were reset, to compare agents
 
 			double* begin() {
 				return &envStepTime;
 			}
 
 			double* end() {
-				return &trajAppendTime + 1;
+				return &steps + 1;
 			}
 		};
-		Times times = {}; // TODO: Convert to use Report instead
+		// On its own cache line, as only our thread writes it
+		alignas(64) Times times = {}; // TODO: Convert to use Report instead
 
-		std::vector<std::vector<GameTrajectory>> trajectories = {};
-		std::atomic<uint64_t> stepsCollected = 0;
-		uint64_t maxCollect;
+		// Shared by the arenas of our games after the first one, only made if the manager has shareCollisionPools
+		// We are the only thread stepping them, which Bullet's pools need
+		std::shared_ptr<ArenaCollisionPools> collisionPools = NULL;
+
+		// Steps our games on helper threads, only made if the manager has stepHelperThreads
+		StepGraphExecutor* stepExecutor = NULL;
+
+		// Ball prediction of our games, only made if the manager has ballPredTicks
+		BallPredBatch* ballPred = NULL;
+		std::vector<Arena*> _ballPredArenas = {};
+
+		// [games.totalPlayers][obsSize], our games write their observations directly into this
+		torch::Tensor obsBuffer;
+		// [games.totalPlayers], the rewards and dones of our players, filled by every step
+		FList stepRewards = {}, stepDones = {};
+
+		// [2][games.totalPlayers * 2], pinned buffers that policy results are copied back into, only made if the manager's device is a GPU
+		// Each inference copies its packed actions and log probs in one transfer (see DiscretePolicy::ReadBackResult())
+		// There are two slots, which each player range alternates between, as the log probs of one inference are still being stored while the next is running (pipelined collection)
+		torch::Tensor resultReadback;
+		// [games.totalPlayers], slot that the next inference starting at each player uses
+		std::vector<uint8_t> resultReadbackSlots = {};
+
+		// If set, we infer these instead of the manager's models (i.e. copies on another GPU)
+		DiscretePolicy* policy = NULL;
+		ValueEstimator* valueNet = NULL;
+
+		// Only used if the manager has useCUDAGraphs, created once we first infer
+		PolicyGraph* policyGraph = NULL;
+		PolicyGraph* bufferPolicyGraphs[2] = {}; // Of each of the manager's policy buffers, as they are separate models
+
+		// Only used for sampling actions with the manager's native policy
+		std::mt19937 nativeRNG = std::mt19937(std::random_device()());
+
+		// Only used if the manager has an opponent pool
+		// Member playing the orange team of each game, NULL if the game is only played by the learning policy
+		// Assigned whenever a game starts an episode
+		std::vector<std::shared_ptr<const OpponentPool::Member>> gameOpponents = {};
+		// [games.totalPlayers], 1 for each player that the learning policy currently controls
+		std::vector<uint8_t> learnerPlayers = {};
+		// [games.totalPlayers], learnerPlayers from when each player's last action was stepped, which is what our rollout stores
+		// Separate, as pipelined collection changes the assignments of one half while the other half's actions are still stepping
+		std::vector<uint8_t> stepLearnerPlayers = {};
+		std::mt19937 opponentRNG = std::mt19937(std::random_device()());
+
+		// [games.totalPlayers], the policy ID of each player (see ThreadAgentManager::GetPolicyID()), only set if the manager has extra policies
+		IList playerPolicyIDs = {};
+
+		RolloutStorage rollout = {};
+		// On its own cache line, as the manager reads it while our thread adds to it
+		alignas(64) std::atomic<uint64_t> stepsCollected = 0;
+		uint64_t maxCollect; // Our expected share of the manager's maxCollect, used for initial rollout capacity
+
+		// Observation stats sampled since we last pushed them to the manager, only used if the manager has standardizeOBS
+		WelfordRunningStat obsStats = {};
+		int obsStatsStepCounter = 0, obsStatsIncrements = 0;
+		// Our stats are pushed to the manager after this many increments
+		constexpr static int OBS_STATS_INCS_PER_PUSH = 16;
+
+		// Segments of our games being recorded, only used if the manager has a rollout recorder
+		// Indexed by game, games that aren't recorded have no players in their segment
+		std::vector<RolloutRecorder::Segment> recordSegments = {};
+
+		// Cores our thread is pinned to, empty if not pinned
+		IList cores;
+		bool pinned = false; // False if pinning to our cores failed
+
+		// Set by the manager to stop us from collecting, without stopping the other agents (see ThreadAgentManager::SetParkedAgents())
+		std::atomic<bool> parked = false;
 		
 		// Lock to prevent game stepping
 		std::mutex gameStepMutex = {};
 
-		// Lock to modify trajectories
+		// Lock to modify the rollout storage
 		std::mutex trajMutex = {};
 
-		ThreadAgent(void* manager, int numGames, uint64_t maxCollect, EnvCreateFn envCreateFn);
+		// If cores is set, our games and buffers are created on a thread pinned to them, so their memory is local to those cores
+		// index is our index among the manager's agents, which is added to the manager afterward
+		ThreadAgent(void* manager, int index, int numGames, uint64_t maxCollect, int obsSize, EnvCreateFn envCreateFn, const IList& cores = {});
 
 		RG_NO_COPY(ThreadAgent);
 
+		// Starts our thread, or adds us to the manager's worker pool if it has one (see CollectionWorkerPool)
 		void Start();
 		void Stop();
 
+		// Collects one step of our games on the calling worker's thread, starting our games first if we were just started
+		void _WorkerStep();
+		bool _needsStart = false;
+
+		void _Init(int index, int numGames, int obsSize, EnvCreateFn envCreateFn);
+
 		~ThreadAgent() {
-			for (auto g : gameInsts)
-				delete g;
+			delete policyGraph;
+			for (PolicyGraph* graph : bufferPolicyGraphs)
+				delete graph;
+			delete ballPred;
+			delete stepExecutor;
 		}
 	};
 }
\ No newline at end of file
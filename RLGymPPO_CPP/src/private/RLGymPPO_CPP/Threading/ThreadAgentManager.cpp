@@ -1,38 +1,189 @@
 #include "ThreadAgentManager.h"
 #include <RLGymPPO_CPP/Util/Timer.h>
+#include <RLGymPPO_CPP/Util/CPUAffinity.h>
+#include <RLGymPPO_CPP/Util/TraceRecorder.h>
+#include <RLGymPPO_CPP/Util/MemoryInfo.h>
+#include <RLGymSim_CPP/Utils/AllocTracker/AllocTracker.h>
 
-void RLGPC::ThreadAgentManager::CreateAgents(EnvCreateFn func, int amount, int gamesPerAgent) {
-	for (int i = 0; i < amount; i++) {
-		auto agent = new ThreadAgent(this, gamesPerAgent, maxCollect / amount, func);
+void RLGPC::ThreadAgentManager::CreateAgents(EnvCreateFn func, int amount, int gamesPerAgent, AgentPinMode pinMode, const IList& pinCores) {
+	_envCreateFn = func;
+	_gamesPerAgent = gamesPerAgent;
+	_pinMode = pinMode;
+	_pinCores = pinCores;
+
+	if (pinMode == AgentPinMode::NUMA_NODES) {
+		_numaNodes = CPUAffinity::GetNUMANodes();
+		RG_LOG("\tFound " << _numaNodes.size() << " NUMA node(s)");
+	}
+
+	_AddAgents(amount, agents.size() + amount);
+}
+
+void RLGPC::ThreadAgentManager::_AddAgents(int amount, int totalAmount) {
+	int64_t rssBefore = MemoryInfo::GetProcessRSS();
+	int64_t rolloutBytes = 0;
+
+	int firstIndex = agents.size();
+	std::vector<IList> agentCores = std::vector<IList>(amount);
+	std::vector<ThreadAgent*> newAgents = std::vector<ThreadAgent*>(amount);
+	for (int n = 0; n < amount; n++) {
+		int i = firstIndex + n;
+
+		IList& cores = agentCores[n];
+		if (_pinMode == AgentPinMode::CORES) {
+			cores = { _pinCores.empty() ? (i % CPUAffinity::GetNumCores()) : _pinCores[i % _pinCores.size()] };
+		} else if (_pinMode == AgentPinMode::NUMA_NODES) {
+			cores = _numaNodes[i % _numaNodes.size()];
+		}
+	}
+
+	auto fnCreateAgent = [&](int n) {
+		newAgents[n] = new ThreadAgent(this, firstIndex + n, _gamesPerAgent, maxCollect / totalAmount, policy->inputAmount, _envCreateFn, agentCores[n]);
+	};
+
+	if (parallelEnvCreation && amount > 1) {
+		// Each agent creates its games on its own thread, which is pinned to its cores if it has any
+		std::vector<std::thread> createThreads = {};
+		for (int n = 0; n < amount; n++)
+			createThreads.push_back(std::thread(fnCreateAgent, n));
+		for (std::thread& thread : createThreads)
+			thread.join();
+	} else {
+		for (int n = 0; n < amount; n++)
+			fnCreateAgent(n);
+	}
+
+	// Set up in order, so callbacks and logs don't depend on which agent finished first
+	for (int n = 0; n < amount; n++) {
+		int i = firstIndex + n;
+		auto agent = newAgents[n];
+		const IList& cores = agentCores[n];
 		agents.push_back(agent);
+		rolloutBytes += agent->rollout.GetCapacityBytes();
+
+		for (auto game : agent->games.games) {
+			game->stepCallback = _stepCallback;
+			game->match->AddExtraStateFields(_extraStateFields);
+		}
+		agent->games.stepCallback = _batchStepCallback;
+
+		if (onAgentCreated)
+			onAgentCreated(agent, i);
+
+		if (agent->pinned) {
+			RG_LOG("\tAgent " << i << " pinned to core(s) " << CPUAffinity::CoresToString(cores));
+		} else if (!cores.empty()) {
+			RG_LOG("\tWARNING: Failed to pin agent " << i << " to core(s) " << CPUAffinity::CoresToString(cores));
+		}
 	}
+
+	if (rssBefore > 0)
+		gameMemoryEstimate += RS_MAX(MemoryInfo::GetProcessRSS() - rssBefore - rolloutBytes, 0);
+}
+
+void RLGPC::ThreadAgentManager::SwapEnvs(const std::function<RLGSC::EnvSwap(GameInst* game)>& swapFn) {
+	for (ThreadAgent* agent : agents) {
+		std::lock_guard<std::mutex> lock(agent->gameStepMutex);
+		for (GameInst* game : agent->games.games) {
+			RLGSC::EnvSwap swap = swapFn(game);
+			if (swap.teamSize >= 0 && swap.teamSize != game->match->teamSize)
+				RG_ERR_CLOSE("ThreadAgentManager::SwapEnvs(): Can't change the team size of training games (" << game->match->teamSize << " to " << swap.teamSize << ")");
+
+			game->gym->QueueSwap(swap);
+		}
+	}
+}
+
+void RLGPC::ThreadAgentManager::SetAgentAmount(int amount) {
+	amount = RS_MAX(amount, 1);
+	int oldAmount = agents.size();
+	if (amount == oldAmount)
+		return;
+
+	if (!_envCreateFn)
+		RG_ERR_CLOSE("ThreadAgentManager::SetAgentAmount(): Agents must be created first");
+
+	RG_LOG("ThreadAgentManager: Changing from " << oldAmount << " to " << amount << " agents...");
+
+	if (amount > oldAmount) {
+		_AddAgents(amount - oldAmount, amount);
+		if (agentsStarted)
+			for (int i = oldAmount; i < amount; i++)
+				agents[i]->Start();
+	} else {
+		// Agents are removed from the back, so the games of the rest keep their indices
+		for (int i = oldAmount - 1; i >= amount; i--) {
+			ThreadAgent* agent = agents[i];
+			if (agentsStarted)
+				agent->Stop();
+
+			// Steps the agent already collected are kept for the next CollectTimesteps()
+			agent->trajMutex.lock();
+			if (agent->rollout.size > 0) {
+				GameTrajectory traj = agent->rollout.Collect();
+				if (segmentSteps > 0) {
+					// Only full segments were counted
+					if (traj.size > 0) {
+						uint64_t trajSize = traj.size;
+						segmentQueue.Push(std::move(traj));
+						AddCollectedSteps(trajSize);
+					}
+				} else {
+					if (traj.size > 0)
+						_drainedTrajs.push_back(std::move(traj));
+					_drainedSteps += agent->stepsCollected;
+				}
+			}
+			agent->trajMutex.unlock();
+
+			gameMemoryEstimate -= gameMemoryEstimate / (i + 1);
+			agents.pop_back();
+			delete agent;
+		}
+	}
+
+	// Remaining agents now collect a different share of maxCollect
+	for (auto agent : agents) {
+		std::lock_guard<std::mutex> lock(agent->trajMutex);
+		agent->maxCollect = maxCollect / amount;
+		if (segmentSteps == 0)
+			agent->rollout.Reserve(agent->maxCollect / RS_MAX(agent->rollout.numPlayers, 1) + 1);
+	}
+
+	if (inferServer) {
+		{
+			std::lock_guard<std::mutex> lock(inferServer->mutex);
+			inferServer->numClients = GetNumCollectors();
+		}
+		inferServer->requestCV.notify_all();
+	}
+
+	RG_LOG(" > Done.");
 }
 
 RLGPC::GameTrajectory RLGPC::ThreadAgentManager::CollectTimesteps(uint64_t amount) {
 
 	RG_LOG("Collecting timesteps...");
-	// We will just wait in this loop until our agents have collected enough total timesteps
-	while (true) {
-		uint64_t totalSteps = 0;
-		for (auto agent : agents)
-			totalSteps += agent->stepsCollected;
-
-		if (totalSteps >= amount)
-			break;
 
-		// "waiter! waiter! more timesteps please!"
+	if (segmentSteps > 0)
+		return _CollectSegments(amount);
 
-		// TODO: Possibly sub-optimal waiting solution:
-		// This seems ok, but timestep collection only happens every once in a while (timings are very variable to config), 
-		//	so maybe its actually smarter to run sleep(1) or something?
-		// 
-		// Could also just have the agents keep track of total step collection and unlock this thread?
-		std::this_thread::yield();
+	// We will just wait here until our agents have collected enough total timesteps
+	// "waiter! waiter! more timesteps please!"
+	{
+		RG_TRACE_SCOPE("Wait For Steps");
+		std::unique_lock<std::mutex> lock(collectMutex);
+		stepsReadyTarget = amount;
+		stepsReadyCV.wait(lock, [&] { return totalStepsCollected >= amount; });
+		stepsReadyTarget = UINT64_MAX;
 	}
 
 	// Our agents have collected the timesteps we need
 	 
 	RG_LOG("Concatenating timesteps...");
+	Timer concatTimer = {};
+	RG_TRACE_SCOPE("Concat");
+	RG_ALLOC_SCOPE(TRAJECTORY);
 
 	GameTrajectory result = {};
 	size_t totalTimesteps = 0;
@@ -41,29 +192,53 @@ RLGPC::GameTrajectory RLGPC::ThreadAgentManager::CollectTimesteps(uint64_t amoun
 		// Combine all of their trajectories into one long trajectory
 		// We will return this giant trajectory to the learner
 		std::vector<GameTrajectory> trajs;
+
+		// From agents that were removed since the last call
+		for (auto& traj : _drainedTrajs) {
+			totalTimesteps += traj.size;
+			trajs.push_back(std::move(traj));
+		}
+		_drainedTrajs.clear();
+		totalStepsCollected -= _drainedSteps;
+		_drainedSteps = 0;
+
 		for (auto agent : agents) {
 			agent->trajMutex.lock();
-			for (auto& trajSet : agent->trajectories) {
-				for (auto& traj : trajSet) {
-					if (traj.size > 0) {
-						// If the last timestep is not a done, mark it as truncated
-						// The GAE needs to know when the environment state stops being continuous
-						// This happens either because the environment reset (i.e. goal scored), called "done",
-						//	or the data got cut short, called "truncated"
-						traj.data.truncateds[traj.size - 1] = (traj.data.dones[traj.size - 1].item<float>() == 0);
-						trajs.push_back(traj);
-						totalTimesteps += traj.size;
-						traj.Clear();
-					} else {
-						// Kinda lame but does happen
-					}
+			if (agent->rollout.size > 0) {
+				// Can still be empty, if none of the agent's steps are learned (see RolloutStorage::learned)
+				GameTrajectory traj = agent->rollout.Collect();
+				if (traj.size > 0) {
+					totalTimesteps += traj.size;
+					trajs.push_back(std::move(traj));
 				}
+			} else {
+				// Kinda lame but does happen
 			}
+			totalStepsCollected -= agent->stepsCollected;
 			agent->stepsCollected = 0;
 			agent->trajMutex.unlock();
 		}
 
-		result.MultiAppend(trajs);
+		if (remoteServer) {
+			uint64_t remoteSteps;
+			auto remoteTrajs = remoteServer->TakeTrajectories(remoteSteps);
+			trajs.insert(trajs.end(), remoteTrajs.begin(), remoteTrajs.end());
+			totalTimesteps += remoteSteps;
+			totalStepsCollected -= remoteSteps;
+		}
+
+		if (processServer) {
+			uint64_t processSteps;
+			auto processTrajs = processServer->TakeTrajectories(processSteps);
+			trajs.insert(trajs.end(), processTrajs.begin(), processTrajs.end());
+			totalTimesteps += processSteps;
+			totalStepsCollected -= processSteps;
+		}
+
+		// Agents waiting on the step limit can continue
+		NotifyAgents();
+
+		result.MultiAppend(trajs, jobSystem);
 	} catch (std::exception& e) {
 		RG_ERR_CLOSE("Exception concatenating timesteps: " << e.what());
 	}
@@ -72,15 +247,143 @@ RLGPC::GameTrajectory RLGPC::ThreadAgentManager::CollectTimesteps(uint64_t amoun
 	if (result.size != totalTimesteps)
 		RG_ERR_CLOSE("ThreadAgentManager::CollectTimesteps(): Agent timestep concatenation failed (" << result.size << " != " << totalTimesteps << ")");
 
+	lastConcatTime = concatTimer.Elapsed();
+	lastIterationTime = iterationTimer.Elapsed();
+	iterationTimer.Reset();
+	return result;
+}
+
+RLGPC::GameTrajectory RLGPC::ThreadAgentManager::_CollectSegments(uint64_t amount) {
+	GameTrajectory result = {};
+	std::vector<torch::Tensor> truncNextStates = {};
+	uint64_t totalTimesteps = 0;
+
+	auto fnAddTraj = [&](GameTrajectory& traj) {
+		{
+			RG_TRACE_SCOPE("Segment Append");
+			RG_ALLOC_SCOPE(TRAJECTORY);
+			if (result.capacity == 0)
+				result.Reserve(RS_MAX(maxCollect.load(), traj.size), traj);
+			result.AppendInPlace(traj);
+		}
+		truncNextStates.push_back(traj.truncNextStates);
+		totalTimesteps += traj.size;
+
+		if (segmentCallback)
+			segmentCallback(traj);
+	};
+
+	try {
+		// Copy segments in as they arrive, so there is nothing left to concatenate once we have enough
+		// Agents never wait on us, they only push to the queue
+		stepsReadyTarget = 0; // Wake us up for every segment
+		while (totalTimesteps < amount) {
+			GameTrajectory segment;
+			if (segmentQueue.Pop(segment)) {
+				fnAddTraj(segment);
+			} else {
+				std::unique_lock<std::mutex> lock(collectMutex);
+				stepsReadyCV.wait(lock, [&] { return !segmentQueue.IsEmpty(); });
+			}
+		}
+		stepsReadyTarget = UINT64_MAX;
+
+		// Steps in segments we didn't take yet stay counted, so agents still stop at maxCollect
+		totalStepsCollected -= totalTimesteps;
+
+		if (remoteServer) {
+			uint64_t remoteSteps;
+			for (auto& traj : remoteServer->TakeTrajectories(remoteSteps))
+				fnAddTraj(traj);
+			totalStepsCollected -= remoteSteps;
+		}
+
+		if (processServer) {
+			uint64_t processSteps;
+			for (auto& traj : processServer->TakeTrajectories(processSteps))
+				fnAddTraj(traj);
+			totalStepsCollected -= processSteps;
+		}
+
+		// Agents waiting on the step limit can continue
+		NotifyAgents();
+
+		result.truncNextStates = torch::cat(truncNextStates);
+	} catch (std::exception& e) {
+		RG_ERR_CLOSE("Exception collecting timestep segments: " << e.what());
+	}
+
 	lastIterationTime = iterationTimer.Elapsed();
 	iterationTimer.Reset();
 	return result;
 }
 
+void RLGPC::ThreadAgentManager::PublishPolicy(DiscretePolicy* policy) {
+	if (!policyBuffers[0].policy)
+		return;
+
+	RG_NOGRAD;
+
+	int front = frontPolicyBuffer;
+	int backIndex = (front < 0) ? 0 : (1 - front);
+	auto& back = policyBuffers[backIndex];
+
+	// Agents that acquired it before the last swap can still be inferring it
+	while (back.users > 0)
+		std::this_thread::yield();
+
+	auto fromParams = policy->parameters();
+	auto toParams = back.policy->parameters();
+	for (int i = 0; i < fromParams.size(); i++)
+		toParams[i].copy_(fromParams[i]);
+	back.policy->SetOBSStandardization(policy->obsStandardization);
+
+	frontPolicyBuffer = backIndex;
+}
+
+int RLGPC::ThreadAgentManager::AcquirePolicyBuffer() {
+	while (true) {
+		int index = frontPolicyBuffer;
+		if (index < 0)
+			return -1;
+
+		policyBuffers[index].users++;
+
+		// If it was swapped before we started using it, it may be about to be written to
+		if (frontPolicyBuffer == index)
+			return index;
+
+		policyBuffers[index].users--;
+	}
+}
+
+void RLGPC::ThreadAgentManager::WaitUntilCanCollect(ThreadAgent* agent) {
+	auto fnCanCollect = [&] {
+		return _CanCollect() && !agent->parked;
+	};
+
+	if (fnCanCollect())
+		return;
+
+	RG_TRACE_SCOPE("Wait To Collect");
+	bool atLimit = !disableCollection && !agent->parked;
+	Timer waitTimer = {};
+	{
+		std::unique_lock<std::mutex> lock(collectMutex);
+		collectCV.wait(lock, [&] { return !agent->shouldRun || fnCanCollect(); });
+	}
+
+	if (atLimit) {
+		agent->times.collectLimitWaitTime += waitTimer.Elapsed();
+	} else {
+		agent->times.disabledWaitTime += waitTimer.Elapsed();
+	}
+}
+
 void RLGPC::ThreadAgentManager::GetMetrics(Report& report) {
     AvgTracker avgStepRew, avgEpRew, avgEpLen;
     for (auto agent : agents) {
-        for (auto game : agent->gameInsts) {
+        for (auto game : agent->games.games) {
             avgStepRew += game->avgStepRew;
             avgEpRew += game->avgEpRew;
             avgEpLen += game->avgEpLen;
@@ -91,6 +394,58 @@ void RLGPC::ThreadAgentManager::GetMetrics(Report& report) {
     report["Average Episode Reward"] = avgEpRew.Get();
     report["Average Episode Length"] = avgEpLen.Get();
 
+	// Each policy that plays whole games also gets them over just its games
+	if (gamePolicyAmount > 1) {
+		std::vector<AvgTracker> policyStepRew(gamePolicyAmount), policyEpRew(gamePolicyAmount), policyEpLen(gamePolicyAmount);
+		for (auto agent : agents) {
+			for (int i = 0; i < agent->games.Size(); i++) {
+				auto game = agent->games.games[i];
+				int policyID = GetPolicyID(agent->firstGameIndex + i, 0);
+				policyStepRew[policyID] += game->avgStepRew;
+				policyEpRew[policyID] += game->avgEpRew;
+				policyEpLen[policyID] += game->avgEpLen;
+			}
+		}
+
+		for (int id = 0; id < gamePolicyAmount; id++) {
+			std::string prefix = "Policy " + std::to_string(id) + " ";
+			report[prefix + "Average Step Reward"] = policyStepRew[id].Get();
+			report[prefix + "Average Episode Reward"] = policyEpRew[id].Get();
+			report[prefix + "Average Episode Length"] = policyEpLen[id].Get();
+		}
+	}
+
+	// Registered metrics are read without stopping the games
+	int numRegistered = MetricRegistry::GetCount();
+	for (int i = 0; i < numRegistered; i++) {
+		double total = 0;
+		uint64_t count = 0;
+		for (auto agent : agents) {
+			for (auto game : agent->games.games) {
+				double gameTotal;
+				uint64_t gameCount;
+				game->metrics.GetSinceReset(i, gameTotal, gameCount);
+				total += gameTotal;
+				count += gameCount;
+			}
+
+			// Added by the batch step callback
+			double batchTotal;
+			uint64_t batchCount;
+			agent->games.metrics.GetSinceReset(i, batchTotal, batchCount);
+			total += batchTotal;
+			count += batchCount;
+		}
+
+		auto& entry = MetricRegistry::Get(i);
+		if (entry.type == MetricType::AVG) {
+			if (count > 0)
+				report[entry.name] = total / count;
+		} else {
+			report[entry.name] = total;
+		}
+	}
+
 	ThreadAgent::Times avgTimes = {};
 
 	for (ThreadAgent* agent : agents)
@@ -101,17 +456,176 @@ void RLGPC::ThreadAgentManager::GetMetrics(Report& report) {
 		time /= agents.size();
 
 	report["Env Step Time"] = avgTimes.envStepTime;
+	report["Collect Limit Wait Time"] = avgTimes.collectLimitWaitTime;
+	report["Concat Time"] = lastConcatTime;
+	report["Agents"] = agents.size();
+
+	{ // Memory of our agents
+		constexpr double MB = 1024 * 1024;
+		size_t capacityBytes = 0, usedBytes = 0;
+		for (auto agent : agents) {
+			agent->trajMutex.lock();
+			capacityBytes += agent->rollout.GetCapacityBytes();
+			usedBytes += agent->rollout.GetUsedBytes();
+			agent->trajMutex.unlock();
+		}
+		report["Rollout Capacity MB"] = capacityBytes / MB;
+		report["Rollout Used MB"] = usedBytes / MB;
+		if (gameMemoryEstimate > 0)
+			report["Est. Game Memory MB"] = gameMemoryEstimate / MB;
+	}
+
+	{ // Per agent, like the env step time
+		double obsBuildTime = 0, terminalTime = 0, rewardTime = 0, resetTime = 0;
+		for (auto agent : agents) {
+			for (auto game : agent->games.games) {
+				obsBuildTime += game->gym->obsBuildTime;
+				terminalTime += game->gym->terminalTime;
+				rewardTime += game->gym->rewardTime;
+				resetTime += game->gym->resetTime;
+			}
+		}
+		report["OBS Build Time"] = obsBuildTime / agents.size();
+		report["Env Terminal Time"] = terminalTime / agents.size();
+		report["Env Reward Time"] = rewardTime / agents.size();
+		report["Env Reset Time"] = resetTime / agents.size();
+	}
+
+	if (stepHelperThreads > 0) { // How much of the work of stepping games moved between the threads of each agent
+		uint64_t totalTasks = 0, stolenTasks = 0;
+		for (auto agent : agents) {
+			if (agent->stepExecutor) {
+				totalTasks += agent->stepExecutor->totalTasks;
+				stolenTasks += agent->stepExecutor->stolenTasks;
+			}
+		}
+		report["Env Step Stolen Task Fraction"] = totalTasks > 0 ? (double)stolenTasks / totalTasks : 0;
+	}
+
+	{ // Break down the arena step time of our games, only measured if RocketSim is built with RS_PROFILE
+		ArenaProfile arenaProfile = {};
+		for (auto agent : agents)
+			for (auto game : agent->games.games)
+				arenaProfile += game->gym->arena->profile;
+
+		if (arenaProfile.ticks > 0) {
+			// Per agent, like the env step time
+			double timeScale = 1 / (ArenaProfile::GetTimestampsPerSecond() * agents.size());
+			report["Arena Step Time"] = arenaProfile.GetTotalTime() * timeScale;
+			for (int i = 0; i < (int)ArenaProfilePhase::AMOUNT; i++) {
+				const char* phaseName = ArenaProfile::GetPhaseName((ArenaProfilePhase)i);
+				report[std::string("Arena ") + phaseName + " Time"] = arenaProfile.phaseTimes[i] * timeScale;
+			}
+
+			double ticks = arenaProfile.ticks;
+			report["Arena Contact Points Per Tick"] = arenaProfile.contactPoints / ticks;
+			report["Arena Broadphase Pairs Per Tick"] = arenaProfile.broadphasePairs / ticks;
+			report["Arena Suspension Rays Per Tick"] = arenaProfile.suspensionRays / ticks;
+			report["Arena Bullet Suspension Rays Per Tick"] = arenaProfile.suspensionBulletRays / ticks;
+		}
+	}
+
+	{ // Contacts that didn't fit in the collision pools of our games, since they were created
+		uint64_t manifoldOverflows = 0, algorithmOverflows = 0;
+		for (auto agent : agents) {
+			for (auto game : agent->games.games) {
+				ArenaCollisionPoolStats poolStats = game->gym->arena->GetCollisionPoolStats();
+				manifoldOverflows += poolStats.manifoldOverflows;
+				algorithmOverflows += poolStats.algorithmOverflows;
+			}
+		}
+		report["Total Arena Manifold Pool Overflows"] = manifoldOverflows;
+		report["Total Arena Algorithm Pool Overflows"] = algorithmOverflows;
+	}
 	// NOTE: Because of non-blocking mode, a good portion of policy inference time is waited when appending trajectories
 	//	This means the trajectory append time is not correct at all, so this is a temporary solution
 	report["Policy Infer Time"] = avgTimes.policyInferTime + avgTimes.trajAppendTime;
+
+	if (pipelinedCollection)
+		report["Infer-Step Overlap Time"] = avgTimes.inferOverlapTime;
+
+	if (workerPool)
+		workerPool->GetMetrics(report);
+
+	if (agents.size() > 1)
+		_GetAgentSpreadMetrics(report);
+
+	if (opponentPool) {
+		report["Opponent Pool Size"] = opponentPool->Size();
+		report["Opponent Infer Time"] = avgTimes.opponentInferTime;
+	}
+
+	if (inferServer)
+		report["Avg Inference Batch Size"] = inferServer->GetAvgBatchSize();
+
+	if (remoteServer)
+		remoteServer->GetMetrics(report);
+
+	if (processServer)
+		processServer->GetMetrics(report);
+}
+
+void RLGPC::ThreadAgentManager::_GetAgentSpreadMetrics(Report& report) {
+	int numAgents = agents.size();
+
+	auto fnAddSpread = [&](const std::string& name, std::function<double(ThreadAgent*)> fnGetValue) -> double {
+		std::vector<double> values = std::vector<double>(numAgents);
+		for (int i = 0; i < numAgents; i++)
+			values[i] = fnGetValue(agents[i]);
+		std::sort(values.begin(), values.end());
+
+		double median = values[numAgents / 2];
+		report["Agent " + name + " Min"] = values.front();
+		report["Agent " + name + " Median"] = median;
+		report["Agent " + name + " Max"] = values.back();
+		return median;
+	};
+
+	double medianSteps = fnAddSpread("Steps", [](ThreadAgent* agent) { return agent->times.steps; });
+	fnAddSpread("Env Step Time", [](ThreadAgent* agent) { return agent->times.envStepTime; });
+	fnAddSpread("Policy Infer Time", [](ThreadAgent* agent) { return agent->times.policyInferTime + agent->times.trajAppendTime; });
+	fnAddSpread("Collect Limit Wait Time", [](ThreadAgent* agent) { return agent->times.collectLimitWaitTime; });
+	fnAddSpread("Disabled Wait Time", [](ThreadAgent* agent) { return agent->times.disabledWaitTime; });
+	fnAddSpread("Resets", [](ThreadAgent* agent) {
+		uint64_t resets = 0;
+		for (auto game : agent->games.games)
+			resets += game->gym->resets;
+		return (double)resets;
+	});
+
+	// Agents that collected far less than the median are what CollectTimesteps() waits on
+	int stragglers = 0;
+	for (int i = 0; i < numAgents; i++) {
+		if (agents[i]->times.steps < medianSteps * STRAGGLER_STEPS_FRACTION) {
+			if (stragglers == 0)
+				RG_LOG("ThreadAgentManager: Agent " << i << " is straggling, it collected " << agents[i]->times.steps << " steps (median is " << medianSteps << ")");
+			stragglers++;
+		}
+	}
+	report["Straggler Agents"] = stragglers;
 }
 
 void RLGPC::ThreadAgentManager::ResetMetrics() {
+	if (inferServer)
+		inferServer->ResetStats();
+
+	if (remoteServer)
+		remoteServer->ResetMetrics();
+
+	if (processServer)
+		processServer->ResetMetrics();
+
+	if (workerPool)
+		workerPool->ResetMetrics();
+
 	for (auto agent : agents) {
 		agent->times = {};
+		if (agent->stepExecutor) {
+			agent->stepExecutor->totalTasks = 0;
+			agent->stepExecutor->stolenTasks = 0;
+		}
 		agent->gameStepMutex.lock();
-		for (auto game : agent->gameInsts)
-			game->ResetMetrics();
+		agent->games.ResetMetrics();
 		agent->gameStepMutex.unlock();
 	}
 }
\ No newline at end of file
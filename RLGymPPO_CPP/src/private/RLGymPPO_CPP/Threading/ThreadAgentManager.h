@@ -1,31 +1,242 @@
 #pragma once
 #include "ThreadAgent.h"
+#include "CollectionWorkerPool.h"
+#include "InferenceServer.h"
+#include "RemoteWorkerServer.h"
+#include "ProcessWorkerServer.h"
+#include "Spectator.h"
+#include "../PPO/NativePolicy.h"
+#include "../PPO/ScriptedPolicy.h"
+#include "../PPO/ValueEstimator.h"
 #include "../PPO/ExperienceBuffer.h"
+#include "../Util/MPSCQueue.h"
 #include <RLGymPPO_CPP/Util/Report.h>
 #include <RLGymPPO_CPP/Util/WelfordRunningStat.h>
 #include <RLGymPPO_CPP/Util/Timer.h>
 #include <RLGymPPO_CPP/Util/RenderSender.h>
+#include <RLGymPPO_CPP/LearnerConfig.h>
 
 namespace RLGPC {
 	class ThreadAgentManager {
 	public:
 		DiscretePolicy* policy, *policyHalf;
+
+		// If set, agents infer critic values during collection and store them in their rollouts
+		// NOTE: These values are from the critic at the time of collection, which is before the next learn iteration updates it
+		ValueEstimator* valueNet = NULL;
 		std::vector<ThreadAgent*> agents;
 		ExperienceBuffer* expBuffer;
 		std::mutex expBufferMutex = {};
 		bool standardizeOBS;
 		bool deterministic;
-		uint64_t maxCollect;
+		std::atomic<uint64_t> maxCollect; // Can be changed between iterations (see LearnerConfig::adaptiveIteration)
 		torch::Device device;
 
+		// Incremented whenever the policy is updated, steps are tagged with the version that collected them
+		// Starts at 1, as remote workers use 0 for not having a policy
+		std::atomic<uint64_t> policyVersion = 1;
+
+		// Total steps collected by all agents, agents stop collecting once this passes maxCollect
+		std::atomic<uint64_t> totalStepsCollected = 0;
+
+		// If set, agents will send their observations to this server instead of inferring the policy themselves
+		InferenceServer* inferServer = NULL;
+
+		// If set, trajectories from remote workers are collected alongside those of our agents
+		// Their steps count towards the steps we collect
+		RemoteWorkerServer* remoteServer = NULL;
+
+		// If set, segments from process workers are collected alongside those of our agents, like remote trajectories
+		ProcessWorkerServer* processServer = NULL;
+
 		RenderSender* renderSender = NULL;
 		float renderTimeScale = 1.f;
 
-		bool disableCollection = false; // Prevents new steps from being started
+		// If set, collected trajectories are concatenated on it (see LearnerConfig::jobThreads)
+		JobSystem* jobSystem = NULL;
+
+		// If set, its game is published to it after every step (see LearnerConfig::spectate)
+		// Must outlive our agents
+		Spectator* spectator = NULL;
+
+		std::atomic<bool> disableCollection = false; // Prevents new steps from being started, use SetCollectionDisabled()
+
+		// Each agent steps half of its games while inferring the policy for the other half
+		bool pipelinedCollection = false;
+
+		// If set, agents are stepped by a pool of this many worker threads instead of their own threads (see LearnerConfig::collectionWorkers)
+		// The pool is made by StartAgents(), and only steps non-pipelined agents
+		int collectionWorkers = 0;
+		CollectionWorkerPool* workerPool = NULL;
+
+		// Threads that collect steps and infer the policy, which is how many clients the inference server has
+		int GetNumCollectors() const {
+			return workerPool ? workerPool->GetNumWorkers() : (int)agents.size();
+		}
+
+		// The gyms of our agents make their next start state while waiting on inference (see LearnerConfig::resetAhead)
+		// Must be set before creating agents
+		bool resetAhead = false;
+
+		// Agents replay captured CUDA graphs of the policy, instead of launching every kernel each step
+		bool useCUDAGraphs = false;
+
+		// If set, agents infer with native CPU kernels instead of torch
+		// This is a copy of the policy, use UpdateNativePolicy() after the policy changes
+		bool useNativeInference = false;
+		std::shared_ptr<const NativePolicy> nativePolicy = NULL;
+		std::mutex nativePolicyMutex = {};
+
+		// Re-copies the policy into a new native policy, agents still using the old one keep it until they finish inferring
+		void UpdateNativePolicy() {
+			if (!useNativeInference)
+				return;
+
+			auto newPolicy = std::make_shared<const NativePolicy>(policy);
+			std::lock_guard<std::mutex> lock(nativePolicyMutex);
+			nativePolicy = newPolicy;
+		}
+
+		std::shared_ptr<const NativePolicy> GetNativePolicy() {
+			std::lock_guard<std::mutex> lock(nativePolicyMutex);
+			return nativePolicy;
+		}
+
+		// If set, agents infer a frozen TorchScript copy of the policy (see LearnerConfig::scriptedInference)
+		// Created by the first UpdateScriptedPolicy(), use it again after the policy changes
+		bool useScriptedInference = false;
+		std::atomic<ScriptedPolicy*> scriptedPolicy = NULL;
+
+		// Copies the weights of the policy into the scripted policy in-place, so it is never re-scripted
+		void UpdateScriptedPolicy() {
+			if (!useScriptedInference)
+				return;
+
+			// Same policy agents would otherwise infer
+			auto sourcePolicy = (policyHalf ? policyHalf : policy);
+			if (scriptedPolicy) {
+				scriptedPolicy.load()->Load(sourcePolicy);
+			} else {
+				scriptedPolicy = new ScriptedPolicy(sourcePolicy);
+			}
+		}
+
+		// Two copies of the policy that agents infer instead of the policy being learned, only used if set (see LearnerConfig::inferencePolicyBuffers)
+		// Agents infer the front buffer, PublishPolicy() writes the other one and then swaps them
+		// Agents never wait on this, and the learner only waits for agents that are still inferring a buffer from before the last swap
+		struct PolicyBuffer {
+			DiscretePolicy* policy = NULL;
+			std::atomic<int> users = 0; // Agents currently inferring this buffer
+		};
+		PolicyBuffer policyBuffers[2] = {};
+		std::atomic<int> frontPolicyBuffer = -1; // -1 until the first PublishPolicy()
+
+		// Copies the parameters and standardization of policy into the back buffer, then makes it the front buffer
+		// Does nothing if there are no policy buffers
+		void PublishPolicy(DiscretePolicy* policy);
+
+		// Returns the index of the front buffer, which stays unchanged until ReleasePolicyBuffer(), or -1 if nothing is published
+		int AcquirePolicyBuffer();
+		void ReleasePolicyBuffer(int index) {
+			policyBuffers[index].users--;
+		}
+
+		// Agents block on this while they are not allowed to collect
+		// NOTE: Any change that can let agents collect again must notify this
+		std::mutex collectMutex = {};
+		std::condition_variable collectCV = {};
+
+		// If set, agents predict the ball of each of their games this many ticks ahead after every step
+		// Must be set before creating agents
+		int ballPredTicks = 0;
+
+		// If set, the arenas of each agent share collision pools (see LearnerConfig::shareCollisionPools)
+		// Must be set before creating agents
+		bool shareCollisionPools = false;
+
+		// If set, agents step their games with this many helper threads (see LearnerConfig::stepHelperThreads)
+		// Must be set before creating agents
+		int stepHelperThreads = 0;
+
+		// If set, agents step the arenas of their games together (see LearnerConfig::interleaveArenaSteps)
+		// Must be set before creating agents
+		bool interleaveArenaSteps = false;
+
+		// Pages to back each agent's rollout storage with (see LearnerConfig::hugePages)
+		// Must be set before creating agents
+		HugePageMode hugePages = HugePageMode::NONE;
+
+		// If set, agents are created at the same time, each on its own thread (see LearnerConfig::parallelEnvCreation)
+		// Must be set before creating agents
+		bool parallelEnvCreation = false;
+
+		// If set, used as the first game of the first agent instead of creating one (e.g. the Learner's test environment)
+		// Taken once that agent is created
+		EnvCreateResult firstEnv = {};
+
+		// If non-negative, each game's random engine is seeded from this and the game's index, so resets are the same every run
+		// Must be set before creating agents
+		int randomSeed = -1;
+
+		// If set, agents hand off their steps in segments of this many steps (see LearnerConfig::collectionSegmentSteps)
+		// Must be set before creating agents
+		int segmentSteps = 0;
+		// Segments from agents, which CollectTimesteps() copies into its result as they arrive
+		MPSCQueue<GameTrajectory> segmentQueue = {};
+		// Called on each segment (and remote trajectory) as it is copied in, from the thread calling CollectTimesteps()
+		// Segments are passed in the same order they are in the result
+		std::function<void(GameTrajectory&)> segmentCallback = NULL;
+
+		// If set, the orange teams of some games are played by past policies from this pool (see LearnerConfig::opponentPoolSize)
+		// Must be set before creating agents, and outlive them
+		OpponentPool* opponentPool = NULL;
+
+		// Policy ID of each player slot of a game, players past the end are controlled by the main policy (ID 0) (see LearnerConfig::playerPolicyIDs)
+		// Must be set before creating agents
+		IList playerPolicyIDs = {};
+		// If above 1, whole games are dealt out to this many policies instead, game i being played by policy (i % gamePolicyAmount) (see LearnerConfig::gamePolicyConfigs)
+		// Must be set before creating agents
+		int gamePolicyAmount = 1;
+		// Policies with IDs from 1, which replace the actions of the players they control
+		// Must outlive our agents
+		std::vector<DiscretePolicy*> extraPolicies = {};
+
+		int GetPolicyID(uint64_t gameIndex, int playerSlot) const {
+			if (gamePolicyAmount > 1)
+				return gameIndex % gamePolicyAmount;
+			return (playerSlot < playerPolicyIDs.size()) ? playerPolicyIDs[playerSlot] : 0;
+		}
+
+		// If set, agents copy the steps of some of their games into segments for this to write (see LearnerConfig::rolloutRecordPath)
+		// Must be set before starting agents, and outlive them
+		RolloutRecorder* rolloutRecorder = NULL;
+
+		// CollectTimesteps() blocks on this until enough steps are collected
+		std::condition_variable stepsReadyCV = {};
+		std::atomic<uint64_t> stepsReadyTarget = UINT64_MAX;
 
 		Timer iterationTimer = {};
 		double lastIterationTime = 0;
+		double lastConcatTime = 0; // Of the trajectories in the last CollectTimesteps()
+
+		// Estimated memory of all of our games, from how much creating our agents grew the process's RSS, minus their rollout storage
+		// Only a rough estimate, as it includes anything else allocated at the same time
+		int64_t gameMemoryEstimate = 0;
+
+		// Stats of all observations sampled by agents, only merged into when the learner calls MergeOBSStats()
 		WelfordRunningStat obsStats;
+		// If standardizeOBS, agents add the observations of every this many steps to their own stats
+		// Must be set before starting agents
+		int stepsPerObsStatsInc = 5;
+		// Stats sampled by agents since they were last pushed, which MergeOBSStats() combines into obsStats
+		MPSCQueue<WelfordRunningStat> obsStatsQueue = {};
+
+		// Merges stats pushed by agents into obsStats, without stopping them
+		void MergeOBSStats() {
+			WelfordRunningStat agentStats;
+			while (obsStatsQueue.Pop(agentStats))
+				obsStats.Merge(agentStats);
+		}
 
 		ThreadAgentManager(
 			DiscretePolicy* policy, DiscretePolicy* policyHalf, ExperienceBuffer* expBuffer, 
@@ -35,32 +246,177 @@ namespace RLGPC {
 
 		RG_NO_COPY(ThreadAgentManager);
 
-		void CreateAgents(EnvCreateFn func, int amount, int gamesPerAgent);
+		// Agents are pinned to cores based on pinMode (see LearnerConfig::agentPinMode)
+		void CreateAgents(EnvCreateFn func, int amount, int gamesPerAgent, AgentPinMode pinMode = AgentPinMode::NONE, const IList& pinCores = {});
+
+		// Called on every agent we create, along with its index, before it is started
+		std::function<void(ThreadAgent*, int)> onAgentCreated = NULL;
+
+		// Kept from CreateAgents(), so that more agents can be created later
+		EnvCreateFn _envCreateFn = NULL;
+		int _gamesPerAgent = 0;
+		AgentPinMode _pinMode = AgentPinMode::NONE;
+		IList _pinCores = {};
+		std::vector<IList> _numaNodes = {};
+		StepCallback _stepCallback = NULL;
+		BatchStepCallback _batchStepCallback = NULL;
+		RLGSC::StateFields _extraStateFields = RLGSC::StateFields::NONE;
+
+		// Creates more agents, each expecting to collect its share of maxCollect among totalAmount agents
+		void _AddAgents(int amount, int totalAmount);
+
+		// Creates or removes agents until we have this many, and rebalances maxCollect between them
+		// Removed agents are stopped, and the steps they collected are kept for the next CollectTimesteps()
+		// NOTE: Must not be called during CollectTimesteps(), only between learn iterations
+		void SetAgentAmount(int amount);
+
+		// Queues a swap of components on every game of our agents, from swapFn (see Gym::QueueSwap())
+		// Each game applies it at the start of its next episode, so its arena is kept
+		// NOTE: Team sizes can't change, as the player layout of each agent's games is fixed
+		void SwapEnvs(const std::function<RLGSC::EnvSwap(GameInst* game)>& swapFn);
+
+		// Trajectories of removed agents, taken by the next CollectTimesteps()
+		std::vector<GameTrajectory> _drainedTrajs = {};
+		uint64_t _drainedSteps = 0;
+
+		bool agentsStarted = false;
 
 		void StartAgents() {
+			agentsStarted = true;
+
+			if (collectionWorkers > 0 && !workerPool)
+				workerPool = new CollectionWorkerPool(this, collectionWorkers);
+
+			if (inferServer) {
+				inferServer->numClients = GetNumCollectors();
+				inferServer->Start();
+			}
+
 			for (ThreadAgent* agent : agents)
 				agent->Start();
+
+			if (remoteServer) {
+				remoteServer->onStepsReceived = [this](uint64_t amount) { AddCollectedSteps(amount); };
+				remoteServer->Start();
+			}
+
+			if (processServer) {
+				processServer->onStepsReceived = [this](uint64_t amount) { AddCollectedSteps(amount); };
+				processServer->Start();
+			}
 		}
 
 		void StopAgents() {
+			agentsStarted = false;
 			for (ThreadAgent* agent : agents)
 				agent->Stop();
+
+			// Stopped agents have all been taken out of its queue
+			delete workerPool;
+			workerPool = NULL;
+
+			// Agents may be waiting on the server, so it needs to be stopped after them
+			if (inferServer)
+				inferServer->Stop();
+
+			if (remoteServer)
+				remoteServer->Stop();
+
+			if (processServer)
+				processServer->Stop();
+		}
+
+		void SetCollectionDisabled(bool disabled) {
+			{
+				std::lock_guard<std::mutex> lock(collectMutex);
+				disableCollection = disabled;
+			}
+			collectCV.notify_all();
+		}
+
+		// Parks this many agents from the back, and unparks the rest
+		// Parked agents finish their current step, then wait until they are unparked
+		void SetParkedAgents(int amount) {
+			{
+				std::lock_guard<std::mutex> lock(collectMutex);
+				for (int i = 0; i < agents.size(); i++)
+					agents[i]->parked = i >= (int)agents.size() - amount;
+			}
+			collectCV.notify_all();
+		}
+
+		// Wakes up all agents that are waiting to collect, so they can re-check if they should run
+		void NotifyAgents() {
+			{ std::lock_guard<std::mutex> lock(collectMutex); }
+			collectCV.notify_all();
+		}
+
+		// Called by agents after they add steps to their rollout
+		void AddCollectedSteps(uint64_t amount) {
+			uint64_t newTotal = (totalStepsCollected += amount);
+			if (newTotal >= stepsReadyTarget) {
+				{ std::lock_guard<std::mutex> lock(collectMutex); }
+				stepsReadyCV.notify_all();
+			}
+		}
+
+		// Blocks until the agent is allowed to collect another step, or should stop running
+		void WaitUntilCanCollect(ThreadAgent* agent);
+
+		// If collection isn't disabled and the step limit isn't reached, ignoring parked agents
+		bool _CanCollect() const {
+			return !disableCollection && totalStepsCollected <= maxCollect;
 		}
 
 		void SetStepCallback(StepCallback callback) {
+			_stepCallback = callback;
 			for (ThreadAgent* agent : agents)
-				for (GameInst* game : agent->gameInsts)
+				for (GameInst* game : agent->games.games)
 					game->stepCallback = callback;
+
+			// Step callbacks can read anything from the state
+			if (callback)
+				AddStateFields(RLGSC::StateFields::ALL);
+		}
+
+		// Makes the games of all agents, including ones created later, fill these fields of their states (see RLGSC::Match::extraStateFields)
+		void AddStateFields(RLGSC::StateFields fields) {
+			_extraStateFields |= fields;
+			for (ThreadAgent* agent : agents)
+				for (GameInst* game : agent->games.games)
+					game->match->AddExtraStateFields(fields);
+		}
+
+		void SetBatchStepCallback(BatchStepCallback callback) {
+			_batchStepCallback = callback;
+			for (ThreadAgent* agent : agents)
+				agent->games.stepCallback = callback;
 		}
 
 		void GetMetrics(Report& report);
+
+		// Agents that collected less than this fraction of the median agent's steps are reported as stragglers
+		constexpr static double STRAGGLER_STEPS_FRACTION = 0.5;
+
+		// Min, median and max of each agent's steps, times, and resets, which averages would hide the slowest agent in
+		void _GetAgentSpreadMetrics(Report& report);
 		void ResetMetrics();
 
 		GameTrajectory CollectTimesteps(uint64_t amount);
+		GameTrajectory _CollectSegments(uint64_t amount);
 
 		~ThreadAgentManager() {
+			delete workerPool; // Before our agents, which its workers may still be stepping
 			for (ThreadAgent* agent : agents)
 				delete agent;
+			delete inferServer;
+			delete remoteServer;
+			delete processServer;
+			delete scriptedPolicy.load();
+			for (auto& buffer : policyBuffers)
+				delete buffer.policy;
+			delete firstEnv.gym;
+			delete firstEnv.match;
 		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "CPUAffinity.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+int RLGPC::CPUAffinity::GetNumCores() {
+	return RS_MAX((int)std::thread::hardware_concurrency(), 1);
+}
+
+// Parses Linux's cpulist format, e.g. "0-15,32-47"
+RLGPC::IList _ParseCoreList(const std::string& str) {
+	RLGPC::IList result = {};
+	std::stringstream stream = std::stringstream(str);
+	std::string range;
+	while (std::getline(stream, range, ',')) {
+		if (range.empty() || !isdigit(range[0]))
+			continue;
+
+		size_t dashPos = range.find('-');
+		int first = std::stoi(range.substr(0, dashPos));
+		int last = (dashPos == std::string::npos) ? first : std::stoi(range.substr(dashPos + 1));
+		for (int i = first; i <= last; i++)
+			result.push_back(i);
+	}
+	return result;
+}
+
+std::vector<RLGPC::IList> RLGPC::CPUAffinity::GetNUMANodes() {
+	std::vector<IList> result = {};
+
+#ifdef _WIN32
+	ULONG highestNode = 0;
+	if (GetNumaHighestNodeNumber(&highestNode)) {
+		for (ULONG node = 0; node <= highestNode; node++) {
+			ULONGLONG mask = 0;
+			if (!GetNumaNodeProcessorMask((UCHAR)node, &mask) || !mask)
+				continue;
+
+			IList cores = {};
+			for (int i = 0; i < 64; i++)
+				if (mask & (1ull << i))
+					cores.push_back(i);
+			result.push_back(cores);
+		}
+	}
+#else
+	constexpr const char* NODES_PATH = "/sys/devices/system/node";
+	std::map<int, IList> nodes = {};
+	if (std::filesystem::is_directory(NODES_PATH)) {
+		for (auto& entry : std::filesystem::directory_iterator(NODES_PATH)) {
+			std::string name = entry.path().filename().string();
+			if (name.rfind("node", 0) != 0 || name.size() == 4 || !isdigit(name[4]))
+				continue;
+
+			std::ifstream listIn = std::ifstream(entry.path() / "cpulist");
+			std::string coreList;
+			if (!std::getline(listIn, coreList))
+				continue;
+
+			IList cores = _ParseCoreList(coreList);
+			if (!cores.empty())
+				nodes[std::stoi(name.substr(4))] = cores;
+		}
+	}
+
+	for (auto& pair : nodes)
+		result.push_back(pair.second);
+#endif
+
+	if (result.empty()) {
+		IList allCores = {};
+		for (int i = 0; i < GetNumCores(); i++)
+			allCores.push_back(i);
+		result.push_back(allCores);
+	}
+
+	return result;
+}
+
+bool RLGPC::CPUAffinity::PinCurrentThread(const IList& cores) {
+	if (cores.empty())
+		return false;
+
+#ifdef _WIN32
+	DWORD_PTR mask = 0;
+	for (int core : cores)
+		if (core >= 0 && core < sizeof(DWORD_PTR) * 8)
+			mask |= ((DWORD_PTR)1 << core);
+
+	return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int core : cores)
+		if (core >= 0 && core < CPU_SETSIZE)
+			CPU_SET(core, &set);
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+std::string RLGPC::CPUAffinity::CoresToString(const IList& cores) {
+	IList sorted = cores;
+	std::sort(sorted.begin(), sorted.end());
+
+	std::stringstream stream;
+	for (int i = 0; i < sorted.size();) {
+		int j = i;
+		while (j + 1 < sorted.size() && sorted[j + 1] == sorted[j] + 1)
+			j++;
+
+		if (i > 0)
+			stream << ',';
+		stream << sorted[i];
+		if (j > i)
+			stream << '-' << sorted[j];
+		i = j + 1;
+	}
+	return stream.str();
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include <RLGymPPO_CPP/Lists.h>
+
+namespace RLGPC {
+	// Pinning threads to CPU cores, and finding which cores belong to which NUMA node
+	namespace CPUAffinity {
+		int GetNumCores();
+
+		// Cores of each NUMA node
+		// If the NUMA layout can't be found, returns a single node with all cores
+		std::vector<IList> GetNUMANodes();
+
+		// Restricts the calling thread to run on these cores
+		// Returns false if this isn't supported or failed
+		bool PinCurrentThread(const IList& cores);
+
+		// Formats cores like "0-3,8,10-11"
+		std::string CoresToString(const IList& cores);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "CUDAPhaseTimer.h"
+
+#ifdef RG_CUDA_EVENTS
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDAGuard.h>
+
+using CUDAEvent = at::cuda::CUDAEvent;
+
+struct RLGPC::CUDAPhaseTimer::_Impl {
+	int deviceIndex;
+	CUDAEvent beginEvent, endEvent;
+
+	// Events are kept between windows, so they are only created once they are first needed
+	struct Mark {
+		int phase;
+		std::unique_ptr<CUDAEvent> startEvent, endEvent;
+	};
+	std::vector<Mark> marks = {};
+	int numMarks = 0;
+
+	_Impl(int deviceIndex) : deviceIndex(deviceIndex), beginEvent(cudaEventDefault), endEvent(cudaEventDefault) {}
+};
+#else
+struct RLGPC::CUDAPhaseTimer::_Impl {};
+#endif
+
+bool RLGPC::CUDAPhaseTimer::IsSupported(c10::Device device) {
+#ifdef RG_CUDA_EVENTS
+	return device.is_cuda();
+#else
+	return false;
+#endif
+}
+
+RLGPC::CUDAPhaseTimer::CUDAPhaseTimer(c10::Device device, int numPhases) : numPhases(numPhases) {
+	enabled = IsSupported(device);
+#ifdef RG_CUDA_EVENTS
+	if (enabled)
+		_impl = new _Impl(device.has_index() ? device.index() : 0);
+#endif
+}
+
+RLGPC::CUDAPhaseTimer::~CUDAPhaseTimer() {
+	delete _impl;
+}
+
+void RLGPC::CUDAPhaseTimer::Begin() {
+#ifdef RG_CUDA_EVENTS
+	if (!enabled)
+		return;
+
+	c10::cuda::CUDAGuard guard = c10::cuda::CUDAGuard(_impl->deviceIndex);
+	_impl->numMarks = 0;
+	_impl->beginEvent.record();
+#endif
+}
+
+void RLGPC::CUDAPhaseTimer::StartPhase(int phase) {
+#ifdef RG_CUDA_EVENTS
+	if (!enabled)
+		return;
+
+	c10::cuda::CUDAGuard guard = c10::cuda::CUDAGuard(_impl->deviceIndex);
+	if (_impl->numMarks == _impl->marks.size()) {
+		_impl->marks.push_back({
+			phase,
+			std::make_unique<CUDAEvent>(cudaEventDefault),
+			std::make_unique<CUDAEvent>(cudaEventDefault)
+		});
+	}
+
+	auto& mark = _impl->marks[_impl->numMarks];
+	mark.phase = phase;
+	mark.startEvent->record();
+#endif
+}
+
+void RLGPC::CUDAPhaseTimer::EndPhase(int phase) {
+#ifdef RG_CUDA_EVENTS
+	if (!enabled)
+		return;
+
+	if (_impl->numMarks == _impl->marks.size() || _impl->marks[_impl->numMarks].phase != phase)
+		RG_ERR_CLOSE("CUDAPhaseTimer::EndPhase(): Phase " << phase << " was not started");
+
+	c10::cuda::CUDAGuard guard = c10::cuda::CUDAGuard(_impl->deviceIndex);
+	_impl->marks[_impl->numMarks].endEvent->record();
+	_impl->numMarks++;
+#endif
+}
+
+void RLGPC::CUDAPhaseTimer::End() {
+#ifdef RG_CUDA_EVENTS
+	if (!enabled)
+		return;
+
+	c10::cuda::CUDAGuard guard = c10::cuda::CUDAGuard(_impl->deviceIndex);
+	_impl->endEvent.record();
+#endif
+}
+
+RLGPC::CUDAPhaseTimer::Result RLGPC::CUDAPhaseTimer::Resolve() {
+	Result result = {};
+	result.phaseTimes = std::vector<double>(numPhases, 0);
+	result.totalTime = 0;
+	result.idleFraction = NAN;
+
+#ifdef RG_CUDA_EVENTS
+	if (!enabled)
+		return result;
+
+	// Every event before it has completed once this one has
+	_impl->endEvent.synchronize();
+
+	double busyTime = 0;
+	for (int i = 0; i < _impl->numMarks; i++) {
+		auto& mark = _impl->marks[i];
+		double phaseTime = mark.startEvent->elapsed_time(*mark.endEvent) / 1000.0;
+		result.phaseTimes[mark.phase] += phaseTime;
+		busyTime += phaseTime;
+	}
+
+	result.totalTime = _impl->beginEvent.elapsed_time(_impl->endEvent) / 1000.0;
+	if (result.totalTime > 0)
+		result.idleFraction = RS_CLAMP(1 - busyTime / result.totalTime, 0, 1);
+	_impl->numMarks = 0;
+#endif
+
+	return result;
+}
\ No newline at end of file
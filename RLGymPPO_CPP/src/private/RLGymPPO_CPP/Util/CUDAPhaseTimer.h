@@ -0,0 +1,42 @@
+#pragma once
+#include <RLGymPPO_CPP/FrameworkTorch.h>
+
+namespace RLGPC {
+	// Times phases of the work queued on a CUDA device, by recording CUDA events around them
+	// Events are only read in Resolve(), so timing never waits on the device until then
+	// Does nothing on other devices, or if libtorch was built without CUDA (see RG_CUDA_EVENTS)
+	class CUDAPhaseTimer {
+	public:
+		int numPhases;
+		bool enabled;
+
+		CUDAPhaseTimer(c10::Device device, int numPhases);
+		RG_NO_COPY(CUDAPhaseTimer);
+		~CUDAPhaseTimer();
+
+		static bool IsSupported(c10::Device device);
+
+		// Starts a new timing window, forgetting the phases of the last one
+		void Begin();
+
+		// Phases can be timed any amount of times within a window, but must not overlap
+		void StartPhase(int phase);
+		void EndPhase(int phase);
+
+		// Ends the window
+		void End();
+
+		struct Result {
+			std::vector<double> phaseTimes; // Device time spent in each phase, in seconds
+			double totalTime; // Device time from Begin() to End(), in seconds
+			double idleFraction; // Fraction of totalTime not spent in any phase
+		};
+
+		// Waits for the device to reach the end of the window
+		Result Resolve();
+
+		// Holds the CUDA events, so that CUDA headers are only needed by our source file
+		struct _Impl;
+		_Impl* _impl = NULL;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "CheckpointFile.h"
+
+using namespace RLGPC;
+
+// Followed by the table, which is tableSize bytes
+struct _FileHeader {
+	uint32_t magic, version;
+	uint32_t entryCount, reserved;
+	uint64_t tableSize;
+};
+
+uint64_t _AlignUp(uint64_t val) {
+	return (val + CheckpointFile::DATA_ALIGNMENT - 1) / CheckpointFile::DATA_ALIGNMENT * CheckpointFile::DATA_ALIGNMENT;
+}
+
+RLGPC::CheckpointFile::CheckpointFile(std::filesystem::path path) : path(path), _map(path, "CheckpointFile: ") {
+	constexpr const char* ERROR_PREFIX = "CheckpointFile: ";
+
+	_FileHeader header;
+	if (_map.size < sizeof(header))
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is too small to be a checkpoint");
+	memcpy(&header, _map.data, sizeof(header));
+
+	if (header.magic != MAGIC)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is not a checkpoint file");
+	if (header.version != VERSION)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " has unsupported version " << header.version);
+	if (sizeof(header) + header.tableSize > _map.size)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is truncated");
+
+	DataStreamIn in = {};
+	in.data = std::vector<byte>(_map.data + sizeof(header), _map.data + sizeof(header) + header.tableSize);
+
+	for (uint32_t i = 0; i < header.entryCount; i++) {
+		if (in.GetNumBytesLeft() < sizeof(uint32_t) * 3 + sizeof(uint64_t) * 2)
+			RG_ERR_CLOSE(ERROR_PREFIX << path << " has a corrupt table");
+
+		Entry entry = {};
+		entry.type = (EntryType)in.Read<uint32_t>();
+		uint32_t nameLen = in.Read<uint32_t>();
+		uint32_t numDims = in.Read<uint32_t>();
+		entry.offset = in.Read<uint64_t>();
+		entry.size = in.Read<uint64_t>();
+
+		if (in.GetNumBytesLeft() < nameLen + numDims * sizeof(int64_t))
+			RG_ERR_CLOSE(ERROR_PREFIX << path << " has a corrupt table");
+
+		entry.name = std::string((const char*)in.data.data() + in.pos, nameLen);
+		in.pos += nameLen;
+		for (uint32_t j = 0; j < numDims; j++)
+			entry.shape.push_back(in.Read<int64_t>());
+
+		if (entry.offset + entry.size > _map.size)
+			RG_ERR_CLOSE(ERROR_PREFIX << path << " is truncated (entry \"" << entry.name << "\")");
+
+		entry.data = _map.data + entry.offset;
+		entries.push_back(entry);
+	}
+}
+
+const CheckpointFile::Entry* RLGPC::CheckpointFile::Find(const std::string& name) const {
+	for (auto& entry : entries)
+		if (entry.name == name)
+			return &entry;
+	return NULL;
+}
+
+const CheckpointFile::Entry& RLGPC::CheckpointFile::Get(const std::string& name, EntryType type) const {
+	const Entry* entry = Find(name);
+	if (!entry)
+		RG_ERR_CLOSE("CheckpointFile: " << path << " has no entry \"" << name << "\"");
+	if (entry->type != type)
+		RG_ERR_CLOSE("CheckpointFile: Entry \"" << name << "\" in " << path << " has the wrong type");
+	return *entry;
+}
+
+bool RLGPC::CheckpointFile::IsCheckpointFile(std::filesystem::path path) {
+	std::ifstream in = std::ifstream(path, std::ios::binary);
+	uint32_t magic = 0;
+	in.read((char*)&magic, sizeof(magic));
+	return in.good() && magic == MAGIC;
+}
+
+void RLGPC::CheckpointFileWriter::AddFloats(const std::string& name, const float* data, const std::vector<int64_t>& shape) {
+	uint64_t count = 1;
+	for (int64_t dim : shape)
+		count *= dim;
+	entries.push_back(PendingEntry{ name, CheckpointFile::EntryType::FLOAT32, shape, data, count * sizeof(float) });
+}
+
+void RLGPC::CheckpointFileWriter::AddBytes(const std::string& name, const void* data, uint64_t size) {
+	entries.push_back(PendingEntry{ name, CheckpointFile::EntryType::BYTES, {}, data, size });
+}
+
+void RLGPC::CheckpointFileWriter::Save(std::filesystem::path path) const {
+	// Table size doesn't depend on the offsets, so find it first
+	uint64_t tableSize = 0;
+	for (auto& entry : entries)
+		tableSize += sizeof(uint32_t) * 3 + sizeof(uint64_t) * 2 + entry.name.size() + entry.shape.size() * sizeof(int64_t);
+
+	std::vector<uint64_t> offsets = {};
+	uint64_t curOffset = _AlignUp(sizeof(_FileHeader) + tableSize);
+	for (auto& entry : entries) {
+		offsets.push_back(curOffset);
+		curOffset = _AlignUp(curOffset + entry.size);
+	}
+
+	DataStreamOut table = {};
+	for (int i = 0; i < entries.size(); i++) {
+		auto& entry = entries[i];
+		table.Write<uint32_t>((uint32_t)entry.type);
+		table.Write<uint32_t>(entry.name.size());
+		table.Write<uint32_t>(entry.shape.size());
+		table.Write<uint64_t>(offsets[i]);
+		table.Write<uint64_t>(entry.size);
+		table.WriteBytes(entry.name.data(), entry.name.size());
+		for (int64_t dim : entry.shape)
+			table.Write<int64_t>(dim);
+	}
+	RG_ASSERT(table.data.size() == tableSize);
+
+	_FileHeader header = { CheckpointFile::MAGIC, CheckpointFile::VERSION, (uint32_t)entries.size(), 0, tableSize };
+
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+
+	{
+		std::ofstream out = std::ofstream(tempPath, std::ios::binary);
+		if (!out.good())
+			RG_ERR_CLOSE("CheckpointFileWriter::Save(): Failed to open " << tempPath);
+
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)table.data.data(), table.data.size());
+
+		uint64_t pos = sizeof(header) + tableSize;
+		const char zeros[CheckpointFile::DATA_ALIGNMENT] = {};
+		for (int i = 0; i < entries.size(); i++) {
+			out.write(zeros, offsets[i] - pos);
+			out.write((const char*)entries[i].data, entries[i].size);
+			pos = offsets[i] + entries[i].size;
+		}
+
+		if (!out.good())
+			RG_ERR_CLOSE("CheckpointFileWriter::Save(): Failed to write " << tempPath);
+	}
+
+	std::filesystem::rename(tempPath, path);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "MappedFile.h"
+
+namespace RLGPC {
+	// Single-file checkpoint format
+	// Layout: header, table of entries, then the data of each entry, aligned to DATA_ALIGNMENT from the start of the file
+	// Loading memory-maps the file, so an entry's data can be used (or copied to the device) directly from the mapping
+	class CheckpointFile {
+	public:
+		constexpr static uint32_t MAGIC = 0x4B434752; // "RGCK"
+		constexpr static uint32_t VERSION = 1;
+		constexpr static uint64_t DATA_ALIGNMENT = 64;
+
+		enum class EntryType : uint8_t {
+			FLOAT32,
+			BYTES // Anything else, e.g. serialized optimizer state or JSON
+		};
+
+		struct Entry {
+			std::string name;
+			EntryType type;
+			std::vector<int64_t> shape; // Empty for BYTES
+			uint64_t offset, size; // In bytes, offset is from the start of the file
+			const uint8_t* data; // Points into our mapping
+		};
+
+		std::filesystem::path path;
+		std::vector<Entry> entries;
+
+		// Maps and reads the table of a checkpoint file
+		CheckpointFile(std::filesystem::path path);
+		RG_NO_COPY(CheckpointFile);
+
+		// Returns NULL if there is no entry with this name
+		const Entry* Find(const std::string& name) const;
+		// Closes if there is no entry with this name, or if it is of a different type
+		const Entry& Get(const std::string& name, EntryType type) const;
+
+		// True if the file exists and starts with our magic number
+		static bool IsCheckpointFile(std::filesystem::path path);
+
+		MappedFile _map;
+	};
+
+	// Builds a CheckpointFile
+	// NOTE: Entries only point to their data, which must stay valid until Save()
+	class CheckpointFileWriter {
+	public:
+		struct PendingEntry {
+			std::string name;
+			CheckpointFile::EntryType type;
+			std::vector<int64_t> shape;
+			const void* data;
+			uint64_t size;
+		};
+		std::vector<PendingEntry> entries;
+
+		void AddFloats(const std::string& name, const float* data, const std::vector<int64_t>& shape);
+		void AddBytes(const std::string& name, const void* data, uint64_t size);
+
+		// Writes to a temporary file next to path, then renames it to path
+		void Save(std::filesystem::path path) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "CheckpointWriter.h"
+
+RLGPC::CheckpointWriter::CheckpointWriter(std::filesystem::path removeFolder, int checkpointsToKeep, std::string metricsName) :
+	removeFolder(removeFolder), checkpointsToKeep(checkpointsToKeep), metricsName(metricsName) {
+
+	thread = std::thread(&CheckpointWriter::_Run, this);
+}
+
+void RLGPC::CheckpointWriter::Submit(std::filesystem::path folderPath, WriteFn writeFn, double snapshotTime) {
+	std::unique_lock<std::mutex> lock(mutex);
+	cv.wait(lock, [this] { return pendingJobs.empty() || !error.empty(); });
+	_CheckError();
+
+	pendingJobs.push_back(Job{ folderPath, writeFn, snapshotTime });
+	cv.notify_all();
+}
+
+void RLGPC::CheckpointWriter::WaitIdle() {
+	std::unique_lock<std::mutex> lock(mutex);
+	cv.wait(lock, [this] { return (pendingJobs.empty() && !writing) || !error.empty(); });
+	_CheckError();
+}
+
+void RLGPC::CheckpointWriter::GetMetrics(Report& report) {
+	std::lock_guard<std::mutex> lock(mutex);
+	_CheckError();
+
+	// Only reported once per written checkpoint
+	if (hasNewMetrics) {
+		report[metricsName + " Write Time"] = lastWriteTime;
+		report[metricsName + " Snapshot Time"] = lastSnapshotTime;
+		hasNewMetrics = false;
+	}
+}
+
+void RLGPC::CheckpointWriter::Write(std::filesystem::path folderPath, WriteFn writeFn) {
+	// Not a number, so it is never loaded as a checkpoint (see Learner::Load())
+	std::filesystem::path tempPath = folderPath.parent_path() / (".tmp_" + folderPath.filename().string());
+
+	if (std::filesystem::exists(tempPath))
+		std::filesystem::remove_all(tempPath); // Left over from an interrupted write
+	std::filesystem::create_directories(tempPath);
+
+	writeFn(tempPath);
+
+	if (std::filesystem::exists(folderPath))
+		std::filesystem::remove_all(folderPath);
+	std::filesystem::rename(tempPath, folderPath);
+}
+
+void RLGPC::CheckpointWriter::RemoveOldCheckpoints(std::filesystem::path folderPath, int checkpointsToKeep) {
+	if (checkpointsToKeep == -1)
+		return;
+
+	int numCheckpoints = 0;
+	int64_t lowestCheckpointTS = INT64_MAX;
+
+	for (auto entry : std::filesystem::directory_iterator(folderPath)) {
+		if (entry.is_directory()) {
+			auto name = entry.path().filename();
+			try {
+				int64_t nameVal = std::stoll(name);
+				lowestCheckpointTS = RS_MIN(nameVal, lowestCheckpointTS);
+				numCheckpoints++;
+			} catch (...) {}
+		}
+	}
+
+	if (numCheckpoints > checkpointsToKeep) {
+		std::filesystem::path removePath = folderPath / std::to_string(lowestCheckpointTS);
+		try {
+			std::filesystem::remove_all(removePath);
+		} catch (std::exception& e) {
+			RG_ERR_CLOSE("Failed to remove old checkpoint from " << removePath << ", exception: " << e.what());
+		}
+	}
+}
+
+void RLGPC::CheckpointWriter::_Run() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [this] { return !pendingJobs.empty() || shouldStop; });
+			if (pendingJobs.empty())
+				break; // Stopping, and nothing left to write
+
+			job = pendingJobs.front();
+			pendingJobs.pop_front();
+			writing = true;
+			cv.notify_all();
+		}
+
+		std::string jobError = {};
+		Timer writeTimer = {};
+		try {
+			Write(job.folderPath, job.writeFn);
+			RemoveOldCheckpoints(removeFolder, checkpointsToKeep);
+		} catch (std::exception& e) {
+			jobError = RS_STR("Failed to write checkpoint to " << job.folderPath << ", exception: " << e.what());
+		}
+		double writeTime = writeTimer.Elapsed();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			writing = false;
+			if (jobError.empty()) {
+				lastWriteTime = writeTime;
+				lastSnapshotTime = job.snapshotTime;
+				hasNewMetrics = true;
+			} else {
+				error = jobError;
+			}
+			cv.notify_all();
+		}
+
+		if (!jobError.empty())
+			break;
+	}
+}
+
+// Errors from the writer thread are thrown on the learner's thread, where they can be handled
+void RLGPC::CheckpointWriter::_CheckError() {
+	if (!error.empty())
+		RG_ERR_CLOSE("CheckpointWriter: " << error);
+}
+
+RLGPC::CheckpointWriter::~CheckpointWriter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shouldStop = true;
+		cv.notify_all();
+	}
+
+	if (thread.joinable())
+		thread.join();
+}
\ No newline at end of file
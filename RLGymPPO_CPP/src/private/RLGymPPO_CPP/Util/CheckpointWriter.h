@@ -0,0 +1,68 @@
+#pragma once
+#include <RLGymPPO_CPP/Util/Report.h>
+#include <RLGymPPO_CPP/Util/Timer.h>
+#include <condition_variable>
+
+namespace RLGPC {
+	// Writes checkpoints on a background thread, so that slow filesystems don't stall learning
+	// Each checkpoint is written to a temporary folder, which is renamed to its final name once complete
+	class CheckpointWriter {
+	public:
+		// Writes all files of a checkpoint into the given folder
+		// Must only use data that was copied when it was created, as it runs while learning continues
+		typedef std::function<void(std::filesystem::path)> WriteFn;
+
+		// After each checkpoint is written, old checkpoints in this folder are removed (see RemoveOldCheckpoints())
+		std::filesystem::path removeFolder;
+		int checkpointsToKeep;
+
+		// Metrics are reported as "<metricsName> Write Time" and "<metricsName> Snapshot Time"
+		std::string metricsName;
+
+		struct Job {
+			std::filesystem::path folderPath;
+			WriteFn writeFn;
+			double snapshotTime;
+		};
+
+		std::thread thread;
+		std::mutex mutex = {};
+		std::condition_variable cv = {};
+
+		std::list<Job> pendingJobs = {};
+		bool writing = false;
+		bool shouldStop = false;
+		std::string error = {};
+
+		// From the last written checkpoint
+		double lastWriteTime = 0, lastSnapshotTime = 0;
+		bool hasNewMetrics = false;
+
+		CheckpointWriter(std::filesystem::path removeFolder, int checkpointsToKeep, std::string metricsName = "Checkpoint");
+
+		// Queues a checkpoint to be written to folderPath
+		// To limit memory use, waits until any previously-queued checkpoint has started writing
+		// snapshotTime is the time it took to copy the checkpoint's data, and is only used for metrics
+		void Submit(std::filesystem::path folderPath, WriteFn writeFn, double snapshotTime);
+
+		// Waits until all queued checkpoints are written
+		void WaitIdle();
+
+		void GetMetrics(Report& report);
+
+		// Writes a checkpoint on this thread, using a temporary folder
+		static void Write(std::filesystem::path folderPath, WriteFn writeFn);
+
+		// Removes the lowest-numbered checkpoints in folderPath until there are no more than checkpointsToKeep
+		// Does nothing if checkpointsToKeep is -1
+		static void RemoveOldCheckpoints(std::filesystem::path folderPath, int checkpointsToKeep);
+
+		void _Run();
+		void _CheckError();
+
+		RG_NO_COPY(CheckpointWriter);
+
+		// Finishes writing all queued checkpoints first
+		~CheckpointWriter();
+	};
+}
\ No newline at end of file
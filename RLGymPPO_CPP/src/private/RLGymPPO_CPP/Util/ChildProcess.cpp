@@ -0,0 +1,124 @@
+#include "ChildProcess.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+void RLGPC::ChildProcess::SpawnSelf(const std::string& envName, const std::string& envValue) {
+#ifdef _WIN32
+	wchar_t exePath[MAX_PATH];
+	if (!GetModuleFileNameW(NULL, exePath, MAX_PATH))
+		RG_ERR_CLOSE("ChildProcess: Failed to get the path of our executable");
+
+	// CreateProcessW() can modify the command line, so it needs a copy
+	std::wstring cmdLine = GetCommandLineW();
+
+	// The child inherits our environment, so we share the variable until it is started
+	SetEnvironmentVariableA(envName.c_str(), envValue.c_str());
+
+	STARTUPINFOW startupInfo = {};
+	startupInfo.cb = sizeof(startupInfo);
+	PROCESS_INFORMATION procInfo = {};
+	BOOL created = CreateProcessW(exePath, cmdLine.data(), NULL, NULL, FALSE, 0, NULL, NULL, &startupInfo, &procInfo);
+
+	SetEnvironmentVariableA(envName.c_str(), NULL);
+
+	if (!created)
+		RG_ERR_CLOSE("ChildProcess: Failed to start a copy of our executable (error " << GetLastError() << ")");
+
+	CloseHandle(procInfo.hThread);
+	_handle = procInfo.hProcess;
+	pid = procInfo.dwProcessId;
+#elif defined(__linux__)
+	// Our arguments are null-separated
+	std::vector<std::string> args = {};
+	{
+		std::ifstream cmdLineStream = std::ifstream("/proc/self/cmdline", std::ios::binary);
+		std::string arg;
+		while (std::getline(cmdLineStream, arg, '\0'))
+			args.push_back(arg);
+	}
+
+	if (args.empty())
+		RG_ERR_CLOSE("ChildProcess: Failed to read our arguments from /proc/self/cmdline");
+
+	std::vector<char*> argv = {};
+	for (auto& arg : args)
+		argv.push_back(arg.data());
+	argv.push_back(NULL);
+
+	std::string envEntry = envName + "=" + envValue;
+	std::vector<char*> envp = {};
+	for (char** itr = environ; *itr; itr++)
+		if (strncmp(*itr, envEntry.c_str(), envName.size() + 1) != 0)
+			envp.push_back(*itr);
+	envp.push_back(envEntry.data());
+	envp.push_back(NULL);
+
+	pid_t childPid;
+	int error = posix_spawn(&childPid, "/proc/self/exe", NULL, NULL, argv.data(), envp.data());
+	if (error != 0)
+		RG_ERR_CLOSE("ChildProcess: Failed to start a copy of our executable (error " << error << ")");
+
+	pid = childPid;
+#else
+	RG_ERR_CLOSE("ChildProcess: Starting a copy of our executable is only supported on Linux and Windows");
+#endif
+}
+
+bool RLGPC::ChildProcess::IsRunning() {
+	return pid != -1 && !Wait(0);
+}
+
+bool RLGPC::ChildProcess::Wait(int timeoutMS) {
+	if (pid == -1 || _exited)
+		return true;
+
+#ifdef _WIN32
+	_exited = WaitForSingleObject(_handle, timeoutMS < 0 ? INFINITE : (DWORD)timeoutMS) == WAIT_OBJECT_0;
+#else
+	// waitpid() can't time out, so poll it
+	auto startTime = std::chrono::steady_clock::now();
+	while (true) {
+		int status;
+		pid_t result = waitpid((pid_t)pid, &status, WNOHANG);
+		if (result == (pid_t)pid || result == -1) {
+			_exited = true;
+			break;
+		}
+
+		if (timeoutMS >= 0 && std::chrono::steady_clock::now() - startTime >= std::chrono::milliseconds(timeoutMS))
+			break;
+
+		RG_SLEEP(10);
+	}
+#endif
+	return _exited;
+}
+
+void RLGPC::ChildProcess::Kill() {
+	if (pid == -1 || _exited)
+		return;
+
+#ifdef _WIN32
+	TerminateProcess(_handle, 1);
+#else
+	kill((pid_t)pid, SIGKILL);
+#endif
+	Wait();
+}
+
+RLGPC::ChildProcess::~ChildProcess() {
+	Kill();
+#ifdef _WIN32
+	if (_handle)
+		CloseHandle(_handle);
+#endif
+}
\ No newline at end of file
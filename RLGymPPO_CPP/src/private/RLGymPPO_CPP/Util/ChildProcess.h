@@ -0,0 +1,30 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Another instance of our own executable, started with the same arguments
+	// The child is told apart from us by the environment variable we add, so it needs to check for it before doing anything else
+	// NOTE: Only Linux and Windows can find their own executable and arguments, other platforms close on SpawnSelf()
+	class ChildProcess {
+	public:
+		int64_t pid = -1;
+
+		ChildProcess() = default;
+		RG_NO_COPY(ChildProcess);
+
+		// Closes if the process can't be started
+		void SpawnSelf(const std::string& envName, const std::string& envValue);
+
+		bool IsRunning();
+
+		// Blocks until the process exits, or timeoutMS passes (-1 for no limit), returns false on timeout
+		bool Wait(int timeoutMS = -1);
+
+		void Kill();
+
+		~ChildProcess();
+
+		void* _handle = NULL; // Windows only
+		bool _exited = false;
+	};
+}
\ No newline at end of file
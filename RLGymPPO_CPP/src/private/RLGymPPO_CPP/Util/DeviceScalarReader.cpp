@@ -0,0 +1,67 @@
+#include "DeviceScalarReader.h"
+
+#ifdef RG_CUDA_EVENTS
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDAGuard.h>
+
+struct RLGPC::DeviceScalarReader::_Impl {
+	int deviceIndex;
+	at::cuda::CUDAEvent event;
+	torch::Tensor pinned;
+
+	_Impl(int deviceIndex) : deviceIndex(deviceIndex), event(cudaEventDisableTiming) {
+		pinned = torch::empty({}, torch::TensorOptions().dtype(torch::kFloat).pinned_memory(true));
+	}
+};
+#else
+struct RLGPC::DeviceScalarReader::_Impl {};
+#endif
+
+RLGPC::DeviceScalarReader::DeviceScalarReader(torch::Device device) : device(device) {
+#ifdef RG_CUDA_EVENTS
+	if (device.is_cuda())
+		_impl = new _Impl(device.has_index() ? device.index() : 0);
+#endif
+}
+
+RLGPC::DeviceScalarReader::~DeviceScalarReader() {
+	delete _impl;
+}
+
+void RLGPC::DeviceScalarReader::Start(torch::Tensor value) {
+	RG_NOGRAD;
+	_pending = true;
+
+#ifdef RG_CUDA_EVENTS
+	if (_impl) {
+		c10::cuda::CUDAGuard guard = c10::cuda::CUDAGuard(_impl->deviceIndex);
+		_impl->pinned.copy_(value.detach().to(torch::kFloat).reshape({}), true);
+		_impl->event.record();
+		return;
+	}
+#endif
+
+	_value = value.detach();
+}
+
+bool RLGPC::DeviceScalarReader::Poll(float& outValue) {
+	if (!_pending)
+		return false;
+
+#ifdef RG_CUDA_EVENTS
+	if (_impl) {
+		if (!_impl->event.query())
+			return false;
+
+		outValue = _impl->pinned.item<float>();
+		_pending = false;
+		return true;
+	}
+#endif
+
+	// On the CPU this doesn't wait for anything
+	outValue = _value.item<float>();
+	_value = {};
+	_pending = false;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <RLGymPPO_CPP/FrameworkTorch.h>
+
+namespace RLGPC {
+	// Reads a scalar back from a device without waiting for it, by copying it into pinned memory and checking an event
+	// Values on the CPU are ready immediately
+	// Without RG_CUDA_EVENTS, reading from a CUDA device waits for it instead
+	class DeviceScalarReader {
+	public:
+		torch::Device device;
+
+		DeviceScalarReader(torch::Device device);
+		RG_NO_COPY(DeviceScalarReader);
+		~DeviceScalarReader();
+
+		// Starts reading a scalar tensor on our device
+		void Start(torch::Tensor value);
+
+		// If a read was started and has not been taken yet
+		bool IsPending() const { return _pending; }
+
+		// Returns true and takes the value once the last started read is done
+		bool Poll(float& outValue);
+
+		// Forgets the read in progress, if there is one
+		void Discard() {
+			_pending = false;
+			_value = {};
+		}
+
+		bool _pending = false;
+		torch::Tensor _value;
+
+		// Holds the CUDA event, so that CUDA headers are only needed by our source file
+		struct _Impl;
+		_Impl* _impl = NULL;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Allocator for containers whose memory should be backed by huge pages (see HugePageMode)
+	// Allocations smaller than half a huge page still use the heap, as rounding them up would waste most of the page
+	template <typename T>
+	struct HugePageAllocator {
+		using value_type = T;
+
+		// Containers take the allocator of whatever they are assigned from, so that memory is always freed the same way it was allocated
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		HugePageMode mode = HugePageMode::NONE;
+
+		HugePageAllocator() = default;
+		HugePageAllocator(HugePageMode mode) : mode(mode) {}
+
+		template <typename U>
+		HugePageAllocator(const HugePageAllocator<U>& other) : mode(other.mode) {}
+
+		bool UsesHugePages(size_t amount) const {
+			return mode != HugePageMode::NONE && amount * sizeof(T) >= HugePages::PAGE_SIZE / 2;
+		}
+
+		T* allocate(size_t amount) {
+			if (!UsesHugePages(amount))
+				return std::allocator<T>().allocate(amount);
+
+			void* result = HugePages::Alloc(amount * sizeof(T), mode);
+			if (!result)
+				throw std::bad_alloc();
+			return (T*)result;
+		}
+
+		void deallocate(T* ptr, size_t amount) {
+			if (UsesHugePages(amount)) {
+				HugePages::Free(ptr, amount * sizeof(T));
+			} else {
+				std::allocator<T>().deallocate(ptr, amount);
+			}
+		}
+
+		template <typename U>
+		bool operator==(const HugePageAllocator<U>& other) const {
+			return mode == other.mode;
+		}
+	};
+
+	// Float list that can be backed by huge pages
+	typedef std::vector<float, HugePageAllocator<float>> HugeFList;
+}
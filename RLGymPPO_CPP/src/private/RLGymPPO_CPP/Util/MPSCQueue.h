@@ -0,0 +1,60 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Lock-free unbounded queue with any amount of producers and a single consumer
+	// Producers only do one atomic exchange to push, so they never wait on each other or the consumer
+	// https://www.1024cores.net/home/lock-free-algorithms/queues/non-intrusive-mpsc-node-based-queue
+	template <typename T>
+	class MPSCQueue {
+	public:
+		struct Node {
+			std::atomic<Node*> next = NULL;
+			T value;
+		};
+
+		std::atomic<Node*> head; // Last pushed node, producers push after this
+		Node* tail; // Only used by the consumer, its next node is the next to pop
+
+		MPSCQueue() {
+			Node* stub = new Node();
+			head = stub;
+			tail = stub;
+		}
+
+		RG_NO_COPY(MPSCQueue);
+
+		// Can be called from any thread
+		void Push(T value) {
+			Node* node = new Node();
+			node->value = std::move(value);
+			Node* prev = head.exchange(node, std::memory_order_acq_rel);
+			prev->next.store(node, std::memory_order_release);
+		}
+
+		// Consumer only
+		// Returns false if empty, or if the only pushed value is still being linked in by its producer
+		bool Pop(T& out) {
+			Node* next = tail->next.load(std::memory_order_acquire);
+			if (!next)
+				return false;
+
+			// The popped node becomes the new stub
+			out = std::move(next->value);
+			delete tail;
+			tail = next;
+			return true;
+		}
+
+		// Consumer only
+		bool IsEmpty() const {
+			return tail->next.load(std::memory_order_acquire) == NULL;
+		}
+
+		~MPSCQueue() {
+			T temp;
+			while (Pop(temp));
+			delete tail;
+		}
+	};
+}
\ No newline at end of file
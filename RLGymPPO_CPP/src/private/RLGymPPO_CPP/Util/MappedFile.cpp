@@ -0,0 +1,127 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+RLGPC::MappedFile::MappedFile(std::filesystem::path path, const char* errorPrefix) : path(path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		RG_ERR_CLOSE(errorPrefix << "Failed to open " << path);
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	size = fileSize.QuadPart;
+
+	if (size > 0) {
+		_handle = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (_handle)
+			data = (const uint8_t*)MapViewOfFile(_handle, FILE_MAP_READ, 0, 0, 0);
+	}
+	CloseHandle(file);
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file == -1)
+		RG_ERR_CLOSE(errorPrefix << "Failed to open " << path);
+
+	struct stat fileStat;
+	fstat(file, &fileStat);
+	size = fileStat.st_size;
+
+	if (size > 0) {
+		void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (map != MAP_FAILED)
+			data = (const uint8_t*)map;
+	}
+	close(file); // The mapping stays valid
+#endif
+
+	if (!data)
+		RG_ERR_CLOSE(errorPrefix << "Failed to map " << path << " (" << size << " bytes)");
+}
+
+RLGPC::MappedFile::~MappedFile() {
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (_handle)
+		CloseHandle(_handle);
+#else
+	if (data)
+		munmap((void*)data, size);
+#endif
+}
+
+RLGPC::SpillFile::SpillFile(std::filesystem::path folder, uint64_t size, const char* errorPrefix) : size(size) {
+	std::filesystem::create_directories(folder);
+
+#ifdef _WIN32
+	// Named after our process and this object, so that spill files of other learners never collide
+	std::filesystem::path path = folder / ("spill_" + std::to_string(GetCurrentProcessId()) + "_" + std::to_string((uintptr_t)this) + ".bin");
+	HANDLE file = CreateFileW(
+		path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL
+	);
+	if (file == INVALID_HANDLE_VALUE)
+		RG_ERR_CLOSE(errorPrefix << "Failed to create a spill file in " << folder);
+
+	_handle = CreateFileMappingW(file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+	if (_handle)
+		data = (uint8_t*)MapViewOfFile(_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	CloseHandle(file); // The file is deleted once the mapping is closed too
+#else
+	std::string pathTemplate = (folder / "spill_XXXXXX").string();
+	int file = mkstemp(pathTemplate.data());
+	if (file == -1)
+		RG_ERR_CLOSE(errorPrefix << "Failed to create a spill file in " << folder);
+
+	// The file's space is freed once nothing has it open or mapped
+	unlink(pathTemplate.c_str());
+
+	if (ftruncate(file, size) == 0) {
+		void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		if (map != MAP_FAILED) {
+			data = (uint8_t*)map;
+			madvise(map, size, MADV_RANDOM);
+		}
+	}
+	close(file); // The mapping stays valid
+#endif
+
+	if (!data)
+		RG_ERR_CLOSE(errorPrefix << "Failed to map a spill file of " << size << " bytes in " << folder);
+}
+
+RLGPC::SpillFile::~SpillFile() {
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (_handle)
+		CloseHandle(_handle);
+#else
+	if (data)
+		munmap(data, size);
+#endif
+}
+
+void RLGPC::SpillFile::Prefetch(const void* ptr, uint64_t bytes) {
+	if (bytes == 0)
+		return;
+
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range = { (void*)ptr, (SIZE_T)bytes };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// Ranges have to start on a page
+	uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)ptr & ~(pageSize - 1);
+	madvise((void*)start, (uintptr_t)ptr + bytes - start, MADV_WILLNEED);
+#endif
+}
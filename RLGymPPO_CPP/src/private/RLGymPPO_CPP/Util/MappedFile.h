@@ -0,0 +1,42 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Read-only memory mapping of a whole file
+	// Pages are only read from disk once they are used, so files much larger than our memory can be mapped
+	class MappedFile {
+	public:
+		std::filesystem::path path;
+		const uint8_t* data = NULL;
+		uint64_t size = 0;
+
+		// Closes if the file can't be opened or mapped, errors start with errorPrefix
+		MappedFile(std::filesystem::path path, const char* errorPrefix = "MappedFile: ");
+		RG_NO_COPY(MappedFile);
+
+		~MappedFile();
+
+		void* _handle = NULL; // Windows only
+	};
+
+	// Read-write memory mapping of a new file in a folder, which is deleted once unmapped (or if we crash)
+	// Recently used pages stay in memory, and the OS writes the rest out to the file once it needs the memory, so this can be much larger than our memory
+	// Pages are not read ahead on their own, as rows are read in random order, use Prefetch() to read the rows that will be needed
+	class SpillFile {
+	public:
+		uint8_t* data = NULL;
+		uint64_t size = 0;
+
+		// Closes if the file can't be created or mapped, errors start with errorPrefix
+		// The file reads as zeros until written
+		SpillFile(std::filesystem::path folder, uint64_t size, const char* errorPrefix = "SpillFile: ");
+		RG_NO_COPY(SpillFile);
+
+		~SpillFile();
+
+		// Hints that [ptr, ptr + bytes) of a spill file will be read soon, so that the OS starts reading it from disk in one large read
+		static void Prefetch(const void* ptr, uint64_t bytes);
+
+		void* _handle = NULL; // Windows only
+	};
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "MemoryInfo.h"
+
+#include <torch/cuda.h>
+#ifdef RG_CUDA_EVENTS
+#include <c10/cuda/CUDACachingAllocator.h>
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+int64_t RLGPC::MemoryInfo::GetProcessRSS() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.WorkingSetSize;
+	return 0;
+#else
+	// Second value is the resident page count
+	std::ifstream statmStream = std::ifstream("/proc/self/statm");
+	int64_t totalPages = 0, residentPages = 0;
+	if (!(statmStream >> totalPages >> residentPages))
+		return 0;
+	return residentPages * sysconf(_SC_PAGESIZE);
+#endif
+}
+
+int64_t RLGPC::MemoryInfo::GetPeakProcessRSS() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+	return 0;
+#else
+	rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss; // In bytes
+#else
+	return usage.ru_maxrss * 1024; // In KB
+#endif
+#endif
+}
+
+RLGPC::MemoryInfo::CUDAMemory RLGPC::MemoryInfo::GetCUDAMemory() {
+	CUDAMemory result = {};
+#ifdef RG_CUDA_EVENTS
+	if (!torch::cuda::is_available())
+		return result;
+
+	using namespace c10::cuda::CUDACachingAllocator;
+	for (int i = 0; i < torch::cuda::device_count(); i++) {
+		auto stats = getDeviceStats(i);
+		auto& allocated = stats.allocated_bytes[(size_t)StatType::AGGREGATE];
+		auto& reserved = stats.reserved_bytes[(size_t)StatType::AGGREGATE];
+		result.allocated += allocated.current;
+		result.reserved += reserved.current;
+		result.peakAllocated += allocated.peak;
+		result.peakReserved += reserved.peak;
+	}
+#endif
+	return result;
+}
+
+void RLGPC::MemoryInfo::EmptyCUDACache() {
+#ifdef RG_CUDA_EVENTS
+	if (torch::cuda::is_available())
+		c10::cuda::CUDACachingAllocator::emptyCache();
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Memory use of this process, all sizes are in bytes and 0 if unknown
+	namespace MemoryInfo {
+		// Memory of this process that is currently in RAM
+		int64_t GetProcessRSS();
+
+		// Highest RSS of this process so far
+		int64_t GetPeakProcessRSS();
+
+		// Of the CUDA caching allocator, summed over all devices
+		// All 0 if libtorch was built without CUDA (see RG_CUDA_EVENTS)
+		struct CUDAMemory {
+			int64_t allocated, reserved;
+			int64_t peakAllocated, peakReserved;
+		};
+		CUDAMemory GetCUDAMemory();
+
+		// Returns cached blocks that aren't in use back to the CUDA driver, does nothing without RG_CUDA_EVENTS
+		void EmptyCUDACache();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "MemoryPlanner.h"
+
+using namespace RLGPC;
+
+// Memory of one arena with 4 cars, from the measurements in ArenaMemWeightMode
+// ULTRALIGHT isn't measured, it is somewhat below LIGHT
+int64_t _GetArenaBytes(ArenaMemWeightMode mode) {
+	switch (mode) {
+	case ArenaMemWeightMode::HEAVY:
+		return 1263 * 1024;
+	case ArenaMemWeightMode::LIGHT:
+		return 383 * 1024;
+	default:
+		return 256 * 1024;
+	}
+}
+
+// Parameters of Linear layers from inputs through each layer size, then to outputs
+int64_t _GetMLPParams(int inputs, const IList& layerSizes, int outputs) {
+	int64_t params = 0;
+	int prevSize = inputs;
+	for (int size : layerSizes) {
+		params += (int64_t)(prevSize + 1) * size;
+		prevSize = size;
+	}
+	return params + (int64_t)(prevSize + 1) * outputs;
+}
+
+int64_t _Sum(const IList& values) {
+	int64_t sum = 0;
+	for (int value : values)
+		sum += value;
+	return sum;
+}
+
+MemoryPlanner::Estimate MemoryPlanner::MakeEstimate(const LearnerConfig& config, const Inputs& inputs) {
+	Estimate estimate = {};
+	auto& ppo = config.ppo;
+	int obsSize = inputs.obsSize;
+
+	int64_t numGames = (int64_t)config.numThreads * config.numGamesPerThread;
+	int64_t arenaBytes = _GetArenaBytes(inputs.arenaMode) * RS_MAX(inputs.carsPerGame, 4) / 4;
+	// Each game also has two game states and its observations
+	int64_t gameBytes = (int64_t)inputs.playersPerGame * (obsSize * sizeof(float) + 1024);
+	estimate.arenas = numGames * (arenaBytes + gameBytes);
+
+	// Agents store up to 1.5x timestepsPerIteration in their rollouts, which are then concatenated into one more copy
+	// Each player-step has its observation, then an action, log prob, reward, done, value, and policy version, then a learned byte
+	int64_t stepBytes = obsSize * sizeof(float) + 6 * sizeof(float) + 1;
+	estimate.trajectories = (int64_t)(config.timestepsPerIteration * 2.5) * stepBytes;
+
+	// Columns of ExperienceTensors, actions are the narrowest integer type that fits
+	int64_t obsBytes = (config.expBufferOBSType == OBSStorageType::FLOAT) ? 4 : 2;
+	int64_t actionBytes = (inputs.actionAmount <= INT8_MAX) ? 1 : ((inputs.actionAmount <= INT16_MAX) ? 2 : 4);
+	// Every policy has its own buffer and models (see LearnerConfig::playerPolicyIDs and LearnerConfig::gamePolicyConfigs)
+	int64_t numPolicies = config.gamePolicyConfigs.size() + 1;
+	for (int id : config.playerPolicyIDs)
+		numPolicies = RS_MAX(numPolicies, (int64_t)id + 1);
+
+	int64_t rowBytes = obsSize * obsBytes + actionBytes + 2 /* dones, truncateds */ + 5 * sizeof(float) /* log probs, rewards, values, advantages, IS weights */;
+	estimate.expBuffer = numPolicies * config.expBufferSize * rowBytes;
+	estimate.expBufferOnDevice = config.expBufferOnDevice && inputs.learnOnCUDA;
+	if (!config.expBufferSpillFolder.empty() && !estimate.expBufferOnDevice)
+		estimate.expBuffer = 0; // Only uses memory the OS can take back (see LearnerConfig::expBufferSpillFolder)
+
+	int64_t policyParams = _GetMLPParams(obsSize, ppo.policyLayerSizes, inputs.actionAmount);
+	int64_t criticParams = ppo.sharedTrunk ?
+		_GetMLPParams(ppo.policyLayerSizes.back(), ppo.criticHeadLayerSizes, 1) :
+		_GetMLPParams(obsSize, ppo.criticLayerSizes, 1);
+	int64_t params = policyParams + criticParams;
+
+	// Full precision parameters and gradients, plus the half-precision copies and inference buffers of the policy
+	estimate.models = numPolicies * params * 2 * sizeof(float);
+	if (ppo.halfPrecModels)
+		estimate.models += numPolicies * params * 2;
+	if (config.inferencePolicyBuffers)
+		estimate.models += policyParams * 2 * (ppo.halfPrecModels ? 2 : sizeof(float));
+	estimate.models += (int64_t)config.opponentPoolSize * policyParams * sizeof(float);
+	estimate.optimizer = numPolicies * params * 2 * sizeof(float); // Adam's two moments
+	estimate.modelsOnDevice = inputs.learnOnCUDA;
+
+	// Each hidden layer's output is kept for backward, along with its gradient and a temporary
+	int64_t miniBatchSize = (ppo.miniBatchSize > 0 ? ppo.miniBatchSize : ppo.batchSize) / RS_MAX(ppo.numGPUs, 1);
+	int64_t hiddenWidth = _Sum(ppo.policyLayerSizes) + (ppo.sharedTrunk ? _Sum(ppo.criticHeadLayerSizes) : _Sum(ppo.criticLayerSizes));
+	if (ppo.activationCheckpointLayers > 0)
+		hiddenWidth /= ppo.activationCheckpointLayers;
+	int64_t activationBytes = ppo.autocastLearn ? 2 : sizeof(float);
+	int64_t miniBatchRowBytes = (obsSize + inputs.actionAmount * 3 + 8) * sizeof(float);
+	estimate.activations = miniBatchSize * (miniBatchRowBytes + hiddenWidth * 3 * activationBytes);
+
+	int64_t evalRows = (config.criticEvalChunkSize > 0) ? RS_MIN(config.criticEvalChunkSize, config.timestepsPerIteration) : config.timestepsPerIteration;
+	int64_t evalWidth = ppo.sharedTrunk ? _Sum(ppo.policyLayerSizes) : _Sum(ppo.criticLayerSizes);
+	estimate.criticEval = evalRows * (obsSize + evalWidth * 2) * sizeof(float);
+
+	// Everything of the models lives on the learning device
+	estimate.hostTotal = estimate.arenas + estimate.trajectories;
+	int64_t deviceBytes = estimate.models + estimate.optimizer + estimate.activations + estimate.criticEval;
+	(estimate.modelsOnDevice ? estimate.deviceTotal : estimate.hostTotal) += deviceBytes;
+	(estimate.expBufferOnDevice ? estimate.deviceTotal : estimate.hostTotal) += estimate.expBuffer;
+	return estimate;
+}
+
+double _ToMB(int64_t bytes) {
+	return bytes / (1024.0 * 1024.0);
+}
+
+void MemoryPlanner::FitBudget(LearnerConfig& config, const Inputs& inputs) {
+	auto& budget = config.memoryBudget;
+	if (budget.headroom < 0 || budget.headroom >= 1)
+		RG_ERR_CLOSE("Learner::Learner(): config.memoryBudget.headroom must be from 0 to 1 (got " << budget.headroom << ")");
+
+	constexpr double BYTES_PER_GB = 1024.0 * 1024.0 * 1024.0;
+	int64_t hostLimit = (budget.hostGB > 0) ? (int64_t)(budget.hostGB * (1 - budget.headroom) * BYTES_PER_GB) : INT64_MAX;
+	int64_t deviceLimit = (budget.deviceGB > 0 && inputs.learnOnCUDA) ? (int64_t)(budget.deviceGB * (1 - budget.headroom) * BYTES_PER_GB) : INT64_MAX;
+
+	struct Step {
+		const char* name;
+		bool forDevice; // Otherwise it saves host memory
+		// Scales the config back once, returns false if it can't be scaled back any further
+		std::function<bool(LearnerConfig&)> fnApply;
+		// Current value of what it scales back, for logging
+		std::function<int64_t(const LearnerConfig&)> fnGetValue;
+	};
+
+	// Ordered by how much speed each costs, cheapest first
+	std::vector<Step> steps = {
+		{ "criticEvalChunkSize", true, [](LearnerConfig& config) {
+			if (config.criticEvalChunkSize > 0)
+				return false;
+			config.criticEvalChunkSize = 16 * 1024;
+			return true;
+		}, [](const LearnerConfig& config) { return (int64_t)config.criticEvalChunkSize; }},
+		{ "expBufferOnDevice", true, [](LearnerConfig& config) {
+			if (!config.expBufferOnDevice)
+				return false;
+			config.expBufferOnDevice = false;
+			return true;
+		}, [](const LearnerConfig& config) { return (int64_t)config.expBufferOnDevice; }},
+		{ "ppo.miniBatchSize", true, [&budget](LearnerConfig& config) {
+			int64_t& miniBatchSize = config.ppo.miniBatchSize;
+			int64_t curSize = (miniBatchSize > 0) ? miniBatchSize : config.ppo.batchSize;
+			int64_t newSize = curSize / 2;
+			if (newSize < budget.minMiniBatchSize || (curSize % 2) != 0 || (config.ppo.batchSize % newSize) != 0)
+				return false;
+			miniBatchSize = newSize;
+			return true;
+		}, [](const LearnerConfig& config) { return (int64_t)config.ppo.miniBatchSize; }},
+		{ "ppo.activationCheckpointLayers", true, [](LearnerConfig& config) {
+			if (config.ppo.activationCheckpointLayers > 0)
+				return false;
+			config.ppo.activationCheckpointLayers = 2;
+			return true;
+		}, [](const LearnerConfig& config) { return (int64_t)config.ppo.activationCheckpointLayers; }},
+
+		{ "expBufferOBSType", false, [](LearnerConfig& config) {
+			if (config.expBufferOBSType != OBSStorageType::FLOAT)
+				return false;
+			config.expBufferOBSType = OBSStorageType::BF16;
+			return true;
+		}, [](const LearnerConfig& config) { return (int64_t)config.expBufferOBSType; }},
+		{ "expBufferSize", false, [](LearnerConfig& config) {
+			// Every iteration's steps still need to fit
+			int64_t minSize = RS_MAX(config.timestepsPerIteration, config.ppo.batchSize);
+			if (config.expBufferSize <= minSize)
+				return false;
+			config.expBufferSize = RS_MAX(config.expBufferSize * 3 / 4, minSize);
+			return true;
+		}, [](const LearnerConfig& config) { return (int64_t)config.expBufferSize; }},
+		{ "numGamesPerThread", false, [&budget](LearnerConfig& config) {
+			if (config.numGamesPerThread <= budget.minGamesPerThread)
+				return false;
+			config.numGamesPerThread = RS_MAX(config.numGamesPerThread * 3 / 4, budget.minGamesPerThread);
+			return true;
+		}, [](const LearnerConfig& config) { return (int64_t)config.numGamesPerThread; }},
+	};
+
+	RG_LOG("\tFitting memory budget (host: " << budget.hostGB << "GB, device: " << budget.deviceGB << "GB, " << (int)(budget.headroom * 100) << "% headroom)...");
+
+	Estimate estimate = MakeEstimate(config, inputs);
+	std::vector<std::string> changes = {};
+	for (auto& step : steps) {
+		int64_t oldValue = step.fnGetValue(config);
+		bool applied = false;
+		while (true) {
+			bool overBudget = step.forDevice ? (estimate.deviceTotal > deviceLimit) : (estimate.hostTotal > hostLimit);
+			if (!overBudget || !step.fnApply(config))
+				break;
+			applied = true;
+			estimate = MakeEstimate(config, inputs);
+		}
+
+		if (applied) {
+			std::stringstream changeStream;
+			changeStream << step.name << ": " << oldValue << " -> " << step.fnGetValue(config);
+			changes.push_back(changeStream.str());
+		}
+	}
+
+	RG_LOG("\t\tArenas: " << _ToMB(estimate.arenas) << "MB (host)");
+	RG_LOG("\t\tTrajectories: " << _ToMB(estimate.trajectories) << "MB (host)");
+	RG_LOG("\t\tExperience buffer: " << _ToMB(estimate.expBuffer) << "MB (" << (estimate.expBufferOnDevice ? "device" : "host") << ")");
+	const char* modelPlace = estimate.modelsOnDevice ? "device" : "host";
+	RG_LOG("\t\tModels: " << _ToMB(estimate.models) << "MB (" << modelPlace << ")");
+	RG_LOG("\t\tOptimizer: " << _ToMB(estimate.optimizer) << "MB (" << modelPlace << ")");
+	RG_LOG("\t\tActivations: " << _ToMB(estimate.activations) << "MB (" << modelPlace << ")");
+	RG_LOG("\t\tCritic evaluation: " << _ToMB(estimate.criticEval) << "MB (" << modelPlace << ")");
+	RG_LOG("\t\tTotal: " << _ToMB(estimate.hostTotal) << "MB host, " << _ToMB(estimate.deviceTotal) << "MB device");
+
+	if (changes.empty()) {
+		RG_LOG("\t\tConfig fits as-is");
+	} else {
+		RG_LOG("\t\tScaled back to fit:");
+		for (auto& change : changes)
+			RG_LOG("\t\t > " << change);
+	}
+
+	// Arenas are made by the env create function, so we can only suggest their mode
+	if (inputs.arenaMode == ArenaMemWeightMode::HEAVY && estimate.hostTotal > hostLimit / 2) {
+		int64_t savedBytes = (_GetArenaBytes(ArenaMemWeightMode::HEAVY) - _GetArenaBytes(ArenaMemWeightMode::LIGHT)) * (int64_t)config.numThreads * config.numGamesPerThread;
+		RG_LOG("\t\tNOTE: The test environment's arenas use ArenaMemWeightMode::HEAVY, LIGHT would save about " << _ToMB(savedBytes) << "MB");
+	}
+
+	if (estimate.hostTotal > hostLimit || estimate.deviceTotal > deviceLimit) {
+		RG_ERR_CLOSE(
+			"Learner::Learner(): Config doesn't fit config.memoryBudget, even after scaling everything back " <<
+			"(estimated " << _ToMB(estimate.hostTotal) << "MB host and " << _ToMB(estimate.deviceTotal) << "MB device, " <<
+			"with " << (int)(budget.headroom * 100) << "% of the " << budget.hostGB << "GB host and " << budget.deviceGB << "GB device budgets left as headroom)"
+		);
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <RLGymPPO_CPP/LearnerConfig.h>
+
+namespace RLGPC {
+	// Estimates the memory of each part of the learner, and fits its config into a memory budget (see LearnerConfig::memoryBudget)
+	// Only the big allocations that grow with the config are estimated, everything else is covered by MemoryBudgetConfig::headroom
+	namespace MemoryPlanner {
+		// What the estimate needs that isn't in the config
+		struct Inputs {
+			int obsSize, actionAmount;
+			int carsPerGame, playersPerGame;
+			ArenaMemWeightMode arenaMode;
+			bool learnOnCUDA;
+		};
+
+		// Bytes of each part, where each is depends on the config
+		struct Estimate {
+			int64_t
+				arenas = 0,
+				trajectories = 0,
+				expBuffer = 0,
+				models = 0, // Parameters, their gradients, and copies of them
+				optimizer = 0,
+				activations = 0, // Of a learning minibatch, including the minibatch itself
+				criticEval = 0; // Of inferring the critic's values for GAE
+
+			bool expBufferOnDevice = false;
+			bool modelsOnDevice = false;
+
+			int64_t hostTotal = 0, deviceTotal = 0;
+		};
+
+		Estimate MakeEstimate(const LearnerConfig& config, const Inputs& inputs);
+
+		// Scales back the config until its estimate fits config.memoryBudget, and logs the plan
+		// Stops with an error if it still doesn't fit once nothing else can be scaled back
+		void FitBudget(LearnerConfig& config, const Inputs& inputs);
+	}
+}
@@ -0,0 +1,26 @@
+#include "MetricFileWriter.h"
+
+#include "../libsrc/json/nlohmann/json.hpp"
+
+RLGPC::MetricFileWriter::MetricFileWriter(std::filesystem::path path, std::string runID) : path(path), runID(runID) {
+	if (path.has_parent_path())
+		std::filesystem::create_directories(path.parent_path());
+
+	stream = std::ofstream(path, std::ios::app);
+	if (!stream.good())
+		RG_ERR_CLOSE("MetricFileWriter: Failed to open metrics file at " << path);
+}
+
+void RLGPC::MetricFileWriter::Write(const Report& report) {
+	nlohmann::json j = {};
+	if (!runID.empty())
+		j["run_id"] = runID;
+	j["time"] = (int64_t)time(0);
+
+	for (auto& pair : report.data)
+		j[pair.first] = pair.second; // NAN values become null
+
+	stream << j.dump() << std::endl;
+	if (!stream.good())
+		RG_ERR_CLOSE("MetricFileWriter: Failed to write to metrics file at " << path);
+}
\ No newline at end of file
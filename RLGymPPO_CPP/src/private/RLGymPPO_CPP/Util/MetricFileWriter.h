@@ -0,0 +1,21 @@
+#pragma once
+#include <RLGymPPO_CPP/Util/Report.h>
+
+namespace RLGPC {
+	// Appends each report to a file as one line of JSON (JSONL), without needing Python
+	class MetricFileWriter {
+	public:
+		std::filesystem::path path;
+		std::ofstream stream;
+
+		// Added to every line, so multiple runs can share a file
+		std::string runID;
+
+		// Reports from a previous run in the same file are kept
+		MetricFileWriter(std::filesystem::path path, std::string runID);
+
+		void Write(const Report& report);
+
+		RG_NO_COPY(MetricFileWriter);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "MetricsHTTPServer.h"
+#include "MemoryInfo.h"
+
+void RLGPC::MetricsHTTPServer::Start() {
+	if (shouldRun)
+		return;
+
+	listenSocket = TCPSocket::Listen(port);
+	if (!listenSocket.IsOpen())
+		RG_ERR_CLOSE("MetricsHTTPServer: Failed to listen on port " << port);
+
+	RG_LOG("MetricsHTTPServer: Serving metrics at http://localhost:" << port << "/metrics");
+
+	shouldRun = true;
+	thread = std::thread(&MetricsHTTPServer::_Run, this);
+}
+
+void RLGPC::MetricsHTTPServer::Stop() {
+	if (!shouldRun)
+		return;
+
+	shouldRun = false;
+	listenSocket.Close();
+	thread.join();
+}
+
+std::string RLGPC::MetricsHTTPServer::MakeMetricName(const std::string& reportKey) {
+	std::string result = "rlgppo_";
+	bool lastUnderscore = true;
+	for (char c : reportKey) {
+		if (isalnum((unsigned char)c)) {
+			result += (char)tolower((unsigned char)c);
+			lastUnderscore = false;
+		} else if (!lastUnderscore) {
+			result += '_';
+			lastUnderscore = true;
+		}
+	}
+
+	if (result.back() == '_')
+		result.pop_back();
+	return result;
+}
+
+void _WriteValue(std::stringstream& stream, double val) {
+	if (isnan(val)) {
+		stream << "NaN";
+	} else if (isinf(val)) {
+		stream << (val > 0 ? "+Inf" : "-Inf");
+	} else {
+		stream << val;
+	}
+}
+
+void RLGPC::MetricsHTTPServer::Publish(const Report& report, const std::vector<Report>& agentReports) {
+	std::stringstream stream;
+	stream << std::setprecision(17);
+
+	for (auto& pair : report.data) {
+		std::string name = MakeMetricName(pair.first);
+		stream << "# TYPE " << name << " gauge\n";
+		stream << name << " ";
+		_WriteValue(stream, pair.second);
+		stream << "\n";
+	}
+
+	// Group the values of each agent under one metric
+	std::map<std::string, std::vector<std::pair<int, double>>> agentMetrics = {};
+	for (int i = 0; i < agentReports.size(); i++)
+		for (auto& pair : agentReports[i].data)
+			agentMetrics[MakeMetricName("Agent " + pair.first)].push_back({ i, pair.second });
+
+	for (auto& pair : agentMetrics) {
+		stream << "# TYPE " << pair.first << " gauge\n";
+		for (auto& agentVal : pair.second) {
+			stream << pair.first << "{agent=\"" << agentVal.first << "\"} ";
+			_WriteValue(stream, agentVal.second);
+			stream << "\n";
+		}
+	}
+
+	stream << "# TYPE process_resident_memory_bytes gauge\n";
+	stream << "process_resident_memory_bytes " << MemoryInfo::GetProcessRSS() << "\n";
+
+	std::atomic_store(&snapshot, std::make_shared<const std::string>(stream.str()));
+}
+
+void RLGPC::MetricsHTTPServer::_Run() {
+	constexpr size_t MAX_REQUEST_SIZE = 8 * 1024;
+
+	while (shouldRun) {
+		TCPSocket socket = listenSocket.Accept();
+		if (!socket.IsOpen())
+			continue;
+
+		// Scrapes are handled one at a time, so don't let a stuck client hold us up
+		socket.SetRecvTimeout(2);
+
+		// Read the request header
+		std::string request = {};
+		char buffer[1024];
+		while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE) {
+			size_t received = socket.RecvSome(buffer, sizeof(buffer));
+			if (received == 0)
+				break;
+			request.append(buffer, received);
+		}
+
+		// Only the request line matters, e.g. "GET /metrics HTTP/1.1"
+		std::string method, path;
+		std::stringstream(request.substr(0, request.find("\r\n"))) >> method >> path;
+
+		std::string status, contentType, body;
+		if (method != "GET") {
+			status = "405 Method Not Allowed";
+		} else if (path == "/metrics" || path == "/") {
+			status = "200 OK";
+			contentType = "text/plain; version=0.0.4; charset=utf-8";
+			body = *std::atomic_load(&snapshot);
+		} else if (path == "/profile" && fnStartProfile) {
+			if (fnStartProfile()) {
+				status = "202 Accepted";
+				body = "Profile started\n";
+			} else {
+				status = "409 Conflict";
+				body = "A profile is already running\n";
+			}
+		} else {
+			status = "404 Not Found";
+		}
+
+		std::stringstream response;
+		response << "HTTP/1.1 " << status << "\r\n";
+		if (!contentType.empty())
+			response << "Content-Type: " << contentType << "\r\n";
+		response << "Content-Length: " << body.size() << "\r\n";
+		response << "Connection: close\r\n\r\n";
+		response << body;
+
+		std::string responseStr = response.str();
+		socket.SendAll(responseStr.data(), responseStr.size());
+	}
+}
\ No newline at end of file
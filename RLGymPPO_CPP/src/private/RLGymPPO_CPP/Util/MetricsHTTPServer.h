@@ -0,0 +1,43 @@
+#pragma once
+#include "TCPSocket.h"
+#include <RLGymPPO_CPP/Util/Report.h>
+#include <memory>
+
+namespace RLGPC {
+	// Serves the latest published metrics over HTTP, in the Prometheus/OpenMetrics text format
+	// Metrics are rendered when published, so scraping only copies out the last snapshot and never waits on the learner
+	class MetricsHTTPServer {
+	public:
+		int port;
+
+		TCPSocket listenSocket;
+		std::thread thread;
+		std::atomic<bool> shouldRun = false;
+
+		// Full response body, only accessed through std::atomic_load() and std::atomic_store()
+		std::shared_ptr<const std::string> snapshot = std::make_shared<const std::string>();
+
+		// If set, a GET of /profile calls this from our thread, which returns false if a profile is already running
+		std::function<bool()> fnStartProfile = NULL;
+
+		MetricsHTTPServer(int port) : port(port) {}
+
+		RG_NO_COPY(MetricsHTTPServer);
+
+		void Start();
+		void Stop();
+
+		// Every entry of report becomes a gauge, named like "rlgppo_" + its lowercase name with non-alphanumeric characters as underscores
+		// Each report in agentReports is the same, but with an "agent" label of its index
+		// The resident memory of this process is also added
+		void Publish(const Report& report, const std::vector<Report>& agentReports);
+
+		static std::string MakeMetricName(const std::string& reportKey);
+
+		void _Run();
+
+		~MetricsHTTPServer() {
+			Stop();
+		}
+	};
+}
\ No newline at end of file
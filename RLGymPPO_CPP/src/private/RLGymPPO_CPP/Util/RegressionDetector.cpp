@@ -0,0 +1,60 @@
+#include "RegressionDetector.h"
+
+bool RLGPC::RegressionDetector::GetValue(const Report& report, const std::string& metric, bool isTime, double& outVal) const {
+	if (!report.Has(metric))
+		return false;
+
+	if (isTime) {
+		if (!report.Has("Timesteps Collected") || report["Timesteps Collected"] <= 0)
+			return false;
+		outVal = report[metric] / report["Timesteps Collected"];
+	} else {
+		outVal = report[metric];
+	}
+
+	return std::isfinite(outVal);
+}
+
+double RLGPC::RegressionDetector::GetBaseline(const std::string& metric) const {
+	auto itr = baselineValues.find(metric);
+	if (itr == baselineValues.end() || itr->second.size() < RS_MAX(config.minBaselineIterations, 1))
+		return NAN;
+
+	// Median, so that single slow iterations (e.g. ones that saved a checkpoint) don't move it
+	std::vector<double> sorted = std::vector<double>(itr->second.begin(), itr->second.end());
+	std::sort(sorted.begin(), sorted.end());
+	return sorted[sorted.size() / 2];
+}
+
+std::vector<RLGPC::RegressionDetector::Regression> RLGPC::RegressionDetector::Update(const Report& report) {
+	std::vector<Regression> result = {};
+
+	iterations++;
+	if (iterations <= config.warmupIterations)
+		return result;
+
+	for (int i = 0; i < 2; i++) {
+		bool isTime = (i == 1);
+		for (auto& metric : isTime ? config.timeMetrics : config.rateMetrics) {
+			double value;
+			if (!GetValue(report, metric, isTime, value))
+				continue;
+
+			double baseline = GetBaseline(metric);
+			if (!isnan(baseline) && baseline > 0) {
+				double change = isTime ? (value / baseline - 1) : (1 - value / baseline);
+				if (change > config.threshold) {
+					result.push_back({ metric, value, baseline, change });
+					continue; // Regressed values would drag the baseline along with them
+				}
+			}
+
+			auto& values = baselineValues[metric];
+			values.push_back(value);
+			while (values.size() > RS_MAX(config.baselineIterations, 1))
+				values.pop_front();
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <RLGymPPO_CPP/RegressionWatchConfig.h>
+#include <RLGymPPO_CPP/Util/Report.h>
+
+namespace RLGPC {
+	// Keeps rolling baselines of some metrics, and finds iterations where they regress (see RegressionWatchConfig)
+	class RegressionDetector {
+	public:
+		RegressionWatchConfig config;
+
+		struct Regression {
+			std::string metric;
+			double value, baseline;
+			double change; // Relative to the baseline, positive is worse
+		};
+
+		// Recent values of each metric that didn't regress, oldest first
+		std::map<std::string, std::deque<double>> baselineValues = {};
+		int iterations = 0;
+
+		RegressionDetector(const RegressionWatchConfig& config) : config(config) {}
+
+		// Value of a watched metric in a report, per collected timestep for times
+		// Returns false if the report doesn't have it
+		bool GetValue(const Report& report, const std::string& metric, bool isTime, double& outVal) const;
+
+		// NAN if the metric doesn't have enough iterations in its baseline yet
+		double GetBaseline(const std::string& metric) const;
+
+		// Compares the metrics of an iteration to their baselines, then adds the ones that didn't regress to them
+		std::vector<Regression> Update(const Report& report);
+	};
+}
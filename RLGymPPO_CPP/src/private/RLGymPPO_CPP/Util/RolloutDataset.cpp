@@ -0,0 +1,280 @@
+#include "RolloutDataset.h"
+
+using namespace RLGPC;
+
+typedef RolloutRecorder::ChunkHeader _ChunkHeader;
+typedef RolloutRecorder::ColumnHeader _ColumnHeader;
+
+// Returns the end of the chunk at offset, or 0 if it isn't a complete chunk (e.g. the last chunk of a file that was still being written)
+uint64_t _GetChunkEnd(const MappedFile* file, uint64_t offset, _ChunkHeader& outHeader) {
+	if (offset + sizeof(_ChunkHeader) > file->size)
+		return 0;
+
+	memcpy(&outHeader, file->data + offset, sizeof(_ChunkHeader));
+	if (outHeader.magic != RolloutRecorder::CHUNK_MAGIC)
+		return 0;
+
+	uint64_t pos = offset + sizeof(_ChunkHeader);
+	for (uint32_t i = 0; i < outHeader.columnAmount; i++) {
+		if (pos + sizeof(_ColumnHeader) > file->size)
+			return 0;
+
+		_ColumnHeader column;
+		memcpy(&column, file->data + pos, sizeof(column));
+		pos += sizeof(column) + column.storedSize;
+		if (pos > file->size)
+			return 0;
+	}
+	return pos;
+}
+
+RLGPC::RolloutDataset::RolloutDataset(const std::vector<std::filesystem::path>& paths, int numWorkers, uint64_t windowSize, uint64_t seed, int maxDecodedChunks) :
+	numWorkers(RS_MAX(numWorkers, 1)), windowSize(windowSize), maxDecodedChunks(RS_MAX(maxDecodedChunks, 1)), rng(seed) {
+
+	for (auto& path : paths) {
+		if (std::filesystem::is_directory(path)) {
+			// Sorted, so that the dataset is the same on every platform
+			std::vector<std::filesystem::path> folderFiles = {};
+			for (auto& entry : std::filesystem::directory_iterator(path))
+				if (entry.is_regular_file())
+					folderFiles.push_back(entry.path());
+			std::sort(folderFiles.begin(), folderFiles.end());
+
+			for (auto& filePath : folderFiles)
+				_AddFile(filePath);
+		} else {
+			_AddFile(path);
+		}
+	}
+
+	if (chunks.empty())
+		RG_ERR_CLOSE("RolloutDataset: No recorded steps found");
+}
+
+void RLGPC::RolloutDataset::_AddFile(std::filesystem::path path) {
+	constexpr const char* ERROR_PREFIX = "RolloutDataset: ";
+
+	MappedFile* file = new MappedFile(path, ERROR_PREFIX);
+	files.push_back(file);
+	int fileIndex = files.size() - 1;
+
+	RolloutRecorder::FileHeader header;
+	if (file->size < sizeof(header))
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is too small to be a recorded rollout file");
+	memcpy(&header, file->data, sizeof(header));
+
+	if (header.magic != RolloutRecorder::MAGIC)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is not a recorded rollout file");
+	if (header.version != RolloutRecorder::VERSION)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " has unsupported version " << header.version);
+
+	// Use the index if the file has one, otherwise it wasn't closed properly and we find the chunks ourselves
+	std::vector<uint64_t> offsets = {};
+	RolloutRecorder::Footer footer = {};
+	if (file->size >= sizeof(header) + sizeof(footer))
+		memcpy(&footer, file->data + file->size - sizeof(footer), sizeof(footer));
+
+	bool hasIndex =
+		footer.magic == RolloutRecorder::MAGIC &&
+		footer.indexOffset + footer.indexEntryAmount * sizeof(RolloutRecorder::IndexEntry) + sizeof(footer) == file->size;
+
+	if (hasIndex) {
+		for (uint64_t i = 0; i < footer.indexEntryAmount; i++) {
+			RolloutRecorder::IndexEntry entry;
+			memcpy(&entry, file->data + footer.indexOffset + i * sizeof(entry), sizeof(entry));
+			offsets.push_back(entry.offset);
+		}
+	} else {
+		RG_LOG(ERROR_PREFIX << "WARNING: " << path << " has no index, finding its chunks instead");
+		uint64_t offset = sizeof(header);
+		_ChunkHeader chunkHeader;
+		while (uint64_t chunkEnd = _GetChunkEnd(file, offset, chunkHeader)) {
+			offsets.push_back(offset);
+			offset = chunkEnd;
+		}
+	}
+
+	for (uint64_t offset : offsets) {
+		_ChunkHeader chunkHeader;
+		if (!_GetChunkEnd(file, offset, chunkHeader))
+			RG_ERR_CLOSE(ERROR_PREFIX << path << " has a corrupt chunk at offset " << offset);
+
+		uint64_t rows = (uint64_t)chunkHeader.stepAmount * chunkHeader.playerAmount;
+		if (rows == 0)
+			continue;
+
+		if (obsSize == 0) {
+			obsSize = chunkHeader.obsSize;
+		} else if (chunkHeader.obsSize != obsSize) {
+			RG_ERR_CLOSE(ERROR_PREFIX << path << " has an OBS size of " << chunkHeader.obsSize << ", but previous files have " << obsSize);
+		}
+
+		chunks.push_back(ChunkRef{ fileIndex, offset, rows });
+		totalRows += rows;
+	}
+}
+
+RolloutDataset::DecodedChunk RLGPC::RolloutDataset::_DecodeChunk(const ChunkRef& ref) const {
+	const MappedFile* file = files[ref.fileIndex];
+
+	_ChunkHeader header;
+	memcpy(&header, file->data + ref.offset, sizeof(header));
+
+	DecodedChunk result = {};
+	result.rows = ref.rows;
+	result.obs.resize(ref.rows * obsSize);
+	result.actions.resize(ref.rows);
+
+	bool hasObs = false, hasActions = false;
+	uint64_t pos = ref.offset + sizeof(header);
+	for (uint32_t i = 0; i < header.columnAmount; i++) {
+		_ColumnHeader column;
+		memcpy(&column, file->data + pos, sizeof(column));
+		const uint8_t* storedData = file->data + pos + sizeof(column);
+		pos += sizeof(column) + column.storedSize;
+
+		byte* out;
+		if (column.type == RolloutRecorder::ColumnType::OBS) {
+			out = (byte*)result.obs.data();
+			hasObs = (column.rawSize == result.obs.size() * sizeof(float));
+			if (!hasObs)
+				break;
+		} else if (column.type == RolloutRecorder::ColumnType::ACTIONS) {
+			out = (byte*)result.actions.data();
+			hasActions = (column.rawSize == result.actions.size() * sizeof(int32_t));
+			if (!hasActions)
+				break;
+		} else {
+			continue;
+		}
+
+		// The file is only mapped, so this is where the chunk is actually read from disk
+		RolloutRecorder::DecodeColumn(column, storedData, out);
+	}
+
+	if (!hasObs || !hasActions)
+		RG_ERR_CLOSE("RolloutDataset: Chunk at offset " << ref.offset << " of " << file->path << " has missing or wrongly-sized columns");
+
+	return result;
+}
+
+void RLGPC::RolloutDataset::_RunWorker() {
+	while (true) {
+		size_t orderIndex = _nextChunk++;
+		if (orderIndex >= _chunkOrder.size())
+			break;
+
+		// Don't decode too far ahead of the window
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [&] { return _shouldStop || orderIndex < _receivedChunks + maxDecodedChunks; });
+			if (_shouldStop)
+				break;
+		}
+
+		DecodedChunk chunk;
+		std::string chunkError = {};
+		try {
+			chunk = _DecodeChunk(chunks[_chunkOrder[orderIndex]]);
+		} catch (std::exception& e) {
+			chunkError = e.what();
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (chunkError.empty()) {
+			_decodedChunks[orderIndex] = std::move(chunk);
+		} else {
+			_error = chunkError;
+		}
+		_cv.notify_all();
+	}
+}
+
+void RLGPC::RolloutDataset::_StopWorkers() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_shouldStop = true;
+		_cv.notify_all();
+	}
+
+	for (auto& worker : _workers)
+		worker.join();
+	_workers.clear();
+}
+
+void RLGPC::RolloutDataset::StartEpoch() {
+	_StopWorkers();
+
+	_chunkOrder.resize(chunks.size());
+	for (size_t i = 0; i < chunks.size(); i++)
+		_chunkOrder[i] = i;
+	std::shuffle(_chunkOrder.begin(), _chunkOrder.end(), rng);
+
+	_nextChunk = 0;
+	_receivedChunks = 0;
+	_decodedChunks.clear();
+	_error.clear();
+	_shouldStop = false;
+	_windowRows = 0;
+
+	for (int i = 0; i < numWorkers; i++)
+		_workers.push_back(std::thread(&RolloutDataset::_RunWorker, this));
+}
+
+bool RLGPC::RolloutDataset::GetBatch(int64_t batchSize, torch::Tensor& outObs, torch::Tensor& outActions, bool pinned) {
+	// Refill the window
+	while (_windowRows < windowSize && _receivedChunks < _chunkOrder.size()) {
+		DecodedChunk chunk;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [&] { return _decodedChunks.count(_receivedChunks) || !_error.empty(); });
+			if (!_error.empty())
+				RG_ERR_CLOSE("RolloutDataset: Worker failed to decode a chunk: " << _error);
+
+			auto itr = _decodedChunks.find(_receivedChunks);
+			chunk = std::move(itr->second);
+			_decodedChunks.erase(itr);
+			_receivedChunks++;
+			_cv.notify_all();
+		}
+
+		uint64_t newRows = _windowRows + chunk.rows;
+		if (_windowActions.size() < newRows) {
+			_windowObs.resize(newRows * obsSize);
+			_windowActions.resize(newRows);
+		}
+		memcpy(_windowObs.data() + _windowRows * obsSize, chunk.obs.data(), chunk.obs.size() * sizeof(float));
+		memcpy(_windowActions.data() + _windowRows, chunk.actions.data(), chunk.actions.size() * sizeof(int32_t));
+		_windowRows = newRows;
+	}
+
+	if (_windowRows == 0)
+		return false;
+
+	int64_t rows = RS_MIN(batchSize, (int64_t)_windowRows);
+	outObs = torch::empty({ rows, obsSize }, torch::TensorOptions().dtype(torch::kFloat).pinned_memory(pinned));
+	outActions = torch::empty({ rows }, torch::TensorOptions().dtype(torch::kInt64).pinned_memory(pinned));
+	float* obsOut = outObs.data_ptr<float>();
+	int64_t* actionsOut = outActions.data_ptr<int64_t>();
+
+	for (int64_t i = 0; i < rows; i++) {
+		uint64_t index = rng() % _windowRows;
+		memcpy(obsOut + i * obsSize, _windowObs.data() + index * obsSize, obsSize * sizeof(float));
+		actionsOut[i] = _windowActions[index];
+
+		// Drawn rows are replaced by the last row
+		_windowRows--;
+		if (index != _windowRows) {
+			memcpy(_windowObs.data() + index * obsSize, _windowObs.data() + _windowRows * obsSize, obsSize * sizeof(float));
+			_windowActions[index] = _windowActions[_windowRows];
+		}
+	}
+
+	return true;
+}
+
+RLGPC::RolloutDataset::~RolloutDataset() {
+	_StopWorkers();
+	for (MappedFile* file : files)
+		delete file;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include "../FrameworkTorch.h"
+#include "MappedFile.h"
+#include "RolloutRecorder.h"
+#include <condition_variable>
+
+namespace RLGPC {
+	// Reads the (observation, action) pairs of files written by RolloutRecorder, for supervised training of the policy
+	// Files are memory-mapped, and only the chunks currently being used are decoded into memory
+	// Each epoch visits the chunks in a shuffled order, and rows are shuffled again through an in-memory window
+	// Chunks are decoded by worker threads, results only depend on the seed (not on worker timing)
+	class RolloutDataset {
+	public:
+		struct ChunkRef {
+			int fileIndex;
+			uint64_t offset;
+			uint64_t rows; // Steps * players
+		};
+
+		struct DecodedChunk {
+			std::vector<float> obs;
+			std::vector<int32_t> actions;
+			uint64_t rows = 0;
+		};
+
+		std::vector<MappedFile*> files = {};
+		std::vector<ChunkRef> chunks = {};
+		int obsSize = 0;
+		uint64_t totalRows = 0;
+
+		int numWorkers;
+		// Rows are drawn randomly from a window of at least this many rows (unless the epoch is running out)
+		uint64_t windowSize;
+		// Workers stop decoding once this many chunks are waiting to enter the window
+		int maxDecodedChunks;
+
+		std::mt19937_64 rng;
+
+		// Paths can be files, or folders of files
+		RolloutDataset(const std::vector<std::filesystem::path>& paths, int numWorkers, uint64_t windowSize, uint64_t seed, int maxDecodedChunks = 16);
+		RG_NO_COPY(RolloutDataset);
+
+		// Shuffles the chunks and starts decoding them
+		void StartEpoch();
+
+		// Draws up to batchSize random rows from the window, returns false once every row of this epoch was drawn
+		// Outputs are [rows][obsSize] float and [rows] int64, in pinned memory if pinned
+		bool GetBatch(int64_t batchSize, torch::Tensor& outObs, torch::Tensor& outActions, bool pinned);
+
+		// Epoch state
+		std::vector<size_t> _chunkOrder = {};
+		std::atomic<size_t> _nextChunk = 0; // Next index into _chunkOrder for a worker to decode
+		size_t _receivedChunks = 0; // Chunks moved into the window, in the order of _chunkOrder
+		std::map<size_t, DecodedChunk> _decodedChunks = {}; // By index into _chunkOrder
+		std::string _error = {};
+		bool _shouldStop = false;
+		std::mutex _mutex = {};
+		std::condition_variable _cv = {};
+		std::vector<std::thread> _workers = {};
+
+		// Rows in the window, only the first _windowRows are valid
+		std::vector<float> _windowObs = {};
+		std::vector<int32_t> _windowActions = {};
+		uint64_t _windowRows = 0;
+
+		void _AddFile(std::filesystem::path path);
+		DecodedChunk _DecodeChunk(const ChunkRef& ref) const;
+		void _RunWorker();
+		void _StopWorkers();
+
+		~RolloutDataset();
+	};
+}
\ No newline at end of file
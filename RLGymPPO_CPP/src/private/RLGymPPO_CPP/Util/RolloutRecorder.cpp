@@ -0,0 +1,192 @@
+#include "RolloutRecorder.h"
+
+#ifdef RG_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace RLGPC;
+
+RLGPC::RolloutRecorder::RolloutRecorder(std::filesystem::path path, int gameInterval, int segmentSteps, int stateInterval, int maxPendingSegments) :
+	path(path), gameInterval(RS_MAX(gameInterval, 1)), segmentSteps(RS_MAX(segmentSteps, 1)),
+	stateInterval(stateInterval), maxPendingSegments(maxPendingSegments) {
+
+	if (path.has_parent_path())
+		std::filesystem::create_directories(path.parent_path());
+
+	out = std::ofstream(path, std::ios::binary);
+	if (!out.good())
+		RG_ERR_CLOSE("RolloutRecorder: Failed to open " << path);
+
+	FileHeader header = { MAGIC, VERSION, sizeof(BallState), sizeof(CarState) };
+	out.write((const char*)&header, sizeof(header));
+
+	thread = std::thread(&RolloutRecorder::_Run, this);
+}
+
+void RLGPC::RolloutRecorder::Submit(Segment&& segment) {
+	if (pendingSegments >= maxPendingSegments) {
+		droppedSegments++;
+		return;
+	}
+
+	pendingSegments++;
+	queue.Push(std::move(segment));
+}
+
+void RLGPC::RolloutRecorder::GetMetrics(Report& report) {
+	std::lock_guard<std::mutex> lock(metricsMutex);
+	if (!error.empty())
+		RG_ERR_CLOSE("RolloutRecorder: " << error);
+
+	report["Recorded Segments"] = writtenSegments;
+	report["Recorder Dropped Segments"] = droppedSegments.load();
+	if (storedBytes > 0)
+		report["Recorder Compression Ratio"] = (double)rawBytes / storedBytes;
+}
+
+void RLGPC::RolloutRecorder::_Run() {
+	while (true) {
+		Segment segment;
+		if (queue.Pop(segment)) {
+			try {
+				_WriteSegment(segment);
+			} catch (std::exception& e) {
+				std::lock_guard<std::mutex> lock(metricsMutex);
+				error = RS_STR("Failed to write to " << path << ", exception: " << e.what());
+			}
+			pendingSegments--;
+
+			std::lock_guard<std::mutex> lock(metricsMutex);
+			if (!error.empty())
+				break;
+			continue;
+		}
+
+		// Agents are stopped before we are, so nothing is pushed once we are stopping
+		if (shouldStop)
+			break;
+
+		// Segments take a while to fill up, so there is no need to be woken up for each one
+		RG_SLEEP(5);
+	}
+}
+
+void RLGPC::RolloutRecorder::_WriteSegment(const Segment& segment) {
+	IndexEntry entry = {};
+	entry.offset = out.tellp();
+	entry.gameIndex = segment.gameIndex;
+	entry.firstStep = segment.firstStep;
+	entry.stepAmount = segment.stepAmount;
+
+	ChunkHeader header = {};
+	header.magic = CHUNK_MAGIC;
+	header.columnAmount = 5;
+	header.gameIndex = segment.gameIndex;
+	header.firstStep = segment.firstStep;
+	header.stepAmount = segment.stepAmount;
+	header.playerAmount = segment.playerAmount;
+	header.obsSize = segment.obsSize;
+	header.carAmount = segment.carAmount;
+	header.stateAmount = segment.stateAmount;
+	out.write((const char*)&header, sizeof(header));
+
+	_WriteColumn(ColumnType::OBS, segment.obs.data(), segment.obs.size() * sizeof(float));
+	_WriteColumn(ColumnType::ACTIONS, segment.actions.data(), segment.actions.size() * sizeof(int32_t));
+	_WriteColumn(ColumnType::REWARDS, segment.rewards.data(), segment.rewards.size() * sizeof(float));
+	_WriteColumn(ColumnType::DONES, segment.dones.data(), segment.dones.size());
+	_WriteColumn(ColumnType::STATES, segment.states.data(), segment.states.size());
+
+	if (!out.good())
+		RG_ERR_CLOSE("RolloutRecorder: Failed to write chunk");
+
+	index.push_back(entry);
+	std::lock_guard<std::mutex> lock(metricsMutex);
+	writtenSegments++;
+}
+
+int RLGPC::RolloutRecorder::GetValueSize(ColumnType type) {
+	switch (type) {
+	case ColumnType::DONES:
+		return 1;
+	default:
+		return 4; // The step and states are also mostly made of 4-byte values
+	}
+}
+
+void RLGPC::RolloutRecorder::DecodeColumn(const ColumnHeader& header, const uint8_t* storedData, byte* out) {
+	if (header.encoding == ColumnEncoding::RAW) {
+		memcpy(out, storedData, header.rawSize);
+		return;
+	}
+
+	if (header.encoding != ColumnEncoding::ZLIB_SHUFFLED)
+		RG_ERR_CLOSE("RolloutRecorder::DecodeColumn(): Unknown column encoding " << (uint32_t)header.encoding);
+
+#ifdef RG_ZLIB
+	std::vector<byte> shuffled = std::vector<byte>(header.rawSize);
+	uLongf rawSize = header.rawSize;
+	if (uncompress(shuffled.data(), &rawSize, storedData, header.storedSize) != Z_OK || rawSize != header.rawSize)
+		RG_ERR_CLOSE("RolloutRecorder::DecodeColumn(): Failed to decompress column");
+
+	int valueSize = GetValueSize(header.type);
+	uint64_t valueAmount = header.rawSize / valueSize;
+	for (int i = 0; i < valueSize; i++)
+		for (uint64_t j = 0; j < valueAmount; j++)
+			out[j * valueSize + i] = shuffled[i * valueAmount + j];
+	memcpy(out + valueAmount * valueSize, shuffled.data() + valueAmount * valueSize, header.rawSize % valueSize);
+#else
+	RG_ERR_CLOSE("RolloutRecorder::DecodeColumn(): Column is compressed with zlib, but we were built without it");
+#endif
+}
+
+void RLGPC::RolloutRecorder::_WriteColumn(ColumnType type, const void* data, uint64_t size) {
+	ColumnHeader header = { type, ColumnEncoding::RAW, size, size };
+	const void* storedData = data;
+	int valueSize = GetValueSize(type);
+
+#ifdef RG_ZLIB
+	std::vector<byte> shuffled, compressed;
+	if (size > 0) {
+		// Shuffling puts the similar bytes of neighbouring values next to each other (e.g. float exponents)
+		const byte* bytes = (const byte*)data;
+		uint64_t valueAmount = size / valueSize;
+		shuffled.resize(size);
+		for (int i = 0; i < valueSize; i++)
+			for (uint64_t j = 0; j < valueAmount; j++)
+				shuffled[i * valueAmount + j] = bytes[j * valueSize + i];
+		memcpy(shuffled.data() + valueAmount * valueSize, bytes + valueAmount * valueSize, size % valueSize);
+
+		uLongf compressedSize = compressBound(size);
+		compressed.resize(compressedSize);
+		// Fastest level, we only need to keep up with collection
+		if (compress2(compressed.data(), &compressedSize, shuffled.data(), size, 1) == Z_OK && compressedSize < size) {
+			header.encoding = ColumnEncoding::ZLIB_SHUFFLED;
+			header.storedSize = compressedSize;
+			storedData = compressed.data();
+		}
+	}
+#endif
+
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)storedData, header.storedSize);
+
+	std::lock_guard<std::mutex> lock(metricsMutex);
+	rawBytes += header.rawSize;
+	storedBytes += header.storedSize;
+}
+
+RLGPC::RolloutRecorder::~RolloutRecorder() {
+	shouldStop = true;
+	if (thread.joinable())
+		thread.join();
+
+	if (error.empty()) {
+		Footer footer = {};
+		footer.indexOffset = out.tellp();
+		footer.indexEntryAmount = index.size();
+		footer.magic = MAGIC;
+		out.write((const char*)index.data(), index.size() * sizeof(IndexEntry));
+		out.write((const char*)&footer, sizeof(footer));
+	}
+	out.close();
+}
\ No newline at end of file
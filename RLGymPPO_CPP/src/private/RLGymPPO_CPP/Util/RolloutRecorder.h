@@ -0,0 +1,129 @@
+#pragma once
+#include "MPSCQueue.h"
+#include <RLGymPPO_CPP/Util/Report.h>
+
+namespace RLGPC {
+	// Records the rollouts of some games to a file, for debugging and offline analysis
+	// Agents copy the steps of their recorded games into segments, which are pushed to a lock-free queue
+	// A background thread compresses and writes each segment, so recording never waits on the disk
+	//
+	// File layout: header, then one chunk per segment, then the index of all chunks and a footer
+	// Each chunk is a ChunkHeader followed by its columns (ColumnHeader then data), each column is compressed separately
+	// The index is only written once the recorder is destroyed, but chunks can also be read in order without it
+	class RolloutRecorder {
+	public:
+		constexpr static uint32_t MAGIC = 0x52524752; // "RGRR"
+		constexpr static uint32_t CHUNK_MAGIC = 0x43524752; // "RGRC"
+		constexpr static uint32_t VERSION = 1;
+
+		enum class ColumnType : uint32_t {
+			OBS, // float [steps][players][obsSize]
+			ACTIONS, // int32 [steps][players]
+			REWARDS, // float [steps][players]
+			DONES, // uint8 [steps][players]
+			STATES // Per recorded state: uint32 step (the state is from right after it), BallState, CarState of each car
+		};
+
+		enum class ColumnEncoding : uint32_t {
+			RAW,
+			ZLIB_SHUFFLED // Bytes of each value are grouped together (all first bytes, then all second bytes...), then deflated
+		};
+
+		struct FileHeader {
+			uint32_t magic, version;
+
+			// Recorded states are raw structs, so they can only be read with the same layouts
+			uint32_t ballStateSize, carStateSize;
+		};
+
+		struct ChunkHeader {
+			uint32_t magic;
+			uint32_t columnAmount;
+			uint64_t gameIndex; // Index of the game across all agents
+			uint64_t firstStep; // Steps of this game recorded before this chunk
+			uint32_t stepAmount, playerAmount, obsSize, carAmount;
+			uint32_t stateAmount, reserved;
+		};
+
+		struct ColumnHeader {
+			ColumnType type;
+			ColumnEncoding encoding;
+			uint64_t rawSize, storedSize;
+		};
+
+		// Written at the end, followed by the footer
+		struct IndexEntry {
+			uint64_t offset; // Offset of the chunk from the start of the file
+			uint64_t gameIndex, firstStep;
+			uint32_t stepAmount, reserved;
+		};
+
+		struct Footer {
+			uint64_t indexOffset, indexEntryAmount;
+			uint32_t magic, reserved;
+		};
+
+		// Steps of one game, copied from an agent's rollout
+		struct Segment {
+			uint64_t gameIndex = 0, firstStep = 0;
+			int playerAmount = 0, obsSize = 0, carAmount = 0;
+			uint32_t stepAmount = 0, stateAmount = 0;
+
+			std::vector<float> obs, rewards;
+			std::vector<int32_t> actions;
+			std::vector<uint8_t> dones;
+			std::vector<byte> states;
+		};
+
+		std::filesystem::path path;
+
+		// 1 in this many games is recorded
+		int gameInterval;
+		// Steps per segment, the last segment of each game is dropped if it isn't full when recording stops
+		int segmentSteps;
+		// Steps between recorded arena states
+		int stateInterval;
+		// Segments are dropped if this many are still waiting to be written, so a slow disk can't use up our memory
+		int maxPendingSegments;
+
+		std::ofstream out;
+		std::vector<IndexEntry> index = {};
+
+		MPSCQueue<Segment> queue = {};
+		std::atomic<int> pendingSegments = 0;
+		std::atomic<uint64_t> droppedSegments = 0;
+
+		std::thread thread;
+		std::atomic<bool> shouldStop = false;
+
+		std::mutex metricsMutex = {};
+		uint64_t writtenSegments = 0, rawBytes = 0, storedBytes = 0;
+		std::string error = {};
+
+		RolloutRecorder(std::filesystem::path path, int gameInterval, int segmentSteps, int stateInterval, int maxPendingSegments = 256);
+		RG_NO_COPY(RolloutRecorder);
+
+		bool ShouldRecordGame(uint64_t gameIndex) const {
+			return gameIndex % gameInterval == 0;
+		}
+
+		// Can be called from any thread
+		void Submit(Segment&& segment);
+
+		void GetMetrics(Report& report);
+
+		// Size of each value of a column, which is what shuffling groups bytes by
+		static int GetValueSize(ColumnType type);
+
+		// Decodes a column's stored data into out, which must have room for its rawSize
+		// Closes if the column is compressed and we were built without zlib
+		static void DecodeColumn(const ColumnHeader& header, const uint8_t* storedData, byte* out);
+
+		void _Run();
+		void _WriteSegment(const Segment& segment);
+		void _WriteColumn(ColumnType type, const void* data, uint64_t size);
+
+		// Writes everything still queued, then the index
+		~RolloutRecorder();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "SamplingProfiler.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#define RG_SAMPLING_PROFILER
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+using namespace RLGPC;
+
+std::mutex _rolesMutex = {};
+std::unordered_map<uint64_t, std::string> _threadRoles = {};
+
+std::mutex _profileMutex = {};
+std::thread _profileThread = {};
+std::atomic<bool> _profileRunning = false;
+
+std::atomic<bool> _profileRequested = false;
+
+#ifdef RG_SAMPLING_PROFILER
+constexpr int MAX_STACK_DEPTH = 48;
+// Our handler and the signal trampoline, which are the first frames of every sample
+constexpr int SIGNAL_FRAMES = 2;
+// Samples are preallocated, as the signal handler can't allocate
+constexpr size_t MAX_SAMPLES = 1 << 17;
+
+struct _Sample {
+	uint64_t threadID;
+	int depth;
+	void* frames[MAX_STACK_DEPTH];
+};
+
+std::vector<_Sample> _samples = {};
+std::atomic<size_t> _sampleCount = 0;
+std::atomic<bool> _sampling = false;
+std::atomic<int> _activeHandlers = 0; // Handlers still writing a sample, waited for after sampling stops
+
+// Must be async-signal-safe, as it is called from our handler
+uint64_t _GetThreadID() {
+#ifdef __linux__
+	return (uint64_t)syscall(SYS_gettid);
+#else
+	uint64_t id = 0;
+	pthread_threadid_np(NULL, &id);
+	return id;
+#endif
+}
+
+void _OnSampleSignal(int) {
+	if (!_sampling.load(std::memory_order_relaxed))
+		return;
+
+	int savedErrno = errno;
+	_activeHandlers++;
+	size_t index = _sampleCount.fetch_add(1);
+	if (index < _samples.size()) {
+		_Sample& sample = _samples[index];
+		sample.threadID = _GetThreadID();
+		sample.depth = backtrace(sample.frames, MAX_STACK_DEPTH);
+	}
+	_activeHandlers--;
+	errno = savedErrno;
+}
+
+void _OnRequestSignal(int) {
+	_profileRequested = true;
+}
+
+// Name of the function containing a code address, or its module and offset if it has no symbol
+std::string _Symbolize(void* address) {
+	Dl_info info = {};
+	if (!dladdr(address, &info) || !info.dli_fname)
+		return "[unknown]";
+
+	std::string result;
+	if (info.dli_sname) {
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+		result = (status == 0 && demangled) ? demangled : info.dli_sname;
+		free(demangled);
+	} else {
+		std::stringstream stream;
+		stream << std::filesystem::path(info.dli_fname).filename().string() << "+0x" << std::hex << ((uintptr_t)address - (uintptr_t)info.dli_fbase);
+		result = stream.str();
+	}
+
+	// Frames are separated by semicolons in collapsed stacks
+	std::replace(result.begin(), result.end(), ';', ':');
+	return result;
+}
+
+void _RunProfile(std::filesystem::path path, float seconds, int sampleHz) {
+	// The first backtrace() loads the unwinder, which isn't safe to do in a signal handler
+	void* warmupFrames[4];
+	backtrace(warmupFrames, 4);
+
+	// Some kernels fire the timer per CPU time of the whole process, so leave room for every core being busy
+	size_t capacity = (size_t)(seconds * sampleHz * RS_MAX(std::thread::hardware_concurrency(), 1u)) + 1;
+	_samples.resize(RS_MIN(capacity, MAX_SAMPLES));
+	_sampleCount = 0;
+
+	// Our handler stays installed after sampling stops, as a SIGPROF that is still pending would otherwise kill the process
+	static bool handlerInstalled = false;
+	if (!handlerInstalled) {
+		struct sigaction action = {};
+		action.sa_handler = _OnSampleSignal;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		if (sigaction(SIGPROF, &action, NULL) != 0) {
+			RG_LOG("SamplingProfiler: Failed to install the SIGPROF handler, not profiling");
+			_samples = {};
+			_profileRunning = false;
+			return;
+		}
+		handlerInstalled = true;
+	}
+
+	RG_LOG("SamplingProfiler: Profiling for " << seconds << "s at " << sampleHz << "Hz...");
+	_sampling = true;
+
+	itimerval timer = {};
+	int intervalMicros = RS_MAX(1000000 / RS_MAX(sampleHz, 1), 1);
+	timer.it_interval.tv_sec = intervalMicros / 1000000;
+	timer.it_interval.tv_usec = intervalMicros % 1000000;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_PROF, &timer, NULL);
+
+	std::this_thread::sleep_for(std::chrono::duration<float>(seconds));
+
+	timer = {};
+	setitimer(ITIMER_PROF, &timer, NULL);
+	_sampling = false;
+	while (_activeHandlers > 0)
+		std::this_thread::yield();
+
+	size_t totalSamples = _sampleCount;
+	size_t numSamples = RS_MIN(totalSamples, _samples.size());
+
+	std::unordered_map<uint64_t, std::string> threadRoles;
+	{
+		std::lock_guard<std::mutex> lock(_rolesMutex);
+		threadRoles = _threadRoles;
+	}
+
+	// Collapse identical stacks, roots first
+	std::unordered_map<void*, std::string> symbols = {};
+	std::map<std::string, uint64_t> stackCounts = {};
+	std::map<std::string, uint64_t> roleCounts = {};
+	for (size_t i = 0; i < numSamples; i++) {
+		const _Sample& sample = _samples[i];
+
+		auto roleItr = threadRoles.find(sample.threadID);
+		std::string stack = (roleItr != threadRoles.end()) ? roleItr->second : "Other";
+		roleCounts[stack]++;
+
+		for (int j = sample.depth - 1; j >= SIGNAL_FRAMES; j--) {
+			// Every frame but the interrupted one is a return address, which can be just past the end of its call's function
+			void* address = sample.frames[j];
+			if (j > SIGNAL_FRAMES)
+				address = (void*)((uintptr_t)address - 1);
+
+			auto symbolItr = symbols.find(address);
+			if (symbolItr == symbols.end())
+				symbolItr = symbols.emplace(address, _Symbolize(address)).first;
+
+			stack += ';';
+			stack += symbolItr->second;
+		}
+		stackCounts[stack]++;
+	}
+
+	_samples = {};
+
+	if (path.has_parent_path())
+		std::filesystem::create_directories(path.parent_path());
+	std::ofstream outStream = std::ofstream(path);
+	if (!outStream.good()) {
+		RG_LOG("SamplingProfiler: Failed to open " << path << " for writing");
+	} else {
+		for (auto& pair : stackCounts)
+			outStream << pair.first << " " << pair.second << "\n";
+		outStream.close();
+
+		std::stringstream roleSummary;
+		for (auto& pair : roleCounts)
+			roleSummary << (roleSummary.tellp() ? ", " : "") << pair.first << ": " << pair.second;
+		RG_LOG("SamplingProfiler: Wrote " << numSamples << " samples (" << roleSummary.str() << ") to " << path);
+		if (totalSamples > numSamples)
+			RG_LOG("SamplingProfiler: Dropped " << (totalSamples - numSamples) << " samples, as there was no room for them");
+	}
+
+	_profileRunning = false;
+}
+#endif
+
+void SamplingProfiler::SetThreadRole(const std::string& role) {
+#ifdef RG_SAMPLING_PROFILER
+	std::lock_guard<std::mutex> lock(_rolesMutex);
+	_threadRoles[_GetThreadID()] = role;
+#endif
+}
+
+bool SamplingProfiler::IsRunning() {
+	return _profileRunning;
+}
+
+bool SamplingProfiler::Start(std::filesystem::path path, float seconds, int sampleHz) {
+#ifdef RG_SAMPLING_PROFILER
+	std::lock_guard<std::mutex> lock(_profileMutex);
+	if (_profileRunning)
+		return false;
+
+	if (_profileThread.joinable())
+		_profileThread.join();
+
+	_profileRunning = true;
+	_profileThread = std::thread(_RunProfile, path, seconds, sampleHz);
+	return true;
+#else
+	RG_LOG("SamplingProfiler: Sampling profiles are not supported on this platform");
+	return false;
+#endif
+}
+
+void SamplingProfiler::Wait() {
+	std::lock_guard<std::mutex> lock(_profileMutex);
+	if (_profileThread.joinable())
+		_profileThread.join();
+}
+
+void SamplingProfiler::InstallSignalTrigger() {
+#ifdef RG_SAMPLING_PROFILER
+	struct sigaction action = {};
+	action.sa_handler = _OnRequestSignal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGUSR2, &action, NULL);
+#endif
+}
+
+bool SamplingProfiler::PollTriggers(const std::filesystem::path& triggerPath) {
+	bool requested = _profileRequested.exchange(false);
+
+	std::error_code error;
+	if (!triggerPath.empty() && std::filesystem::exists(triggerPath, error)) {
+		std::filesystem::remove(triggerPath, error);
+		requested = true;
+	}
+
+	return requested;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Samples the call stacks of every thread of the process for a few seconds, to see inside env stepping and libtorch without attaching perf
+	// Samples are taken on SIGPROF from setitimer(), which lands on running threads in proportion to the CPU time they use
+	// Profiles are written as collapsed stacks ("role;outermost;...;innermost count" lines), which flamegraph.pl, speedscope, and inferno can open
+	// Stacks are unwound with backtrace(), optimized code without frame pointers or unwind tables may have cut-off stacks
+	// Only supported on Linux and macOS, elsewhere starting a profile just logs that it isn't supported
+	namespace SamplingProfiler {
+		// Stacks of the calling thread are rooted under role in every profile from now on, threads without a role are under "Other"
+		void SetThreadRole(const std::string& role);
+
+		bool IsRunning();
+
+		// Samples at about sampleHz for seconds, then writes the profile to path, all on a background thread
+		// Returns false if a profile is already running
+		bool Start(std::filesystem::path path, float seconds, int sampleHz);
+
+		// Waits for a running profile to be written
+		void Wait();
+
+		// Makes SIGUSR2 request a profile, which is then returned by PollTriggers()
+		void InstallSignalTrigger();
+
+		// Returns true if a profile was requested by SIGUSR2 since the last poll, or if triggerPath exists (which is then deleted)
+		bool PollTriggers(const std::filesystem::path& triggerPath);
+	}
+}
@@ -0,0 +1,87 @@
+#include "SharedMemory.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+RLGPC::SharedMemory::SharedMemory(const std::string& name, uint64_t size, bool create, const char* errorPrefix) : name(name) {
+#ifdef _WIN32
+	std::string fullName = "Local\\" + name;
+	if (create) {
+		_handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, fullName.c_str());
+		if (_handle && GetLastError() == ERROR_ALREADY_EXISTS) {
+			CloseHandle(_handle);
+			_handle = NULL;
+		}
+	} else {
+		_handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, fullName.c_str());
+	}
+
+	if (!_handle)
+		RG_ERR_CLOSE(errorPrefix << "Failed to " << (create ? "create" : "open") << " shared memory \"" << name << "\"");
+
+	data = (uint8_t*)MapViewOfFile(_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (data && !create) {
+		MEMORY_BASIC_INFORMATION info;
+		VirtualQuery(data, &info, sizeof(info));
+		size = info.RegionSize;
+	}
+#else
+	// Names of POSIX shared memory start with a slash
+	std::string fullName = "/" + name;
+	int file = shm_open(fullName.c_str(), create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+	if (file == -1)
+		RG_ERR_CLOSE(errorPrefix << "Failed to " << (create ? "create" : "open") << " shared memory \"" << name << "\"");
+
+	if (create) {
+		_owner = true;
+		if (ftruncate(file, size) != 0) {
+			close(file);
+			Unlink();
+			RG_ERR_CLOSE(errorPrefix << "Failed to resize shared memory \"" << name << "\" to " << size << " bytes");
+		}
+	} else {
+		struct stat fileStat;
+		fstat(file, &fileStat);
+		size = fileStat.st_size;
+	}
+
+	// New regions are zeroed
+	void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if (map != MAP_FAILED)
+		data = (uint8_t*)map;
+	close(file); // The mapping stays valid
+#endif
+
+	this->size = size;
+	if (!data)
+		RG_ERR_CLOSE(errorPrefix << "Failed to map shared memory \"" << name << "\" (" << size << " bytes)");
+}
+
+void RLGPC::SharedMemory::Unlink() {
+#ifndef _WIN32
+	if (_owner) {
+		shm_unlink(("/" + name).c_str());
+		_owner = false;
+	}
+#endif
+}
+
+RLGPC::SharedMemory::~SharedMemory() {
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (_handle)
+		CloseHandle(_handle);
+#else
+	if (data)
+		munmap(data, size);
+	Unlink();
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Named memory that can be mapped by more than one process
+	class SharedMemory {
+	public:
+		std::string name;
+		uint8_t* data = NULL;
+		uint64_t size = 0;
+
+		// If create is set, makes a new zeroed region of this size, otherwise opens an existing one (size is then read from it)
+		// Closes if the region can't be created or opened, errors start with errorPrefix
+		SharedMemory(const std::string& name, uint64_t size, bool create, const char* errorPrefix = "SharedMemory: ");
+		RG_NO_COPY(SharedMemory);
+
+		// Removes the name, so the region is freed once every process unmaps it, and can't be opened again
+		// NOTE: Does nothing on Windows, where regions are freed once no process has them open anyways
+		void Unlink();
+
+		~SharedMemory();
+
+		bool _owner = false; // If set, we created the region, and still need to unlink it
+		void* _handle = NULL; // Windows only
+	};
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "TCPSocket.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET _SocketHandle;
+typedef int _SockLen;
+#define _CLOSE_SOCKET closesocket
+#define _SHUT_BOTH SD_BOTH
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+typedef int _SocketHandle;
+typedef socklen_t _SockLen;
+#define _CLOSE_SOCKET close
+#define _SHUT_BOTH SHUT_RDWR
+#endif
+
+// Writing to a closed connection would otherwise kill us with SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define _SEND_FLAGS MSG_NOSIGNAL
+#else
+#define _SEND_FLAGS 0
+#endif
+
+void _InitSockets() {
+#ifdef _WIN32
+	static std::once_flag initFlag;
+	std::call_once(initFlag, [] {
+		WSADATA wsaData;
+		if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+			RG_ERR_CLOSE("TCPSocket: Failed to initialize Winsock");
+	});
+#endif
+}
+
+// Sends are mostly small requests followed by waiting for a reply, so don't let them be delayed
+void _SetNoDelay(_SocketHandle handle) {
+	int noDelay = 1;
+	setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+}
+
+RLGPC::TCPSocket RLGPC::TCPSocket::Listen(int port) {
+	_InitSockets();
+
+	_SocketHandle handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (handle == (_SocketHandle)-1)
+		return TCPSocket();
+
+	TCPSocket result = TCPSocket((int64_t)handle);
+
+	// Lets us listen again right after restarting
+	int reuse = 1;
+	setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons((uint16_t)port);
+
+	if (bind(handle, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(handle, SOMAXCONN) != 0)
+		return TCPSocket();
+
+	return result;
+}
+
+RLGPC::TCPSocket RLGPC::TCPSocket::Connect(const std::string& address, int port) {
+	_InitSockets();
+
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	addrinfo* addrs = NULL;
+	if (getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &addrs) != 0)
+		return TCPSocket();
+
+	TCPSocket result = {};
+	for (addrinfo* cur = addrs; cur; cur = cur->ai_next) {
+		_SocketHandle handle = socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
+		if (handle == (_SocketHandle)-1)
+			continue;
+
+		if (connect(handle, cur->ai_addr, (_SockLen)cur->ai_addrlen) == 0) {
+			_SetNoDelay(handle);
+			result = TCPSocket((int64_t)handle);
+			break;
+		}
+
+		_CLOSE_SOCKET(handle);
+	}
+
+	freeaddrinfo(addrs);
+	return result;
+}
+
+RLGPC::TCPSocket RLGPC::TCPSocket::Accept() {
+	_SocketHandle clientHandle = accept((_SocketHandle)handle, NULL, NULL);
+	if (clientHandle == (_SocketHandle)-1)
+		return TCPSocket();
+
+	_SetNoDelay(clientHandle);
+	return TCPSocket((int64_t)clientHandle);
+}
+
+bool RLGPC::TCPSocket::SendAll(const void* data, size_t size) {
+	const char* cur = (const char*)data;
+	while (size > 0) {
+		// Send in chunks, as the size is an int on Windows
+		int chunkSize = (int)RS_MIN(size, (size_t)(1 << 30));
+		auto sent = send((_SocketHandle)handle, cur, chunkSize, _SEND_FLAGS);
+		if (sent <= 0)
+			return false;
+
+		cur += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+bool RLGPC::TCPSocket::RecvAll(void* out, size_t size) {
+	char* cur = (char*)out;
+	while (size > 0) {
+		int chunkSize = (int)RS_MIN(size, (size_t)(1 << 30));
+		auto received = recv((_SocketHandle)handle, cur, chunkSize, 0);
+		if (received <= 0)
+			return false;
+
+		cur += received;
+		size -= received;
+	}
+	return true;
+}
+
+size_t RLGPC::TCPSocket::RecvSome(void* out, size_t maxSize) {
+	int chunkSize = (int)RS_MIN(maxSize, (size_t)(1 << 30));
+	auto received = recv((_SocketHandle)handle, (char*)out, chunkSize, 0);
+	return (received > 0) ? received : 0;
+}
+
+void RLGPC::TCPSocket::SetRecvTimeout(float seconds) {
+#ifdef _WIN32
+	DWORD timeout = (DWORD)(seconds * 1000);
+#else
+	timeval timeout = {};
+	timeout.tv_sec = (time_t)seconds;
+	timeout.tv_usec = (suseconds_t)((seconds - timeout.tv_sec) * 1000 * 1000);
+#endif
+	setsockopt((_SocketHandle)handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+void RLGPC::TCPSocket::Close() {
+	if (!IsOpen())
+		return;
+
+	// Closing alone doesn't wake up threads blocked in accept() or recv() on Linux
+	shutdown((_SocketHandle)handle, _SHUT_BOTH);
+	_CLOSE_SOCKET((_SocketHandle)handle);
+	handle = -1;
+}
\ No newline at end of file
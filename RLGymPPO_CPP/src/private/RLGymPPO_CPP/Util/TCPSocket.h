@@ -0,0 +1,54 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Minimal blocking TCP socket, used to talk to remote workers
+	class TCPSocket {
+	public:
+		// SOCKET on Windows, file descriptor everywhere else
+		int64_t handle = -1;
+
+		TCPSocket() = default;
+		explicit TCPSocket(int64_t handle) : handle(handle) {}
+		RG_NO_COPY(TCPSocket);
+
+		TCPSocket(TCPSocket&& other) noexcept : handle(other.handle) {
+			other.handle = -1;
+		}
+
+		TCPSocket& operator=(TCPSocket&& other) noexcept {
+			if (this != &other) {
+				Close();
+				handle = other.handle;
+				other.handle = -1;
+			}
+			return *this;
+		}
+
+		bool IsOpen() const {
+			return handle != -1;
+		}
+
+		// These return a closed socket on failure
+		static TCPSocket Listen(int port);
+		static TCPSocket Connect(const std::string& address, int port);
+		TCPSocket Accept();
+
+		// These return false if the connection was lost
+		bool SendAll(const void* data, size_t size);
+		bool RecvAll(void* out, size_t size);
+
+		// Receives up to maxSize bytes, returns the amount received, or 0 if the connection was lost or timed out
+		size_t RecvSome(void* out, size_t maxSize);
+
+		// Makes receives give up after this many seconds, 0 to wait forever
+		void SetRecvTimeout(float seconds);
+
+		// Also wakes up any thread blocked on this socket
+		void Close();
+
+		~TCPSocket() {
+			Close();
+		}
+	};
+}
\ No newline at end of file
@@ -7,21 +7,36 @@ void RLGPC::TorchFuncs::ComputeGAE(
 	torch::Tensor& outAdvantages, torch::Tensor& outValues, FList& outReturns, 
 	float gamma, float lambda, float returnStd
 ) {
-	auto next_values = FList(values.begin() + 1, values.end());
-	auto& terminal = dones;
+	int64_t nReturns = rews.size();
+	outAdvantages = torch::empty(nReturns);
+	outValues = torch::empty(nReturns);
+	outReturns = FList(nReturns);
 
+	ComputeGAE(
+		rews.data(), dones.data(), truncated.data(), values.data(), nReturns,
+		outAdvantages.data_ptr<float>(), outValues.data_ptr<float>(), outReturns.data(),
+		gamma, lambda, returnStd
+	);
+}
+
+// Reverse GAE pass over [start, end)
+// The step at (end - 1) must either be the last step, or the end of a segment (done or truncated)
+void _ComputeGAERange(
+	const float* rews, const float* dones, const float* truncated, const float* values, const float* truncValues, 
+	int64_t start, int64_t end,
+	float* outAdvantages, float* outValues, float* outReturns,
+	float gamma, float lambda, float returnStd,
+	const float* isRatios, float rhoClip, float traceClip
+) {
 	float returnScale = 1 / returnStd;
 	if (isnan(returnScale))
 		returnScale = 0;
 
 	float lastGAE_LAM = 0;
-	int nReturns = rews.size();
-	FList adv = FList(nReturns);
-	FList returns = FList(nReturns);
 	float lastReturn = 0;
 
-	for (int step = nReturns - 1; step >= 0; step--) {
-		float done = 1 - terminal[step];
+	for (int64_t step = end - 1; step >= start; step--) {
+		float done = 1 - dones[step];
 		float trunc = 1 - truncated[step];
 
 		float norm_rew;
@@ -31,22 +46,287 @@ void RLGPC::TorchFuncs::ComputeGAE(
 			norm_rew = rews[step];
 		}
 
-		float pred_ret = norm_rew + gamma * next_values[step] * done;
+		float nextValue;
+		if (dones[step]) {
+			nextValue = 0;
+		} else if (truncValues && truncated[step]) {
+			nextValue = truncValues[step];
+		} else {
+			nextValue = values[step + 1];
+		}
+
+		float pred_ret = norm_rew + gamma * nextValue;
 		float delta = pred_ret - values[step];
 		float ret = rews[step] + lastReturn * gamma * done * trunc;
-		returns[step] = ret;
+		outReturns[step] = ret;
 		lastReturn = ret;
-		lastGAE_LAM = delta + gamma * lambda * done * trunc * lastGAE_LAM;
-		adv[step] = lastGAE_LAM;
+		if (isRatios) {
+			float rho = RS_MIN(isRatios[step], rhoClip);
+			float trace = RS_MIN(isRatios[step], traceClip) * gamma * lambda * done * trunc * lastGAE_LAM;
+			outAdvantages[step] = delta + trace;
+			lastGAE_LAM = rho * delta + trace;
+		} else {
+			lastGAE_LAM = delta + gamma * lambda * done * trunc * lastGAE_LAM;
+			outAdvantages[step] = lastGAE_LAM;
+		}
+		outValues[step] = values[step] + lastGAE_LAM;
 	}
+}
+
+void RLGPC::TorchFuncs::ComputeGAE(
+	const float* rews, const float* dones, const float* truncated, const float* values, int64_t count,
+	float* outAdvantages, float* outValues, float* outReturns,
+	float gamma, float lambda, float returnStd, JobSystem* jobs, const float* truncValues,
+	const float* isRatios, float rhoClip, float traceClip
+) {
+	// Don't bother with threads for small amounts of steps
+	constexpr int64_t MIN_STEPS_PER_THREAD = 16 * 1000;
+	int numThreads = (int)RS_CLAMP(count / MIN_STEPS_PER_THREAD, 1, jobs ? jobs->GetNumThreads() : 1);
+
+	// Find the range of each thread
+	// Ranges are moved forward so that they always end after a done or truncation
+	std::vector<int64_t> rangeEnds = {};
+	int64_t lastEnd = 0;
+	for (int i = 1; i < numThreads; i++) {
+		int64_t end = RS_MAX(count * i / numThreads, lastEnd + 1);
+		while (end < count && dones[end - 1] == 0 && truncated[end - 1] == 0)
+			end++;
+
+		if (end >= count)
+			break;
+
+		rangeEnds.push_back(end);
+		lastEnd = end;
+	}
+	rangeEnds.push_back(count);
+
+	auto fnRunRange = [&](int64_t start, int64_t end) {
+		_ComputeGAERange(
+			rews, dones, truncated, values, truncValues, start, end,
+			outAdvantages, outValues, outReturns,
+			gamma, lambda, returnStd,
+			isRatios, rhoClip, traceClip
+		);
+	};
+
+	JobSystem::ParallelFor(jobs, 0, rangeEnds.size(), 1,
+		[&](int64_t start, int64_t end) {
+			for (int64_t i = start; i < end; i++)
+				fnRunRange((i > 0) ? rangeEnds[i - 1] : 0, rangeEnds[i]);
+		}
+	);
+}
+
+// Computes out[t] = vals[t] + coefs[t] * out[t + 1] for every t, with out[count] = 0
+// Each step combines every element with the one (span) after it, like a Hillis-Steele scan, so the spans double until they cover everything
+torch::Tensor _ReverseLinearScan(torch::Tensor coefs, torch::Tensor vals) {
+	int64_t count = vals.size(0);
+	for (int64_t span = 1; span < count; span *= 2) {
+		int64_t headSize = count - span;
+		auto headCoefs = coefs.slice(0, 0, headSize);
+
+		// Elements within (span) of the end have nothing after them to combine with
+		auto newVals = vals.clone();
+		newVals.slice(0, 0, headSize).addcmul_(headCoefs, vals.slice(0, span));
+		auto newCoefs = coefs.clone();
+		newCoefs.slice(0, 0, headSize).mul_(coefs.slice(0, span));
+
+		vals = newVals;
+		coefs = newCoefs;
+	}
+	return vals;
+}
+
+void RLGPC::TorchFuncs::ComputeGAEDevice(
+	torch::Tensor rews, torch::Tensor dones, torch::Tensor truncated, torch::Tensor values,
+	torch::Tensor& outAdvantages, torch::Tensor& outValues, torch::Tensor& outReturns,
+	float gamma, float lambda, float returnStd, torch::Tensor truncValues,
+	torch::Tensor isRatios, float rhoClip, float traceClip
+) {
+	RG_NOGRAD;
+
+	int64_t count = rews.size(0);
+	auto options = torch::TensorOptions().dtype(torch::kFloat).device(rews.device());
+	rews = rews.to(torch::kFloat);
+	dones = dones.to(torch::kFloat);
+	truncated = truncated.to(torch::kFloat);
+	values = values.to(torch::kFloat).flatten();
+
+	float returnScale = 1 / returnStd;
+	if (isnan(returnScale))
+		returnScale = 0;
+
+	torch::Tensor normRews;
+	if (returnStd != 0) {
+		normRews = (rews * returnScale).clamp(-10, 10);
+	} else {
+		normRews = rews;
+	}
+
+	torch::Tensor nextValues;
+	if (values.size(0) > count) {
+		nextValues = values.slice(0, 1, count + 1);
+	} else {
+		// The last step is done or truncated, so it doesn't need a next value from values
+		nextValues = torch::cat({ values.slice(0, 1), torch::zeros({ 1 }, options) });
+	}
+	if (truncValues.defined())
+		nextValues = torch::where(truncated != 0, truncValues.to(torch::kFloat), nextValues);
+	nextValues = torch::where(dones != 0, torch::zeros({}, options), nextValues);
+
+	auto curValues = values.slice(0, 0, count);
+	auto delta = normRews + gamma * nextValues - curValues;
+	auto notEnded = (1 - dones) * (1 - truncated);
+
+	outReturns = _ReverseLinearScan(gamma * notEnded, rews);
+
+	torch::Tensor gaeLams;
+	if (isRatios.defined()) {
+		isRatios = isRatios.to(torch::kFloat);
+		auto rhoDelta = isRatios.clamp_max(rhoClip) * delta;
+		gaeLams = _ReverseLinearScan(isRatios.clamp_max(traceClip) * (gamma * lambda) * notEnded, rhoDelta);
 
-	outAdvantages = torch::tensor(adv);
-	auto outValuesList = FList(values.size() - 1);
-	for (int i = 0; i < values.size() - 1; i++)
-		outValuesList[i] = values[i] + adv[i];
+		// Each step's own TD error is unweighted, see the sequential pass
+		outAdvantages = delta + (gaeLams - rhoDelta);
+	} else {
+		gaeLams = _ReverseLinearScan((gamma * lambda) * notEnded, delta);
+		outAdvantages = gaeLams;
+	}
+	outValues = curValues + gaeLams;
+}
+
+void RLGPC::TorchFuncs::AddSeqToFile(CheckpointFileWriter& writer, torch::nn::Sequential seq, const std::string& prefix) {
+	for (auto& param : seq->named_parameters()) {
+		auto& tensor = param.value();
+		RG_ASSERT(tensor.is_cpu() && tensor.scalar_type() == torch::kFloat && tensor.is_contiguous());
+		writer.AddFloats(prefix + param.key(), tensor.data_ptr<float>(), tensor.sizes().vec());
+	}
+}
+
+void RLGPC::TorchFuncs::LoadSeqFromFile(torch::nn::Sequential seq, const CheckpointFile& file, const std::string& prefix) {
+	RG_NOGRAD;
+
+	for (auto& param : seq->named_parameters()) {
+		auto& entry = file.Get(prefix + param.key(), CheckpointFile::EntryType::FLOAT32);
+		auto& tensor = param.value();
+		if (entry.shape != tensor.sizes().vec()) {
+			RG_ERR_CLOSE(
+				"Saved model has different size than current model, cannot load model from " << file.path << 
+				" (parameter \"" << entry.name << "\")"
+			);
+		}
+
+		auto savedTensor = torch::from_blob((void*)entry.data, entry.shape, torch::kFloat);
+		tensor.copy_(savedTensor);
+	}
+}
+
+void RLGPC::TorchFuncs::ClipGradNorms(const std::vector<std::vector<torch::Tensor>>& paramGroups, float maxNorm) {
+	RG_NOGRAD;
+
+	std::vector<std::vector<torch::Tensor>> groupGrads = {};
+	std::vector<torch::Tensor> allGrads = {};
+	for (auto& params : paramGroups) {
+		auto& grads = groupGrads.emplace_back();
+		for (auto& param : params)
+			if (param.grad().defined())
+				grads.push_back(param.grad());
+		allGrads.insert(allGrads.end(), grads.begin(), grads.end());
+	}
+
+	if (allGrads.empty())
+		return;
+
+	// Norm of every gradient at once, then the norm of each group from those
+	auto norms = torch::stack(torch::_foreach_norm(allGrads));
+
+	int64_t startIdx = 0;
+	for (auto& grads : groupGrads) {
+		if (grads.empty())
+			continue;
+
+		auto totalNorm = norms.slice(0, startIdx, startIdx + grads.size()).norm();
+		startIdx += grads.size();
+
+		// Same as clip_grad_norm_(), but the scale is applied even when it is 1, so that we don't need to read it
+		auto clipCoef = (maxNorm / (totalNorm + 1e-6f)).clamp_max(1.f);
+		torch::_foreach_mul_(grads, clipCoef);
+	}
+}
+
+bool RLGPC::TorchFuncs::FusedAdamStep(const std::vector<torch::optim::Adam*>& optimizers) {
+	RG_NOGRAD;
+
+	// Parameters that share betas and epsilon are updated together, the step size can differ for each one
+	struct Bucket {
+		std::vector<torch::Tensor> params, grads, expAvgs, expAvgSqs;
+		std::vector<c10::Scalar> negStepSizes, bias2Sqrts;
+	};
+	std::map<std::tuple<double, double, double>, Bucket> buckets = {};
+
+	for (auto optimizer : optimizers) {
+		for (auto& group : optimizer->param_groups()) {
+			auto& options = static_cast<torch::optim::AdamOptions&>(group.options());
+			if (options.amsgrad() || options.weight_decay() != 0)
+				return false;
+		}
+	}
+
+	for (auto optimizer : optimizers) {
+		for (auto& group : optimizer->param_groups()) {
+			auto& options = static_cast<torch::optim::AdamOptions&>(group.options());
+			double beta1 = std::get<0>(options.betas()), beta2 = std::get<1>(options.betas());
+			auto& bucket = buckets[{ beta1, beta2, options.eps() }];
+
+			for (auto& param : group.params()) {
+				if (!param.grad().defined())
+					continue;
+
+				// Same state as optim::Adam::step() creates
+				auto& stateEntry = optimizer->state()[param.unsafeGetTensorImpl()];
+				if (!stateEntry) {
+					auto newState = std::make_unique<torch::optim::AdamParamState>();
+					newState->step(0);
+					newState->exp_avg(torch::zeros_like(param, torch::MemoryFormat::Preserve));
+					newState->exp_avg_sq(torch::zeros_like(param, torch::MemoryFormat::Preserve));
+					stateEntry = std::move(newState);
+				}
+
+				auto& state = static_cast<torch::optim::AdamParamState&>(*stateEntry);
+				state.step(state.step() + 1);
+
+				double bias1 = 1 - std::pow(beta1, state.step());
+				double bias2 = 1 - std::pow(beta2, state.step());
+
+				bucket.params.push_back(param);
+				bucket.grads.push_back(param.grad());
+				bucket.expAvgs.push_back(state.exp_avg());
+				bucket.expAvgSqs.push_back(state.exp_avg_sq());
+				bucket.negStepSizes.push_back(-options.lr() / bias1);
+				bucket.bias2Sqrts.push_back(std::sqrt(bias2));
+			}
+		}
+	}
+
+	for (auto& pair : buckets) {
+		auto [beta1, beta2, eps] = pair.first;
+		auto& bucket = pair.second;
+		if (bucket.params.empty())
+			continue;
+
+		torch::_foreach_mul_(bucket.expAvgs, beta1);
+		torch::_foreach_add_(bucket.expAvgs, bucket.grads, 1 - beta1);
+		torch::_foreach_mul_(bucket.expAvgSqs, beta2);
+		torch::_foreach_addcmul_(bucket.expAvgSqs, bucket.grads, bucket.grads, 1 - beta2);
+
+		auto denoms = torch::_foreach_sqrt(bucket.expAvgSqs);
+		torch::_foreach_div_(denoms, bucket.bias2Sqrts);
+		torch::_foreach_add_(denoms, eps);
+
+		torch::_foreach_addcdiv_(bucket.params, bucket.expAvgs, denoms, bucket.negStepSizes);
+	}
 
-	outValues = torch::tensor(outValuesList);
-	outReturns = returns;
+	return true;
 }
 
 torch::Tensor RLGPC::TorchFuncs::ConcatSafe(torch::Tensor a, torch::Tensor b) {
@@ -1,6 +1,8 @@
 #pragma once
 #include <RLGymPPO_CPP/Lists.h>
+#include <RLGymPPO_CPP/Threading/JobSystem.h>
 #include "../FrameworkTorch.h"
+#include "CheckpointFile.h"
 #include <torch/optim/adam.h>
 
 namespace RLGPC {
@@ -12,7 +14,54 @@ namespace RLGPC {
 			float gamma = 0.99f, float lambda = 0.95f, float returnStd = 0
 		);
 
+		// Computes advantages, value targets, and returns in a single reverse pass, directly on contiguous memory
+		// Values must have (count + 1) elements, as it includes the value of the final next state
+		// Segments that end in a done or truncation are independent, and are split across the threads of jobs, if set
+		// If truncValues is set, it has (count) elements, and a truncated step uses truncValues[step] as its next value instead of values[step + 1]
+		//	Values then only needs (count) elements, as the last step is always done or truncated
+		// If isRatios is set, it has the importance ratio (current policy / collecting policy) of each step's action
+		//	Value targets are then V-trace targets, with ratios clipped to rhoClip for the TD error and to traceClip for the trace
+		//	Advantages use the same traces, but leave the step's own TD error unweighted, as the PPO loss is importance-weighted instead
+		//	With all ratios at 1, this is the same as normal GAE
+		void ComputeGAE(
+			const float* rews, const float* dones, const float* truncated, const float* values, int64_t count,
+			float* outAdvantages, float* outValues, float* outReturns,
+			float gamma = 0.99f, float lambda = 0.95f, float returnStd = 0, JobSystem* jobs = NULL,
+			const float* truncValues = NULL,
+			const float* isRatios = NULL, float rhoClip = 1, float traceClip = 1
+		);
+
+		// Same as the ComputeGAE() above, but with tensors that can be on any device (such as the GPU), which never leave it
+		// Each reverse pass is a scan over (coefficient, value) pairs in log2(count) steps of elementwise ops, instead of a loop over steps
+		//	Done and truncated steps have a coefficient of 0, which splits the scan into independent segments
+		// Values, truncValues, and isRatios are the same as above, truncValues and isRatios can be undefined
+		// NOTE: Sums are done in a different order than the sequential pass, so results can differ by rounding
+		void ComputeGAEDevice(
+			torch::Tensor rews, torch::Tensor dones, torch::Tensor truncated, torch::Tensor values,
+			torch::Tensor& outAdvantages, torch::Tensor& outValues, torch::Tensor& outReturns,
+			float gamma = 0.99f, float lambda = 0.95f, float returnStd = 0,
+			torch::Tensor truncValues = {},
+			torch::Tensor isRatios = {}, float rhoClip = 1, float traceClip = 1
+		);
+
+		// Clips the gradients of each group of parameters to maxNorm, like nn::utils::clip_grad_norm_() on each group
+		// Norms of every group are computed together with multi-tensor ops, and are never read back, so this doesn't wait for the device
+		void ClipGradNorms(const std::vector<std::vector<torch::Tensor>>& paramGroups, float maxNorm);
+
+		// Steps Adam optimizers like optim::Adam::step(), but updates every parameter of every optimizer together with multi-tensor ops
+		// Uses the optimizers' own state, so they can still be saved, loaded, and stepped normally
+		// Returns false without stepping if an optimizer uses options this doesn't support (amsgrad or weight decay)
+		bool FusedAdamStep(const std::vector<torch::optim::Adam*>& optimizers);
+
 		// torch::cat({a, b}, 0) but returns b.clone() if a is undefined
 		torch::Tensor ConcatSafe(torch::Tensor a, torch::Tensor b);
+
+		// Adds each parameter of seq as an entry named (prefix + parameter name)
+		// Parameters must be contiguous float CPU tensors, which stay valid until the writer saves
+		void AddSeqToFile(CheckpointFileWriter& writer, torch::nn::Sequential seq, const std::string& prefix);
+
+		// Copies each parameter of seq from the file's entry named (prefix + parameter name), directly from the file's mapping
+		// Closes if an entry is missing or is of a different shape
+		void LoadSeqFromFile(torch::nn::Sequential seq, const CheckpointFile& file, const std::string& prefix);
 	}
 }
\ No newline at end of file
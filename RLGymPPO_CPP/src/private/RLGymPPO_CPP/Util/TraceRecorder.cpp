@@ -0,0 +1,235 @@
+#include "TraceRecorder.h"
+
+#include "../libsrc/json/nlohmann/json.hpp"
+
+#ifdef RG_CUDA_EVENTS
+#include <torch/cuda.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDAGuard.h>
+#endif
+
+using namespace RLGPC;
+
+struct _TraceEvent {
+	const char* name;
+	int64_t startTime, endTime;
+};
+
+// Events of one thread, only locked by that thread and when a trace begins or ends
+struct _TraceThread {
+	int id;
+	std::string name;
+	std::mutex mutex = {};
+	std::vector<_TraceEvent> events = {};
+};
+
+#ifdef RG_CUDA_EVENTS
+struct _GPUSpan {
+	int deviceIndex, threadID;
+	const char* name = NULL;
+	std::shared_ptr<at::cuda::CUDAEvent> startEvent, endEvent;
+	bool ended = false;
+};
+#endif
+
+std::atomic<bool> _recording = false;
+std::atomic<uint64_t> _traceIndex = 0;
+int64_t _traceStartTime = 0;
+
+std::mutex _threadsMutex = {};
+std::vector<std::shared_ptr<_TraceThread>> _threads = {};
+thread_local std::shared_ptr<_TraceThread> _curThread = NULL;
+
+#ifdef RG_CUDA_EVENTS
+std::mutex _gpuMutex = {};
+std::vector<_GPUSpan> _gpuSpans = {};
+#endif
+
+_TraceThread* _GetCurThread() {
+	if (!_curThread) {
+		std::lock_guard<std::mutex> lock(_threadsMutex);
+		_curThread = std::make_shared<_TraceThread>();
+		_curThread->id = _threads.size();
+		_curThread->name = "Thread " + std::to_string(_curThread->id);
+		_threads.push_back(_curThread);
+	}
+	return _curThread.get();
+}
+
+int64_t TraceRecorder::_Now() {
+	static auto processStartTime = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - processStartTime).count();
+}
+
+bool TraceRecorder::IsRecording() {
+	return _recording.load(std::memory_order_relaxed);
+}
+
+uint64_t TraceRecorder::_GetTraceIndex() {
+	return _traceIndex.load(std::memory_order_relaxed);
+}
+
+void TraceRecorder::SetThreadName(const std::string& name) {
+	auto thread = _GetCurThread();
+	std::lock_guard<std::mutex> lock(thread->mutex);
+	thread->name = name;
+}
+
+void TraceRecorder::Begin() {
+	{
+		std::lock_guard<std::mutex> lock(_threadsMutex);
+		for (auto& thread : _threads) {
+			std::lock_guard<std::mutex> threadLock(thread->mutex);
+			thread->events.clear();
+		}
+	}
+
+#ifdef RG_CUDA_EVENTS
+	{
+		std::lock_guard<std::mutex> lock(_gpuMutex);
+		_gpuSpans.clear();
+	}
+#endif
+
+	_traceStartTime = _Now();
+	_traceIndex++;
+	_recording = true;
+}
+
+void TraceRecorder::_AddEvent(const char* name, int64_t startTime, int64_t endTime, uint64_t traceIndex) {
+	if (!IsRecording() || traceIndex != _GetTraceIndex())
+		return;
+
+	auto thread = _GetCurThread();
+	std::lock_guard<std::mutex> lock(thread->mutex);
+	thread->events.push_back({ name, startTime, endTime });
+}
+
+int TraceRecorder::_BeginGPUSpan(c10::Device device) {
+#ifdef RG_CUDA_EVENTS
+	if (!device.is_cuda())
+		return -1;
+
+	int deviceIndex = device.has_index() ? device.index() : 0;
+	c10::cuda::CUDAGuard guard = c10::cuda::CUDAGuard(deviceIndex);
+
+	_GPUSpan span = {};
+	span.deviceIndex = deviceIndex;
+	span.threadID = _GetCurThread()->id;
+	span.startEvent = std::make_shared<at::cuda::CUDAEvent>(cudaEventDefault);
+	span.endEvent = std::make_shared<at::cuda::CUDAEvent>(cudaEventDefault);
+	span.startEvent->record();
+
+	std::lock_guard<std::mutex> lock(_gpuMutex);
+	_gpuSpans.push_back(span);
+	return _gpuSpans.size() - 1;
+#else
+	return -1;
+#endif
+}
+
+void TraceRecorder::_EndGPUSpan(int spanIndex, const char* name, uint64_t traceIndex) {
+#ifdef RG_CUDA_EVENTS
+	std::lock_guard<std::mutex> lock(_gpuMutex);
+	if (!IsRecording() || traceIndex != _GetTraceIndex() || spanIndex >= _gpuSpans.size())
+		return;
+
+	auto& span = _gpuSpans[spanIndex];
+	c10::cuda::CUDAGuard guard = c10::cuda::CUDAGuard(span.deviceIndex);
+	span.endEvent->record();
+	span.name = name;
+	span.ended = true;
+#endif
+}
+
+void TraceRecorder::End(std::filesystem::path path) {
+	if (!IsRecording())
+		return;
+	_recording = false;
+
+	using namespace nlohmann;
+	json events = json::array();
+
+	constexpr int CPU_PID = 0, GPU_PID = 1;
+	auto fnAddMetadata = [&](const char* type, int pid, int tid, const std::string& name) {
+		events.push_back({ { "name", type }, { "ph", "M" }, { "pid", pid }, { "tid", tid }, { "args", { { "name", name } } } });
+	};
+	auto fnAddEvent = [&](const char* name, int pid, int tid, double startTime, double endTime) {
+		events.push_back({
+			{ "name", name }, { "ph", "X" }, { "pid", pid }, { "tid", tid },
+			{ "ts", startTime - _traceStartTime }, { "dur", RS_MAX(endTime - startTime, 0) }
+		});
+	};
+
+	fnAddMetadata("process_name", CPU_PID, 0, "CPU");
+
+	std::map<int, std::string> threadNames = {};
+	{
+		std::lock_guard<std::mutex> lock(_threadsMutex);
+		for (auto& thread : _threads) {
+			std::lock_guard<std::mutex> threadLock(thread->mutex);
+			threadNames[thread->id] = thread->name;
+			if (thread->events.empty())
+				continue;
+
+			fnAddMetadata("thread_name", CPU_PID, thread->id, thread->name);
+			for (auto& event : thread->events)
+				fnAddEvent(event.name, CPU_PID, thread->id, event.startTime, event.endTime);
+		}
+	}
+
+#ifdef RG_CUDA_EVENTS
+	{
+		std::lock_guard<std::mutex> lock(_gpuMutex);
+		if (!_gpuSpans.empty()) {
+			fnAddMetadata("process_name", GPU_PID, 0, "GPU");
+
+			// Once the device is idle, an event recorded on it completes at the time we see it complete
+			// Every span is placed relative to that event, so GPU times line up with CPU times
+			std::map<int, std::pair<std::shared_ptr<at::cuda::CUDAEvent>, int64_t>> refEvents = {};
+			for (auto& span : _gpuSpans) {
+				if (refEvents.count(span.deviceIndex))
+					continue;
+
+				c10::cuda::CUDAGuard guard = c10::cuda::CUDAGuard(span.deviceIndex);
+				torch::cuda::synchronize(span.deviceIndex);
+				auto refEvent = std::make_shared<at::cuda::CUDAEvent>(cudaEventDefault);
+				refEvent->record();
+				refEvent->synchronize();
+				refEvents[span.deviceIndex] = { refEvent, _Now() };
+			}
+
+			// Each thread queuing work on a device gets its own track, as their spans don't nest
+			std::set<int> namedTracks = {};
+			for (auto& span : _gpuSpans) {
+				if (!span.ended)
+					continue;
+
+				int tid = span.deviceIndex * 1000 + span.threadID;
+				if (!namedTracks.count(tid)) {
+					fnAddMetadata("thread_name", GPU_PID, tid, "GPU " + std::to_string(span.deviceIndex) + ": " + threadNames[span.threadID]);
+					namedTracks.insert(tid);
+				}
+
+				auto& ref = refEvents[span.deviceIndex];
+				double startTime = ref.second - span.startEvent->elapsed_time(*ref.first) * 1000.0;
+				double endTime = ref.second - span.endEvent->elapsed_time(*ref.first) * 1000.0;
+				fnAddEvent(span.name, GPU_PID, tid, startTime, endTime);
+			}
+		}
+		_gpuSpans.clear();
+	}
+#endif
+
+	if (path.has_parent_path())
+		std::filesystem::create_directories(path.parent_path());
+
+	std::ofstream fOut(path);
+	if (!fOut.good())
+		RG_ERR_CLOSE("TraceRecorder: Failed to open trace file at " << path);
+
+	json j = {};
+	j["traceEvents"] = events;
+	j["displayTimeUnit"] = "ms";
+	fOut << j.dump();
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <RLGymPPO_CPP/FrameworkTorch.h>
+
+namespace RLGPC {
+	// Records a timeline of scoped events from every thread, while a trace is running
+	// Traces are written in the Chrome trace event format, which can be opened at ui.perfetto.dev or chrome://tracing
+	// Scopes given a CUDA device also record CUDA events around their work, which show up on a separate track of that GPU
+	// When no trace is running, scopes only cost an atomic load
+	namespace TraceRecorder {
+		// Time since the process started, in microseconds
+		int64_t _Now();
+
+		bool IsRecording();
+
+		// Names the calling thread in every trace from now on
+		void SetThreadName(const std::string& name);
+
+		// Starts recording a new trace, events of a trace that is still running are dropped
+		void Begin();
+
+		// Stops recording and writes the trace to path, waiting for GPU work of the trace to finish
+		void End(std::filesystem::path path);
+
+		// Adds a complete event of the calling thread
+		void _AddEvent(const char* name, int64_t startTime, int64_t endTime, uint64_t traceIndex);
+
+		// Returns the index of a GPU span, or -1 if the device is not a CUDA device
+		int _BeginGPUSpan(c10::Device device);
+		void _EndGPUSpan(int spanIndex, const char* name, uint64_t traceIndex);
+
+		uint64_t _GetTraceIndex();
+	}
+
+	// Adds an event of the calling thread from its construction to its destruction
+	// name must outlive the trace, so it should be a string literal
+	struct TraceScope {
+		const char* name;
+		bool active;
+		int64_t startTime = 0;
+		uint64_t traceIndex = 0;
+		int gpuSpanIndex = -1;
+
+		TraceScope(const char* name) : name(name) {
+			active = TraceRecorder::IsRecording();
+			if (active) {
+				traceIndex = TraceRecorder::_GetTraceIndex();
+				startTime = TraceRecorder::_Now();
+			}
+		}
+
+		// Also times the work this scope queues on the device, if it is a CUDA device
+		TraceScope(const char* name, c10::Device device) : TraceScope(name) {
+			if (active)
+				gpuSpanIndex = TraceRecorder::_BeginGPUSpan(device);
+		}
+
+		RG_NO_COPY(TraceScope);
+
+		~TraceScope() {
+			if (!active)
+				return;
+
+			if (gpuSpanIndex != -1)
+				TraceRecorder::_EndGPUSpan(gpuSpanIndex, name, traceIndex);
+			TraceRecorder::_AddEvent(name, startTime, TraceRecorder::_Now(), traceIndex);
+		}
+	};
+}
+
+#define _RG_TRACE_CONCAT(a, b) a##b
+#define _RG_TRACE_NAME(line) _RG_TRACE_CONCAT(_traceScope, line)
+
+// Traces the rest of the current scope, args are the name and optionally the device
+#define RG_TRACE_SCOPE(...) RLGPC::TraceScope _RG_TRACE_NAME(__LINE__)(__VA_ARGS__)
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Lock-free single-slot mailbox, where one writer publishes values and one reader takes the newest
+	// Neither side ever waits, values the reader doesn't get to in time are overwritten
+	// There are three slots, so the writer and reader each always have their own, and the third holds the newest published value
+	// Values are written and read in place, so slots keep their memory
+	template <typename T>
+	class TripleBuffer {
+	public:
+		T slots[3] = {};
+
+		// Writer only, the slot to write the next value into
+		T& GetWriteSlot() {
+			return slots[_writeIndex];
+		}
+
+		// Writer only, publishes the write slot
+		void Publish() {
+			uint8_t prev = _middle.exchange(_writeIndex | NEW_BIT, std::memory_order_acq_rel);
+			_writeIndex = prev & INDEX_MASK;
+		}
+
+		// True if a published value hasn't been taken yet
+		bool HasNew() const {
+			return _middle.load(std::memory_order_relaxed) & NEW_BIT;
+		}
+
+		// Reader only, returns the newest value if one was published since the last call, otherwise NULL
+		// The value stays valid until the next call
+		const T* Take() {
+			if (!HasNew())
+				return NULL;
+
+			uint8_t prev = _middle.exchange(_readIndex, std::memory_order_acq_rel);
+			_readIndex = prev & INDEX_MASK;
+			return &slots[_readIndex];
+		}
+
+		constexpr static uint8_t NEW_BIT = 4, INDEX_MASK = 3;
+
+		uint8_t _writeIndex = 0, _readIndex = 1;
+		std::atomic<uint8_t> _middle = 2;
+	};
+}
\ No newline at end of file
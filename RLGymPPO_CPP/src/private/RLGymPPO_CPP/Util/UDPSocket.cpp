@@ -0,0 +1,62 @@
+#include "UDPSocket.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET _SocketHandle;
+#define _CLOSE_SOCKET closesocket
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <unistd.h>
+typedef int _SocketHandle;
+#define _CLOSE_SOCKET close
+#endif
+
+// From TCPSocket.cpp
+void _InitSockets();
+
+bool RLGPC::UDPSocket::Open(const std::string& address, int port) {
+	Close();
+	_InitSockets();
+
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_protocol = IPPROTO_UDP;
+
+	addrinfo* addrs = NULL;
+	if (getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &addrs) != 0)
+		return false;
+
+	for (addrinfo* cur = addrs; cur; cur = cur->ai_next) {
+		if (cur->ai_addrlen > sizeof(_addr))
+			continue;
+
+		_SocketHandle curHandle = socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
+		if (curHandle == (_SocketHandle)-1)
+			continue;
+
+		handle = (int64_t)curHandle;
+		memcpy(_addr, cur->ai_addr, cur->ai_addrlen);
+		_addrSize = (int)cur->ai_addrlen;
+		break;
+	}
+
+	freeaddrinfo(addrs);
+	return IsOpen();
+}
+
+bool RLGPC::UDPSocket::Send(const void* data, size_t size) {
+	auto sent = sendto((_SocketHandle)handle, (const char*)data, (int)size, 0, (const sockaddr*)_addr, _addrSize);
+	return sent == (decltype(sent))size;
+}
+
+void RLGPC::UDPSocket::Close() {
+	if (!IsOpen())
+		return;
+
+	_CLOSE_SOCKET((_SocketHandle)handle);
+	handle = -1;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <RLGymPPO_CPP/Framework.h>
+
+namespace RLGPC {
+	// Minimal UDP socket that sends to one address, used to send render packets
+	class UDPSocket {
+	public:
+		// SOCKET on Windows, file descriptor everywhere else
+		int64_t handle = -1;
+
+		// sockaddr_storage of where we send to
+		uint8_t _addr[128] = {};
+		int _addrSize = 0;
+
+		UDPSocket() = default;
+		RG_NO_COPY(UDPSocket);
+
+		bool IsOpen() const {
+			return handle != -1;
+		}
+
+		// Returns false if the address can't be resolved, or the socket can't be made
+		bool Open(const std::string& address, int port);
+
+		// Returns false if the packet couldn't be sent
+		bool Send(const void* data, size_t size);
+
+		void Close();
+
+		~UDPSocket() {
+			Close();
+		}
+	};
+}
\ No newline at end of file
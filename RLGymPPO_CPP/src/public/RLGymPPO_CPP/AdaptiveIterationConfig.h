@@ -0,0 +1,32 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	// Settings for adapting the size of each learn iteration to keep learning and collection balanced (see LearnerConfig::adaptiveIteration)
+	// After every iteration, the time the learner waited on collection ("Collection Time") is compared to the time agents waited on the learner,
+	//	which is when they have collected as far ahead as they are allowed to ("Collect Limit Wait Time")
+	// If agents waited more, learning is the bottleneck, so there are fewer epochs and more timesteps per iteration to learn from
+	// If the learner waited more, collection is the bottleneck, so there are more epochs and fewer timesteps, so the learner does more with what is collected
+	// Small differences only change timestepsPerIteration, epochs change one at a time when the difference is large or timesteps are at a bound
+	struct AdaptiveIterationConfig {
+		bool enabled = false;
+
+		// Bounds of timestepsPerIteration, which starts at its value in the learner's config
+		int64_t minTimesteps = 20 * 1000;
+		int64_t maxTimesteps = 500 * 1000;
+
+		// Bounds of PPOLearnerConfig::epochs, which starts at its value in the learner's config
+		int minEpochs = 1;
+		int maxEpochs = 4;
+
+		// Fraction of the difference in wait times (relative to the iteration's time) that timesteps are scaled by each iteration
+		// Lower is smoother, but slower to adapt
+		float adjustRate = 0.5f;
+
+		// Differences in wait times below this fraction of the iteration's time are ignored
+		float tolerance = 0.05f;
+
+		// Epochs change once the difference in wait times is above this fraction of the iteration's time
+		float epochThreshold = 0.25f;
+	};
+}
@@ -0,0 +1,246 @@
+#include "Learner.h"
+#include "AutotuneConfig.h"
+
+#include <RLGymPPO_CPP/Threading/ThreadAgentManager.h>
+
+#include <torch/cuda.h>
+#ifdef RG_CUDA_EVENTS
+#include <c10/cuda/CUDACachingAllocator.h>
+#endif
+#include "../libsrc/json/nlohmann/json.hpp"
+
+using namespace RLGPC;
+
+struct _TrialResult {
+	int numThreads, numGamesPerThread, miniBatchSize;
+	double collectedSPS = 0, overallSPS = 0;
+	double peakVRAM = 0; // In GB
+	std::string failReason = {}; // Empty if succeeded
+};
+
+// Runs a short learner with these values, measuring its steps per second
+_TrialResult _RunTrial(EnvCreateFn envCreateFn, const LearnerConfig& baseConfig, const AutotuneConfig& tuneConfig, int numThreads, int numGamesPerThread, int miniBatchSize) {
+	_TrialResult result = {};
+	result.numThreads = numThreads;
+	result.numGamesPerThread = numGamesPerThread;
+	result.miniBatchSize = miniBatchSize;
+
+	RG_LOG("Learner::Autotune(): Trying numThreads=" << numThreads << ", numGamesPerThread=" << numGamesPerThread << ", miniBatchSize=" << miniBatchSize << "...");
+
+	if (baseConfig.ppo.batchSize % miniBatchSize != 0) {
+		result.failReason = "batchSize is not a multiple of miniBatchSize";
+		return result;
+	}
+
+	LearnerConfig config = baseConfig;
+	config.numThreads = numThreads;
+	config.numGamesPerThread = numGamesPerThread;
+	config.ppo.miniBatchSize = miniBatchSize;
+
+	// Nothing from a trial should be kept
+	config.timestepLimit = 0;
+	config.checkpointLoadFolder.clear();
+	config.checkpointSaveFolder.clear();
+	config.sendMetrics = false;
+	config.renderMode = false;
+
+#ifdef RG_CUDA_EVENTS
+	bool useCUDA = config.deviceType != LearnerDeviceType::CPU && torch::cuda::is_available();
+	int numDevices = useCUDA ? (int)torch::cuda::device_count() : 0;
+	for (int i = 0; i < numDevices; i++)
+		c10::cuda::CUDACachingAllocator::resetPeakStats(i);
+#endif
+
+	int iterations = 0, measuredIterations = 0;
+	Learner* learner = NULL;
+	try {
+		learner = new Learner(envCreateFn, config);
+		learner->iterationCallback = [&](Learner* trialLearner, Report& report) {
+			iterations++;
+			if (iterations > tuneConfig.warmupIterations) {
+				result.collectedSPS += report["Collected Steps/Second"];
+				result.overallSPS += report["Overall Steps/Second"];
+				measuredIterations++;
+			}
+
+			// Stops Learn() after this iteration
+			if (measuredIterations >= tuneConfig.trialIterations)
+				trialLearner->config.timestepLimit = trialLearner->totalTimesteps;
+		};
+		learner->Learn();
+	} catch (std::exception& e) {
+		result.failReason = e.what();
+		if (learner)
+			learner->agentMgr->StopAgents();
+	}
+	delete learner;
+
+	if (measuredIterations > 0) {
+		result.collectedSPS /= measuredIterations;
+		result.overallSPS /= measuredIterations;
+	}
+
+	// Without RG_CUDA_EVENTS, there is no CUDA allocator to read, so peakVRAM stays 0
+#ifdef RG_CUDA_EVENTS
+	for (int i = 0; i < numDevices; i++) {
+		auto stats = c10::cuda::CUDACachingAllocator::getDeviceStats(i);
+		auto peakBytes = stats.reserved_bytes[(size_t)c10::cuda::CUDACachingAllocator::StatType::AGGREGATE].peak;
+		result.peakVRAM = RS_MAX(result.peakVRAM, peakBytes / (1024.0 * 1024.0 * 1024.0));
+	}
+#endif
+
+	if (result.failReason.empty() && tuneConfig.maxVRAM > 0 && result.peakVRAM > tuneConfig.maxVRAM)
+		result.failReason = RS_STR("Used " << result.peakVRAM << "GB of VRAM, over the limit of " << tuneConfig.maxVRAM << "GB");
+
+	if (result.failReason.empty()) {
+		RG_LOG(" > Collected Steps/Second: " << (int64_t)result.collectedSPS << ", Overall Steps/Second: " << (int64_t)result.overallSPS);
+	} else {
+		RG_LOG(" > Rejected: " << result.failReason);
+	}
+
+	return result;
+}
+
+LearnerConfig RLGPC::Learner::Autotune(EnvCreateFn envCreateFn, LearnerConfig baseConfig, AutotuneConfig tuneConfig) {
+	using namespace nlohmann;
+
+	RG_LOG("Learner::Autotune():");
+
+	if (baseConfig.ppo.miniBatchSize == 0)
+		baseConfig.ppo.miniBatchSize = baseConfig.ppo.batchSize;
+
+	IList candidates[3] = { tuneConfig.numThreads, tuneConfig.numGamesPerThread, tuneConfig.miniBatchSizes };
+	int baseVals[3] = { baseConfig.numThreads, baseConfig.numGamesPerThread, (int)baseConfig.ppo.miniBatchSize };
+	for (int i = 0; i < 3; i++) {
+		if (candidates[i].empty())
+			candidates[i] = { baseVals[i] };
+		std::sort(candidates[i].begin(), candidates[i].end());
+	}
+
+	typedef std::array<int, 3> Indices;
+	std::map<Indices, _TrialResult> results = {};
+
+	// Returns -1 if the trial failed
+	auto fnEvaluate = [&](const Indices& indices) -> double {
+		auto itr = results.find(indices);
+		if (itr == results.end()) {
+			auto result = _RunTrial(
+				envCreateFn, baseConfig, tuneConfig, 
+				candidates[0][indices[0]], candidates[1][indices[1]], candidates[2][indices[2]]
+			);
+			itr = results.insert({ indices, result }).first;
+		}
+
+		auto& result = itr->second;
+		if (!result.failReason.empty())
+			return -1;
+		return tuneConfig.optimizeCollectedSPS ? result.collectedSPS : result.overallSPS;
+	};
+
+	Indices bestIndices = {};
+	double bestScore = -1;
+	if (tuneConfig.fullGrid) {
+		Indices indices = {};
+		for (indices[0] = 0; indices[0] < candidates[0].size(); indices[0]++) {
+			for (indices[1] = 0; indices[1] < candidates[1].size(); indices[1]++) {
+				for (indices[2] = 0; indices[2] < candidates[2].size(); indices[2]++) {
+					double score = fnEvaluate(indices);
+					if (score > bestScore) {
+						bestScore = score;
+						bestIndices = indices;
+					}
+				}
+			}
+		}
+	} else {
+		// Start from the candidate closest to the base config's value
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < candidates[i].size(); j++)
+				if (abs(candidates[i][j] - baseVals[i]) < abs(candidates[i][bestIndices[i]] - baseVals[i]))
+					bestIndices[i] = j;
+		}
+		bestScore = fnEvaluate(bestIndices);
+
+		bool improved = true;
+		while (improved) {
+			improved = false;
+			for (int i = 0; i < 3; i++) {
+				for (int dir : { -1, 1 }) {
+					Indices next = bestIndices;
+					next[i] += dir;
+					if (next[i] < 0 || next[i] >= candidates[i].size())
+						continue;
+
+					double score = fnEvaluate(next);
+					if (score > bestScore) {
+						bestScore = score;
+						bestIndices = next;
+						improved = true;
+					}
+				}
+			}
+		}
+	}
+
+	if (bestScore < 0)
+		RG_ERR_CLOSE("Learner::Autotune(): All trials failed");
+
+	auto& best = results[bestIndices];
+	RG_LOG("Learner::Autotune(): Best of " << results.size() << " trials:");
+	RG_LOG(" > numThreads: " << best.numThreads);
+	RG_LOG(" > numGamesPerThread: " << best.numGamesPerThread);
+	RG_LOG(" > miniBatchSize: " << best.miniBatchSize);
+	RG_LOG(" > Collected Steps/Second: " << (int64_t)best.collectedSPS << ", Overall Steps/Second: " << (int64_t)best.overallSPS);
+
+	json j = {};
+	j["numThreads"] = best.numThreads;
+	j["numGamesPerThread"] = best.numGamesPerThread;
+	j["miniBatchSize"] = best.miniBatchSize;
+
+	auto& trials = j["trials"];
+	trials = json::array();
+	for (auto& pair : results) {
+		auto& result = pair.second;
+		json trial = {};
+		trial["numThreads"] = result.numThreads;
+		trial["numGamesPerThread"] = result.numGamesPerThread;
+		trial["miniBatchSize"] = result.miniBatchSize;
+		trial["collected_sps"] = result.collectedSPS;
+		trial["overall_sps"] = result.overallSPS;
+		trial["peak_vram_gb"] = result.peakVRAM;
+		if (!result.failReason.empty())
+			trial["fail_reason"] = result.failReason;
+		trials.push_back(trial);
+	}
+
+	std::ofstream fOut(tuneConfig.outputPath);
+	if (!fOut.good())
+		RG_ERR_CLOSE("Learner::Autotune(): Can't open file at " << tuneConfig.outputPath);
+	fOut << j.dump(4);
+	RG_LOG(" > Saved to " << tuneConfig.outputPath);
+
+	LearnerConfig result = baseConfig;
+	result.numThreads = best.numThreads;
+	result.numGamesPerThread = best.numGamesPerThread;
+	result.ppo.miniBatchSize = best.miniBatchSize;
+	return result;
+}
+
+bool RLGPC::Learner::LoadAutotuneResult(std::filesystem::path path, LearnerConfig& config) {
+	using namespace nlohmann;
+
+	std::ifstream fIn(path);
+	if (!fIn.good())
+		return false;
+
+	json j = json::parse(fIn);
+	config.numThreads = j["numThreads"];
+	config.numGamesPerThread = j["numGamesPerThread"];
+	config.ppo.miniBatchSize = j["miniBatchSize"];
+
+	RG_LOG(
+		"Learner::LoadAutotuneResult(): Loaded numThreads=" << config.numThreads << 
+		", numGamesPerThread=" << config.numGamesPerThread << ", miniBatchSize=" << config.ppo.miniBatchSize << " from " << path
+	);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	// Settings for Learner::Autotune()
+	struct AutotuneConfig {
+		// Candidate values to try, leave empty to keep the value from the base config
+		IList numThreads = {};
+		IList numGamesPerThread = {};
+		IList miniBatchSizes = {}; // Values that don't divide ppo.batchSize are skipped
+
+		// Try every combination of candidates, instead of hill-climbing from the base config's values
+		// Hill-climbing moves one candidate at a time to a neighboring value, until no move improves the score
+		bool fullGrid = false;
+
+		// Each trial runs warmupIterations to let collection settle, then measures trialIterations
+		int warmupIterations = 1;
+		int trialIterations = 3;
+
+		// Trials that reserve more than this much GPU memory (in GB) on any GPU are rejected, set to 0 to disable
+		// Not enforced if libtorch was built without CUDA (see RG_CUDA_EVENTS)
+		float maxVRAM = 0;
+
+		// Score trials by "Collected Steps/Second" instead of "Overall Steps/Second"
+		// Only use this if learning is not your bottleneck (e.g. with collectionDuringLearn)
+		bool optimizeCollectedSPS = false;
+
+		// The best values are written here, load them with Learner::LoadAutotuneResult()
+		std::filesystem::path outputPath = "autotune.json";
+	};
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "Learner.h"
+#include "BenchmarkConfig.h"
+
+#include <RLGymPPO_CPP/Threading/ThreadAgentManager.h>
+#include <RLGymPPO_CPP/Util/MemoryInfo.h>
+
+#include <torch/cuda.h>
+#ifdef RG_CUDA_EVENTS
+#include <c10/cuda/CUDACachingAllocator.h>
+#endif
+#include "../libsrc/json/nlohmann/json.hpp"
+
+using namespace RLGPC;
+
+// Resident memory of this process, in MB
+void _GetRSS(double& outCurrent, double& outPeak) {
+	outCurrent = MemoryInfo::GetProcessRSS() / (1024.0 * 1024.0);
+	outPeak = MemoryInfo::GetPeakProcessRSS() / (1024.0 * 1024.0);
+}
+
+struct _BenchResult {
+	int numThreads, numGamesPerThread, batchSize, miniBatchSize;
+	HugePageMode hugePages;
+	bool autocastLearn;
+
+	// Averages of every timing and speed in the reports of measured iterations
+	std::map<std::string, double> metrics = {};
+	int measuredIterations = 0;
+
+	double rss = 0, peakRSS = 0; // In MB, peak is of the whole process so far
+	double hugePagesMB = 0; // Memory of the process in huge pages, measured along with RSS
+	double peakVRAM = 0, peakAllocatedVRAM = 0; // In MB, of the GPU that used the most
+	std::string failReason = {}; // Empty if succeeded
+};
+
+// Only these are averaged, the rest of the report depends on the environment rather than the build
+bool _IsBenchMetric(const std::string& name) {
+	auto fnEndsWith = [&](const char* suffix) {
+		size_t len = strlen(suffix);
+		return name.size() >= len && name.compare(name.size() - len, len, suffix) == 0;
+	};
+	return fnEndsWith(" Time") || fnEndsWith(" Steps/Second") || name == "Avg Inference Batch Size";
+}
+
+// Also averaged, to check that learning with autocast follows the same curve as in fp32
+const char* _LEARN_CURVE_METRICS[] = { "Value Function Loss", "Policy Entropy", "Mean KL Divergence", "SB3 Clip Fraction" };
+
+_BenchResult _RunBench(
+	EnvCreateFn envCreateFn, const LearnerConfig& baseConfig, const BenchmarkConfig& benchConfig, 
+	int numThreads, int numGamesPerThread, int batchSize, int miniBatchSize, HugePageMode hugePages, bool autocastLearn) {
+	_BenchResult result = {};
+	result.numThreads = numThreads;
+	result.numGamesPerThread = numGamesPerThread;
+	result.batchSize = batchSize;
+	result.miniBatchSize = miniBatchSize;
+	result.hugePages = hugePages;
+	result.autocastLearn = autocastLearn;
+
+	RG_LOG(
+		"Learner::Benchmark(): Running numThreads=" << numThreads << ", numGamesPerThread=" << numGamesPerThread << 
+		", batchSize=" << batchSize << ", miniBatchSize=" << miniBatchSize << ", hugePages=" << HugePages::GetModeName(hugePages) << ", autocastLearn=" << autocastLearn << "..."
+	);
+
+	LearnerConfig config = baseConfig;
+	config.numThreads = numThreads;
+	config.numGamesPerThread = numGamesPerThread;
+	config.ppo.batchSize = batchSize;
+	config.ppo.miniBatchSize = miniBatchSize;
+	config.hugePages = hugePages;
+	config.ppo.autocastLearn = autocastLearn;
+
+	// An iteration collects one batch
+	config.timestepsPerIteration = batchSize;
+	config.expBufferSize = RS_MAX(config.expBufferSize, (int64_t)batchSize);
+
+	// Nothing from a run should be kept
+	config.timestepLimit = 0;
+	config.checkpointLoadFolder.clear();
+	config.checkpointSaveFolder.clear();
+	config.sendMetrics = false;
+	config.renderMode = false;
+
+#ifdef RG_CUDA_EVENTS
+	bool useCUDA = config.deviceType != LearnerDeviceType::CPU && torch::cuda::is_available();
+	int numDevices = useCUDA ? (int)torch::cuda::device_count() : 0;
+	for (int i = 0; i < numDevices; i++)
+		c10::cuda::CUDACachingAllocator::resetPeakStats(i);
+#endif
+
+	int iterations = 0;
+	Learner* learner = NULL;
+	try {
+		learner = new Learner(envCreateFn, config);
+		learner->iterationCallback = [&](Learner* benchLearner, Report& report) {
+			iterations++;
+			if (iterations > benchConfig.warmupIterations) {
+				for (auto& pair : report.data)
+					if (_IsBenchMetric(pair.first))
+						result.metrics[pair.first] += pair.second;
+				for (const char* name : _LEARN_CURVE_METRICS)
+					if (report.Has(name))
+						result.metrics[name] += report[name];
+				result.measuredIterations++;
+			}
+
+			if (result.measuredIterations >= benchConfig.measuredIterations) {
+				// Measured while the learner still has all of its memory
+				_GetRSS(result.rss, result.peakRSS);
+				result.hugePagesMB = HugePages::GetProcessHugeBytes() / (1024.0 * 1024.0);
+
+				// Stops Learn() after this iteration
+				benchLearner->config.timestepLimit = benchLearner->totalTimesteps;
+			}
+		};
+		learner->Learn();
+	} catch (std::exception& e) {
+		result.failReason = e.what();
+		if (learner)
+			learner->agentMgr->StopAgents();
+	}
+	delete learner;
+
+	for (auto& pair : result.metrics)
+		pair.second /= RS_MAX(result.measuredIterations, 1);
+
+	// Without RG_CUDA_EVENTS, there is no CUDA allocator to read, so peak VRAM stays 0
+#ifdef RG_CUDA_EVENTS
+	for (int i = 0; i < numDevices; i++) {
+		auto stats = c10::cuda::CUDACachingAllocator::getDeviceStats(i);
+		constexpr size_t AGGREGATE = (size_t)c10::cuda::CUDACachingAllocator::StatType::AGGREGATE;
+		result.peakVRAM = RS_MAX(result.peakVRAM, stats.reserved_bytes[AGGREGATE].peak / (1024.0 * 1024.0));
+		result.peakAllocatedVRAM = RS_MAX(result.peakAllocatedVRAM, stats.allocated_bytes[AGGREGATE].peak / (1024.0 * 1024.0));
+	}
+#endif
+
+	if (result.failReason.empty()) {
+		RG_LOG(
+			" > Collected Steps/Second: " << (int64_t)result.metrics["Collected Steps/Second"] << 
+			", Overall Steps/Second: " << (int64_t)result.metrics["Overall Steps/Second"]
+		);
+	} else {
+		RG_LOG(" > Failed: " << result.failReason);
+	}
+
+	return result;
+}
+
+void RLGPC::Learner::Benchmark(EnvCreateFn envCreateFn, LearnerConfig baseConfig, BenchmarkConfig benchConfig) {
+	using namespace nlohmann;
+
+	RG_LOG("Learner::Benchmark():");
+
+	if (baseConfig.ppo.miniBatchSize == 0)
+		baseConfig.ppo.miniBatchSize = baseConfig.ppo.batchSize;
+
+	IList candidates[4] = { benchConfig.numThreads, benchConfig.numGamesPerThread, benchConfig.batchSizes, benchConfig.miniBatchSizes };
+	int baseVals[4] = { baseConfig.numThreads, baseConfig.numGamesPerThread, (int)baseConfig.ppo.batchSize, (int)baseConfig.ppo.miniBatchSize };
+	for (int i = 0; i < 4; i++)
+		if (candidates[i].empty())
+			candidates[i] = { baseVals[i] };
+
+	std::vector<HugePageMode> hugePageModes = benchConfig.hugePageModes;
+	if (hugePageModes.empty())
+		hugePageModes = { baseConfig.hugePages };
+
+	std::vector<bool> autocastLearnModes = benchConfig.autocastLearnModes;
+	if (autocastLearnModes.empty())
+		autocastLearnModes = { baseConfig.ppo.autocastLearn };
+
+	std::vector<_BenchResult> results = {};
+	for (int numThreads : candidates[0]) {
+		for (int numGamesPerThread : candidates[1]) {
+			for (int batchSize : candidates[2]) {
+				for (int miniBatchSize : candidates[3]) {
+					if (batchSize % miniBatchSize != 0)
+						continue;
+
+					for (HugePageMode hugePages : hugePageModes)
+						for (bool autocastLearn : autocastLearnModes)
+							results.push_back(_RunBench(envCreateFn, baseConfig, benchConfig, numThreads, numGamesPerThread, batchSize, miniBatchSize, hugePages, autocastLearn));
+				}
+			}
+		}
+	}
+
+	json j = {};
+	j["warmup_iterations"] = benchConfig.warmupIterations;
+	j["measured_iterations"] = benchConfig.measuredIterations;
+	j["random_seed"] = baseConfig.randomSeed;
+
+	auto& runs = j["runs"];
+	runs = json::array();
+	for (auto& result : results) {
+		json run = {};
+		run["numThreads"] = result.numThreads;
+		run["numGamesPerThread"] = result.numGamesPerThread;
+		run["batchSize"] = result.batchSize;
+		run["miniBatchSize"] = result.miniBatchSize;
+		run["hugePages"] = HugePages::GetModeName(result.hugePages);
+		run["autocastLearn"] = result.autocastLearn;
+		run["metrics"] = result.metrics;
+		run["rss_mb"] = result.rss;
+		run["peak_rss_mb"] = result.peakRSS;
+		run["huge_pages_mb"] = result.hugePagesMB;
+		run["peak_vram_mb"] = result.peakVRAM;
+		run["peak_allocated_vram_mb"] = result.peakAllocatedVRAM;
+		if (!result.failReason.empty())
+			run["fail_reason"] = result.failReason;
+
+		// Compare autocast runs to the fp32 run with the same settings
+		if (result.autocastLearn && result.failReason.empty()) {
+			for (auto& other : results) {
+				if (other.autocastLearn || !other.failReason.empty() ||
+					other.numThreads != result.numThreads || other.numGamesPerThread != result.numGamesPerThread ||
+					other.batchSize != result.batchSize || other.miniBatchSize != result.miniBatchSize || other.hugePages != result.hugePages)
+					continue;
+
+				double learnTime = result.metrics["PPO Learn Time"], fp32LearnTime = other.metrics["PPO Learn Time"];
+				double speedup = learnTime > 0 ? fp32LearnTime / learnTime : 0;
+				run["autocast_learn_speedup"] = speedup;
+
+				std::stringstream curveDiffs;
+				for (const char* name : _LEARN_CURVE_METRICS) {
+					if (!result.metrics.count(name) || !other.metrics.count(name))
+						continue;
+
+					// Relative to the fp32 value
+					double fp32Val = other.metrics[name];
+					double relDiff = fp32Val != 0 ? (result.metrics[name] - fp32Val) / abs(fp32Val) : 0;
+					run["autocast_learn_curve_diffs"][name] = relDiff;
+					curveDiffs << ", " << name << " " << (relDiff >= 0 ? "+" : "") << (relDiff * 100) << "%";
+				}
+
+				RG_LOG(
+					"Learner::Benchmark(): Autocast learning is " << speedup << "x as fast as fp32 for numThreads=" << result.numThreads <<
+					", batchSize=" << result.batchSize << ", miniBatchSize=" << result.miniBatchSize << curveDiffs.str()
+				);
+				break;
+			}
+		}
+
+		runs.push_back(run);
+	}
+
+	std::ofstream fOut(benchConfig.outputPath);
+	if (!fOut.good())
+		RG_ERR_CLOSE("Learner::Benchmark(): Can't open file at " << benchConfig.outputPath);
+	fOut << j.dump(4);
+	RG_LOG("Learner::Benchmark(): Wrote " << results.size() << " run(s) to " << benchConfig.outputPath);
+}
\ No newline at end of file
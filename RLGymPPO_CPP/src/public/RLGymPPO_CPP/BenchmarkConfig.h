@@ -0,0 +1,25 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	// Settings for Learner::Benchmark()
+	struct BenchmarkConfig {
+		// Every combination of these is run, leave a list empty to keep the value from the base config
+		IList numThreads = {};
+		IList numGamesPerThread = {};
+		IList batchSizes = {};
+		IList miniBatchSizes = {}; // Combinations where this doesn't divide the batch size are skipped
+		std::vector<HugePageMode> hugePageModes = {}; // See LearnerConfig::hugePages
+
+		// See PPOLearnerConfig::autocastLearn, e.g. { false, true } to compare bf16 learning against fp32
+		// Runs with autocast also report their learn speedup and loss differences over the matching fp32 run
+		std::vector<bool> autocastLearnModes = {};
+
+		// Each run does warmupIterations to let collection settle, then measures the average of measuredIterations
+		int warmupIterations = 1;
+		int measuredIterations = 5;
+
+		// Results of every run are written here as JSON
+		std::filesystem::path outputPath = "bench_ppo.json";
+	};
+}
\ No newline at end of file
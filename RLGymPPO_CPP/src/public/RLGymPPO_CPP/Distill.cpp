@@ -0,0 +1,140 @@
+#include "Learner.h"
+#include "DistillConfig.h"
+
+#include <RLGymPPO_CPP/PPO/PPOLearner.h>
+#include <RLGymPPO_CPP/PPO/PolicyDistiller.h>
+#include <RLGymPPO_CPP/Threading/ThreadAgentManager.h>
+#include <RLGymPPO_CPP/Util/MetricFileWriter.h>
+#include <RLGymPPO_CPP/Util/RolloutDataset.h>
+
+using namespace RLGPC;
+
+// From Learner.cpp
+void DisplayReport(const RLGPC::Report& report);
+
+void RLGPC::Learner::Distill(DistillConfig distillConfig) {
+	RG_LOG("Learner::Distill():");
+
+	if (distillConfig.studentLayerSizes.empty())
+		RG_ERR_CLOSE("Learner::Distill(): No student layer sizes given");
+
+	DiscretePolicy* teacher = ppo->policy;
+	PolicyDistiller distiller = PolicyDistiller(teacher, distillConfig.studentLayerSizes, distillConfig.learningRate);
+
+	auto fnParamCount = [](DiscretePolicy* policy) {
+		int64_t count = 0;
+		for (auto& param : policy->parameters())
+			count += param.numel();
+		return count;
+	};
+	RG_LOG("\tTeacher parameters: " << fnParamCount(teacher) << ", student parameters: " << fnParamCount(distiller.student));
+
+	// Pinned batches are copied to the GPU asynchronously, so the next batch is drawn while the GPU trains on this one
+	bool pinned = ppo->device.is_cuda();
+
+	// Summed on the device, and only read once per report
+	torch::Tensor klSum = torch::zeros({}, ppo->device), agreementSum = torch::zeros({}, ppo->device);
+	int batchesSinceReport = 0;
+	int64_t rowsSinceReport = 0;
+	uint64_t totalBatches = 0;
+	Timer reportTimer = {};
+
+	auto fnSave = [&]() {
+		distiller.SaveTo(distillConfig.outputFolder);
+
+		// Has the OBS stats that the student standardizes with, which PolicyInferUnit loads
+		SaveStats(distillConfig.outputFolder / STATS_FILE_NAME);
+	};
+
+	auto fnReport = [&](int epoch) {
+		Report report = {};
+		report["Distill KL Divergence"] = (klSum / batchesSinceReport).item<float>();
+		report["Distill Action Agreement"] = (agreementSum / batchesSinceReport).item<float>();
+		report["Distill Rows/Second"] = (int64_t)(rowsSinceReport / reportTimer.Elapsed());
+		report["Distill Epoch"] = epoch;
+		report["Distill Batches"] = totalBatches;
+
+		RG_LOG("Distill report:");
+		DisplayReport(report);
+
+		if (metricSender)
+			metricSender->Send(report);
+		if (metricFileWriter)
+			metricFileWriter->Write(report);
+
+		klSum.zero_();
+		agreementSum.zero_();
+		batchesSinceReport = 0;
+		rowsSinceReport = 0;
+		reportTimer.Reset();
+	};
+
+	auto fnTrainBatch = [&](torch::Tensor obs, int epoch) {
+		auto result = distiller.Step(teacher, obs);
+		klSum += result.kl;
+		agreementSum += result.agreement;
+		batchesSinceReport++;
+		rowsSinceReport += obs.size(0);
+		totalBatches++;
+
+		if (batchesSinceReport >= distillConfig.batchesPerReport)
+			fnReport(epoch);
+
+		if (distillConfig.batchesPerSave > 0 && totalBatches % distillConfig.batchesPerSave == 0)
+			fnSave();
+	};
+
+	int epoch = 0;
+	if (!distillConfig.datasetPaths.empty()) {
+		RG_LOG("\tLoading dataset...");
+		RolloutDataset dataset = RolloutDataset(
+			distillConfig.datasetPaths, distillConfig.numWorkers, distillConfig.shuffleWindowSize, distillConfig.seed
+		);
+		RG_LOG("\t > " << dataset.totalRows << " rows in " << dataset.chunks.size() << " chunks, from " << dataset.files.size() << " file(s)");
+
+		if (dataset.obsSize != obsSize)
+			RG_ERR_CLOSE("Learner::Distill(): Dataset has an OBS size of " << dataset.obsSize << ", but our OBS size is " << obsSize);
+
+		for (; epoch < distillConfig.epochs; epoch++) {
+			RG_LOG("\tDistilling epoch " << (epoch + 1) << "/" << distillConfig.epochs << "...");
+			dataset.StartEpoch();
+
+			// Recorded actions are unused, the teacher's action distribution is the target
+			torch::Tensor obs, actions;
+			while (dataset.GetBatch(distillConfig.batchSize, obs, actions, pinned))
+				fnTrainBatch(obs, epoch);
+		}
+	} else {
+		// Agents play with the teacher, so the student learns on the states the teacher reaches
+		agentMgr->SetStepCallback(stepCallback);
+		agentMgr->SetBatchStepCallback(batchStepCallback);
+		if (agentMgr->agentsStarted) {
+			agentMgr->SetCollectionDisabled(false);
+		} else {
+			agentMgr->StartAgents();
+		}
+
+		for (int i = 0; i < distillConfig.numCollections; i++) {
+			RG_LOG("\tCollecting " << distillConfig.timestepsPerCollection << " steps (" << (i + 1) << "/" << distillConfig.numCollections << ")...");
+			GameTrajectory traj = agentMgr->CollectTimesteps(distillConfig.timestepsPerCollection);
+			torch::Tensor obs = traj.data.states.to(ppo->device, true);
+			int64_t numRows = obs.size(0);
+
+			for (epoch = 0; epoch < distillConfig.epochs; epoch++) {
+				auto order = torch::randperm(numRows, torch::TensorOptions().dtype(torch::kInt64).device(ppo->device));
+				for (int64_t start = 0; start < numRows; start += distillConfig.batchSize) {
+					int64_t end = RS_MIN(start + distillConfig.batchSize, numRows);
+					fnTrainBatch(obs.index_select(0, order.slice(0, start, end)), epoch);
+				}
+			}
+		}
+
+		agentMgr->SetCollectionDisabled(true);
+	}
+
+	if (batchesSinceReport > 0)
+		fnReport(RS_MAX(epoch - 1, 0));
+
+	fnSave();
+	RG_LOG("Learner::Distill(): Finished after " << totalBatches << " batches, saved student to " << distillConfig.outputFolder);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	// Settings for Learner::Distill()
+	struct DistillConfig {
+		// Hidden layer sizes of the student policy
+		// Load the student with these as the policyLayerSizes of PolicyInferUnit
+		IList studentLayerSizes = { 128, 128 };
+
+		// Folder the student is saved to, as a policy file and stats file like those of checkpoint folders
+		std::filesystem::path outputFolder = "distilled";
+
+		// Files written by the rollout recorder (see LearnerConfig::rolloutRecordPath), or folders of them
+		// If empty, observations are collected by our agents, playing with the teacher (our policy)
+		std::vector<std::filesystem::path> datasetPaths = {};
+
+		// Epochs over the datasets, or over each collection of observations
+		int epochs = 1;
+
+		// Only used without datasets: amount of times observations are collected, and steps in each collection
+		int numCollections = 10;
+		int64_t timestepsPerCollection = 200 * 1000;
+
+		int64_t batchSize = 4096;
+		float learningRate = 3e-4f;
+
+		// Only used with datasets, same as in PretrainConfig
+		int numWorkers = 4;
+		int64_t shuffleWindowSize = 1000 * 1000;
+		uint64_t seed = 0;
+
+		// KL divergence and action agreement are reported every this many batches, to the same places as learn iteration metrics
+		int batchesPerReport = 500;
+
+		// Save the student every this many batches, set to 0 to only save once distillation finishes
+		int batchesPerSave = 0;
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	// Settings for Learner::Evaluate()
+	struct EvalConfig {
+		// Policies to play against each other, at least 2
+		// Each can be a policy file from a checkpoint folder, or a single-file checkpoint (see PolicyInferUnit)
+		std::vector<std::filesystem::path> policyPaths = {};
+
+		// Layer sizes of every policy (see PPOLearnerConfig::policyLayerSizes)
+		IList policyLayerSizes = { 256, 256, 256 };
+
+		// Every pair of policies plays this many episodes against each other, swapping sides every episode
+		// Episodes end with the environment's terminal conditions, the team that scored more goals wins
+		int episodesPerPair = 200;
+
+		// Episodes longer than this are ended as they are, set to 0 to only use the environment's terminal conditions
+		float maxEpisodeSeconds = 300;
+
+		// Each thread steps this many arenas at once, inferring all players of each policy in one batch
+		int numThreads = 8;
+		int arenasPerThread = 32;
+
+		// Sample actions instead of always picking the most likely one
+		// Results are then only reproducible with native inference, which has its own seeded RNG
+		bool stochastic = false;
+
+		bool gpu = false;
+		bool nativeInference = false; // See LearnerConfig::nativeInference, gpu is ignored if set
+
+		// Arenas are seeded from this, so results only depend on it and the policies, set to -1 for a random seed
+		int randomSeed = 0;
+
+		// Ratings are fitted to all results (Bradley-Terry), and shifted so that their average is this
+		float averageElo = 1500;
+
+		// A summary of every pair and policy is written here as JSON
+		std::filesystem::path outputPath = "eval.json";
+	};
+}
\ No newline at end of file
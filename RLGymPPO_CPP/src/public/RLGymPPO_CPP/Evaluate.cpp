@@ -0,0 +1,399 @@
+#include "Learner.h"
+#include "EvalConfig.h"
+
+#include "Util/PolicyInferUnit.h"
+#include "Util/Timer.h"
+#include "Threading/GymBatch.h"
+#include <RLGymPPO_CPP/FrameworkTorch.h>
+
+#include "../libsrc/json/nlohmann/json.hpp"
+
+using namespace RLGPC;
+using namespace RLGSC;
+
+// Results of one pair of policies, from the side of the first policy (A)
+struct _EvalPairResult {
+	int policyA, policyB;
+	int episodes = 0, winsA = 0, winsB = 0, draws = 0;
+	int64_t goalsA = 0, goalsB = 0;
+	int timeouts = 0; // Episodes ended by maxEpisodeSeconds
+
+	void Add(const _EvalPairResult& other) {
+		episodes += other.episodes;
+		winsA += other.winsA;
+		winsB += other.winsB;
+		draws += other.draws;
+		goalsA += other.goalsA;
+		goalsB += other.goalsB;
+		timeouts += other.timeouts;
+	}
+};
+
+// Episodes of a pair that one thread plays with all of its arenas
+struct _EvalJob {
+	int pairIndex;
+	int firstEpisode, numEpisodes;
+};
+
+struct _EvalShared {
+	EnvCreateFn envCreateFn;
+	const EvalConfig* config;
+	int obsSize;
+
+	std::vector<_EvalJob> jobs = {};
+	std::atomic<int> nextJob = 0;
+
+	std::mutex resultMutex = {};
+	std::vector<_EvalPairResult> pairResults = {};
+	std::atomic<int64_t> totalSteps = 0;
+	std::atomic<double> totalGameTime = 0; // In seconds
+};
+
+// State of one of a thread's arenas
+struct _EvalArena {
+	bool active = false;
+	bool aIsBlue;
+	int stepsLeft;
+	ScoreLine startScore;
+};
+
+void _RunEvalThread(_EvalShared* shared) {
+	RG_NOGRAD;
+	torch::set_num_threads(1);
+
+	auto& config = *shared->config;
+
+	GymBatch games = {};
+	for (int i = 0; i < config.arenasPerThread; i++) {
+		auto envCreateResult = shared->envCreateFn();
+		games.Add(new GameInst(envCreateResult.gym, envCreateResult.match));
+		envCreateResult.match->AddExtraStateFields(RLGSC::StateFields::SCORE_LINE);
+	}
+
+	int obsSize = shared->obsSize;
+	int totalPlayers = games.totalPlayers;
+	FList obsBuffer = FList((size_t)totalPlayers * obsSize);
+	games.SetOBSOutput(obsBuffer.data(), obsSize);
+
+	// Our own units, as they are not thread-safe
+	// Our games' builders and parsers are only used for their action amount, observations are built by the games
+	auto firstMatch = games.games[0]->match;
+	std::vector<PolicyInferUnit*> units = {};
+	for (auto& path : config.policyPaths) {
+		units.push_back(new PolicyInferUnit(
+			firstMatch->obsBuilder, firstMatch->actionParser,
+			path, obsSize, config.policyLayerSizes, config.gpu, config.nativeInference
+		));
+	}
+
+	std::vector<_EvalArena> arenas = std::vector<_EvalArena>(games.Size());
+	std::vector<int64_t> actions = std::vector<int64_t>(totalPlayers);
+
+	// Rows of obsBuffer that each side of the pair infers, gathered into one batch per side
+	IList sideRows[2] = {};
+	FList sideOBS[2] = {};
+	std::vector<int64_t> sideActions[2] = {};
+
+	while (true) {
+		int jobIndex = shared->nextJob++;
+		if (jobIndex >= shared->jobs.size())
+			break;
+
+		auto& job = shared->jobs[jobIndex];
+		auto& pair = shared->pairResults[job.pairIndex];
+		PolicyInferUnit* sideUnits[2] = { units[pair.policyA], units[pair.policyB] };
+
+		_EvalPairResult result = {};
+		int episodesStarted = 0;
+		int64_t steps = 0;
+		double gameTime = 0;
+
+		// Seeded by the job, so results don't depend on which thread runs it
+		if (config.randomSeed >= 0)
+			for (auto unit : units)
+				unit->nativeRNG.seed(((uint64_t)config.randomSeed << 32) ^ jobIndex);
+
+		auto fnStartEpisode = [&](int gameIndex) {
+			auto game = games.games[gameIndex];
+			auto& arena = arenas[gameIndex];
+			if (episodesStarted >= job.numEpisodes) {
+				arena.active = false;
+				return;
+			}
+
+			// Sides swap every episode of the pair
+			int episodeIndex = job.firstEpisode + episodesStarted;
+			if (config.randomSeed >= 0)
+				game->match->randEngine.Seed(((uint64_t)config.randomSeed << 32) | ((uint64_t)job.pairIndex << 24) | episodeIndex);
+
+			// Games reset themselves when done, but again here so that the episode starts from the seeded state
+			game->Start();
+			arena.active = true;
+			arena.aIsBlue = (episodeIndex % 2 == 0);
+			arena.startScore = game->gym->prevState.scoreLine;
+			arena.stepsLeft = config.maxEpisodeSeconds > 0 ? RS_MAX((int)roundf(config.maxEpisodeSeconds / game->gym->GetStepTime()), 1) : INT_MAX;
+			episodesStarted++;
+		};
+
+		// Counts the goals of the arena's episode, and starts its next episode
+		auto fnEndEpisode = [&](int gameIndex, const ScoreLine& endScore, bool timedOut) {
+			auto& arena = arenas[gameIndex];
+			int blueGoals = endScore[(int)Team::BLUE] - arena.startScore[(int)Team::BLUE];
+			int orangeGoals = endScore[(int)Team::ORANGE] - arena.startScore[(int)Team::ORANGE];
+			int goalsA = arena.aIsBlue ? blueGoals : orangeGoals;
+			int goalsB = arena.aIsBlue ? orangeGoals : blueGoals;
+
+			result.episodes++;
+			result.goalsA += goalsA;
+			result.goalsB += goalsB;
+			result.timeouts += timedOut;
+			if (goalsA > goalsB) {
+				result.winsA++;
+			} else if (goalsB > goalsA) {
+				result.winsB++;
+			} else {
+				result.draws++;
+			}
+
+			fnStartEpisode(gameIndex);
+		};
+
+		for (int i = 0; i < games.Size(); i++)
+			fnStartEpisode(i);
+
+		while (true) {
+			for (int side = 0; side < 2; side++) {
+				sideRows[side].clear();
+				sideOBS[side].clear();
+			}
+
+			// Gather each side's observations
+			bool anyActive = false;
+			for (int i = 0; i < games.Size(); i++) {
+				auto& arena = arenas[i];
+				if (!arena.active)
+					continue;
+				anyActive = true;
+
+				auto& players = games.games[i]->gym->prevState.players;
+				for (int j = 0; j < players.size(); j++) {
+					int side = ((players[j].team == Team::BLUE) == arena.aIsBlue) ? 0 : 1;
+					int row = games.playerStart[i] + j;
+					const float* rowOBS = obsBuffer.data() + (size_t)row * obsSize;
+					sideRows[side].push_back(row);
+					sideOBS[side].insert(sideOBS[side].end(), rowOBS, rowOBS + obsSize);
+				}
+			}
+
+			if (!anyActive)
+				break;
+
+			for (int side = 0; side < 2; side++) {
+				int amount = sideRows[side].size();
+				if (amount == 0)
+					continue;
+
+				sideActions[side].resize(amount);
+				sideUnits[side]->InferActions(sideOBS[side].data(), amount, sideActions[side].data(), !config.stochastic);
+				for (int i = 0; i < amount; i++)
+					actions[sideRows[side][i]] = sideActions[side][i];
+			}
+
+			for (int i = 0; i < games.Size(); i++) {
+				auto& arena = arenas[i];
+				if (!arena.active)
+					continue;
+
+				auto game = games.games[i];
+				auto& stepResult = game->Step(actions.data() + games.playerStart[i]);
+				gameTime += game->gym->GetStepTime();
+				steps++;
+
+				// The result keeps the state from before the game reset
+				arena.stepsLeft--;
+				if (stepResult.done) {
+					fnEndEpisode(i, stepResult.state.scoreLine, false);
+				} else if (arena.stepsLeft <= 0) {
+					fnEndEpisode(i, game->gym->prevState.scoreLine, true);
+				}
+			}
+		}
+
+		shared->totalGameTime += gameTime;
+		shared->totalSteps += steps;
+
+		std::lock_guard<std::mutex> lock(shared->resultMutex);
+		pair.Add(result);
+		RG_LOG(" > Finished episodes " << job.firstEpisode << "-" << (job.firstEpisode + job.numEpisodes) << " of pair " << pair.policyA << " vs " << pair.policyB);
+	}
+
+	for (auto unit : units)
+		delete unit;
+}
+
+// Fits a Bradley-Terry strength to each policy, with the MM algorithm (Hunter, 2004), then converts them to Elo
+// Draws count as half a win for both, and every pair gets one virtual draw, so that undefeated policies have a finite rating
+std::vector<double> _FitElo(const std::vector<_EvalPairResult>& pairResults, int numPolicies, double averageElo) {
+	std::vector<double> wins = std::vector<double>(numPolicies, 0);
+	std::vector<std::vector<double>> games = std::vector<std::vector<double>>(numPolicies, std::vector<double>(numPolicies, 0));
+	for (auto& pair : pairResults) {
+		wins[pair.policyA] += pair.winsA + pair.draws * 0.5 + 0.5;
+		wins[pair.policyB] += pair.winsB + pair.draws * 0.5 + 0.5;
+		games[pair.policyA][pair.policyB] += pair.episodes + 1;
+		games[pair.policyB][pair.policyA] += pair.episodes + 1;
+	}
+
+	constexpr int ITERATIONS = 1000;
+	std::vector<double> strengths = std::vector<double>(numPolicies, 1);
+	for (int itr = 0; itr < ITERATIONS; itr++) {
+		std::vector<double> newStrengths = std::vector<double>(numPolicies);
+		for (int i = 0; i < numPolicies; i++) {
+			double denom = 0;
+			for (int j = 0; j < numPolicies; j++)
+				if (j != i && games[i][j] > 0)
+					denom += games[i][j] / (strengths[i] + strengths[j]);
+			newStrengths[i] = denom > 0 ? wins[i] / denom : strengths[i];
+		}
+
+		// Strengths are only relative, keep their geometric mean at 1
+		double logMean = 0;
+		for (double strength : newStrengths)
+			logMean += log(strength);
+		logMean /= numPolicies;
+		for (double& strength : newStrengths)
+			strength /= exp(logMean);
+
+		strengths = newStrengths;
+	}
+
+	std::vector<double> elos = {};
+	for (double strength : strengths)
+		elos.push_back(averageElo + 400 * log10(strength));
+	return elos;
+}
+
+void RLGPC::Learner::Evaluate(EnvCreateFn envCreateFn, EvalConfig evalConfig) {
+	using namespace nlohmann;
+
+	RG_LOG("Learner::Evaluate():");
+
+	int numPolicies = evalConfig.policyPaths.size();
+	if (numPolicies < 2)
+		RG_ERR_CLOSE("Learner::Evaluate(): Need at least 2 policies, got " << numPolicies);
+	if (evalConfig.numThreads < 1 || evalConfig.arenasPerThread < 1 || evalConfig.episodesPerPair < 1)
+		RG_ERR_CLOSE("Learner::Evaluate(): numThreads, arenasPerThread and episodesPerPair must be at least 1");
+
+	if (RocketSim::GetStage() != RocketSimStage::INITIALIZED) {
+		RG_LOG("\tInitializing RocketSim...");
+		RocketSim::Init("collision_meshes", true, RocketSim::InitModes::Lazy());
+	}
+
+	if (evalConfig.randomSeed < 0)
+		evalConfig.randomSeed = std::random_device()() & INT_MAX;
+
+	_EvalShared shared = {};
+	shared.envCreateFn = envCreateFn;
+	shared.config = &evalConfig;
+	{
+		RG_LOG("\tCreating test environment to determine OBS size...");
+		auto envCreateResult = envCreateFn();
+		auto obsSet = envCreateResult.gym->Reset();
+		shared.obsSize = obsSet[0].size();
+		RG_LOG("\t\tOBS size: " << shared.obsSize);
+		delete envCreateResult.gym;
+		delete envCreateResult.match;
+	}
+
+	// Pairs are split into jobs of a few episodes per arena, so that a pair can be spread over every thread
+	int jobEpisodes = evalConfig.arenasPerThread * 4;
+	for (int i = 0; i < numPolicies; i++) {
+		for (int j = i + 1; j < numPolicies; j++) {
+			int pairIndex = shared.pairResults.size();
+			_EvalPairResult pair = {};
+			pair.policyA = i;
+			pair.policyB = j;
+			shared.pairResults.push_back(pair);
+
+			for (int start = 0; start < evalConfig.episodesPerPair; start += jobEpisodes)
+				shared.jobs.push_back({ pairIndex, start, RS_MIN(jobEpisodes, evalConfig.episodesPerPair - start) });
+		}
+	}
+
+	RG_LOG(
+		"\tPlaying " << shared.pairResults.size() << " pair(s) of " << evalConfig.episodesPerPair << " episodes on " <<
+		evalConfig.numThreads << " thread(s) of " << evalConfig.arenasPerThread << " arenas..."
+	);
+
+	Timer timer = {};
+	std::vector<std::thread> threads = {};
+	for (int i = 0; i < RS_MIN(evalConfig.numThreads, (int)shared.jobs.size()); i++)
+		threads.push_back(std::thread(_RunEvalThread, &shared));
+	for (auto& thread : threads)
+		thread.join();
+	double elapsed = timer.Elapsed();
+
+	auto elos = _FitElo(shared.pairResults, numPolicies, evalConfig.averageElo);
+
+	json j = {};
+	j["random_seed"] = evalConfig.randomSeed;
+	j["episodes_per_pair"] = evalConfig.episodesPerPair;
+	j["stochastic"] = evalConfig.stochastic;
+	j["elapsed_seconds"] = elapsed;
+	j["steps_per_second"] = shared.totalSteps / RS_MAX(elapsed, 1e-6);
+
+	// Seconds of game time played per second, in every arena together
+	j["realtime_factor"] = shared.totalGameTime / RS_MAX(elapsed, 1e-6);
+
+	std::vector<_EvalPairResult> policyTotals = std::vector<_EvalPairResult>(numPolicies);
+	auto& pairs = j["pairs"];
+	pairs = json::array();
+	for (auto& pair : shared.pairResults) {
+		json jPair = {};
+		jPair["policy_a"] = pair.policyA;
+		jPair["policy_b"] = pair.policyB;
+		jPair["episodes"] = pair.episodes;
+		jPair["wins_a"] = pair.winsA;
+		jPair["wins_b"] = pair.winsB;
+		jPair["draws"] = pair.draws;
+		jPair["timeouts"] = pair.timeouts;
+		jPair["goals_a"] = pair.goalsA;
+		jPair["goals_b"] = pair.goalsB;
+		jPair["win_rate_a"] = (pair.winsA + pair.draws * 0.5) / RS_MAX(pair.episodes, 1);
+		jPair["goal_diff_per_episode_a"] = (double)(pair.goalsA - pair.goalsB) / RS_MAX(pair.episodes, 1);
+		pairs.push_back(jPair);
+
+		// Totals of each policy, from its own side
+		_EvalPairResult flipped = pair;
+		std::swap(flipped.winsA, flipped.winsB);
+		std::swap(flipped.goalsA, flipped.goalsB);
+		policyTotals[pair.policyA].Add(pair);
+		policyTotals[pair.policyB].Add(flipped);
+	}
+
+	auto& policies = j["policies"];
+	policies = json::array();
+	RG_LOG("Learner::Evaluate(): Results:");
+	for (int i = 0; i < numPolicies; i++) {
+		auto& total = policyTotals[i];
+		double winRate = (total.winsA + total.draws * 0.5) / RS_MAX(total.episodes, 1);
+
+		json jPolicy = {};
+		jPolicy["path"] = evalConfig.policyPaths[i].string();
+		jPolicy["elo"] = elos[i];
+		jPolicy["episodes"] = total.episodes;
+		jPolicy["wins"] = total.winsA;
+		jPolicy["losses"] = total.winsB;
+		jPolicy["draws"] = total.draws;
+		jPolicy["win_rate"] = winRate;
+		jPolicy["goal_diff_per_episode"] = (double)(total.goalsA - total.goalsB) / RS_MAX(total.episodes, 1);
+		policies.push_back(jPolicy);
+
+		RG_LOG(" > [" << i << "] " << evalConfig.policyPaths[i] << ": Elo " << (int)round(elos[i]) << ", win rate " << RS_STR(std::fixed << std::setprecision(3) << winRate));
+	}
+
+	std::ofstream fOut(evalConfig.outputPath);
+	if (!fOut.good())
+		RG_ERR_CLOSE("Learner::Evaluate(): Can't open file at " << evalConfig.outputPath);
+	fOut << j.dump(4);
+	RG_LOG("Learner::Evaluate(): Wrote results to " << evalConfig.outputPath << " (" << RS_STR(std::fixed << std::setprecision(1) << j["realtime_factor"].get<double>()) << "x realtime)");
+}
\ No newline at end of file
@@ -2,11 +2,127 @@
 
 #include <RLGymPPO_CPP/PPO/PPOLearner.h>
 #include <RLGymPPO_CPP/PPO/ExperienceBuffer.h>
+#include <RLGymPPO_CPP/PPO/OpponentPool.h>
 #include <RLGymPPO_CPP/Threading/ThreadAgentManager.h>
+#include <RLGymPPO_CPP/Threading/CoreScheduler.h>
+#include <RLGymPPO_CPP/Threading/JobSystem.h>
+#include <RLGymPPO_CPP/Threading/ProcessWorker.h>
+#include <RLGymPPO_CPP/Util/CheckpointWriter.h>
+#include <RLGymPPO_CPP/Util/CheckpointFile.h>
+#include <RLGymPPO_CPP/Util/MetricFileWriter.h>
+#include <RLGymPPO_CPP/Util/MetricsHTTPServer.h>
+#include <RLGymPPO_CPP/Util/RolloutRecorder.h>
+#include <RLGymPPO_CPP/Util/TraceRecorder.h>
+#include <RLGymPPO_CPP/Util/SamplingProfiler.h>
+#include <RLGymPPO_CPP/Util/MemoryInfo.h>
+#include <RLGymPPO_CPP/Util/MemoryPlanner.h>
+#include <RLGymPPO_CPP/Util/RegressionDetector.h>
+#include <RLGymPPO_CPP/Util/CPUAffinity.h>
+#include <RLGymSim_CPP/Utils/AllocTracker/AllocTracker.h>
 
 #include <torch/cuda.h>
+#include <ATen/CPUGeneratorImpl.h>
+#include <ATen/cuda/CUDAEvent.h>
 #include "../libsrc/json/nlohmann/json.hpp"
+#ifndef RG_NO_PYTHON
 #include <pybind11/embed.h>
+#endif
+
+namespace RLGPC {
+	// Everything computed from a trajectory before it is added to the experience buffer
+	struct TrajExperience {
+		torch::Tensor advantages, valueTargets;
+		torch::Tensor logProbs, isWeights; // See LearnerConfig::offPolicyCorrection
+		FList returns;
+		int64_t size = 0, numStale = 0;
+		double staleISWeightSum = 0;
+
+		// Combines experience from consecutive trajectories, in order
+		static TrajExperience Concat(const std::vector<TrajExperience>& parts) {
+			TrajExperience result = {};
+			std::vector<torch::Tensor> advantageParts, valueTargetParts, logProbParts, isWeightParts;
+			for (auto& part : parts) {
+				advantageParts.push_back(part.advantages);
+				valueTargetParts.push_back(part.valueTargets);
+				logProbParts.push_back(part.logProbs);
+				isWeightParts.push_back(part.isWeights);
+				result.returns.insert(result.returns.end(), part.returns.begin(), part.returns.end());
+				result.size += part.size;
+				result.numStale += part.numStale;
+				result.staleISWeightSum += part.staleISWeightSum;
+			}
+
+			result.advantages = torch::cat(advantageParts);
+			result.valueTargets = torch::cat(valueTargetParts);
+			result.logProbs = torch::cat(logProbParts);
+			result.isWeights = torch::cat(isWeightParts);
+			return result;
+		}
+	};
+
+	// Experience of the segments collected so far this iteration
+	struct SegmentExperience {
+		std::vector<TrajExperience> parts;
+		int64_t size = 0;
+
+		// With config.streamingLearnFraction, segments are added to the experience buffer as they arrive
+		int64_t submittedSize = 0;
+		double submitTime = 0;
+		bool streamed = false; // If the first epoch already ran on the submitted segments
+		double streamedEpochTime = 0;
+	};
+
+	// A policy that plays some player slots of every game (see LearnerConfig::playerPolicyIDs), or some whole games (see LearnerConfig::gamePolicyConfigs), learned only from their steps
+	struct ExtraPolicy {
+		int id = 0;
+		PPOLearner* ppo = NULL;
+		ExperienceBuffer* expBuffer = NULL;
+		WelfordRunningStat returnStats = WelfordRunningStat(1);
+
+		// Subfolder of each checkpoint that we are saved to
+		std::string GetFolderName() const {
+			return "policy_" + std::to_string(id);
+		}
+
+		std::string GetMetricPrefix() const {
+			return "Policy " + std::to_string(id) + " ";
+		}
+
+		~ExtraPolicy() {
+			delete ppo;
+			delete expBuffer;
+		}
+	};
+}
+
+// Parses a torch device string from the config
+at::Device _ParseDevice(const std::string& str, const char* name) {
+	try {
+		return at::Device(str);
+	} catch (std::exception& e) {
+		RG_ERR_CLOSE("Learner::Learner(): config." << name << " is not a valid device (\"" << str << "\")");
+		return at::Device(at::kCPU);
+	}
+}
+
+// Moves a tensor to the device and back to make sure the device is working
+void _TestCUDADevice(at::Device device) {
+	bool deviceTestFailed = false;
+	try {
+		torch::Tensor t = torch::tensor(0);
+		t = t.to(device);
+		t = t.cpu();
+	} catch (...) {
+		deviceTestFailed = true;
+	}
+
+	if (!torch::cuda::is_available() || deviceTestFailed)
+		RG_ERR_CLOSE(
+			"Learner::Learner(): Can't use CUDA GPU because " <<
+			(torch::cuda::is_available() ? "libtorch cannot access the GPU" : "CUDA is not available to libtorch") << ".\n" <<
+			"Make sure your libtorch comes with CUDA support, and that CUDA is installed properly."
+		)
+}
 
 RLGPC::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig _config) :
 	envCreateFn(envCreateFn),
@@ -15,7 +131,11 @@ RLGPC::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig _config) :
 	torch::set_num_interop_threads(1);
 	torch::set_num_threads(1);
 
-	pybind11::initialize_interpreter();
+	// We were started by another learner to collect for it (see LearnerConfig::numProcessWorkers)
+	if (ProcessWorker::IsWorkerProcess()) {
+		ProcessWorker::Run(envCreateFn, config);
+		exit(0);
+	}
 
 #ifndef NDEBUG
 	RG_LOG("===========================");
@@ -27,9 +147,6 @@ RLGPC::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig _config) :
 	if (config.timestepsPerSave == 0)
 		config.timestepsPerSave = config.timestepsPerIteration;
 
-	if (config.standardizeOBS)
-		RG_ERR_CLOSE("LearnerConfig.standardizeOBS has not yet been implemented, sorry");
-
 	RG_LOG("Learner::Learner():");
 	
 	if (config.renderMode) {
@@ -47,8 +164,22 @@ RLGPC::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig _config) :
 		RG_LOG("\t > timestepsPerIteration = inf");
 	}
 
+	if (config.sendMetrics) {
+#ifdef RG_NO_PYTHON
+		RG_ERR_CLOSE(
+			"Learner: sendMetrics requires Python, but RLGymPPO_CPP was built with RG_NO_PYTHON\n" <<
+			"Disable it, and use metricsFilePath to save metrics instead"
+		);
+#else
+		pybind11::initialize_interpreter();
+		pythonInitialized = true;
+#endif
+	}
+
 	if (config.saveFolderAddUnixTimestamp && !config.checkpointSaveFolder.empty())
 		config.checkpointSaveFolder += "-" + std::to_string(time(0));
+	if (config.saveFolderAddUnixTimestamp && !config.policySnapshotFolder.empty())
+		config.policySnapshotFolder += "-" + std::to_string(time(0));
 
 	RG_LOG("\tCheckpoint Load Dir: " << config.checkpointLoadFolder);
 	RG_LOG("\tCheckpoint Save Dir: " << config.checkpointSaveFolder);
@@ -56,84 +187,482 @@ RLGPC::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig _config) :
 	torch::manual_seed(config.randomSeed);
 
 	at::Device device = at::Device(at::kCPU);
-	if (
+	if (!config.learnDevice.empty()) {
+		device = _ParseDevice(config.learnDevice, "learnDevice");
+	} else if (
 		config.deviceType == LearnerDeviceType::GPU_CUDA || 
 		(config.deviceType == LearnerDeviceType::AUTO && torch::cuda::is_available())
 		) {
-		RG_LOG("\tUsing CUDA GPU device...");
-
-		// Test out moving a tensor to GPU and back to make sure the device is working
-		torch::Tensor t;
-		bool deviceTestFailed = false;
-		try {
-			t = torch::tensor(0);
-			t = t.to(at::Device(at::kCUDA));
-			t = t.cpu();
-		} catch (...) {
-			deviceTestFailed = true;
-		}
-
-		if (!torch::cuda::is_available() || deviceTestFailed)
-			RG_ERR_CLOSE(
-				"Learner::Learner(): Can't use CUDA GPU because " <<
-				(torch::cuda::is_available() ? "libtorch cannot access the GPU" : "CUDA is not available to libtorch") << ".\n" <<
-				"Make sure your libtorch comes with CUDA support, and that CUDA is installed properly."
-			)
 		device = at::Device(at::kCUDA);
+	}
+
+	if (device.is_cuda()) {
+		RG_LOG("\tUsing CUDA GPU device...");
+		_TestCUDADevice(device);
 	} else {
 		RG_LOG("\tUsing CPU device...");
-		device = at::Device(at::kCPU);
+	}
+
+	// Agents infer on the learning device, unless they have their own
+	at::Device inferDevice = device;
+	if (!config.inferenceDevice.empty()) {
+		inferDevice = _ParseDevice(config.inferenceDevice, "inferenceDevice");
+		if (inferDevice != device) {
+			RG_LOG("\tAgents infer on " << inferDevice << ", with their own copies of the policy");
+			if (inferDevice.is_cuda())
+				_TestCUDADevice(inferDevice);
+			config.inferencePolicyBuffers = true;
+		}
 	}
 
 	if (RocketSim::GetStage() != RocketSimStage::INITIALIZED) {
 		RG_LOG("\tInitializing RocketSim...");
-		RocketSim::Init("collision_meshes");
+		RocketSim::Init("collision_meshes", true, RocketSim::InitModes::Lazy());
 	}
 
+	OBSStorageType obsStorageType = config.expBufferOBSType;
+	FList obsScales = {};
+	RLGSC::OBSMirrorMap obsMirrorMap = {};
+	IList actionMirrorMap = {};
+	// Becomes the first game of the first agent once we've used it
+	EnvCreateResult testEnv = {};
 	{
 		RG_LOG("\tCreating test environment to determine OBS size and action amount...")
-		auto envCreateResult = envCreateFn();
+		testEnv = envCreateFn();
+		auto& envCreateResult = testEnv;
 		auto obsSet = envCreateResult.gym->Reset();
 		obsSize = obsSet[0].size();
+
+		if (obsStorageType == OBSStorageType::INT16) {
+			obsScales = envCreateResult.match->obsBuilder->GetOBSScales(envCreateResult.gym->prevState);
+			if (obsScales.empty()) {
+				RG_LOG("\tWARNING: OBS builder has no OBS scales for INT16 OBS storage, using BF16 instead");
+				obsStorageType = OBSStorageType::BF16;
+			} else if (obsScales.size() != obsSize) {
+				RG_ERR_CLOSE("Learner::Learner(): OBS builder gave " << obsScales.size() << " OBS scales, but the OBS size is " << obsSize);
+			}
+		}
 		actionAmount = envCreateResult.match->actionParser->GetActionAmount();
+
+		if (config.mirrorFraction > 0) {
+			if (config.mirrorFraction > 1)
+				RG_ERR_CLOSE("Learner::Learner(): config.mirrorFraction must be from 0 to 1 (got " << config.mirrorFraction << ")");
+
+			obsMirrorMap = envCreateResult.match->obsBuilder->GetOBSMirrorMap(envCreateResult.gym->prevState);
+			actionMirrorMap = envCreateResult.match->actionParser->GetMirrorActionMap();
+			if (!obsMirrorMap.IsSet())
+				RG_ERR_CLOSE("Learner::Learner(): config.mirrorFraction requires an OBS builder with an OBS mirror map");
+			if (obsMirrorMap.sourceIndices.size() != obsSize)
+				RG_ERR_CLOSE("Learner::Learner(): OBS builder gave an OBS mirror map of size " << obsMirrorMap.sourceIndices.size() << ", but the OBS size is " << obsSize);
+			if (actionMirrorMap.size() != actionAmount)
+				RG_ERR_CLOSE("Learner::Learner(): config.mirrorFraction requires an action parser with an action mirror map");
+		}
+
 		RG_LOG("\t\tOBS size: " << obsSize);
 		RG_LOG("\t\tAction amount: " << actionAmount);
-		delete envCreateResult.gym;
-		delete envCreateResult.match;
+	}
+
+	if (config.memoryBudget.enabled && !config.renderMode) {
+		MemoryPlanner::Inputs planInputs = {};
+		planInputs.obsSize = obsSize;
+		planInputs.actionAmount = actionAmount;
+		planInputs.carsPerGame = testEnv.gym->arena->_cars.size();
+		planInputs.playersPerGame = testEnv.match->playerAmount;
+		planInputs.arenaMode = testEnv.gym->arena->GetMemWeightMode();
+		planInputs.learnOnCUDA = device.is_cuda();
+
+		// The plan may only narrow how observations are stored, INT16 may have already fallen back to BF16
+		config.expBufferOBSType = obsStorageType;
+		MemoryPlanner::FitBudget(config, planInputs);
+		obsStorageType = config.expBufferOBSType;
+	}
+
+	int numJobWorkers = (config.jobThreads < 0) ? RS_MAX(config.numThreads - 1, 0) : config.jobThreads;
+	if (numJobWorkers > 0) {
+		RG_LOG("\tCreating job system (" << numJobWorkers << " workers)...");
+		jobSystem = new JobSystem(numJobWorkers,
+			[](int workerIndex) {
+				torch::set_num_threads(1); // Threads don't inherit the learner's count (see LearnerConfig::learnThreads)
+				SamplingProfiler::SetThreadRole("Jobs");
+			}
+		);
+		if (!jobSystem->InstallBulletScheduler())
+			RG_LOG("\t\tBullet already has a task scheduler, physics won't use the job system");
 	}
 
 	RG_LOG("\tCreating experience buffer...");
-	expBuffer = new ExperienceBuffer(config.expBufferSize, config.randomSeed, device);
+	bool expBufferOnDevice = config.expBufferOnDevice && device.is_cuda();
+	std::vector<IList> expBufferShardCores = {};
+	bool expBufferSpilled = !config.expBufferSpillFolder.empty() && !expBufferOnDevice;
+	if (expBufferSpilled)
+		RG_LOG("\t\tSpilling experience buffer to " << config.expBufferSpillFolder);
+	if (config.expBufferNUMAShards && !expBufferOnDevice && !expBufferSpilled) {
+		expBufferShardCores = CPUAffinity::GetNUMANodes();
+		if (expBufferShardCores.size() > 1) {
+			RG_LOG("\t\tSplitting experience buffer across " << expBufferShardCores.size() << " NUMA nodes");
+		} else {
+			expBufferShardCores = {};
+		}
+	}
+	expBuffer = new ExperienceBuffer(
+		config.expBufferSize, config.randomSeed, device, expBufferOnDevice,
+		obsStorageType, obsScales, config.hugePages, actionAmount, expBufferShardCores,
+		expBufferSpilled ? config.expBufferSpillFolder : std::filesystem::path()
+	);
+	expBuffer->jobSystem = jobSystem;
+	if (config.mirrorFraction > 0)
+		expBuffer->SetMirror(config.mirrorFraction, obsMirrorMap.sourceIndices, obsMirrorMap.signs, actionMirrorMap);
 
 	RG_LOG("\tCreating PPO Learner...");
 	ppo = new PPOLearner(obsSize, actionAmount, config.ppo, device);
 
+	bool gamePolicies = !config.gamePolicyConfigs.empty();
+	if (!config.playerPolicyIDs.empty() || gamePolicies) {
+		const char* policiesName = gamePolicies ? "config.gamePolicyConfigs" : "config.playerPolicyIDs";
+		if (gamePolicies && !config.playerPolicyIDs.empty())
+			RG_ERR_CLOSE("Learner::Learner(): config.gamePolicyConfigs is not compatible with config.playerPolicyIDs");
+		if (config.opponentPoolSize > 0)
+			RG_ERR_CLOSE("Learner::Learner(): " << policiesName << " is not compatible with config.opponentPoolSize");
+		if (config.remoteWorkerPort || config.numProcessWorkers > 0)
+			RG_ERR_CLOSE("Learner::Learner(): " << policiesName << " is not compatible with remote or process workers, which only play the main policy");
+		if (config.collectionSegmentSteps > 0 || config.rolloutValues)
+			RG_ERR_CLOSE("Learner::Learner(): " << policiesName << " is not compatible with config.collectionSegmentSteps or config.rolloutValues, which use the main critic for every step");
+
+		int maxPolicyID = 0;
+		if (gamePolicies) {
+			maxPolicyID = config.gamePolicyConfigs.size();
+			int64_t numGames = (int64_t)config.numThreads * config.numGamesPerThread;
+			if (numGames <= maxPolicyID)
+				RG_ERR_CLOSE("Learner::Learner(): config.gamePolicyConfigs has " << (maxPolicyID + 1) << " policies, but there are only " << numGames << " games to deal out to them");
+		} else {
+			int playersPerGame = testEnv.match->playerAmount;
+			int numPolicySlots = config.playerPolicyIDs.size();
+			bool hasMainPlayers = playersPerGame > numPolicySlots;
+			for (int i = 0; i < RS_MIN(playersPerGame, numPolicySlots); i++)
+				hasMainPlayers |= (config.playerPolicyIDs[i] == 0);
+			if (!hasMainPlayers)
+				RG_ERR_CLOSE("Learner::Learner(): config.playerPolicyIDs must give at least one of the " << playersPerGame << " player slots to the main policy (ID 0)");
+
+			for (int id : config.playerPolicyIDs) {
+				if (id < 0)
+					RG_ERR_CLOSE("Learner::Learner(): config.playerPolicyIDs can't have negative IDs (got " << id << ")");
+				maxPolicyID = RS_MAX(maxPolicyID, id);
+			}
+		}
+
+		RG_LOG("\tCreating " << maxPolicyID << " extra policies...");
+		for (int id = 1; id <= maxPolicyID; id++) {
+			if (!gamePolicies && std::find(config.playerPolicyIDs.begin(), config.playerPolicyIDs.end(), id) == config.playerPolicyIDs.end())
+				RG_ERR_CLOSE("Learner::Learner(): config.playerPolicyIDs has no player slots for policy ID " << id << ", IDs must be consecutive");
+
+			auto extra = new ExtraPolicy();
+			extra->id = id;
+			extra->expBuffer = new ExperienceBuffer(
+				config.expBufferSize, config.randomSeed + id, device, expBufferOnDevice,
+				obsStorageType, obsScales, config.hugePages, actionAmount, expBufferShardCores,
+				expBufferSpilled ? config.expBufferSpillFolder : std::filesystem::path()
+			);
+			extra->expBuffer->jobSystem = jobSystem;
+			if (config.mirrorFraction > 0)
+				extra->expBuffer->SetMirror(config.mirrorFraction, obsMirrorMap.sourceIndices, obsMirrorMap.signs, actionMirrorMap);
+			extra->ppo = new PPOLearner(obsSize, actionAmount, gamePolicies ? config.gamePolicyConfigs[id - 1] : config.ppo, device);
+			extraPolicies.push_back(extra);
+		}
+	}
+
 	RG_LOG("\tCreating agent manager...");
 	agentMgr = new ThreadAgentManager(
 		ppo->policy, ppo->policyHalf, expBuffer, 
 		config.standardizeOBS, config.deterministic,
 		(uint64_t)(config.timestepsPerIteration * 1.5f),
-		device
+		inferDevice
 	);
 
+	agentMgr->jobSystem = jobSystem;
+	if (config.collectionWorkers > 0) {
+		if (config.renderMode) {
+			config.collectionWorkers = 0;
+		} else {
+			if (config.pipelinedCollection) {
+				RG_LOG("\tWARNING: config.collectionWorkers steps agents one step at a time, disabling config.pipelinedCollection");
+				config.pipelinedCollection = false;
+			}
+			if (config.useCUDAGraphs) {
+				RG_LOG("\tWARNING: config.collectionWorkers infers each agent on any worker, but CUDA graphs belong to the thread that captured them, disabling config.useCUDAGraphs");
+				config.useCUDAGraphs = false;
+			}
+			if (config.agentPinMode != AgentPinMode::NONE) {
+				RG_LOG("\tWARNING: config.collectionWorkers doesn't run agents on their own threads, disabling config.agentPinMode");
+				config.agentPinMode = AgentPinMode::NONE;
+			}
+		}
+	}
+	agentMgr->collectionWorkers = config.collectionWorkers;
+	agentMgr->pipelinedCollection = config.pipelinedCollection;
+	agentMgr->resetAhead = config.resetAhead;
+	agentMgr->stepsPerObsStatsInc = config.stepsPerObsStatsInc;
+	if (config.standardizeOBS)
+		agentMgr->obsStats = WelfordRunningStat(obsSize);
+	agentMgr->segmentSteps = config.collectionSegmentSteps;
+	if (!extraPolicies.empty()) {
+		agentMgr->playerPolicyIDs = config.playerPolicyIDs;
+		agentMgr->gamePolicyAmount = config.gamePolicyConfigs.size() + 1;
+		for (auto extra : extraPolicies)
+			agentMgr->extraPolicies.push_back(extra->ppo->policyHalf ? extra->ppo->policyHalf : extra->ppo->policy);
+	}
+	agentMgr->ballPredTicks = config.ballPredTicks;
+	if (config.stepHelperThreads > 0 && config.shareCollisionPools) {
+		RG_LOG("\tWARNING: config.stepHelperThreads steps arenas on multiple threads, disabling config.shareCollisionPools");
+		config.shareCollisionPools = false;
+	}
+	agentMgr->shareCollisionPools = config.shareCollisionPools;
+	agentMgr->stepHelperThreads = config.stepHelperThreads;
+	if (config.interleaveArenaSteps && config.stepHelperThreads > 0) {
+		RG_LOG("\tWARNING: config.interleaveArenaSteps does nothing with config.stepHelperThreads");
+		config.interleaveArenaSteps = false;
+	}
+	agentMgr->interleaveArenaSteps = config.interleaveArenaSteps;
+	agentMgr->hugePages = config.hugePages;
+	agentMgr->randomSeed = config.randomSeed;
+	agentMgr->parallelEnvCreation = config.parallelEnvCreation;
+	agentMgr->firstEnv = testEnv;
+	if (config.streamingLearnFraction > 0) {
+		if (config.collectionSegmentSteps <= 0)
+			RG_ERR_CLOSE("Learner::Learner(): config.streamingLearnFraction requires config.collectionSegmentSteps");
+		if (config.streamingLearnFraction >= 1)
+			RG_ERR_CLOSE("Learner::Learner(): config.streamingLearnFraction must be below 1 (got " << config.streamingLearnFraction << ")");
+
+		if (config.ppo.epochs < 2) {
+			RG_LOG("\tWARNING: config.streamingLearnFraction needs at least 2 epochs, steps after the first epoch would never be learned from, disabling it");
+			config.streamingLearnFraction = 0;
+		}
+	}
+
+	if (config.adaptiveIteration.enabled) {
+		auto& adaptive = config.adaptiveIteration;
+		if (!config.collectionDuringLearn) {
+			RG_LOG("\tWARNING: config.adaptiveIteration needs config.collectionDuringLearn, disabling it");
+			adaptive.enabled = false;
+		} else {
+			if (adaptive.minTimesteps < 1 || adaptive.maxTimesteps < adaptive.minTimesteps)
+				RG_ERR_CLOSE("Learner::Learner(): config.adaptiveIteration has invalid timestep bounds (" << adaptive.minTimesteps << " to " << adaptive.maxTimesteps << ")");
+			if (adaptive.minEpochs < 1 || adaptive.maxEpochs < adaptive.minEpochs)
+				RG_ERR_CLOSE("Learner::Learner(): config.adaptiveIteration has invalid epoch bounds (" << adaptive.minEpochs << " to " << adaptive.maxEpochs << ")");
+
+			// Streaming runs its first epoch on its own
+			if (config.streamingLearnFraction > 0)
+				adaptive.minEpochs = RS_MAX(adaptive.minEpochs, 2);
+
+			config.timestepsPerIteration = RS_CLAMP(config.timestepsPerIteration, adaptive.minTimesteps, adaptive.maxTimesteps);
+			config.ppo.epochs = RS_CLAMP(config.ppo.epochs, adaptive.minEpochs, adaptive.maxEpochs);
+			agentMgr->maxCollect = (uint64_t)(config.timestepsPerIteration * 1.5f);
+		}
+	}
+
+	if (config.collectionSegmentSteps > 0) {
+		// Compute the values and advantages of each segment while we wait for the rest
+		segmentExperience = new SegmentExperience();
+		agentMgr->segmentCallback = [this](GameTrajectory& segment) {
+			{
+				RG_TRACE_SCOPE("Segment GAE", ppo->device);
+				segmentExperience->parts.push_back(_ComputeExperience(segment, true, ppo, returnStats));
+				segmentExperience->size += segment.size;
+			}
+
+			if (config.streamingLearnFraction > 0)
+				_StreamSegment(segment);
+		};
+	}
+	if (config.rolloutValues)
+		agentMgr->valueNet = ppo->valueNet;
+
+	if (config.useCUDAGraphs) {
+		if (!device.is_cuda()) {
+			RG_LOG("\tWARNING: useCUDAGraphs does nothing on CPU");
+		} else if (!PolicyGraph::IsSupported()) {
+			RG_LOG("\tWARNING: useCUDAGraphs is enabled, but libtorch was not built with CUDA graph support");
+		} else {
+			agentMgr->useCUDAGraphs = true;
+		}
+	}
+
+	if (config.opponentPoolSize > 0) {
+		// Created before our agents, but only filled once we've loaded
+		opponentPool = new OpponentPool(
+			obsSize, actionAmount, config.ppo.policyLayerSizes, device, config.opponentPoolSize, config.opponentPoolProb
+		);
+		agentMgr->opponentPool = opponentPool;
+	}
+
+	if (config.spreadAgentsAcrossGPUs && !ppo->replicas.empty()) {
+		RG_LOG("\tSpreading agents across " << (ppo->replicas.size() + 1) << " GPUs...");
+
+		// Also applies to agents added later on
+		agentMgr->onAgentCreated = [this](ThreadAgent* agent, int index) {
+			int rank = index % (ppo->replicas.size() + 1);
+			if (rank == 0)
+				return; // Uses the manager's models
+
+			auto& replica = ppo->replicas[rank - 1];
+			agent->policy = replica.policyHalf ? replica.policyHalf : replica.policy;
+			if (agentMgr->valueNet)
+				agent->valueNet = replica.valueNet;
+		};
+	}
+
 	RG_LOG("\tCreating " << config.numThreads << " agents...");
-	agentMgr->CreateAgents(envCreateFn, config.numThreads, config.numGamesPerThread);
+	agentMgr->CreateAgents(envCreateFn, config.numThreads, config.numGamesPerThread, config.agentPinMode, config.agentPinCores);
+
+	if (config.coreScheduling) {
+		if (!device.is_cpu() || !config.collectionDuringLearn || config.renderMode) {
+			RG_LOG("\tWARNING: config.coreScheduling needs learning on the CPU and config.collectionDuringLearn, disabling it");
+			config.coreScheduling = false;
+		} else {
+			if (config.coreSchedulingLearnFraction < 0 || config.coreSchedulingLearnFraction > 1)
+				RG_ERR_CLOSE("Learner::Learner(): config.coreSchedulingLearnFraction must be from 0 to 1 (got " << config.coreSchedulingLearnFraction << ")");
+			coreScheduler = new CoreScheduler(agentMgr, config.coreSchedulingLearnFraction);
+		}
+	}
+
+	if (!config.agentAmountFile.empty() && config.renderMode) {
+		RG_LOG("\tWARNING: config.agentAmountFile is ignored in render mode");
+		config.agentAmountFile.clear();
+	}
+
+	if (config.useInferenceServer && !config.renderMode) {
+		RG_LOG("\tCreating inference server (min inference size: " << config.minInferenceSize << ")...");
+		agentMgr->inferServer = new InferenceServer(
+			ppo->policyHalf ? ppo->policyHalf : ppo->policy, device, config.deterministic,
+			config.minInferenceSize, config.inferenceMaxWaitTime
+		);
+		agentMgr->inferServer->valueNet = agentMgr->valueNet;
+	}
+
+	if (config.remoteWorkerPort) {
+		if (config.rolloutValues)
+			RG_ERR_CLOSE("Learner::Learner(): config.rolloutValues is not compatible with remote workers");
+
+		RG_LOG("\tCreating remote worker server...");
+		agentMgr->remoteServer = new RemoteWorkerServer(config.remoteWorkerPort, obsSize, actionAmount, config.remoteMaxPolicyAge);
+	}
+
+	if (config.numProcessWorkers > 0 && !config.renderMode) {
+		if (config.rolloutValues)
+			RG_ERR_CLOSE("Learner::Learner(): config.rolloutValues is not compatible with process workers");
+
+		// Room for the policy's parameters, and an OBS standardization even if it isn't set yet
+		DataStreamOut paramData;
+		RemoteProtocol::WriteParams(paramData, ppo->policy);
+		uint64_t policyCapacity = paramData.data.size() + 1 + 2 * (sizeof(uint64_t) + obsSize * sizeof(float));
+		uint64_t ringCapacity = ProcessShared::Align((uint64_t)config.processRingMB * 1024 * 1024);
+
+		RG_LOG("\tCreating process worker server (" << config.numProcessWorkers << " workers)...");
+		agentMgr->processServer = new ProcessWorkerServer(
+			config.numProcessWorkers, obsSize, actionAmount, config.remoteMaxPolicyAge, policyCapacity, ringCapacity
+		);
+	}
 
 	if (!config.checkpointLoadFolder.empty())
 		Load();
 
+	if (opponentPool && !config.checkpointLoadFolder.empty()) {
+		RG_LOG("\tLoading opponent pool from " << config.checkpointLoadFolder << "...");
+		opponentPool->LoadFromFolder(config.checkpointLoadFolder);
+		RG_LOG("\t\tLoaded " << opponentPool->Size() << " past policies");
+	}
+
+	// Set before anything copies or captures our models, so that copies and CUDA graphs include it
+	if (config.standardizeOBS)
+		_UpdateOBSStandardization();
+
+	if (config.asyncCheckpointSave && !config.checkpointSaveFolder.empty()) {
+		RG_LOG("\tCreating checkpoint writer...");
+		checkpointWriter = new CheckpointWriter(config.checkpointLoadFolder, config.checkpointsToKeep);
+	}
+
+	if (config.timestepsPerPolicySnapshot > 0 && !config.policySnapshotFolder.empty()) {
+		RG_LOG("\tCreating policy snapshot writer...");
+		policySnapshotWriter = new CheckpointWriter(config.policySnapshotFolder, config.policySnapshotsToKeep, "Policy Snapshot");
+	}
+
+	// Created after loading, as it is a copy of the policy
+	if (config.nativeInference) {
+		RG_LOG("\tCreating native policy...");
+		agentMgr->useNativeInference = true;
+		agentMgr->UpdateNativePolicy();
+	}
+
+	if (config.inferencePolicyBuffers) {
+		RG_LOG("\tCreating inference policy buffers...");
+		for (auto& buffer : agentMgr->policyBuffers) {
+			buffer.policy = new DiscretePolicy(obsSize, actionAmount, config.ppo.policyLayerSizes, inferDevice);
+			if (config.ppo.halfPrecModels && inferDevice.is_cuda()) {
+				buffer.policy->to(RG_HALFPERC_TYPE);
+				buffer.policy->halfPrec = true;
+			}
+		}
+		agentMgr->PublishPolicy(ppo->policy);
+	}
+
+	if (config.scriptedInference && !config.nativeInference) {
+		RG_LOG("\tCreating scripted policy...");
+		agentMgr->useScriptedInference = true;
+		agentMgr->UpdateScriptedPolicy();
+	}
+
+	if (agentMgr->remoteServer)
+		agentMgr->remoteServer->UpdatePolicy(ppo->policy, agentMgr->policyVersion);
+	if (agentMgr->processServer)
+		agentMgr->processServer->UpdatePolicy(ppo->policy, agentMgr->policyVersion);
+
 	if (config.sendMetrics) {
 		metricSender = new MetricSender(config.metricsProjectName, config.metricsGroupName, config.metricsRunName, runID);
 	} else {
 		metricSender = NULL;
 	}
 
+	if (!config.profileFolder.empty())
+		SamplingProfiler::InstallSignalTrigger();
+
+	if (config.metricsHTTPPort) {
+		metricsServer = new MetricsHTTPServer(config.metricsHTTPPort);
+		if (!config.profileFolder.empty())
+			metricsServer->fnStartProfile = [this] { return _StartProfile(); };
+		metricsServer->Start();
+	}
+
+	if (!config.metricsFilePath.empty())
+		metricFileWriter = new MetricFileWriter(config.metricsFilePath, metricSender ? metricSender->curRunID : runID);
+
+	if (config.regressionWatch.enabled) {
+		if (config.regressionWatch.threshold <= 0)
+			RG_ERR_CLOSE("Learner::Learner(): config.regressionWatch.threshold must be positive (got " << config.regressionWatch.threshold << ")");
+		regressionDetector = new RegressionDetector(config.regressionWatch);
+	}
+
+	if (!config.rolloutRecordPath.empty() && !config.renderMode) {
+		RG_LOG("\tCreating rollout recorder (recording 1 in " << config.rolloutRecordGameInterval << " games to " << config.rolloutRecordPath << ")...");
+		rolloutRecorder = new RolloutRecorder(
+			config.rolloutRecordPath, config.rolloutRecordGameInterval, config.rolloutRecordSegmentSteps, config.rolloutRecordStateInterval
+		);
+		agentMgr->rolloutRecorder = rolloutRecorder;
+	}
+
 	if (config.renderMode) {
-		renderSender = new RenderSender();
+		renderSender = new RenderSender(config.renderAddress, config.renderPort);
 		agentMgr->renderSender = renderSender;
 		agentMgr->renderTimeScale = config.renderTimeScale;
+		agentMgr->AddStateFields(RLGSC::StateFields::ALL);
 	} else {
 		renderSender = NULL;
+
+		if (config.spectate) {
+			RG_LOG("\tCreating spectator (game " << config.spectateGameIndex << ")...");
+			spectator = new Spectator(config.renderAddress, config.renderPort, config.spectateGameIndex, config.spectateFPS);
+			spectator->Start();
+			agentMgr->spectator = spectator;
+			agentMgr->AddStateFields(RLGSC::StateFields::ALL);
+		}
 	}
 }
 
@@ -150,19 +679,15 @@ nlohmann::json MakeJSONArray(const std::vector<T> list) {
 	return result;
 }
 
-void RLGPC::Learner::SaveStats(std::filesystem::path path) {
+std::string MakeStatsJSON(RLGPC::Learner* learner) {
 	using namespace nlohmann;
-
-	constexpr const char* ERROR_PREFIX = "Learner::SaveStats(): ";
-
-	std::ofstream fOut(path);
-	if (!fOut.good())
-		RG_ERR_CLOSE(ERROR_PREFIX << "Can't open file at " << path);
+	auto& config = learner->config;
+	auto& returnStats = learner->returnStats;
 
 	json j = {};
-	j["cumulative_timesteps"] = totalTimesteps;
-	j["cumulative_model_updates"] = ppo->cumulativeModelUpdates;
-	j["epoch"] = totalEpochs;
+	j["cumulative_timesteps"] = learner->totalTimesteps;
+	j["cumulative_model_updates"] = learner->ppo->cumulativeModelUpdates;
+	j["epoch"] = learner->totalEpochs;
 	
 	auto& rrs = j["reward_running_stats"];
 	{
@@ -172,24 +697,162 @@ void RLGPC::Learner::SaveStats(std::filesystem::path path) {
 		rrs["count"] = returnStats.count;
 	}
 
+	for (auto extra : learner->extraPolicies) {
+		auto& jExtra = j["extra_policies"][std::to_string(extra->id)];
+		jExtra["cumulative_model_updates"] = extra->ppo->cumulativeModelUpdates;
+		auto& extraRRS = jExtra["reward_running_stats"];
+		extraRRS["mean"] = MakeJSONArray(extra->returnStats.runningMean);
+		extraRRS["var"] = MakeJSONArray(extra->returnStats.runningVariance);
+		extraRRS["shape"] = extra->returnStats.shape;
+		extraRRS["count"] = extra->returnStats.count;
+	}
+
+	if (config.standardizeOBS) {
+		auto& obsStats = learner->agentMgr->obsStats;
+		auto& ors = j["obs_running_stats"];
+		ors["mean"] = MakeJSONArray(obsStats.runningMean);
+		ors["var"] = MakeJSONArray(obsStats.runningVariance);
+		ors["shape"] = obsStats.shape;
+		ors["count"] = obsStats.count;
+		ors["min_std"] = config.minOBSSTD;
+	}
+
 	if (config.sendMetrics)
-		j["run_id"] = metricSender->curRunID;
+		j["run_id"] = learner->metricSender->curRunID;
+
+	return j.dump(4);
+}
+
+void WriteStatsFile(std::filesystem::path path, const std::string& jStr) {
+	constexpr const char* ERROR_PREFIX = "Learner::SaveStats(): ";
+
+	std::ofstream fOut(path);
+	if (!fOut.good())
+		RG_ERR_CLOSE(ERROR_PREFIX << "Can't open file at " << path);
 
-	std::string jStr = j.dump(4);
 	fOut << jStr;
 }
 
-void RLGPC::Learner::LoadStats(std::filesystem::path path) {
-	// TODO: Repetitive code, merge repeated code into one function called from both SaveStats() and LoadStats()
+// Writes the policy snapshot of a checkpoint that was just written to checkpointFolder (see LearnerConfig::timestepsPerPolicySnapshot)
+// The snapshot hard-links the checkpoint's policy file, so removing either of them never affects the other
+// Single-file checkpoints have no policy file of their own, so policySnapshot is written instead
+void WriteLinkedPolicySnapshot(
+	std::filesystem::path snapshotFolder, const std::string& statsJSON, int snapshotsToKeep,
+	std::filesystem::path checkpointFolder, const torch::nn::Sequential& policySnapshot) {
+	using namespace RLGPC;
+
+	std::filesystem::create_directories(snapshotFolder.parent_path());
+	CheckpointWriter::Write(snapshotFolder, [&](std::filesystem::path folderPath) {
+		WriteStatsFile(folderPath / Learner::STATS_FILE_NAME, statsJSON);
+
+		auto policyPath = folderPath / PPOLearner::POLICY_FILE_NAME;
+		auto checkpointPolicyPath = checkpointFolder / PPOLearner::POLICY_FILE_NAME;
+		if (std::filesystem::exists(checkpointPolicyPath)) {
+			// Copy if the filesystem can't hard-link
+			std::error_code ec;
+			std::filesystem::create_hard_link(checkpointPolicyPath, policyPath, ec);
+			if (ec)
+				std::filesystem::copy_file(checkpointPolicyPath, policyPath);
+		} else {
+			PPOLearner::SavePolicySnapshotTo(policySnapshot, policyPath);
+		}
+	});
+	CheckpointWriter::RemoveOldCheckpoints(snapshotFolder.parent_path(), snapshotsToKeep);
+}
 
-	using namespace nlohmann;
+// Copy of everything a warm restart needs besides the checkpoint (see LearnerConfig::warmRestartCheckpoints)
+struct WarmRestartSnapshot {
+	RLGPC::ExperienceBuffer::Snapshot expBuffer;
+	std::vector<uint64_t> gameRNGStates; // Every game's random engine state, in game order
+	torch::Tensor torchRNGState;
+};
+
+std::shared_ptr<WarmRestartSnapshot> MakeWarmRestartSnapshot(RLGPC::Learner* learner) {
+	using namespace RLGPC;
+
+	auto snapshot = std::make_shared<WarmRestartSnapshot>();
+	snapshot->expBuffer = learner->expBuffer->MakeSnapshot();
+
+	for (auto agent : learner->agentMgr->agents) {
+		// Agents can be collecting while we save
+		std::lock_guard<std::mutex> lock(agent->gameStepMutex);
+		for (auto game : agent->games.games) {
+			auto& engineState = game->match->randEngine.state;
+			snapshot->gameRNGStates.insert(snapshot->gameRNGStates.end(), std::begin(engineState), std::end(engineState));
+		}
+	}
+
+	auto generator = at::detail::getDefaultCPUGenerator();
+	{
+		std::lock_guard<std::mutex> lock(generator.mutex());
+		snapshot->torchRNGState = generator.get_state();
+	}
+
+	return snapshot;
+}
+
+void WriteWarmRestartFile(std::filesystem::path path, const WarmRestartSnapshot& snapshot) {
+	using namespace RLGPC;
+
+	CheckpointFileWriter writer = {};
+	ExperienceBuffer::AddSnapshotToFile(writer, snapshot.expBuffer);
+	writer.AddBytes("game_rngs", snapshot.gameRNGStates.data(), snapshot.gameRNGStates.size() * sizeof(uint64_t));
+	writer.AddBytes("torch_rng", snapshot.torchRNGState.data_ptr(), snapshot.torchRNGState.nbytes());
+	writer.Save(path);
+}
+
+void RLGPC::Learner::_LoadWarmRestart(std::filesystem::path path) {
+	CheckpointFile file = CheckpointFile(path);
+
+	if (expBuffer->LoadFromFile(file, obsSize))
+		RG_LOG(" > Loaded " << expBuffer->curSize << " steps of experience");
+
+	auto& gameRNGs = file.Get("game_rngs", CheckpointFile::EntryType::BYTES);
+	uint64_t numGames = 0;
+	for (auto agent : agentMgr->agents)
+		numGames += agent->games.Size();
+
+	constexpr size_t ENGINE_SIZE = sizeof(RLGSC::Math::RandEngine::state);
+	if (gameRNGs.size == numGames * ENGINE_SIZE) {
+		auto engineData = gameRNGs.data;
+		for (auto agent : agentMgr->agents) {
+			for (auto game : agent->games.games) {
+				memcpy(game->match->randEngine.state, engineData, ENGINE_SIZE);
+				engineData += ENGINE_SIZE;
+			}
+		}
+	} else {
+		RG_LOG(" > WARNING: Saved game random engines are from " << (gameRNGs.size / ENGINE_SIZE) << " games, but we have " << numGames << ", games will keep their seeds");
+	}
+
+	auto& torchRNG = file.Get("torch_rng", CheckpointFile::EntryType::BYTES);
+	auto generator = at::detail::getDefaultCPUGenerator();
+	{
+		std::lock_guard<std::mutex> lock(generator.mutex());
+		generator.set_state(torch::from_blob((void*)torchRNG.data, { (int64_t)torchRNG.size }, torch::kUInt8).clone());
+	}
+}
+
+void RLGPC::Learner::SaveStats(std::filesystem::path path) {
+	WriteStatsFile(path, MakeStatsJSON(this));
+}
+
+void RLGPC::Learner::LoadStats(std::filesystem::path path) {
 	constexpr const char* ERROR_PREFIX = "Learner::LoadStats(): ";
 
 	std::ifstream fIn(path);
 	if (!fIn.good())
 		RG_ERR_CLOSE(ERROR_PREFIX << "Can't open file at " << path);
 
-	json j = json::parse(fIn);
+	_LoadStatsJSON(std::string(std::istreambuf_iterator<char>(fIn), std::istreambuf_iterator<char>()));
+}
+
+void RLGPC::Learner::_LoadStatsJSON(const std::string& jStr) {
+	// TODO: Repetitive code, merge repeated code into one function called from both SaveStats() and LoadStats()
+
+	using namespace nlohmann;
+
+	json j = json::parse(jStr);
 	totalTimesteps = j["cumulative_timesteps"];
 	ppo->cumulativeModelUpdates = j["cumulative_model_updates"];
 	totalEpochs = j["epoch"];
@@ -202,51 +865,148 @@ void RLGPC::Learner::LoadStats(std::filesystem::path path) {
 		returnStats.count = rrs["count"];
 	}
 
+	// Policies that are new to this checkpoint keep their fresh stats
+	for (auto extra : extraPolicies) {
+		std::string idStr = std::to_string(extra->id);
+		if (!j.contains("extra_policies") || !j["extra_policies"].contains(idStr))
+			continue;
+
+		auto& jExtra = j["extra_policies"][idStr];
+		extra->ppo->cumulativeModelUpdates = jExtra["cumulative_model_updates"];
+		auto& extraRRS = jExtra["reward_running_stats"];
+		extra->returnStats = WelfordRunningStat(extraRRS["shape"]);
+		extra->returnStats.runningMean = extraRRS["mean"].get<std::vector<double>>();
+		extra->returnStats.runningVariance = extraRRS["var"].get<std::vector<double>>();
+		extra->returnStats.count = extraRRS["count"];
+	}
+
+	if (config.standardizeOBS && j.contains("obs_running_stats")) {
+		auto& ors = j["obs_running_stats"];
+		if (ors["shape"] != obsSize)
+			RG_ERR_CLOSE("Learner::_LoadStatsJSON(): Saved OBS stats have a shape of " << ors["shape"] << ", but our OBS size is " << obsSize);
+
+		auto& obsStats = agentMgr->obsStats;
+		obsStats = WelfordRunningStat(obsSize);
+		obsStats.runningMean = ors["mean"].get<std::vector<double>>();
+		obsStats.runningVariance = ors["var"].get<std::vector<double>>();
+		obsStats.count = ors["count"];
+	}
+
 	if (j.contains("run_id"))
 		runID = j["run_id"];
 }
 
-// Different than RLGym-PPO to show that they are not compatible
-constexpr const char* STATS_FILE_NAME = "RUNNING_STATS.json";
+void RLGPC::Learner::_UpdateOBSStandardization() {
+	agentMgr->MergeOBSStats();
+	auto standardization = OBSStandardization::FromStats(agentMgr->obsStats, config.minOBSSTD);
+	ppo->SetOBSStandardization(standardization);
+	for (auto extra : extraPolicies)
+		extra->ppo->SetOBSStandardization(standardization);
+}
 
 void RLGPC::Learner::Save() {
 	if (config.checkpointSaveFolder.empty())
 		RG_ERR_CLOSE("Learner::Save(): Cannot save because config.checkpointSaveFolder is not set");
 
 	std::filesystem::path saveFolder = config.checkpointSaveFolder / std::to_string(totalTimesteps);
-	std::filesystem::create_directories(saveFolder);
+	std::filesystem::create_directories(config.checkpointSaveFolder);
 
 	RG_LOG("Saving to folder " << saveFolder << "...");
-	SaveStats(saveFolder / STATS_FILE_NAME);
-	ppo->SaveTo(saveFolder);
-
-	// Remove old checkpoints
-	if (config.checkpointsToKeep != -1) {
-		int numCheckpoints = 0;
-		int64_t lowestCheckpointTS = INT64_MAX;
 
-		for (auto entry : std::filesystem::directory_iterator(config.checkpointLoadFolder)) {
-			if (entry.is_directory()) {
-				auto name = entry.path().filename();
-				try {
-					int64_t nameVal = std::stoll(name);
-					lowestCheckpointTS = RS_MIN(nameVal, lowestCheckpointTS);
-					numCheckpoints++;
-				} catch (...) {}
+	// Each checkpoint also gets a policy snapshot, which shares its policy file
+	std::filesystem::path snapshotFolder = policySnapshotWriter ? (config.policySnapshotFolder / std::to_string(totalTimesteps)) : std::filesystem::path();
+	int snapshotsToKeep = config.policySnapshotsToKeep;
+
+	if (checkpointWriter || config.singleFileCheckpoints) {
+		Timer snapshotTimer = {};
+		std::string statsJSON = MakeStatsJSON(this);
+		auto snapshot = ppo->MakeSnapshot();
+		std::vector<std::pair<std::string, PPOLearner::Snapshot>> extraSnapshots = {};
+		for (auto extra : extraPolicies)
+			extraSnapshots.push_back({ extra->GetFolderName(), extra->ppo->MakeSnapshot() });
+		std::shared_ptr<WarmRestartSnapshot> warmSnapshot = NULL;
+		if (config.warmRestartCheckpoints)
+			warmSnapshot = MakeWarmRestartSnapshot(this);
+		double snapshotTime = snapshotTimer.Elapsed();
+
+		auto writeFn = [statsJSON, snapshot, extraSnapshots, warmSnapshot, singleFile = config.singleFileCheckpoints, snapshotFolder, snapshotsToKeep](std::filesystem::path folderPath) {
+			if (singleFile) {
+				PPOLearner::SaveSnapshotToFile(snapshot, folderPath / CHECKPOINT_FILE_NAME, { { CHECKPOINT_STATS_ENTRY, statsJSON } });
+			} else {
+				WriteStatsFile(folderPath / STATS_FILE_NAME, statsJSON);
+				PPOLearner::SaveSnapshotTo(snapshot, folderPath);
 			}
-		}
 
-		if (numCheckpoints > config.checkpointsToKeep) {
-			std::filesystem::path removePath = config.checkpointLoadFolder / std::to_string(lowestCheckpointTS);
-			try {
-				std::filesystem::remove_all(removePath);
-			} catch (std::exception& e) {
-				RG_ERR_CLOSE("Failed to remove old checkpoint from " << removePath << ", exception: " << e.what());
+			for (auto& [folderName, extraSnapshot] : extraSnapshots) {
+				std::filesystem::create_directories(folderPath / folderName);
+				if (singleFile) {
+					PPOLearner::SaveSnapshotToFile(extraSnapshot, folderPath / folderName / CHECKPOINT_FILE_NAME, {});
+				} else {
+					PPOLearner::SaveSnapshotTo(extraSnapshot, folderPath / folderName);
+				}
 			}
+
+			if (warmSnapshot)
+				WriteWarmRestartFile(folderPath / WARM_RESTART_FILE_NAME, *warmSnapshot);
+
+			if (!snapshotFolder.empty())
+				WriteLinkedPolicySnapshot(snapshotFolder, statsJSON, snapshotsToKeep, folderPath, snapshot.policy);
+		};
+
+		if (checkpointWriter) {
+			checkpointWriter->Submit(saveFolder, writeFn, snapshotTime);
+			RG_LOG(" > Writing in background.");
+		} else {
+			CheckpointWriter::Write(saveFolder, writeFn);
+			CheckpointWriter::RemoveOldCheckpoints(config.checkpointLoadFolder, config.checkpointsToKeep);
+			RG_LOG(" > Done.");
 		}
+	} else {
+		CheckpointWriter::Write(
+			saveFolder,
+			[&](std::filesystem::path folderPath) {
+				std::string statsJSON = MakeStatsJSON(this);
+				WriteStatsFile(folderPath / STATS_FILE_NAME, statsJSON);
+				ppo->SaveTo(folderPath);
+				for (auto extra : extraPolicies) {
+					std::filesystem::create_directories(folderPath / extra->GetFolderName());
+					extra->ppo->SaveTo(folderPath / extra->GetFolderName());
+				}
+
+				if (config.warmRestartCheckpoints)
+					WriteWarmRestartFile(folderPath / WARM_RESTART_FILE_NAME, *MakeWarmRestartSnapshot(this));
+
+				if (!snapshotFolder.empty())
+					WriteLinkedPolicySnapshot(snapshotFolder, statsJSON, snapshotsToKeep, folderPath, torch::nn::Sequential());
+			}
+		);
+		CheckpointWriter::RemoveOldCheckpoints(config.checkpointLoadFolder, config.checkpointsToKeep);
+		RG_LOG(" > Done.");
 	}
 
-	RG_LOG(" > Done.");
+	// Our past policies are the ones we've saved
+	if (opponentPool)
+		opponentPool->AddCopy(ppo->policy, totalTimesteps);
+}
+
+void RLGPC::Learner::SavePolicySnapshot() {
+	if (!policySnapshotWriter)
+		RG_ERR_CLOSE("Learner::SavePolicySnapshot(): Cannot save because config.timestepsPerPolicySnapshot or config.policySnapshotFolder is not set");
+
+	Timer snapshotTimer = {};
+	std::string statsJSON = MakeStatsJSON(this);
+	auto policySnapshot = ppo->MakePolicySnapshot();
+	double snapshotTime = snapshotTimer.Elapsed();
+
+	std::filesystem::create_directories(config.policySnapshotFolder);
+	policySnapshotWriter->Submit(
+		config.policySnapshotFolder / std::to_string(totalTimesteps),
+		[statsJSON, policySnapshot](std::filesystem::path folderPath) {
+			WriteStatsFile(folderPath / STATS_FILE_NAME, statsJSON);
+			PPOLearner::SavePolicySnapshotTo(policySnapshot, folderPath / PPOLearner::POLICY_FILE_NAME);
+		},
+		snapshotTime
+	);
 }
 
 void RLGPC::Learner::Load() {
@@ -271,14 +1031,124 @@ void RLGPC::Learner::Load() {
 	if (highest != -1) {
 		std::filesystem::path loadFolder = config.checkpointLoadFolder / std::to_string(highest);
 		RG_LOG(" > Loading checkpoint " << loadFolder << "...");
-		LoadStats(loadFolder / STATS_FILE_NAME);
-		ppo->LoadFrom(loadFolder);
+		if (std::filesystem::exists(loadFolder / CHECKPOINT_FILE_NAME)) {
+			CheckpointFile file = CheckpointFile(loadFolder / CHECKPOINT_FILE_NAME);
+			auto& statsEntry = file.Get(CHECKPOINT_STATS_ENTRY, CheckpointFile::EntryType::BYTES);
+			_LoadStatsJSON(std::string((const char*)statsEntry.data, statsEntry.size));
+			ppo->LoadFromFile(file);
+		} else {
+			LoadStats(loadFolder / STATS_FILE_NAME);
+			ppo->LoadFrom(loadFolder);
+		}
+
+		for (auto extra : extraPolicies) {
+			std::filesystem::path extraFolder = loadFolder / extra->GetFolderName();
+			if (std::filesystem::exists(extraFolder / CHECKPOINT_FILE_NAME)) {
+				extra->ppo->LoadFromFile(CheckpointFile(extraFolder / CHECKPOINT_FILE_NAME));
+			} else if (std::filesystem::is_directory(extraFolder)) {
+				extra->ppo->LoadFrom(extraFolder);
+			} else {
+				RG_LOG(" > No saved models for policy " << extra->id << ", starting it new");
+			}
+		}
+
+		if (std::filesystem::exists(loadFolder / WARM_RESTART_FILE_NAME)) {
+			RG_LOG(" > Loading warm restart state...");
+			_LoadWarmRestart(loadFolder / WARM_RESTART_FILE_NAME);
+		}
 		RG_LOG(" > Done.");
 	} else {
 		RG_LOG(" > No checkpoints found, starting new model.")
 	}
 }
 
+// Adds what is only useful for monitoring to the report, and gives it to the metrics server
+void _PublishServedMetrics(RLGPC::Learner* learner, const RLGPC::Report& report) {
+	using namespace RLGPC;
+
+	Report servedReport = report;
+	if (learner->ppo->device.is_cuda()) {
+		auto cudaMemory = MemoryInfo::GetCUDAMemory();
+		servedReport["CUDA Allocated Bytes"] = cudaMemory.allocated;
+		servedReport["CUDA Reserved Bytes"] = cudaMemory.reserved;
+	}
+
+	std::vector<Report> agentReports = {};
+	for (auto agent : learner->agentMgr->agents) {
+		Report agentReport = {};
+		agentReport["Env Step Time"] = agent->times.envStepTime;
+		agentReport["Policy Infer Time"] = agent->times.policyInferTime;
+		agentReport["Traj Append Time"] = agent->times.trajAppendTime;
+		agentReport["Infer-Step Overlap Time"] = agent->times.inferOverlapTime;
+		agentReports.push_back(agentReport);
+	}
+
+	learner->metricsServer->Publish(servedReport, agentReports);
+}
+
+// Writes what was captured from the iteration after a throughput regression (see LearnerConfig::regressionWatch)
+void WriteRegressionReport(
+	RLGPC::Learner* learner, std::filesystem::path path, int64_t iteration,
+	const std::vector<RLGPC::RegressionDetector::Regression>& regressions, const RLGPC::Report& report) {
+	using namespace RLGPC;
+	using namespace nlohmann;
+	constexpr double MB = 1024 * 1024;
+
+	json j = {};
+	j["iteration"] = iteration;
+	j["cumulative_timesteps"] = learner->totalTimesteps;
+
+	auto& jRegressions = j["regressions"] = json::array();
+	for (auto& regression : regressions) {
+		jRegressions.push_back({
+			{ "metric", regression.metric },
+			{ "value", regression.value },
+			{ "baseline", regression.baseline },
+			{ "change", regression.change }
+		});
+	}
+
+	// Baselines of every watched metric, as they are now
+	auto& jBaselines = j["baselines"] = json::object();
+	for (auto& pair : learner->regressionDetector->baselineValues) {
+		double baseline = learner->regressionDetector->GetBaseline(pair.first);
+		if (!isnan(baseline))
+			jBaselines[pair.first] = baseline;
+	}
+
+	auto& jMetrics = j["metrics"] = json::object();
+	for (auto& pair : report.data)
+		if (std::isfinite(pair.second))
+			jMetrics[pair.first] = pair.second;
+
+	auto& jAgents = j["agents"] = json::array();
+	for (auto agent : learner->agentMgr->agents) {
+		jAgents.push_back({
+			{ "env_step_time", agent->times.envStepTime },
+			{ "policy_infer_time", agent->times.policyInferTime },
+			{ "traj_append_time", agent->times.trajAppendTime },
+			{ "infer_step_overlap_time", agent->times.inferOverlapTime }
+		});
+	}
+
+	auto& jMemory = j["memory"];
+	jMemory["process_rss_mb"] = MemoryInfo::GetProcessRSS() / MB;
+	jMemory["process_peak_rss_mb"] = MemoryInfo::GetPeakProcessRSS() / MB;
+	if (learner->ppo->device.is_cuda()) {
+		auto cudaMemory = MemoryInfo::GetCUDAMemory();
+		jMemory["cuda_allocated_mb"] = cudaMemory.allocated / MB;
+		jMemory["cuda_reserved_mb"] = cudaMemory.reserved / MB;
+		jMemory["cuda_peak_allocated_mb"] = cudaMemory.peakAllocated / MB;
+		jMemory["cuda_peak_reserved_mb"] = cudaMemory.peakReserved / MB;
+	}
+
+	std::filesystem::create_directories(path.parent_path());
+	std::ofstream fOut(path);
+	if (!fOut.good())
+		RG_ERR_CLOSE("Learner: Can't open regression report file at " << path);
+	fOut << j.dump(4);
+}
+
 // Prints the metrics report in a similar way to rlgym-ppo
 void DisplayReport(const RLGPC::Report& report) {
 	// FORMAT:
@@ -291,9 +1161,13 @@ void DisplayReport(const RLGPC::Report& report) {
 		"Value Function Loss",
 		"",
 		"Mean KL Divergence",
+		"-PPO Early Stop Fraction",
 		"SB3 Clip Fraction",
 		"Policy Update Magnitude",
 		"Value Function Update Magnitude",
+		"Half Policy KL Divergence",
+		"Stale Step Fraction",
+		"-Mean Stale IS Weight",
 		"",
 		"Collected Steps/Second",
 		"Overall Steps/Second",
@@ -301,14 +1175,63 @@ void DisplayReport(const RLGPC::Report& report) {
 		"Collection Time",
 		"-Policy Infer Time",
 		"-Env Step Time",
+		"--OBS Build Time",
+		"--Env Terminal Time",
+		"--Env Reward Time",
+		"--Env Reset Time",
+		"-Infer-Step Overlap Time",
+		"-Collect Limit Wait Time",
+		"-Avg Inference Batch Size",
+		"-Concat Time",
+		"Remote Workers",
+		"-Remote Steps/Second",
+		"-Remote Stale Steps Dropped",
+		"Process Workers",
+		"-Process Steps/Second",
+		"-Process Stale Steps Dropped",
 		"Consumption Time",
+		"-GAE Time",
+		"-Buffer Submit Time",
 		"-PPO Learn Time",
+		"--PPO Batch Prep Time",
+		"--PPO Batch Wait Time",
+		"--PPO Early Stop Saved Time",
+		"--PPO GPU Transfer Time",
+		"--PPO GPU Forward Time",
+		"--PPO GPU Backward Time",
+		"--PPO GPU Clip Time",
+		"--PPO GPU Optimizer Time",
+		"--PPO GPU Idle Fraction",
+		"-Policy Publish Time",
 		"Collect-Consume Overlap Time",
+		"Streamed Epoch Time",
+		"Adaptive Imbalance",
+		"-Adaptive Timesteps Per Iteration",
+		"-Adaptive PPO Epochs",
 		// TODO: These timers don't work due to non-blocking mode
 		//"--PPO Value Estimate Time",
 		//"--PPO Backprop Data Time",
 		//"--PPO Gradient Time",
 		"Total Iteration Time",
+		"Checkpoint Write Time",
+		"-Checkpoint Snapshot Time",
+		"Policy Snapshot Write Time",
+		"-Policy Snapshot Snapshot Time",
+		"Metric Queue Depth",
+		"-Dropped Metric Reports",
+		"",
+		"Process RSS MB",
+		"-Process Peak RSS MB",
+		"-Huge Pages MB",
+		"-Exp Buffer MB",
+		"--Exp Buffer States MB",
+		"-Rollout Capacity MB",
+		"--Rollout Used MB",
+		"-Est. Game Memory MB",
+		"CUDA Reserved MB",
+		"-CUDA Allocated MB",
+		"-CUDA Peak Reserved MB",
+		"-CUDA Peak Allocated MB",
 		"",
 		"Cumulative Model Updates",
 		"Cumulative Timesteps",
@@ -324,6 +1247,10 @@ void DisplayReport(const RLGPC::Report& report) {
 				name++;
 			}
 
+			// Some metrics only exist with certain settings
+			if (!report.Has(name))
+				continue;
+
 			std::string prefix = {};
 			if (indentLevel > 0) {
 				prefix += std::string((indentLevel - 1) * 3, ' ');
@@ -344,29 +1271,81 @@ void RLGPC::Learner::Learn() {
 	RG_LOG("NOTE: Paranoid mode active. Additional checks will be run that may impact performance.");
 #endif
 
+	double warmupTime = config.warmup ? _Warmup() : 0;
+
 	RG_LOG("\tStarting agents...");
 	agentMgr->SetStepCallback(stepCallback);
-	agentMgr->StartAgents();
+	agentMgr->SetBatchStepCallback(batchStepCallback);
+	if (agentMgr->agentsStarted) {
+		agentMgr->SetCollectionDisabled(false); // Already started by Distill()
+	} else {
+		agentMgr->StartAgents();
+	}
 
 	auto device = ppo->device;
 
+	TraceRecorder::SetThreadName("Learner");
+	SamplingProfiler::SetThreadRole("Learner");
+
+	// The rest of the time we only need one thread, as agents use the other cores
+	int learnThreads = 1;
+	if (coreScheduler) {
+		RG_LOG("\tLearning with the cores of " << (int)(config.coreSchedulingLearnFraction * 100) << "% of agents");
+	} else if (device.is_cpu()) {
+		learnThreads = config.learnThreads;
+		if (learnThreads <= 0)
+			learnThreads = config.collectionDuringLearn ? 1 : CPUAffinity::GetNumCores();
+		if (learnThreads > 1)
+			RG_LOG("\tLearning with " << learnThreads << " threads");
+	}
+
 	RG_LOG("\tBeginning learning loop:");
-	int64_t tsSinceSave = 0;
+	int64_t tsSinceSave = 0, tsSincePolicySnapshot = 0;
+	int64_t iteration = 0;
 	Timer epochTimer = {};
+
+	// Regressions found in the last iteration, which this iteration is captured for (see config.regressionWatch)
+	std::vector<RegressionDetector::Regression> pendingRegressions = {};
+	int64_t lastRegressionCapture = -1;
+
+	// Allocation totals of each subsystem at the last report, only used with RG_ALLOC_TRACKING
+	RLGSC::AllocTracker::Counts lastAllocCounts[(int)RLGSC::AllocTag::AMOUNT] = {};
 	while (totalTimesteps < config.timestepLimit || config.timestepLimit == 0) {
 		Report report = {};
 
+		_UpdateNumAgents();
+
+		bool captureRegression = !pendingRegressions.empty();
+		bool traceIteration = !config.traceFolder.empty() && (iteration % RS_MAX(config.traceIterationInterval, 1)) == 0;
+		if (captureRegression)
+			traceIteration = true;
+		if (traceIteration)
+			TraceRecorder::Begin();
+
+		if (!config.profileFolder.empty() && SamplingProfiler::PollTriggers(config.profileFolder / "profile.trigger"))
+			_StartProfile();
+
+		if (config.warmup && iteration == 0)
+			report["Warmup Time"] = warmupTime;
+
 		agentMgr->SetStepCallback(stepCallback);
+		agentMgr->SetBatchStepCallback(batchStepCallback);
 
 		// Collect the desired timesteps from our agents
-		GameTrajectory timesteps = agentMgr->CollectTimesteps(config.timestepsPerIteration);
-		double relCollectionTime = epochTimer.Elapsed();
+		GameTrajectory timesteps;
+		{
+			RG_TRACE_SCOPE("Collect");
+			timesteps = agentMgr->CollectTimesteps(config.timestepsPerIteration);
+		}
+		// The learner wasn't waiting on collection during the streamed epoch (see config.streamingLearnFraction)
+		double streamedEpochTime = (segmentExperience && segmentExperience->streamed) ? segmentExperience->streamedEpochTime : 0;
+		double relCollectionTime = epochTimer.Elapsed() - streamedEpochTime;
 		uint64_t timestepsCollected = timesteps.size; // Use actual size instead of target size
 
 		totalTimesteps += timestepsCollected;
 
 		if (!config.collectionDuringLearn)
-			agentMgr->disableCollection = true;
+			agentMgr->SetCollectionDisabled(true);
 
 		// Add it to our experience buffer, also computing GAE in the process
 		try {
@@ -375,13 +1354,17 @@ void RLGPC::Learner::Learn() {
 			RG_ERR_CLOSE("Exception during Learner::AddNewExperience(): " << e.what());
 		}
 
+		if (config.cudaEmptyCacheInterval > 0 && device.is_cuda() && (iteration % config.cudaEmptyCacheInterval) == 0)
+			MemoryInfo::EmptyCUDACache();
+
 		Timer ppoLearnTimer = {};
 
 		// Stop agents from inferencing during learn if we are not on CPU
 		// This is because learning is very GPU intensive, and letting iterations collect during that time slows it down
 		// On CPU, learning is its own thread, it's better to keep collecting
 		// Also, if config.collectionDuringLearn is false, we ignore this
-		bool blockAgentInferDuringLearn = config.collectionDuringLearn && !device.is_cpu();
+		// Agents that infer on their own device (see config.inferenceDevice) don't slow down learning
+		bool blockAgentInferDuringLearn = config.collectionDuringLearn && !device.is_cpu() && agentMgr->device == device;
 		{ // Run the actual PPO learning on the experience we have collected
 			
 			if (config.deterministic) {
@@ -393,16 +1376,64 @@ void RLGPC::Learner::Learn() {
 
 			RG_LOG("Learning...");
 			if (blockAgentInferDuringLearn)
-				agentMgr->disableCollection = true;
+				agentMgr->SetCollectionDisabled(true);
+
+			int phaseLearnThreads = coreScheduler ? coreScheduler->BeginLearn() : learnThreads;
+			if (phaseLearnThreads > 1)
+				torch::set_num_threads(phaseLearnThreads);
 
 			try {
-				ppo->Learn(expBuffer, report);
+				RG_TRACE_SCOPE("PPO Learn");
+				RG_ALLOC_SCOPE(LEARNER);
+				ppo->Learn(expBuffer, report, config.ppo.epochs - (streamedEpochTime > 0 ? 1 : 0));
 			} catch (std::exception& e) {
 				RG_ERR_CLOSE("Exception during PPOLearner::Learn(): " << e.what());
 			}
 
+			for (auto extra : extraPolicies) {
+				Report extraReport = {};
+				try {
+					RG_TRACE_SCOPE("Extra Policy Learn");
+					RG_ALLOC_SCOPE(LEARNER);
+					// Policies of whole games have their own PPO configs, the rest follow ours
+					int extraEpochs = config.gamePolicyConfigs.empty() ? config.ppo.epochs : extra->ppo->config.epochs;
+					extra->ppo->Learn(extra->expBuffer, extraReport, extraEpochs);
+				} catch (std::exception& e) {
+					RG_ERR_CLOSE("Exception during PPOLearner::Learn() of policy " << extra->id << ": " << e.what());
+				}
+
+				for (auto& pair : extraReport.data)
+					report[extra->GetMetricPrefix() + pair.first] = pair.second;
+			}
+
+			if (phaseLearnThreads > 1)
+				torch::set_num_threads(1);
+			if (coreScheduler)
+				coreScheduler->EndLearn();
+
+			if (config.standardizeOBS)
+				_UpdateOBSStandardization();
+
+			if (postLearnCallback)
+				postLearnCallback(this, report);
+
+			agentMgr->UpdateNativePolicy();
+			agentMgr->UpdateScriptedPolicy();
+
+			// Published before the version changes, so steps are never tagged with a newer version than the one that collected them
+			if (agentMgr->policyBuffers[0].policy) {
+				Timer publishTimer = {};
+				agentMgr->PublishPolicy(ppo->policy);
+				report["Policy Publish Time"] = publishTimer.Elapsed();
+			}
+			agentMgr->policyVersion++;
+			if (agentMgr->remoteServer)
+				agentMgr->remoteServer->UpdatePolicy(ppo->policy, agentMgr->policyVersion);
+			if (agentMgr->processServer)
+				agentMgr->processServer->UpdatePolicy(ppo->policy, agentMgr->policyVersion);
+
 			if (blockAgentInferDuringLearn)
-				agentMgr->disableCollection = false;
+				agentMgr->SetCollectionDisabled(false);
 
 			totalEpochs += config.ppo.epochs;
 		}
@@ -416,13 +1447,46 @@ void RLGPC::Learner::Learn() {
 		// Get all metrics from agent manager
 		agentMgr->GetMetrics(report);
 
+		{ // Add memory use to report
+			constexpr double MB = 1024 * 1024;
+			report["Process RSS MB"] = MemoryInfo::GetProcessRSS() / MB;
+			report["Process Peak RSS MB"] = MemoryInfo::GetPeakProcessRSS() / MB;
+			if (config.hugePages != HugePageMode::NONE)
+				report["Huge Pages MB"] = HugePages::GetProcessHugeBytes() / MB;
+
+			if (device.is_cuda()) {
+				auto cudaMemory = MemoryInfo::GetCUDAMemory();
+				report["CUDA Allocated MB"] = cudaMemory.allocated / MB;
+				report["CUDA Reserved MB"] = cudaMemory.reserved / MB;
+				report["CUDA Peak Allocated MB"] = cudaMemory.peakAllocated / MB;
+				report["CUDA Peak Reserved MB"] = cudaMemory.peakReserved / MB;
+			}
+
+			expBuffer->GetMetrics(report);
+		}
+
+		if (checkpointWriter)
+			checkpointWriter->GetMetrics(report);
+		if (policySnapshotWriter)
+			policySnapshotWriter->GetMetrics(report);
+
+		if (coreScheduler)
+			coreScheduler->GetMetrics(report);
+
+		if (rolloutRecorder)
+			rolloutRecorder->GetMetrics(report);
+
+		if (metricSender)
+			metricSender->GetMetrics(report);
+
 		if (!config.collectionDuringLearn) {
-			agentMgr->disableCollection = false;
+			agentMgr->SetCollectionDisabled(false);
 		}
 
 		// If we collect during consuption, don't just measure the time we waited for to collect for steps
 		// Because of collection during learn, this time could be near-zero, resulting in SPS showing some crazy number
-		double trueCollectionTime = config.collectionDuringLearn ? agentMgr->lastIterationTime : relCollectionTime;
+		// Agents also collect during the streamed epoch, which is part of consumption
+		double trueCollectionTime = config.collectionDuringLearn ? agentMgr->lastIterationTime : (relCollectionTime + streamedEpochTime);
 		if (blockAgentInferDuringLearn)
 			trueCollectionTime -= ppoLearnTime; // We couldn't have been collecting during this time
 		trueCollectionTime = RS_MAX(trueCollectionTime, relCollectionTime);
@@ -436,8 +1500,13 @@ void RLGPC::Learner::Learn() {
 			report["Collection Time"] = relCollectionTime;
 			report["Consumption Time"] = consumptionTime;
 			report["Collect-Consume Overlap Time"] = (trueCollectionTime - relCollectionTime);
+			if (streamedEpochTime > 0)
+				report["Streamed Epoch Time"] = streamedEpochTime;
 		}
 
+		if (config.adaptiveIteration.enabled)
+			_AdaptIteration(report, relCollectionTime, relEpochTime);
+
 		{ // Add timestep data to report
 			report["Collected Steps/Second"] = (int64_t)(timestepsCollected / trueCollectionTime);
 			report["Overall Steps/Second"] = (int64_t)(timestepsCollected / trueEpochTime);
@@ -445,6 +1514,29 @@ void RLGPC::Learner::Learn() {
 			report["Cumulative Timesteps"] = totalTimesteps;
 		}
 
+		if (RLGSC::AllocTracker::ENABLED) { // Add heap allocations of each subsystem since the last report
+			using namespace RLGSC;
+			for (int i = 0; i < (int)AllocTag::AMOUNT; i++) {
+				AllocTag tag = (AllocTag)i;
+				auto counts = AllocTracker::GetTotal(tag);
+				std::string tagName = AllocTracker::GetTagName(tag);
+				report[tagName + " Allocations"] = (int64_t)(counts.allocs - lastAllocCounts[i].allocs);
+				report[tagName + " Allocated MB"] = (counts.bytes - lastAllocCounts[i].bytes) / (1024.0 * 1024.0);
+				lastAllocCounts[i] = counts;
+			}
+		}
+
+		std::vector<RegressionDetector::Regression> regressions = {};
+		if (regressionDetector) {
+			regressions = regressionDetector->Update(report);
+			for (auto& regression : regressions) {
+				RG_LOG(
+					"WARNING: \"" << regression.metric << "\" regressed by " << (int)(regression.change * 100) << "% " <<
+					"(" << regression.value << ", baseline is " << regression.baseline << ")"
+				);
+			}
+		}
+
 		// Call iteration callback
 		if (iterationCallback) {
 			RG_LOG("Calling iteration callback...");
@@ -465,59 +1557,344 @@ void RLGPC::Learner::Learn() {
 		if (config.sendMetrics)
 			metricSender->Send(report);
 
+		if (metricFileWriter)
+			metricFileWriter->Write(report);
+
+		if (metricsServer)
+			_PublishServedMetrics(this, report);
+
 		// Save if needed
 		tsSinceSave += timestepsCollected;
+		tsSincePolicySnapshot += timestepsCollected;
 		if (tsSinceSave > config.timestepsPerSave && !config.checkpointSaveFolder.empty()) {
+			RG_TRACE_SCOPE("Save");
 			Save();
 			tsSinceSave = 0;
+			tsSincePolicySnapshot = 0; // Saving also adds a policy snapshot
+		} else if (policySnapshotWriter && tsSincePolicySnapshot > config.timestepsPerPolicySnapshot) {
+			RG_TRACE_SCOPE("Policy Snapshot");
+			SavePolicySnapshot();
+			tsSincePolicySnapshot = 0;
 		}
 
 		// Reset everything
 		agentMgr->ResetMetrics();
+
+		if (captureRegression) {
+			auto& reportFolder = config.regressionWatch.reportFolder;
+			auto tracePath = reportFolder / ("regression_trace_" + std::to_string(iteration) + ".json");
+			auto reportPath = reportFolder / ("regression_report_" + std::to_string(iteration) + ".json");
+			TraceRecorder::End(tracePath);
+			WriteRegressionReport(this, reportPath, iteration, pendingRegressions, report);
+			RG_LOG("Wrote regression trace and report to " << tracePath << " and " << reportPath);
+			pendingRegressions.clear();
+			lastRegressionCapture = iteration;
+		} else if (traceIteration) {
+			auto tracePath = config.traceFolder / ("trace_" + std::to_string(iteration) + ".json");
+			TraceRecorder::End(tracePath);
+			RG_LOG("Wrote trace to " << tracePath);
+		}
+
+		// Capture the next iteration, unless we captured one recently
+		if (!regressions.empty()) {
+			if (lastRegressionCapture < 0 || iteration - lastRegressionCapture >= config.regressionWatch.captureCooldown) {
+				pendingRegressions = regressions;
+			} else {
+				RG_LOG("\tNot capturing the regression, last capture was at iteration " << lastRegressionCapture);
+			}
+		}
+		iteration++;
 	}
 	
 	RG_LOG("Learner: Timestep limit of " << config.timestepLimit << " reached, stopping");
 	RG_LOG("\tStopping agents...");
 	agentMgr->StopAgents();
+
+	if (checkpointWriter) {
+		RG_LOG("\tWaiting for checkpoints to finish writing...");
+		checkpointWriter->WaitIdle();
+	}
+	if (policySnapshotWriter)
+		policySnapshotWriter->WaitIdle();
 }
 
-void RLGPC::Learner::AddNewExperience(GameTrajectory& gameTraj, Report& report) {
+// Infers the critic's values of states, as a float tensor [numStates] on outDevice
+// With a chunk size, states are inferred that many at a time into a preallocated output (see LearnerConfig::criticEvalChunkSize)
+torch::Tensor InferCriticValues(RLGPC::PPOLearner* ppo, torch::Tensor states, torch::Device outDevice, int64_t chunkSize, bool useHalf) {
 	RG_NOGRAD;
+	RLGPC::ValueEstimator* valueNet = (useHalf && ppo->valueNetHalf) ? ppo->valueNetHalf : ppo->valueNet;
+	auto fnForward = [&](torch::Tensor input) -> torch::Tensor {
+		if (valueNet == ppo->valueNetHalf)
+			input = input.to(RG_HALFPERC_TYPE);
+		return valueNet->Forward(input).flatten().to(torch::kFloat);
+	};
 
-	RG_LOG("Adding experience...");
+	int64_t count = states.size(0);
+	if (chunkSize <= 0 || count <= chunkSize)
+		return fnForward(states.to(ppo->device, true)).to(outDevice).contiguous();
+
+	// Kept on the device until every chunk is done, so reading them back doesn't wait on each chunk
+	torch::Tensor values = torch::empty({ count }, torch::TensorOptions().dtype(torch::kFloat).device(ppo->device));
+
+	// Each chunk is copied into a pinned buffer, which is uploaded while the chunk before it is being inferred
+	// A buffer is only refilled once its last upload is done
+	bool usePinned = ppo->device.is_cuda() && !states.is_pinned();
+	torch::Tensor staging[2] = {};
+	at::cuda::CUDAEvent uploadDone[2];
+
+	for (int64_t start = 0, chunk = 0; start < count; start += chunkSize, chunk++) {
+		int64_t end = RS_MIN(start + chunkSize, count);
+		torch::Tensor part = states.slice(0, start, end);
+
+		int slot = chunk % 2;
+		if (usePinned) {
+			if (!staging[slot].defined()) {
+				auto shape = states.sizes().vec();
+				shape[0] = chunkSize;
+				staging[slot] = torch::empty(shape, states.options().pinned_memory(true));
+			}
+
+			uploadDone[slot].synchronize();
+			torch::Tensor stage = staging[slot].slice(0, 0, end - start);
+			stage.copy_(part);
+			part = stage;
+		}
+
+		torch::Tensor input = part.to(ppo->device, true);
+		if (usePinned)
+			uploadDone[slot].record();
+
+		values.slice(0, start, end).copy_(fnForward(input));
+	}
+
+	return values.to(outDevice).contiguous();
+}
+
+RLGPC::TrajExperience RLGPC::Learner::_ComputeExperience(GameTrajectory& gameTraj, bool isSegment, PPOLearner* ppo, WelfordRunningStat& returnStats) {
+	RG_NOGRAD;
 
 	gameTraj.RemoveCapacity();
 	auto& trajData = gameTraj.data;
 
 	size_t count = trajData.actions.size(0);
 
-	// Construct input to the value function estimator that includes the final state (which an action was not taken in)
-	auto valInput = 
-		torch::cat({ trajData.states, torch::unsqueeze(trajData.nextStates[count - 1], 0) })
-		.to(ppo->device, true);
+	// Segments are processed on their own, so every truncated step needs the value of its own next state
+	bool useTruncValues = config.rolloutValues || isSegment;
+
+	// Values stay wherever GAE is computed
+	bool gaeOnDevice = config.gaeOnDevice && ppo->device.is_cuda();
+	torch::Device gaeDevice = gaeOnDevice ? ppo->device : torch::Device(torch::kCPU);
 
-	auto valPredsTensor = ppo->valueNet->Forward(valInput).cpu().flatten();
-	FList valPreds = TENSOR_TO_FLIST(valPredsTensor);
-	// TODO: rlgym-ppo runs torch.cuda.empty_cache() here
+	torch::Tensor valPredsTensor, truncValuesTensor;
+	if (config.rolloutValues) {
+		// Values were inferred during collection
+		valPredsTensor = trajData.values.to(gaeDevice, torch::kFloat).contiguous();
+	} else if (useTruncValues) {
+		valPredsTensor = InferCriticValues(ppo, trajData.states, gaeDevice, config.criticEvalChunkSize, config.criticEvalHalf);
+	} else {
+		// Construct input to the value function estimator that includes the final state (which an action was not taken in)
+		// The last step is always done or truncated, if it is done, its next value is unused
+		torch::Tensor finalState;
+		if (trajData.truncateds[count - 1].item<float>() != 0) {
+			finalState = gameTraj.truncNextStates[-1];
+		} else {
+			finalState = torch::zeros_like(trajData.states[0]);
+		}
+
+		// Inferred separately from the final state, so the states aren't copied to append it
+		valPredsTensor = torch::cat({
+			InferCriticValues(ppo, trajData.states, gaeDevice, config.criticEvalChunkSize, config.criticEvalHalf),
+			InferCriticValues(ppo, torch::unsqueeze(finalState, 0), gaeDevice, 0, config.criticEvalHalf)
+		});
+		// rlgym-ppo runs torch.cuda.empty_cache() here, see LearnerConfig::cudaEmptyCacheInterval
+	}
+
+	if (useTruncValues) {
+		// We only need the values of the next states where trajectories were truncated
+		truncValuesTensor = torch::zeros({ (int64_t)count }, torch::TensorOptions().device(gaeDevice));
+		auto truncIndices = trajData.truncateds.nonzero().flatten();
+		RG_ASSERT(truncIndices.size(0) == gameTraj.truncNextStates.size(0));
+		if (truncIndices.numel() > 0) {
+			auto truncValues = InferCriticValues(ppo, gameTraj.truncNextStates, gaeDevice, config.criticEvalChunkSize, config.criticEvalHalf);
+			truncValuesTensor.index_put_({ truncIndices.to(gaeDevice) }, truncValues);
+		}
+	}
+
+	TrajExperience result = {};
+	result.size = count;
 	
+	// Steps from older policies use the action probabilities of the current policy for PPO clipping
+	// They are then weighted by how much more likely the current policy is to take their action
+	torch::Tensor isRatios;
+	result.logProbs = trajData.logProbs;
+	result.isWeights = torch::ones({ (int64_t)count });
+	if (config.offPolicyCorrection) {
+		auto staleIndices = (trajData.policyVersions < (float)agentMgr->policyVersion).nonzero().flatten();
+		int64_t numStale = staleIndices.size(0);
+
+		result.numStale = numStale;
+		if (numStale > 0) {
+			auto staleStates = trajData.states.index_select(0, staleIndices);
+			auto staleActions = trajData.actions.index_select(0, staleIndices).to(torch::kInt64).view({ -1, 1 });
+
+			// Split into minibatches to limit memory use
+			std::vector<torch::Tensor> curLogProbParts = {};
+			for (int64_t start = 0; start < numStale; start += ppo->config.miniBatchSize) {
+				int64_t end = RS_MIN(start + ppo->config.miniBatchSize, numStale);
+				auto logProbs = ppo->policy->GetLogProbs(staleStates.slice(0, start, end).to(ppo->device, true));
+				curLogProbParts.push_back(logProbs.gather(-1, staleActions.slice(0, start, end).to(ppo->device, true)).flatten().cpu());
+			}
+			auto curLogProbs = torch::cat(curLogProbParts);
+
+			auto staleRatios = (curLogProbs - trajData.logProbs.index_select(0, staleIndices)).exp();
+			isRatios = torch::ones({ (int64_t)count });
+			isRatios.index_put_({ staleIndices }, staleRatios);
+			result.isWeights.index_put_({ staleIndices }, staleRatios.clamp_max(config.offPolicyRhoClip));
+
+			result.logProbs = trajData.logProbs.clone();
+			result.logProbs.index_put_({ staleIndices }, curLogProbs);
+
+			result.staleISWeightSum = result.isWeights.index_select(0, staleIndices).sum().item<double>();
+		}
+	}
+
 	float retStd = (config.standardizeReturns ? returnStats.GetSTD()[0] : 1);
 
+	if (gaeOnDevice) {
+		auto fnToDevice = [&](torch::Tensor t) -> torch::Tensor {
+			return t.defined() ? t.to(gaeDevice, true) : t;
+		};
+
+		torch::Tensor returns;
+		TorchFuncs::ComputeGAEDevice(
+			fnToDevice(trajData.rewards),
+			fnToDevice(trajData.dones),
+			fnToDevice(trajData.truncateds),
+			valPredsTensor,
+			result.advantages,
+			result.valueTargets,
+			returns,
+			config.gaeGamma,
+			config.gaeLambda,
+			retStd,
+			truncValuesTensor,
+			fnToDevice(isRatios),
+			config.offPolicyRhoClip,
+			config.offPolicyTraceClip
+		);
+		result.returns = TENSOR_TO_FLIST(returns);
+		return result;
+	}
+
 	// Compute GAE stuff
-	torch::Tensor advantages, valueTargets;
-	FList returns;
+	auto fnGetFloats = [](torch::Tensor& t) -> const float* {
+		t = t.cpu().to(torch::kFloat).contiguous();
+		return t.data_ptr<float>();
+	};
+	torch::Tensor 
+		rewards = trajData.rewards, 
+		dones = trajData.dones, 
+		truncateds = trajData.truncateds;
+
+	result.advantages = torch::empty({ (int64_t)count });
+	result.valueTargets = torch::empty({ (int64_t)count });
+	result.returns = FList(count);
 	TorchFuncs::ComputeGAE(
-		TENSOR_TO_FLIST(trajData.rewards),
-		TENSOR_TO_FLIST(trajData.dones),
-		TENSOR_TO_FLIST(trajData.truncateds),
-		valPreds,
-		advantages,
-		valueTargets,
-		returns,
+		fnGetFloats(rewards),
+		fnGetFloats(dones),
+		fnGetFloats(truncateds),
+		valPredsTensor.data_ptr<float>(),
+		count,
+		result.advantages.data_ptr<float>(),
+		result.valueTargets.data_ptr<float>(),
+		result.returns.data(),
 		config.gaeGamma,
 		config.gaeLambda,
-		retStd
+		retStd,
+		isSegment ? NULL : jobSystem,
+		truncValuesTensor.defined() ? truncValuesTensor.data_ptr<float>() : NULL,
+		isRatios.defined() ? fnGetFloats(isRatios) : NULL,
+		config.offPolicyRhoClip,
+		config.offPolicyTraceClip
 	);
 
+	return result;
+}
+
+// Splits a trajectory into the steps chosen by each policy ID, keeping their order (see LearnerConfig::playerPolicyIDs)
+// Players keep their policy and their steps are contiguous, so each part is still made of whole player trajectories
+std::vector<RLGPC::GameTrajectory> _SplitByPolicy(const RLGPC::GameTrajectory& gameTraj, int numPolicies) {
+	using namespace RLGPC;
+	RG_NOGRAD;
+
+	auto& data = gameTraj.data;
+
+	// Index of each truncated step's next state
+	auto truncMask = data.truncateds != 0;
+	auto truncOrder = truncMask.to(torch::kInt64).cumsum(0) - 1;
+
+	std::vector<GameTrajectory> result = std::vector<GameTrajectory>(numPolicies);
+	for (int id = 0; id < numPolicies; id++) {
+		auto policyMask = data.policyIDs == (float)id;
+		auto rows = policyMask.nonzero().flatten();
+
+		auto& part = result[id];
+		for (int i = 0; i < TrajectoryTensors::TENSOR_AMOUNT; i++)
+			part.data[i] = data[i].index_select(0, rows);
+		part.truncNextStates = gameTraj.truncNextStates.index_select(0, truncOrder.index_select(0, (truncMask & policyMask).nonzero().flatten()));
+		part.size = part.capacity = rows.size(0);
+	}
+	return result;
+}
+
+void RLGPC::Learner::AddNewExperience(GameTrajectory& gameTraj, Report& report) {
+	RG_NOGRAD;
+
+	RG_LOG("Adding experience...");
+
+	gameTraj.RemoveCapacity();
+
+	// Each extra policy gets the steps it chose, and we keep the rest
+	if (!extraPolicies.empty()) {
+		std::vector<GameTrajectory> policyTrajs = _SplitByPolicy(gameTraj, extraPolicies.size() + 1);
+		for (auto extra : extraPolicies)
+			_AddExtraPolicyExperience(extra, policyTrajs[extra->id], report);
+		gameTraj = std::move(policyTrajs[0]);
+	}
+
+	auto& trajData = gameTraj.data;
+
+	size_t count = trajData.actions.size(0);
+
+	// Segments are added in the same order they were computed in
+	Timer gaeTimer = {};
+	TrajExperience exp;
+	int64_t submittedSize = 0;
+	double submitTime = 0;
+	if (segmentExperience && segmentExperience->size == count && !segmentExperience->parts.empty()) {
+		exp = TrajExperience::Concat(segmentExperience->parts);
+		submittedSize = segmentExperience->submittedSize;
+		submitTime = segmentExperience->submitTime;
+	} else {
+		if (segmentExperience && segmentExperience->submittedSize > 0)
+			RG_ERR_CLOSE("Learner::AddNewExperience(): Collected steps don't match the segments already added to the experience buffer");
+
+		RG_TRACE_SCOPE("GAE", ppo->device);
+		exp = _ComputeExperience(gameTraj, false, ppo, returnStats);
+	}
+	if (segmentExperience)
+		*segmentExperience = {};
+	report["GAE Time"] = gaeTimer.Elapsed();
+
+	if (config.offPolicyCorrection) {
+		report["Stale Step Fraction"] = exp.numStale / (double)count;
+		if (exp.numStale > 0)
+			report["Mean Stale IS Weight"] = exp.staleISWeightSum / exp.numStale;
+	}
+
+	float retStd = (config.standardizeReturns ? returnStats.GetSTD()[0] : 1);
+
+	auto& returns = exp.returns;
 	float avgRet = 0;
 	for (float f : returns)
 		avgRet += abs(f);
@@ -526,32 +1903,250 @@ void RLGPC::Learner::AddNewExperience(GameTrajectory& gameTraj, Report& report)
 
 	if (config.standardizeReturns) {
 		int numToIncrement = RS_MIN(config.maxReturnsPerStatsInc, returns.size());
-		returnStats.Increment(returns, numToIncrement);
+		returnStats.Increment(returns, numToIncrement, jobSystem);
+	}
+
+	// Streamed segments are already in the buffer
+	if (submittedSize < count) {
+		Timer submitTimer = {};
+		_SubmitExperience(gameTraj, exp, expBuffer, ppo);
+		submitTime += submitTimer.Elapsed();
+	}
+	report["Buffer Submit Time"] = submitTime;
+}
+
+void RLGPC::Learner::_AddExtraPolicyExperience(ExtraPolicy* extra, GameTrajectory& gameTraj, Report& report) {
+	RG_NOGRAD;
+
+	if (gameTraj.size == 0)
+		return;
+
+	std::string prefix = extra->GetMetricPrefix();
+	TrajExperience exp;
+	{
+		RG_TRACE_SCOPE("GAE", extra->ppo->device);
+		exp = _ComputeExperience(gameTraj, false, extra->ppo, extra->returnStats);
 	}
 
+	if (config.offPolicyCorrection)
+		report[prefix + "Stale Step Fraction"] = exp.numStale / (double)gameTraj.size;
+
+	float retStd = (config.standardizeReturns ? extra->returnStats.GetSTD()[0] : 1);
+
+	auto& returns = exp.returns;
+	float avgRet = 0;
+	for (float f : returns)
+		avgRet += abs(f);
+	avgRet /= returns.size();
+	report[prefix + "Avg Return"] = avgRet / retStd;
+
+	if (config.standardizeReturns) {
+		int numToIncrement = RS_MIN(config.maxReturnsPerStatsInc, returns.size());
+		extra->returnStats.Increment(returns, numToIncrement, jobSystem);
+	}
+
+	_SubmitExperience(gameTraj, exp, extra->expBuffer, extra->ppo);
+}
+
+void RLGPC::Learner::_SubmitExperience(GameTrajectory& gameTraj, TrajExperience& exp, ExperienceBuffer* expBuffer, PPOLearner* ppo) {
+	RG_NOGRAD;
+	RG_TRACE_SCOPE("Buffer Submit");
+
+	auto& trajData = gameTraj.data;
 	auto expTensors = ExperienceTensors{
 			trajData.states,
 			trajData.actions,
-			trajData.logProbs,
+			exp.logProbs,
 			trajData.rewards,
 
 #ifdef RG_PARANOID_MODE
 			trajData.debugCounters,
 #endif
 
-			trajData.nextStates,
 			trajData.dones,
 			trajData.truncateds,
-			valueTargets,
-			advantages
+			exp.valueTargets,
+			exp.advantages,
+			exp.isWeights
 	};
+	if (config.mirrorFraction > 0)
+		expBuffer->MirrorExperience(expTensors, ppo->policy, ppo->config.miniBatchSize);
 	expBuffer->SubmitExperience(
 		expTensors
 	);
 }
 
+void RLGPC::Learner::_StreamSegment(GameTrajectory& segment) {
+	auto& segExp = *segmentExperience;
+
+	Timer submitTimer = {};
+	_SubmitExperience(segment, segExp.parts.back(), expBuffer, ppo);
+	segExp.submittedSize += segment.size;
+	segExp.submitTime += submitTimer.Elapsed();
+
+	if (segExp.streamed)
+		return;
+
+	// Need at least one batch to learn from
+	int64_t streamThreshold = RS_MAX((int64_t)(config.timestepsPerIteration * config.streamingLearnFraction), config.ppo.batchSize);
+	if (segExp.submittedSize < streamThreshold)
+		return;
+
+	if (config.deterministic)
+		return; // Learn() stops us once collection is done
+
+	// Agents keep pushing segments while we learn, we copy them in once we're done
+	RG_LOG("Learning on " << segExp.submittedSize << " streamed steps...");
+	Timer epochTimer = {};
+	try {
+		RG_TRACE_SCOPE("Streamed Epoch");
+		Report epochReport = {};
+		ppo->Learn(expBuffer, epochReport, 1, segExp.submittedSize);
+	} catch (std::exception& e) {
+		RG_ERR_CLOSE("Exception during streamed PPOLearner::Learn(): " << e.what());
+	}
+	segExp.streamed = true;
+	segExp.streamedEpochTime = epochTimer.Elapsed();
+}
+
+void RLGPC::Learner::SetNumAgents(int amount) {
+	if (amount < 1)
+		RG_ERR_CLOSE("Learner::SetNumAgents(): Amount must be at least 1 (got " << amount << ")");
+	_requestedNumAgents = amount;
+}
+
+double RLGPC::Learner::_Warmup() {
+	RG_LOG("\tWarming up...");
+	Timer warmupTimer = {};
+
+	// Step each arena, then roll it back, which keeps the memory its pools grew into
+	ArenaSnapshot snapshot = {};
+	for (auto agent : agentMgr->agents) {
+		std::lock_guard<std::mutex> lock(agent->gameStepMutex);
+		for (auto game : agent->games.games) {
+			Arena* arena = game->gym->arena;
+			arena->TakeSnapshot(snapshot);
+			arena->Step(config.warmupArenaTicks);
+			arena->RestoreSnapshot(snapshot);
+			arena->_ClearContactCache();
+			arena->_eventQueue.clear();
+		}
+	}
+
+	{
+		RG_NOGRAD;
+
+		// Policy inference at the batch size of each agent, on the policy it infers
+		// Inference that isn't through libtorch's allocators (native or scripted inference, the inference server, or CUDA graphs, which warm up themselves) is skipped
+		if (!agentMgr->inferServer && !agentMgr->useNativeInference && !agentMgr->useScriptedInference && !agentMgr->useCUDAGraphs) {
+			std::set<std::pair<DiscretePolicy*, int>> warmed = {};
+			for (auto agent : agentMgr->agents) {
+				DiscretePolicy* policy = agent->policy ? agent->policy : (agentMgr->policyHalf ? agentMgr->policyHalf : agentMgr->policy);
+				int batchSize = agent->games.totalPlayers;
+				if (batchSize > 0 && warmed.insert({ policy, batchSize }).second)
+					policy->GetAction(torch::zeros({ batchSize, obsSize }, torch::TensorOptions().device(policy->device)), config.deterministic);
+			}
+		}
+
+		// Critic inference of the states of an iteration, as done for GAE
+		if (!config.rolloutValues) {
+			bool gaeOnDevice = config.gaeOnDevice && ppo->device.is_cuda();
+			torch::Tensor states = torch::zeros({ config.timestepsPerIteration, obsSize });
+			InferCriticValues(ppo, states, gaeOnDevice ? ppo->device : torch::Device(torch::kCPU), config.criticEvalChunkSize, config.criticEvalHalf);
+		}
+	}
+
+	ppo->Warmup();
+
+	if (ppo->device.is_cuda())
+		torch::cuda::synchronize(ppo->device.has_index() ? ppo->device.index() : -1);
+
+	double elapsed = warmupTimer.Elapsed();
+	RG_LOG("\tWarmed up in " << elapsed << "s");
+	return elapsed;
+}
+
+bool RLGPC::Learner::_StartProfile() {
+	int64_t unixTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	auto path = config.profileFolder / ("profile_" + std::to_string(unixTime) + ".folded");
+	return SamplingProfiler::Start(path, config.profileSeconds, config.profileSampleHz);
+}
+
+void RLGPC::Learner::_UpdateNumAgents() {
+	if (!config.agentAmountFile.empty()) {
+		// Only re-read once it changes, so it can also be overridden with SetNumAgents()
+		std::error_code ec;
+		auto writeTime = std::filesystem::last_write_time(config.agentAmountFile, ec);
+		if (!ec && writeTime != _agentAmountFileTime) {
+			_agentAmountFileTime = writeTime;
+
+			std::ifstream inStream = std::ifstream(config.agentAmountFile);
+			int amount = 0;
+			if (inStream >> amount && amount >= 1) {
+				_requestedNumAgents = amount;
+			} else {
+				RG_LOG("Learner: WARNING: Failed to read an amount of agents from " << config.agentAmountFile);
+			}
+		}
+	}
+
+	int amount = _requestedNumAgents.exchange(-1);
+	if (amount < 1 || amount == agentMgr->agents.size())
+		return;
+
+	agentMgr->SetAgentAmount(amount);
+	config.numThreads = amount;
+}
+
+void RLGPC::Learner::_AdaptIteration(Report& report, double learnerWaitTime, double iterationTime) {
+	auto& adaptive = config.adaptiveIteration;
+
+	// Positive if agents waited on the learner, negative if the learner waited on agents
+	double agentWaitTime = report.Has("Collect Limit Wait Time") ? report["Collect Limit Wait Time"] : 0;
+	double imbalance = RS_CLAMP((agentWaitTime - learnerWaitTime) / RS_MAX(iterationTime, 1e-6), -1.0, 1.0);
+
+	if (std::abs(imbalance) >= adaptive.tolerance) {
+		// Learning takes about as long no matter how many new timesteps there are, so more timesteps give the learner less to do per timestep
+		int64_t prevTimesteps = config.timestepsPerIteration;
+		int64_t newTimesteps = (int64_t)(prevTimesteps * (1 + adaptive.adjustRate * imbalance));
+		config.timestepsPerIteration = RS_CLAMP(newTimesteps, adaptive.minTimesteps, adaptive.maxTimesteps);
+
+		// Epochs are a much coarser change, so they only move when timesteps can't, or the imbalance is large
+		bool timestepsAtBound = (config.timestepsPerIteration == prevTimesteps);
+		if (timestepsAtBound || std::abs(imbalance) >= adaptive.epochThreshold) {
+			int epochChange = (imbalance > 0) ? -1 : 1;
+			config.ppo.epochs = RS_CLAMP(config.ppo.epochs + epochChange, adaptive.minEpochs, adaptive.maxEpochs);
+		}
+
+		// Agents collect up to the next iteration ahead, like when they were created
+		agentMgr->maxCollect = (uint64_t)(config.timestepsPerIteration * 1.5f);
+	}
+
+	report["Adaptive Imbalance"] = imbalance;
+	report["Adaptive Timesteps Per Iteration"] = config.timestepsPerIteration;
+	report["Adaptive PPO Epochs"] = config.ppo.epochs;
+}
+
 void RLGPC::Learner::UpdateLearningRates(float policyLR, float criticLR) {
 	ppo->UpdateLearningRates(policyLR, criticLR);
+	for (auto extra : extraPolicies)
+		extra->ppo->UpdateLearningRates(policyLR, criticLR);
+}
+
+RLGPC::PPOLearner* RLGPC::Learner::GetPolicyPPO(int id) {
+	if (id < 0 || id > extraPolicies.size())
+		RG_ERR_CLOSE("Learner::GetPolicyPPO(): Invalid policy ID " << id << " (we have " << GetNumPolicies() << " policies)");
+	return (id == 0) ? ppo : extraPolicies[id - 1]->ppo;
+}
+
+RLGPC::WelfordRunningStat& RLGPC::Learner::GetPolicyReturnStats(int id) {
+	if (id < 0 || id > extraPolicies.size())
+		RG_ERR_CLOSE("Learner::GetPolicyReturnStats(): Invalid policy ID " << id << " (we have " << GetNumPolicies() << " policies)");
+	return (id == 0) ? returnStats : extraPolicies[id - 1]->returnStats;
+}
+
+void RLGPC::Learner::SwapEnvs(const std::function<RLGSC::EnvSwap(GameInst* game)>& swapFn) {
+	agentMgr->SwapEnvs(swapFn);
 }
 
 std::vector<RLGPC::Report> RLGPC::Learner::GetAllGameMetrics() {
@@ -559,7 +2154,7 @@ std::vector<RLGPC::Report> RLGPC::Learner::GetAllGameMetrics() {
 
 	for (auto agent : agentMgr->agents) {
 		agent->gameStepMutex.lock();
-		for (auto game : agent->gameInsts)
+		for (auto game : agent->games.games)
 			reports.push_back(game->_metrics);
 		agent->gameStepMutex.unlock();
 	}
@@ -568,10 +2163,28 @@ std::vector<RLGPC::Report> RLGPC::Learner::GetAllGameMetrics() {
 }
 
 RLGPC::Learner::~Learner() {
+	delete checkpointWriter; // Finishes any checkpoint that is still being written
+	delete policySnapshotWriter;
+	delete segmentExperience;
 	delete ppo;
+	delete coreScheduler;
 	delete agentMgr;
+	for (auto extra : extraPolicies)
+		delete extra; // After our agents, as they infer its policy
+	delete rolloutRecorder; // After our agents, as they submit to it
+	delete opponentPool; // Members still used by agents are kept alive by them
 	delete expBuffer;
 	delete metricSender;
 	delete renderSender;
-	pybind11::finalize_interpreter();
+	delete spectator; // After our agents, as they publish to it
+	delete metricFileWriter;
+	delete regressionDetector;
+	delete metricsServer;
+	delete jobSystem; // After everything that runs jobs on it
+	SamplingProfiler::Wait();
+
+#ifndef RG_NO_PYTHON
+	if (pythonInitialized)
+		pybind11::finalize_interpreter();
+#endif
 }
\ No newline at end of file
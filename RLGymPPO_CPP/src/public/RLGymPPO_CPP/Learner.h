@@ -1,15 +1,25 @@
 #pragma once
 
-#include "Threading/GameInst.h"
+#include "Threading/GymBatch.h"
 #include "Util/WelfordRunningStat.h"
 #include "Util/MetricSender.h"
 #include "Util/RenderSender.h"
 #include "LearnerConfig.h"
+#include "AutotuneConfig.h"
+#include "BenchmarkConfig.h"
+#include "EvalConfig.h"
+#include "PretrainConfig.h"
+#include "DistillConfig.h"
+#include "PopulationConfig.h"
 
 namespace RLGPC {
 
 	typedef std::function<void(class Learner*, Report&)> IterationCallback;
 
+	struct TrajExperience;
+	struct SegmentExperience;
+	struct ExtraPolicy;
+
 	// https://github.com/AechPro/rlgym-ppo/blob/main/rlgym_ppo/learner.py
 	class RG_IMEXPORT Learner {
 	public:
@@ -18,9 +28,24 @@ namespace RLGPC {
 		class PPOLearner* ppo;
 		class ThreadAgentManager* agentMgr;
 		class ExperienceBuffer* expBuffer;
+		class CheckpointWriter* checkpointWriter = NULL; // Only used with config.asyncCheckpointSave
+		class CheckpointWriter* policySnapshotWriter = NULL; // Only used with config.timestepsPerPolicySnapshot
+		class CoreScheduler* coreScheduler = NULL; // Only used with config.coreScheduling
+		class JobSystem* jobSystem = NULL; // Only used with config.jobThreads
+		SegmentExperience* segmentExperience = NULL; // Experience computed from segments during collection, only used with config.collectionSegmentSteps
 		EnvCreateFn envCreateFn;
 		MetricSender* metricSender;
 		RenderSender* renderSender;
+		class MetricFileWriter* metricFileWriter = NULL; // Only used with config.metricsFilePath
+		class RegressionDetector* regressionDetector = NULL; // Only used with config.regressionWatch
+		class MetricsHTTPServer* metricsServer = NULL; // Only used with config.metricsHTTPPort
+		class RolloutRecorder* rolloutRecorder = NULL; // Only used with config.rolloutRecordPath
+		class OpponentPool* opponentPool = NULL; // Only used with config.opponentPoolSize
+		class Spectator* spectator = NULL; // Only used with config.spectate
+		std::vector<ExtraPolicy*> extraPolicies = {}; // Policies with IDs from 1, in ID order, only used with config.playerPolicyIDs or config.gamePolicyConfigs
+
+		// Python is only started if something needs it (sendMetrics)
+		bool pythonInitialized = false;
 
 		int obsSize;
 		int actionAmount;
@@ -36,18 +61,113 @@ namespace RLGPC {
 		Learner(EnvCreateFn envCreateFunc, LearnerConfig config);
 		void Learn();
 		void AddNewExperience(class GameTrajectory& gameTraj, Report& report);
+		// ppo and returnStats are those of the policy that collected gameTraj, which is ours unless we have extra policies
+		TrajExperience _ComputeExperience(class GameTrajectory& gameTraj, bool isSegment, class PPOLearner* ppo, WelfordRunningStat& returnStats);
+		void _SubmitExperience(class GameTrajectory& gameTraj, TrajExperience& exp, class ExperienceBuffer* expBuffer, class PPOLearner* ppo);
+
+		// Adds the experience of an extra policy's steps to its own buffer, with metrics under its name
+		void _AddExtraPolicyExperience(ExtraPolicy* extra, class GameTrajectory& gameTraj, Report& report);
+
+		// Adds a segment to the experience buffer, and runs the first epoch once enough are in (see config.streamingLearnFraction)
+		void _StreamSegment(class GameTrajectory& segment);
 
 		void UpdateLearningRates(float policyLR, float criticLR);
 
+		// Amount of policies we train, including our own (see config.playerPolicyIDs and config.gamePolicyConfigs)
+		int GetNumPolicies() const {
+			return extraPolicies.size() + 1;
+		}
+		// PPO learner and return stats of a policy by ID, ID 0 being our own
+		class PPOLearner* GetPolicyPPO(int id);
+		WelfordRunningStat& GetPolicyReturnStats(int id);
+
+		// Adds or removes agents at the start of the next learn iteration, until there are this many
+		// Steps of removed agents are still learned from, and each agent's share of the steps per iteration is rebalanced
+		// Can be called from any thread, such as an iteration callback
+		void SetNumAgents(int amount);
+		std::atomic<int> _requestedNumAgents = -1;
+		std::filesystem::file_time_type _agentAmountFileTime = {};
+
+		// Applies SetNumAgents() and config.agentAmountFile
+		void _UpdateNumAgents();
+
+		// Warms up our games and models for config.warmup, returns the time taken
+		double _Warmup();
+
+		// Starts a sampling profile that is written to config.profileFolder, returns false if one is already running
+		// Can be called from any thread
+		bool _StartProfile();
+
+		// Adjusts config.timestepsPerIteration and config.ppo.epochs from the wait times of the last iteration (see config.adaptiveIteration)
+		// learnerWaitTime is how long the learner waited on collection, agents' wait times are read from the report
+		void _AdaptIteration(Report& report, double learnerWaitTime, double iterationTime);
+
+		// Trains the policy to choose the recorded actions of a dataset (behavior cloning), before learning with PPO
+		// Uses the policy and optimizer of our PPO learner, and saves to our checkpoint folder
+		void Pretrain(PretrainConfig pretrainConfig);
+
+		// Trains a smaller policy (the student) to choose actions like our policy (the teacher), for cheaper inference (e.g. with PolicyInferUnit)
+		// Learns on recorded datasets, or on observations our agents collect, and saves the student to distillConfig.outputFolder
+		// Our policy is not changed
+		void Distill(DistillConfig distillConfig);
+
+		// Swaps the reward function, terminal conditions, OBS builder or state setter of every game at the start of its next episode, without recreating its arena
+		// swapFn is called for each game, with its agent stopped, and returns what to swap into it (see RLGSC::EnvSwap)
+		// Only games of our own agents are swapped, games made afterward (see SetNumAgents()) come from the env create function
+		void SwapEnvs(const std::function<RLGSC::EnvSwap(GameInst* game)>& swapFn);
+
+		// Copies the string-keyed metrics of every game, which stops each agent while copying
+		// Metrics registered with MetricRegistry are added to the report automatically instead
 		std::vector<Report> GetAllGameMetrics();
 
 		void Save();
+		// Saves only the policy and running stats to config.policySnapshotFolder, on a background thread
+		void SavePolicySnapshot();
 		void Load();
 		void SaveStats(std::filesystem::path path);
 		void LoadStats(std::filesystem::path path);
+		void _LoadStatsJSON(const std::string& jStr);
+
+		// Different than RLGym-PPO to show that they are not compatible
+		constexpr static const char* STATS_FILE_NAME = "RUNNING_STATS.json";
+
+		// Used instead of the other files with config.singleFileCheckpoints
+		constexpr static const char* CHECKPOINT_FILE_NAME = "CHECKPOINT.rgck";
+		constexpr static const char* CHECKPOINT_STATS_ENTRY = "stats";
+
+		// Experience buffer and random states, only saved with config.warmRestartCheckpoints
+		constexpr static const char* WARM_RESTART_FILE_NAME = "WARM_RESTART.rgck";
+		void _LoadWarmRestart(std::filesystem::path path);
+
+		// Merges the observation stats our agents collected, and standardizes the observations of our models with them
+		// Only called between learn iterations, so that the steps of each iteration are learned with the standardization they were collected with
+		void _UpdateOBSStandardization();
+
+		// Runs short trials of learners with different numThreads, numGamesPerThread, and ppo.miniBatchSize (see AutotuneConfig)
+		// Returns baseConfig with the fastest values, which are also saved to tuneConfig.outputPath
+		static LearnerConfig Autotune(EnvCreateFn envCreateFn, LearnerConfig baseConfig, AutotuneConfig tuneConfig);
+
+		// Applies values saved by Autotune() to config, returns false if there is no file at path
+		static bool LoadAutotuneResult(std::filesystem::path path, LearnerConfig& config);
+
+		// Runs learners with every combination of values in benchConfig, and writes their speed, time of each phase, and memory use to benchConfig.outputPath
+		// Use a fixed config.randomSeed, so runs of different builds can be compared
+		static void Benchmark(EnvCreateFn envCreateFn, LearnerConfig baseConfig, BenchmarkConfig benchConfig);
+
+		// Plays the policies of evalConfig against each other in many arenas at once, as fast as the simulator runs
+		// Writes the results of each pair, and a rating of each policy, to evalConfig.outputPath
+		static void Evaluate(EnvCreateFn envCreateFn, EvalConfig evalConfig);
+
+		// Trains the members of a population as the policies of one learner, which deals out the games of its agents between them (see LearnerConfig::gamePolicyConfigs)
+		// Worse members periodically copy the models of better ones and explore new learning rates from theirs (population-based training)
+		static void TrainPopulation(EnvCreateFn envCreateFn, PopulationConfig populationConfig);
+
+		// Called after each learn phase, before our agents get the new policy, so it can still change our models
+		IterationCallback postLearnCallback = NULL;
 
 		IterationCallback iterationCallback = NULL;
 		StepCallback stepCallback = NULL;
+		BatchStepCallback batchStepCallback = NULL; // Called once per step of each agent's games, can be used alongside stepCallback
 
 		RG_NO_COPY(Learner);
 
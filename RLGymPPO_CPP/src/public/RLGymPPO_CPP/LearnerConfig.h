@@ -1,6 +1,9 @@
 #pragma once
 #include "Lists.h"
 #include "PPO/PPOLearnerConfig.h"
+#include "AdaptiveIterationConfig.h"
+#include "RegressionWatchConfig.h"
+#include "MemoryBudgetConfig.h"
 
 namespace RLGPC {
 	enum class LearnerDeviceType {
@@ -9,27 +12,175 @@ namespace RLGPC {
 		GPU_CUDA
 	};
 
+	// How observations are stored in the experience buffer
+	enum class OBSStorageType {
+		FLOAT,
+		HALF,
+		BF16,
+		// Scaled by the max absolute value of each feature, from OBSBuilder::GetOBSScales()
+		// Falls back to BF16 if the OBS builder doesn't provide scales
+		INT16
+	};
+
+	// How agent threads are pinned to CPU cores
+	enum class AgentPinMode {
+		NONE,
+		CORES, // Each agent is pinned to one core
+		NUMA_NODES // Agents are spread across NUMA nodes, and each is pinned to all cores of its node
+	};
+
 	// https://github.com/AechPro/rlgym-ppo/blob/main/rlgym_ppo/learner.py
 	struct LearnerConfig {
 		int numThreads = 8;
 		int numGamesPerThread = 16;
+
+		// If set, the amount of agents (numThreads) is read from this file at the start of every learn iteration, and agents are added or removed to match it
+		// The file should only contain the number, and is only re-read once it changes
+		// Use this to grow collection when the machine is idle and shrink it when other jobs need it, without restarting (also see Learner::SetNumAgents())
+		std::filesystem::path agentAmountFile = {};
+
+		// If above 0, agents don't run on threads of their own, and this many worker threads collect their steps instead (see CollectionWorkerPool)
+		// Agents that are ready to step wait in a shared queue, each worker takes the next one, steps all of its games once, and puts it back
+		// Use more agents than workers (e.g. numThreads = 32 and numGamesPerThread = 4 with 8 workers, instead of 8 agents of 16 games),
+		//	so that an agent whose games are slow (resets, demos, cars on walls) only holds up one worker while the others keep taking the rest
+		// Not used with pipelinedCollection, useCUDAGraphs, agentPinMode, or in render mode
+		int collectionWorkers = 0;
+
+		// Use a single inference thread that batches the observations of all agents together
+		// This is much faster on GPU, as the policy runs one big forward pass instead of many small ones
+		bool useInferenceServer = false;
+		// Minimum amount of observations the inference server waits for before inferring
 		int minInferenceSize = 80;
+		// Maximum time in seconds the inference server waits for minInferenceSize observations
+		float inferenceMaxWaitTime = 0.002f;
+
+		// Split the games of each thread into two halves, and step one half while the policy infers the other
+		// This hides the smaller of env step time and policy infer time, and is most useful with CPU inference
+		bool pipelinedCollection = false;
+
+		// Make the start state of each game's next episode ahead of time, while agents wait on inference (see Gym::resetAhead)
+		// Episodes that end then only restore that state, instead of running the state setter while stepping
+		// Only pipelined collection has idle time to make them in, otherwise they are made when the episode ends
+		bool resetAhead = false;
+
+		// Capture the policy's inference into CUDA graphs, and replay them every step
+		// Much faster for small policies, where kernel launch overhead is most of the inference time
+		// Does nothing on CPU or with the inference server, and falls back to normal inference if capturing fails
+		bool useCUDAGraphs = false;
+
+		// Agents infer a copy of the policy with our own CPU kernels, instead of torch
+		// Much faster for the small batches agents infer, and the learner can still use the GPU
+		// Build with RG_NATIVE_ARCH to use AVX2/AVX-512
+		// Not used by the inference server, which always uses torch
+		bool nativeInference = false;
+
+		// Agents infer a frozen TorchScript graph of the policy, optimized for inference, instead of the torch module
+		// The graph is built once, and the policy's weights are copied into it after every learn iteration
+		// Ignored if nativeInference is set, and not used by the inference server
+		bool scriptedInference = false;
+
+		// Agents predict the ball of each of their games this many ticks ahead after every step, read from GameInst::ballPred
+		// Predictions are only re-simulated from where they stop matching the real ball
+		// Set to 0 to disable
+		int ballPredTicks = 0;
+
+		// The arenas of each thread share one set of Bullet contact pools, sized from the car count of its first game (see ArenaCollisionPools)
+		// Saves a lot of memory with many games per thread, overflows of the pools are reported as metrics
+		bool shareCollisionPools = true;
+
+		// Helper threads each agent steps its games with, in addition to its own thread (see StepGraphExecutor)
+		// The physics of some games then overlaps with the observations and rewards of others, so a few agents can use more cores without more games
+		// Per-game step callbacks are then called from helper threads too
+		// Arenas stepped on different threads can't share collision pools, so this disables shareCollisionPools
+		// Set to 0 to disable
+		int stepHelperThreads = 0;
+
+		// Each agent steps the arenas of its games together one tick phase at a time (car pre-tick, Bullet step, car post-tick, pads, ball),
+		//	instead of running every phase of one arena before the next (see RLGSC::Gym::StepArenas())
+		// Each phase's code then stays in the instruction cache and branch predictors across all games, results are identical
+		// Does nothing with stepHelperThreads, which steps games across threads instead
+		bool interleaveArenaSteps = false;
+
+		// Worker threads of the learner's job system, which runs GAE, trajectory concatenation, batch gathering, and large OBS stat batches in parallel (see JobSystem)
+		// It is also Bullet's task scheduler, so parallel loops in the physics use the same workers instead of starting their own threads
+		// The learner thread works alongside them, so -1 uses (numThreads - 1) workers, and parallel work uses as many threads as there are agents
+		// Set to 0 to run all of it on the learner thread
+		int jobThreads = -1;
+
+		// Agents create their games at the same time, each on its own thread (pinned to the agent's cores, so the games' memory is local to them)
+		// The test environment used to find the OBS size and action amount becomes the first game
+		// NOTE: envCreateFn is then called from multiple threads at once, disable this if it isn't thread-safe
+		bool parallelEnvCreation = true;
+
+		// If learning on multiple GPUs (see PPOLearnerConfig::numGPUs), agents are spread across them for inference
+		// Each GPU infers with its own copy of the policy, which is synced after every learn iteration
+		// Not used by the inference server or native inference
+		bool spreadAgentsAcrossGPUs = false;
+
+		// Pin agent threads to CPU cores, their games are then also created on their own thread
+		// This keeps each agent's memory local to its cores on multi-socket machines
+		AgentPinMode agentPinMode = AgentPinMode::NONE;
+		// With AgentPinMode::CORES, agent i is pinned to agentPinCores[i % size], or to core i if empty
+		IList agentPinCores = {};
 
 		bool renderMode = false;
 		// If renderMode, this is the scaling of time for the game
 		// 1.0 = Run the game at real time
 		// 2.0 = Run the game twice as fast as real time
 		float renderTimeScale = 1.5f; 
+		// If renderMode, states are sent to RocketSimVis at this address
+		std::string renderAddress = "127.0.0.1";
+		int renderPort = 9273;
+
+		// Send one game to RocketSimVis (at renderAddress) while training, without slowing training down
+		// The game runs at training speed, and is sampled at spectateFPS
+		// Ignored in renderMode
+		bool spectate = false;
+		uint64_t spectateGameIndex = 0; // Index of the game across all agents, in the order they are created
+		float spectateFPS = 60;
 
 		// Set to 0 to disable
 		uint64_t timestepLimit = 0;
 
 		int64_t expBufferSize = 100 * 1000;
+		// Keep the experience buffer on the GPU, instead of moving every minibatch there during learning
+		// Uses more GPU memory, does nothing on CPU
+		bool expBufferOnDevice = false;
+		// Observations are most of the experience buffer's memory, storing them in 16 bits halves it
+		// They are converted back to float once their batch is on the device
+		OBSStorageType expBufferOBSType = OBSStorageType::FLOAT;
+		// Fraction of collected steps to mirror left-right before they are added to the experience buffer, with the mirror maps of the OBS builder and action parser
+		// (see OBSBuilder::GetOBSMirrorMap() and ActionParser::GetMirrorActionMap())
+		// The field is symmetric, so mirrored steps are as valid as collected ones, and they replace the originals so nothing extra is stored
+		// The policy is run once on each mirrored step, for the log prob of its mirrored action
+		// Set to 0 to disable
+		float mirrorFraction = 0;
+		// Back the experience buffer (if on the CPU) and each agent's rollout storage with huge pages
+		// Cuts down on TLB misses when gathering shuffled minibatches from a large buffer
+		// Falls back to regular pages if huge pages aren't available, "Huge Pages MB" in the report shows how much memory actually got them
+		// NOTE: Arena slabs are set by the ArenaConfig given to each Gym (see ArenaConfig::slabHugePages)
+		HugePageMode hugePages = HugePageMode::NONE;
+		// Split the experience buffer (if on the CPU) into one shard per NUMA node, with each shard's memory on its node
+		// Minibatches are stratified across shards, and each shard's part is gathered by threads on its own node,
+		//	so gathering doesn't cross the interconnect and its bandwidth scales with sockets
+		// Does nothing with a single NUMA node
+		bool expBufferNUMAShards = false;
+		// If set, the experience buffer (if on the CPU) is backed by memory-mapped files in this folder instead of memory, so expBufferSize can be larger than our memory
+		// Recently written and sampled rows stay in memory, and the OS writes older ones out to the files once it needs the memory (use a fast drive, such as an NVMe SSD)
+		// Each minibatch's rows are read in order on the prefetch thread, with nearby rows merged into large reads
+		// The files are deleted when the buffer is, overrides hugePages and expBufferNUMAShards for the buffer
+		std::filesystem::path expBufferSpillFolder = {};
 		int64_t timestepsPerIteration = 50 * 1000;
 		bool standardizeReturns = true;
-		bool standardizeOBS = false; // TODO: Implement
 		int maxReturnsPerStatsInc = 150;
+
+		// Standardize observations with running stats of the observations our agents collect
+		// Agents sample the observations of every stepsPerObsStatsInc steps, and the stats used by the models are updated after each learn iteration
+		// Observations are still stored raw, standardization is a multiply-add done inside the models (and folded into the native policy)
+		bool standardizeOBS = false;
 		int stepsPerObsStatsInc = 5;
+		// Standard deviations of observations are clamped to at least this, so that near-constant values aren't scaled up massively
+		float minOBSSTD = 0.01f;
 
 		// Actions with the highest probability are always chosen, instead of being more likely
 		// This will make your bot play better, but is horrible for learning
@@ -38,12 +189,97 @@ namespace RLGPC {
 
 		// Collect additional steps during the learning phase
 		// Note that, once the learning phase completes and the policy is updated, these additional steps are from the old policy
+		// Use offPolicyCorrection to correct for this
 		bool collectionDuringLearn = false;
 
+		// Adjust timestepsPerIteration and ppo.epochs after every iteration, so neither the learner nor the agents wait on each other
+		// Requires collectionDuringLearn, as otherwise they never run at the same time
+		AdaptiveIterationConfig adaptiveIteration = {};
+
+		// Agents infer one of two copies of the policy, instead of the policy that PPO learning updates in-place
+		// After every learn iteration, the new parameters are written into the copy agents aren't using, which is then swapped in
+		// This keeps collection during learning from inferring half-updated parameters, and from sharing the policy's memory with the optimizer
+		// Copies are half precision with ppo.halfPrecModels
+		// Not used by the inference server, nativeInference or scriptedInference, which infer their own copies
+		bool inferencePolicyBuffers = false;
+
+		// Threads torch uses within each operation of PPO learning on the CPU
+		// Collection always uses one thread per agent (and per inference thread) so that agents don't oversubscribe the CPU
+		// Set to 0 to use every core while collection is paused during learning (collectionDuringLearn is false), and one thread otherwise
+		// NOTE: Per-thread thread counts need libtorch's default OpenMP backend, otherwise this also applies to collection during learning
+		int learnThreads = 0;
+
+		// Hand cores between agents and learning as the learner changes phase, for learning on the CPU with collectionDuringLearn
+		// During learning, coreSchedulingLearnFraction of the agents are parked after their current step, and learning uses their cores instead
+		// With agentPinMode, learning is pinned to the cores only parked agents were pinned to, otherwise it uses the same share of all cores
+		// Overrides learnThreads
+		bool coreScheduling = false;
+		float coreSchedulingLearnFraction = 0.75f;
+
+		// Agents hand off their steps in segments of this many steps (per player), through a lock-free queue
+		// Segments are copied into the collected timesteps as they arrive, instead of all being concatenated once enough are collected
+		// Their values and advantages are also computed as they arrive, so only the last segments are left once collection ends
+		// NOTE: Each segment ends in a truncation, so use segments much longer than your discount horizon
+		// Set to 0 to disable, and collect all steps of every agent at the end of each iteration
+		int collectionSegmentSteps = 0;
+
+		// Start learning before collection of an iteration ends, requires collectionSegmentSteps
+		// Segments are added to the experience buffer as they arrive, and once this fraction of timestepsPerIteration is in, the first PPO epoch runs on them
+		// Agents keep collecting the rest during that epoch (even on GPU), then the remaining epochs run on the whole iteration as usual
+		// NOTE: Steps collected during the first epoch are from a policy that is partway through its update
+		// Set to 0 to disable
+		float streamingLearnFraction = 0;
+
+		// Corrects for steps collected by an older version of the policy (from collectionDuringLearn or remote workers)
+		// Their value targets and advantages use V-trace importance weights, and their PPO loss is importance-weighted
+		//	Their PPO ratio is also clipped around the policy from before this learn iteration, instead of the policy that collected them
+		// Steps from the current policy are unaffected
+		bool offPolicyCorrection = false;
+		// Maximum importance weight of the TD error and PPO loss (V-trace's rho-bar)
+		float offPolicyRhoClip = 1;
+		// Maximum importance weight of the trace (V-trace's c-bar)
+		float offPolicyTraceClip = 1;
+
+		// Infer critic values alongside the policy during collection, instead of in one big pass over all collected steps
+		// This removes a stall between collection and learning, only the values of truncated next states are inferred afterward
+		// NOTE: Values are from the critic at the time of collection, which is from before the learn iteration that uses them
+		//	With collectionDuringLearn, some values can also be from a critic that is being updated
+		bool rolloutValues = false;
+
+		// Port to accept remote workers on (see RemoteWorker), set to 0 to disable
+		// Their trajectories are added to the ones collected by our own agents
+		// Not compatible with rolloutValues, as workers don't infer the critic
+		int remoteWorkerPort = 0;
+		// Trajectories from remote workers collected with a policy more than this many learn iterations old are dropped
+		int remoteMaxPolicyAge = 1;
+
+		// Amount of extra processes to collect in, alongside our own agents, set to 0 to disable
+		// Workers are copies of this executable, started with the same arguments, that stop at the start of the Learner constructor
+		// Their segments are written into shared memory, and used by the learner from there without being copied or serialized
+		// The learner's policy is written into their shared memory after every learn iteration, segments from too old of a policy are dropped (see remoteMaxPolicyAge)
+		// Not compatible with rolloutValues, as workers don't infer the critic
+		// NOTE: Only the learner's own agents add to the OBS stats and game metrics, and everything before the Learner constructor also runs in every worker
+		int numProcessWorkers = 0;
+		int processWorkerThreads = 8; // Agents of each process worker, each has numGamesPerThread games
+		int processSegmentSteps = 5000; // Steps per segment each agent of a process worker hands off
+		int processRingMB = 256; // Size of each process worker's ring of segments, must fit at least one segment
+
 		PPOLearnerConfig ppo = {};
 
 		float gaeLambda = 0.95f;
 		float gaeGamma = 0.99f;
+		// Compute advantages and value targets on the learning device (if it's a GPU) with a parallel scan (see TorchFuncs::ComputeGAEDevice())
+		// Values never leave the device, and rewards, dones, and truncateds are moved there once, only returns are read back for return standardization
+		// Results can differ from the CPU's sequential pass by rounding
+		bool gaeOnDevice = false;
+
+		// Infer the critic's values for GAE this many steps at a time, into one preallocated output, instead of all of an iteration's steps at once
+		// Caps the GPU memory of computing experience, which otherwise grows with timestepsPerIteration
+		// On a GPU, chunks are uploaded through two pinned buffers, so each chunk uploads while the last is inferred
+		// Set to 0 to infer all steps at once
+		int64_t criticEvalChunkSize = 0;
+		// Infer those values with the half-precision copy of the critic, only used with ppo.halfPrecModels
+		bool criticEvalHalf = false;
 
 		// Set to a directory with numbered subfolders, the learner will load the subfolder with the highest number
 		// If the folder is empty or does not exist, loading is skipped
@@ -56,19 +292,127 @@ namespace RLGPC {
 		std::filesystem::path checkpointSaveFolder = "checkpoints"; 
 		bool saveFolderAddUnixTimestamp = false; // Appends the unix time to checkpointSaveFolder
 
+		// Copy the models and optimizers in memory when saving, and write them to disk on a background thread
+		// Learning continues while the checkpoint is written, which helps a lot on slow or network filesystems
+		bool asyncCheckpointSave = false;
+
+		// Save each checkpoint as a single file (CHECKPOINT.rgck) with raw, aligned weights, instead of separate torch archives
+		// Loading memory-maps the file, and the policy can be loaded on its own by PolicyInferUnit without reading optimizer state
+		// Both formats can always be loaded
+		bool singleFileCheckpoints = false;
+
+		// Checkpoints also save the experience buffer, its random engine, the random engines of our games and torch's CPU generator
+		// A resumed run then learns from a full buffer right away, instead of collecting until it fills up again
+		// Saved as a memory-mapped file (WARM_RESTART.rgck) in the checkpoint's folder, which is loaded if it exists
+		// NOTE: Saving copies the whole buffer, so it is written in the background with asyncCheckpointSave
+		bool warmRestartCheckpoints = false;
+
 		// Save every timestep
 		// Set to zero to just use timestepsPerIteration
 		int64_t timestepsPerSave = 500 * 1000;
 
-		int randomSeed = 123;
+		int randomSeed = 123; // Seeds torch, and the random engine of each game (see RLGSC::Match::randEngine)
 		int checkpointsToKeep = 5; // Checkpoint storage limit before old checkpoints are deleted, set to -1 to disable
+
+		// Also save lightweight policy snapshots every this many timesteps, for evaluation and hot reloading, set to 0 to disable
+		// Each is a timestep-numbered subfolder of policySnapshotFolder with only the policy and running stats,
+		//	which PolicyInferUnit (and its hot reload) and Evaluate() load like a checkpoint, but which can't be resumed from
+		// Snapshots are always written on a background thread
+		// Full checkpoints also add a snapshot, which hard-links the checkpoint's policy file instead of writing it again
+		int64_t timestepsPerPolicySnapshot = 0;
+		std::filesystem::path policySnapshotFolder = "policy_snapshots";
+		int policySnapshotsToKeep = 20; // Like checkpointsToKeep, but for policy snapshots
 		LearnerDeviceType deviceType = LearnerDeviceType::AUTO; // Auto will use your CUDA GPU if available
 
+		// Device to learn on, as a torch device string (e.g. "cuda:0"), overrides deviceType if set
+		std::string learnDevice = "";
+
+		// Device agents infer the policy on, as a torch device string (e.g. "cuda:1" or "cpu"), leave empty to infer on the learning device
+		// On a different device, agents infer their own copies of the policy (see inferencePolicyBuffers), so collection never competes with learning
+		//	Agents then also keep collecting during learning with collectionDuringLearn, even if learning is on a GPU
+		// Copies are updated after every learn iteration, the time it takes is reported as "Policy Publish Time"
+		// Not used by the inference server, and "cpu" is best combined with nativeInference
+		std::string inferenceDevice = "";
+
+		// Play against past versions of the policy, keeping up to this many of them on the device, set to 0 to disable
+		// The pool starts with the newest checkpoints in checkpointLoadFolder, and gets a copy of the policy every time we save
+		// Whenever a game starts an episode, its orange team is played by a random past policy with a chance of opponentPoolProb
+		// Steps of past policies are not learned from, and don't count towards timestepsPerIteration
+		int opponentPoolSize = 0;
+		float opponentPoolProb = 0.2f;
+
+		// Policy ID of each player slot of a game, in the order of the match's players, set empty to control every player with one policy
+		// Slots with ID 0 (and slots past the end) are played by the main policy, every other ID is its own policy with its own models,
+		//	optimizers, experience buffer, and return stats, which learns from only the steps of its slots after the main policy learns
+		// All policies step in the same games, share OBS standardization, and are saved in "policy_<ID>" subfolders of each checkpoint
+		// Metrics of a policy are prefixed with "Policy <ID>"
+		// Not compatible with opponentPoolSize, remote or process workers, collectionSegmentSteps, or rolloutValues
+		IList playerPolicyIDs = {};
+
+		// PPO configs of extra policies that each play whole games, instead of player slots of every game (see playerPolicyIDs)
+		// Games are dealt out in turn to the main policy (ID 0, which uses ppo) and these, policy <i + 1> using gamePolicyConfigs[i]
+		// Each policy learns from only the steps of its games, and is saved and reported like a playerPolicyIDs policy,
+		//	along with the episode metrics of its games (e.g. "Policy 0 Average Episode Reward" for the main policy)
+		// Used by Learner::TrainPopulation(), so the members of a population share one set of agents and games
+		// Not compatible with playerPolicyIDs, or anything playerPolicyIDs isn't compatible with
+		std::vector<PPOLearnerConfig> gamePolicyConfigs = {};
+
 		// Send metrics to the python metrics receiver
 		// The receiver can then log them to wandb or whatever
+		// Python is only started if this is enabled
 		bool sendMetrics = true;
 		std::string metricsProjectName = "rlgymppo-cpp"; // Project name for the python metrics receiver
 		std::string metricsGroupName = "unnamed-runs"; // Group name for the python metrics receiver
 		std::string metricsRunName = "rlgymppo-cpp-run"; // Run name for the python metrics receiver
+
+		// Append each iteration's metrics to this file as a line of JSON, set empty to disable
+		// Doesn't need Python, so this also works with sendMetrics disabled or when built with RG_NO_PYTHON
+		std::filesystem::path metricsFilePath = {};
+
+		// Record the rollouts of some games to this file, for debugging and offline analysis, set empty to disable
+		// Includes the observations, actions, rewards and dones of every step, as well as periodic arena states
+		// Agents copy steps into segments, which are compressed (if built with zlib) and written on a background thread
+		std::filesystem::path rolloutRecordPath = {};
+		int rolloutRecordGameInterval = 16; // 1 in this many games is recorded
+		int rolloutRecordSegmentSteps = 1024; // Steps per written segment, of each recorded game
+		int rolloutRecordStateInterval = 64; // Steps between recorded arena states, set to 0 to not record states
+
+		// Serve the latest metrics on this port at /metrics, in the Prometheus text format, set to 0 to disable
+		// Includes per-agent times, process memory use, and CUDA allocator memory use
+		int metricsHTTPPort = 0;
+
+		// Return the CUDA memory cached by libtorch to the driver every this many learn iterations, set to 0 to disable
+		// rlgym-ppo does this every iteration, which lowers reserved memory when other processes share the GPU, but makes re-allocation slower
+		int cudaEmptyCacheInterval = 0;
+
+		// Before collection starts, step every arena warmupArenaTicks ticks (then roll it back), and run the policy, critic and a learn pass on zeros at our batch shapes
+		// This lets Bullet's pools, the device's allocator, and cuBLAS/oneDNN settle, so the first iterations aren't slower than the rest
+		// The time taken is reported as "Warmup Time" in the first iteration, models and game states are unchanged
+		bool warmup = false;
+		int warmupArenaTicks = 8;
+
+		// Write a timeline of some learn iterations to this folder, as "trace_<iteration>.json", set empty to disable
+		// Traces are in the Chrome trace event format, open them at ui.perfetto.dev or chrome://tracing
+		// Every agent and the learner thread add events for what they are doing, so overlap and stalls between them can be seen
+		// Parts of learning that run on a CUDA GPU are also timed on the GPU with CUDA events, which waits for the GPU once per trace
+		std::filesystem::path traceFolder = {};
+		int traceIterationInterval = 10; // 1 in this many learn iterations is traced
+
+		// Write a sampled CPU profile of every thread to this folder whenever one is requested, as "profile_<unix time>.folded", set empty to disable
+		// Profiles are requested by sending SIGUSR2 to the process, creating "profile.trigger" in this folder, or a GET of /profile on metricsHTTPPort
+		// Signal and file requests start at the next learn iteration
+		// Stacks are rooted at the role of their thread ("Learner", "Agent", "Agent Step Helper", ...), in the collapsed format flamegraph.pl and speedscope open
+		// Unlike traces, this sees inside env stepping and libtorch, and doesn't need perf to be attached (Linux and macOS only)
+		std::filesystem::path profileFolder = {};
+		float profileSeconds = 10;
+		int profileSampleHz = 200;
+
+		// Watch for iterations where throughput drops (or step, inference, or learn times rise) compared to recent iterations
+		// Regressions log a warning, and the iteration after them is traced and reported to regressionWatch.reportFolder
+		RegressionWatchConfig regressionWatch = {};
+
+		// Scale back expBufferSize, expBufferOBSType, expBufferOnDevice, numGamesPerThread, ppo.miniBatchSize,
+		//	ppo.activationCheckpointLayers, and criticEvalChunkSize until the learner's estimated memory fits a RAM and VRAM budget
+		MemoryBudgetConfig memoryBudget = {};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	// Settings for fitting the learner into a memory budget (see LearnerConfig::memoryBudget)
+	// At startup, the memory of each part of the learner is estimated from the config, the OBS size, and the test environment
+	// If the estimate doesn't fit, the config is scaled back one step at a time, starting with the steps that cost the least speed
+	// Values in the config are the most we want, they are never raised
+	// The plan is logged, and the learner stops if nothing fits
+	struct MemoryBudgetConfig {
+		bool enabled = false;
+
+		// Host RAM, and GPU memory of the learning device, we may use (in GB), set to 0 to not limit one
+		float hostGB = 0;
+		float deviceGB = 0;
+
+		// Fraction of each budget left for what isn't estimated (libtorch itself, the CUDA context, allocator fragmentation, ...)
+		float headroom = 0.15f;
+
+		// Lowest values the plan may scale down to
+		int minGamesPerThread = 4;
+		int64_t minMiniBatchSize = 5000;
+	};
+}
@@ -12,13 +12,60 @@ namespace RLGPC {
 		float criticLR = 3e-4f; // Critic learning rate
 		float entCoef = 0.005f; // Entropy coefficient
 		float clipRange = 0.2f;
+
+		// Stop the rest of a learn iteration's batches and epochs once a batch's mean KL divergence passes this, set to 0 to disable
+		// Each batch's KL is read from the device without waiting for it, so stopping can lag a batch or two behind
+		float targetKL = 0;
 		int64_t miniBatchSize = 0; // Set to 0 to just use batchSize
 
+		// Share the hidden layers of the policy (policyLayerSizes) with the critic, which then only has its own head on top of them
+		// Both heads are learned from one forward and backward pass through the shared layers, and criticLayerSizes is unused
+		// The policy is saved the same as without this, the critic's head is saved on its own (as PPO_CRITIC_HEAD.lt)
+		// Checkpoints with a separate critic can still be loaded, but only their policy is used
+		bool sharedTrunk = false;
+		IList criticHeadLayerSizes = {}; // Hidden layers of the critic's head, only used with sharedTrunk
+
+		// Weight of the value loss, which matters most with sharedTrunk, as the value loss then also trains the shared layers
+		float valueLossCoef = 1;
+
 		// Experimental, improves PPO learn speed
 		// If this causes your learning to collapse, please let me know
+		// Runs the forward passes of learning in bf16, parameters and optimizer states stay in fp32
+		// Also works when learning on CPU, which is only faster on CPUs with bf16 matmuls (AVX512-BF16 or AMX, e.g. Sapphire Rapids)
+		//	Elsewhere bf16 is emulated and slower, compare both with Learner::Benchmark() (see BenchmarkConfig::autocastLearnModes)
 		bool autocastLearn = false;
 
-		// Very experimental, uses half-precision versions of models where beneficial
+		// Uses a half-precision copy of the policy for collection inference, which is faster on GPU
+		// The copy is updated once per learn iteration, and its divergence from the full policy is reported
+		// Learning itself is always done in full precision
 		bool halfPrecModels = false;
+
+		// Amount of CUDA GPUs to learn on, starting from the first one
+		// Each GPU has a copy of the models and computes the gradients of a shard of every minibatch
+		// Gradients are summed on the first GPU before clipping and stepping, which then sends its parameters back out
+		// Not compatible with autocastLearn
+		int numGPUs = 1;
+
+		// Time the parts of each learn iteration on the GPU with CUDA events, and report them as "PPO GPU ... Time"
+		// Unlike the other PPO timers, which only time how long the work took to queue up, these are the times the GPU spent running it
+		// Also reports the fraction of the iteration the GPU was idle for, which is high if learning is held back by the CPU
+		// Events are only read at the end of the iteration, so this doesn't add any waiting for the GPU
+		// Only the first GPU is timed, and this needs libtorch built with CUDA
+		bool gpuEventTiming = false;
+
+		// Clip gradients and step the optimizers of both models together with multi-tensor ops, instead of a few kernels per parameter
+		// Gradient norms are also never read back, so stepping doesn't wait for the device
+		// Not used with autocastLearn on a GPU, as its grad scaler steps the optimizers itself
+		bool fusedOptimizerStep = true;
+
+		// Run each Linear and ReLU of the policy and critic as one GEMM, with the bias and ReLU fused into it (cuBLASLt's epilogue on CUDA)
+		// Saves a kernel and an intermediate activation per hidden layer, in both inference and learning
+		// Parameters are unchanged, so checkpoints are the same either way
+		bool fusedLayers = false;
+
+		// Recompute the activations of the policy and critic during backward, instead of storing them, in blocks of this many layers (0 to disable)
+		// Only the input of each block is stored, so much larger minibatches fit in memory, but every minibatch is run forward twice
+		// Checkpoints are the same either way
+		int activationCheckpointLayers = 0;
 	};
 }
\ No newline at end of file
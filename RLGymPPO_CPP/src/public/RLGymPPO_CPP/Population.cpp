@@ -0,0 +1,114 @@
+#include "Learner.h"
+#include "PopulationConfig.h"
+
+#include <RLGymPPO_CPP/PPO/PPOLearner.h>
+
+using namespace RLGPC;
+
+struct _PopulationMember {
+	float fitness = 0;
+	bool hasFitness = false;
+};
+
+// Copies the parameters of one model into another, returns false (copying nothing) if their layouts differ
+bool _CopyModelParams(torch::nn::Module& from, torch::nn::Module& to) {
+	RG_NOGRAD;
+	auto fromParams = from.parameters(), toParams = to.parameters();
+	if (fromParams.size() != toParams.size())
+		return false;
+	for (int i = 0; i < fromParams.size(); i++)
+		if (!fromParams[i].sizes().equals(toParams[i].sizes()))
+			return false;
+
+	for (int i = 0; i < fromParams.size(); i++)
+		toParams[i].copy_(fromParams[i]);
+	return true;
+}
+
+void Learner::TrainPopulation(EnvCreateFn envCreateFn, PopulationConfig populationConfig) {
+	auto& memberConfigs = populationConfig.memberConfigs;
+	int numMembers = memberConfigs.size();
+	if (numMembers < 1)
+		RG_ERR_CLOSE("Learner::TrainPopulation(): No member configs");
+	if (populationConfig.exploitInterval > 0 && populationConfig.exploreLRFactors.empty())
+		RG_ERR_CLOSE("Learner::TrainPopulation(): exploreLRFactors is empty");
+
+	// Member 0 is the learner's own policy, the rest each play their own share of its games
+	LearnerConfig config = populationConfig.config;
+	config.ppo = memberConfigs[0];
+	config.gamePolicyConfigs = std::vector<PPOLearnerConfig>(memberConfigs.begin() + 1, memberConfigs.end());
+
+	std::vector<_PopulationMember> members = std::vector<_PopulationMember>(numMembers);
+	int iterations = 0;
+	std::mt19937 rng = std::mt19937(std::random_device()());
+
+	// Members among the worst copy the models of members among the best, called right after every member learns
+	auto fnExploit = [&](Learner* learner, Report& report) {
+		iterations++;
+		if (populationConfig.exploitInterval <= 0 || (iterations % populationConfig.exploitInterval) != 0)
+			return;
+
+		IList ranking = {};
+		for (int i = 0; i < numMembers; i++)
+			if (members[i].hasFitness)
+				ranking.push_back(i);
+		if (ranking.size() < 2)
+			return;
+		std::sort(ranking.begin(), ranking.end(), [&](int a, int b) { return members[a].fitness > members[b].fitness; });
+
+		// No member is both copied and copying, so every copy is of a model from this iteration's learn
+		int exploitAmount = RS_MAX((int)(ranking.size() * populationConfig.exploitFraction), 1);
+		exploitAmount = RS_MIN(exploitAmount, (int)ranking.size() / 2);
+
+		for (int rank = ranking.size() - exploitAmount; rank < ranking.size(); rank++) {
+			int memberIndex = ranking[rank];
+			int sourceIndex = ranking[rng() % exploitAmount];
+			float lrFactor = populationConfig.exploreLRFactors[rng() % populationConfig.exploreLRFactors.size()];
+
+			PPOLearner* source = learner->GetPolicyPPO(sourceIndex);
+			PPOLearner* target = learner->GetPolicyPPO(memberIndex);
+			if (!_CopyModelParams(*source->policy, *target->policy) || !_CopyModelParams(*source->valueNet, *target->valueNet)) {
+				RG_LOG("Learner::TrainPopulation(): Member " << memberIndex << " can't copy member " << sourceIndex << ", as their models have different layouts");
+				continue;
+			}
+
+			// OBS standardization is already shared by every policy of the learner
+			learner->GetPolicyReturnStats(memberIndex) = learner->GetPolicyReturnStats(sourceIndex);
+			target->UpdateModelCopies();
+			target->UpdateLearningRates(source->config.policyLR * lrFactor, source->config.criticLR * lrFactor);
+
+			// Measured again from scratch, as its fitness was of its old models
+			members[memberIndex].hasFitness = false;
+
+			RG_LOG("Learner::TrainPopulation(): Member " << memberIndex << " copied member " << sourceIndex << ", with learning rates scaled by " << lrFactor);
+			report["Policy " + std::to_string(memberIndex) + " Population Copied Member"] = sourceIndex;
+		}
+	};
+
+	auto fnIteration = [&](Learner* learner, Report& report) {
+		for (int i = 0; i < numMembers; i++) {
+			std::string prefix = "Policy " + std::to_string(i) + " ";
+			std::string metric = prefix + populationConfig.fitnessMetric;
+			if (!report.Has(metric) && i == 0)
+				metric = populationConfig.fitnessMetric; // Metrics of the learner's own policy aren't prefixed
+			if (!report.Has(metric))
+				continue;
+
+			_PopulationMember& member = members[i];
+			float value = report[metric];
+			member.fitness = member.hasFitness ? (member.fitness + (value - member.fitness) * populationConfig.fitnessSmoothing) : value;
+			member.hasFitness = true;
+			report[prefix + "Population Fitness"] = member.fitness;
+		}
+
+		if (populationConfig.iterationCallback)
+			populationConfig.iterationCallback(learner, report);
+	};
+
+	RG_LOG("Learner::TrainPopulation(): Creating learner for " << numMembers << " members...");
+	Learner* learner = new Learner(envCreateFn, config);
+	learner->postLearnCallback = fnExploit;
+	learner->iterationCallback = fnIteration;
+	learner->Learn();
+	delete learner;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "LearnerConfig.h"
+#include "Util/Report.h"
+
+namespace RLGPC {
+	// Settings for Learner::TrainPopulation()
+	struct PopulationConfig {
+		// Config of the one learner that trains every member, its agents and games are shared by the whole population
+		// Its ppo and gamePolicyConfigs are replaced by memberConfigs
+		// timestepsPerIteration is for the whole population, each member gets the steps of its own games
+		LearnerConfig config = {};
+
+		// PPO config of each member of the population, member i is the learner's policy i (see LearnerConfig::gamePolicyConfigs)
+		// Members must have models of the same layout to copy each other
+		std::vector<PPOLearnerConfig> memberConfigs = {};
+
+		// Every this many iterations, members in the worst exploitFraction each copy a member from the best exploitFraction
+		// Set to 0 to never exploit
+		int exploitInterval = 10;
+		float exploitFraction = 0.25f;
+
+		// A member that copied another gets its learning rates, multiplied by a random one of these
+		FList exploreLRFactors = { 0.8f, 1.25f };
+
+		// Report metric members are ranked by, higher is better
+		// Each member's is read with its policy's prefix (e.g. "Policy 1 Average Episode Reward"), falling back to the unprefixed metric for member 0
+		std::string fitnessMetric = "Average Episode Reward";
+		// Fitness is a running average of the metric, each iteration moves it this far towards the newest value
+		float fitnessSmoothing = 0.2f;
+
+		// Called after each iteration, once the fitness of every member is in the report
+		std::function<void(class Learner* learner, Report& report)> iterationCallback = NULL;
+	};
+}
@@ -0,0 +1,113 @@
+#include "Learner.h"
+#include "PretrainConfig.h"
+
+#include <RLGymPPO_CPP/PPO/PPOLearner.h>
+#include <RLGymPPO_CPP/Threading/ThreadAgentManager.h>
+#include <RLGymPPO_CPP/Util/CheckpointWriter.h>
+#include <RLGymPPO_CPP/Util/MetricFileWriter.h>
+#include <RLGymPPO_CPP/Util/RolloutDataset.h>
+
+using namespace RLGPC;
+
+// From Learner.cpp
+void DisplayReport(const RLGPC::Report& report);
+
+void RLGPC::Learner::Pretrain(PretrainConfig pretrainConfig) {
+	RG_LOG("Learner::Pretrain():");
+
+	if (pretrainConfig.datasetPaths.empty())
+		RG_ERR_CLOSE("Learner::Pretrain(): No dataset paths given");
+
+	RG_LOG("\tLoading dataset...");
+	RolloutDataset dataset = RolloutDataset(
+		pretrainConfig.datasetPaths, pretrainConfig.numWorkers, pretrainConfig.shuffleWindowSize, pretrainConfig.seed
+	);
+	RG_LOG("\t > " << dataset.totalRows << " rows in " << dataset.chunks.size() << " chunks, from " << dataset.files.size() << " file(s)");
+
+	if (dataset.obsSize != obsSize)
+		RG_ERR_CLOSE("Learner::Pretrain(): Dataset has an OBS size of " << dataset.obsSize << ", but our OBS size is " << obsSize);
+
+	float prevPolicyLR = ppo->config.policyLR;
+	if (pretrainConfig.learningRate > 0)
+		ppo->UpdateLearningRates(pretrainConfig.learningRate, ppo->config.criticLR);
+
+	// Pinned batches are copied to the GPU asynchronously, so the next batch is drawn while the GPU trains on this one
+	bool pinned = ppo->device.is_cuda();
+
+	// Summed on the device, and only read once per report
+	torch::Tensor lossSum = torch::zeros({}, ppo->device), accuracySum = torch::zeros({}, ppo->device);
+	int batchesSinceReport = 0;
+	int64_t rowsSinceReport = 0;
+	uint64_t totalBatches = 0;
+	Timer reportTimer = {};
+
+	auto fnReport = [&](int epoch) {
+		Report report = {};
+		report["Pretrain Loss"] = (lossSum / batchesSinceReport).item<float>();
+		report["Pretrain Accuracy"] = (accuracySum / batchesSinceReport).item<float>();
+		report["Pretrain Rows/Second"] = (int64_t)(rowsSinceReport / reportTimer.Elapsed());
+		report["Pretrain Epoch"] = epoch;
+		report["Pretrain Batches"] = totalBatches;
+
+		RG_LOG("Pretrain report:");
+		DisplayReport(report);
+
+		if (metricSender)
+			metricSender->Send(report);
+		if (metricFileWriter)
+			metricFileWriter->Write(report);
+
+		lossSum.zero_();
+		accuracySum.zero_();
+		batchesSinceReport = 0;
+		rowsSinceReport = 0;
+		reportTimer.Reset();
+	};
+
+	int epoch = 0;
+	for (; epoch < pretrainConfig.epochs; epoch++) {
+		RG_LOG("\tPretraining epoch " << (epoch + 1) << "/" << pretrainConfig.epochs << "...");
+		dataset.StartEpoch();
+
+		torch::Tensor obs, actions;
+		while (dataset.GetBatch(pretrainConfig.batchSize, obs, actions, pinned)) {
+			auto result = ppo->PretrainPolicy(obs, actions);
+			lossSum += result.loss;
+			accuracySum += result.accuracy;
+			batchesSinceReport++;
+			rowsSinceReport += obs.size(0);
+			totalBatches++;
+
+			if (batchesSinceReport >= pretrainConfig.batchesPerReport)
+				fnReport(epoch);
+
+			if (pretrainConfig.batchesPerSave > 0 && totalBatches % pretrainConfig.batchesPerSave == 0 && !config.checkpointSaveFolder.empty())
+				Save();
+		}
+	}
+
+	if (batchesSinceReport > 0)
+		fnReport(epoch - 1);
+
+	if (pretrainConfig.learningRate > 0)
+		ppo->UpdateLearningRates(prevPolicyLR, ppo->config.criticLR);
+
+	// Same as after a learn iteration
+	ppo->UpdateModelCopies();
+	agentMgr->UpdateNativePolicy();
+	agentMgr->UpdateScriptedPolicy();
+	agentMgr->PublishPolicy(ppo->policy);
+	agentMgr->policyVersion++;
+	if (agentMgr->remoteServer)
+		agentMgr->remoteServer->UpdatePolicy(ppo->policy, agentMgr->policyVersion);
+	if (agentMgr->processServer)
+		agentMgr->processServer->UpdatePolicy(ppo->policy, agentMgr->policyVersion);
+
+	if (!config.checkpointSaveFolder.empty()) {
+		Save();
+		if (checkpointWriter)
+			checkpointWriter->WaitIdle();
+	}
+
+	RG_LOG("Learner::Pretrain(): Finished after " << totalBatches << " batches");
+}
\ No newline at end of file
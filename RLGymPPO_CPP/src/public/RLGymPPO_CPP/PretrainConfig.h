@@ -0,0 +1,30 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	// Settings for Learner::Pretrain()
+	struct PretrainConfig {
+		// Files written by the rollout recorder (see LearnerConfig::rolloutRecordPath), or folders of them
+		std::vector<std::filesystem::path> datasetPaths = {};
+
+		int epochs = 1;
+		int64_t batchSize = 4096;
+
+		// Learning rate of the policy while pretraining, set to 0 to use ppo.policyLR
+		float learningRate = 0;
+
+		// Threads decoding chunks of the dataset
+		int numWorkers = 4;
+		// Rows are drawn randomly from at least this many decoded rows, larger windows shuffle better but use more memory
+		int64_t shuffleWindowSize = 1000 * 1000;
+
+		uint64_t seed = 0;
+
+		// Loss and accuracy are reported every this many batches, to the same places as learn iteration metrics
+		int batchesPerReport = 500;
+
+		// Save a checkpoint every this many batches, set to 0 to only save once pretraining finishes
+		// Checkpoints are the same as those saved while learning, so learning can continue from them
+		int batchesPerSave = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	// Settings for catching throughput regressions during long runs (see LearnerConfig::regressionWatch)
+	// Each watched metric is compared to its baseline, the median of its values over recent iterations that didn't regress
+	// Times are compared per collected timestep, so changes to timestepsPerIteration (e.g. from adaptiveIteration) don't look like regressions
+	// When a metric regresses past the threshold, a warning is logged, and the next iteration is traced and reported to reportFolder
+	struct RegressionWatchConfig {
+		bool enabled = false;
+
+		// Metrics that regress when they drop
+		std::vector<std::string> rateMetrics = { "Collected Steps/Second" };
+		// Metrics that regress when they rise
+		std::vector<std::string> timeMetrics = { "Env Step Time", "Policy Infer Time", "PPO Learn Time" };
+
+		// Relative change from the baseline that counts as a regression
+		float threshold = 0.2f;
+
+		// Iterations in each baseline
+		// Slow regressions are caught once they pass the threshold within about half of this many iterations
+		int baselineIterations = 200;
+		// A metric isn't compared until its baseline has this many iterations
+		int minBaselineIterations = 10;
+		// The first iterations aren't added to baselines, as caches and allocators are still warming up
+		int warmupIterations = 3;
+
+		// Iterations after a capture before the next regression can be captured
+		int captureCooldown = 50;
+
+		// Each capture writes "regression_trace_<iteration>.json" (like LearnerConfig::traceFolder) and "regression_report_<iteration>.json" here
+		// The report has the regressions, the baselines, every metric of the captured iteration, each agent's times, and memory use
+		std::filesystem::path reportFolder = "regression_reports";
+	};
+}
@@ -0,0 +1,175 @@
+#include "RemoteWorker.h"
+
+#include <RLGymPPO_CPP/PPO/DiscretePolicy.h>
+#include <RLGymPPO_CPP/Threading/ThreadAgentManager.h>
+#include <RLGymPPO_CPP/Threading/RemoteProtocol.h>
+
+using namespace RLGPC::RemoteProtocol;
+
+RLGPC::RemoteWorker::RemoteWorker(EnvCreateFn envCreateFn, RemoteWorkerConfig _config) :
+	envCreateFn(envCreateFn),
+	config(_config)
+{
+	torch::set_num_interop_threads(1);
+	torch::set_num_threads(1);
+
+	RG_LOG("RemoteWorker::RemoteWorker():");
+
+	if (RocketSim::GetStage() != RocketSimStage::INITIALIZED) {
+		RG_LOG("\tInitializing RocketSim...");
+		RocketSim::Init("collision_meshes", true, RocketSim::InitModes::Lazy());
+	}
+
+	{
+		RG_LOG("\tCreating test environment to determine OBS size and action amount...")
+		auto envCreateResult = envCreateFn();
+		auto obsSet = envCreateResult.gym->Reset();
+		obsSize = obsSet[0].size();
+		actionAmount = envCreateResult.match->actionParser->GetActionAmount();
+		RG_LOG("\t\tOBS size: " << obsSize);
+		RG_LOG("\t\tAction amount: " << actionAmount);
+		delete envCreateResult.gym;
+		delete envCreateResult.match;
+	}
+
+	auto device = torch::Device(torch::kCPU);
+	policy = new DiscretePolicy(obsSize, actionAmount, config.policyLayerSizes, device);
+
+	RG_LOG("\tCreating agent manager...");
+	agentMgr = new ThreadAgentManager(
+		policy, NULL, NULL,
+		false, false,
+		(uint64_t)(config.timestepsPerSegment * 1.5f),
+		device
+	);
+	agentMgr->pipelinedCollection = config.pipelinedCollection;
+	agentMgr->useNativeInference = config.nativeInference;
+
+	RG_LOG("\tCreating " << config.numThreads << " agents...");
+	agentMgr->CreateAgents(envCreateFn, config.numThreads, config.numGamesPerThread);
+}
+
+bool _Handshake(RLGPC::RemoteWorker* worker, RLGPC::TCPSocket& socket) {
+	DataStreamOut hello;
+	hello.Write<uint32_t>(VERSION);
+	WriteString(hello, worker->config.name);
+	hello.Write<int32_t>(worker->obsSize);
+	hello.Write<int32_t>(worker->actionAmount);
+	if (!SendMsg(socket, MsgType::HELLO, hello))
+		return false;
+
+	MsgType type;
+	DataStreamIn reply;
+	if (!RecvMsg(socket, type, reply) || type != MsgType::HELLO_REPLY)
+		return false;
+
+	bool accepted = reply.Read<uint8_t>();
+	std::string rejectReason = ReadString(reply);
+	if (!accepted)
+		RG_LOG("RemoteWorker: Learner rejected us: " << rejectReason);
+	return accepted;
+}
+
+// Gets the learner's policy if it has a newer version than ours
+bool _UpdatePolicy(RLGPC::RemoteWorker* worker, RLGPC::TCPSocket& socket) {
+	DataStreamOut request;
+	request.Write<uint64_t>(worker->policyVersion);
+	if (!SendMsg(socket, MsgType::POLICY_REQUEST, request))
+		return false;
+
+	MsgType type;
+	DataStreamIn reply;
+	if (!RecvMsg(socket, type, reply) || type != MsgType::POLICY)
+		return false;
+
+	uint64_t newVersion = reply.Read<uint64_t>();
+	if (newVersion == worker->policyVersion || reply.IsDone())
+		return true; // Already up to date
+
+	if (!ReadParams(reply, worker->policy)) {
+		RG_LOG("RemoteWorker: Learner sent a policy of a different size, make sure config.policyLayerSizes matches the learner");
+		return false;
+	}
+
+	RLGPC::OBSStandardization standardization;
+	if (!ReadOBSStandardization(reply, worker->obsSize, standardization)) {
+		RG_LOG("RemoteWorker: Learner sent an invalid OBS standardization");
+		return false;
+	}
+	worker->policy->SetOBSStandardization(standardization);
+
+	worker->policyVersion = newVersion;
+	worker->agentMgr->UpdateNativePolicy();
+
+	// Our steps are tagged with the learner's version of the policy
+	worker->agentMgr->policyVersion = newVersion;
+	return true;
+}
+
+void RLGPC::RemoteWorker::Run() {
+	RG_LOG("RemoteWorker::Run():");
+	agentMgr->SetStepCallback(stepCallback);
+	agentMgr->SetBatchStepCallback(batchStepCallback);
+
+	bool agentsStarted = false;
+
+	// Oldest policy version that the steps in our rollouts can be from
+	uint64_t segmentVersion = 0;
+
+	while (true) {
+		RG_LOG("RemoteWorker: Connecting to learner at " << config.learnerAddress << ":" << config.learnerPort << "...");
+		TCPSocket socket = TCPSocket::Connect(config.learnerAddress, config.learnerPort);
+
+		if (socket.IsOpen() && _Handshake(this, socket)) {
+			RG_LOG("RemoteWorker: Connected, getting policy...");
+
+			// Don't collect until we have a policy
+			if (_UpdatePolicy(this, socket) && policyVersion != 0) {
+				if (segmentVersion == 0)
+					segmentVersion = policyVersion; // Nothing was collected before
+
+				if (!agentsStarted) {
+					agentMgr->StartAgents();
+					agentsStarted = true;
+				} else {
+					agentMgr->SetCollectionDisabled(false);
+				}
+
+				while (true) {
+					Timer collectTimer = {};
+					GameTrajectory traj = agentMgr->CollectTimesteps(config.timestepsPerSegment);
+					double collectTime = collectTimer.Elapsed();
+
+					DataStreamOut msg;
+					msg.Write<uint64_t>(segmentVersion);
+					WriteTrajectory(msg, traj);
+					if (!SendMsg(socket, MsgType::TRAJECTORY, msg))
+						break;
+
+					// Agents keep collecting with our current policy until the new one is loaded
+					segmentVersion = policyVersion;
+					if (!_UpdatePolicy(this, socket))
+						break;
+
+					RG_LOG(
+						"RemoteWorker: Sent " << traj.size << " steps (" << (int64_t)(traj.size / RS_MAX(collectTime, 1e-6)) << " steps/second)" <<
+						", policy version: " << policyVersion
+					);
+				}
+			}
+
+			// Stop collecting until we reconnect, otherwise these steps would be even older
+			if (agentsStarted)
+				agentMgr->SetCollectionDisabled(true);
+		}
+
+		RG_LOG("RemoteWorker: Not connected to learner, retrying in " << config.reconnectDelay << "s...");
+		RG_SLEEP((int)(config.reconnectDelay * 1000));
+	}
+}
+
+RLGPC::RemoteWorker::~RemoteWorker() {
+	agentMgr->StopAgents();
+	delete agentMgr;
+	delete policy;
+}
\ No newline at end of file
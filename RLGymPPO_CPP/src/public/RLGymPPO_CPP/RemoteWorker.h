@@ -0,0 +1,35 @@
+#pragma once
+#include "Threading/GymBatch.h"
+#include "RemoteWorkerConfig.h"
+
+namespace RLGPC {
+	// Collects trajectories for a learner on another machine
+	// The worker gets the learner's latest policy, and sends back each segment of steps it collects with it
+	// Only CPU inference is used, as workers are made to run on machines without a GPU
+	class RG_IMEXPORT RemoteWorker {
+	public:
+		RemoteWorkerConfig config;
+		EnvCreateFn envCreateFn;
+
+		class DiscretePolicy* policy;
+		class ThreadAgentManager* agentMgr;
+
+		int obsSize;
+		int actionAmount;
+
+		// Version of the learner's policy we have, 0 if we don't have one yet
+		uint64_t policyVersion = 0;
+
+		StepCallback stepCallback = NULL;
+		BatchStepCallback batchStepCallback = NULL;
+
+		RemoteWorker(EnvCreateFn envCreateFn, RemoteWorkerConfig config);
+
+		// Collects and sends segments forever, reconnecting whenever the connection to the learner is lost
+		void Run();
+
+		RG_NO_COPY(RemoteWorker);
+
+		~RemoteWorker();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#include "Lists.h"
+
+namespace RLGPC {
+	struct RemoteWorkerConfig {
+		// Address and port of the learner, which needs LearnerConfig::remoteWorkerPort set
+		std::string learnerAddress = "127.0.0.1";
+		int learnerPort = 0;
+
+		// Shown in the learner's metrics, must be unique among the workers of a learner
+		std::string name = "worker";
+
+		int numThreads = 8;
+		int numGamesPerThread = 16;
+
+		// Amount of steps collected before they are sent to the learner
+		// The policy is also checked for updates after each send
+		int64_t timestepsPerSegment = 10 * 1000;
+
+		// Must match the learner's PPOLearnerConfig::policyLayerSizes
+		IList policyLayerSizes = { 256, 256, 256 };
+
+		// Same as in LearnerConfig
+		bool pipelinedCollection = false;
+		bool nativeInference = false;
+
+		// Seconds to wait before reconnecting to the learner
+		float reconnectDelay = 5;
+	};
+}
\ No newline at end of file
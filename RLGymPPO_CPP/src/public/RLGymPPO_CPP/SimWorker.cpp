@@ -0,0 +1,242 @@
+#include "SimWorker.h"
+#include "Threading/GymBatch.h"
+#include "Util/Timer.h"
+
+#include <RLGymPPO_CPP/PPO/NativeMLP.h>
+#include <RLGymPPO_CPP/Threading/SimRollout.h>
+#include <RLGymPPO_CPP/Threading/RemoteProtocolBase.h>
+
+using namespace RLGPC::RemoteProtocol;
+
+struct RLGPC::SimThread {
+	GymBatch batch;
+	SimRollout rollout;
+	std::mt19937 rng;
+
+	// [totalPlayers][obsSize], games write their observations here
+	FList obs;
+
+	// [totalPlayers]
+	std::vector<int64_t> actions;
+	FList logProbs, rewards, dones;
+};
+
+RLGPC::SimWorker::SimWorker(EnvCreateFn envCreateFn, RemoteWorkerConfig _config) :
+	envCreateFn(envCreateFn),
+	config(_config)
+{
+	RG_LOG("SimWorker::SimWorker():");
+
+	if (config.numThreads < 1 || config.numGamesPerThread < 1)
+		RG_ERR_CLOSE("SimWorker: numThreads and numGamesPerThread must be at least 1");
+
+	if (RocketSim::GetStage() != RocketSimStage::INITIALIZED) {
+		RG_LOG("\tInitializing RocketSim...");
+		RocketSim::Init("collision_meshes", true, RocketSim::InitModes::Lazy());
+	}
+
+	{
+		RG_LOG("\tCreating test environment to determine OBS size and action amount...")
+		auto envCreateResult = envCreateFn();
+		auto obsSet = envCreateResult.gym->Reset();
+		obsSize = obsSet[0].size();
+		actionAmount = envCreateResult.match->actionParser->GetActionAmount();
+		RG_LOG("\t\tOBS size: " << obsSize);
+		RG_LOG("\t\tAction amount: " << actionAmount);
+		delete envCreateResult.gym;
+		delete envCreateResult.match;
+	}
+
+	policy = new NativeMLP();
+
+	RG_LOG("\tCreating " << config.numThreads << " threads of " << config.numGamesPerThread << " games...");
+	std::random_device randDevice;
+	for (int i = 0; i < config.numThreads; i++) {
+		SimThread* thread = new SimThread();
+		for (int j = 0; j < config.numGamesPerThread; j++) {
+			auto envCreateResult = envCreateFn();
+			thread->batch.Add(new GameInst(envCreateResult.gym, envCreateResult.match));
+		}
+
+		int numPlayers = thread->batch.totalPlayers;
+		thread->obs.resize((size_t)numPlayers * obsSize);
+		thread->actions.resize(numPlayers);
+		thread->logProbs.resize(numPlayers);
+		thread->rewards.resize(numPlayers);
+		thread->dones.resize(numPlayers);
+		thread->rollout = SimRollout(numPlayers, obsSize);
+		thread->rng.seed(randDevice());
+
+		thread->batch.SetOBSOutput(thread->obs.data(), obsSize);
+		thread->batch.Start();
+		thread->rollout.SetCurOBS(thread->obs.data());
+
+		threads.push_back(thread);
+	}
+}
+
+bool _Handshake(RLGPC::SimWorker* worker, RLGPC::TCPSocket& socket) {
+	DataStreamOut hello;
+	hello.Write<uint32_t>(VERSION);
+	WriteString(hello, worker->config.name);
+	hello.Write<int32_t>(worker->obsSize);
+	hello.Write<int32_t>(worker->actionAmount);
+	if (!SendMsg(socket, MsgType::HELLO, hello))
+		return false;
+
+	MsgType type;
+	DataStreamIn reply;
+	if (!RecvMsg(socket, type, reply) || type != MsgType::HELLO_REPLY)
+		return false;
+
+	bool accepted = reply.Read<uint8_t>();
+	std::string rejectReason = ReadString(reply);
+	if (!accepted)
+		RG_LOG("SimWorker: Learner rejected us: " << rejectReason);
+	return accepted;
+}
+
+// Gets the learner's policy if it has a newer version than ours
+// Reads the same data as RemoteProtocol::ReadParams() and RemoteProtocol::ReadOBSStandardization()
+bool _UpdatePolicy(RLGPC::SimWorker* worker, RLGPC::TCPSocket& socket) {
+	DataStreamOut request;
+	request.Write<uint64_t>(worker->policyVersion);
+	if (!SendMsg(socket, MsgType::POLICY_REQUEST, request))
+		return false;
+
+	MsgType type;
+	DataStreamIn reply;
+	if (!RecvMsg(socket, type, reply) || type != MsgType::POLICY)
+		return false;
+
+	uint64_t newVersion = reply.Read<uint64_t>();
+	if (newVersion == worker->policyVersion || reply.IsDone())
+		return true; // Already up to date
+
+	// The amount of parameters is checked by NativeMLP::LoadParams()
+	uint64_t numParams = reply.Read<uint64_t>();
+	if (numParams * sizeof(float) > reply.GetNumBytesLeft()) {
+		RG_LOG("SimWorker: Learner sent an invalid policy");
+		return false;
+	}
+	RLGPC::FList params = RLGPC::FList(numParams);
+	reply.ReadBytes(params.data(), numParams * sizeof(float));
+
+	RLGPC::FList scale, shift;
+	bool standardizationSet = reply.Read<uint8_t>();
+	if (reply.IsOverflown() || (standardizationSet && !(
+		ReadFloats(reply, worker->obsSize, scale) &&
+		ReadFloats(reply, worker->obsSize, shift)))) {
+		RG_LOG("SimWorker: Learner sent an invalid OBS standardization");
+		return false;
+	}
+
+	bool loaded = worker->policy->LoadParams(
+		params.data(), params.size(), worker->obsSize, worker->config.policyLayerSizes, worker->actionAmount,
+		standardizationSet ? scale.data() : NULL, standardizationSet ? shift.data() : NULL
+	);
+	if (!loaded) {
+		RG_LOG("SimWorker: Learner sent a policy of a different size, make sure config.policyLayerSizes matches the learner");
+		return false;
+	}
+
+	worker->policyVersion = newVersion;
+	return true;
+}
+
+// Steps every thread's games until each thread has its share of the segment
+void _CollectSegment(RLGPC::SimWorker* worker) {
+	using namespace RLGPC;
+
+	int64_t stepsPerThread = RS_MAX(worker->config.timestepsPerSegment / worker->config.numThreads, 1);
+	float policyVersion = worker->policyVersion;
+
+	auto fnCollect = [&](SimThread* thread) {
+		auto& batch = thread->batch;
+		auto& rollout = thread->rollout;
+		int numPlayers = batch.totalPlayers;
+
+		while ((int64_t)(rollout.size * numPlayers) < stepsPerThread) {
+			worker->policy->Infer(
+				rollout.GetStates(rollout.size), numPlayers,
+				thread->actions.data(), thread->logProbs.data(), false, thread->rng
+			);
+
+			batch.Step(0, batch.Size(), thread->actions.data(), thread->rewards.data(), thread->dones.data());
+
+			rollout.AddStep(
+				thread->obs.data(), thread->actions.data(), thread->logProbs.data(),
+				thread->rewards.data(), thread->dones.data(), policyVersion
+			);
+		}
+	};
+
+	// The calling thread collects for the first thread
+	std::vector<std::thread> stdThreads = {};
+	for (int i = 1; i < worker->threads.size(); i++)
+		stdThreads.push_back(std::thread(fnCollect, worker->threads[i]));
+	fnCollect(worker->threads[0]);
+	for (auto& stdThread : stdThreads)
+		stdThread.join();
+}
+
+void RLGPC::SimWorker::Run() {
+	RG_LOG("SimWorker::Run():");
+	for (auto thread : threads) {
+		thread->batch.stepCallback = batchStepCallback;
+		for (auto game : thread->batch.games) {
+			game->stepCallback = stepCallback;
+			if (stepCallback)
+				game->match->AddExtraStateFields(RLGSC::StateFields::ALL);
+		}
+	}
+
+	while (true) {
+		RG_LOG("SimWorker: Connecting to learner at " << config.learnerAddress << ":" << config.learnerPort << "...");
+		TCPSocket socket = TCPSocket::Connect(config.learnerAddress, config.learnerPort);
+
+		if (socket.IsOpen() && _Handshake(this, socket)) {
+			RG_LOG("SimWorker: Connected, getting policy...");
+
+			// Don't collect until we have a policy
+			if (_UpdatePolicy(this, socket) && policyVersion != 0) {
+				while (true) {
+					Timer collectTimer = {};
+					_CollectSegment(this);
+					double collectTime = collectTimer.Elapsed();
+
+					// Every step of a segment is from the same policy
+					uint64_t segmentSize = 0;
+					std::vector<SimRollout*> rollouts = {};
+					for (auto thread : threads) {
+						segmentSize += thread->rollout.size * thread->rollout.numPlayers;
+						rollouts.push_back(&thread->rollout);
+					}
+
+					DataStreamOut msg;
+					msg.Write<uint64_t>(policyVersion);
+					SimRollout::WriteTrajectory(msg, rollouts);
+					if (!SendMsg(socket, MsgType::TRAJECTORY, msg))
+						break;
+
+					if (!_UpdatePolicy(this, socket))
+						break;
+
+					RG_LOG(
+						"SimWorker: Sent " << segmentSize << " steps (" << (int64_t)(segmentSize / RS_MAX(collectTime, 1e-6)) << " steps/second)" <<
+						", policy version: " << policyVersion
+					);
+				}
+			}
+		}
+
+		RG_LOG("SimWorker: Not connected to learner, retrying in " << config.reconnectDelay << "s...");
+		RG_SLEEP((int)(config.reconnectDelay * 1000));
+	}
+}
+
+RLGPC::SimWorker::~SimWorker() {
+	for (auto thread : threads)
+		delete thread;
+	delete policy;
+}
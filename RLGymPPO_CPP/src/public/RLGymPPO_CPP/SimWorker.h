@@ -0,0 +1,38 @@
+#pragma once
+#include "Threading/GymBatch.h"
+#include "RemoteWorkerConfig.h"
+
+namespace RLGPC {
+	// Same as RemoteWorker, but without libtorch, so it can be built and deployed on its own (see the RLGymPPO_CPP_Sim library)
+	// Inference uses our own CPU kernels (NativeMLP), and collection is synchronous: every segment is collected, then sent
+	// NOTE: config.pipelinedCollection and config.nativeInference are unused, inference is always native
+	class RG_IMEXPORT SimWorker {
+	public:
+		RemoteWorkerConfig config;
+		EnvCreateFn envCreateFn;
+
+		// Our copy of the learner's policy
+		class NativeMLP* policy;
+
+		// Games, rollout and inference buffers of each collection thread
+		std::vector<struct SimThread*> threads;
+
+		int obsSize;
+		int actionAmount;
+
+		// Version of the learner's policy we have, 0 if we don't have one yet
+		uint64_t policyVersion = 0;
+
+		StepCallback stepCallback = NULL;
+		BatchStepCallback batchStepCallback = NULL;
+
+		SimWorker(EnvCreateFn envCreateFn, RemoteWorkerConfig config);
+
+		// Collects and sends segments forever, reconnecting whenever the connection to the learner is lost
+		void Run();
+
+		RG_NO_COPY(SimWorker);
+
+		~SimWorker();
+	};
+}
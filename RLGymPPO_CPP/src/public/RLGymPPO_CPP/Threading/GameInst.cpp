@@ -4,10 +4,52 @@ void RLGPC::GameInst::Start() {
 	curObs = gym->Reset();
 }
 
-RLGSC::Gym::StepResult RLGPC::GameInst::Step(const IList& actions) {
+template <typename T>
+const RLGSC::Gym::StepResult& _Step(RLGPC::GameInst* game, const T& actions) {
+    auto gym = game->gym;
+    auto match = game->match;
+
     // Step with agent actions
-    auto stepResult = gym->Step(actions);
+    auto& stepResult = game->lastStepResult;
+    if (gym->obsOutput) {
+        // Everything is written into the memory of the last result
+        stepResult.reward.resize(match->playerAmount);
+        gym->StepInto(actions, stepResult.reward.data(), stepResult.done);
+        stepResult.state = gym->prevState;
+    } else {
+        stepResult = gym->Step(actions);
+    }
+
+    game->_OnStepped(stepResult);
+    return stepResult;
+}
+
+const RLGSC::Gym::StepResult& RLGPC::GameInst::Step(const IList& actions) {
+    return _Step(this, actions);
+}
+
+const RLGSC::Gym::StepResult& RLGPC::GameInst::Step(const int64_t* actions) {
+    return _Step(this, actions);
+}
 
+void RLGPC::GameInst::StepArena(const int64_t* actions) {
+    if (!gym->obsOutput)
+        RG_ERR_CLOSE("GameInst::StepArena(): Stepping in stages needs an OBS output");
+
+    gym->StepArena(actions);
+}
+
+const RLGSC::Gym::StepResult& RLGPC::GameInst::FinishStep() {
+    auto& stepResult = lastStepResult;
+    stepResult.reward.resize(match->playerAmount);
+    gym->FinishStepInto(stepResult.reward.data(), stepResult.done);
+    stepResult.state = gym->prevState;
+
+    _OnStepped(stepResult);
+    return stepResult;
+}
+
+void RLGPC::GameInst::_OnStepped(RLGSC::Gym::StepResult& stepResult) {
     auto& nextObs = stepResult.obs;
 
     {
@@ -37,6 +79,4 @@ RLGSC::Gym::StepResult RLGPC::GameInst::Step(const IList& actions) {
 
     curObs = nextObs;
     totalSteps++;
-
-    return stepResult;
 }
\ No newline at end of file
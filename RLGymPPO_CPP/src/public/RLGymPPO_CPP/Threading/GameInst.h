@@ -2,6 +2,7 @@
 #include "../Lists.h"
 #include "../Util/AvgTracker.h"
 #include "../Util/Report.h"
+#include "../Util/MetricRegistry.h"
 
 namespace RLGPC {
 	typedef std::function<void(class GameInst*, const RLGSC::Gym::StepResult&, Report&)> StepCallback;
@@ -18,6 +19,7 @@ namespace RLGPC {
 		RLGSC::Gym* gym;
 		RLGSC::Match* match;
 
+		// NOTE: Will be empty if the gym has an OBS output set (see Gym::SetOBSOutput())
 		FList2 curObs;
 
 		uint64_t totalSteps;
@@ -27,10 +29,18 @@ namespace RLGPC {
 		AvgTracker avgStepRew, avgEpRew, avgEpLen;
 
 		// Will be reset every iteration, when ResetMetrics() is called
+		// NOTE: Reading these requires stopping the game, prefer registered metrics
 		Report _metrics = {};
 
+		// Metrics registered with MetricRegistry, also reset every iteration
+		GameMetrics metrics = {};
+
 		StepCallback stepCallback = NULL;
 
+		// Predicted ball states of the LearnerConfig::ballPredTicks ticks after the last step, NULL if not predicting
+		// NOTE: Updated once the step is done, so rewards and step callbacks see the prediction from the step before
+		const BallState* ballPred = NULL;
+
 		// NOTE: Gym and match will be deleted when GameInst is deleted
 		GameInst(RLGSC::Gym* gym, RLGSC::Match* match) : gym(gym), match(match) {
 			totalSteps = 0;
@@ -42,10 +52,36 @@ namespace RLGPC {
 			avgStepRew.Reset();
 			avgEpRew.Reset();
 			_metrics.Clear();
+			metrics.Reset();
+			gym->arena->profile = {};
+			gym->simTime = 0;
+			gym->obsBuildTime = 0;
+			gym->terminalTime = 0;
+			gym->rewardTime = 0;
+			gym->resetTime = 0;
+			gym->resets = 0;
 		}
 
+		// Result of the last step, reused every step
+		// With an OBS output set, its observations are empty and stepping doesn't allocate (see Gym::StepInto())
+		RLGSC::Gym::StepResult lastStepResult = {};
+
 		void Start();
-		RLGSC::Gym::StepResult Step(const IList& actions);
+
+		// NOTE: The result is only valid until the next step
+		const RLGSC::Gym::StepResult& Step(const IList& actions);
+
+		// Steps with the action index of each player ([playerAmount]), without copying them into a list
+		const RLGSC::Gym::StepResult& Step(const int64_t* actions);
+
+		// Step() with action indices in two stages, see Gym::StepArena()
+		// FinishStep() also updates metrics and resets if done, like Step()
+		// NOTE: Needs an OBS output set
+		void StepArena(const int64_t* actions);
+		const RLGSC::Gym::StepResult& FinishStep();
+
+		// Updates metrics and the current OBS after stepping, resets if done
+		void _OnStepped(RLGSC::Gym::StepResult& stepResult);
 
 		~GameInst() {
 			delete gym;
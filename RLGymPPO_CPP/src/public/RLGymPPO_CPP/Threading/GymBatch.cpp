@@ -0,0 +1,88 @@
+#include "GymBatch.h"
+
+void RLGPC::GymBatch::Add(GameInst* game) {
+	games.push_back(game);
+	totalPlayers += game->match->playerAmount;
+	playerStart.push_back(totalPlayers);
+	state.AddArena(game->match->GetCarAmount());
+
+	// Our state is set from the game's states every step
+	game->match->AddExtraStateFields(RLGSC::StateFields::SOA);
+}
+
+void RLGPC::GymBatch::SetOBSOutput(float* output, int obsSize) {
+	for (int i = 0; i < games.size(); i++)
+		games[i]->gym->SetOBSOutput(output + (size_t)playerStart[i] * obsSize, obsSize);
+}
+
+void RLGPC::GymBatch::Start() {
+	for (int i = 0; i < games.size(); i++) {
+		games[i]->Start();
+		state.SetArena(i, games[i]->gym->prevState);
+	}
+}
+
+void RLGPC::GymBatch::Step(int gameStart, int gameEnd, const int64_t* actions, float* outRewards, float* outDones) {
+	auto fnFinishGame = [&](int i, const RLGSC::Gym::StepResult& stepResult) {
+		int playerOffset = playerStart[i];
+		for (int j = 0; j < games[i]->match->playerAmount; j++) {
+			outRewards[playerOffset + j] = stepResult.reward[j];
+			outDones[playerOffset + j] = (float)stepResult.done;
+		}
+
+		// After a reset, this is the new episode's first state
+		state.SetArena(i, games[i]->gym->prevState);
+	};
+
+	if (executor) {
+		// Stage 0 is physics, stage 1 is observations, terminals, rewards and resets
+		executor->Run(gameEnd - gameStart, 2,
+			[&](int index, int stage) {
+				int i = gameStart + index;
+				if (stage == 0) {
+					games[i]->StepArena(actions + (playerStart[i] - playerStart[gameStart]));
+				} else {
+					fnFinishGame(i, games[i]->FinishStep());
+				}
+			}
+		);
+	} else if (interleaveArenas) {
+		_stepGyms.clear();
+		_stepActions.clear();
+		for (int i = gameStart; i < gameEnd; i++) {
+			if (!games[i]->gym->obsOutput)
+				RG_ERR_CLOSE("GymBatch::Step(): Interleaving arenas needs an OBS output");
+
+			_stepGyms.push_back(games[i]->gym);
+			_stepActions.push_back(actions + (playerStart[i] - playerStart[gameStart]));
+		}
+
+		RLGSC::Gym::StepArenas(_stepGyms.data(), _stepGyms.size(), _stepActions.data());
+		for (int i = gameStart; i < gameEnd; i++)
+			fnFinishGame(i, games[i]->FinishStep());
+	} else {
+		const int64_t* gameActions = actions;
+		for (int i = gameStart; i < gameEnd; i++) {
+			fnFinishGame(i, games[i]->Step(gameActions));
+			gameActions += games[i]->match->playerAmount;
+		}
+	}
+
+	if (stepCallback) {
+		BatchStepInfo info = {
+			this,
+			gameStart, gameEnd,
+			playerStart[gameStart], playerStart[gameEnd],
+			state,
+			outRewards, outDones,
+			metrics
+		};
+		stepCallback(info);
+	}
+}
+
+void RLGPC::GymBatch::ResetMetrics() {
+	for (auto game : games)
+		game->ResetMetrics();
+	metrics.Reset();
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+#include "GameInst.h"
+#include "StepGraphExecutor.h"
+#include <RLGymSim_CPP/Utils/Gamestates/StateSoA.h>
+
+namespace RLGPC {
+	// One step of some of the games of a GymBatch, given to its BatchStepCallback
+	struct BatchStepInfo {
+		const class GymBatch* batch;
+
+		// Games [gameStart, gameEnd) were stepped, their players are [playerStart, playerEnd)
+		int gameStart, gameEnd;
+		int playerStart, playerEnd;
+
+		// State of every game of the batch, with the cars of each game in the order of its state's players
+		// Scripted cars are included (see RLGSC::Match::SetScripted()), so use state.arenaCarStart for the cars of a game
+		// NOTE: Games that are done have already reset, so their state is the first of their next episode
+		const RLGSC::StateSoA& state;
+
+		// [batch->totalPlayers], only valid for the players of the stepped games
+		const float* rewards;
+		const float* dones;
+
+		// Registered metrics (see MetricRegistry) of the batch, reported together with those of games
+		GameMetrics& metrics;
+	};
+
+	// Called once per step of a batch of games, instead of once per game like StepCallback
+	// Lets metrics of all games be computed in tight loops over structure-of-arrays state
+	// WARNING: Called from every agent thread, often simultaneously, only access the info and its metrics
+	typedef std::function<void(const BatchStepInfo& info)> BatchStepCallback;
+
+	// A batch of games that are stepped together, owned by one agent
+	// Observations, rewards and dones of all players are laid out together, in the order of the games
+	// The state of every game is also kept in structure-of-arrays form, for batched passes over all arenas
+	class RG_IMEXPORT GymBatch {
+	public:
+		std::vector<GameInst*> games = {};
+
+		// Index of the first player of each game, with the total amount of players at the end
+		IList playerStart = { 0 };
+		int totalPlayers = 0;
+
+		// State of all games, updated whenever they start or step
+		RLGSC::StateSoA state = {};
+
+		// Metrics added by stepCallback, each batch is only stepped by one thread, so this is a thread-local accumulator
+		GameMetrics metrics = {};
+
+		// Called at the end of Step(), see BatchStepCallback
+		BatchStepCallback stepCallback = NULL;
+
+		// If set, Step() runs the physics and the rest of each game's step as tasks on this, instead of one game after another
+		// Every game then needs an OBS output (see SetOBSOutput()), and must not share anything with the others that stepping touches
+		// NOTE: Not owned by us
+		StepGraphExecutor* executor = NULL;
+
+		// If set (and we have no executor), Step() steps the arenas of all games together one tick phase at a time (see RLGSC::Gym::StepArenas())
+		// Results are identical, every game then needs an OBS output (see SetOBSOutput())
+		bool interleaveArenas = false;
+
+		GymBatch() = default;
+		RG_NO_COPY(GymBatch);
+
+		// The game is deleted with the batch
+		void Add(GameInst* game);
+
+		int Size() const {
+			return games.size();
+		}
+
+		// Games write their observations into output ([totalPlayers][obsSize])
+		void SetOBSOutput(float* output, int obsSize);
+
+		void Start();
+
+		// Steps games [gameStart, gameEnd) with the actions of their players, which start at the first player of gameStart
+		// Rewards and dones are written at the index of each player in the batch
+		// stepCallback is then called with all of the stepped games
+		void Step(int gameStart, int gameEnd, const int64_t* actions, float* outRewards, float* outDones);
+
+		void ResetMetrics();
+
+		// Reused by Step() with interleaveArenas
+		std::vector<RLGSC::Gym*> _stepGyms = {};
+		std::vector<const int64_t*> _stepActions = {};
+
+		~GymBatch() {
+			for (auto game : games)
+				delete game;
+		}
+	};
+}
\ No newline at end of file
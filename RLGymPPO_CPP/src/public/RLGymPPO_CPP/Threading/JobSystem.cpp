@@ -0,0 +1,92 @@
+#include "JobSystem.h"
+
+#include <RLGymSim_CPP/../../RocketSim/libsrc/bullet3-3.24/LinearMath/btThreads.h>
+
+// Chunks each thread gets at most, so that threads that finish early have something to steal
+constexpr int CHUNKS_PER_THREAD = 4;
+
+// Runs Bullet's parallel loops on a job system
+class _BulletJobScheduler : public btITaskScheduler {
+public:
+	RLGPC::JobSystem* jobs;
+
+	_BulletJobScheduler(RLGPC::JobSystem* jobs) : btITaskScheduler("RLGymPPO_CPP"), jobs(jobs) {}
+
+	int getMaxNumThreads() const override {
+		return jobs->GetNumThreads();
+	}
+
+	int getNumThreads() const override {
+		return jobs->GetNumThreads();
+	}
+
+	// Our thread count is fixed
+	void setNumThreads(int numThreads) override {}
+
+	void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override {
+		jobs->ParallelFor(iBegin, iEnd, grainSize,
+			[&](int64_t start, int64_t end) {
+				body.forLoop((int)start, (int)end);
+			}
+		);
+	}
+
+	btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override {
+		std::mutex sumMutex = {};
+		btScalar sum = 0;
+		jobs->ParallelFor(iBegin, iEnd, grainSize,
+			[&](int64_t start, int64_t end) {
+				btScalar rangeSum = body.sumLoop((int)start, (int)end);
+				std::lock_guard<std::mutex> lock(sumMutex);
+				sum += rangeSum;
+			}
+		);
+		return sum;
+	}
+};
+
+RLGPC::JobSystem::JobSystem(int numWorkers, WorkerInitFn workerInitFn) : _executor(numWorkers, workerInitFn) {}
+
+RLGPC::JobSystem::~JobSystem() {
+	if (_bulletScheduler) {
+		if (btGetTaskScheduler() == _bulletScheduler)
+			btSetTaskScheduler(NULL);
+		delete _bulletScheduler;
+	}
+}
+
+void RLGPC::JobSystem::ParallelFor(int64_t begin, int64_t end, int64_t grainSize, const std::function<void(int64_t start, int64_t end)>& fn) {
+	if (begin >= end)
+		return;
+
+	int64_t count = end - begin;
+	int64_t numChunks = RS_MIN(count / RS_MAX(grainSize, 1), (int64_t)GetNumThreads() * CHUNKS_PER_THREAD);
+
+	bool expected = false;
+	if (numChunks < 2 || !_busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+		if (numChunks >= 2)
+			inlineJobs.fetch_add(1, std::memory_order_relaxed);
+		totalJobs.fetch_add(1, std::memory_order_relaxed);
+		fn(begin, end);
+		return;
+	}
+
+	_executor.Run((int)numChunks, 1,
+		[&](int chunk, int stage) {
+			fn(begin + count * chunk / numChunks, begin + count * (chunk + 1) / numChunks);
+		}
+	);
+
+	totalJobs.fetch_add(1, std::memory_order_relaxed);
+	_busy.store(false, std::memory_order_release);
+}
+
+bool RLGPC::JobSystem::InstallBulletScheduler() {
+	if (btGetTaskScheduler())
+		return btGetTaskScheduler() == _bulletScheduler;
+
+	if (!_bulletScheduler)
+		_bulletScheduler = new _BulletJobScheduler(this);
+	btSetTaskScheduler(_bulletScheduler);
+	return btGetTaskScheduler() == _bulletScheduler;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "StepGraphExecutor.h"
+
+namespace RLGPC {
+	// A fixed set of worker threads, shared by the learner's parallel work (GAE, concatenating trajectories, gathering batches, OBS stats) and Bullet's task scheduler
+	// Work is split into chunks which are spread across the threads' queues and stolen between them (see StepGraphExecutor)
+	// Only one job runs at a time, a ParallelFor() called while another is running (from another thread, or from inside a job) runs on its caller instead
+	//	This way, parallel work never uses more threads than the workers and its callers, however many users start it at once
+	class RG_IMEXPORT JobSystem {
+	public:
+		// Called on each worker thread when it starts, with the worker's index (e.g. to set its torch thread count)
+		typedef StepGraphExecutor::HelperInitFn WorkerInitFn;
+
+		// numWorkers doesn't include the thread that calls ParallelFor(), which also runs chunks
+		JobSystem(int numWorkers, WorkerInitFn workerInitFn = NULL);
+		~JobSystem();
+
+		RG_NO_COPY(JobSystem);
+
+		int GetNumThreads() const {
+			return _executor.GetNumThreads();
+		}
+
+		// Calls fn(start, end) on ranges that together cover [begin, end), returns once all calls are done
+		// Ranges are at least grainSize long (except the last), and there are a few per thread so that threads which finish early can steal
+		// NOTE: fn must not throw
+		void ParallelFor(int64_t begin, int64_t end, int64_t grainSize, const std::function<void(int64_t start, int64_t end)>& fn);
+
+		// Runs ParallelFor() on jobs if set, otherwise calls fn(begin, end) on this thread
+		static void ParallelFor(JobSystem* jobs, int64_t begin, int64_t end, int64_t grainSize, const std::function<void(int64_t start, int64_t end)>& fn) {
+			if (jobs) {
+				jobs->ParallelFor(begin, end, grainSize, fn);
+			} else if (begin < end) {
+				fn(begin, end);
+			}
+		}
+
+		// Makes Bullet's btParallelFor() and btParallelSum() run on us, until we are destroyed
+		// Bullet has one task scheduler per process, so this returns false if another is already set
+		bool InstallBulletScheduler();
+
+		// Jobs run, and jobs that ran on their caller because another was already running, since these were last reset
+		std::atomic<uint64_t> totalJobs = 0, inlineJobs = 0;
+
+		StepGraphExecutor _executor;
+		std::atomic<bool> _busy = false;
+		class btITaskScheduler* _bulletScheduler = NULL;
+	};
+}
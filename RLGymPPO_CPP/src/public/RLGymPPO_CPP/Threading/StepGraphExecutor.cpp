@@ -0,0 +1,163 @@
+#include "StepGraphExecutor.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RG_SPIN_PAUSE() _mm_pause()
+#else
+#define RG_SPIN_PAUSE() {}
+#endif
+
+// How many times helpers check for a new job before sleeping
+constexpr int HELPER_SPIN_AMOUNT = 2000;
+
+// How many times a thread with nothing to do checks for tasks before yielding, in case there are more threads than cores
+constexpr int IDLE_SPIN_AMOUNT = 200;
+
+RLGPC::StepGraphExecutor::StepGraphExecutor(int numHelpers, HelperInitFn helperInitFn) {
+	if (numHelpers < 0)
+		RG_ERR_CLOSE("StepGraphExecutor::StepGraphExecutor(): Invalid helper count (" << numHelpers << ")");
+
+	for (int i = 0; i < numHelpers + 1; i++)
+		_queues.push_back(new TaskQueue());
+
+	for (int i = 0; i < numHelpers; i++)
+		_helpers.push_back(std::thread([this, i, helperInitFn] { _HelperFunc(i, helperInitFn); }));
+}
+
+RLGPC::StepGraphExecutor::~StepGraphExecutor() {
+	_shouldStop = true;
+	_jobCounter++;
+	_jobCounter.notify_all();
+
+	for (std::thread& helper : _helpers)
+		helper.join();
+
+	for (TaskQueue* queue : _queues)
+		delete queue;
+}
+
+void RLGPC::StepGraphExecutor::Run(int amount, int numStages, const std::function<void(int, int)>& fn) {
+	if (_helpers.empty() || amount < 2) {
+		for (int i = 0; i < amount; i++)
+			for (int stage = 0; stage < numStages; stage++)
+				fn(i, stage);
+		totalTasks += (uint64_t)amount * numStages;
+		return;
+	}
+
+	// Each thread starts with a contiguous range of indices, so games that are next to each other in memory stay on the same thread unless stolen
+	int numThreads = GetNumThreads();
+	for (int i = 0; i < numThreads; i++) {
+		TaskQueue* queue = _queues[i];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->tasks.clear();
+		for (int j = (int64_t)amount * i / numThreads; j < (int64_t)amount * (i + 1) / numThreads; j++)
+			queue->tasks.push_back({ j, 0 });
+	}
+
+	_fn = &fn;
+	_numStages = numStages;
+	_remainingTasks.store(amount * numStages, std::memory_order_relaxed);
+	_busyHelpers.store(_helpers.size(), std::memory_order_relaxed);
+
+	// Publishes the job above
+	_jobCounter++;
+	if (_sleepingHelpers.load() > 0)
+		_jobCounter.notify_all();
+
+	_DoWork(numThreads - 1);
+
+	for (int i = 0; _busyHelpers.load(std::memory_order_acquire) > 0; i++) {
+		if (i < IDLE_SPIN_AMOUNT) {
+			RG_SPIN_PAUSE();
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool RLGPC::StepGraphExecutor::_PopTask(int threadIndex, Task& outTask) {
+	{ // Our own queue, from the front
+		TaskQueue* queue = _queues[threadIndex];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (!queue->tasks.empty()) {
+			outTask = queue->tasks.front();
+			queue->tasks.pop_front();
+			return true;
+		}
+	}
+
+	// Steal from the back of the others, starting with our neighbor so that thieves spread out
+	int numThreads = GetNumThreads();
+	for (int i = 1; i < numThreads; i++) {
+		TaskQueue* queue = _queues[(threadIndex + i) % numThreads];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (!queue->tasks.empty()) {
+			outTask = queue->tasks.back();
+			queue->tasks.pop_back();
+			stolenTasks.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void RLGPC::StepGraphExecutor::_DoWork(int threadIndex) {
+	TaskQueue* ownQueue = _queues[threadIndex];
+	uint64_t tasksRun = 0;
+
+	int idleSpins = 0;
+	while (_remainingTasks.load(std::memory_order_acquire) > 0) {
+		Task task;
+		if (!_PopTask(threadIndex, task)) {
+			// Every task left is running, or is the next stage of one that is
+			if (idleSpins++ < IDLE_SPIN_AMOUNT) {
+				RG_SPIN_PAUSE();
+			} else {
+				std::this_thread::yield();
+			}
+			continue;
+		}
+		idleSpins = 0;
+
+		(*_fn)(task.index, task.stage);
+		tasksRun++;
+
+		// The next stage goes to the front of our queue, so we run it next while the game's memory is still in our cache
+		if (task.stage + 1 < _numStages) {
+			std::lock_guard<std::mutex> lock(ownQueue->mutex);
+			ownQueue->tasks.push_front({ task.index, task.stage + 1 });
+		}
+
+		_remainingTasks.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	totalTasks.fetch_add(tasksRun, std::memory_order_relaxed);
+}
+
+void RLGPC::StepGraphExecutor::_HelperFunc(int helperIndex, HelperInitFn helperInitFn) {
+	if (helperInitFn)
+		helperInitFn(helperIndex);
+
+	uint32_t lastJob = 0;
+	while (true) {
+		uint32_t job;
+		for (int i = 0; (job = _jobCounter.load(std::memory_order_acquire)) == lastJob; i++) {
+			if (i < HELPER_SPIN_AMOUNT) {
+				RG_SPIN_PAUSE();
+			} else {
+				_sleepingHelpers++;
+				_jobCounter.wait(lastJob);
+				_sleepingHelpers--;
+			}
+		}
+		lastJob = job;
+
+		if (_shouldStop)
+			return;
+
+		_DoWork(helperIndex);
+		_busyHelpers.fetch_sub(1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "../Lists.h"
+#include <atomic>
+#include <deque>
+
+namespace RLGPC {
+	// Runs the steps of a batch of games as a small task graph, on the thread calling Run() and some helper threads
+	// Each game's step is a chain of stages (e.g. physics, then observations and rewards), which run in order
+	// Every thread has its own queue of tasks, and steals from the others once it runs out
+	// This lets physics of some games overlap with observations and rewards of others, without needing more games per thread
+	class RG_IMEXPORT StepGraphExecutor {
+	public:
+		struct Task {
+			int index, stage;
+		};
+
+		struct TaskQueue {
+			std::mutex mutex = {};
+			std::deque<Task> tasks = {};
+		};
+
+		// Called on each helper thread when it starts, with the helper's index (e.g. to pin it to cores)
+		typedef std::function<void(int)> HelperInitFn;
+
+		// numHelpers doesn't include the thread that calls Run()
+		StepGraphExecutor(int numHelpers, HelperInitFn helperInitFn = NULL);
+		~StepGraphExecutor();
+
+		RG_NO_COPY(StepGraphExecutor);
+
+		int GetNumThreads() const {
+			return _helpers.size() + 1;
+		}
+
+		// Calls fn(i, stage) for every i in [0, amount) and stage in [0, numStages), returns once all calls are done
+		// Stage s of i is only called once stage s - 1 of i has returned, different indices have no order
+		// NOTE: fn must not throw
+		void Run(int amount, int numStages, const std::function<void(int, int)>& fn);
+
+		// Tasks run, and tasks run by a thread that stole them from another's queue, since these were last reset
+		std::atomic<uint64_t> totalTasks = 0, stolenTasks = 0;
+
+		std::vector<std::thread> _helpers;
+		std::vector<TaskQueue*> _queues; // One per thread, the thread calling Run() is last
+
+		const std::function<void(int, int)>* _fn = NULL;
+		int _numStages = 0;
+		std::atomic<int> _remainingTasks = 0;
+
+		// Incremented to start each job, helpers wait on this
+		std::atomic<uint32_t> _jobCounter = 0;
+		std::atomic<int> _busyHelpers = 0, _sleepingHelpers = 0;
+		std::atomic<bool> _shouldStop = false;
+
+		bool _PopTask(int threadIndex, Task& outTask);
+		void _DoWork(int threadIndex);
+		void _HelperFunc(int helperIndex, HelperInitFn helperInitFn);
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "../Framework.h"
+
+namespace RLGPC {
+	// Keeps the last windowSize samples of a latency, for percentiles over a rolling window
+	// Samples can be added from any thread
+	struct LatencyTracker {
+		std::vector<float> samples;
+		size_t windowSize, nextIndex = 0;
+		uint64_t totalCount = 0;
+		std::mutex mutex = {};
+
+		struct Summary {
+			uint64_t count; // Samples in the window
+			float p50, p99, max; // In milliseconds
+		};
+
+		LatencyTracker(size_t windowSize = 10 * 1000) : windowSize(windowSize) {
+			samples.reserve(windowSize);
+		}
+
+		RG_NO_COPY(LatencyTracker);
+
+		void Add(double seconds) {
+			std::lock_guard<std::mutex> lock(mutex);
+			float ms = (float)(seconds * 1000);
+			if (samples.size() < windowSize) {
+				samples.push_back(ms);
+			} else {
+				samples[nextIndex] = ms;
+			}
+			nextIndex = (nextIndex + 1) % windowSize;
+			totalCount++;
+		}
+
+		// Adds the time since startTime
+		void AddSince(std::chrono::steady_clock::time_point startTime) {
+			Add(std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+		}
+
+		Summary GetSummary() {
+			std::vector<float> sorted;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				sorted = samples;
+			}
+
+			if (sorted.empty())
+				return { 0, NAN, NAN, NAN };
+
+			auto fnPercentile = [&](float fraction) {
+				size_t index = RS_MIN((size_t)(fraction * sorted.size()), sorted.size() - 1);
+				std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+				return sorted[index];
+			};
+
+			float p50 = fnPercentile(0.5f), p99 = fnPercentile(0.99f);
+			return { sorted.size(), p50, p99, *std::max_element(sorted.begin(), sorted.end()) };
+		}
+	};
+}
\ No newline at end of file
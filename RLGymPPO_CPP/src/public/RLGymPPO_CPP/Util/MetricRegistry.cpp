@@ -0,0 +1,36 @@
+#include "MetricRegistry.h"
+
+#include <deque>
+
+namespace RLGPC {
+	std::mutex _registryMutex = {};
+	std::deque<MetricRegistry::Entry> _registryEntries = {}; // Deque so that references from Get() stay valid
+}
+
+RLGPC::MetricHandle RLGPC::MetricRegistry::Register(const std::string& name, MetricType type) {
+	std::lock_guard<std::mutex> lock(_registryMutex);
+
+	for (size_t i = 0; i < _registryEntries.size(); i++) {
+		if (_registryEntries[i].name == name) {
+			if (_registryEntries[i].type != type)
+				RG_ERR_CLOSE("MetricRegistry::Register(): Metric \"" << name << "\" was already registered with a different type");
+			return i;
+		}
+	}
+
+	if (_registryEntries.size() >= MAX_METRICS)
+		RG_ERR_CLOSE("MetricRegistry::Register(): Cannot register more than " << MAX_METRICS << " metrics (registering \"" << name << "\")");
+
+	_registryEntries.push_back({ name, type });
+	return _registryEntries.size() - 1;
+}
+
+int RLGPC::MetricRegistry::GetCount() {
+	std::lock_guard<std::mutex> lock(_registryMutex);
+	return _registryEntries.size();
+}
+
+const RLGPC::MetricRegistry::Entry& RLGPC::MetricRegistry::Get(MetricHandle handle) {
+	std::lock_guard<std::mutex> lock(_registryMutex);
+	return _registryEntries.at(handle);
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include "Report.h"
+
+namespace RLGPC {
+	typedef int MetricHandle;
+
+	enum class MetricType {
+		COUNTER, // Summed across all games
+		AVG // Averaged across every added value of all games
+	};
+
+	// Game metrics are registered once by name, then added by handle from step callbacks
+	// Registered metrics are added to the iteration report automatically
+	class RG_IMEXPORT MetricRegistry {
+	public:
+		constexpr static int MAX_METRICS = 64;
+
+		struct Entry {
+			std::string name;
+			MetricType type;
+		};
+
+		// Registering the same name again returns the same handle
+		// NOTE: Register metrics before the learner starts, not from step callbacks
+		static MetricHandle Register(const std::string& name, MetricType type);
+
+		static int GetCount();
+		static const Entry& Get(MetricHandle handle);
+	};
+
+	// Registered metrics of a single game
+	// Each game is only ever stepped by one thread, so adding is just a relaxed load and store, with no allocation or locking
+	// Other threads can read the metrics at any time, without stopping the game
+	class GameMetrics {
+	public:
+		struct Slot {
+			std::atomic<double> total = 0;
+			std::atomic<uint64_t> count = 0;
+		};
+		Slot slots[MetricRegistry::MAX_METRICS] = {};
+
+		// Values at the last reset, only used by the reading thread
+		struct {
+			double total;
+			uint64_t count;
+		} resetValues[MetricRegistry::MAX_METRICS] = {};
+
+		GameMetrics() = default;
+		RG_NO_COPY(GameMetrics);
+
+		// NOTE: Only call from the thread that steps this game
+		void Add(MetricHandle handle, double val) {
+			Slot& slot = slots[handle];
+			slot.total.store(slot.total.load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+			slot.count.store(slot.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		// Gets the total and count of a metric since the last reset
+		void GetSinceReset(MetricHandle handle, double& outTotal, uint64_t& outCount) const {
+			outTotal = slots[handle].total.load(std::memory_order_relaxed) - resetValues[handle].total;
+			outCount = slots[handle].count.load(std::memory_order_relaxed) - resetValues[handle].count;
+		}
+
+		// Safe to call while the game is stepping, values added during the reset go to either side of it
+		void Reset() {
+			for (int i = 0; i < MetricRegistry::MAX_METRICS; i++) {
+				resetValues[i].total = slots[i].total.load(std::memory_order_relaxed);
+				resetValues[i].count = slots[i].count.load(std::memory_order_relaxed);
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "Timer.h"
 
+#ifndef RG_NO_PYTHON
+
 namespace py = pybind11;
 using namespace RLGPC;
 
@@ -25,22 +27,87 @@ RLGPC::MetricSender::MetricSender(std::string _projectName, std::string _groupNa
 		RG_ERR_CLOSE("MetricSender: Failed to initialize in Python, exception: " << e.what());
 	}
 
+	// Let our thread take the GIL
+	mainThreadState = PyEval_SaveThread();
+	thread = std::thread(&MetricSender::_Run, this);
+
 	RG_LOG(" > MetricSender initalized.");
 }
 
 void RLGPC::MetricSender::Send(const Report& report) {
-	py::dict reportDict = {};
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!error.empty())
+		RG_ERR_CLOSE("MetricSender: Failed to add metrics, exception: " << error);
 
-	for (auto& pair : report.data)
-		reportDict[pair.first.c_str()] = pair.second;
+	pendingReports.push_back(report);
+	while (pendingReports.size() > maxQueueSize) {
+		pendingReports.pop_front();
+		numDropped++;
+	}
+	cv.notify_all();
+}
 
-	try {
-		pyMod.attr("add_metrics")(reportDict);
-	} catch (std::exception& e) {
-		RG_ERR_CLOSE("MetricSender: Failed to add metrics, exception: " << e.what());
+void RLGPC::MetricSender::GetMetrics(Report& report) {
+	std::lock_guard<std::mutex> lock(mutex);
+	report["Metric Queue Depth"] = pendingReports.size();
+	report["Dropped Metric Reports"] = numDropped;
+}
+
+void RLGPC::MetricSender::_Run() {
+	while (true) {
+		std::list<Report> batch;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [this] { return !pendingReports.empty() || shouldStop; });
+			if (pendingReports.empty())
+				return; // Stopping, and everything was sent
+
+			// Everything that arrived while we were sending the last batch
+			batch.swap(pendingReports);
+		}
+
+		py::gil_scoped_acquire gil;
+		try {
+			py::list reportList = {};
+			for (auto& report : batch) {
+				py::dict reportDict = {};
+				for (auto& pair : report.data)
+					reportDict[pair.first.c_str()] = pair.second;
+				reportList.append(reportDict);
+			}
+
+			pyMod.attr("add_metrics_batch")(reportList);
+		} catch (std::exception& e) {
+			// Thrown on the learner's thread by the next Send()
+			std::lock_guard<std::mutex> lock(mutex);
+			error = e.what();
+			return;
+		}
 	}
 }
 
 RLGPC::MetricSender::~MetricSender() {
-	
-}
\ No newline at end of file
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shouldStop = true;
+		cv.notify_all();
+	}
+	if (thread.joinable())
+		thread.join();
+
+	if (mainThreadState)
+		PyEval_RestoreThread(mainThreadState);
+}
+
+#else
+
+RLGPC::MetricSender::MetricSender(std::string projectName, std::string groupName, std::string runName, std::string runID) {
+	RG_ERR_CLOSE("MetricSender: Sending metrics requires Python, but RLGymPPO_CPP was built with RG_NO_PYTHON");
+}
+
+void RLGPC::MetricSender::Send(const Report& report) {}
+void RLGPC::MetricSender::GetMetrics(Report& report) {}
+void RLGPC::MetricSender::_Run() {}
+RLGPC::MetricSender::~MetricSender() {}
+
+#endif
\ No newline at end of file
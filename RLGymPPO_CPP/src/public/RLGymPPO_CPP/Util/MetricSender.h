@@ -1,19 +1,49 @@
 #pragma once
 #include "Report.h"
+#ifndef RG_NO_PYTHON
 #include <pybind11/pybind11.h>
+#endif
+#include <condition_variable>
 
 namespace RLGPC {
+	// Sends reports to the python metrics receiver from a background thread, so a slow backend never stalls learning
+	// Reports that pile up while the receiver is busy are sent together in one batch
+	// NOTE: The creating thread gives up the GIL until the sender is destroyed, which must be on the same thread
+	// NOTE: Not available when built with RG_NO_PYTHON, use LearnerConfig::metricsFilePath instead
 	struct RG_IMEXPORT MetricSender {
 		std::string curRunID;
 		std::string projectName, groupName, runName;
+#ifndef RG_NO_PYTHON
 		pybind11::module pyMod;
+#endif
+
+		// If more reports than this are waiting to be sent, the oldest are dropped
+		int maxQueueSize = 64;
+
+		std::thread thread;
+		std::mutex mutex = {};
+		std::condition_variable cv = {};
+		std::list<Report> pendingReports = {};
+		uint64_t numDropped = 0;
+		bool shouldStop = false;
+		std::string error = {};
+
+#ifndef RG_NO_PYTHON
+		PyThreadState* mainThreadState = NULL;
+#endif
 
 		MetricSender(std::string projectName = {}, std::string groupName = {}, std::string runName = {}, std::string runID = {});
 		
 		RG_NO_COPY(MetricSender);
 
+		// Queues the report to be sent, never waits on Python
 		void Send(const Report& report);
 
+		void GetMetrics(Report& report);
+
+		void _Run();
+
+		// Sends all reports that are still queued first
 		~MetricSender();
 	};
 }
\ No newline at end of file
@@ -1,27 +1,81 @@
 #include "PolicyInferUnit.h"
 
 #include <RLGymPPO_CPP/PPO/DiscretePolicy.h>
+#include <RLGymPPO_CPP/PPO/NativePolicy.h>
+#include <RLGymPPO_CPP/PPO/ScriptedPolicy.h>
+#include <RLGymPPO_CPP/PPO/QuantizedPolicy.h>
+#include <RLGymPPO_CPP/PPO/PPOLearner.h>
+#include <RLGymPPO_CPP/Util/TorchFuncs.h>
 #include <RLGymPPO_CPP/FrameworkTorch.h>
+#include <RLGymPPO_CPP/Learner.h>
 #include <torch/csrc/api/include/torch/serialize.h>
 
 using namespace RLGSC;
 using namespace RLGPC;
 
+// Standardizes the policy's observations like the learner did, if the checkpoint has OBS stats (see LearnerConfig::standardizeOBS)
+void _LoadOBSStandardization(DiscretePolicy* policy, const std::string& statsJSON) {
+	auto standardization = OBSStandardization::FromStatsJSON(statsJSON, policy->inputAmount);
+	if (!standardization.IsSet())
+		return;
+
+	policy->SetOBSStandardization(standardization);
+	RG_LOG(" > Standardizing observations with the checkpoint's OBS stats");
+}
+
+// Creates a policy and loads it from policyPath, throws if it can't be loaded or is of a different size
+DiscretePolicy* _LoadPolicy(std::filesystem::path policyPath, int obsSize, int actionAmount, const IList& policyLayerSizes, torch::Device device) {
+	auto policy = new DiscretePolicy(obsSize, actionAmount, policyLayerSizes, device);
+
+	try {
+		if (CheckpointFile::IsCheckpointFile(policyPath)) {
+			// Only the policy's weights are read from the mapping, the rest of the checkpoint is never touched
+			CheckpointFile file = CheckpointFile(policyPath);
+
+			// LoadSeqFromFile() would close on a mismatch, but a reload should only be rejected
+			for (auto& param : policy->seq->named_parameters()) {
+				auto entry = file.Find(PPOLearner::POLICY_ENTRY_PREFIX + param.key());
+				if (!entry || entry->type != CheckpointFile::EntryType::FLOAT32 || entry->shape != param.value().sizes().vec())
+					throw std::runtime_error("Saved model has different size than current model (parameter \"" + param.key() + "\")");
+			}
+
+			TorchFuncs::LoadSeqFromFile(policy->seq, file, PPOLearner::POLICY_ENTRY_PREFIX);
+
+			if (auto statsEntry = file.Find(Learner::CHECKPOINT_STATS_ENTRY))
+				_LoadOBSStandardization(policy, std::string((const char*)statsEntry->data, statsEntry->size));
+		} else {
+			auto streamIn = std::ifstream(policyPath, std::ios::binary);
+			torch::load(policy->seq, streamIn, device);
+
+			// The stats file is next to the policy file in checkpoint folders
+			auto statsPath = policyPath.parent_path() / Learner::STATS_FILE_NAME;
+			if (std::filesystem::exists(statsPath)) {
+				std::ifstream statsIn(statsPath);
+				_LoadOBSStandardization(policy, std::string(std::istreambuf_iterator<char>(statsIn), std::istreambuf_iterator<char>()));
+			}
+		}
+	} catch (...) {
+		delete policy;
+		throw;
+	}
+
+	return policy;
+}
+
 RLGPC::PolicyInferUnit::PolicyInferUnit(
 	OBSBuilder* obsBuilder, ActionParser* actionParser, 
-	std::filesystem::path policyPath, int obsSize, const IList& policyLayerSizes, bool gpu)
-	: obsBuilder(obsBuilder), actionParser(actionParser) {
+	std::filesystem::path policyPath, int obsSize, const IList& policyLayerSizes, bool gpu, bool native, bool scripted)
+	: obsBuilder(obsBuilder), actionParser(actionParser), _policyPath(policyPath), _policyLayerSizes(policyLayerSizes), _native(native) {
+
+	if (native)
+		gpu = false;
 
 	RG_LOG("PolicyInferUnit():");
 
-	RG_LOG(" > Creating policy...");
-	torch::Device device = gpu ? torch::kCUDA : torch::kCPU;
-	policy = new DiscretePolicy(obsSize, actionParser->GetActionAmount(), policyLayerSizes, device);
-	
 	RG_LOG(" > Loading policy...");
+	torch::Device device = gpu ? torch::kCUDA : torch::kCPU;
 	try {
-		auto streamIn = std::ifstream(policyPath, std::ios::binary);
-		torch::load(policy->seq, streamIn, device);
+		policy = _LoadPolicy(policyPath, obsSize, actionParser->GetActionAmount(), policyLayerSizes, device);
 	} catch (std::exception& e) {
 		RG_ERR_CLOSE(
 			"Failed to load model, checkpoint may be corrupt or of different model arch.\n" <<
@@ -29,30 +83,211 @@ RLGPC::PolicyInferUnit::PolicyInferUnit(
 		);
 	}
 
+	if (native) {
+		RG_LOG(" > Creating native policy...");
+		nativePolicy = new NativePolicy(policy);
+	} else if (scripted) {
+		RG_LOG(" > Creating scripted policy...");
+		scriptedPolicy = new ScriptedPolicy(policy);
+	}
+
 	RG_LOG(" > Done!");
 }
 
-ActionSet RLGPC::PolicyInferUnit::InferPolicyAll(const GameState& state, const ActionSet& prevActions, bool deterministic) {
-	FList2 obsSet = {};
-	for (int i = 0; i < state.players.size(); i++)
-		obsSet.push_back(obsBuilder->BuildOBS(state.players[i], state, prevActions[i]));
-	
+RLGPC::PolicyInferUnit::PolicyInferUnit(OBSBuilder* obsBuilder, ActionParser* actionParser, std::filesystem::path quantPolicyPath)
+	: obsBuilder(obsBuilder), actionParser(actionParser), policy(NULL) {
+
+	RG_LOG("PolicyInferUnit():");
+	RG_LOG(" > Loading quantized policy...");
+	quantPolicy = new QuantizedPolicy(quantPolicyPath);
+
+	if (quantPolicy->actionAmount != actionParser->GetActionAmount())
+		RG_ERR_CLOSE("PolicyInferUnit(): Quantized policy has " << quantPolicy->actionAmount << " actions, but the action parser has " << actionParser->GetActionAmount());
+
+	RG_LOG(" > Done!");
+}
+
+float RLGPC::PolicyInferUnit::ExportQuantized(std::filesystem::path outPath, PolicyQuantType type, const FList2& checkObs) {
+	if (!policy)
+		RG_ERR_CLOSE("PolicyInferUnit::ExportQuantized(): No full-precision policy to export");
+
+	for (size_t i = 0; i < checkObs.size(); i++)
+		if (checkObs[i].size() != policy->inputAmount)
+			RG_ERR_CLOSE("PolicyInferUnit::ExportQuantized(): Check observation " << i << " has size " << checkObs[i].size() << ", but the policy's input size is " << policy->inputAmount);
+
+	RG_LOG("Exporting quantized policy to " << outPath << "...");
+	NativePolicy fullPolicy = NativePolicy(policy);
+	QuantizedPolicy quantizedPolicy = QuantizedPolicy(fullPolicy, type);
+	quantizedPolicy.Save(outPath);
+
+	FList checkObsData = {};
+	for (auto& obs : checkObs)
+		checkObsData.insert(checkObsData.end(), obs.begin(), obs.end());
+
+	float agreement = quantizedPolicy.GetActionAgreement(fullPolicy, checkObsData.data(), checkObs.size());
+	RG_LOG(" > Action agreement with full-precision policy: " << (agreement * 100) << "% (" << checkObs.size() << " observations)");
+	return agreement;
+}
+
+// The newest policy file in a learner's checkpoint folder, or watchPath itself if it's a file
+std::filesystem::path _FindNewestPolicy(const std::filesystem::path& watchPath) {
+	std::error_code ec;
+	if (!std::filesystem::is_directory(watchPath, ec))
+		return watchPath;
+
+	// Same as Learner::Load(), checkpoints are only renamed to their number once fully written
+	int64_t highest = -1;
+	for (auto& entry : std::filesystem::directory_iterator(watchPath, ec)) {
+		if (entry.is_directory()) {
+			try {
+				highest = RS_MAX(std::stoll(entry.path().filename().string()), highest);
+			} catch (...) {}
+		}
+	}
+
+	if (highest == -1)
+		return {};
+
+	std::filesystem::path folder = watchPath / std::to_string(highest);
+	if (std::filesystem::exists(folder / Learner::CHECKPOINT_FILE_NAME))
+		return folder / Learner::CHECKPOINT_FILE_NAME;
+	return folder / PPOLearner::POLICY_FILE_NAME;
+}
+
+void RLGPC::PolicyInferUnit::StartHotReload(std::filesystem::path watchPath, float checkInterval) {
+	if (!policy)
+		RG_ERR_CLOSE("PolicyInferUnit::StartHotReload(): Quantized policies cannot be hot-reloaded");
+
+	StopHotReload();
+	_reloadRunning = true;
+
+	RG_LOG("PolicyInferUnit: Watching " << watchPath << " for new checkpoints");
+	_reloadThread = std::thread([this, watchPath, checkInterval] {
+		std::error_code ec;
+		std::filesystem::path loadedPath = _policyPath;
+		auto loadedWriteTime = std::filesystem::last_write_time(loadedPath, ec);
+
+		int obsSize = policy->inputAmount;
+		torch::Device device = policy->device;
+
+		std::unique_lock<std::mutex> lock(_reloadMutex);
+		while (!_reloadCV.wait_for(lock, std::chrono::milliseconds((int64_t)(checkInterval * 1000)), [this] { return !_reloadRunning; })) {
+			lock.unlock();
+
+			std::filesystem::path newestPath = _FindNewestPolicy(watchPath);
+			auto writeTime = std::filesystem::last_write_time(newestPath, ec);
+			bool isNew = !newestPath.empty() && !ec && 
+				!(writeTime == loadedWriteTime && (newestPath == loadedPath || std::filesystem::equivalent(newestPath, loadedPath, ec)));
+
+			if (isNew) {
+				// Whether or not it loads, we don't retry the same file until it changes again
+				loadedPath = newestPath;
+				loadedWriteTime = writeTime;
+
+				RG_LOG("PolicyInferUnit: Reloading policy from " << newestPath << "...");
+				try {
+					DiscretePolicy* newPolicy = _LoadPolicy(newestPath, obsSize, actionParser->GetActionAmount(), _policyLayerSizes, device);
+					NativePolicy* newNativePolicy = _native ? new NativePolicy(newPolicy) : NULL;
+
+					if (!newNativePolicy) {
+						// Run it once here, so its first inference after the swap isn't slower than usual
+						RG_NOGRAD;
+						newPolicy->GetAction(torch::zeros({ 1, obsSize }, device), true);
+					}
+
+					std::lock_guard<std::mutex> swapLock(_reloadMutex);
+
+					// Replaces a policy we loaded before that was never swapped in
+					delete _reloadedPolicy;
+					delete _reloadedNativePolicy;
+					_reloadedPolicy = newPolicy;
+					_reloadedNativePolicy = newNativePolicy;
+					_hasReloaded = true;
+					RG_LOG(" > Done, it will be used from our next inference");
+				} catch (std::exception& e) {
+					RG_LOG(" > Failed to load, keeping the current policy (" << e.what() << ")");
+				}
+			}
+
+			lock.lock();
+		}
+	});
+}
+
+void RLGPC::PolicyInferUnit::StopHotReload() {
+	{
+		std::lock_guard<std::mutex> lock(_reloadMutex);
+		_reloadRunning = false;
+	}
+	_reloadCV.notify_all();
+
+	if (_reloadThread.joinable())
+		_reloadThread.join();
+}
+
+void RLGPC::PolicyInferUnit::_SwapReloaded() {
+	std::lock_guard<std::mutex> lock(_reloadMutex);
+	if (!_reloadedPolicy)
+		return;
+
+	delete policy;
+	delete nativePolicy;
+	policy = _reloadedPolicy;
+	nativePolicy = _reloadedNativePolicy;
+
+	// Same architecture, so its weights are just copied into our graph
+	if (scriptedPolicy)
+		scriptedPolicy->Load(policy);
+
+	_reloadedPolicy = NULL;
+	_reloadedNativePolicy = NULL;
+	_hasReloaded = false;
+}
+
+RLGPC::PolicyInferUnit::~PolicyInferUnit() {
+	StopHotReload();
+}
+
+void RLGPC::PolicyInferUnit::InferActions(const float* obsData, int amount, int64_t* outActions, bool deterministic) {
+	if (_hasReloaded)
+		_SwapReloaded();
+
+	if (nativePolicy || quantPolicy) {
+		FList logProbs = FList(amount);
+		if (quantPolicy) {
+			quantPolicy->Infer(obsData, amount, outActions, logProbs.data(), deterministic, nativeRNG);
+		} else {
+			nativePolicy->Infer(obsData, amount, outActions, logProbs.data(), deterministic, nativeRNG);
+		}
+		return;
+	}
+
 	RG_NOGRAD;
-	torch::Tensor inputTen = FLIST2_TO_TENSOR(obsSet).to(policy->device);
-	auto actionResult = policy->GetAction(inputTen, deterministic);
-	auto actionParserInput = TENSOR_TO_ILIST(actionResult.action);
+	torch::Tensor inputTen = torch::from_blob((void*)obsData, { amount, policy->inputAmount }, torch::kFloat).to(policy->device);
+	auto actionResult = scriptedPolicy ? scriptedPolicy->GetAction(inputTen, deterministic) : policy->GetAction(inputTen, deterministic);
+	torch::Tensor actions = actionResult.action.cpu().to(torch::kInt64).contiguous();
+	memcpy(outActions, actions.data_ptr<int64_t>(), amount * sizeof(int64_t));
+}
+
+ActionSet RLGPC::PolicyInferUnit::InferPolicyAll(const GameState& state, const ActionSet& prevActions, bool deterministic) {
+	obsBuilder->PreStep(state);
 
-	return actionParser->ParseActions(actionParserInput, state);
+	FList obsData = {};
+	for (int i = 0; i < state.players.size(); i++) {
+		FList obs = obsBuilder->BuildOBS(state.players[i], state, prevActions[i]);
+		obsData.insert(obsData.end(), obs.begin(), obs.end());
+	}
+
+	std::vector<int64_t> actions = std::vector<int64_t>(state.players.size());
+	InferActions(obsData.data(), actions.size(), actions.data(), deterministic);
+	return actionParser->ParseActions(IList(actions.begin(), actions.end()), state);
 }
 
 Action RLGPC::PolicyInferUnit::InferPolicySingle(const PlayerData& player, const GameState& state, const Action& prevAction, bool deterministic) {
+	obsBuilder->PreStep(state);
 	FList obs = obsBuilder->BuildOBS(player, state, prevAction);
 
-	RG_NOGRAD;
-	torch::Tensor inputTen = torch::tensor(obs).to(policy->device);
-	auto actionResult = policy->GetAction(inputTen, deterministic);
-	IList actionParserInput = {};
-	actionParserInput.push_back(actionResult.action.item<int>());
-
-	return actionParser->ParseActions(actionParserInput, state)[0];
+	int64_t action;
+	InferActions(obs.data(), 1, &action, deterministic);
+	return actionParser->ParseActions({ (int)action }, state)[0];
 }
\ No newline at end of file
@@ -2,8 +2,14 @@
 #include "../Lists.h"
 #include "../Threading/GameInst.h"
 #include "../LearnerConfig.h"
+#include <condition_variable>
 
 namespace RLGPC {
+	enum class PolicyQuantType : uint8_t {
+		INT8, // Per-channel int8 weights, integer math
+		BF16  // bfloat16 weights, float math
+	};
+
 	class RG_IMEXPORT PolicyInferUnit {
 	public:
 
@@ -11,10 +17,61 @@ namespace RLGPC {
 		RLGSC::ActionParser* actionParser;
 		class DiscretePolicy* policy;
 
+		// If set, we infer with native CPU kernels instead of torch (see LearnerConfig::nativeInference)
+		class NativePolicy* nativePolicy = NULL;
+		std::mt19937 nativeRNG = std::mt19937(std::random_device()());
+
+		// If set, we infer a frozen TorchScript graph of the policy (see LearnerConfig::scriptedInference)
+		class ScriptedPolicy* scriptedPolicy = NULL;
+
+		// policyPath can be a policy file from a checkpoint folder, or a single-file checkpoint (see LearnerConfig::singleFileCheckpoints)
+		// If native, inference is done on the CPU with our own kernels, and gpu is ignored
+		// If scripted (and not native), inference is done with a frozen TorchScript graph, hot reloads copy their weights into it
 		PolicyInferUnit(
 			RLGSC::OBSBuilder* obsBuilder, RLGSC::ActionParser* actionParser, 
-			std::filesystem::path policyPath, int obsSize, const RLGPC::IList& policyLayerSizes, bool gpu);
+			std::filesystem::path policyPath, int obsSize, const RLGPC::IList& policyLayerSizes, bool gpu, bool native = false, bool scripted = false);
+
+		// If set, we infer with a quantized policy exported by ExportQuantized()
+		class QuantizedPolicy* quantPolicy = NULL;
+
+		// Loads a quantized policy file, does not use torch
+		PolicyInferUnit(RLGSC::OBSBuilder* obsBuilder, RLGSC::ActionParser* actionParser, std::filesystem::path quantPolicyPath);
+
+		// Exports a quantized version of our policy to outPath, which can then be loaded with PolicyInferUnit(..., quantPolicyPath)
+		// checkObs should be a set of recorded observations, each the size of our policy's input, it is used to check how often the quantized policy chooses the same action
+		// Returns the fraction of checkObs where the actions agreed
+		float ExportQuantized(std::filesystem::path outPath, PolicyQuantType type, const RLGPC::FList2& checkObs);
+
+		// Watches for new checkpoints, loads them in the background, and swaps them in at the start of our next inference
+		// watchPath can be a policy path like in our constructor, which is reloaded whenever the file changes,
+		//	or a learner's checkpoint folder (see LearnerConfig::checkpointSaveFolder), where the newest checkpoint is loaded whenever a new one is saved
+		// Checkpoints of a different size than our policy are ignored
+		void StartHotReload(std::filesystem::path watchPath, float checkInterval = 5);
+		void StopHotReload();
+
+		std::filesystem::path _policyPath;
+		IList _policyLayerSizes;
+		bool _native = false;
+
+		std::thread _reloadThread;
+		bool _reloadRunning = false;
+		std::mutex _reloadMutex = {};
+		std::condition_variable _reloadCV = {};
+
+		// Loaded by the reload thread, waiting to be swapped in
+		class DiscretePolicy* _reloadedPolicy = NULL;
+		class NativePolicy* _reloadedNativePolicy = NULL;
+		std::atomic<bool> _hasReloaded = false;
+
+		void _SwapReloaded();
+
+		~PolicyInferUnit();
+
+		// Infers the action index of each of amount observations ([amount][obsSize]), for the action parser
+		// NOTE: Not thread-safe, even with many states, as our models and OBS builder are shared
+		void InferActions(const float* obsData, int amount, int64_t* outActions, bool deterministic);
 
+		// These call obsBuilder->PreStep() with the state first
 		RLGSC::ActionSet InferPolicyAll(const RLGSC::GameState& state, const RLGSC::ActionSet& prevActions, bool deterministic);
 		RLGSC::Action InferPolicySingle(const RLGSC::PlayerData& player, const RLGSC::GameState& state, const RLGSC::Action& prevAction, bool deterministic);
 	};
@@ -1,101 +1,131 @@
 #include "RenderSender.h"
 
-#include "../../libsrc/json/nlohmann/json.hpp"
+#include <RLGymPPO_CPP/Util/UDPSocket.h>
 
-namespace py = pybind11;
-using namespace nlohmann;
 using namespace RLGSC;
 
-RLGPC::RenderSender::RenderSender() {
+RLGPC::RenderSender::RenderSender(const std::string& address, int port) : address(address), port(port) {
 	RG_LOG("Initializing RenderSender...");
 
-	try {
-		RG_LOG("Current dir: " << std::filesystem::current_path());
-		pyMod = py::module::import("python_scripts.render_receiver");
-	} catch (std::exception& e) {
-		RG_ERR_CLOSE("RenderSender: Failed to import render receiver, exception: " << e.what());
-	}
+	_socket = new UDPSocket();
+	if (!_socket->Open(address, port))
+		RG_ERR_CLOSE("RenderSender: Failed to open UDP socket to " << address << ":" << port);
 
-	RG_LOG(" > RenderSender initalized.");
-}
+	_thread = std::thread(&RenderSender::_Run, this);
 
-FList VecToList(const Vec& vec) {
-	return FList({ vec.x, vec.y, vec.z });
+	RG_LOG(" > RenderSender initalized, sending to RocketSimVis at " << address << ":" << port);
 }
 
-json PhysToJSON(const PhysObj& obj) {
-	json j = {};
-
-	j["pos"] = VecToList(obj.pos);
-
-	j["forward"] = VecToList(obj.rotMat.forward);
-	j["right"] = VecToList(obj.rotMat.right);
-	j["up"] = VecToList(obj.rotMat.up);
-
-	j["vel"] = VecToList(obj.vel);
-	j["ang_vel"] = VecToList(obj.angVel);
+template <typename T>
+void _Write(std::vector<uint8_t>& out, T val) {
+	size_t pos = out.size();
+	out.resize(pos + sizeof(T));
+	memcpy(out.data() + pos, &val, sizeof(T));
+}
 
-	return j;
+void _WriteVec(std::vector<uint8_t>& out, const Vec& vec) {
+	_Write<float>(out, vec.x);
+	_Write<float>(out, vec.y);
+	_Write<float>(out, vec.z);
 }
 
-json PlayerToJSON(const PlayerData& player) {
-	json j = {};
+void _WritePhys(std::vector<uint8_t>& out, const PhysObj& obj) {
+	_WriteVec(out, obj.pos);
+	_WriteVec(out, obj.rotMat.forward);
+	_WriteVec(out, obj.rotMat.right);
+	_WriteVec(out, obj.rotMat.up);
+	_WriteVec(out, obj.vel);
+	_WriteVec(out, obj.angVel);
+}
 
-	j["car_id"] = player.carId;
-	j["team_num"] = (int)player.team;
-	j["phys"] = PhysToJSON(player.phys);
-	j["boost_pickups"] = player.boostPickups;
-	j["is_demoed"] = player.carState.isDemoed;
-	j["on_ground"] = player.carState.isOnGround;
-	j["ball_touched"] = player.ballTouchedStep;
-	j["has_flip"] = player.hasFlip;
-	j["boost_amount"] = player.boostFraction;
+void RLGPC::RenderSender::Send(const GameState& state, const ActionSet& actions) {
+	GetPads(state, _pads);
+	SendWithPads(state, _pads);
+}
 
-	return j;
+void RLGPC::RenderSender::GetPads(const GameState& state, std::vector<Pad>& outPads) {
+	outPads.clear();
+	if (state.lastArena) {
+		// The arena's pads have their cooldowns, and are sent with their own positions, so their order doesn't matter
+		for (BoostPad* pad : state.lastArena->_boostPads) {
+			BoostPadState padState = pad->GetState();
+			outPads.push_back({ pad->pos, padState.isActive, padState.cooldown });
+		}
+	} else {
+		for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++)
+			outPads.push_back({ CommonValues::BOOST_LOCATIONS[i], state.boostPads[i], 0 });
+	}
 }
 
-json GameStateToJSON(const GameState& state) {
-	json j = {};
-	
-	j["ball"] = PhysToJSON(state.ball);
+void RLGPC::RenderSender::SendWithPads(const GameState& state, const std::vector<Pad>& pads) {
+	// Only allocates when the packet grows
+	auto& out = _buildBuffer;
+	out.clear();
+
+	_Write<uint32_t>(out, PACKET_MAGIC);
+
+	// Sent as 120Hz ticks, since that is what the visualizer expects
+	uint64_t tickRate = RS_MAX((uint64_t)roundf(1 / state.tickTime), 1);
+	_Write<uint32_t>(out, (uint32_t)(state.lastTickCount * 120 / tickRate));
+
+	_Write<uint32_t>(out, state.players.size());
+	for (auto& player : state.players) {
+		_Write<uint8_t>(out, (uint8_t)player.team);
+		_WritePhys(out, player.phys);
+		_Write<float>(out, player.boostFraction);
+		_Write<uint8_t>(out, player.carState.isDemoed);
+
+		// Controls, not used by RocketSimVis yet
+		_Write<float>(out, 0);
+		_Write<uint8_t>(out, 0);
+		_Write<uint8_t>(out, 0);
+		_Write<uint8_t>(out, 0);
+	}
 
-	std::vector<json> players;
-	for (auto& player : state.players)
-		players.push_back(PlayerToJSON(player));
+	_Write<uint32_t>(out, pads.size());
+	for (auto& pad : pads) {
+		_WriteVec(out, pad.pos);
+		_Write<uint8_t>(out, pad.isActive);
+		_Write<float>(out, pad.cooldown);
+	}
 
-	j["players"] = players;
-	j["boost_pads"] = state.boostPads;
-	j["team_goals"] = state.scoreLine.teamGoals;
+	_WritePhys(out, state.ball);
 
-	return j;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::swap(_buildBuffer, _sendBuffer);
+		_hasPacket = true;
+	}
+	_cv.notify_one();
 }
 
-std::vector<json> ActionSetToJSON(const ActionSet& actions) {
-	std::vector<json> js = {};
-	for (auto& action : actions) {
-		FList vals;
-		for (float v : action)
-			vals.push_back(v);
-		js.push_back(json(vals));
-	}
+void RLGPC::RenderSender::_Run() {
+	// Only touched by us while we send, Send() swaps in new packets under the lock
+	std::vector<uint8_t> packet = {};
 
-	return js;
-}
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [this] { return _hasPacket || !_shouldRun; });
+			if (!_shouldRun)
+				break;
 
-void RLGPC::RenderSender::Send(const GameState& state, const ActionSet& actions) {
-	json j = {};
-	j["state"] = GameStateToJSON(state);
-	j["actions"] = ActionSetToJSON(actions);
-	
-	std::string jStr = j.dump();
-
-	try {
-		pyMod.attr("render_state")(jStr);
-	} catch (std::exception& e) {
-		RG_ERR_CLOSE("RenderSender: Failed to send gamestate, exception: " << e.what());
+			std::swap(packet, _sendBuffer);
+			_hasPacket = false;
+		}
+
+		// Nothing might be listening, which is fine
+		_socket->Send(packet.data(), packet.size());
 	}
 }
 
 RLGPC::RenderSender::~RenderSender() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_shouldRun = false;
+	}
+	_cv.notify_one();
+	_thread.join();
 
+	delete _socket;
 }
\ No newline at end of file
@@ -1,19 +1,51 @@
 #pragma once
 #include "Report.h"
-#include <pybind11/pybind11.h>
 #include <RLGymSim_CPP/Utils/Gamestates/GameState.h>
 #include <RLGymSim_CPP/Utils/BasicTypes/Action.h>
+#include <condition_variable>
 
 namespace RLGPC {
+	// Sends game states to RocketSimVis (https://github.com/ZealanL/RocketSimVis) over UDP
+	// Packets are built on the thread calling Send() into a reused buffer, then sent from our own thread
+	// If states are sent faster than our thread sends them, only the newest is sent
 	struct RG_IMEXPORT RenderSender {
-		pybind11::module pyMod;
+		constexpr static uint32_t PACKET_MAGIC = 0xA490E7B3;
 
-		RenderSender();
+		std::string address;
+		int port;
+
+		RenderSender(const std::string& address = "127.0.0.1", int port = 9273);
 
 		RG_NO_COPY(RenderSender);
 
 		void Send(const RLGSC::GameState& state, const RLGSC::ActionSet& actions);
 
+		struct Pad {
+			Vec pos;
+			bool isActive;
+			float cooldown;
+		};
+
+		// Gets the boost pads of the state, with their cooldowns if the state has its arena
+		static void GetPads(const RLGSC::GameState& state, std::vector<Pad>& outPads);
+
+		// Like Send(), but with pads from GetPads(), for states that are sent after their arena has moved on
+		void SendWithPads(const RLGSC::GameState& state, const std::vector<Pad>& pads);
+
 		~RenderSender();
+
+		class UDPSocket* _socket;
+
+		// Send() builds into the first, then swaps it with the second for our thread to send
+		std::vector<uint8_t> _buildBuffer = {}, _sendBuffer = {};
+		std::vector<Pad> _pads = {};
+		bool _hasPacket = false;
+
+		std::thread _thread;
+		std::mutex _mutex = {};
+		std::condition_variable _cv = {};
+		bool _shouldRun = true;
+
+		void _Run();
 	};
 }
\ No newline at end of file
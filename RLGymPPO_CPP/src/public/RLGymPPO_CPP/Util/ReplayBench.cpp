@@ -0,0 +1,263 @@
+#include "ReplayBench.h"
+#include "Timer.h"
+
+#include <RLGymPPO_CPP/Util/RolloutRecorder.h>
+
+using namespace RLGPC;
+
+typedef RolloutRecorder::ChunkHeader _ChunkHeader;
+typedef RolloutRecorder::ColumnHeader _ColumnHeader;
+
+void _LoadFileStreams(std::filesystem::path path, std::vector<ReplayBench::ActionStream>& out) {
+	constexpr const char* ERROR_PREFIX = "ReplayBench::LoadActionStreams(): ";
+
+	std::ifstream in = std::ifstream(path, std::ios::binary);
+	if (!in.good())
+		RG_ERR_CLOSE(ERROR_PREFIX << "Failed to open " << path);
+	std::vector<uint8_t> data = std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+
+	RolloutRecorder::FileHeader header;
+	if (data.size() < sizeof(header))
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is too small to be a recorded rollout file");
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != RolloutRecorder::MAGIC)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " is not a recorded rollout file");
+	if (header.version != RolloutRecorder::VERSION)
+		RG_ERR_CLOSE(ERROR_PREFIX << path << " has unsupported version " << header.version);
+
+	// Chunks of each game, by first step
+	std::map<uint64_t, std::map<uint64_t, ReplayBench::ActionStream>> gameChunks = {};
+
+	// Chunks are read in order, until the index (or the end of a file that wasn't closed properly)
+	uint64_t offset = sizeof(header);
+	while (offset + sizeof(_ChunkHeader) <= data.size()) {
+		_ChunkHeader chunk;
+		memcpy(&chunk, data.data() + offset, sizeof(chunk));
+		if (chunk.magic != RolloutRecorder::CHUNK_MAGIC)
+			break;
+
+		ReplayBench::ActionStream actions = {};
+		actions.gameIndex = chunk.gameIndex;
+		actions.playerAmount = chunk.playerAmount;
+		bool hasActions = false, isComplete = true;
+
+		uint64_t pos = offset + sizeof(chunk);
+		for (uint32_t i = 0; i < chunk.columnAmount; i++) {
+			_ColumnHeader column;
+			if (pos + sizeof(column) > data.size()) {
+				isComplete = false;
+				break;
+			}
+			memcpy(&column, data.data() + pos, sizeof(column));
+			const uint8_t* storedData = data.data() + pos + sizeof(column);
+			pos += sizeof(column) + column.storedSize;
+			if (pos > data.size()) {
+				isComplete = false;
+				break;
+			}
+
+			if (column.type == RolloutRecorder::ColumnType::ACTIONS) {
+				actions.actions.resize((size_t)chunk.stepAmount * chunk.playerAmount);
+				if (column.rawSize != actions.actions.size() * sizeof(int32_t))
+					RG_ERR_CLOSE(ERROR_PREFIX << "Chunk at offset " << offset << " of " << path << " has a wrongly-sized actions column");
+
+				RolloutRecorder::DecodeColumn(column, storedData, (byte*)actions.actions.data());
+				hasActions = true;
+			}
+		}
+
+		if (!isComplete)
+			break;
+
+		if (hasActions && !actions.actions.empty())
+			gameChunks[chunk.gameIndex][chunk.firstStep] = std::move(actions);
+		offset = pos;
+	}
+
+	for (auto& pair : gameChunks) {
+		ReplayBench::ActionStream stream = {};
+		stream.gameIndex = pair.first;
+		stream.playerAmount = pair.second.begin()->second.playerAmount;
+
+		uint64_t nextStep = pair.second.begin()->first;
+		for (auto& chunkPair : pair.second) {
+			auto& chunkActions = chunkPair.second;
+			if (chunkPair.first != nextStep || chunkActions.playerAmount != stream.playerAmount)
+				break;
+
+			stream.actions.insert(stream.actions.end(), chunkActions.actions.begin(), chunkActions.actions.end());
+			nextStep += chunkActions.GetStepAmount();
+		}
+
+		out.push_back(std::move(stream));
+	}
+}
+
+std::vector<ReplayBench::ActionStream> RLGPC::ReplayBench::LoadActionStreams(const std::vector<std::filesystem::path>& paths) {
+	std::vector<ActionStream> result = {};
+	for (auto& path : paths) {
+		if (std::filesystem::is_directory(path)) {
+			// Sorted, so that the streams are in the same order on every platform
+			std::vector<std::filesystem::path> folderFiles = {};
+			for (auto& entry : std::filesystem::directory_iterator(path))
+				if (entry.is_regular_file())
+					folderFiles.push_back(entry.path());
+			std::sort(folderFiles.begin(), folderFiles.end());
+
+			for (auto& filePath : folderFiles)
+				_LoadFileStreams(filePath, result);
+		} else {
+			_LoadFileStreams(path, result);
+		}
+	}
+
+	if (result.empty())
+		RG_ERR_CLOSE("ReplayBench::LoadActionStreams(): No recorded actions found");
+
+	return result;
+}
+
+struct _ReplayThread {
+	GymBatch batch;
+	std::vector<const ReplayBench::ActionStream*> gameStreams;
+
+	FList obs, rewards, dones;
+	std::vector<int64_t> actions;
+
+	double elapsed = 0;
+};
+
+void _RunReplayThread(_ReplayThread* thread, int steps) {
+	Timer timer = {};
+	auto& batch = thread->batch;
+	for (int step = 0; step < steps; step++) {
+		for (int i = 0; i < batch.Size(); i++) {
+			auto stream = thread->gameStreams[i];
+			const int32_t* stepActions = stream->actions.data() + (step % stream->GetStepAmount()) * stream->playerAmount;
+			std::copy(stepActions, stepActions + stream->playerAmount, thread->actions.data() + batch.playerStart[i]);
+		}
+
+		batch.Step(0, batch.Size(), thread->actions.data(), thread->rewards.data(), thread->dones.data());
+	}
+	thread->elapsed = timer.Elapsed();
+}
+
+std::vector<ReplayBench::Result> RLGPC::ReplayBench::Run(EnvCreateFn envCreateFn, const std::vector<ActionStream>& streams, const Config& config) {
+	if (streams.empty())
+		RG_ERR_CLOSE("ReplayBench::Run(): No action streams to replay");
+
+	int obsSize, actionAmount;
+	{
+		auto envCreateResult = envCreateFn();
+		auto obsSet = envCreateResult.gym->Reset();
+		obsSize = obsSet[0].size();
+		actionAmount = envCreateResult.match->actionParser->GetActionAmount();
+		delete envCreateResult.gym;
+		delete envCreateResult.match;
+	}
+
+	for (auto& stream : streams)
+		for (int32_t action : stream.actions)
+			if (action < 0 || action >= actionAmount)
+				RG_ERR_CLOSE("ReplayBench::Run(): Recorded game " << stream.gameIndex << " has action " << action << ", but the env only has " << actionAmount);
+
+	std::vector<Result> results = {};
+	for (int numThreads : config.threadCounts) {
+		RG_LOG("ReplayBench: Running " << numThreads << " thread(s) of " << config.numGamesPerThread << " games...");
+
+		std::vector<_ReplayThread*> threads = {};
+		std::map<int, int> streamsUsed = {}; // By player amount
+		uint64_t gameIndex = 0;
+		for (int i = 0; i < numThreads; i++) {
+			_ReplayThread* thread = new _ReplayThread();
+			for (int j = 0; j < config.numGamesPerThread; j++) {
+				auto envCreateResult = envCreateFn();
+				envCreateResult.match->randEngine.Seed((config.seed << 32) | gameIndex);
+				gameIndex++;
+
+				// Next stream with this game's amount of players
+				int playerAmount = envCreateResult.match->playerAmount;
+				const ActionStream* gameStream = NULL;
+				int& used = streamsUsed[playerAmount];
+				for (int k = 0; k < streams.size() && !gameStream; k++) {
+					auto& stream = streams[(used + k) % streams.size()];
+					if (stream.playerAmount == playerAmount) {
+						gameStream = &stream;
+						used += k + 1;
+					}
+				}
+				if (!gameStream)
+					RG_ERR_CLOSE("ReplayBench::Run(): No recorded game has " << playerAmount << " players, like the env");
+
+				thread->batch.Add(new GameInst(envCreateResult.gym, envCreateResult.match));
+				thread->gameStreams.push_back(gameStream);
+			}
+
+			int numPlayers = thread->batch.totalPlayers;
+			thread->obs.resize((size_t)numPlayers * obsSize);
+			thread->actions.resize(numPlayers);
+			thread->rewards.resize(numPlayers);
+			thread->dones.resize(numPlayers);
+
+			thread->batch.SetOBSOutput(thread->obs.data(), obsSize);
+			thread->batch.Start();
+			thread->batch.ResetMetrics(); // So the first resets aren't counted
+			threads.push_back(thread);
+		}
+
+		Timer timer = {};
+		std::vector<std::thread> stdThreads = {};
+		for (auto thread : threads)
+			stdThreads.push_back(std::thread(_RunReplayThread, thread, config.stepsPerGame));
+		for (auto& stdThread : stdThreads)
+			stdThread.join();
+
+		Result result = {};
+		result.numThreads = numThreads;
+		result.numGames = numThreads * config.numGamesPerThread;
+		result.elapsed = timer.Elapsed();
+
+		double threadTime = 0;
+		for (auto thread : threads) {
+			result.playerSteps += (uint64_t)thread->batch.totalPlayers * config.stepsPerGame;
+			threadTime += thread->elapsed;
+			for (auto game : thread->batch.games) {
+				result.simTime += game->gym->simTime;
+				result.obsBuildTime += game->gym->obsBuildTime;
+				result.terminalTime += game->gym->terminalTime;
+				result.rewardTime += game->gym->rewardTime;
+				result.resetTime += game->gym->resetTime;
+			}
+			delete thread;
+		}
+
+		result.playerStepsPerSecond = result.playerSteps / result.elapsed;
+		result.otherTime = threadTime - result.simTime - result.obsBuildTime - result.terminalTime - result.rewardTime - result.resetTime;
+
+		RG_LOG(
+			"\t" << (int64_t)result.playerStepsPerSecond << " player steps/second (" << result.playerSteps << " in " << result.elapsed << "s)\n" <<
+			"\tThread time: " << threadTime << "s, sim: " << result.simTime << "s, OBS: " << result.obsBuildTime << "s, " <<
+			"terminal: " << result.terminalTime << "s, reward: " << result.rewardTime << "s, reset: " << result.resetTime << "s, other: " << result.otherTime << "s"
+		);
+		results.push_back(result);
+	}
+
+	return results;
+}
+
+std::string RLGPC::ReplayBench::ToJSON(const std::vector<Result>& results) {
+	std::stringstream stream;
+	stream << "[\n";
+	for (int i = 0; i < results.size(); i++) {
+		auto& result = results[i];
+		stream << "\t{ \"threads\": " << result.numThreads << ", \"games\": " << result.numGames;
+		stream << ", \"player_steps\": " << result.playerSteps << ", \"elapsed\": " << result.elapsed;
+		stream << ", \"player_steps_per_second\": " << result.playerStepsPerSecond;
+		stream << ", \"sim_time\": " << result.simTime << ", \"obs_build_time\": " << result.obsBuildTime;
+		stream << ", \"terminal_time\": " << result.terminalTime << ", \"reward_time\": " << result.rewardTime;
+		stream << ", \"reset_time\": " << result.resetTime << ", \"other_time\": " << result.otherTime << " }";
+		stream << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	stream << "]";
+	return stream.str();
+}
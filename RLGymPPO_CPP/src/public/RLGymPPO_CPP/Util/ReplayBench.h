@@ -0,0 +1,53 @@
+#pragma once
+#include "../Threading/GymBatch.h"
+
+namespace RLGPC {
+	// Environment-only benchmark, which replays the actions of a training run through games with no policy and no libtorch
+	// Actions are read from files written by the rollout recorder (see LearnerConfig::rolloutRecordPath)
+	// Replaying the same recordings with the same env and seed steps the same games, so results are comparable between builds
+	namespace ReplayBench {
+		// Recorded actions of one game
+		struct ActionStream {
+			uint64_t gameIndex;
+			int playerAmount;
+			std::vector<int32_t> actions; // [steps][players]
+
+			uint64_t GetStepAmount() const {
+				return actions.size() / playerAmount;
+			}
+		};
+
+		// Reads the actions of every recorded game in these files, or folders of files
+		// The chunks of each game are joined in order, up to the first one that is missing
+		RG_IMEXPORT std::vector<ActionStream> LoadActionStreams(const std::vector<std::filesystem::path>& paths);
+
+		struct Config {
+			// Each is run separately, with numGamesPerThread games per thread
+			IList threadCounts = { 1, 2, 4, 8 };
+			int numGamesPerThread = 16;
+
+			// Every game is stepped this many times per run, so runs with more threads do more work
+			int stepsPerGame = 2000;
+
+			// The random engine of each game is seeded from this and the game's index (see RLGSC::Match::randEngine)
+			uint64_t seed = 0;
+		};
+
+		struct Result {
+			int numThreads, numGames;
+			uint64_t playerSteps;
+			double elapsed; // Wall time, in seconds
+			double playerStepsPerSecond;
+
+			// Time spent on each part of stepping, in seconds summed over all threads (see RLGSC::Gym)
+			double simTime, obsBuildTime, terminalTime, rewardTime, resetTime;
+			// The rest of the time of the threads, e.g. copying actions and rewards
+			double otherTime;
+		};
+
+		// Game i replays the i-th stream with its amount of players (looping around the streams), starting over when it runs out
+		RG_IMEXPORT std::vector<Result> Run(EnvCreateFn envCreateFn, const std::vector<ActionStream>& streams, const Config& config);
+
+		RG_IMEXPORT std::string ToJSON(const std::vector<Result>& results);
+	}
+}
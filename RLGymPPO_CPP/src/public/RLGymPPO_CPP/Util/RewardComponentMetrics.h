@@ -0,0 +1,34 @@
+#pragma once
+#include "MetricRegistry.h"
+#include "../Threading/GameInst.h"
+
+#include <RLGymSim_CPP/Utils/RewardFunctions/StaticCombinedReward.h>
+
+namespace RLGPC {
+	// Registered metrics for the reward functions of a StaticCombinedReward, one AVG metric per function
+	// Construct once before the learner starts, then call Add() from the step callback
+	template <typename... Rs>
+	class RewardComponentMetrics {
+	public:
+		constexpr static int FUNC_AMOUNT = sizeof...(Rs);
+		std::array<MetricHandle, FUNC_AMOUNT> handles;
+
+		// Metric names are prefix + the name of each function, in order
+		RewardComponentMetrics(const std::array<std::string, FUNC_AMOUNT>& names, const std::string& prefix = "reward_") {
+			for (int i = 0; i < FUNC_AMOUNT; i++)
+				handles[i] = MetricRegistry::Register(prefix + names[i], MetricType::AVG);
+		}
+
+		// Adds the functions' rewards of the last step to this game's metrics
+		// Turns on StaticCombinedReward::recordFuncRewards if it isn't yet, so the first step after that is skipped
+		void Add(GameInst* game, RLGSC::StaticCombinedReward<Rs...>* reward) const {
+			if (!reward->recordFuncRewards) {
+				reward->recordFuncRewards = true;
+				return;
+			}
+
+			for (int i = 0; i < FUNC_AMOUNT; i++)
+				game->metrics.Add(handles[i], reward->lastFuncRewards[i]);
+		}
+	};
+}
@@ -0,0 +1,59 @@
+#include "WelfordRunningStat.h"
+#include "../Threading/JobSystem.h"
+
+// Mean and sum of squared differences of rows [0, rows) of samples ([rows][shape])
+// Values are shifted by the first row, so that summing squares in one pass doesn't lose precision to large means
+void _ComputeMoments(const float* samples, int64_t rows, int shape, double* outMean, double* outVariance) {
+	const float* shift = samples;
+	for (int i = 0; i < shape; i++)
+		outMean[i] = outVariance[i] = 0;
+
+	// Inner loops are over contiguous values, so they vectorize
+	for (int64_t row = 1; row < rows; row++) {
+		const float* sample = samples + row * shape;
+		for (int i = 0; i < shape; i++) {
+			double delta = (double)sample[i] - shift[i];
+			outMean[i] += delta;
+			outVariance[i] += delta * delta;
+		}
+	}
+
+	for (int i = 0; i < shape; i++) {
+		double deltaSum = outMean[i];
+		outMean[i] = shift[i] + deltaSum / rows;
+		outVariance[i] = RS_MAX(outVariance[i] - deltaSum * deltaSum / rows, 0);
+	}
+}
+
+void RLGPC::WelfordRunningStat::IncrementBatch(const float* samples, int64_t rows, JobSystem* jobs) {
+	if (rows <= 0)
+		return;
+
+	int numChunks = 1;
+	if (jobs && rows * shape >= PARALLEL_MIN_VALUES)
+		numChunks = RS_CLAMP(jobs->GetNumThreads(), 1, rows);
+
+	// Thread-local results, merged in order
+	std::vector<double> chunkMoments = std::vector<double>((size_t)numChunks * shape * 2);
+	auto fnChunkRows = [&](int chunk) -> std::pair<int64_t, int64_t> {
+		return { rows * chunk / numChunks, rows * (chunk + 1) / numChunks };
+	};
+	auto fnComputeChunk = [&](int chunk) {
+		auto [start, end] = fnChunkRows(chunk);
+		double* moments = chunkMoments.data() + (size_t)chunk * shape * 2;
+		_ComputeMoments(samples + start * shape, end - start, shape, moments, moments + shape);
+	};
+
+	JobSystem::ParallelFor(jobs, 0, numChunks, 1,
+		[&](int64_t start, int64_t end) {
+			for (int64_t chunk = start; chunk < end; chunk++)
+				fnComputeChunk(chunk);
+		}
+	);
+
+	for (int i = 0; i < numChunks; i++) {
+		auto [start, end] = fnChunkRows(i);
+		double* moments = chunkMoments.data() + (size_t)i * shape * 2;
+		Add(end - start, moments, moments + shape);
+	}
+}
\ No newline at end of file
@@ -1,19 +1,19 @@
 #pragma once
-#include "../Framework.h"
+#include "../Lists.h"
 
 namespace RLGPC {
-	struct WelfordRunningStat {
+	struct RG_IMEXPORT WelfordRunningStat {
 		FList ones, zeros;
 		std::vector<double> runningMean, runningVariance;
 
-		int64_t count, shape;
+		int64_t count = 0, shape = 0;
 
 		WelfordRunningStat() = default;
 		WelfordRunningStat(int shape) {
 			this->ones = FList(shape);
 			this->zeros = FList(shape);
 			std::fill(ones.begin(), ones.end(), 1);
-			std::fill(zeros.begin(), zeros.end(), 1);
+			std::fill(zeros.begin(), zeros.end(), 0);
 
 			this->runningMean = std::vector<double>(shape);
 			this->runningVariance = std::vector<double>(shape);
@@ -24,32 +24,54 @@ namespace RLGPC {
 
 		void Increment(const FList2& samples, int num) {
 			for (int i = 0; i < num; i++)
-				Update(samples[i]);
+				Update(samples[i].data());
 		}
 
-		// TODO: Inefficient construction of another DList
-		void Increment(const FList& samples, int num) {
-			for (int i = 0; i < num; i++)
-				Update(FList({ samples[i] }));
+		// For stats with a shape of 1
+		void Increment(const FList& samples, int num, class JobSystem* jobs = NULL) {
+			IncrementBatch(samples.data(), num, jobs);
 		}
 
-		void Update(const FList& sample) {
-			int64_t currentCount = count;
-			count++;
-
-			// TODO: Inefficient, only need 1 loop
+		// Adds a contiguous batch of samples ([rows][shape]), without allocating per sample
+		// The mean and sum of squared differences of each chunk of rows are computed in one pass, then merged with Add()
+		// Batches of at least PARALLEL_MIN_VALUES values are split into chunks across the threads of jobs, if set
+		// Results don't depend on the amount of threads more than floating-point rounding
+		void IncrementBatch(const float* samples, int64_t rows, class JobSystem* jobs = NULL);
+		constexpr static int64_t PARALLEL_MIN_VALUES = 1 << 16;
 
-			auto delta = std::vector<double>(shape);
-			auto deltaN = std::vector<double>(shape);
+		void Update(const float* sample) {
+			count++;
 			for (int i = 0; i < shape; i++) {
-				delta[i] = sample[i] - runningMean[i];
-				deltaN[i] = delta[i] / count;
+				double delta = sample[i] - runningMean[i];
+				runningMean[i] += delta / count;
+				runningVariance[i] += delta * (sample[i] - runningMean[i]);
 			}
+		}
 
+		void Update(const FList& sample) {
+			Update(sample.data());
+		}
+
+		// Adds the stats of a separate set of samples, with their mean and sum of squared differences from it ([shape] each)
+		// Parallel variant of Welford's algorithm: https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Parallel_algorithm
+		void Add(int64_t otherCount, const double* otherMean, const double* otherVariance) {
+			if (otherCount == 0)
+				return;
+
+			int64_t newCount = count + otherCount;
+			double otherFrac = (double)otherCount / newCount;
+			double crossWeight = (double)count * otherCount / newCount;
 			for (int i = 0; i < shape; i++) {
-				runningMean[i] += deltaN[i];
-				runningVariance[i] += delta[i] * deltaN[i] * currentCount;
+				double delta = otherMean[i] - runningMean[i];
+				runningMean[i] += delta * otherFrac;
+				runningVariance[i] += otherVariance[i] + delta * delta * crossWeight;
 			}
+			count = newCount;
+		}
+
+		// Combines with stats from other samples, as if they had all been added to us
+		void Merge(const WelfordRunningStat& other) {
+			Add(other.count, other.runningMean.data(), other.runningVariance.data());
 		}
 
 		void Reset() {
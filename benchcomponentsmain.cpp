@@ -0,0 +1,82 @@
+#include <RLGymSim_CPP/Utils/Bench/ComponentBench.h>
+
+#include <RLGymSim_CPP/Utils/RewardFunctions/CommonRewards.h>
+#include <RLGymSim_CPP/Utils/RewardFunctions/CombinedReward.h>
+#include <RLGymSim_CPP/Utils/RewardFunctions/StaticCombinedReward.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/NoTouchCondition.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/GoalScoreCondition.h>
+#include <RLGymSim_CPP/Utils/OBSBuilders/DefaultOBS.h>
+#include <RLGymSim_CPP/Utils/OBSBuilders/DefaultOBSPadded.h>
+#include <RLGymSim_CPP/Utils/ActionParsers/DiscreteAction.h>
+
+#include <fstream>
+
+// Baselines of the built-in components with ComponentBench, add your own components here to compare with them
+// Usage: bench_components [--seconds <per component>] [--out <json path>]
+
+// So allocations per step are counted
+RG_COUNTING_ALLOCATOR();
+
+using namespace RLGSC;
+using namespace RLGSC::ComponentBench;
+
+int main(int argc, char* argv[]) {
+	double seconds = 1;
+	std::filesystem::path outPath = "bench_components.json";
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i], val = argv[i + 1];
+		if (arg == "--seconds") {
+			seconds = std::stod(val);
+		} else if (arg == "--out") {
+			outPath = val;
+		} else {
+			RG_ERR_CLOSE("Unknown argument \"" << arg << "\"");
+		}
+	}
+
+	RocketSim::Init("./collision_meshes");
+
+	std::vector<Result> results = {};
+	for (int teamSize : { 1, 2, 3 }) {
+		std::string suffix = RS_STR(" (" << teamSize << "v" << teamSize << ")");
+		StateCorpus corpus = RecordStates(teamSize, 4000);
+
+		DefaultOBS defaultOBS = {};
+		results.push_back(BenchOBS("DefaultOBS" + suffix, &defaultOBS, corpus, seconds));
+
+		DefaultOBSPadded defaultOBSPadded = DefaultOBSPadded(3);
+		results.push_back(BenchOBS("DefaultOBSPadded" + suffix, &defaultOBSPadded, corpus, seconds));
+
+		// The example's reward
+		// Not deleted, like the rewards of a Match
+		auto combinedReward = new CombinedReward(
+			{
+				{ new FaceBallReward(), 0.1f },
+				{ new VelocityPlayerToBallReward(), 0.5f },
+				{ new VelocityBallToGoalReward(), 1.0f },
+				{ new EventReward({.teamGoal = 1.f, .concede = -1.f}), 50.f },
+			}
+		);
+		results.push_back(BenchReward("CombinedReward" + suffix, combinedReward, corpus, seconds));
+
+		// The same reward, combined at compile time
+		auto staticCombinedReward = new StaticCombinedReward(
+			{ 0.1f, 0.5f, 1.0f, 50.f },
+			FaceBallReward(), VelocityPlayerToBallReward(), VelocityBallToGoalReward(), EventReward({.teamGoal = 1.f, .concede = -1.f})
+		);
+		results.push_back(BenchReward("StaticCombinedReward" + suffix, staticCombinedReward, corpus, seconds));
+
+		NoTouchCondition noTouchCondition = NoTouchCondition(3 * 120 / 8);
+		results.push_back(BenchTerminal("NoTouchCondition" + suffix, &noTouchCondition, corpus, seconds));
+
+		GoalScoreCondition goalScoreCondition = {};
+		results.push_back(BenchTerminal("GoalScoreCondition" + suffix, &goalScoreCondition, corpus, seconds));
+
+		DiscreteAction discreteAction = {};
+		results.push_back(BenchActionParser("DiscreteAction" + suffix, &discreteAction, corpus, seconds));
+	}
+
+	std::ofstream(outPath) << ToJSON(results);
+	RG_LOG("Wrote results to " << outPath);
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
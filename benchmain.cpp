@@ -0,0 +1,440 @@
+#include <RocketSim.h>
+
+#include <fstream>
+#include <sstream>
+
+// Measures RocketSim's performance in representative scenarios, and writes the results as JSON
+// Usage: bench_rocketsim [--meshes <collision meshes folder>] [--seconds <per scenario>] [--threads <max threads>] [--out <json path>]
+
+using namespace RocketSim;
+
+struct BenchArgs {
+	std::filesystem::path meshesPath = "collision_meshes";
+	double seconds = 2;
+	int maxThreads = RS_MAX((int)std::thread::hardware_concurrency(), 1);
+	std::filesystem::path outPath = "bench_rocketsim.json";
+};
+
+struct Scenario {
+	std::string name;
+	int teamSize = 1; // 0 for no cars
+	ArenaMemWeightMode memWeightMode = ArenaMemWeightMode::LIGHT;
+	bool useCustomBroadphase = true;
+	bool wallPlay = false; // Cars start driving into the side walls with the ball
+	bool genericSolver = false; // Solve contacts with Bullet's generic iterations, to compare with the contact-only ones
+	uint32_t slabKB = 512;
+	HugePageMode slabHugePages = HugePageMode::NONE;
+	bool groundPlay = false; // Cars never jump, so they spend most of their time driving on the floor
+	int adaptiveSubstepTicks = 0; // If set, arenas use Arena::StepAdaptive() with this as the max substep
+	float tickRate = 120; // The tick skip is scaled with this, so that decisions are always the same length of game time
+};
+
+double ElapsedSince(std::chrono::steady_clock::time_point startTime) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+Arena* CreateArena(const Scenario& scenario, int seed) {
+	ArenaConfig config = {};
+	config.memWeightMode = scenario.memWeightMode;
+	config.useCustomBroadphase = scenario.useCustomBroadphase;
+	config.slabKB = scenario.slabKB;
+	config.slabHugePages = scenario.slabHugePages;
+
+	Arena* arena = Arena::Create(GameMode::SOCCAR, config, scenario.tickRate);
+	for (int i = 0; i < scenario.teamSize; i++) {
+		arena->AddCar(Team::BLUE);
+		arena->AddCar(Team::ORANGE);
+	}
+	arena->ResetToRandomKickoff(seed);
+
+	if (scenario.genericSolver)
+		arena->_bulletWorld.getSolverInfo().m_solverMode |= SOLVER_RS_GENERIC_ITERATIONS;
+
+	if (scenario.wallPlay) {
+		// Everything pressed against the same side wall, so most ticks have car-wall, car-car and car-ball contacts
+		int i = 0;
+		for (Car* car : arena->GetCars()) {
+			CarState state = {};
+			state.pos = Vec(3600, -600 + i * 200.f, 17);
+			state.rotMat = Angle(0, 0, 0).ToRotMat();
+			state.vel = Vec(1000, 0, 0);
+			state.boost = 100;
+			car->SetState(state);
+			i++;
+		}
+
+		BallState ballState = {};
+		ballState.pos = Vec(3900, 0, 300);
+		ballState.vel = Vec(500, 0, 200);
+		arena->ball->SetState(ballState);
+	} else if (scenario.teamSize == 0) {
+		BallState ballState = {};
+		ballState.pos = Vec(0, 0, 500);
+		ballState.vel = Vec(1500, 2000, 1000);
+		arena->ball->SetState(ballState);
+	}
+
+	return arena;
+}
+
+// Gives every car new random controls, like a bot with a tick skip of 8 would
+void RandomizeControls(Arena* arena, std::mt19937& rng, bool wallPlay, bool groundPlay) {
+	std::uniform_real_distribution<float> dist = std::uniform_real_distribution<float>(-1, 1);
+	for (Car* car : arena->GetCars()) {
+		CarControls& controls = car->controls;
+		controls.throttle = wallPlay ? 1 : dist(rng);
+		controls.steer = dist(rng);
+		controls.pitch = dist(rng);
+		controls.yaw = dist(rng);
+		controls.roll = dist(rng);
+		controls.boost = wallPlay || dist(rng) > 0.5f;
+		controls.jump = !groundPlay && dist(rng) > 0.8f;
+		controls.handbrake = dist(rng) > 0.8f;
+	}
+}
+
+constexpr int TICK_SKIP = 8; // At 120Hz
+constexpr int ARENAS_PER_THREAD = 4;
+constexpr float RESET_SECONDS = 20; // Arenas are reset this often, so they don't settle into a quiet state
+
+int GetTickSkip(const Scenario& scenario) {
+	return RS_MAX((int)roundf(TICK_SKIP * scenario.tickRate / 120), 1);
+}
+
+bool ShouldReset(Arena* arena) {
+	return arena->tickCount * arena->tickTime >= RESET_SECONDS;
+}
+
+// Steps one decision, like a gym would: the first tick normally, and the rest adaptively if the scenario does
+void StepArena(Arena* arena, const Scenario& scenario) {
+	int tickSkip = GetTickSkip(scenario);
+	if (scenario.adaptiveSubstepTicks > 0) {
+		AdaptiveStepConfig config = {};
+		config.maxSubstepTicks = scenario.adaptiveSubstepTicks;
+		arena->Step(1);
+		arena->StepAdaptive(tickSkip - 1, config);
+	} else {
+		arena->Step(tickSkip);
+	}
+}
+
+// Makes a new arena for the scenario, with the same cars, ball and boost pads as the given one
+// Unlike Arena::Clone(), this can change the tick rate
+Arena* CopyArena(Arena* arena, const Scenario& scenario) {
+	Arena* result = CreateArena(scenario, 0);
+	for (int i = 0; i < arena->GetCars().size(); i++) {
+		result->GetCars()[i]->SetState(arena->GetCars()[i]->GetState());
+		result->GetCars()[i]->controls = arena->GetCars()[i]->controls;
+	}
+	result->ball->SetState(arena->ball->GetState());
+	for (int i = 0; i < arena->_boostPads.size(); i++)
+		result->_boostPads[i]->SetState(arena->_boostPads[i]->GetState());
+	return result;
+}
+
+// Steps arenasPerThread arenas on each of numThreads threads for the given time, returns total ticks per second
+double MeasureTPS(const Scenario& scenario, int numThreads, double seconds) {
+	std::atomic<uint64_t> totalTicks = 0;
+	std::atomic<int> numReady = 0;
+	std::atomic<bool> shouldStart = false, shouldStop = false;
+
+	std::vector<std::thread> threads = {};
+	for (int t = 0; t < numThreads; t++) {
+		threads.emplace_back([&, t] {
+			std::mt19937 rng = std::mt19937(t);
+			std::vector<Arena*> arenas = {};
+			for (int i = 0; i < ARENAS_PER_THREAD; i++)
+				arenas.push_back(CreateArena(scenario, t * ARENAS_PER_THREAD + i));
+
+			// Creating arenas isn't part of the measurement
+			numReady++;
+			while (!shouldStart)
+				std::this_thread::yield();
+
+			uint64_t ticks = 0;
+			while (!shouldStop) {
+				for (Arena*& arena : arenas) {
+					if (ShouldReset(arena)) {
+						delete arena;
+						arena = CreateArena(scenario, rng());
+					}
+
+					RandomizeControls(arena, rng, scenario.wallPlay, scenario.groundPlay);
+					StepArena(arena, scenario);
+					ticks += GetTickSkip(scenario);
+				}
+			}
+
+			totalTicks += ticks;
+			for (Arena* arena : arenas)
+				delete arena;
+		});
+	}
+
+	while (numReady < numThreads)
+		std::this_thread::yield();
+
+	auto startTime = std::chrono::steady_clock::now();
+	shouldStart = true;
+	std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+	shouldStop = true;
+	for (auto& thread : threads)
+		thread.join();
+
+	return totalTicks / ElapsedSince(startTime);
+}
+
+constexpr int DRIFT_HORIZON_TICKS = 120;
+constexpr int DRIFT_RUNS = 200;
+
+struct DriftResult {
+	double substepFraction = 0; // Of the compared arenas' ticks, if they step adaptively
+	double meanCarError = 0, maxCarError = 0; // Car position error in UU, after the horizon
+	double meanBallError = 0, maxBallError = 0; // Ball position error in UU, after the horizon
+};
+
+// Steps two copies of the same arena with the same controls for DRIFT_HORIZON_TICKS (at 120Hz), one every tick at 120Hz and one stepped like the scenario,
+//	and measures how far apart they ended up
+// The full-rate copy then continues as the next run's arena, so runs cover a whole game
+DriftResult MeasureDrift(const Scenario& scenario) {
+	DriftResult result = {};
+	std::mt19937 rng = std::mt19937(0);
+
+	Scenario fullScenario = scenario;
+	fullScenario.adaptiveSubstepTicks = 0;
+	fullScenario.tickRate = 120;
+
+	Arena* arena = CreateArena(fullScenario, 0);
+	uint64_t totalTicks = 0, totalSubstepTicks = 0, carSamples = 0;
+	for (int run = 0; run < DRIFT_RUNS; run++) {
+		if (ShouldReset(arena)) {
+			delete arena;
+			arena = CreateArena(fullScenario, rng());
+		}
+
+		Arena* full = arena->Clone(false);
+		Arena* compared = (scenario.tickRate == fullScenario.tickRate) ? arena->Clone(false) : CopyArena(arena, scenario);
+		for (int tick = 0; tick < DRIFT_HORIZON_TICKS; tick += TICK_SKIP) {
+			RandomizeControls(full, rng, scenario.wallPlay, scenario.groundPlay);
+			for (int i = 0; i < full->GetCars().size(); i++)
+				compared->GetCars()[i]->controls = full->GetCars()[i]->controls;
+
+			StepArena(full, fullScenario);
+			StepArena(compared, scenario);
+		}
+
+		for (int i = 0; i < full->GetCars().size(); i++) {
+			double error = full->GetCars()[i]->GetState().pos.Dist(compared->GetCars()[i]->GetState().pos);
+			result.meanCarError += error;
+			result.maxCarError = RS_MAX(result.maxCarError, error);
+			carSamples++;
+		}
+
+		double ballError = full->ball->GetState().pos.Dist(compared->ball->GetState().pos);
+		result.meanBallError += ballError;
+		result.maxBallError = RS_MAX(result.maxBallError, ballError);
+
+		totalTicks += compared->adaptiveStepStats.ticks + (DRIFT_HORIZON_TICKS / TICK_SKIP);
+		totalSubstepTicks += compared->adaptiveStepStats.substepTicks;
+
+		delete compared;
+		delete arena;
+		arena = full;
+	}
+	delete arena;
+
+	result.substepFraction = totalTicks ? (double)totalSubstepTicks / totalTicks : 0;
+	result.meanCarError /= RS_MAX(carSamples, 1);
+	result.meanBallError /= DRIFT_RUNS;
+	return result;
+}
+
+// Average time of fn in microseconds, over as many runs as fit in the given time
+template <typename T>
+double MeasureMicroseconds(double seconds, T fn) {
+	uint64_t runs = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	do {
+		fn();
+		runs++;
+	} while (ElapsedSince(startTime) < seconds);
+
+	return ElapsedSince(startTime) * 1000 * 1000 / runs;
+}
+
+int main(int argc, char* argv[]) {
+	BenchArgs args = {};
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i], val = argv[i + 1];
+		if (arg == "--meshes") {
+			args.meshesPath = val;
+		} else if (arg == "--seconds") {
+			args.seconds = std::stod(val);
+		} else if (arg == "--threads") {
+			args.maxThreads = RS_MAX(std::stoi(val), 1);
+		} else if (arg == "--out") {
+			args.outPath = val;
+		} else {
+			RS_ERR_CLOSE("Unknown argument \"" << arg << "\"");
+		}
+	}
+
+	RocketSim::Init(args.meshesPath);
+
+	std::vector<Scenario> scenarios = {
+		{ "1v1", 1 },
+		{ "2v2", 2 },
+		{ "3v3", 3 },
+		{ "2v2_heavy", 2, ArenaMemWeightMode::HEAVY },
+		{ "2v2_dbvt", 2, ArenaMemWeightMode::LIGHT, false },
+		{ "ball_only", 0 },
+		{ "2v2_wall_play", 2, ArenaMemWeightMode::LIGHT, true, true },
+		{ "2v2_generic_solver", 2, ArenaMemWeightMode::LIGHT, true, false, true },
+		{ "2v2_wall_play_generic_solver", 2, ArenaMemWeightMode::LIGHT, true, true, true },
+		// Huge pages need a 2MB slab, so they are compared to a 2MB slab with regular pages
+		{ "2v2_slab_2mb", 2, ArenaMemWeightMode::LIGHT, true, false, false, 2048 },
+		{ "2v2_slab_2mb_huge_pages", 2, ArenaMemWeightMode::LIGHT, true, false, false, 2048, HugePageMode::MADVISE },
+	};
+
+	std::stringstream json;
+	json << "{\n";
+	json << "\t\"seconds_per_run\": " << args.seconds << ",\n";
+	json << "\t\"tick_skip\": " << TICK_SKIP << ",\n";
+	json << "\t\"arenas_per_thread\": " << ARENAS_PER_THREAD << ",\n";
+
+	// Single-thread speed of each scenario
+	json << "\t\"scenarios\": [\n";
+	for (int i = 0; i < scenarios.size(); i++) {
+		auto& scenario = scenarios[i];
+		double tps = MeasureTPS(scenario, 1, args.seconds);
+		RS_LOG(scenario.name << ": " << (int64_t)tps << " ticks/second/core");
+
+		json << "\t\t{ \"name\": \"" << scenario.name << "\", \"ticks_per_second\": " << (int64_t)tps << " }";
+		json << (i + 1 < scenarios.size() ? ",\n" : "\n");
+	}
+	json << "\t],\n";
+
+	// Scaling of 2v2 with threads, each owning its own arenas
+	json << "\t\"thread_scaling\": [\n";
+	std::vector<int> threadCounts = {};
+	for (int numThreads = 1; numThreads < args.maxThreads; numThreads *= 2)
+		threadCounts.push_back(numThreads);
+	threadCounts.push_back(args.maxThreads);
+
+	for (int i = 0; i < threadCounts.size(); i++) {
+		int numThreads = threadCounts[i];
+		double tps = MeasureTPS(scenarios[1], numThreads, args.seconds);
+		RS_LOG("2v2 with " << numThreads << " thread(s): " << (int64_t)tps << " ticks/second (" << (int64_t)(tps / numThreads) << " per thread)");
+
+		json << "\t\t{ \"threads\": " << numThreads << ", \"ticks_per_second\": " << (int64_t)tps << ", \"ticks_per_second_per_thread\": " << (int64_t)(tps / numThreads) << " }";
+		json << (i + 1 < threadCounts.size() ? ",\n" : "\n");
+	}
+	json << "\t],\n";
+
+	// Speed and drift of adaptive substepping, compared to stepping every tick
+	// Drift is measured after DRIFT_HORIZON_TICKS, from the same state and with the same controls
+	json << "\t\"adaptive_step\": [\n";
+	std::vector<Scenario> adaptiveScenarios = {};
+	for (bool groundPlay : { false, true }) {
+		for (int substepTicks : { 0, 2, 4 }) {
+			Scenario scenario = { groundPlay ? "2v2_ground_play" : "2v2", 2 };
+			scenario.groundPlay = groundPlay;
+			scenario.adaptiveSubstepTicks = substepTicks;
+			if (substepTicks > 0)
+				scenario.name += "_adaptive_" + std::to_string(substepTicks);
+			adaptiveScenarios.push_back(scenario);
+		}
+	}
+
+	for (int i = 0; i < adaptiveScenarios.size(); i++) {
+		auto& scenario = adaptiveScenarios[i];
+		double tps = MeasureTPS(scenario, 1, args.seconds);
+		json << "\t\t{ \"name\": \"" << scenario.name << "\", \"ticks_per_second\": " << (int64_t)tps;
+
+		if (scenario.adaptiveSubstepTicks > 0) {
+			DriftResult drift = MeasureDrift(scenario);
+			RS_LOG(
+				scenario.name << ": " << (int64_t)tps << " ticks/second/core, " << (int)(drift.substepFraction * 100) << "% of ticks substepped, " <<
+				"drift after " << DRIFT_HORIZON_TICKS << " ticks: car " << drift.meanCarError << "uu avg/" << drift.maxCarError << "uu max, " <<
+				"ball " << drift.meanBallError << "uu avg/" << drift.maxBallError << "uu max"
+			);
+
+			json << ", \"substep_fraction\": " << drift.substepFraction;
+			json << ", \"car_drift_uu\": { \"mean\": " << drift.meanCarError << ", \"max\": " << drift.maxCarError << " }";
+			json << ", \"ball_drift_uu\": { \"mean\": " << drift.meanBallError << ", \"max\": " << drift.maxBallError << " }";
+		} else {
+			RS_LOG(scenario.name << ": " << (int64_t)tps << " ticks/second/core");
+		}
+
+		json << " }" << (i + 1 < adaptiveScenarios.size() ? ",\n" : "\n");
+	}
+	json << "\t],\n";
+
+	// Speed and drift of lower tick rates, compared to 120Hz
+	// Steps are the same length of game time, so game seconds per second is what to compare
+	json << "\t\"tick_rate\": [\n";
+	std::vector<Scenario> tickRateScenarios = {};
+	for (Scenario scenario : { scenarios[0], scenarios[1], scenarios[6], adaptiveScenarios[3] }) {
+		for (float tickRate : { 120.f, 60.f }) {
+			scenario.tickRate = tickRate;
+			if (tickRate != 120)
+				scenario.name += "_" + std::to_string((int)tickRate) + "hz";
+			tickRateScenarios.push_back(scenario);
+		}
+	}
+
+	for (int i = 0; i < tickRateScenarios.size(); i++) {
+		auto& scenario = tickRateScenarios[i];
+		double tps = MeasureTPS(scenario, 1, args.seconds);
+		double gameSecondsPerSecond = tps / scenario.tickRate;
+		json << "\t\t{ \"name\": \"" << scenario.name << "\", \"tick_rate\": " << scenario.tickRate << ", ";
+		json << "\"ticks_per_second\": " << (int64_t)tps << ", \"game_seconds_per_second\": " << gameSecondsPerSecond;
+
+		if (scenario.tickRate != 120) {
+			DriftResult drift = MeasureDrift(scenario);
+			RS_LOG(
+				scenario.name << ": " << gameSecondsPerSecond << " game seconds/second/core, " <<
+				"drift after " << DRIFT_HORIZON_TICKS / 120.f << "s: car " << drift.meanCarError << "uu avg/" << drift.maxCarError << "uu max, " <<
+				"ball " << drift.meanBallError << "uu avg/" << drift.maxBallError << "uu max"
+			);
+
+			json << ", \"car_drift_uu\": { \"mean\": " << drift.meanCarError << ", \"max\": " << drift.maxCarError << " }";
+			json << ", \"ball_drift_uu\": { \"mean\": " << drift.meanBallError << ", \"max\": " << drift.maxBallError << " }";
+		} else {
+			RS_LOG(scenario.name << ": " << gameSecondsPerSecond << " game seconds/second/core");
+		}
+
+		json << " }" << (i + 1 < tickRateScenarios.size() ? ",\n" : "\n");
+	}
+	json << "\t],\n";
+
+	// Costs of making arenas
+	Arena* arena = CreateArena(scenarios[1], 0);
+	arena->Step(120);
+
+	double createTime = MeasureMicroseconds(args.seconds, [&] { delete CreateArena(scenarios[1], 0); });
+	double cloneTime = MeasureMicroseconds(args.seconds, [&] { delete arena->Clone(false); });
+
+	DataStreamOut out = {};
+	double serializeTime = MeasureMicroseconds(args.seconds, [&] {
+		out.Clear();
+		arena->Serialize(out);
+	});
+	double deserializeTime = MeasureMicroseconds(args.seconds, [&] {
+		DataStreamIn in = DataStreamIn::FromBuffer(out.data.data(), out.data.size());
+		delete Arena::DeserializeNew(in);
+	});
+	delete arena;
+
+	RS_LOG("2v2 arena costs: create " << createTime << "us, clone " << cloneTime << "us, serialize " << serializeTime << "us, deserialize " << deserializeTime << "us");
+	json << "\t\"arena_costs_us\": { ";
+	json << "\"create\": " << createTime << ", \"clone\": " << cloneTime << ", ";
+	json << "\"serialize\": " << serializeTime << ", \"deserialize\": " << deserializeTime << ", ";
+	json << "\"serialized_bytes\": " << out.data.size() << " }\n";
+	json << "}";
+
+	std::ofstream(args.outPath) << json.str();
+	RS_LOG("Wrote results to " << args.outPath);
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include <RLGymPPO_CPP/Learner.h>
+
+#include <RLGymSim_CPP/Utils/RewardFunctions/CommonRewards.h>
+#include <RLGymSim_CPP/Utils/RewardFunctions/CombinedReward.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/NoTouchCondition.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/GoalScoreCondition.h>
+#include <RLGymSim_CPP/Utils/OBSBuilders/DefaultOBS.h>
+#include <RLGymSim_CPP/Utils/StateSetters/RandomState.h>
+#include <RLGymSim_CPP/Utils/ActionParsers/DiscreteAction.h>
+
+// Benchmarks collection and learning with Learner::Benchmark(), on the example's environment with a fixed seed
+// Usage: bench_ppo [--threads 8,16] [--games 16,24] [--batch 100000] [--minibatch 25000,50000] [--huge-pages none,madvise,reserved] [--tick-rate 120] [--iterations 5] [--out bench_ppo.json]
+// Lists are comma-separated, every combination of them is run
+
+using namespace RLGPC; // RLGymPPO
+using namespace RLGSC; // RLGymSim
+
+// Physics tick rate of the arenas, the tick skip is scaled with it so that each step is the same amount of game time
+float g_TickRate = 120;
+
+// Same as the example, so results are comparable to its steps per second
+EnvCreateResult EnvCreateFunc() {
+	constexpr int TICK_SKIP = 8; // At 120Hz
+	constexpr float NO_TOUCH_TIMEOUT_SECS = 3.f;
+
+	auto rewards = new CombinedReward(
+		{
+			{ new FaceBallReward(), 0.1f },
+			{ new VelocityPlayerToBallReward(), 0.5f },
+			{ new VelocityBallToGoalReward(), 1.0f },
+			{ new EventReward({.teamGoal = 1.f, .concede = -1.f}), 50.f },
+		}
+	);
+
+	std::vector<TerminalCondition*> terminalConditions = {
+		NoTouchCondition::FromSeconds(NO_TOUCH_TIMEOUT_SECS),
+		new GoalScoreCondition()
+	};
+
+	Match* match = new Match(
+		rewards,
+		terminalConditions,
+		new DefaultOBS(),
+		new DiscreteAction(),
+		new RandomState(true, true, true),
+
+		1, // Team size
+		true // Spawn opponents
+	);
+
+	int tickSkip = RS_MAX((int)roundf(TICK_SKIP * g_TickRate / 120), 1);
+	Gym* gym = new Gym(match, tickSkip, CAR_CONFIG_OCTANE, GameMode::SOCCAR, MutatorConfig(GameMode::SOCCAR), {}, g_TickRate);
+	return { match, gym };
+}
+
+IList ParseList(const std::string& str) {
+	IList result = {};
+	std::stringstream stream(str);
+	std::string val;
+	while (std::getline(stream, val, ','))
+		result.push_back(std::stoi(val));
+	return result;
+}
+
+std::vector<HugePageMode> ParseHugePageModes(const std::string& str) {
+	std::vector<HugePageMode> result = {};
+	std::stringstream stream(str);
+	std::string val;
+	while (std::getline(stream, val, ',')) {
+		if (val == "none") {
+			result.push_back(HugePageMode::NONE);
+		} else if (val == "madvise") {
+			result.push_back(HugePageMode::MADVISE);
+		} else if (val == "reserved") {
+			result.push_back(HugePageMode::RESERVED);
+		} else {
+			RG_ERR_CLOSE("Unknown huge page mode \"" << val << "\"");
+		}
+	}
+	return result;
+}
+
+int main(int argc, char* argv[]) {
+	RocketSim::Init("./collision_meshes");
+
+	LearnerConfig cfg = {};
+	cfg.numThreads = 16;
+	cfg.numGamesPerThread = 24;
+	cfg.ppo.batchSize = 100 * 1000;
+	cfg.ppo.miniBatchSize = 25 * 1000;
+	cfg.ppo.epochs = 1;
+	cfg.ppo.policyLayerSizes = { 256, 256, 256 };
+	cfg.ppo.criticLayerSizes = { 256, 256, 256 };
+	cfg.randomSeed = 123;
+
+	BenchmarkConfig benchConfig = {};
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i], val = argv[i + 1];
+		if (arg == "--threads") {
+			benchConfig.numThreads = ParseList(val);
+		} else if (arg == "--games") {
+			benchConfig.numGamesPerThread = ParseList(val);
+		} else if (arg == "--batch") {
+			benchConfig.batchSizes = ParseList(val);
+		} else if (arg == "--minibatch") {
+			benchConfig.miniBatchSizes = ParseList(val);
+		} else if (arg == "--huge-pages") {
+			benchConfig.hugePageModes = ParseHugePageModes(val);
+		} else if (arg == "--tick-rate") {
+			g_TickRate = std::stof(val);
+		} else if (arg == "--iterations") {
+			benchConfig.measuredIterations = std::stoi(val);
+		} else if (arg == "--out") {
+			benchConfig.outputPath = val;
+		} else {
+			RG_ERR_CLOSE("Unknown argument \"" << arg << "\"");
+		}
+	}
+
+	Learner::Benchmark(EnvCreateFunc, cfg, benchConfig);
+	return 0;
+}
\ No newline at end of file
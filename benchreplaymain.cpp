@@ -0,0 +1,103 @@
+#include <RLGymPPO_CPP/Util/ReplayBench.h>
+
+#include <RLGymSim_CPP/Utils/RewardFunctions/CommonRewards.h>
+#include <RLGymSim_CPP/Utils/RewardFunctions/CombinedReward.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/NoTouchCondition.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/GoalScoreCondition.h>
+#include <RLGymSim_CPP/Utils/OBSBuilders/DefaultOBS.h>
+#include <RLGymSim_CPP/Utils/StateSetters/RandomState.h>
+#include <RLGymSim_CPP/Utils/ActionParsers/DiscreteAction.h>
+
+#include <fstream>
+
+// Environment-only steps per second, from replaying the actions of a training run with no policy (see ReplayBench)
+// Record a run with LearnerConfig::rolloutRecordPath set, with the same environment as EnvCreateFunc()
+// Builds with only RLGymPPO_CPP_Sim, like sim_worker
+//
+// Usage: bench_replay <recording file or folder>... [--threads <1,2,4,8>] [--games <per thread>] [--steps <per game>] [--seed <seed>] [--out <json path>]
+
+using namespace RLGPC; // RLGymPPO
+using namespace RLGSC; // RLGymSim
+
+// Same as the example
+EnvCreateResult EnvCreateFunc() {
+	constexpr int TICK_SKIP = 8;
+	constexpr float NO_TOUCH_TIMEOUT_SECS = 3.f;
+
+	auto rewards = new CombinedReward(
+		{
+			{ new FaceBallReward(), 0.1f },
+			{ new VelocityPlayerToBallReward(), 0.5f },
+			{ new VelocityBallToGoalReward(), 1.0f },
+			{ new EventReward({.teamGoal = 1.f, .concede = -1.f}), 50.f },
+		}
+	);
+
+	std::vector<TerminalCondition*> terminalConditions = {
+		NoTouchCondition::FromSeconds(NO_TOUCH_TIMEOUT_SECS),
+		new GoalScoreCondition()
+	};
+
+	Match* match = new Match(
+		rewards,
+		terminalConditions,
+		new DefaultOBS(),
+		new DiscreteAction(),
+		new RandomState(true, true, true),
+
+		1, // Team size
+		true // Spawn opponents
+	);
+
+	Gym* gym = new Gym(match, TICK_SKIP);
+	return { match, gym };
+}
+
+int main(int argc, char* argv[]) {
+	std::vector<std::filesystem::path> recordingPaths = {};
+	ReplayBench::Config config = {};
+	std::filesystem::path outPath = "bench_replay.json";
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg.rfind("--", 0) != 0) {
+			recordingPaths.push_back(arg);
+			continue;
+		}
+
+		if (i + 1 >= argc)
+			RG_ERR_CLOSE("Missing value for \"" << arg << "\"");
+		std::string val = argv[++i];
+
+		if (arg == "--threads") {
+			config.threadCounts = {};
+			std::stringstream stream = std::stringstream(val);
+			for (std::string count; std::getline(stream, count, ',');)
+				config.threadCounts.push_back(std::stoi(count));
+		} else if (arg == "--games") {
+			config.numGamesPerThread = std::stoi(val);
+		} else if (arg == "--steps") {
+			config.stepsPerGame = std::stoi(val);
+		} else if (arg == "--seed") {
+			config.seed = std::stoull(val);
+		} else if (arg == "--out") {
+			outPath = val;
+		} else {
+			RG_ERR_CLOSE("Unknown argument \"" << arg << "\"");
+		}
+	}
+
+	if (recordingPaths.empty()) {
+		RG_LOG("Usage: bench_replay <recording file or folder>... [--threads <1,2,4,8>] [--games <per thread>] [--steps <per game>] [--seed <seed>] [--out <json path>]");
+		return 1;
+	}
+
+	RocketSim::Init("./collision_meshes");
+
+	auto streams = ReplayBench::LoadActionStreams(recordingPaths);
+	RG_LOG("Loaded the actions of " << streams.size() << " recorded games");
+
+	auto results = ReplayBench::Run(EnvCreateFunc, streams, config);
+	std::ofstream(outPath) << ReplayBench::ToJSON(results);
+	RG_LOG("Wrote results to " << outPath);
+	return 0;
+}
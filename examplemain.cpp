@@ -13,47 +13,33 @@
 using namespace RLGPC; // RLGymPPO
 using namespace RLGSC; // RLGymSim
 
+// Our custom game metrics, registered once by name
+// Each game's values are combined and added to the metrics report every iteration
+MetricHandle
+	playerSpeedMetric = MetricRegistry::Register("player_speed", MetricType::AVG),
+	ballTouchRatioMetric = MetricRegistry::Register("ball_touch_ratio", MetricType::AVG),
+	inAirRatioMetric = MetricRegistry::Register("in_air_ratio", MetricType::AVG);
+
 // This is our step callback, it's called every step from every RocketSim game
 // WARNING: This is called from multiple threads, often simultaneously, 
 //	so don't access things apart from these arguments unless you know what you're doing.
-// gameMetrics: The metrics for this specific game
+// gameMetrics: String-keyed metrics for this specific game, gameInst->metrics is much faster
 void OnStep(GameInst* gameInst, const RLGSC::Gym::StepResult& stepResult, Report& gameMetrics) {
 
 	auto& gameState = stepResult.state;
 	for (auto& player : gameState.players) {
 		// Track average player speed
 		float speed = player.phys.vel.Length();
-		gameMetrics.AccumAvg("player_speed", speed);
+		gameInst->metrics.Add(playerSpeedMetric, speed);
 
 		// Track ball touch ratio
-		gameMetrics.AccumAvg("ball_touch_ratio", player.ballTouchedStep);
+		gameInst->metrics.Add(ballTouchRatioMetric, player.ballTouchedStep);
 
 		// Track in-air ratio
-		gameMetrics.AccumAvg("in_air_ratio", !player.carState.isOnGround);
+		gameInst->metrics.Add(inAirRatioMetric, !player.carState.isOnGround);
 	}
 }
 
-// This is our iteration callback, it's called every time we complete an iteration, after learning
-// Here we can add custom metrics to the metrics report, for example
-void OnIteration(Learner* learner, Report& allMetrics) {
-
-	AvgTracker avgPlayerSpeed = {};
-	AvgTracker avgBallTouchRatio = {};
-	AvgTracker avgAirRatio = {};
-	
-	// Get metrics for every gameInst
-	auto allGameMetrics = learner->GetAllGameMetrics();
-	for (auto& gameReport : allGameMetrics) {
-		avgPlayerSpeed += gameReport.GetAvg("player_speed");
-		avgBallTouchRatio += gameReport.GetAvg("ball_touch_ratio");
-		avgAirRatio += gameReport.GetAvg("in_air_ratio");
-	}
-
-	allMetrics["player_speed"] = avgPlayerSpeed.Get();
-	allMetrics["ball_touch_ratio"] = avgBallTouchRatio.Get();
-	allMetrics["in_air_ratio"] = avgAirRatio.Get();
-}
-
 // Create the RLGymSim environment for each of our games
 EnvCreateResult EnvCreateFunc() {
 	constexpr int TICK_SKIP = 8;
@@ -76,7 +62,7 @@ EnvCreateResult EnvCreateFunc() {
 	);
 
 	std::vector<TerminalCondition*> terminalConditions = {
-		new NoTouchCondition(NO_TOUCH_TIMEOUT_SECS * 120 / TICK_SKIP),
+		NoTouchCondition::FromSeconds(NO_TOUCH_TIMEOUT_SECS),
 		new GoalScoreCondition()
 	};
 
@@ -107,6 +93,7 @@ int main() {
 	LearnerConfig cfg = {};
 
 	// Play around with these to see what the optimal is for your machine, more isn't always better
+	// Learner::Autotune() can also find them for you, load its result with Learner::LoadAutotuneResult()
 	cfg.numThreads = 16;
 	cfg.numGamesPerThread = 24;
 
@@ -140,9 +127,9 @@ int main() {
 	// Make the learner with the environment creation function and the config we just made
 	Learner learner = Learner(EnvCreateFunc, cfg);
 
-	// Set up our callbacks
+	// Set up our step callback
+	// You can also set learner.iterationCallback to add your own metrics to the report after each iteration
 	learner.stepCallback = OnStep;
-	learner.iterationCallback = OnIteration;
 
 	// Start learning!
 	learner.Learn();
@@ -0,0 +1,497 @@
+#include <RocketSim.h>
+
+#include <fstream>
+#include <sstream>
+
+// Checks that RocketSim's physics haven't changed, by comparing against golden trajectories
+// Each scenario is a seeded kickoff with seeded controls, whose car and ball states are sampled every decision
+// Usage:
+//	physics_regress record <golden file>: Records the trajectories of the current build
+//	physics_regress check <golden file>: Replays them, and reports how far each field diverged over time (parity with the recording build)
+//	physics_regress determinism: Replays each scenario with options that must not change results (threads, slabs, reused forks), and requires them to be identical
+// Options: [--meshes <collision meshes folder>] [--tolerance <max error>] [--out <json path>]
+// Exits with EXIT_FAILURE if a check fails
+
+using namespace RocketSim;
+
+struct RegressArgs {
+	std::string mode;
+	std::filesystem::path goldenPath;
+	std::filesystem::path meshesPath = "collision_meshes";
+	double tolerance = 0; // Largest allowed absolute error of any field in check mode, 0 for bit-exact
+	std::filesystem::path outPath = "physics_regress.json";
+};
+
+struct Scenario {
+	std::string name;
+	int teamSize = 1; // 0 for no cars
+	int seed = 0;
+	float seconds = 10;
+	bool wallPlay = false; // Cars start driving into the side walls with the ball
+	bool groundPlay = false; // Cars never jump
+	bool genericSolver = false; // Solve contacts with Bullet's generic iterations
+	ArenaMemWeightMode memWeightMode = ArenaMemWeightMode::LIGHT;
+};
+
+// Options that must not change the physics, used by the determinism mode
+enum class Variant {
+	NONE,
+	REPEAT, // Same as NONE, catches state leaking between arenas (i.e. through globals)
+	CAR_UPDATE_THREADS, // Cars are updated on multiple threads (see Arena::SetCarUpdateThreads())
+	NO_SLAB, // Allocated without an arena slab, which only changes memory layout
+	FORK_MIDWAY, // Continues from Arena::Fork() halfway through
+	REUSED_FORK_MIDWAY, // Same as FORK_MIDWAY, but the fork is stepped, then rolled back with Arena::CopyStateTo() first
+};
+
+const char* VARIANT_NAMES[] = { "none", "repeat", "car_update_threads", "no_slab", "fork_midway", "reused_fork_midway" };
+
+struct DeterminismCheck {
+	Variant variant, baseline;
+	bool required; // If false, it is reported but doesn't fail the run
+};
+
+// Each variant of the determinism mode, and the variant it must match
+// NOTE: Forks and clones aren't compared to the arena they came from, they have their own Bullet world, so they only simulate exactly the same as each other
+constexpr DeterminismCheck DETERMINISM_CHECKS[] = {
+	{ Variant::REPEAT, Variant::NONE, true },
+	{ Variant::CAR_UPDATE_THREADS, Variant::NONE, true },
+	{ Variant::NO_SLAB, Variant::NONE, true },
+	{ Variant::REUSED_FORK_MIDWAY, Variant::FORK_MIDWAY, true },
+};
+
+constexpr int TICK_SKIP = 8;
+
+// Fields of each sample, grouped for reporting
+struct FieldGroup {
+	const char* name;
+	int offset, size;
+};
+
+constexpr FieldGroup BALL_FIELDS[] = {
+	{ "ball_pos", 0, 3 },
+	{ "ball_vel", 3, 3 },
+	{ "ball_ang_vel", 6, 3 },
+};
+constexpr int BALL_FIELD_AMOUNT = 9;
+
+constexpr FieldGroup CAR_FIELDS[] = {
+	{ "car_pos", 0, 3 },
+	{ "car_rot", 3, 6 }, // Forward and up
+	{ "car_vel", 9, 3 },
+	{ "car_ang_vel", 12, 3 },
+	{ "car_boost", 15, 1 },
+	{ "car_flags", 16, 4 }, // On ground, jumped, flipped, demoed
+};
+constexpr int CAR_FIELD_AMOUNT = 20;
+
+struct Trajectory {
+	int sampleSize = 0;
+	std::vector<float> samples = {}; // [sampleAmount][sampleSize]
+
+	size_t GetSampleAmount() const {
+		return sampleSize ? samples.size() / sampleSize : 0;
+	}
+};
+
+Arena* CreateArena(const Scenario& scenario, Variant variant) {
+	ArenaConfig config = {};
+	config.memWeightMode = scenario.memWeightMode;
+	if (variant == Variant::NO_SLAB)
+		config.slabKB = 0;
+
+	Arena* arena = Arena::Create(GameMode::SOCCAR, config);
+	for (int i = 0; i < scenario.teamSize; i++) {
+		arena->AddCar(Team::BLUE);
+		arena->AddCar(Team::ORANGE);
+	}
+	arena->ResetToRandomKickoff(scenario.seed);
+
+	if (scenario.genericSolver)
+		arena->_bulletWorld.getSolverInfo().m_solverMode |= SOLVER_RS_GENERIC_ITERATIONS;
+
+	if (variant == Variant::CAR_UPDATE_THREADS)
+		arena->SetCarUpdateThreads(2);
+
+	if (scenario.wallPlay) {
+		int i = 0;
+		for (Car* car : arena->GetCars()) {
+			CarState state = {};
+			state.pos = Vec(3600, -600 + i * 200.f, 17);
+			state.rotMat = Angle(0, 0, 0).ToRotMat();
+			state.vel = Vec(1000, 0, 0);
+			state.boost = 100;
+			car->SetState(state);
+			i++;
+		}
+
+		BallState ballState = {};
+		ballState.pos = Vec(3900, 0, 300);
+		ballState.vel = Vec(500, 0, 200);
+		arena->ball->SetState(ballState);
+	} else if (scenario.teamSize == 0) {
+		BallState ballState = {};
+		ballState.pos = Vec(0, 0, 500);
+		ballState.vel = Vec(1500, 2000, 1000);
+		ballState.angVel = Vec(2, -3, 1);
+		arena->ball->SetState(ballState);
+	}
+
+	return arena;
+}
+
+// Same as bench_rocketsim, scripted by the scenario's seed
+void RandomizeControls(Arena* arena, std::mt19937& rng, const Scenario& scenario) {
+	std::uniform_real_distribution<float> dist = std::uniform_real_distribution<float>(-1, 1);
+	for (Car* car : arena->GetCars()) {
+		CarControls& controls = car->controls;
+		controls.throttle = scenario.wallPlay ? 1 : dist(rng);
+		controls.steer = dist(rng);
+		controls.pitch = dist(rng);
+		controls.yaw = dist(rng);
+		controls.roll = dist(rng);
+		controls.boost = scenario.wallPlay || dist(rng) > 0.5f;
+		controls.jump = !scenario.groundPlay && dist(rng) > 0.8f;
+		controls.handbrake = dist(rng) > 0.8f;
+	}
+}
+
+void AddSample(Arena* arena, Trajectory& traj) {
+	auto fnAddVec = [&](Vec v) {
+		traj.samples.insert(traj.samples.end(), { v.x, v.y, v.z });
+	};
+
+	BallState ballState = arena->ball->GetState();
+	fnAddVec(ballState.pos);
+	fnAddVec(ballState.vel);
+	fnAddVec(ballState.angVel);
+
+	for (Car* car : arena->GetCars()) {
+		CarState state = car->GetState();
+		fnAddVec(state.pos);
+		fnAddVec(state.rotMat.forward);
+		fnAddVec(state.rotMat.up);
+		fnAddVec(state.vel);
+		fnAddVec(state.angVel);
+		traj.samples.insert(traj.samples.end(), {
+			state.boost,
+			(float)state.isOnGround, (float)state.hasJumped, (float)state.hasFlipped, (float)state.isDemoed
+		});
+	}
+}
+
+Trajectory RunScenario(const Scenario& scenario, Variant variant = Variant::NONE) {
+	Arena* arena = CreateArena(scenario, variant);
+	std::mt19937 rng = std::mt19937(scenario.seed);
+
+	Trajectory traj = {};
+	traj.sampleSize = BALL_FIELD_AMOUNT + CAR_FIELD_AMOUNT * arena->GetCars().size();
+
+	int decisions = (int)(scenario.seconds * 120 / TICK_SKIP);
+	AddSample(arena, traj);
+	for (int i = 0; i < decisions; i++) {
+		if (i == decisions / 2 && (variant == Variant::FORK_MIDWAY || variant == Variant::REUSED_FORK_MIDWAY)) {
+			Arena* fork = arena->Fork();
+			if (variant == Variant::REUSED_FORK_MIDWAY) {
+				fork->Step(TICK_SKIP * 4);
+				arena->CopyStateTo(fork);
+			}
+			delete arena;
+			arena = fork;
+		}
+
+		RandomizeControls(arena, rng, scenario);
+		arena->Step(TICK_SKIP);
+		AddSample(arena, traj);
+	}
+
+	delete arena;
+	return traj;
+}
+
+// Golden file: magic, scenario amount, then the name, sample size, sample amount and samples of each scenario
+constexpr uint32_t GOLDEN_MAGIC = 0x54475352; // "RSGT"
+
+void WriteGolden(const std::filesystem::path& path, const std::vector<Scenario>& scenarios, const std::vector<Trajectory>& trajs) {
+	std::ofstream out = std::ofstream(path, std::ios::binary);
+	if (!out.good())
+		RS_ERR_CLOSE("Failed to open golden file " << path << " for writing");
+
+	auto fnWrite = [&](const auto& val) { out.write((const char*)&val, sizeof(val)); };
+	fnWrite(GOLDEN_MAGIC);
+	fnWrite((uint32_t)scenarios.size());
+	for (int i = 0; i < scenarios.size(); i++) {
+		fnWrite((uint32_t)scenarios[i].name.size());
+		out.write(scenarios[i].name.data(), scenarios[i].name.size());
+		fnWrite((uint32_t)trajs[i].sampleSize);
+		fnWrite((uint64_t)trajs[i].GetSampleAmount());
+		out.write((const char*)trajs[i].samples.data(), trajs[i].samples.size() * sizeof(float));
+	}
+}
+
+std::map<std::string, Trajectory> ReadGolden(const std::filesystem::path& path) {
+	std::ifstream in = std::ifstream(path, std::ios::binary);
+	if (!in.good())
+		RS_ERR_CLOSE("Failed to open golden file " << path);
+
+	auto fnRead = [&](auto& val) {
+		in.read((char*)&val, sizeof(val));
+		if (!in.good())
+			RS_ERR_CLOSE("Golden file " << path << " is truncated");
+	};
+
+	uint32_t magic, scenarioAmount;
+	fnRead(magic);
+	if (magic != GOLDEN_MAGIC)
+		RS_ERR_CLOSE("File " << path << " is not a golden trajectory file");
+	fnRead(scenarioAmount);
+
+	std::map<std::string, Trajectory> result = {};
+	for (uint32_t i = 0; i < scenarioAmount; i++) {
+		uint32_t nameSize, sampleSize;
+		uint64_t sampleAmount;
+		fnRead(nameSize);
+		std::string name = std::string(nameSize, '\0');
+		in.read(name.data(), nameSize);
+		fnRead(sampleSize);
+		fnRead(sampleAmount);
+
+		Trajectory& traj = result[name];
+		traj.sampleSize = sampleSize;
+		traj.samples.resize(sampleSize * sampleAmount);
+		in.read((char*)traj.samples.data(), traj.samples.size() * sizeof(float));
+		if (!in.good())
+			RS_ERR_CLOSE("Golden file " << path << " is truncated");
+	}
+	return result;
+}
+
+// How far a trajectory diverged from a reference
+struct Divergence {
+	bool comparable = true; // False if the trajectories have different shapes
+	int64_t firstDivergedSample = -1; // First sample that isn't bit-exact, -1 if none
+	int64_t firstOverToleranceSample = -1;
+	double maxError = 0;
+
+	// Max absolute error of each field group, over each second of game time
+	std::vector<std::string> groupNames = {};
+	std::vector<std::vector<double>> groupErrorsPerSecond = {};
+};
+
+Divergence Compare(const Trajectory& reference, const Trajectory& traj, double tolerance) {
+	Divergence result = {};
+	if (reference.sampleSize != traj.sampleSize || reference.samples.size() != traj.samples.size()) {
+		result.comparable = false;
+		return result;
+	}
+
+	struct GroupRange {
+		int groupIndex, offset, size;
+	};
+	std::vector<GroupRange> ranges = {};
+	for (auto& group : BALL_FIELDS) {
+		ranges.push_back({ (int)result.groupNames.size(), group.offset, group.size });
+		result.groupNames.push_back(group.name);
+	}
+
+	int carAmount = (traj.sampleSize - BALL_FIELD_AMOUNT) / CAR_FIELD_AMOUNT;
+	for (auto& group : CAR_FIELDS) {
+		for (int i = 0; i < carAmount; i++)
+			ranges.push_back({ (int)result.groupNames.size(), BALL_FIELD_AMOUNT + i * CAR_FIELD_AMOUNT + group.offset, group.size });
+		result.groupNames.push_back(group.name);
+	}
+
+	constexpr int SAMPLES_PER_SECOND = 120 / TICK_SKIP;
+	size_t sampleAmount = traj.GetSampleAmount();
+	result.groupErrorsPerSecond.resize((sampleAmount + SAMPLES_PER_SECOND - 1) / SAMPLES_PER_SECOND, std::vector<double>(result.groupNames.size()));
+
+	for (size_t i = 0; i < sampleAmount; i++) {
+		const float* refSample = reference.samples.data() + i * traj.sampleSize;
+		const float* sample = traj.samples.data() + i * traj.sampleSize;
+		auto& secondErrors = result.groupErrorsPerSecond[i / SAMPLES_PER_SECOND];
+
+		for (auto& range : ranges) {
+			for (int j = range.offset; j < range.offset + range.size; j++) {
+				// Compare bits, so NaNs that appear in both still match
+				bool bitExact = memcmp(&refSample[j], &sample[j], sizeof(float)) == 0;
+				double error = bitExact ? 0 : abs((double)refSample[j] - sample[j]);
+				if (!bitExact && std::isnan(error))
+					error = INFINITY;
+
+				if (!bitExact && result.firstDivergedSample < 0)
+					result.firstDivergedSample = i;
+				if (error > tolerance && result.firstOverToleranceSample < 0)
+					result.firstOverToleranceSample = i;
+
+				secondErrors[range.groupIndex] = RS_MAX(secondErrors[range.groupIndex], error);
+				result.maxError = RS_MAX(result.maxError, error);
+			}
+		}
+	}
+
+	return result;
+}
+
+void WriteDivergenceJSON(std::stringstream& json, const Divergence& div) {
+	json << "\"comparable\": " << (div.comparable ? "true" : "false");
+	if (!div.comparable)
+		return;
+
+	json << ", \"first_diverged_tick\": " << (div.firstDivergedSample < 0 ? -1 : div.firstDivergedSample * TICK_SKIP);
+	json << ", \"first_over_tolerance_tick\": " << (div.firstOverToleranceSample < 0 ? -1 : div.firstOverToleranceSample * TICK_SKIP);
+	json << ", \"max_error\": " << div.maxError;
+	json << ", \"max_error_per_second\": {";
+	for (int i = 0; i < div.groupNames.size(); i++) {
+		json << (i ? ", " : " ") << "\"" << div.groupNames[i] << "\": [";
+		for (int j = 0; j < div.groupErrorsPerSecond.size(); j++)
+			json << (j ? ", " : "") << div.groupErrorsPerSecond[j][i];
+		json << "]";
+	}
+	json << " }";
+}
+
+std::string DescribeDivergence(const Divergence& div) {
+	if (!div.comparable)
+		return "different amount of cars or samples";
+	if (div.firstDivergedSample < 0)
+		return "identical";
+
+	std::stringstream stream;
+	stream << "diverged at tick " << div.firstDivergedSample * TICK_SKIP << ", max error " << div.maxError;
+
+	// The field group that diverged first
+	for (auto& secondErrors : div.groupErrorsPerSecond) {
+		int worstGroup = -1;
+		for (int i = 0; i < secondErrors.size(); i++)
+			if (secondErrors[i] > 0 && (worstGroup < 0 || secondErrors[i] > secondErrors[worstGroup]))
+				worstGroup = i;
+
+		if (worstGroup >= 0) {
+			stream << " (" << div.groupNames[worstGroup] << " first)";
+			break;
+		}
+	}
+	return stream.str();
+}
+
+int main(int argc, char* argv[]) {
+	RegressArgs args = {};
+	if (argc < 2)
+		RS_ERR_CLOSE("Usage: physics_regress <record|check|determinism> [golden file] [options]");
+
+	int argIdx = 1;
+	args.mode = argv[argIdx++];
+	if (args.mode == "record" || args.mode == "check") {
+		if (argIdx >= argc)
+			RS_ERR_CLOSE("Mode \"" << args.mode << "\" needs a golden file path");
+		args.goldenPath = argv[argIdx++];
+	} else if (args.mode != "determinism") {
+		RS_ERR_CLOSE("Unknown mode \"" << args.mode << "\"");
+	}
+
+	for (; argIdx + 1 < argc; argIdx += 2) {
+		std::string arg = argv[argIdx], val = argv[argIdx + 1];
+		if (arg == "--meshes") {
+			args.meshesPath = val;
+		} else if (arg == "--tolerance") {
+			args.tolerance = std::stod(val);
+		} else if (arg == "--out") {
+			args.outPath = val;
+		} else {
+			RS_ERR_CLOSE("Unknown argument \"" << arg << "\"");
+		}
+	}
+
+	RocketSim::Init(args.meshesPath);
+
+	std::vector<Scenario> scenarios = {
+		{ "ball_only", 0 },
+		{ "1v1", 1 },
+		{ "1v1_seed_1", 1, 1 },
+		{ "2v2", 2 },
+		{ "3v3", 3 },
+		{ "3v3_seed_2", 3, 2 },
+		{ "2v2_ground_play", 2, 3, 10, false, true },
+		{ "2v2_wall_play", 2, 4, 10, true },
+		{ "2v2_generic_solver", 2, 5, 10, false, false, true },
+		{ "2v2_heavy", 2, 6, 10, false, false, false, ArenaMemWeightMode::HEAVY },
+		{ "1v1_long", 1, 7, 60 },
+	};
+
+	bool failed = false;
+	std::stringstream json;
+	json << "{\n";
+	json << "\t\"mode\": \"" << args.mode << "\",\n";
+	json << "\t\"tolerance\": " << args.tolerance << ",\n";
+	json << "\t\"scenarios\": [\n";
+
+	if (args.mode == "record") {
+		std::vector<Trajectory> trajs = {};
+		for (int i = 0; i < scenarios.size(); i++) {
+			trajs.push_back(RunScenario(scenarios[i]));
+			RS_LOG(scenarios[i].name << ": recorded " << trajs.back().GetSampleAmount() << " samples");
+			json << "\t\t{ \"name\": \"" << scenarios[i].name << "\", \"samples\": " << trajs.back().GetSampleAmount() << " }";
+			json << (i + 1 < scenarios.size() ? ",\n" : "\n");
+		}
+		WriteGolden(args.goldenPath, scenarios, trajs);
+		RS_LOG("Wrote golden trajectories to " << args.goldenPath);
+
+	} else if (args.mode == "check") {
+		auto golden = ReadGolden(args.goldenPath);
+		for (int i = 0; i < scenarios.size(); i++) {
+			auto& scenario = scenarios[i];
+			json << "\t\t{ \"name\": \"" << scenario.name << "\", ";
+
+			auto itr = golden.find(scenario.name);
+			if (itr == golden.end()) {
+				RS_LOG(scenario.name << ": not in golden file, skipped");
+				json << "\"missing\": true }";
+			} else {
+				Divergence div = Compare(itr->second, RunScenario(scenario), args.tolerance);
+				bool passed = div.comparable && div.firstOverToleranceSample < 0;
+				failed |= !passed;
+				RS_LOG(scenario.name << ": " << (passed ? "PASS" : "FAIL") << ", " << DescribeDivergence(div));
+				WriteDivergenceJSON(json, div);
+				json << " }";
+			}
+			json << (i + 1 < scenarios.size() ? ",\n" : "\n");
+		}
+
+	} else { // Determinism
+		for (int i = 0; i < scenarios.size(); i++) {
+			auto& scenario = scenarios[i];
+			json << "\t\t{ \"name\": \"" << scenario.name << "\", \"variants\": {";
+
+			std::map<Variant, Trajectory> baselines = {};
+			for (int j = 0; j < std::size(DETERMINISM_CHECKS); j++) {
+				auto& check = DETERMINISM_CHECKS[j];
+				if (!baselines.contains(check.baseline))
+					baselines[check.baseline] = RunScenario(scenario, check.baseline);
+
+				Divergence div = Compare(baselines[check.baseline], RunScenario(scenario, check.variant), 0);
+				bool passed = div.comparable && div.firstDivergedSample < 0;
+				if (check.required)
+					failed |= !passed;
+				RS_LOG(
+					scenario.name << " (" << VARIANT_NAMES[(int)check.variant] << "): " << (passed ? "PASS" : (check.required ? "FAIL" : "FAIL (not required)")) <<
+					", " << DescribeDivergence(div)
+				);
+
+				json << (j ? ", " : " ") << "\"" << VARIANT_NAMES[(int)check.variant] << "\": { \"required\": " << (check.required ? "true" : "false") << ", ";
+				WriteDivergenceJSON(json, div);
+				json << " }";
+			}
+			json << " } }" << (i + 1 < scenarios.size() ? ",\n" : "\n");
+		}
+	}
+
+	json << "\t],\n";
+	json << "\t\"passed\": " << (failed ? "false" : "true") << "\n";
+	json << "}";
+
+	std::ofstream(args.outPath) << json.str();
+	RS_LOG("Wrote results to " << args.outPath);
+
+	if (args.mode != "record")
+		RS_LOG((failed ? "FAILED" : "PASSED"));
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
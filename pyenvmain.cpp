@@ -0,0 +1,143 @@
+#include <RLGymSim_CPP/VecGym.h>
+
+#include <RLGymSim_CPP/Utils/RewardFunctions/CommonRewards.h>
+#include <RLGymSim_CPP/Utils/RewardFunctions/CombinedReward.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/NoTouchCondition.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/GoalScoreCondition.h>
+#include <RLGymSim_CPP/Utils/OBSBuilders/DefaultOBS.h>
+#include <RLGymSim_CPP/Utils/StateSetters/RandomState.h>
+#include <RLGymSim_CPP/Utils/ActionParsers/DiscreteAction.h>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+// Python module of a vectorized RLGymSim environment, for training from Python
+// Edit EnvCreateFunc() to change the environment, just like in examplemain.cpp
+//
+// Usage:
+//	import numpy as np, rlgymsim_cpp_env
+//	env = rlgymsim_cpp_env.VecEnv(num_envs=64, num_threads=8)
+//	obs = env.reset()
+//	obs, rewards, dones = env.step(np.zeros(env.num_players, dtype=np.int64))
+//
+// Returned arrays are views of the env's own buffers, which are overwritten by the next reset() or step()
+// Copy them (e.g. with np.copy() or torch.from_numpy().clone()) to keep them around
+
+namespace py = pybind11;
+using namespace RLGSC; // RLGymSim
+
+// Same as the example
+Gym* EnvCreateFunc() {
+	constexpr int TICK_SKIP = 8;
+	constexpr float NO_TOUCH_TIMEOUT_SECS = 3.f;
+
+	auto rewards = new CombinedReward(
+		{
+			{ new FaceBallReward(), 0.1f },
+			{ new VelocityPlayerToBallReward(), 0.5f },
+			{ new VelocityBallToGoalReward(), 1.0f },
+			{ new EventReward({.teamGoal = 1.f, .concede = -1.f}), 50.f },
+		}
+	);
+
+	std::vector<TerminalCondition*> terminalConditions = {
+		NoTouchCondition::FromSeconds(NO_TOUCH_TIMEOUT_SECS),
+		new GoalScoreCondition()
+	};
+
+	Match* match = new Match(
+		rewards,
+		terminalConditions,
+		new DefaultOBS(),
+		new DiscreteAction(),
+		new RandomState(true, true, true),
+
+		1, // Team size
+		true // Spawn opponents
+	);
+
+	return new Gym(match, TICK_SKIP);
+}
+
+class PyVecEnv {
+public:
+	VecGym* vecGym;
+	int actionAmount;
+
+	PyVecEnv(int numEnvs, int numThreads, int64_t seed, std::string collisionMeshesPath) {
+		if (RocketSim::GetStage() != RocketSimStage::INITIALIZED)
+			RocketSim::Init(collisionMeshesPath);
+
+		vecGym = new VecGym(EnvCreateFunc, numEnvs, numThreads, seed);
+		actionAmount = vecGym->gyms[0]->match->actionParser->GetActionAmount();
+	}
+
+	RG_NO_COPY(PyVecEnv);
+
+	// View of one of our buffers, which keeps us alive while it exists
+	template <typename T>
+	py::array MakeView(py::object self, T* data, std::vector<py::ssize_t> shape) {
+		return py::array(py::dtype::of<T>(), shape, data, self);
+	}
+
+	py::array GetOBSView(py::object self) {
+		return MakeView(self, vecGym->obs.data(), { vecGym->totalPlayers, vecGym->obsSize });
+	}
+
+	py::array Reset(py::object self) {
+		{
+			py::gil_scoped_release release;
+			vecGym->Reset();
+		}
+		return GetOBSView(self);
+	}
+
+	py::tuple Step(py::object self, py::array_t<int64_t, py::array::c_style | py::array::forcecast> actions) {
+		if (actions.ndim() != 1 || actions.shape(0) != vecGym->totalPlayers)
+			throw std::invalid_argument("Expected one action per player (" + std::to_string(vecGym->totalPlayers) + "), got shape of size " + std::to_string(actions.size()));
+
+		const int64_t* actionData = actions.data();
+		for (int i = 0; i < vecGym->totalPlayers; i++)
+			if (actionData[i] < 0 || actionData[i] >= actionAmount)
+				throw std::out_of_range("Action " + std::to_string(actionData[i]) + " is out of range [0, " + std::to_string(actionAmount) + ")");
+
+		{
+			py::gil_scoped_release release;
+			vecGym->Step(actionData);
+		}
+
+		return py::make_tuple(
+			GetOBSView(self),
+			MakeView(self, vecGym->rewards.data(), { vecGym->totalPlayers }),
+			py::array(py::dtype::of<bool>(), { vecGym->totalPlayers }, (const bool*)vecGym->dones.data(), self)
+		);
+	}
+
+	~PyVecEnv() {
+		delete vecGym;
+	}
+};
+
+PYBIND11_MODULE(rlgymsim_cpp_env, m) {
+	m.doc() = "Vectorized RLGymSim environment, stepped on native threads";
+
+	py::class_<PyVecEnv>(m, "VecEnv")
+		.def(
+			py::init<int, int, int64_t, std::string>(),
+			py::arg("num_envs"), py::arg("num_threads") = 1, py::arg("seed") = -1, py::arg("collision_meshes_path") = "./collision_meshes"
+		)
+		.def("reset", [](py::object self) { return self.cast<PyVecEnv&>().Reset(self); },
+			"Resets every env, returns the observations of all players ([num_players, obs_size])")
+		.def("step", [](py::object self, py::array_t<int64_t, py::array::c_style | py::array::forcecast> actions) {
+				return self.cast<PyVecEnv&>().Step(self, actions);
+			}, py::arg("actions"),
+			"Steps every env with the action index of each player ([num_players]), returns (obs, rewards, dones)\n"
+			"Envs that end are reset, so their observations are the first of their next episode"
+		)
+		.def_property_readonly("num_envs", [](const PyVecEnv& env) { return env.vecGym->Size(); })
+		.def_property_readonly("num_players", [](const PyVecEnv& env) { return env.vecGym->totalPlayers; })
+		.def_property_readonly("obs_size", [](const PyVecEnv& env) { return env.vecGym->obsSize; })
+		.def_property_readonly("action_size", [](const PyVecEnv& env) { return env.actionAmount; })
+		.def_property_readonly("player_start", [](const PyVecEnv& env) { return env.vecGym->playerStart; });
+}
@@ -76,7 +76,7 @@ EnvCreateResult EnvCreateFunc() {
 	);
 
 	std::vector<TerminalCondition*> terminalConditions = {
-		new NoTouchCondition(NO_TOUCH_TIMEOUT_SECS * 120 / TICK_SKIP),
+		NoTouchCondition::FromSeconds(NO_TOUCH_TIMEOUT_SECS),
 		new GoalScoreCondition()
 	};
 
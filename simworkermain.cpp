@@ -0,0 +1,74 @@
+#include <RLGymPPO_CPP/SimWorker.h>
+
+#include <RLGymSim_CPP/Utils/RewardFunctions/CommonRewards.h>
+#include <RLGymSim_CPP/Utils/RewardFunctions/CombinedReward.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/NoTouchCondition.h>
+#include <RLGymSim_CPP/Utils/TerminalConditions/GoalScoreCondition.h>
+#include <RLGymSim_CPP/Utils/OBSBuilders/DefaultOBS.h>
+#include <RLGymSim_CPP/Utils/StateSetters/RandomState.h>
+#include <RLGymSim_CPP/Utils/ActionParsers/DiscreteAction.h>
+
+// Rollout worker that doesn't need libtorch, for a learner with LearnerConfig::remoteWorkerPort set
+// Builds with only RLGymPPO_CPP_Sim (configure with -DRG_SIM_ONLY=ON on machines without libtorch)
+// The environment must be the same as the learner's, edit EnvCreateFunc() to match it
+//
+// Usage: sim_worker <learner address> <learner port> [worker name]
+
+using namespace RLGPC; // RLGymPPO
+using namespace RLGSC; // RLGymSim
+
+// Same as the example
+EnvCreateResult EnvCreateFunc() {
+	constexpr int TICK_SKIP = 8;
+	constexpr float NO_TOUCH_TIMEOUT_SECS = 3.f;
+
+	auto rewards = new CombinedReward(
+		{
+			{ new FaceBallReward(), 0.1f },
+			{ new VelocityPlayerToBallReward(), 0.5f },
+			{ new VelocityBallToGoalReward(), 1.0f },
+			{ new EventReward({.teamGoal = 1.f, .concede = -1.f}), 50.f },
+		}
+	);
+
+	std::vector<TerminalCondition*> terminalConditions = {
+		NoTouchCondition::FromSeconds(NO_TOUCH_TIMEOUT_SECS),
+		new GoalScoreCondition()
+	};
+
+	Match* match = new Match(
+		rewards,
+		terminalConditions,
+		new DefaultOBS(),
+		new DiscreteAction(),
+		new RandomState(true, true, true),
+
+		1, // Team size
+		true // Spawn opponents
+	);
+
+	Gym* gym = new Gym(match, TICK_SKIP);
+	return { match, gym };
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		RG_LOG("Usage: sim_worker <learner address> <learner port> [worker name]");
+		return 1;
+	}
+
+	RocketSim::Init("./collision_meshes");
+
+	RemoteWorkerConfig cfg = {};
+	cfg.learnerAddress = argv[1];
+	cfg.learnerPort = std::stoi(argv[2]);
+	if (argc > 3)
+		cfg.name = argv[3];
+
+	// Must match the learner's
+	cfg.policyLayerSizes = { 256, 256, 256 };
+
+	SimWorker worker = SimWorker(EnvCreateFunc, cfg);
+	worker.Run();
+	return 0;
+}